@@ -1,24 +1,26 @@
 # Basic Qt configuration
-QT       += core gui multimedia widgets
+QT       += core gui multimedia network opengl openglwidgets widgets
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 CONFIG += c++17
 
-# Compilation optimization settings
-CONFIG += optimize_full parallel_mode precompile_header unity_build
+# Compilation settings
+CONFIG += parallel_mode precompile_header unity_build
 PRECOMPILED_HEADER = stable.h
 UNITY_BUILD_BATCH_SIZE = 4
 
-# Optimize for lower memory usage and compilation speed
+# Drop unused code and data at link time
 unix:!macx {
-    QMAKE_CXXFLAGS += -MP -Os -ffunction-sections -fdata-sections
+    QMAKE_CXXFLAGS += -ffunction-sections -fdata-sections
     QMAKE_LFLAGS += -Wl,--gc-sections
 }
 
 macx {
-    QMAKE_CXXFLAGS += -MP -Os
     QMAKE_LFLAGS += -Wl,-dead_strip
 }
 
+# Compile the files of a target in parallel
+msvc: QMAKE_CXXFLAGS += -MP
+
 # Increase make timeout and set memory-aware parallel jobs
 unix:!macx {
     QMAKE_MAKEFLAGS += -j4
@@ -55,18 +57,18 @@ win32 {
     QMAKE_MAKEFLAGS += -j4
 }
 
-# Release mode optimizations
-CONFIG(release, debug|release) {
-    QMAKE_CXXFLAGS_RELEASE -= -g -O2
-    QMAKE_CXXFLAGS_RELEASE += -O1
-    QMAKE_CFLAGS_RELEASE -= -g
-    QMAKE_LFLAGS_RELEASE = -Wl,-O1
-}
+# Release optimization profile: size by default, CONFIG+=performance for desktops
+include(buildprofile.pri)
 
 SOURCES += \
     adaptivequiz.cpp \
     backgroundpage.cpp \
+    backgroundrenderer.cpp \
+    chordcapture.cpp \
     datamanager.cpp \
+    datawriter.cpp \
+    gamesession.cpp \
+    idlemanager.cpp \
     keyboard.cpp \
     lessonsbackgroundpage.cpp \
     lessonsgame.cpp \
@@ -77,20 +79,53 @@ SOURCES += \
     mainpage.cpp \
     mainwindow.cpp \
     mathutils.cpp \
+    memorymonitor.cpp \
+    midieventqueue.cpp \
+    midiinput.cpp \
     multiplayergame.cpp \
     multiplayergamewidget.cpp \
     navigationmanager.cpp \
+    notesampler.cpp \
+    noteset.cpp \
+    notetable.cpp \
+    notevisualizer.cpp \
+    onlinematch.cpp \
+    performancerecorder.cpp \
     pianowidget.cpp \
+    promptplayer.cpp \
+    qtable.cpp \
     question.cpp \
+    questionbank.cpp \
+    questionbankwatcher.cpp \
     questionloader.cpp \
+    quizhistory.cpp \
     quizwidget.cpp \
+    reviewschedule.cpp \
+    rhythmengine.cpp \
+    runningstats.cpp \
+    scoringsystem.cpp \
+    screenlayout.cpp \
+    sessionlog.cpp \
+    sessionrng.cpp \
+    smffile.cpp \
+    soundfontloader.cpp \
     soundmanager.cpp \
-    statisticswidget.cpp
+    startupprofiler.cpp \
+    statisticswidget.cpp \
+    stringpool.cpp \
+    theme.cpp \
+    trace.cpp \
+    traceoverlay.cpp
 
 HEADERS += \
     adaptivequiz.h \
     backgroundpage.h \
+    backgroundrenderer.h \
+    chordcapture.h \
     datamanager.h \
+    datawriter.h \
+    gamesession.h \
+    idlemanager.h \
     keyboard.h \
     lessonsbackgroundpage.h \
     lessonsgame.h \
@@ -99,30 +134,135 @@ HEADERS += \
     loaddatamanager.h \
     mainpage.h \
     mainwindow.h \
+    matchprotocol.h \
     mathutils.h \
+    memorymonitor.h \
+    midieventqueue.h \
+    midiinput.h \
     multiplayergame.h \
     multiplayergamewidget.h \
     navigationmanager.h \
+    notesampler.h \
+    noteset.h \
+    notetable.h \
+    notevisualizer.h \
+    onlinematch.h \
+    performancerecorder.h \
     pianowidget.h \
+    promptplayer.h \
+    qtable.h \
     question.h \
+    questionbank.h \
+    questionbankformat.h \
+    questionbankwatcher.h \
     questionloader.h \
+    quizhistory.h \
     quizreport.h \
     quizwidget.h \
+    reviewschedule.h \
+    rhythmengine.h \
+    runningstats.h \
+    scoringsystem.h \
+    screenlayout.h \
+    sessionlog.h \
+    sessionrng.h \
+    smffile.h \
+    soundfontloader.h \
     soundmanager.h \
     stable.h \
+    startupprofiler.h \
     state.h \
-    statisticswidget.h
+    statisticswidget.h \
+    stringpool.h \
+    theme.h \
+    trace.h \
+    traceoverlay.h
 
 FORMS += \
     mainwindow.ui 
 
+# Compile the question bank JSON into a binary blob linked into the executable.
+# Without python3 the build still works and the JSON resource is parsed at runtime.
+QBANK_PYTHON = $$system(python3 -c \"print(1)\")
+!isEmpty(QBANK_PYTHON) {
+    QBANK_JSON = resources/questionBank.json
+    qbank.input = QBANK_JSON
+    qbank.output = ${QMAKE_FILE_BASE}_blob.cpp
+    qbank.commands = python3 $$PWD/tools/qbank_compile.py ${QMAKE_FILE_IN} ${QMAKE_FILE_OUT}
+    qbank.depends = $$PWD/tools/qbank_compile.py
+    qbank.variable_out = GENERATED_SOURCES
+    qbank.name = QBANK ${QMAKE_FILE_IN}
+    QMAKE_EXTRA_COMPILERS += qbank
+    DEFINES += KEYQUEST_HAVE_QBANK_BLOB
+
+    # Hash the piano SoundFont once here instead of on every start (see SoundFontLoader);
+    # without the hash the loader computes it from the resource
+    SOUNDFONT_SF2 = soundFiles/UprightPianoKW-20220221.sf2
+    exists($$PWD/$$SOUNDFONT_SF2) {
+        sfhash.input = SOUNDFONT_SF2
+        sfhash.output = soundfont_hash.cpp
+        sfhash.commands = python3 $$PWD/tools/soundfont_hash.py ${QMAKE_FILE_IN} :/sounds/piano.sf2 ${QMAKE_FILE_OUT}
+        sfhash.depends = $$PWD/tools/soundfont_hash.py
+        sfhash.variable_out = GENERATED_SOURCES
+        sfhash.name = SFHASH ${QMAKE_FILE_IN}
+        QMAKE_EXTRA_COMPILERS += sfhash
+        DEFINES += KEYQUEST_HAVE_SOUNDFONT_HASH
+    }
+}
+
+DISTFILES += tools/qbank_compile.py \
+             tools/soundfont_hash.py \
+             tools/pgo_build.py \
+             tools/asset_pipeline.py \
+             tools/assets.json
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
 
-RESOURCES += resources.qrc \
-             soundFiles.qrc \
+RESOURCES += data.qrc \
+             soundFiles.qrc
+
+# Prior Q-table of new players, written by bench/qtrainer; optional
+exists($$PWD/resources/qtablePrior.kqt) {
+    RESOURCES += qtablePrior.qrc
+}
+
+IMAGE_QRCS = resources.qrc \
              lessonsImages.qrc \
              pianoImages.qrc \
              multiplayerImages.qrc
+
+# "qmake CONFIG+=trace" compiles in the latency tracing of trace.h: F3 shows the
+# input latency and frame time overlay, Ctrl+F3 writes a Chrome trace file.
+trace: DEFINES += KEYQUEST_TRACE
+
+# Images are normally linked into the executable. With "qmake CONFIG+=external_assets"
+# they are resized and recompressed into KeyQuestAssets.rcc next to the executable
+# instead, which is memory-mapped at startup (see tools/asset_pipeline.py).
+external_assets {
+    ASSET_PYTHON = $$system(python3 -c \"import PIL; print(1)\")
+    isEmpty(ASSET_PYTHON): error("CONFIG+=external_assets needs python3 with Pillow")
+
+    ASSET_RCC = $$OUT_PWD/KeyQuestAssets.rcc
+    for(qrc, IMAGE_QRCS): ASSET_QRC_FILES += $$PWD/$$qrc
+    assets.target = $$ASSET_RCC
+    assets.commands = python3 $$PWD/tools/asset_pipeline.py \
+        --rcc $$shell_quote($$[QT_HOST_LIBEXECS]/rcc) \
+        --scan $$PWD/mainwindow.ui \
+        $$OUT_PWD/assets $$ASSET_RCC $$ASSET_QRC_FILES
+    assets.depends = $$PWD/tools/asset_pipeline.py $$PWD/tools/assets.json $$ASSET_QRC_FILES \
+        $$files($$PWD/resources/*.png) $$files($$PWD/lessonsImages/*.png) \
+        $$files($$PWD/pianoImages/*.png) $$files($$PWD/multiplayerImages/*.png)
+    QMAKE_EXTRA_TARGETS += assets
+    PRE_TARGETDEPS += $$ASSET_RCC
+    QMAKE_CLEAN += $$ASSET_RCC
+    DEFINES += KEYQUEST_EXTERNAL_ASSETS
+
+    assetfiles.files = $$ASSET_RCC
+    assetfiles.path = $$target.path
+    !isEmpty(target.path): INSTALLS += assetfiles
+} else {
+    RESOURCES += $$IMAGE_QRCS
+}
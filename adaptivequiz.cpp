@@ -8,13 +8,13 @@
  */
 
 #include "adaptivequiz.h"
-#include <iostream>
+#include "trace.h"
 #include <map>
 #include <vector>
-#include <tuple>
 #include <random>
 #include <algorithm>
-#include <unordered_set>
+#include <QtAlgorithms>
+#include <QDateTime>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -23,17 +23,18 @@
 
 /**
  * @brief Constructor for AdaptiveQuiz
- * @param questionBank Map of question IDs to Question objects
- * @param qTable The Q-table with stored learning from previous sessions
+ * @param questionBank Indexed question bank; must outlive the quiz
+ * @param qTable The Q-table with stored learning from previous sessions; borrowed
  * @param initialState The initial skill state of the user
+ * @param seed Session seed for the quiz's random choices
  * @param parent Parent QObject for memory management
  */
-AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
-    const std::map<State, std::map<int, float>>& qTable,
+AdaptiveQuiz::AdaptiveQuiz(const QuestionBank& questionBank,
+    QTable& qTable,
     const State& initialState,
+    quint64 seed,
     QObject* parent)
-    : QObject(parent),
-    questionBankByID(questionBank),
+    : GameSession(questionBank, seed, parent),
     q_table(qTable),
     state(initialState),
     lr(0.1f),
@@ -42,7 +43,136 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
     incorrectThreshold(4),
     score(0.0f),
     correctAnswers(0),
-    totalQuestions(0) {}
+    totalQuestions(0) {
+        // Give every question a slot up front so the table never grows mid-quiz
+        std::vector<int> questionIDs;
+        questionIDs.reserve(questionBank.size());
+        for (const Question& question : questionBank.questions()) {
+            questionIDs.push_back(question.getQuestionID());
+        }
+        q_table.addActions(questionIDs);
+        buildCandidateColumns();
+        scoring.setQuestionCapacity(static_cast<int>(candidateIndexByID.size()));
+    }
+
+    /**
+     * @brief Builds the selection columns from the question bank
+     * @details Follows the order of getActionsForStateLevel(): topics in ascending
+     *          order, then the (topic, difficulty) index from difficulty 0 to 3.
+     *          Topics below 101 and harder questions can never be selected and are
+     *          left out.
+     */
+    void AdaptiveQuiz::buildCandidateColumns() {
+        candidateIDs.clear();
+        candidateSlots.clear();
+        topicRanges.clear();
+        candidateIndexByID.clear();
+
+        for (int topicID : questionBank.topicIDs()) {
+            TopicRange range;
+            if (topicID == 101) range.domain = 0;
+            else if (topicID >= 102 && topicID <= 103) range.domain = 1;
+            else if (topicID >= 104) range.domain = 2;
+            else continue;
+
+            if (topicID == 101) range.group = 0;
+            else if (topicID == 102) range.group = 1;
+            else if (topicID == 104) range.group = 2;
+            else range.group = 3;
+
+            range.begin = static_cast<int>(candidateIDs.size());
+            for (int difficulty = 0; difficulty <= QTable::LEVEL_COUNT; ++difficulty) {
+                for (int qid : questionBank.questionIDs(topicID, difficulty)) {
+                    if (qid >= static_cast<int>(candidateIndexByID.size())) {
+                        candidateIndexByID.resize(qid + 1, -1);
+                    }
+                    candidateIndexByID[qid] = static_cast<int>(candidateIDs.size());
+                    candidateIDs.push_back(qid);
+                    candidateSlots.push_back(q_table.slotOf(qid));
+                }
+                range.ends[difficulty] = static_cast<int>(candidateIDs.size());
+            }
+            topicRanges.push_back(range);
+        }
+
+        askedBits.assign((candidateIDs.size() + 63) / 64, 0);
+    }
+
+    /**
+     * @brief Gets the end of a topic's candidates for the current skill state
+     * @param range The topic's range
+     * @param stretch 1 to include questions one level above the user's skill, else 0
+     * @return End index of the eligible candidates; they start at range.begin
+     */
+    int AdaptiveQuiz::eligibleEnd(const TopicRange& range, int stretch) const {
+        int level = range.domain == 0 ? state.notes : range.domain == 1 ? state.chords : state.scales;
+        return range.ends[qBound(0, level + stretch, QTable::LEVEL_COUNT)];
+    }
+
+    /**
+     * @brief Counts the candidates of a range not asked this session
+     * @param begin First candidate index
+     * @param end End candidate index
+     * @return Number of unasked candidates in [begin, end)
+     */
+    int AdaptiveQuiz::countUnasked(int begin, int end) const {
+        int count = 0;
+        for (int i = begin; i < end;) {
+            int bit = i & 63;
+            int bits = qMin(64 - bit, end - i);
+            quint64 mask = (bits == 64 ? ~quint64(0) : (quint64(1) << bits) - 1) << bit;
+            count += bits - static_cast<int>(qPopulationCount(askedBits[i >> 6] & mask));
+            i += bits;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Finds an unasked candidate by its position
+     * @param begin First candidate index
+     * @param end End candidate index
+     * @param n Position among the unasked candidates of [begin, end); updated to the
+     *          position left over for the following ranges if the range has fewer
+     * @return The candidate index, or -1 if the range has n or fewer unasked candidates
+     * @details Skips whole words by their population count and only walks the bits
+     *          of the word that holds the candidate.
+     */
+    int AdaptiveQuiz::nthUnasked(int begin, int end, int& n) const {
+        for (int i = begin; i < end;) {
+            int bit = i & 63;
+            int bits = qMin(64 - bit, end - i);
+            quint64 mask = (bits == 64 ? ~quint64(0) : (quint64(1) << bits) - 1) << bit;
+            quint64 unasked = ~askedBits[i >> 6] & mask;
+            int count = static_cast<int>(qPopulationCount(unasked));
+            if (n < count) {
+                for (int skip = 0; skip < n; ++skip) {
+                    unasked &= unasked - 1;
+                }
+                return (i & ~63) + qCountTrailingZeroBits(unasked);
+            }
+            n -= count;
+            i += bits;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Prepares the quiz for a new session in place
+     * @param initialState The skill state the new session starts from
+     * @param seed Session seed of the new session
+     */
+    void AdaptiveQuiz::restart(const State& initialState, quint64 seed) {
+        resetSession(seed);
+        state = initialState;
+        history.clear();
+        askedQuestionsThisSession.clear();
+        correctCounts.clear();
+        incorrectCounts.clear();
+        score = 0.0f;
+        correctAnswers = 0;
+        totalQuestions = 0;
+        std::fill(askedBits.begin(), askedBits.end(), 0);
+    }
 
 
 
@@ -62,13 +192,17 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
             stretchAmount = 1;
         }
 
-        for (const auto& [qid, q] : questionBankByID) {
-            int topicID = q.getTopicID();
-            int difficulty = q.getDifficulty();
-            if ((topicID == 101 && difficulty <= state.notes + stretchAmount) ||
-                    (topicID >= 102 && topicID <= 103 && difficulty <= state.chords + stretchAmount) ||
-                    (topicID >= 104 && difficulty <= state.scales + stretchAmount)) {
-                    validQuestionIDs.push_back(qid);
+        // Walk the (topic, difficulty) index instead of the whole bank
+        for (int topicID : questionBank.topicIDs()) {
+            int level;
+            if (topicID == 101) level = state.notes;
+            else if (topicID >= 102 && topicID <= 103) level = state.chords;
+            else if (topicID >= 104) level = state.scales;
+            else continue;
+
+            for (int difficulty = 0; difficulty <= level + stretchAmount; ++difficulty) {
+                const std::vector<int>& ids = questionBank.questionIDs(topicID, difficulty);
+                validQuestionIDs.insert(validQuestionIDs.end(), ids.begin(), ids.end());
             }
         }
         return validQuestionIDs;
@@ -82,6 +216,15 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
      * @return Question ID of the selected question
      */
     int AdaptiveQuiz::getNextAction() {
+        KEYQUEST_TRACE_SCOPE("AdaptiveQuiz::getNextAction");
+        // Blend in a due review; the random draw is only made when there is one
+        if (reviews) {
+            const int review = bestDueReview();
+            if (review >= 0 && rng.uniform() < REVIEW_SHARE) {
+                return candidateIDs[review];
+            }
+        }
+
         int avgLevel = (state.notes + state.chords + state.scales) / 3;
         float epsilon;
         if (avgLevel == 0){
@@ -94,64 +237,111 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
             epsilon = 0.5f;
         }
 
-        bool explore = ((float)rand() / RAND_MAX) < epsilon;
+        bool explore = rng.uniform() < epsilon;
+        const int stretch = explore ? 1 : 0;
 
-        std::vector<int> candidates = getActionsForStateLevel(explore);
-    
-        // Filter out already asked questions
-        std::vector<int> filteredCandidates;
-        for (int qid : candidates) {
-            if (askedQuestionsThisSession.find(qid) == askedQuestionsThisSession.end()) {
-                filteredCandidates.push_back(qid);
-            }
+        // Count the questions at the user's level that have not been asked yet
+        int available = 0;
+        for (const TopicRange& range : topicRanges) {
+            available += countUnasked(range.begin, eligibleEnd(range, stretch));
         }
 
-        if (filteredCandidates.empty()) {
+        if (available == 0) {
             // All have been asked - reset session and allow repetition
-            askedQuestionsThisSession.clear();
-            filteredCandidates = candidates;
+            std::fill(askedBits.begin(), askedBits.end(), 0);
+            for (const TopicRange& range : topicRanges) {
+                available += eligibleEnd(range, stretch) - range.begin;
+            }
         }
 
-        if (filteredCandidates.empty()) return questionBankByID.begin()->first;
+        if (available == 0) {
+            return questionBank.isEmpty() ? -1 : questionBank.questions().front().getQuestionID();
+        }
 
         if (explore) {
             // exploring
-            // pick a random question from filtered list
-            std::vector<int> notesQ, chordsQ, scalesQ;
-            for (int qid : filteredCandidates) {
-                int tid = questionBankByID[qid].getTopicID();
-                if (tid == 101) notesQ.push_back(qid);
-                else if (tid >= 101 && tid <= 102) chordsQ.push_back(qid);
-                else if (tid == 104) scalesQ.push_back(qid);
+            // pick a random question from one group, or from all of them if it is empty
+            quint32 choice = rng.bounded(3);
+            int inGroup = 0;
+            for (const TopicRange& range : topicRanges) {
+                if (range.group == choice) {
+                    inGroup += countUnasked(range.begin, eligibleEnd(range, stretch));
+                }
             }
 
-            std::vector<int>* group = nullptr;
-            int choice = rand() % 3;
-            if (choice == 0 && !notesQ.empty()) group = &notesQ;
-            else if (choice == 1 && !chordsQ.empty()) group = &chordsQ;
-            else if (choice == 2 && !scalesQ.empty()) group = &scalesQ;
-
-            if (group && !group->empty()) {
-                return (*group)[rand() % group->size()];
-            } else {
-                return filteredCandidates[rand() % filteredCandidates.size()];
+            const bool fromGroup = inGroup > 0;
+            int n = static_cast<int>(rng.bounded(static_cast<quint32>(fromGroup ? inGroup : available)));
+            for (const TopicRange& range : topicRanges) {
+                if (fromGroup && range.group != choice) {
+                    continue;
+                }
+                int index = nthUnasked(range.begin, eligibleEnd(range, stretch), n);
+                if (index >= 0) {
+                    return candidateIDs[index];
+                }
             }
+            return -1;
         } else {
             // exploiting
-            // pick question with highest Q-value
-            int bestQID = filteredCandidates[0];
-            float bestValue = -1e9;
-            for (int qid : filteredCandidates) {
-                float q = q_table[state][qid];
-                if (q > bestValue) {
-                    bestValue = q;
-                    bestQID = qid;
+            // pick the first unasked question with the highest Q-value
+            const float* values = q_table.row(state);
+            float bestValue = -1e9f;
+            int best = -1;
+            for (const TopicRange& range : topicRanges) {
+                const int end = eligibleEnd(range, stretch);
+                for (int i = range.begin; i < end; ++i) {
+                    const bool asked = (askedBits[i >> 6] >> (i & 63)) & 1;
+                    const float q = asked ? -1e30f : values[candidateSlots[i]];
+                    if (q > bestValue) {
+                        bestValue = q;
+                        best = i;
+                    }
+                }
+            }
+            if (best < 0) {
+                int n = 0;
+                for (const TopicRange& range : topicRanges) {
+                    best = nthUnasked(range.begin, eligibleEnd(range, stretch), n);
+                    if (best >= 0) {
+                        break;
+                    }
                 }
             }
-            return bestQID;
+            return best < 0 ? -1 : candidateIDs[best];
         }
-        std::cout << "[DEBUG] Mode: " << (explore ? "Explore" : "Exploit") << "\n";
+    }
 
+    /**
+     * @brief Picks the due review with the highest Q-value
+     * @return Candidate index of the review, or -1 if no due question is eligible
+     */
+    int AdaptiveQuiz::bestDueReview() const {
+        int due[REVIEW_LOOKAHEAD];
+        const int count = reviews->dueQuestions(QDateTime::currentSecsSinceEpoch(), due, REVIEW_LOOKAHEAD);
+        const float* values = q_table.row(state);
+        float bestValue = -1e30f;
+        int best = -1;
+        for (int i = 0; i < count; ++i) {
+            const int questionID = due[i];
+            if (questionID >= static_cast<int>(candidateIndexByID.size())) {
+                continue;
+            }
+            const int index = candidateIndexByID[questionID];
+            if (index < 0 || ((askedBits[index >> 6] >> (index & 63)) & 1)) {
+                continue;
+            }
+            // The ranges are few; find the one holding the candidate
+            for (const TopicRange& range : topicRanges) {
+                if (index >= range.begin && index < range.ends[QTable::LEVEL_COUNT]) {
+                    if (index < eligibleEnd(range, 0) && values[candidateSlots[index]] > bestValue) {
+                        bestValue = values[candidateSlots[index]];
+                        best = index;
+                    }
+                    break;
+                }
+            }
+        }
+        return best;
     }
 
     /**
@@ -165,14 +355,15 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
     /**
      * @brief Retrieves a question by its ID
      * @param questionID The ID of the question to retrieve
-     * @return The Question object
+     * @return Reference to the Question record in the question bank
      */
-    Question AdaptiveQuiz::getQuestion(int questionID) { 
-        if (questionBankByID.find(questionID) != questionBankByID.end()) {
-            return questionBankByID.at(questionID);
+    const Question& AdaptiveQuiz::getQuestion(int questionID) const { 
+        if (const Question* question = questionBank.question(questionID)) {
+            return *question;
         } else {
             // Return default/empty question to avoid crash
-            return Question();
+            static const Question emptyQuestion;
+            return emptyQuestion;
         }
     }
     
@@ -185,13 +376,29 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
      * @param before State before the transition
      * @param after State after the transition
      * @param correct Whether the answer was correct
+     * @param questionID The answered question, -1 to leave out the analytics
+     * @param responseMs Time taken to answer in milliseconds, -1 if not known
      * @return Float value representing the reward
      */
-    float AdaptiveQuiz::getReward(const State& before, const State& after, bool correct) {
-        if (correct && (after.notes > before.notes || after.chords > before.chords || after.scales > before.scales))
-            return 5.0f;
-        if (correct) return 2.5f;
-        return -2.5f;
+    float AdaptiveQuiz::getReward(const State& before, const State& after, bool correct,
+                                  int questionID, qint64 responseMs) {
+        if (!correct) return -2.5f;
+        float reward = (after.notes > before.notes || after.chords > before.chords || after.scales > before.scales)
+            ? 5.0f : 2.5f;
+        if (questionID < 0) return reward;
+
+        // Practising a weak spot is worth more than repeating what is already known
+        const QuestionBank::AnswerKey* answer = questionBank.answerKey(questionID);
+        if (answer && (answer->notes.pitchClassMask() & scoring.weakPitchClasses())) {
+            reward += WEAK_SPOT_BONUS;
+        }
+
+        // A right answer that took far longer than usual is not fluent yet
+        const qint64 median = scoring.medianResponseMs();
+        if (responseMs >= 0 && median > 0 && responseMs > SLOW_ANSWER_FACTOR * median) {
+            reward -= SLOW_ANSWER_PENALTY;
+        }
+        return reward;
     }
 
     // Finds the highest Q-value from all possible actions in the current state
@@ -201,12 +408,7 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
      * @return Float value of the maximum Q-value
      */
     float AdaptiveQuiz::maxQValue(const State& s) {
-        if (q_table.find(s) == q_table.end()) return 0.0f;
-        float maxQ = 0.0f;
-        for (const auto& [_, q] : q_table[s]) {
-            if (q > maxQ) maxQ = q;
-        }
-        return maxQ;
+        return q_table.maxValue(s);
     }
 
     // Upgrade the skill level if answer was correct,
@@ -218,8 +420,11 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
      * @param currentState The state to update
      */
     void AdaptiveQuiz::updateState(int questionID, bool correct, State& currentState) {
-        int difficulty = questionBankByID[questionID].getDifficulty();
-        int topicID = questionBankByID[questionID].getTopicID();
+        const Question* question = questionBank.question(questionID);
+        if (!question) return;
+
+        int difficulty = question->getDifficulty();
+        int topicID = question->getTopicID();
         
         // Assigning points weight for each diffculty value
         int points = 1;
@@ -262,9 +467,9 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
      * @param nextState State after the action
      */
     void AdaptiveQuiz::updateQTable(const State& currentState, int questionID, float reward, const State& nextState) {
-        float& q = q_table[currentState][questionID];
+        float q = q_table.value(currentState, questionID);
         float nextMax = maxQValue(nextState);
-        q = q + lr * (reward + df * nextMax - q);
+        q_table.setValue(currentState, questionID, q + lr * (reward + df * nextMax - q));
     }
 
     // returns Q-value for a given state-action, used in test cases
@@ -275,23 +480,26 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
      * @return Float value representing the Q-value
      */
     float AdaptiveQuiz::getQValue(const State& s, int questionID) const {
-        auto it = q_table.find(s);
-        if (it != q_table.end()) {
-            auto jt = it->second.find(questionID);
-            if (jt != it->second.end()) return jt->second;
-        }
-        return 0.0f;
+        return q_table.value(s, questionID);
     }
 
     // This method will return Q-table so it can be saved in database
     /**
      * @brief Gets the current Q-table
-     * @return Map representing the Q-table for all states and actions
+     * @return The Q-table for all states and actions
      */
-    std::map<State, std::map<int, float>> AdaptiveQuiz::getQTable() const {
+    const QTable& AdaptiveQuiz::getQTable() const {
         return q_table; 
     }
 
+    /**
+     * @brief Sets the spaced-repetition schedule blended into the selection
+     * @param schedule The schedule, borrowed; nullptr selects by the Q-table alone
+     */
+    void AdaptiveQuiz::setReviewSchedule(ReviewSchedule* schedule) {
+        reviews = schedule;
+    }
+
     /**
      * @brief Gets the number of correctly answered questions
      * @return Integer count of correct answers
@@ -315,7 +523,7 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
     float AdaptiveQuiz::getScore() const {
         return score;
     }
-    
+
     /**
      * @brief Calculates the current accuracy as a percentage
      * @return Float value representing accuracy (0-100)
@@ -326,11 +534,19 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
     
     /**
      * @brief Gets the history of quiz interactions
-     * @return Vector of tuples containing state, question ID, description, and correctness
+     * @return The answered questions with the state, question ID and correctness of each
      */
-    const std::vector<std::tuple<State, int, QString, bool>>& AdaptiveQuiz::getHistory() const {
+    const std::vector<QuizReport::Entry>& AdaptiveQuiz::getHistory() const {
         return history;
     }
+
+    /**
+     * @brief Gets the analytics of the answers given so far
+     * @return The scoring system fed by evaluateResponse()
+     */
+    const ScoringSystem& AdaptiveQuiz::getScoring() const {
+        return scoring;
+    }
     
 
 
@@ -346,10 +562,15 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
      * @brief Processes and evaluates a user's response to a question
      * @param questionID The ID of the answered question
      * @param correct Whether the answer was correct
+     * @param playedNotes The notes played, empty if not known
+     * @param responseMs Time taken to answer in milliseconds, -1 if not known
      */
-    void AdaptiveQuiz::evaluateResponse(int questionID, bool correct) {
-        // Add to history
-        history.emplace_back(state, questionID, questionBankByID[questionID].getDescription(), correct);
+    void AdaptiveQuiz::evaluateResponse(int questionID, bool correct, const NoteSet& playedNotes,
+                                        qint64 responseMs) {
+        KEYQUEST_TRACE_SCOPE("AdaptiveQuiz::evaluateResponse");
+        // Add to history; the question is referenced by ID only
+        history.push_back({state, questionID, correct});
+        emit answerEvaluated(history.back());
         
         // Track total questions and correct answers
         totalQuestions++;
@@ -361,19 +582,99 @@ AdaptiveQuiz::AdaptiveQuiz(const std::map<int, Question>& questionBank,
             if (score < 0.0f) score = 0.0f;  // Keep score non-negative
         }
 
-        // Emit signal for highlighting keys with correctness feedback
-        emit highlightKeys(correct);
-        
         // Save state before update for reward calculation
         State stateBefore = state;
         
         // Update user's skill level based on response
         updateState(questionID, correct, state);
         
-        // Get reward and update Q-table
-        float reward = getReward(stateBefore, state, correct);
+        // Get reward and update Q-table; the reward sees the analytics before this answer
+        float reward = getReward(stateBefore, state, correct, questionID, responseMs);
         updateQTable(stateBefore, questionID, reward, state);
+
+        // Update the analytics in constant time
+        if (const QuestionBank::AnswerKey* answer = questionBank.answerKey(questionID)) {
+            const Question* question = questionBank.question(questionID);
+            scoring.evaluateAttempt(questionID, question ? question->getTopicID() : -1,
+                                    answer->notes, playedNotes, correct, responseMs);
+        }
         
-        // Add question to asked set
-        askedQuestionsThisSession.insert(questionID);
+        // Schedule the question's next review
+        if (reviews) {
+            reviews->review(questionID, correct, QDateTime::currentSecsSinceEpoch());
+        }
+
+        // Mark the question as asked
+        if (questionID >= 0 && questionID < static_cast<int>(candidateIndexByID.size())) {
+            int index = candidateIndexByID[questionID];
+            if (index >= 0) {
+                askedBits[index >> 6] |= quint64(1) << (index & 63);
+            }
+        }
+    }
+
+    /**
+     * @brief Follows an update of the shared question bank
+     * @param changes What QuestionBank::update() changed
+     */
+    void AdaptiveQuiz::handleQuestionBankChanged(const QuestionBank::Changes& changes) {
+        if (!changes.topicIDs.empty()) {
+            std::vector<int> added;
+            for (int questionID : changes.questionIDs) {
+                if (questionBank.question(questionID) && q_table.slotOf(questionID) < 0) {
+                    added.push_back(questionID);
+                }
+            }
+            q_table.addActions(added);
+
+            std::vector<int> asked;
+            for (int i = 0; i < static_cast<int>(candidateIDs.size()); ++i) {
+                if ((askedBits[i >> 6] >> (i & 63)) & 1) {
+                    asked.push_back(candidateIDs[i]);
+                }
+            }
+            buildCandidateColumns();
+            for (int questionID : asked) {
+                const int index = questionID < static_cast<int>(candidateIndexByID.size()) ? candidateIndexByID[questionID] : -1;
+                if (index >= 0) {
+                    askedBits[index >> 6] |= quint64(1) << (index & 63);
+                }
+            }
+        }
+        GameSession::handleQuestionBankChanged(changes);
+    }
+
+    /**
+     * @brief Question source of the session: the Q-learning selection
+     * @return Question ID selected by getNextAction()
+     */
+    int AdaptiveQuiz::nextQuestionID() {
+        return getNextAction();
+    }
+
+    /**
+     * @brief Scoring policy of the session: evaluates the current question
+     * @param correct Whether the attempt was correct
+     * @return true, the quiz always moves on to the next question
+     */
+    bool AdaptiveQuiz::scoreAttempt(bool correct) {
+        evaluateResponse(getCurrentQuestionID(), correct, attemptNotes,
+                         questionTimer.isValid() ? questionTimer.elapsed() : -1);
+        return true;
+    }
+
+    /**
+     * @brief Emits updateUI for the current question
+     * @details Starts timing the response.
+     */
+    void AdaptiveQuiz::showQuestion() {
+        questionTimer.start();
+        emit updateUI(static_cast<int>(score), getCurrentTitle(), getCurrentDescription(), getAccuracy());
+    }
+
+    /**
+     * @brief Emits quizOver with the final score and accuracy
+     */
+    void AdaptiveQuiz::finish() {
+        emit quizOver(static_cast<int>(score), getAccuracy());
     }
@@ -11,11 +11,16 @@
 #pragma once
 #include <map>
 #include <vector>
-#include <tuple>
+#include <QElapsedTimer>
 #include <QString>
-#include <unordered_set>
 #include <QObject>
+#include "gamesession.h"
 #include "question.h"
+#include "qtable.h"
+#include "questionbank.h"
+#include "quizreport.h"
+#include "reviewschedule.h"
+#include "scoringsystem.h"
 #include "state.h"
 
 /**
@@ -27,32 +32,75 @@
  *          appropriate rewards for the learning algorithm. The engine maintains
  *          a history of questions asked and responses, and provides methods for
  *          score and accuracy calculation.
+ *
+ *          As a GameSession the quiz is the question source (getNextAction()) and
+ *          the scoring policy (evaluateResponse()) of the shared question loop, so
+ *          QuizWidget drives it like the lessons and the multiplayer game. The
+ *          engine methods can also be called directly, as quizbench does.
+ *
+ *          Question selection runs over columns built once from the bank: the
+ *          candidates are laid out by topic and then difficulty, so the questions of a
+ *          topic up to a skill level form one contiguous range, and a bitset marks the
+ *          candidates asked this session. Counting and drawing the unasked questions
+ *          work on whole 64-bit words, and the greedy choice is a single masked pass
+ *          over the ranges and the state's Q-table row. getNextAction() allocates nothing.
+ *
+ *          With a ReviewSchedule set, the questions that are due for review by
+ *          spaced repetition are blended in: getNextAction() looks at the earliest
+ *          REVIEW_LOOKAHEAD due questions, takes the one at the user's level with the
+ *          highest Q-value, and asks it instead of the usual choice REVIEW_SHARE of
+ *          the time. Every answer reschedules its question.
+ *
+ *          Every answer also feeds a ScoringSystem with the notes played and the
+ *          response time. The reward uses its weak spots and median response time,
+ *          and StatisticsWidget shows them. Like the Q-table, these analytics span
+ *          all the quizzes run on one engine; restart() keeps them.
  */
-class AdaptiveQuiz : public QObject {
+class AdaptiveQuiz : public GameSession {
     Q_OBJECT
     
 private:
-    /// Maps each state to a map of question IDs and their Q-values
-    std::map<State, std::map<int, float>> q_table;
+    /// Q-values of every (state, question ID) pair, borrowed from the owner
+    QTable& q_table;
+
+    /// Spaced-repetition schedule of the user, borrowed from the owner; nullptr if not used
+    ReviewSchedule* reviews = nullptr;
 
     /// User's current skill state (notes, chords, scales)
     State state;
 
-    /// Questions mapped by their unique ID
-    std::map<int, Question> questionBankByID;
-
     /**
      * @brief History of quiz interactions
-     * @details Each entry is a tuple containing:
-     *          - User's state when question was asked
-     *          - Question ID
-     *          - Question description
-     *          - Boolean indicating if user's response was correct
+     * @details Each entry holds the user's state when the question was asked, the
+     *          question ID and whether the response was correct. The question's
+     *          texts stay in the QuestionBank.
      */
-    std::vector<std::tuple<State, int, QString, bool>> history;
+    std::vector<QuizReport::Entry> history;
+
+    /**
+     * @brief Candidates of one topic within the selection columns
+     */
+    struct TopicRange {
+        int begin;                          ///< First candidate of the topic
+        int ends[QTable::LEVEL_COUNT + 1];  ///< End of the candidates at or below each difficulty (0-3)
+        quint8 domain;                      ///< Skill the topic belongs to: 0 notes, 1 chords, 2 scales
+        quint8 group;                       ///< Group drawn from when exploring: 0 notes, 1 chords, 2 scales, 3 none
+    };
+
+    /// Question ID of every candidate, ordered by topic and then difficulty
+    std::vector<int> candidateIDs;
+
+    /// Q-table slot of every candidate
+    std::vector<int> candidateSlots;
 
-    /// Set of question IDs that have already been asked in the current session
-    std::unordered_set<int> askedQuestionsThisSession;
+    /// Range of every topic within the candidate columns, in ascending topic order
+    std::vector<TopicRange> topicRanges;
+
+    /// One bit per candidate, set once the candidate has been asked in the current session
+    std::vector<quint64> askedBits;
+
+    /// Candidate index of every question ID, -1 for questions never selected; indexed by ID
+    std::vector<int> candidateIndexByID;
 
     /// Learning rate for Q-learning algorithm
     float lr;
@@ -81,22 +129,97 @@ private:
     /// Total number of questions answered
     int totalQuestions;
 
+    /// Confusions, response times and weighted accuracies of every answer
+    ScoringSystem scoring;
+
+    /// Started when a question is shown, to time the response
+    QElapsedTimer questionTimer;
+
+    /// Reward added for a correct answer that covers a weak spot
+    static constexpr float WEAK_SPOT_BONUS = 1.0f;
+
+    /// Reward taken from a correct answer that was slower than SLOW_ANSWER_FACTOR times the median
+    static constexpr float SLOW_ANSWER_PENALTY = 1.0f;
+
+    /// Multiple of the median response time above which a correct answer counts as slow
+    static constexpr qint64 SLOW_ANSWER_FACTOR = 2;
+
+    /// Number of the earliest due reviews considered for each question
+    static constexpr int REVIEW_LOOKAHEAD = 8;
+
+    /// Share of the questions that are a due review when one is eligible
+    static constexpr float REVIEW_SHARE = 0.5f;
+
+    /**
+     * @brief Builds the selection columns from the question bank
+     */
+    void buildCandidateColumns();
+
+    /**
+     * @brief Gets the end of a topic's candidates for the current skill state
+     * @param range The topic's range
+     * @param stretch 1 to include questions one level above the user's skill, else 0
+     * @return End index of the eligible candidates; they start at range.begin
+     */
+    int eligibleEnd(const TopicRange& range, int stretch) const;
+
+    /**
+     * @brief Counts the candidates of a range not asked this session
+     * @param begin First candidate index
+     * @param end End candidate index
+     * @return Number of unasked candidates in [begin, end)
+     */
+    int countUnasked(int begin, int end) const;
+
+    /**
+     * @brief Finds an unasked candidate by its position
+     * @param begin First candidate index
+     * @param end End candidate index
+     * @param n Position among the unasked candidates of [begin, end); updated to the
+     *          position left over for the following ranges if the range has fewer
+     * @return The candidate index, or -1 if the range has n or fewer unasked candidates
+     */
+    int nthUnasked(int begin, int end, int& n) const;
+
+    /**
+     * @brief Picks the due review with the highest Q-value
+     * @return Candidate index of the review, or -1 if no due question is eligible
+     * @details Only questions at the user's level that have not been asked this
+     *          session are eligible.
+     */
+    int bestDueReview() const;
+
 public:
     /**
      * @brief Constructor for AdaptiveQuiz
-     * @param questionBank Map of question IDs to Question objects
-     * @param qTable The Q-table with stored learning from previous sessions
+     * @param questionBank Indexed question bank; must outlive the quiz
+     * @param qTable The Q-table with stored learning from previous sessions; it is
+     *               borrowed, updated in place and must outlive the quiz
      * @param initialState The initial skill state of the user
+     * @param seed Session seed; a quiz replayed with the same seed, answers and
+     *             Q-table asks the same questions
      * @param parent Parent QObject for memory management
      * @details Initializes the adaptive quiz with a question bank, existing Q-values,
      *          and the user's initial skill state. Sets default values for learning
-     *          parameters and initializes counters for tracking progress.
+     *          parameters and initializes counters for tracking progress. A Q-table
+     *          slot is reserved for every question of the bank.
      */
-    AdaptiveQuiz(const std::map<int, Question>& questionBank,
-        const std::map<State, std::map<int, float>>& qTable,
+    AdaptiveQuiz(const QuestionBank& questionBank,
+        QTable& qTable,
         const State& initialState,
+        quint64 seed,
         QObject* parent = nullptr);
 
+    /**
+     * @brief Prepares the quiz for a new session in place
+     * @param initialState The skill state the new session starts from
+     * @param seed Session seed of the new session
+     * @details Clears the score, history and answer counters. The borrowed Q-table
+     *          keeps what earlier sessions learned. The first question is asked by
+     *          start().
+     */
+    void restart(const State& initialState, quint64 seed);
+
     /**
      * @brief Gets the number of correctly answered questions
      * @return Integer count of correct answers
@@ -125,25 +248,35 @@ public:
 
     /**
      * @brief Gets the history of quiz interactions
-     * @return Vector of tuples containing state, question ID, description, and correctness
+     * @return The answered questions with the state, question ID and correctness of each
      */
-    const std::vector<std::tuple<State, int, QString, bool>>& getHistory() const;
+    const std::vector<QuizReport::Entry>& getHistory() const;
 
     /**
      * @brief Gets the current Q-table
-     * @return Map representing the Q-table for all states and actions
+     * @return The borrowed Q-table for all states and actions
      * @details Returns the entire Q-table which maps states to question IDs and
      *          their associated Q-values. Used for saving learning progress.
      */
-    std::map<State, std::map<int, float>> getQTable() const;
+    const QTable& getQTable() const;
+
+    /**
+     * @brief Sets the spaced-repetition schedule blended into the selection
+     * @param schedule The schedule, borrowed and updated by every answer; it must
+     *                 outlive the quiz. nullptr selects by the Q-table alone, which
+     *                 keeps a seeded quiz reproducible.
+     */
+    void setReviewSchedule(ReviewSchedule* schedule);
 
     /**
      * @brief Gets valid questions for the current skill level
      * @param allowSlightStretch Whether to include questions slightly above user's level
      * @return Vector of question IDs that match the criteria
-     * @details Filters the question bank to find questions that match the user's
-     *          current skill level in each topic. If allowSlightStretch is true,
-     *          includes questions one level above the user's current skill.
+     * @details Collects the questions that match the user's current skill level in
+     *          each topic from the bank's (topic, difficulty) index, so only matching
+     *          questions are visited. If allowSlightStretch is true, includes questions
+     *          one level above the user's current skill. getNextAction() selects from
+     *          the same questions, in the same order, without building this list.
      */
     std::vector<int> getActionsForStateLevel(bool allowSlightStretch = false);
 
@@ -153,7 +286,9 @@ public:
      * @details Uses an epsilon-greedy strategy to balance exploration and exploitation.
      *          Explores (random selection) or exploits (highest Q-value) based on
      *          the user's average skill level. Avoids repeating questions within
-     *          the same session when possible.
+     *          the same session when possible. With a review schedule, a due review
+     *          is asked instead REVIEW_SHARE of the time. Works on the selection
+     *          columns and makes no heap allocation.
      */
     int getNextAction();
 
@@ -166,29 +301,35 @@ public:
     /**
      * @brief Retrieves a question by its ID
      * @param questionID The ID of the question to retrieve
-     * @return The Question object
+     * @return Reference to the Question record in the question bank
      * @details Looks up a question in the question bank by its ID.
      *          Returns an empty question if the ID is not found.
      */
-    Question getQuestion(int questionID);
+    const Question& getQuestion(int questionID) const;
 
     /**
      * @brief Calculates the reward for a state transition
      * @param before State before the transition
      * @param after State after the transition
      * @param correct Whether the answer was correct
+     * @param questionID The answered question, -1 to leave out the analytics
+     * @param responseMs Time taken to answer in milliseconds, -1 if not known
      * @return Float value representing the reward
      * @details Determines the reward based on whether the answer was correct
-     *          and whether the user's skill level improved.
+     *          and whether the user's skill level improved. A correct answer earns
+     *          WEAK_SPOT_BONUS more when the question covers one of the scoring
+     *          system's weak spots, and SLOW_ANSWER_PENALTY less when it took more
+     *          than SLOW_ANSWER_FACTOR times the median response time.
      */
-    float getReward(const State& before, const State& after, bool correct);
+    float getReward(const State& before, const State& after, bool correct,
+                    int questionID = -1, qint64 responseMs = -1);
 
     /**
      * @brief Finds the maximum Q-value for a given state
      * @param s The state to evaluate
      * @return Float value of the maximum Q-value
-     * @details Searches all actions (question IDs) in the Q-table for the
-     *          given state and returns the highest Q-value found.
+     * @details Reads the Q-table's cached maximum for the state, so this is a
+     *          constant-time lookup. Returns 0 if no stored value is larger.
      */
     float maxQValue(const State& s);
 
@@ -226,11 +367,30 @@ public:
      * @brief Processes and evaluates a user's response to a question
      * @param questionID The ID of the answered question
      * @param correct Whether the answer was correct
+     * @param playedNotes The notes played, empty if not known
+     * @param responseMs Time taken to answer in milliseconds, -1 if not known
      * @details Updates score, tracks history, updates user's skill state,
-     *          calculates rewards, updates the Q-table, and handles all
-     *          necessary bookkeeping for the adaptive quiz system.
+     *          calculates rewards, updates the Q-table, the scoring system and the
+     *          review schedule, and handles all necessary bookkeeping for the adaptive quiz system.
      */
-    void evaluateResponse(int questionID, bool correct);
+    void evaluateResponse(int questionID, bool correct, const NoteSet& playedNotes = NoteSet(),
+                          qint64 responseMs = -1);
+
+    /**
+     * @brief Gets the analytics of the answers given so far
+     * @return The scoring system fed by evaluateResponse()
+     */
+    const ScoringSystem& getScoring() const;
+
+public slots:
+    /**
+     * @brief Follows an update of the shared question bank
+     * @param changes What QuestionBank::update() changed
+     * @details When the questions of a topic or their difficulties changed, new
+     *          questions get a Q-table slot and the selection columns are rebuilt;
+     *          the questions already asked this session stay marked.
+     */
+    void handleQuestionBankChanged(const QuestionBank::Changes& changes) override;
     
 signals:
     /**
@@ -250,8 +410,34 @@ signals:
     void quizOver(int score, double accuracy);
 
     /**
-     * @brief Signal emitted for visual feedback on answer correctness
-     * @param isCorrect True if the answer was correct, false otherwise
+     * @brief Signal emitted when an answer has been added to the history
+     * @param entry The new history entry
+     * @details Emitted before quizOver() for the last question, so a receiver that
+     *          records answers as they come has the whole quiz when it ends.
+     */
+    void answerEvaluated(const QuizReport::Entry& entry);
+
+protected:
+    /**
+     * @brief Question source of the session: the Q-learning selection
+     * @return Question ID selected by getNextAction()
+     */
+    int nextQuestionID() override;
+
+    /**
+     * @brief Scoring policy of the session: evaluates the current question
+     * @param correct Whether the attempt was correct
+     * @return true, the quiz always moves on to the next question
+     */
+    bool scoreAttempt(bool correct) override;
+
+    /**
+     * @brief Emits updateUI for the current question and starts timing the response
+     */
+    void showQuestion() override;
+
+    /**
+     * @brief Emits quizOver with the final score and accuracy
      */
-    void highlightKeys(bool isCorrect);
+    void finish() override;
 };
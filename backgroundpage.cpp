@@ -16,6 +16,7 @@
  */
 BackgroundPage::BackgroundPage(QWidget *parent)
     : QWidget(parent)
+    , m_background(":/resources/KeyQuest.png")
 {
     // Enable widget to receive mouse and keyboard events directly
     setFocusPolicy(Qt::StrongFocus);
@@ -25,8 +26,9 @@ BackgroundPage::BackgroundPage(QWidget *parent)
  * @brief Handles the painting of the background page
  * @param event The paint event that triggered this function
  * @details This method draws the custom background image for the KeyQuest game.
- *          It scales the background to fill the widget while maintaining aspect ratio
- *          and centers the image within the widget.
+ *          The image is scaled to fill the widget while maintaining aspect ratio and
+ *          centered within the widget. Scaling only happens after a resize, so an
+ *          ordinary repaint just blits the cached copy.
  */
 void BackgroundPage::paintEvent(QPaintEvent *event)
 {
@@ -37,19 +39,16 @@ void BackgroundPage::paintEvent(QPaintEvent *event)
     style()->drawPrimitive(QStyle::PE_Widget, &opt, &p, this);
 
     // draws custom background
-    QPixmap background(":/resources/KeyQuest.png");
-    if (!background.isNull()) {
-        // Get the widget size
-        QSize widgetSize = size();
-        
-        // Scale the background to fill the entire widget while maintaining aspect ratio
-        QSize scaledSize = background.size().scaled(widgetSize, Qt::KeepAspectRatioByExpanding);
-        
-        // Calculate position to center the image
-        int x = (widgetSize.width() - scaledSize.width()) / 2;
-        int y = (widgetSize.height() - scaledSize.height()) / 2;
-        
-        // Draw the background
-        p.drawPixmap(x, y, scaledSize.width(), scaledSize.height(), background);
-    }
-} 
+    m_background.paint(p, this);
+}
+
+/**
+ * @brief Handles resizing of the background page
+ * @param event The resize event that triggered this function
+ * @details Drops the scaled background so it is rebuilt for the new size.
+ */
+void BackgroundPage::resizeEvent(QResizeEvent *event)
+{
+    m_background.invalidate();
+    QWidget::resizeEvent(event);
+}
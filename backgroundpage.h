@@ -14,6 +14,7 @@
 #include <QWidget>
 #include <QPainter>
 #include <QStyleOption>
+#include "backgroundrenderer.h"
 
 /**
  * @brief Widget class for displaying background pages
@@ -37,6 +38,15 @@ protected:
      * @param event The paint event
      */
     void paintEvent(QPaintEvent *event) override;
+
+    /**
+     * @brief Handles resize events for the widget
+     * @param event The resize event
+     */
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    BackgroundRenderer m_background;  ///< Cached, pre-scaled background image
 };
 
 #endif // BACKGROUNDPAGE_H 
\ No newline at end of file
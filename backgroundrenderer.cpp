@@ -0,0 +1,158 @@
+/**
+ * @file backgroundrenderer.cpp
+ * @brief Implementation of the BackgroundRenderer class
+ * @author Alan Cruz
+ * @details This file implements the decode-once, scale-on-resize drawing of the
+ *          background images.
+ */
+
+#include "backgroundrenderer.h"
+#include "memorymonitor.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QPixmapCache>
+#include <QSet>
+
+/// Every live renderer, for memoryUsage() and releaseHidden(); GUI thread only
+static QSet<BackgroundRenderer*> BACKGROUND_RENDERERS;
+
+/**
+ * @brief Constructs a renderer for an image resource
+ * @param resourcePath Path of the image, e.g. ":/resources/KeyQuest.png"
+ */
+BackgroundRenderer::BackgroundRenderer(const QString& resourcePath)
+    : m_resourcePath(resourcePath)
+{
+    BACKGROUND_RENDERERS.insert(this);
+}
+
+/**
+ * @brief Stops tracking the renderer
+ */
+BackgroundRenderer::~BackgroundRenderer()
+{
+    BACKGROUND_RENDERERS.remove(this);
+}
+
+/**
+ * @brief Gets the memory of the decoded images of all renderers
+ * @return Bytes of the scaled copies plus each distinct source image once
+ * @details Renderers of the same artwork share one decoded source through
+ *          QPixmapCache; its cache key tells them apart.
+ */
+qint64 BackgroundRenderer::memoryUsage()
+{
+    qint64 bytes = 0;
+    QSet<qint64> sources;
+    for (const BackgroundRenderer* renderer : BACKGROUND_RENDERERS) {
+        bytes += MemoryMonitor::pixmapBytes(renderer->m_scaled);
+        if (!renderer->m_source.isNull() && !sources.contains(renderer->m_source.cacheKey())) {
+            sources.insert(renderer->m_source.cacheKey());
+            bytes += MemoryMonitor::pixmapBytes(renderer->m_source);
+        }
+    }
+    return bytes;
+}
+
+/**
+ * @brief Frees the images of every renderer whose widget is hidden
+ * @details The shared sources are also dropped from QPixmapCache, so the memory
+ *          is returned once no visible renderer uses them.
+ */
+void BackgroundRenderer::releaseHidden()
+{
+    for (BackgroundRenderer* renderer : BACKGROUND_RENDERERS) {
+        if (renderer->m_widget && renderer->m_widget->isVisible()) {
+            continue;
+        }
+        if (!renderer->m_sourcePath.isEmpty()) {
+            QPixmapCache::remove(renderer->m_sourcePath);
+        }
+        renderer->m_source = QPixmap();
+        renderer->m_sourcePath.clear();
+        renderer->m_sourceDpr = 0.0;
+        renderer->invalidate();
+    }
+}
+
+/**
+ * @brief Loads the source image, decoding it only if it is not cached
+ * @param dpr Device pixel ratio the image will be drawn at
+ * @return true if the image is available
+ */
+bool BackgroundRenderer::ensureSource(qreal dpr)
+{
+    if (!m_source.isNull() && m_sourceDpr == dpr) {
+        return true;
+    }
+
+    // Prefer the @2x variant on high-DPI screens when the asset pipeline made one
+    QString path = m_resourcePath;
+    if (dpr > 1.0) {
+        QFileInfo info(m_resourcePath);
+        QString highDpiPath = info.path() + "/" + info.completeBaseName() + "@2x." + info.suffix();
+        if (QFile::exists(highDpiPath)) {
+            path = highDpiPath;
+        }
+    }
+
+    m_sourceDpr = dpr;
+    if (!m_source.isNull() && m_sourcePath == path) {
+        return true;
+    }
+
+    if (!QPixmapCache::find(path, &m_source)) {
+        if (!m_source.load(path)) {
+            qDebug() << "BackgroundRenderer: Failed to load background image:" << path;
+            return false;
+        }
+        QPixmapCache::insert(path, m_source);
+    }
+    m_sourcePath = path;
+    m_scaled = QPixmap();
+    return true;
+}
+
+/**
+ * @brief Draws the background over the whole widget
+ * @param painter Painter active on the widget
+ * @param widget The widget being painted
+ */
+void BackgroundRenderer::paint(QPainter& painter, const QWidget* widget)
+{
+    m_widget = widget;
+
+    // Work in device pixels so the blit below is 1:1 on high-DPI screens
+    qreal dpr = widget->devicePixelRatioF();
+    if (!ensureSource(dpr)) {
+        return;
+    }
+    QSize widgetSize = widget->size();
+    QSize deviceSize = widgetSize * dpr;
+    if (deviceSize.isEmpty()) {
+        return;
+    }
+
+    if (m_scaled.isNull() || m_scaledSize != deviceSize || m_scaled.devicePixelRatio() != dpr) {
+        // Scale the background to fill the entire widget while maintaining aspect ratio
+        m_scaled = m_source.scaled(deviceSize, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+        m_scaled.setDevicePixelRatio(dpr);
+        m_scaledSize = deviceSize;
+    }
+
+    // Center the image; the scaled size is in device pixels
+    QSizeF logicalSize = m_scaled.deviceIndependentSize();
+    qreal x = (widgetSize.width() - logicalSize.width()) / 2;
+    qreal y = (widgetSize.height() - logicalSize.height()) / 2;
+    painter.drawPixmap(QPointF(x, y), m_scaled);
+}
+
+/**
+ * @brief Drops the scaled copy
+ */
+void BackgroundRenderer::invalidate()
+{
+    m_scaled = QPixmap();
+    m_scaledSize = QSize();
+}
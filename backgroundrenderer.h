@@ -0,0 +1,94 @@
+/**
+ * @file backgroundrenderer.h
+ * @brief Header file for the BackgroundRenderer class
+ * @author Alan Cruz
+ * @details This file defines BackgroundRenderer, the helper the background page
+ *          widgets use to draw their full-screen artwork without decoding or
+ *          scaling the image on every repaint.
+ */
+
+#ifndef BACKGROUNDRENDERER_H
+#define BACKGROUNDRENDERER_H
+
+#include <QPainter>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+#include <QWidget>
+
+/**
+ * @brief Draws a cached, pre-scaled background image
+ * @details The source image is decoded once and shared through QPixmapCache, so
+ *          several pages using the same artwork only decode it once. The renderer
+ *          also keeps a copy scaled to the widget's current size in device pixels.
+ *          It is rebuilt only when the widget size or device pixel ratio changes, so
+ *          an ordinary repaint is a single unscaled blit.
+ *
+ *          On high-DPI screens the "@2x" variant of the image is used when the
+ *          resource exists (see tools/asset_pipeline.py).
+ *
+ *          Every renderer is tracked, so memoryUsage() can add up the decoded
+ *          images of all of them for MemoryMonitor, and releaseHidden() can free
+ *          those of pages that are not on screen.
+ */
+class BackgroundRenderer {
+public:
+    /**
+     * @brief Constructs a renderer for an image resource
+     * @param resourcePath Path of the image, e.g. ":/resources/KeyQuest.png"
+     */
+    explicit BackgroundRenderer(const QString& resourcePath);
+
+    /**
+     * @brief Stops tracking the renderer
+     */
+    ~BackgroundRenderer();
+
+    BackgroundRenderer(const BackgroundRenderer&) = delete;
+    BackgroundRenderer& operator=(const BackgroundRenderer&) = delete;
+
+    /**
+     * @brief Gets the memory of the decoded images of all renderers
+     * @return Bytes of the scaled copies plus each distinct source image once
+     */
+    static qint64 memoryUsage();
+
+    /**
+     * @brief Frees the images of every renderer whose widget is hidden
+     * @details They are decoded again the next time the widget is painted.
+     */
+    static void releaseHidden();
+
+    /**
+     * @brief Draws the background over the whole widget
+     * @param painter Painter active on the widget
+     * @param widget The widget being painted
+     * @details The image fills the widget while keeping its aspect ratio and is
+     *          centered, cropping whatever does not fit.
+     */
+    void paint(QPainter& painter, const QWidget* widget);
+
+    /**
+     * @brief Drops the scaled copy
+     * @details The next paint() scales the image again. Call this from resizeEvent.
+     */
+    void invalidate();
+
+private:
+    /**
+     * @brief Loads the source image, decoding it only if it is not cached
+     * @param dpr Device pixel ratio the image will be drawn at
+     * @return true if the image is available
+     */
+    bool ensureSource(qreal dpr);
+
+    QString m_resourcePath;  ///< Path of the image resource
+    QPixmap m_source;        ///< Decoded source image, shared with QPixmapCache
+    QString m_sourcePath;    ///< Path m_source was loaded from, either variant
+    qreal m_sourceDpr = 0.0; ///< Device pixel ratio the variant was chosen for
+    QPixmap m_scaled;        ///< Source scaled to m_scaledSize device pixels
+    QSize m_scaledSize;      ///< Widget size in device pixels m_scaled was made for
+    const QWidget* m_widget = nullptr; ///< Widget last painted on, which owns the renderer
+};
+
+#endif // BACKGROUNDRENDERER_H
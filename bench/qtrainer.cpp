@@ -0,0 +1,229 @@
+/**
+ * @file qtrainer.cpp
+ * @brief Offline training of the prior Q-table new players start from
+ * @author Alan Cruz
+ * @details This file implements the qtrainer console tool. It runs simulated
+ *          learners through the adaptive quiz engine on every core and writes the
+ *          Q-table they converge to in QTable's binary form. Shipped as
+ *          resources/qtablePrior.kqt, it is the table LoadDataManager gives every
+ *          profile that has not learned one of its own.
+ *
+ *          Training runs in rounds. In each round the learners are split into a
+ *          fixed number of shards; every shard trains its own copy of the table on
+ *          a thread of the pool, and the copies are averaged into the table the
+ *          next round starts from. The shard count, not the thread count, decides
+ *          the result, so a seed gives the same table on any machine.
+ *
+ *          Example:
+ *              qtrainer --learners 2000000 --rounds 8 --output resources/qtablePrior.kqt
+ */
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include "adaptivequiz.h"
+#include "qtable.h"
+#include "questionbank.h"
+#include "sessionrng.h"
+#include "simlearner.h"
+
+/**
+ * @brief Parameters of a training run
+ */
+struct TrainConfig {
+    qint64 learners = 200000;            ///< Simulated learners over the whole run
+    int questions = 50;                  ///< Questions asked per learner
+    int rounds = 4;                      ///< Times the shard tables are averaged
+    int shards = 64;                     ///< Independent tables trained per round
+    LearnerModel learner;                ///< How the simulated learners answer
+    quint64 seed = 1;                    ///< Seed of the whole run
+};
+
+/**
+ * @brief Trains one shard's copy of the table
+ * @param bank The question bank
+ * @param start Table the round starts from
+ * @param config Parameters of the run
+ * @param seed Seed of the shard
+ * @param learners Learners trained by the shard
+ * @return The trained copy
+ * @details Runs on a thread of the pool. Each learner starts from their true
+ *          skill, as if they had reported it in the new-user dialog, so every
+ *          skill state is trained.
+ */
+static QTable trainShard(const QuestionBank& bank, const QTable& start, const TrainConfig& config,
+                         quint64 seed, qint64 learners)
+{
+    QTable table = start;
+    SessionRng seeds(seed);
+    AdaptiveQuiz quiz(bank, table, State(), seeds.next());
+
+    for (qint64 l = 0; l < learners; ++l) {
+        Learner learner(seeds.next());
+        quiz.restart(learner.trueState(), seeds.next());
+        for (int q = 0; q < config.questions; ++q) {
+            int questionID = quiz.getNextAction();
+            bool correct = learner.answer(quiz.getQuestion(questionID), config.learner);
+            quiz.evaluateResponse(questionID, correct);
+        }
+    }
+    return table;
+}
+
+/**
+ * @brief Averages the shard tables into the table of the next round
+ * @param tables Tables trained from the same start; they share its slots
+ * @param result Receives the average; must have the same slots as the tables
+ * @return Mean absolute change of a value from the previous content of result
+ */
+static double averageTables(const std::vector<QTable>& tables, QTable& result)
+{
+    const int count = result.actionCount();
+    double change = 0.0;
+    for (int row = 0; row < QTable::STATE_COUNT; ++row) {
+        const State state = QTable::stateAt(row);
+        for (int slot = 0; slot < count; ++slot) {
+            double sum = 0.0;
+            for (const QTable& table : tables) {
+                sum += table.row(state)[slot];
+            }
+            const float average = static_cast<float>(sum / tables.size());
+            change += std::abs(average - result.row(state)[slot]);
+            result.setValue(state, result.questionIDAt(slot), average);
+        }
+    }
+    return count > 0 ? change / (double(QTable::STATE_COUNT) * count) : 0.0;
+}
+
+/**
+ * @brief Parses the command line into a configuration
+ * @param app The application holding the arguments
+ * @param config Receives the parsed values
+ * @param bankPath Receives the path of the question bank
+ * @param outputPath Receives the path of the table to write
+ * @param threads Receives the number of threads
+ * @return true if the arguments are valid
+ */
+static bool parseArguments(const QCoreApplication& app, TrainConfig& config, QString& bankPath,
+                           QString& outputPath, int& threads)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Trains the prior Q-table of new KeyQuest players on simulated learners.");
+    parser.addHelpOption();
+
+    QCommandLineOption learnersOption("learners", "Simulated learners over the whole run.", "count", QString::number(config.learners));
+    QCommandLineOption questionsOption("questions", "Questions asked per learner.", "count", QString::number(config.questions));
+    QCommandLineOption roundsOption("rounds", "Times the shard tables are averaged.", "count", QString::number(config.rounds));
+    QCommandLineOption shardsOption("shards", "Tables trained in parallel per round.", "count", QString::number(config.shards));
+    QCommandLineOption threadsOption("threads", "Number of threads, all cores by default.", "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption accuracyOption("accuracy", "Chance of a correct answer within the learner's skill.", "p", QString::number(config.learner.accuracy));
+    QCommandLineOption learnRateOption("learn-rate", "Chance that a correct stretch answer raises the skill.", "p", QString::number(config.learner.learnRate));
+    QCommandLineOption seedOption("seed", "Seed of the run.", "seed", QString::number(config.seed));
+    QCommandLineOption bankOption("bank", "Question bank JSON file.", "file", ":/resources/questionBank.json");
+    QCommandLineOption outputOption("output", "File the trained table is written to.", "file", "qtablePrior.kqt");
+    parser.addOptions({learnersOption, questionsOption, roundsOption, shardsOption, threadsOption,
+                       accuracyOption, learnRateOption, seedOption, bankOption, outputOption});
+    parser.process(app);
+
+    bool ok = true;
+    auto check = [&ok](bool parsed) { ok = ok && parsed; };
+    bool parsed = false;
+    config.learners = parser.value(learnersOption).toLongLong(&parsed); check(parsed && config.learners > 0);
+    config.questions = parser.value(questionsOption).toInt(&parsed); check(parsed && config.questions > 0);
+    config.rounds = parser.value(roundsOption).toInt(&parsed); check(parsed && config.rounds > 0);
+    config.shards = parser.value(shardsOption).toInt(&parsed); check(parsed && config.shards > 0);
+    threads = parser.value(threadsOption).toInt(&parsed); check(parsed && threads > 0);
+    config.learner.accuracy = parser.value(accuracyOption).toDouble(&parsed); check(parsed);
+    config.learner.learnRate = parser.value(learnRateOption).toDouble(&parsed); check(parsed);
+    config.seed = parser.value(seedOption).toULongLong(&parsed); check(parsed);
+
+    bankPath = parser.value(bankOption);
+    outputPath = parser.value(outputOption);
+    return ok;
+}
+
+/**
+ * @brief Entry point of the trainer
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return 0 on success, 1 on invalid arguments, an unreadable question bank or
+ *         an unwritable output file
+ */
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    TrainConfig config;
+    QString bankPath;
+    QString outputPath;
+    int threads = 1;
+    if (!parseArguments(app, config, bankPath, outputPath, threads)) {
+        out << "qtrainer: invalid arguments, see --help\n";
+        return 1;
+    }
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    QuestionBank bank;
+    if (!bank.loadFromFile(bankPath)) {
+        out << "qtrainer: could not load " << bankPath << "\n";
+        return 1;
+    }
+
+    // Every copy gets the slots of the whole bank up front, so they can be averaged slot by slot
+    QTable table;
+    std::vector<int> questionIDs;
+    questionIDs.reserve(bank.size());
+    for (const Question& question : bank.questions()) {
+        questionIDs.push_back(question.getQuestionID());
+    }
+    table.addActions(questionIDs);
+
+    out << "questions             " << bank.size() << "\n"
+        << "learners              " << config.learners << " in " << config.rounds << " rounds of "
+        << config.shards << " shards on " << threads << " threads\n"
+        << "\nround  seconds  mean change\n";
+
+    SessionRng seeds(config.seed);
+    const auto runStart = std::chrono::steady_clock::now();
+    for (int round = 0; round < config.rounds; ++round) {
+        // Seeds and learner counts are fixed before the shards run, in shard order
+        const qint64 roundLearners = config.learners / config.rounds + (round < config.learners % config.rounds ? 1 : 0);
+        std::vector<quint64> shardSeeds(config.shards);
+        std::vector<qint64> shardLearners(config.shards);
+        std::vector<int> shards(config.shards);
+        for (int s = 0; s < config.shards; ++s) {
+            shardSeeds[s] = seeds.next();
+            shardLearners[s] = roundLearners / config.shards + (s < roundLearners % config.shards ? 1 : 0);
+            shards[s] = s;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<QTable> trained = QtConcurrent::blockingMapped<std::vector<QTable>>(shards,
+            [&](int s) { return trainShard(bank, table, config, shardSeeds[s], shardLearners[s]); });
+        const double change = averageTables(trained, table);
+        const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        out << qSetFieldWidth(5) << (round + 1) << qSetFieldWidth(9) << QString::number(seconds.count(), 'f', 2)
+            << qSetFieldWidth(13) << QString::number(change, 'g', 4) << qSetFieldWidth(0) << "\n";
+        out.flush();
+    }
+    const std::chrono::duration<double> total = std::chrono::steady_clock::now() - runStart;
+
+    QFile file(outputPath);
+    const QByteArray data = table.toBinary();
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        out << "qtrainer: could not write " << outputPath << "\n";
+        return 1;
+    }
+
+    out << "\ntrained in            " << QString::number(total.count(), 'f', 1) << " s\n"
+        << "wrote                 " << outputPath << ", " << data.size() << " bytes\n";
+    return 0;
+}
@@ -0,0 +1,215 @@
+/**
+ * @file quizbench.cpp
+ * @brief Headless simulation and benchmark of the adaptive quiz engine
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file implements the quizbench console tool. It drives simulated
+ *          learners through AdaptiveQuiz::getNextAction() and
+ *          AdaptiveQuiz::evaluateResponse() without any UI, and reports the cost
+ *          of a decision together with how well the engine tracks the learners.
+ *
+ *          Example:
+ *              quizbench --learners 1000000 --questions 10 --model skill --accuracy 0.8
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include "adaptivequiz.h"
+#include "qtable.h"
+#include "questionbank.h"
+#include "runningstats.h"
+#include "sessionrng.h"
+#include "simlearner.h"
+
+/// Number of calls to operator new made by the process so far
+static std::atomic<quint64> allocationCount{0};
+
+/**
+ * @brief Counting replacement of the global allocation function
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory
+ * @details Qt containers allocate with malloc() directly and are not counted, so the
+ *          figure covers the standard containers used by the quiz engine.
+ */
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+/**
+ * @brief Replacement of the global deallocation function matching operator new
+ * @param memory Pointer returned by operator new
+ */
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+/**
+ * @brief Sized replacement of the global deallocation function
+ * @param memory Pointer returned by operator new
+ */
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+/**
+ * @brief Parameters of a simulation run
+ */
+struct BenchConfig {
+    qint64 learners = 10000;             ///< Number of simulated learners
+    int questions = 50;                  ///< Questions asked per learner
+    LearnerModel learner;                ///< How the simulated learners answer
+    bool carryTable = true;              ///< Whether each learner starts from the previous learner's Q-table
+    quint64 seed = 1;                    ///< Seed of the whole run
+};
+
+/**
+ * @brief Parses the command line into a configuration
+ * @param app The application holding the arguments
+ * @param config Receives the parsed values
+ * @param bankPath Receives the path of the question bank
+ * @return true if the arguments are valid
+ */
+static bool parseArguments(const QCoreApplication& app, BenchConfig& config, QString& bankPath)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulates learners against the KeyQuest adaptive quiz engine.");
+    parser.addHelpOption();
+
+    QCommandLineOption learnersOption("learners", "Number of simulated learners.", "count", QString::number(config.learners));
+    QCommandLineOption questionsOption("questions", "Questions asked per learner.", "count", QString::number(config.questions));
+    QCommandLineOption modelOption("model", "Answer model: fixed or skill.", "model", "skill");
+    QCommandLineOption accuracyOption("accuracy", "Chance of a correct answer within the learner's skill.", "p", QString::number(config.learner.accuracy));
+    QCommandLineOption learnRateOption("learn-rate", "Chance that a correct stretch answer raises the skill.", "p", QString::number(config.learner.learnRate));
+    QCommandLineOption freshTableOption("fresh-table", "Start every learner from an empty Q-table.");
+    QCommandLineOption seedOption("seed", "Seed of the run.", "seed", QString::number(config.seed));
+    QCommandLineOption bankOption("bank", "Question bank JSON file.", "file", ":/resources/questionBank.json");
+    parser.addOptions({learnersOption, questionsOption, modelOption, accuracyOption,
+                       learnRateOption, freshTableOption, seedOption, bankOption});
+    parser.process(app);
+
+    bool ok = true;
+    auto check = [&ok](bool parsed) { ok = ok && parsed; };
+    bool parsed = false;
+    config.learners = parser.value(learnersOption).toLongLong(&parsed); check(parsed && config.learners > 0);
+    config.questions = parser.value(questionsOption).toInt(&parsed); check(parsed && config.questions > 0);
+    config.learner.accuracy = parser.value(accuracyOption).toDouble(&parsed); check(parsed);
+    config.learner.learnRate = parser.value(learnRateOption).toDouble(&parsed); check(parsed);
+    config.seed = parser.value(seedOption).toULongLong(&parsed); check(parsed);
+    config.carryTable = !parser.isSet(freshTableOption);
+
+    QString model = parser.value(modelOption);
+    if (model == "fixed") {
+        config.learner.model = AnswerModel::Fixed;
+    } else if (model == "skill") {
+        config.learner.model = AnswerModel::Skill;
+    } else {
+        ok = false;
+    }
+
+    bankPath = parser.value(bankOption);
+    return ok;
+}
+
+/**
+ * @brief Entry point of the benchmark
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return 0 on success, 1 on invalid arguments or an unreadable question bank
+ */
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    BenchConfig config;
+    QString bankPath;
+    if (!parseArguments(app, config, bankPath)) {
+        out << "quizbench: invalid arguments, see --help\n";
+        return 1;
+    }
+
+    QuestionBank bank;
+    if (!bank.loadFromFile(bankPath)) {
+        out << "quizbench: could not load " << bankPath << "\n";
+        return 1;
+    }
+
+    SessionRng seeds(config.seed);
+    QTable table;
+    QTable freshTable;
+    std::vector<qint64> correctAt(config.questions, 0);
+    std::vector<qint64> levelSumAt(config.questions, 0);
+    RunningStats levelError;
+    qint64 decisions = 0;
+    std::chrono::nanoseconds decisionTime{0};
+    quint64 decisionAllocations = 0;
+
+    for (qint64 l = 0; l < config.learners; ++l) {
+        Learner learner(seeds.next());
+        if (!config.carryTable) {
+            freshTable = QTable();
+        }
+        AdaptiveQuiz quiz(bank, config.carryTable ? table : freshTable, State(), seeds.next());
+
+        const quint64 allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        for (int q = 0; q < config.questions; ++q) {
+            int questionID = quiz.getNextAction();
+            const Question& question = quiz.getQuestion(questionID);
+            bool correct = learner.answer(question, config.learner);
+            quiz.evaluateResponse(questionID, correct);
+
+            State estimate = quiz.getCurrentState();
+            correctAt[q] += correct ? 1 : 0;
+            levelSumAt[q] += estimate.notes + estimate.chords + estimate.scales;
+        }
+        decisionTime += std::chrono::steady_clock::now() - start;
+        decisionAllocations += allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        decisions += config.questions;
+
+        if (config.learner.model == AnswerModel::Skill) {
+            State estimate = quiz.getCurrentState();
+            levelError.add((std::abs(estimate.notes - learner.skill[0])
+                            + std::abs(estimate.chords - learner.skill[1])
+                            + std::abs(estimate.scales - learner.skill[2])) / 3.0);
+        }
+    }
+
+    out << "learners              " << config.learners << "\n"
+        << "questions/learner     " << config.questions << "\n"
+        << "decisions             " << decisions << "\n"
+        << "ns/decision           " << double(decisionTime.count()) / decisions << "\n"
+        << "allocations/decision  " << double(decisionAllocations) / decisions << "\n"
+        << "question record       " << sizeof(Question) << " bytes x " << bank.size() << "\n"
+        << "Q-table               " << table.memoryUsage() << " bytes, "
+        << table.actionCount() << " actions x " << QTable::STATE_COUNT << " states\n";
+
+    // Learning curve: accuracy and mean estimated level over the course of a session
+    out << "\nquestion  accuracy  mean level\n";
+    const int step = qMax(1, config.questions / 10);
+    for (int q = 0; q < config.questions; q += step) {
+        out << qSetFieldWidth(8) << (q + 1) << qSetFieldWidth(0) << "  "
+            << qSetFieldWidth(7) << QString::number(100.0 * correctAt[q] / config.learners, 'f', 1)
+            << qSetFieldWidth(0) << "%  "
+            << QString::number(double(levelSumAt[q]) / (3.0 * config.learners), 'f', 3) << "\n";
+    }
+
+    if (config.learner.model == AnswerModel::Skill) {
+        out << "\nfinal level error     " << QString::number(levelError.mean(), 'f', 3)
+            << " (stddev " << QString::number(std::sqrt(levelError.variance()), 'f', 3) << ")\n";
+    }
+    return 0;
+}
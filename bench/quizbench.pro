@@ -0,0 +1,51 @@
+# Headless simulation and benchmark of the adaptive quiz engine.
+# Build from the repository root with "qmake bench/quizbench.pro" and "make",
+# then run "./quizbench --help". It links only the quiz engine sources and needs
+# neither a display nor FluidSynth.
+QT       = core
+CONFIG  += console c++17 release
+CONFIG  -= app_bundle
+TARGET   = quizbench
+
+KEYQUEST_ROOT = $$PWD/..
+INCLUDEPATH += $$KEYQUEST_ROOT
+
+# Same optimization profiles as the application (CONFIG+=performance, pgo_*)
+include($$KEYQUEST_ROOT/buildprofile.pri)
+
+SOURCES += \
+    quizbench.cpp \
+    $$KEYQUEST_ROOT/adaptivequiz.cpp \
+    $$KEYQUEST_ROOT/gamesession.cpp \
+    $$KEYQUEST_ROOT/noteset.cpp \
+    $$KEYQUEST_ROOT/notetable.cpp \
+    $$KEYQUEST_ROOT/qtable.cpp \
+    $$KEYQUEST_ROOT/question.cpp \
+    $$KEYQUEST_ROOT/questionbank.cpp \
+    $$KEYQUEST_ROOT/questionloader.cpp \
+    $$KEYQUEST_ROOT/reviewschedule.cpp \
+    $$KEYQUEST_ROOT/runningstats.cpp \
+    $$KEYQUEST_ROOT/scoringsystem.cpp \
+    $$KEYQUEST_ROOT/sessionrng.cpp \
+    $$KEYQUEST_ROOT/stringpool.cpp
+
+HEADERS += \
+    simlearner.h \
+    $$KEYQUEST_ROOT/adaptivequiz.h \
+    $$KEYQUEST_ROOT/gamesession.h \
+    $$KEYQUEST_ROOT/noteset.h \
+    $$KEYQUEST_ROOT/notetable.h \
+    $$KEYQUEST_ROOT/qtable.h \
+    $$KEYQUEST_ROOT/question.h \
+    $$KEYQUEST_ROOT/questionbank.h \
+    $$KEYQUEST_ROOT/questionloader.h \
+    $$KEYQUEST_ROOT/quizreport.h \
+    $$KEYQUEST_ROOT/reviewschedule.h \
+    $$KEYQUEST_ROOT/runningstats.h \
+    $$KEYQUEST_ROOT/scoringsystem.h \
+    $$KEYQUEST_ROOT/sessionrng.h \
+    $$KEYQUEST_ROOT/state.h \
+    $$KEYQUEST_ROOT/stringpool.h
+
+# The bundled question bank is the default input (--bank overrides it)
+RESOURCES += $$KEYQUEST_ROOT/data.qrc
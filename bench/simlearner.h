@@ -0,0 +1,103 @@
+/**
+ * @file simlearner.h
+ * @brief Simulated learners of the adaptive quiz engine
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file defines the learner model shared by the quizbench benchmark
+ *          and the qtrainer tool: a learner with a hidden skill per domain who
+ *          answers questions with a chance that depends on their difficulty.
+ */
+
+#ifndef SIMLEARNER_H
+#define SIMLEARNER_H
+
+#include "question.h"
+#include "sessionrng.h"
+#include "state.h"
+
+/**
+ * @brief How a simulated learner answers
+ */
+enum class AnswerModel {
+    Fixed,  ///< Every question is answered correctly with the same probability
+    Skill   ///< The chance depends on the question's difficulty and the learner's hidden skill
+};
+
+/**
+ * @brief Parameters of the simulated learners
+ */
+struct LearnerModel {
+    AnswerModel model = AnswerModel::Skill;  ///< Answer model of the learners
+    double accuracy = 0.8;               ///< Chance of a correct answer at or below the learner's skill
+    double learnRate = 0.05;             ///< Chance that a correct stretch answer raises the hidden skill
+};
+
+/**
+ * @brief Maps a topic to the skill domain AdaptiveQuiz assigns it
+ * @param topicID The topic ID
+ * @return 0 for notes, 1 for chords, 2 for scales
+ */
+inline int domainOf(int topicID)
+{
+    if (topicID == 101) return 0;
+    if (topicID >= 102 && topicID <= 103) return 1;
+    return 2;
+}
+
+/**
+ * @brief A simulated learner with a hidden true skill per domain
+ */
+struct Learner {
+    int skill[3];      ///< True skill level of notes, chords and scales (0-2)
+    SessionRng rng;    ///< Generator of the learner's answers
+
+    /**
+     * @brief Creates a learner with a random true skill
+     * @param seed Seed of the learner's generator
+     */
+    explicit Learner(quint64 seed)
+        : rng(seed)
+    {
+        for (int& level : skill) {
+            level = static_cast<int>(rng.bounded(3));
+        }
+    }
+
+    /**
+     * @brief Gets the true skill as a skill state
+     * @return The state the learner would report in the new-user dialog
+     */
+    State trueState() const
+    {
+        State state;
+        state.notes = skill[0];
+        state.chords = skill[1];
+        state.scales = skill[2];
+        return state;
+    }
+
+    /**
+     * @brief Answers a question
+     * @param question The question asked
+     * @param model The answer model and its parameters
+     * @return true if the learner answers correctly
+     */
+    bool answer(const Question& question, const LearnerModel& model)
+    {
+        if (model.model == AnswerModel::Fixed) {
+            return rng.uniform() < model.accuracy;
+        }
+
+        int& level = skill[domainOf(question.getTopicID())];
+        int gap = question.getDifficulty() - level;
+        double chance = gap <= 0 ? model.accuracy : gap == 1 ? model.accuracy * 0.35 : 0.1;
+        bool correct = rng.uniform() < chance;
+
+        // Succeeding at the edge of one's skill occasionally moves the edge
+        if (correct && gap >= 0 && level < 2 && rng.uniform() < model.learnRate) {
+            ++level;
+        }
+        return correct;
+    }
+};
+
+#endif // SIMLEARNER_H
@@ -0,0 +1,56 @@
+# Release build profiles, shared by KeyQuest.pro, bench/quizbench.pro and tests/bench/microbench.pro.
+#
+#   qmake                              size-optimized (-Os), for constrained devices
+#   qmake CONFIG+=performance          -O3 with link-time optimization, for desktops
+#   qmake CONFIG+=performance KEYQUEST_MARCH=x86-64-v3
+#                                      additionally targets a CPU tier (x86-64-v2,
+#                                      x86-64-v3, x86-64-v4 or native); the binary
+#                                      then only runs on CPUs of that tier or newer
+#   qmake CONFIG+=pgo_generate         instruments the build for profiling (clang)
+#   qmake CONFIG+=pgo_use KEYQUEST_PGO_PROFILE=<file.profdata>
+#                                      optimizes with a merged profile (clang)
+#
+# tools/pgo_build.py runs the two profile-guided stages: it trains an instrumented
+# quizbench and builds KeyQuest with the resulting profile.
+
+CONFIG(release, debug|release) {
+    QMAKE_CFLAGS_RELEASE -= -g
+    QMAKE_CXXFLAGS_RELEASE -= -g -O1 -O2 -O3 -Os
+
+    gcc|clang {
+        performance {
+            QMAKE_CFLAGS_RELEASE += -O3
+            QMAKE_CXXFLAGS_RELEASE += -O3
+            !isEmpty(KEYQUEST_MARCH) {
+                QMAKE_CFLAGS_RELEASE += -march=$$KEYQUEST_MARCH
+                QMAKE_CXXFLAGS_RELEASE += -march=$$KEYQUEST_MARCH
+            }
+        } else {
+            QMAKE_CXXFLAGS_RELEASE += -Os
+        }
+        !macx: QMAKE_LFLAGS_RELEASE += -Wl,-O1
+    }
+    msvc {
+        performance: QMAKE_CXXFLAGS_RELEASE += -O2
+        else: QMAKE_CXXFLAGS_RELEASE += -O1
+    }
+
+    # Link-time optimization; qmake picks the matching archiver and linker flags
+    performance: CONFIG += ltcg
+}
+
+# Profile-guided optimization. Clang profiles match functions by name, so a
+# profile recorded by quizbench applies to the quiz engine inside KeyQuest.
+pgo_generate|pgo_use {
+    !clang: error("Profile-guided builds need clang, e.g. \"qmake -spec linux-clang\"")
+}
+pgo_generate {
+    QMAKE_CXXFLAGS += -fprofile-instr-generate
+    QMAKE_LFLAGS += -fprofile-instr-generate
+}
+pgo_use {
+    !exists($$KEYQUEST_PGO_PROFILE): error("CONFIG+=pgo_use needs KEYQUEST_PGO_PROFILE=<file.profdata>")
+    # Code the training run never reached is optimized as usual
+    QMAKE_CXXFLAGS += -fprofile-instr-use=$$KEYQUEST_PGO_PROFILE \
+        -Wno-profile-instr-unprofiled -Wno-profile-instr-out-of-date
+}
@@ -0,0 +1,132 @@
+/**
+ * @file chordcapture.cpp
+ * @brief Implementation of the ChordCapture class
+ * @author Alan Cruz
+ * @details This file implements the onset-window chord grouping shared by the lesson,
+ *          quiz and multiplayer widgets.
+ */
+
+#include "chordcapture.h"
+#include "trace.h"
+
+/**
+ * @brief Constructs a new ChordCapture
+ * @param parent The parent QObject
+ * @details Starts the monotonic clock and sets up the single-shot hold and release
+ *          timers, both of which submit the collected chord.
+ */
+ChordCapture::ChordCapture(QObject* parent)
+    : QObject(parent)
+{
+    m_clock.start();
+
+    m_holdTimer.setSingleShot(true);
+    connect(&m_holdTimer, &QTimer::timeout, this, &ChordCapture::submit);
+
+    m_releaseTimer.setSingleShot(true);
+    connect(&m_releaseTimer, &QTimer::timeout, this, &ChordCapture::submit);
+}
+
+/**
+ * @brief Drops the notes collected so far
+ * @details Keys that are still held stay held, so their release does not
+ *          submit anything.
+ */
+void ChordCapture::clear()
+{
+    m_holdTimer.stop();
+    m_releaseTimer.stop();
+    m_chord.clear();
+    m_noteCount = 0;
+}
+
+/**
+ * @brief Records a key press
+ * @param note The MIDI note
+ * @details The first onset of a chord starts its onset window. Reaching the expected
+ *          note count submits the chord straight away; otherwise the hold timer is
+ *          restarted.
+ */
+void ChordCapture::noteOn(int note)
+{
+    KEYQUEST_TRACE_SCOPE("ChordCapture::noteOn");
+    if (note < 0 || note >= int(m_held.size())) {
+        return;
+    }
+
+    const qint64 time = now();
+    m_held.set(note);
+
+    // A finger landing just after the chord was submitted still belongs to it
+    if (m_submitted && time - m_firstOnset <= m_onsetWindowMs) {
+        return;
+    }
+
+    if (m_chord.isEmpty()) {
+        m_firstOnset = time;
+        m_submitted = false;
+    }
+
+    if (!m_chord.containsMidiNote(note)) {
+        m_chord.addMidiNote(note);
+        ++m_noteCount;
+    }
+    m_releaseTimer.stop();
+
+    if (m_expectedCount > 0 && m_noteCount >= m_expectedCount) {
+        submit();
+        return;
+    }
+
+    m_holdTimer.start(m_holdTimeoutMs);
+}
+
+/**
+ * @brief Records a key release
+ * @param note The MIDI note
+ * @details Once every key is up the chord is submitted, but not before its onset
+ *          window has passed so that the remaining notes of a rolled chord can
+ *          still arrive.
+ */
+void ChordCapture::noteOff(int note)
+{
+    if (note < 0 || note >= int(m_held.size())) {
+        return;
+    }
+
+    m_held.reset(note);
+    if (m_held.any() || m_chord.isEmpty()) {
+        return;
+    }
+
+    const qint64 elapsed = now() - m_firstOnset;
+    if (elapsed < m_onsetWindowMs) {
+        m_releaseTimer.start(int(m_onsetWindowMs - elapsed));
+        return;
+    }
+
+    submit();
+}
+
+/**
+ * @brief Emits the collected chord and starts a new one
+ * @details The chord is cleared before the signal is emitted, so a receiver that
+ *          moves on to the next question starts from an empty chord.
+ */
+void ChordCapture::submit()
+{
+    KEYQUEST_TRACE_SCOPE("ChordCapture::submit");
+    m_holdTimer.stop();
+    m_releaseTimer.stop();
+
+    if (m_chord.isEmpty()) {
+        return;
+    }
+
+    const NoteSet chord = m_chord;
+    m_chord.clear();
+    m_noteCount = 0;
+    m_submitted = true;
+
+    emit chordCaptured(chord);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file chordcapture.h
+ * @brief Header file for the ChordCapture class
+ * @author Alan Cruz
+ * @details This file defines ChordCapture, which turns the key presses and releases
+ *          of the piano into submitted chords for the lesson, quiz and multiplayer
+ *          widgets.
+ */
+
+#ifndef CHORDCAPTURE_H
+#define CHORDCAPTURE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <bitset>
+#include "noteset.h"
+
+/**
+ * @brief Groups note-on/note-off events into chords
+ * @details Every event is timestamped with a monotonic clock. A chord starts with its
+ *          first onset and is submitted as soon as one of these happens:
+ *          - the expected number of distinct notes has been played
+ *          - every key has been released, once the onset window since the first
+ *            onset has passed (a key tapped and released before the other fingers
+ *            land does not cut the chord short)
+ *          - no new onset arrived for the hold timeout while keys are still held
+ *
+ *          Onsets within the onset window of a submitted chord's first onset still
+ *          belong to that chord and are ignored, so a finger landing a few
+ *          milliseconds late does not start a stray chord of its own.
+ */
+class ChordCapture : public QObject
+{
+    Q_OBJECT
+public:
+    static const int DEFAULT_ONSET_WINDOW_MS = 60;    ///< Onsets this close together form one chord
+    static const int DEFAULT_HOLD_TIMEOUT_MS = 1000;  ///< Submit held notes after this long without an onset
+
+    /**
+     * @brief Constructs a new ChordCapture
+     * @param parent The parent QObject
+     */
+    explicit ChordCapture(QObject* parent = nullptr);
+
+    /**
+     * @brief Sets the onset window
+     * @param ms Onsets within this many milliseconds of the first one form one chord
+     */
+    void setOnsetWindow(int ms) { m_onsetWindowMs = ms; }
+
+    /**
+     * @brief Sets how long held notes wait for another onset
+     * @param ms Milliseconds after the last onset
+     */
+    void setHoldTimeout(int ms) { m_holdTimeoutMs = ms; }
+
+    /**
+     * @brief Sets the number of notes the current question expects
+     * @param count Distinct notes that submit the chord right away; 0 if unknown
+     */
+    void setExpectedNoteCount(int count) { m_expectedCount = count; }
+
+    /**
+     * @brief Drops the notes collected so far
+     * @details Keys that are still held stay held, so their release does not
+     *          submit anything.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the notes collected so far
+     * @return The notes of the chord that has not been submitted yet
+     */
+    const NoteSet& pendingChord() const { return m_chord; }
+
+public slots:
+    /**
+     * @brief Records a key press
+     * @param note The MIDI note
+     */
+    void noteOn(int note);
+
+    /**
+     * @brief Records a key release
+     * @param note The MIDI note
+     */
+    void noteOff(int note);
+
+signals:
+    /**
+     * @brief Emitted when a chord is complete
+     * @param chord The notes of the chord
+     */
+    void chordCaptured(const NoteSet& chord);
+
+private:
+    /**
+     * @brief Emits the collected chord and starts a new one
+     */
+    void submit();
+
+    /**
+     * @brief Gets the time since construction on the monotonic clock
+     * @return Milliseconds
+     */
+    qint64 now() const { return m_clock.elapsed(); }
+
+    QElapsedTimer m_clock;           ///< Monotonic clock for the onset timestamps
+    QTimer m_holdTimer;              ///< Submits held notes after the hold timeout
+    QTimer m_releaseTimer;           ///< Submits a released chord once the onset window passed
+    NoteSet m_chord;                 ///< Notes of the current chord
+    int m_noteCount = 0;             ///< Distinct MIDI notes in m_chord
+    std::bitset<128> m_held;         ///< Keys currently held down
+    qint64 m_firstOnset = -1;        ///< Time of the current or last chord's first onset
+    bool m_submitted = false;        ///< Whether the chord starting at m_firstOnset was submitted
+    int m_expectedCount = 0;         ///< Notes that complete a chord, 0 if unknown
+    int m_onsetWindowMs = DEFAULT_ONSET_WINDOW_MS;  ///< See setOnsetWindow()
+    int m_holdTimeoutMs = DEFAULT_HOLD_TIMEOUT_MS;  ///< See setHoldTimeout()
+};
+
+#endif // CHORDCAPTURE_H
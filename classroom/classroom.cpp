@@ -0,0 +1,336 @@
+/**
+ * @file classroom.cpp
+ * @brief Class-wide summary of the lesson and quiz results of many players
+ * @author Alan Cruz
+ * @details This file implements the classroom console tool. It finds the
+ *          profile shards of every player under the given folders, summarizes
+ *          each one on a thread of the global thread pool and merges the partial
+ *          summaries into per-topic and per-question results of the whole class.
+ *
+ *          Example:
+ *              classroom --threads 32 /srv/lab/students
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <vector>
+#include "question.h"
+#include "questionbank.h"
+#include "quizhistory.h"
+#include "runningstats.h"
+
+/**
+ * @brief Quiz results of one question over the class
+ */
+struct QuestionSummary {
+    qint64 asked = 0;     ///< Times it was answered
+    qint64 correct = 0;   ///< Times it was answered correctly
+    int students = 0;     ///< Players who answered it at least once
+};
+
+/**
+ * @brief Lesson results of one topic over the class
+ */
+struct TopicSummary {
+    TopicStatistics lessons;  ///< Every completed lesson of every player
+    int students = 0;         ///< Players who completed a lesson of the topic
+};
+
+/**
+ * @brief Results of a group of players, from one player up to the whole class
+ * @details Summaries of disjoint groups are merged with merge(); the result does
+ *          not depend on the order they are merged in.
+ */
+struct ClassSummary {
+    int students = 0;                              ///< Players with any results
+    int unreadable = 0;                            ///< Profiles whose files could not be read
+    std::map<int, TopicSummary> topics;            ///< Lesson results by topic ID
+    std::map<int, QuestionSummary> questions;      ///< Quiz results by question ID
+    RunningStats quizAccuracy;                     ///< Accuracy of every finished quiz
+    RunningStats studentAccuracy;                  ///< Quiz answer accuracy of every player who answered one
+    qint64 answers = 0;                            ///< Quiz answers of all players
+
+    /**
+     * @brief Adds the results of another group of players
+     * @param other The summary to add
+     */
+    void merge(const ClassSummary& other)
+    {
+        students += other.students;
+        unreadable += other.unreadable;
+        for (const auto& topic : other.topics) {
+            TopicSummary& summary = topics[topic.first];
+            summary.lessons.merge(topic.second.lessons);
+            summary.students += topic.second.students;
+        }
+        for (const auto& question : other.questions) {
+            QuestionSummary& summary = questions[question.first];
+            summary.asked += question.second.asked;
+            summary.correct += question.second.correct;
+            summary.students += question.second.students;
+        }
+        quizAccuracy.merge(other.quizAccuracy);
+        studentAccuracy.merge(other.studentAccuracy);
+        answers += other.answers;
+    }
+};
+
+/**
+ * @brief Reads a JSON object through a memory map of its file
+ * @param filePath The file
+ * @param object Receives the object
+ * @return true if the file holds a JSON object
+ * @details The parser reads the mapped pages directly, so the file is not copied
+ *          into a buffer of its own first.
+ */
+static bool readMappedObject(const QString& filePath, QJsonObject& object)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 size = file.size();
+    uchar* data = size > 0 ? file.map(0, size) : nullptr;
+    QJsonDocument doc = data
+        ? QJsonDocument::fromJson(QByteArray::fromRawData(reinterpret_cast<const char*>(data), size))
+        : QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) {
+        return false;
+    }
+    object = doc.object();
+    return true;
+}
+
+/**
+ * @brief Reads the lesson statistics of a profile
+ * @param lessons The "lessons" section of profile.json or of an older data.json
+ * @param summary Receives the topics of the player
+ * @details Statistics still in the old format of one array per value are read too.
+ */
+static void summarizeLessons(const QJsonObject& lessons, ClassSummary& summary)
+{
+    const QJsonObject topics = lessons["topics"].toObject();
+    for (auto it = topics.begin(); it != topics.end(); ++it) {
+        const QJsonObject stats = it.value().toObject()["statistics"].toObject();
+        TopicStatistics topicStats;
+        if (stats["scores"].isArray()) {
+            const QJsonArray scores = stats["scores"].toArray();
+            const QJsonArray accuracies = stats["accuracy"].toArray();
+            const QJsonArray attempts = stats["attempts"].toArray();
+            for (qsizetype i = 0; i < scores.size(); ++i) {
+                topicStats.add(scores[i].toInt(), accuracies[i].toDouble(), attempts[i].toInt());
+            }
+        } else {
+            topicStats = TopicStatistics::fromJson(stats);
+        }
+
+        if (topicStats.scores.count() > 0) {
+            TopicSummary& topic = summary.topics[it.key().toInt()];
+            topic.lessons = topicStats;
+            topic.students = 1;
+        }
+    }
+}
+
+/**
+ * @brief Reads the quiz history of a profile
+ * @param filePath Path of its quiz_history.kqr
+ * @param summary Receives the quizzes of the player
+ * @return false if the file exists but is not a quiz history
+ */
+static bool summarizeQuizzes(const QString& filePath, ClassSummary& summary)
+{
+    QuizHistory::Reader reader(filePath);
+    if (!reader.isValid()) {
+        return !QFileInfo::exists(filePath);
+    }
+
+    qint64 correct = 0;
+    QuizReport session;
+    while (reader.nextSession(session)) {
+        for (const QuizReport::Entry& entry : session.getHistory()) {
+            QuestionSummary& question = summary.questions[entry.questionID];
+            ++question.asked;
+            question.correct += entry.correct ? 1 : 0;
+            question.students = 1;
+            correct += entry.correct ? 1 : 0;
+            ++summary.answers;
+        }
+        if (session.finished) {
+            summary.quizAccuracy.add(session.getAccuracy());
+        }
+    }
+
+    if (summary.answers > 0) {
+        summary.studentAccuracy.add(100.0 * correct / summary.answers);
+    }
+    return true;
+}
+
+/**
+ * @brief Summarizes the results of one player
+ * @param profileDir Folder of the player's profile shard
+ * @return The player's summary; players without results count as no student
+ * @details Runs on a thread of the pool; it only reads the files of its folder.
+ */
+static ClassSummary summarizeStudent(const QString& profileDir)
+{
+    ClassSummary summary;
+    const QDir dir(profileDir);
+    bool readable = true;
+
+    // profile.json is the shard format; a data.json of an unsharded install holds the same section
+    const QString profileFile = dir.exists("profile.json") ? dir.filePath("profile.json") : dir.filePath("data.json");
+    if (QFileInfo::exists(profileFile)) {
+        QJsonObject profile;
+        if (readMappedObject(profileFile, profile)) {
+            summarizeLessons(profile["lessons"].toObject(), summary);
+        } else {
+            readable = false;
+        }
+    }
+    readable = summarizeQuizzes(dir.filePath("quiz_history.kqr"), summary) && readable;
+
+    summary.unreadable = readable ? 0 : 1;
+    summary.students = (!summary.topics.empty() || summary.answers > 0) ? 1 : 0;
+    return summary;
+}
+
+/**
+ * @brief Merges the summary of one player into the class summary
+ * @param result The class summary built so far
+ * @param partial The summary of a player
+ */
+static void mergeSummary(ClassSummary& result, const ClassSummary& partial)
+{
+    result.merge(partial);
+}
+
+/**
+ * @brief Finds the profile folders under the given paths
+ * @param paths Folders to search and files of profiles
+ * @return Every folder that holds a profile.json, data.json or quiz_history.kqr
+ */
+static QStringList findProfiles(const QStringList& paths)
+{
+    const QStringList names = {"profile.json", "data.json", "quiz_history.kqr"};
+    std::set<QString> folders;
+    for (const QString& path : paths) {
+        const QFileInfo info(path);
+        if (info.isFile()) {
+            folders.insert(info.absolutePath());
+            continue;
+        }
+        QDirIterator it(path, names, QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            folders.insert(QFileInfo(it.next()).absolutePath());
+        }
+    }
+    return QStringList(folders.begin(), folders.end());
+}
+
+/**
+ * @brief Entry point of the classroom tool
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return 0 on success, 1 on invalid arguments
+ */
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Summarizes the KeyQuest lesson and quiz results of a class.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("paths", "Folders holding the players' profiles, e.g. copies of their KeyQuest data folders.", "paths...");
+    QCommandLineOption threadsOption("threads", "Number of threads, all cores by default.", "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption questionsOption("questions", "Number of questions listed, hardest first; 0 lists all.", "count", "20");
+    QCommandLineOption bankOption("bank", "Question bank JSON file the question titles are read from.", "file", ":/resources/questionBank.json");
+    parser.addOptions({threadsOption, questionsOption, bankOption});
+    parser.process(app);
+
+    bool threadsOk = false;
+    bool questionsOk = false;
+    const int threads = parser.value(threadsOption).toInt(&threadsOk);
+    const int listed = parser.value(questionsOption).toInt(&questionsOk);
+    if (parser.positionalArguments().isEmpty() || !threadsOk || threads < 1 || !questionsOk || listed < 0) {
+        out << "classroom: invalid arguments, see --help\n";
+        return 1;
+    }
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    QElapsedTimer timer;
+    timer.start();
+    const QStringList profiles = findProfiles(parser.positionalArguments());
+    const ClassSummary summary = QtConcurrent::mappedReduced<ClassSummary>(
+        profiles, summarizeStudent, mergeSummary, QtConcurrent::UnorderedReduce).result();
+    const qint64 elapsed = timer.elapsed();
+
+    // Titles are optional; the summary stands without them
+    QuestionBank bank;
+    if (!bank.loadFromFile(parser.value(bankOption))) {
+        out << "classroom: could not load " << parser.value(bankOption) << ", questions are listed by ID\n";
+    }
+
+    out << "students              " << summary.students << " of " << profiles.size() << " profiles\n"
+        << "unreadable profiles   " << summary.unreadable << "\n"
+        << "read in               " << elapsed << " ms on " << threads << " threads\n";
+
+    out << "\ntopic  students  lessons  mean score  mean accuracy  mean attempts  name\n";
+    for (const auto& topic : summary.topics) {
+        const TopicStatistics& lessons = topic.second.lessons;
+        const QuestionBank::QuestionRange questions = bank.topicQuestions(topic.first);
+        out << qSetFieldWidth(5) << topic.first
+            << qSetFieldWidth(10) << topic.second.students
+            << qSetFieldWidth(9) << lessons.scores.count()
+            << qSetFieldWidth(12) << QString::number(lessons.scores.mean(), 'f', 1)
+            << qSetFieldWidth(14) << QString::number(lessons.accuracy.mean(), 'f', 1) + "%"
+            << qSetFieldWidth(15) << QString::number(lessons.attempts.mean(), 'f', 1)
+            << qSetFieldWidth(0) << "  " << (questions.isEmpty() ? QString() : questions.first->getTopicName()) << "\n";
+    }
+
+    out << "\nquizzes finished      " << summary.quizAccuracy.count()
+        << ", mean accuracy " << QString::number(summary.quizAccuracy.mean(), 'f', 1) << "%\n"
+        << "quiz answers          " << summary.answers << " by " << summary.studentAccuracy.count() << " students"
+        << ", accuracy per student " << QString::number(summary.studentAccuracy.mean(), 'f', 1) << "%"
+        << " (stddev " << QString::number(std::sqrt(summary.studentAccuracy.variance()), 'f', 1) << ")\n";
+
+    // Hardest questions first: lowest share of correct answers
+    std::vector<std::pair<int, QuestionSummary>> questions(summary.questions.begin(), summary.questions.end());
+    std::stable_sort(questions.begin(), questions.end(), [](const auto& a, const auto& b) {
+        return a.second.correct * b.second.asked < b.second.correct * a.second.asked;
+    });
+    if (listed > 0 && questions.size() > std::size_t(listed)) {
+        questions.resize(listed);
+    }
+
+    out << "\nquestion  topic  students  answers  correct  title\n";
+    for (const auto& entry : questions) {
+        const Question* question = bank.question(entry.first);
+        const QuestionSummary& stats = entry.second;
+        out << qSetFieldWidth(8) << entry.first
+            << qSetFieldWidth(7) << (question ? question->getTopicID() : 0)
+            << qSetFieldWidth(10) << stats.students
+            << qSetFieldWidth(9) << stats.asked
+            << qSetFieldWidth(8) << QString::number(100.0 * stats.correct / stats.asked, 'f', 1) + "%"
+            << qSetFieldWidth(0) << "  " << (question ? question->getTitle() : QString()) << "\n";
+    }
+    return 0;
+}
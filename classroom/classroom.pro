@@ -0,0 +1,42 @@
+# Class-wide summary of the lesson and quiz results of many players.
+# Build from the repository root with "qmake classroom/classroom.pro" and "make",
+# then run "./classroom --help". It reads copies of the players' data folders and
+# needs neither a display nor FluidSynth.
+QT       = core concurrent
+CONFIG  += console c++17 release
+CONFIG  -= app_bundle
+TARGET   = classroom
+
+KEYQUEST_ROOT = $$PWD/..
+INCLUDEPATH += $$KEYQUEST_ROOT
+
+# Same optimization profiles as the application (CONFIG+=performance, pgo_*)
+include($$KEYQUEST_ROOT/buildprofile.pri)
+
+SOURCES += \
+    classroom.cpp \
+    $$KEYQUEST_ROOT/noteset.cpp \
+    $$KEYQUEST_ROOT/notetable.cpp \
+    $$KEYQUEST_ROOT/qtable.cpp \
+    $$KEYQUEST_ROOT/question.cpp \
+    $$KEYQUEST_ROOT/questionbank.cpp \
+    $$KEYQUEST_ROOT/questionloader.cpp \
+    $$KEYQUEST_ROOT/quizhistory.cpp \
+    $$KEYQUEST_ROOT/runningstats.cpp \
+    $$KEYQUEST_ROOT/stringpool.cpp
+
+HEADERS += \
+    $$KEYQUEST_ROOT/noteset.h \
+    $$KEYQUEST_ROOT/notetable.h \
+    $$KEYQUEST_ROOT/qtable.h \
+    $$KEYQUEST_ROOT/question.h \
+    $$KEYQUEST_ROOT/questionbank.h \
+    $$KEYQUEST_ROOT/questionloader.h \
+    $$KEYQUEST_ROOT/quizhistory.h \
+    $$KEYQUEST_ROOT/quizreport.h \
+    $$KEYQUEST_ROOT/runningstats.h \
+    $$KEYQUEST_ROOT/state.h \
+    $$KEYQUEST_ROOT/stringpool.h
+
+# The bundled question bank names the questions (--bank overrides it)
+RESOURCES += $$KEYQUEST_ROOT/data.qrc
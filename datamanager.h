@@ -4,8 +4,8 @@
  * @author Alan Cruz, Sarah Laharpour
  * @details This file defines the DataManager class which serves as a centralized
  *          interface for persistent data operations in the KeyQuest application.
- *          It provides functionality for loading and saving Q-tables, user states,
- *          and quiz reports, delegating to the LoadDataManager for consistent
+ *          It provides functionality for loading and saving Q-tables and user states,
+ *          and for reading quiz reports back, delegating to the LoadDataManager for consistent
  *          data storage in the application's central data file.
  */
 
@@ -17,6 +17,7 @@
 #include <QJsonArray>
 #include <QString>
 #include <QFile>
+#include "qtable.h"
 #include "question.h"
 #include "state.h"
 #include "quizreport.h"
@@ -41,30 +42,30 @@ class DataManager {
 public:
     /**
      * @brief Load the user's Q-table for adaptive quiz
-     * @param filename Kept for API compatibility, but always uses data.json
-     * @return The Q-table as a map of States to maps of action IDs and Q-values
+     * @param filename Kept for API compatibility, but always uses the active profile
+     * @return The Q-table of States and action IDs to Q-values
      * @details Leverages LoadDataManager to retrieve the Q-table from the central
      *          data store, ensuring consistent data access across the application.
      *          The returned Q-table maps user skill states to question IDs and
      *          their corresponding Q-values, which guide question selection in the
      *          adaptive quiz engine.
      */
-    static std::map<State, std::map<int, float>> loadQTable(const QString& filename);
+    static QTable loadQTable(const QString& filename);
     
     /**
      * @brief Save the user's Q-table for adaptive quiz
-     * @param filename Kept for API compatibility, but always uses data.json
+     * @param filename Kept for API compatibility, but always uses the active profile
      * @param qTable The Q-table to save
      * @details Delegates to LoadDataManager to store the Q-table in the central
      *          data store, maintaining consistent data handling throughout the application.
      *          This preserves the learning progress of the adaptive quiz engine between
      *          sessions, allowing for continuous improvement of question selection.
      */
-    static void saveQTable(const QString& filename, const std::map<State, std::map<int, float>>& qTable);
+    static void saveQTable(const QString& filename, const QTable& qTable);
 
     /**
      * @brief Save user's current state for the adaptive quiz
-     * @param filename Kept for API compatibility, but always uses data.json
+     * @param filename Kept for API compatibility, but always uses the active profile
      * @param state The user's current state
      * @details Stores the user's current skill level state (notes, chords, scales)
      *          using the LoadDataManager for centralized data management. This enables
@@ -75,7 +76,7 @@ public:
     
     /**
      * @brief Get user's current state for the adaptive quiz
-     * @param filename Kept for API compatibility, but always uses data.json
+     * @param filename Kept for API compatibility, but always uses the active profile
      * @return The user's current state
      * @details Retrieves the user's skill level state (notes, chords, scales)
      *          from the central data store using LoadDataManager. This allows
@@ -85,27 +86,12 @@ public:
     static State loadState(const QString& filename);
 
     /**
-     * @brief Save a quiz report to the specified file
-     * @param filename The file to save the report to
-     * @param quiz The quiz report to save
-     * @details Serializes the quiz report to JSON and writes it to the specified file.
-     *          The report includes score, accuracy, total questions answered,
-     *          correct answers, and a history containing all questions presented
-     *          during the quiz session with their responses. Unlike Q-table and state
-     *          operations, this method does use the provided filename to store
-     *          individual quiz reports separately.
-     */
-    static void saveQuizReport(const QString& filename, const QuizReport& quiz);
-    
-    /**
-     * @brief Load a quiz report from the specified file
-     * @param filename The file to load the report from
-     * @return The loaded quiz report, or an empty report if loading fails
-     * @details Reads and parses a quiz report from the specified JSON file.
-     *          Returns a QuizReport object populated with the historical quiz data,
-     *          enabling review of past performance and learning progress.
-     *          If the file cannot be opened or doesn't contain valid JSON,
-     *          an empty QuizReport is returned with no error message.
+     * @brief Load the most recent quiz report
+     * @param filename Kept for API compatibility, but always uses the active profile
+     * @return The most recent quiz of the active profile, or an empty report if it has none
+     * @details Quiz reports are no longer saved as a whole at the end of a quiz. Every
+     *          answer is appended to the profile's QuizHistory as it is given, and
+     *          this streams that history back to the last session.
      */
     static QuizReport loadQuizReport(const QString& filename);
 };
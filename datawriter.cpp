@@ -0,0 +1,94 @@
+/**
+ * @file datawriter.cpp
+ * @brief Implementation of the DataWriter class
+ * @author Alan Cruz, Bashar Hamo
+ * @details This file implements the incremental serialization and atomic file
+ *          replacement used to persist data.json and the profile files.
+ */
+
+#include "datawriter.h"
+#include "qtable.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+/**
+ * @brief Constructs a new DataWriter
+ * @param parent The parent QObject
+ */
+DataWriter::DataWriter(QObject *parent)
+    : QObject(parent)
+{
+}
+
+/**
+ * @brief Serializes the data and atomically replaces the data file
+ * @param filePath Path of the file, e.g. data.json or a profile shard
+ * @param data Snapshot of the full application data
+ * @param dirtySections Top-level keys of data that changed since the last write
+ * @param qTable Snapshot of the Q-table stored as qtable.table, or null to keep the one in data
+ * @details The output is compact JSON with the top-level keys in the same sorted
+ *          order QJsonDocument would use, so the file reads back unchanged.
+ */
+void DataWriter::write(const QString& filePath, const QJsonObject& data, const QStringList& dirtySections,
+                       std::shared_ptr<const QTable> qTable)
+{
+    const QStringList keys = data.keys();
+    QHash<QString, QByteArray>& sectionCache = m_sectionCache[filePath];
+
+    // Forget sections that no longer exist
+    for (auto it = sectionCache.begin(); it != sectionCache.end();) {
+        if (!data.contains(it.key())) {
+            it = sectionCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    QByteArray output("{");
+    for (const QString& key : keys) {
+        auto cached = sectionCache.find(key);
+        if (cached == sectionCache.end() || dirtySections.contains(key)) {
+            QJsonValue value = data.value(key);
+            if (key == "qtable" && qTable) {
+                QJsonObject qtableObj = value.toObject();
+                qtableObj["table"] = qTable->toJson();
+                value = qtableObj;
+            }
+
+            // Serialize the section as a one-key object and keep only "key":value
+            QByteArray section = QJsonDocument(QJsonObject{{key, value}}).toJson(QJsonDocument::Compact);
+            cached = sectionCache.insert(key, section.mid(1, section.size() - 2));
+        }
+        if (output.size() > 1) {
+            output.append(',');
+        }
+        output.append(cached.value());
+    }
+    output.append('}');
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "DataWriter: Failed to open data file for writing at:" << filePath;
+        emit writeFinished(false);
+        return;
+    }
+
+    if (file.write(output) != output.size() || !file.commit()) {
+        qDebug() << "DataWriter: Failed to write data file at:" << filePath;
+        emit writeFinished(false);
+        return;
+    }
+
+    emit writeFinished(true);
+}
+
+/**
+ * @brief Drops the cached sections of a file
+ * @param filePath The file that is no longer written
+ */
+void DataWriter::forget(const QString& filePath)
+{
+    m_sectionCache.remove(filePath);
+}
+
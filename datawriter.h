@@ -0,0 +1,74 @@
+/**
+ * @file datawriter.h
+ * @brief Header file for the DataWriter class
+ * @author Alan Cruz, Bashar Hamo
+ * @details This file defines the DataWriter class, the worker that serializes the
+ *          application data and writes its files off the GUI thread on behalf of
+ *          LoadDataManager.
+ */
+
+#ifndef DATAWRITER_H
+#define DATAWRITER_H
+
+#include <QObject>
+#include <QHash>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+class QTable;
+
+/**
+ * @brief Background writer for data.json and the profile files
+ * @details Lives on a worker thread owned by LoadDataManager. Every write receives a
+ *          snapshot of the whole data object of one file together with the names of the top-level
+ *          sections that changed since the previous write. Clean sections reuse their
+ *          cached compact JSON, so only the changed sections are serialized again.
+ *          The file is replaced atomically with QSaveFile, which means a crash while
+ *          writing never leaves a truncated file behind.
+ *
+ *          The Q-table arrives as a separate immutable snapshot and is converted to
+ *          JSON here, so that work never runs on the GUI thread either.
+ */
+class DataWriter : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a new DataWriter
+     * @param parent The parent QObject
+     */
+    explicit DataWriter(QObject *parent = nullptr);
+
+public slots:
+    /**
+     * @brief Serializes the data and atomically replaces the data file
+     * @param filePath Path of the file, e.g. data.json or a profile shard
+     * @param data Snapshot of the full application data
+     * @param dirtySections Top-level keys of data that changed since the last write
+     * @param qTable Snapshot of the Q-table stored as qtable.table, or null to keep the one in data
+     */
+    void write(const QString& filePath, const QJsonObject& data, const QStringList& dirtySections,
+               std::shared_ptr<const QTable> qTable);
+
+    /**
+     * @brief Drops the cached sections of a file
+     * @param filePath The file that is no longer written, e.g. the shard of a profile switched away from
+     */
+    void forget(const QString& filePath);
+
+signals:
+    /**
+     * @brief Signal emitted after each write attempt
+     * @param success true if the file was replaced, false otherwise
+     */
+    void writeFinished(bool success);
+
+private:
+    /// Compact JSON of every clean section, as "key":value, per file
+    QHash<QString, QHash<QString, QByteArray>> m_sectionCache;
+};
+
+#endif // DATAWRITER_H
@@ -0,0 +1,281 @@
+/**
+ * @file gamesession.cpp
+ * @brief Implementation of the GameSession class for KeyQuest
+ * @author Alan Cruz
+ * @details This file implements the question loop, the topic question source and the
+ *          answer matching shared by all quiz and game modes.
+ */
+
+#include "gamesession.h"
+
+#include <algorithm>
+#include <QDebug>
+
+/**
+ * @brief Constructs a session; no question is asked before start()
+ * @param questionBank Indexed question bank; must outlive the session
+ * @param seed Seed of the session's generator
+ * @param parent The parent QObject
+ */
+GameSession::GameSession(const QuestionBank& questionBank, quint64 seed, QObject* parent)
+    : QObject(parent)
+    , questionBank(questionBank)
+    , rng(seed)
+    , nextDealt(0)
+    , currentQuestion(-1)
+    , questionsAsked(0)
+    , questionLimit(0)
+    , gameEnded(false)
+{
+}
+
+/**
+ * @brief Returns the session to its state before start()
+ * @param seed Seed of the next session's generator
+ * @details Clears the question source, the current question and the question
+ *          count; the question limit is kept. The deck keeps its capacity, so
+ *          dealing the next topic does not allocate again.
+ */
+void GameSession::resetSession(quint64 seed)
+{
+    rng = SessionRng(seed);
+    attemptNotes.clear();
+    deck.clear();
+    nextDealt = 0;
+    currentQuestion = -1;
+    questionsAsked = 0;
+    gameEnded = false;
+}
+
+/**
+ * @brief Uses the shuffled questions of one topic as the question source
+ * @param topicID The ID of the topic
+ * @details Only question IDs are stored; the questions stay in the bank. The
+ *          Fisher-Yates shuffle draws from the session's generator, so the order
+ *          follows the seed.
+ */
+void GameSession::dealTopic(int topicID)
+{
+    deck.clear();
+    nextDealt = 0;
+
+    QuestionBank::QuestionRange topicQuestions = questionBank.topicQuestions(topicID);
+    if (topicQuestions.isEmpty()) {
+        qDebug() << "GameSession: Topic ID" << topicID << "not found";
+        return;
+    }
+
+    deck.reserve(topicQuestions.size());
+    for (const Question& question : topicQuestions) {
+        deck.append(question.getQuestionID());
+    }
+    for (int i = deck.size() - 1; i > 0; --i) {
+        int j = static_cast<int>(rng.bounded(static_cast<quint32>(i + 1)));
+        if (i != j) {
+            deck.swapItemsAt(i, j);
+        }
+    }
+}
+
+/**
+ * @brief Question source: picks the next question
+ * @return The ID of the next question, or -1 when there is none
+ */
+int GameSession::nextQuestionID()
+{
+    return nextDealt < deck.size() ? deck[nextDealt++] : -1;
+}
+
+/**
+ * @brief Answer matching: decides whether an attempt answers the current question
+ * @param playedNotes The notes played by the player
+ * @return true if the notes match the current question's answer key
+ */
+bool GameSession::judgeAttempt(const NoteSet& playedNotes) const
+{
+    return isAnsweredBy(currentQuestion, playedNotes);
+}
+
+/**
+ * @brief Asks the first question
+ * @details Ends the session right away if there is no question to ask.
+ */
+void GameSession::start()
+{
+    if (gameEnded || currentQuestion >= 0) {
+        return;
+    }
+    currentQuestion = nextQuestionID();
+    if (currentQuestion < 0) {
+        gameEnded = true;
+        finish();
+        return;
+    }
+    showQuestion();
+}
+
+/**
+ * @brief Moves on to the next question or ends the session
+ */
+void GameSession::advance()
+{
+    questionsAsked++;
+    currentQuestion = (questionLimit > 0 && questionsAsked >= questionLimit) ? -1 : nextQuestionID();
+    if (currentQuestion < 0) {
+        gameEnded = true;
+        finish();
+    } else {
+        showQuestion();
+    }
+}
+
+/**
+ * @brief Processes a player's attempt at answering the current question
+ * @param playedNotes The notes played by the player
+ * @return true if the attempt was correct, false otherwise
+ * @details Emits the feedback before any game state changes, then lets the mode
+ *          score the attempt and decide whether to move on.
+ */
+bool GameSession::playerAttempt(const NoteSet& playedNotes)
+{
+    if (gameEnded || currentQuestion < 0) {
+        return false;
+    }
+
+    // Pitch-class comparison is order independent and handles enharmonic spellings
+    attemptNotes = playedNotes;
+    bool isCorrect = judgeAttempt(playedNotes);
+    qDebug() << "GameSession: Comparing notes: attempt =" << playedNotes.toString() << "expected =" << getCurrentPattern() << "correct =" << isCorrect;
+
+    emit highlightKeys(isCorrect);
+
+    if (scoreAttempt(isCorrect)) {
+        advance();
+    } else {
+        showQuestion();
+    }
+    return isCorrect;
+}
+
+/**
+ * @brief Limits the number of questions asked
+ * @param limit Questions answered before the session ends; 0 for no limit
+ */
+void GameSession::setQuestionLimit(int limit) { questionLimit = qMax(0, limit); }
+
+/**
+ * @brief Checks whether an attempt answers a question
+ * @param questionID The ID of the question
+ * @param playedNotes The notes played by the player
+ * @return true if the notes answer the question
+ */
+bool GameSession::isAnsweredBy(int questionID, const NoteSet& playedNotes) const
+{
+    const QuestionBank::AnswerKey* answer = questionBank.answerKey(questionID);
+    return answer && answer->notes.isAnsweredBy(playedNotes);
+}
+
+/**
+ * @brief Follows an update of the shared question bank
+ * @param changes What QuestionBank::update() changed
+ */
+void GameSession::handleQuestionBankChanged(const QuestionBank::Changes& changes)
+{
+    if (changes.questionIDs.empty()) {
+        return;
+    }
+
+    // Drop the removed questions that have not been dealt yet
+    for (int i = deck.size() - 1; i >= nextDealt; --i) {
+        if (!questionBank.question(deck[i])) {
+            deck.removeAt(i);
+        }
+    }
+
+    if (gameEnded || currentQuestion < 0
+            || !std::binary_search(changes.questionIDs.begin(), changes.questionIDs.end(), currentQuestion)) {
+        return;
+    }
+    if (!questionBank.question(currentQuestion)) {
+        currentQuestion = nextQuestionID();
+        if (currentQuestion < 0) {
+            gameEnded = true;
+            finish();
+            return;
+        }
+    }
+    showQuestion();
+}
+
+/**
+ * @brief Gets the ID of the current question
+ * @return The question ID, or -1 if no question is being asked
+ */
+int GameSession::getCurrentQuestionID() const { return currentQuestion; }
+
+/**
+ * @brief Gets the current pattern to be played
+ * @return The expected input with an octave on every note
+ */
+QString GameSession::getCurrentPattern() const
+{
+    const QuestionBank::AnswerKey* answer = questionBank.answerKey(currentQuestion);
+    return answer ? answer->normalizedInput : QString();
+}
+
+/**
+ * @brief Gets the current question title
+ * @return The current question title
+ */
+QString GameSession::getCurrentTitle() const
+{
+    const Question* question = questionBank.question(currentQuestion);
+    return question ? question->getTitle() : QString();
+}
+
+/**
+ * @brief Gets the current question description
+ * @return The current question description
+ */
+QString GameSession::getCurrentDescription() const
+{
+    const Question* question = questionBank.question(currentQuestion);
+    return question ? question->getDescription() : QString();
+}
+
+/**
+ * @brief Gets the notes the current question expects
+ * @return The expected notes, or an empty set if there is no current question
+ */
+NoteSet GameSession::getCurrentExpectedNotes() const
+{
+    const QuestionBank::AnswerKey* answer = questionBank.answerKey(currentQuestion);
+    return answer ? answer->notes : NoteSet();
+}
+
+/**
+ * @brief Gets the current question's answer compiled for playback
+ * @return The prompt notes, empty if there is no current question
+ */
+QuestionBank::PromptRange GameSession::getCurrentPrompt() const
+{
+    return questionBank.prompt(currentQuestion);
+}
+
+/**
+ * @brief Gets the number of questions moved past so far
+ * @return The number of answered questions
+ */
+int GameSession::getQuestionsAsked() const { return questionsAsked; }
+
+/**
+ * @brief Gets the seed of the session
+ * @return The seed the session's generator was created with
+ */
+quint64 GameSession::getSeed() const { return rng.seed(); }
+
+/**
+ * @brief Checks if the session has ended
+ * @return true if the session has ended, false otherwise
+ */
+bool GameSession::isGameOver() const { return gameEnded; }
@@ -0,0 +1,228 @@
+/**
+ * @file gamesession.h
+ * @brief Header file for the GameSession class
+ * @author Alan Cruz
+ * @details This file defines GameSession, the engine shared by the lessons, the
+ *          local multiplayer game and the adaptive quiz. It runs the question loop
+ *          and answer matching once; the modes only supply their question source,
+ *          scoring and turn rules.
+ */
+
+#ifndef GAMESESSION_H
+#define GAMESESSION_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "noteset.h"
+#include "questionbank.h"
+#include "sessionrng.h"
+
+/**
+ * @brief Base class of every quiz and game session
+ * @details A session asks one question after another until its question source runs
+ *          dry or the question limit is reached. Played notes are checked against the
+ *          bank's precomputed AnswerKey with NoteSet::isAnsweredBy(), so every mode
+ *          matches answers by pitch class in the same way.
+ *
+ *          The modes are policies on top of the loop:
+ *          - question source: nextQuestionID(); by default the shuffled questions of
+ *            one topic, dealt with dealTopic()
+ *          - answer matching: judgeAttempt(); by default the answer key alone, the
+ *            rhythm lesson also checks the timing
+ *          - scoring and turn policy: scoreAttempt(), which also decides whether the
+ *            attempt moves on to the next question
+ *          - presentation: showQuestion() and finish(), which emit the mode's own
+ *            signals
+ *
+ *          Sessions refer to the questions in the shared QuestionBank instead of
+ *          copying them, so creating one reads no files and copies no strings.
+ *          A finished session can be reset and started again in place; the modes
+ *          offer reset() or restart() for that, built on resetSession().
+ */
+class GameSession : public QObject
+{
+    Q_OBJECT
+public:
+    // Topic IDs
+    static const int GENERAL_TOPIC_ID = 101;
+    static const int MAJOR_MINOR_CHORDS_TOPIC_ID = 102;
+    static const int TRIAD_TOPIC_ID = 103;
+    static const int MAJOR_SCALE_ID = 104;
+    static const int PERFECT_ID = 105;
+    static const int MELODY_ID = 106;
+
+    /**
+     * @brief Asks the first question
+     * @details Ends the session right away if there is no question to ask.
+     */
+    void start();
+
+    /**
+     * @brief Processes a player's attempt at answering the current question
+     * @param playedNotes The notes played by the player
+     * @return bool true if the attempt was correct, false otherwise
+     */
+    bool playerAttempt(const NoteSet& playedNotes);
+
+    /**
+     * @brief Limits the number of questions asked
+     * @param limit Questions answered before the session ends; 0 for no limit
+     */
+    void setQuestionLimit(int limit);
+
+    /**
+     * @brief Checks whether an attempt answers a question
+     * @param questionID The ID of the question
+     * @param playedNotes The notes played by the player
+     * @return bool true if the notes answer the question
+     */
+    bool isAnsweredBy(int questionID, const NoteSet& playedNotes) const;
+
+    /**
+     * @brief Gets the ID of the current question
+     * @return int The question ID, or -1 if no question is being asked
+     */
+    int getCurrentQuestionID() const;
+
+    /**
+     * @brief Gets the current pattern to be played
+     * @return QString The expected input with an octave on every note
+     */
+    QString getCurrentPattern() const;
+
+    /**
+     * @brief Gets the current question title
+     * @return QString The current question title
+     */
+    QString getCurrentTitle() const;
+
+    /**
+     * @brief Gets the current question description
+     * @return QString The current question description
+     */
+    QString getCurrentDescription() const;
+
+    /**
+     * @brief Gets the notes the current question expects
+     * @return NoteSet The expected notes, empty if there is no current question
+     */
+    NoteSet getCurrentExpectedNotes() const;
+
+    /**
+     * @brief Gets the current question's answer compiled for playback
+     * @return The prompt notes, empty if there is no current question
+     */
+    QuestionBank::PromptRange getCurrentPrompt() const;
+
+    /**
+     * @brief Gets the number of questions moved past so far
+     * @return int The number of answered questions
+     */
+    int getQuestionsAsked() const;
+
+    /**
+     * @brief Gets the seed of the session
+     * @return quint64 The seed the session's generator was created with
+     */
+    quint64 getSeed() const;
+
+    /**
+     * @brief Checks if the session has ended
+     * @return bool true if the session is over, false otherwise
+     */
+    bool isGameOver() const;
+
+public slots:
+    /**
+     * @brief Follows an update of the shared question bank
+     * @param changes What QuestionBank::update() changed
+     * @details Removed questions are taken out of the questions still to be dealt.
+     *          An edited current question is shown again with its new texts; a
+     *          removed one is replaced by the next question without counting it as
+     *          asked. Questions added to a dealt topic are asked from the next session.
+     */
+    virtual void handleQuestionBankChanged(const QuestionBank::Changes& changes);
+
+signals:
+    /**
+     * @brief Signal emitted for key highlighting feedback
+     * @param isCorrect True if the answer was correct, false otherwise
+     */
+    void highlightKeys(bool isCorrect);
+
+protected:
+    /**
+     * @brief Constructs a session; no question is asked before start()
+     * @param questionBank Indexed question bank; must outlive the session
+     * @param seed Seed of the session's generator
+     * @param parent The parent QObject
+     */
+    GameSession(const QuestionBank& questionBank, quint64 seed, QObject* parent);
+
+    /**
+     * @brief Returns the session to its state before start()
+     * @param seed Seed of the next session's generator
+     * @details Clears the question source, the current question and the question
+     *          count; the question limit is kept.
+     */
+    void resetSession(quint64 seed);
+
+    /**
+     * @brief Uses the shuffled questions of one topic as the question source
+     * @param topicID The ID of the topic
+     */
+    void dealTopic(int topicID);
+
+    /**
+     * @brief Question source: picks the next question
+     * @return int The ID of the next question, or -1 when there is none
+     * @details The default takes the next question dealt by dealTopic().
+     */
+    virtual int nextQuestionID();
+
+    /**
+     * @brief Answer matching: decides whether an attempt answers the current question
+     * @param playedNotes The notes played by the player
+     * @return bool true if the attempt is correct
+     * @details The default compares the notes with the question's answer key.
+     */
+    virtual bool judgeAttempt(const NoteSet& playedNotes) const;
+
+    /**
+     * @brief Scoring and turn policy: records an attempt at the current question
+     * @param correct Whether the attempt was correct
+     * @return bool true to move on to the next question, false to ask it again
+     */
+    virtual bool scoreAttempt(bool correct) = 0;
+
+    /**
+     * @brief Presents the current question, e.g. by emitting the mode's updateUI
+     * @details Also called when a question is asked again after an attempt.
+     */
+    virtual void showQuestion() = 0;
+
+    /**
+     * @brief Presents the end of the session, e.g. by emitting the mode's gameOver
+     */
+    virtual void finish() = 0;
+
+    const QuestionBank& questionBank;  ///< Shared question bank
+    SessionRng rng;                    ///< Per-session generator, seeded from the session seed
+    NoteSet attemptNotes;              ///< Notes of the attempt being scored, set before scoreAttempt()
+
+private:
+    /**
+     * @brief Moves on to the next question or ends the session
+     */
+    void advance();
+
+    QVector<int> deck;        ///< Question IDs dealt by dealTopic(), in asking order
+    int nextDealt;            ///< Index of the next question of the deck
+    int currentQuestion;      ///< ID of the question being asked, -1 if none
+    int questionsAsked;       ///< Questions moved past so far
+    int questionLimit;        ///< Questions asked before the session ends, 0 for no limit
+    bool gameEnded;           ///< Whether the session is over
+};
+
+#endif // GAMESESSION_H
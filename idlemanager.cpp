@@ -0,0 +1,195 @@
+/**
+ * @file idlemanager.cpp
+ * @brief Implementation of the IdleManager class
+ * @author Alan Cruz
+ * @details This file implements the suspension of the audio output and the
+ *          background music while the application is idle.
+ */
+
+#include "idlemanager.h"
+#include "keyboard.h"
+#include "soundmanager.h"
+#include <QDebug>
+#include <QEvent>
+#include <QGuiApplication>
+
+IdleManager* IdleManager::m_instance = nullptr;
+
+/**
+ * @brief Gets the application-wide manager
+ * @return The manager, created the first time it is requested
+ */
+IdleManager* IdleManager::instance()
+{
+    if (!m_instance) {
+        m_instance = new IdleManager();
+    }
+    return m_instance;
+}
+
+/**
+ * @brief Creates the manager
+ * @details Nothing is watched before setKeyboard().
+ */
+IdleManager::IdleManager()
+{
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setTimerType(Qt::VeryCoarseTimer);
+    connect(&m_idleTimer, &QTimer::timeout, this, &IdleManager::checkIdle);
+}
+
+/**
+ * @brief Starts watching the input for a keyboard
+ * @param keyboard The synthesizer whose audio driver is suspended
+ */
+void IdleManager::setKeyboard(Keyboard* keyboard)
+{
+    if (!keyboard) {
+        qDebug() << "IdleManager: No keyboard to suspend";
+        return;
+    }
+    const bool first = !m_keyboard;
+    m_keyboard = keyboard;
+    if (!first) {
+        return;
+    }
+
+    qApp->installEventFilter(this);
+    connect(qApp, &QGuiApplication::applicationStateChanged, this, &IdleManager::handleApplicationState);
+    m_active = QGuiApplication::applicationState() == Qt::ApplicationActive;
+    m_lastInput.start();
+    m_idleTimer.start(idleTimeout());
+}
+
+/**
+ * @brief Adds a check that keeps the audio running while it returns true
+ * @param busy The check; ignored if empty
+ */
+void IdleManager::addBusyCheck(BusyFunction busy)
+{
+    if (busy) {
+        m_busyChecks.push_back(std::move(busy));
+    }
+}
+
+/**
+ * @brief Records input and resumes the audio if it is suspended
+ * @details Called for every input event, so it only restarts the clock; the
+ *          timer is left running and checkIdle() measures from the last input.
+ */
+void IdleManager::notifyActivity()
+{
+    m_lastInput.restart();
+    if (m_musicPaused) {
+        m_musicPaused = false;
+        SoundManager::instance()->resumeBackgroundMusic();
+    }
+    if (m_audioSuspended) {
+        m_audioSuspended = false;
+        m_keyboard->resumeAudio();
+    }
+    if (!m_idleTimer.isActive()) {
+        m_idleTimer.start(idleTimeout());
+    }
+}
+
+/**
+ * @brief Watches the application's input events
+ * @param watched The object receiving the event
+ * @param event The event
+ * @return false; the event is always delivered
+ * @details Mouse movement counts as input, so reaching for the piano opens the
+ *          driver before the first click.
+ */
+bool IdleManager::eventFilter(QObject* watched, QEvent* event)
+{
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+    case QEvent::TabletPress:
+        notifyActivity();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+/**
+ * @brief Resumes on activation and shortens the timeout in the background
+ * @param state The new application state
+ * @details Becoming active counts as input, which opens the driver while the
+ *          window gets focus rather than on the first key press.
+ */
+void IdleManager::handleApplicationState(Qt::ApplicationState state)
+{
+    m_active = state == Qt::ApplicationActive;
+    if (m_active) {
+        notifyActivity();
+    }
+    m_idleTimer.start(qMax(0, idleTimeout() - int(m_lastInput.elapsed())));
+}
+
+/**
+ * @brief Suspends what has been idle long enough, or waits for the rest
+ * @details When the timeout has not passed since the last input, or something is
+ *          playing, the timer is started again for the time that is left.
+ */
+void IdleManager::checkIdle()
+{
+    const int timeout = idleTimeout();
+    const qint64 idle = m_lastInput.elapsed();
+    if (idle < timeout) {
+        m_idleTimer.start(int(timeout - idle));
+        return;
+    }
+    if (isBusy()) {
+        m_idleTimer.start(timeout);
+        return;
+    }
+
+    if (!m_audioSuspended) {
+        m_audioSuspended = true;
+        m_keyboard->suspendAudio();
+    }
+    SoundManager* sound = SoundManager::instance();
+    if (!m_active && !m_musicPaused && sound->isBackgroundMusicPlaying()) {
+        m_musicPaused = true;
+        sound->pauseBackgroundMusic();
+        qDebug() << "IdleManager: background music paused";
+    }
+
+    // Moving to the background later still has to pause the music
+    if (m_active) {
+        m_idleTimer.stop();
+    }
+}
+
+/**
+ * @brief Checks the busy checks and the keyboard
+ * @return true if something is playing
+ */
+bool IdleManager::isBusy() const
+{
+    if (m_keyboard->isBusy()) {
+        return true;
+    }
+    for (const BusyFunction& busy : m_busyChecks) {
+        if (busy()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Gets the idle time after which the next step is taken
+ * @return INPUT_IDLE_MS, or BACKGROUND_IDLE_MS in the background
+ */
+int IdleManager::idleTimeout() const
+{
+    return m_active ? INPUT_IDLE_MS : BACKGROUND_IDLE_MS;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file idlemanager.h
+ * @brief Header file for the IdleManager class
+ * @author Alan Cruz
+ * @details This file defines IdleManager, which closes the audio output and
+ *          pauses the background music while KeyQuest is not being used, so an
+ *          idle or minimized window does not keep a core awake.
+ */
+
+#ifndef IDLEMANAGER_H
+#define IDLEMANAGER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <functional>
+#include <vector>
+
+class Keyboard;
+
+/**
+ * @brief Suspends the audio while there is no input and resumes it on the next
+ * @details Once the piano exists, its audio driver renders silence for as long as
+ *          the application runs. The manager watches the input events of the
+ *          whole application and QGuiApplication::applicationStateChanged:
+ *          - after INPUT_IDLE_MS without input the piano's audio driver is closed
+ *            with Keyboard::suspendAudio(), which keeps the synthesizer and its
+ *            SoundFont, so the background music goes on
+ *          - after BACKGROUND_IDLE_MS in the background (another window active,
+ *            or minimized) the background music is paused as well
+ *
+ *          Any key press, click, wheel or touch, a note from a MIDI keyboard and
+ *          the window becoming active again resume the audio. The input is seen
+ *          by an event filter before it reaches the widgets, so the note of the
+ *          key press that wakes the piano is already played by the reopened
+ *          driver, and mouse movement or focusing the window opens it ahead of
+ *          the first note. A note from a MIDI keyboard is queued for the audio
+ *          callback on arrival and MidiInput::wakeRequested() resumes the driver,
+ *          which then plays it.
+ *
+ *          Nothing is suspended while Keyboard::isBusy() or a check added with
+ *          addBusyCheck() reports work in progress, such as a recording being
+ *          played back.
+ */
+class IdleManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int INPUT_IDLE_MS = 60000;       ///< Time without input that suspends the piano's audio
+    static constexpr int BACKGROUND_IDLE_MS = 10000;  ///< Time in the background that also pauses the music
+
+    /// Reports whether something is playing that suspending would cut off
+    using BusyFunction = std::function<bool()>;
+
+    /**
+     * @brief Gets the application-wide manager
+     * @return The manager
+     */
+    static IdleManager* instance();
+
+    /**
+     * @brief Starts watching the input for a keyboard
+     * @param keyboard The synthesizer whose audio driver is suspended
+     * @details Installs the event filter on the application the first time.
+     */
+    void setKeyboard(Keyboard* keyboard);
+
+    /**
+     * @brief Adds a check that keeps the audio running while it returns true
+     * @param busy The check; called on the GUI thread
+     */
+    void addBusyCheck(BusyFunction busy);
+
+    /**
+     * @brief Checks whether the audio is suspended
+     * @return true while the piano's audio driver is closed
+     */
+    bool isSuspended() const { return m_audioSuspended; }
+
+public Q_SLOTS:
+    /**
+     * @brief Records input and resumes the audio if it is suspended
+     */
+    void notifyActivity();
+
+protected:
+    /**
+     * @brief Watches the application's input events
+     * @param watched The object receiving the event
+     * @param event The event
+     * @return false; the event is always delivered
+     */
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private Q_SLOTS:
+    /**
+     * @brief Resumes on activation and shortens the timeout in the background
+     * @param state The new application state
+     */
+    void handleApplicationState(Qt::ApplicationState state);
+
+    /**
+     * @brief Suspends what has been idle long enough, or waits for the rest
+     */
+    void checkIdle();
+
+private:
+    /**
+     * @brief Creates the manager
+     */
+    IdleManager();
+
+    /**
+     * @brief Checks the busy checks and the keyboard
+     * @return true if something is playing
+     */
+    bool isBusy() const;
+
+    /**
+     * @brief Gets the idle time after which the next step is taken
+     * @return INPUT_IDLE_MS, or BACKGROUND_IDLE_MS in the background
+     */
+    int idleTimeout() const;
+
+    static IdleManager* m_instance;        ///< The application-wide instance
+    Keyboard* m_keyboard = nullptr;        ///< Synthesizer whose driver is suspended
+    std::vector<BusyFunction> m_busyChecks; ///< Added by addBusyCheck()
+    QElapsedTimer m_lastInput;             ///< Time since the last input
+    QTimer m_idleTimer;                    ///< Wakes checkIdle() when the timeout may have passed
+    bool m_active = true;                  ///< Whether the application is the active one
+    bool m_audioSuspended = false;         ///< Whether the keyboard's driver is closed
+    bool m_musicPaused = false;            ///< Whether the music was paused here and is to be resumed
+};
+
+#endif // IDLEMANAGER_H
@@ -7,18 +7,43 @@
  */
 
 #include "keyboard.h"
-#include <unistd.h>
+#include "trace.h"
 #include <QCoreApplication>
-#include <QtCore/QFile>
-#include <QStandardPaths>
+#include <QResource>
+#include <QStringList>
+#include <QThread>
 #include <QtCore/QTimer>
+#include <algorithm>
+#include "loaddatamanager.h"
+
+/**
+ * @brief What the synthesizer does at one quality
+ */
+struct KeyboardSynthTier {
+    int polyphony;   ///< Most voices sounding at once
+    bool effects;    ///< Whether reverb and chorus are on
+    bool multiCore;  ///< Whether rendering is spread over several cores
+};
+
+/// Tiers of Keyboard::SynthQuality, in its order
+static const KeyboardSynthTier KEYBOARD_SYNTH_TIERS[] = {
+    {48, false, false},   // Light
+    {128, false, false},  // Standard
+    {256, true, true}     // Rich
+};
+
+/// The piano SoundFont, played by the synthesizer and rendered into the samples
+static const char* const KEYBOARD_SOUNDFONT = ":/sounds/piano.sf2";
 
 /**
  * @brief Constructor for Keyboard
- * @details Initializes the FluidSynth synthesizer and audio driver based on the operating system.
- *          Sets up the appropriate audio driver (CoreAudio for macOS, DirectSound for Windows,
- *          PulseAudio for Linux) and loads the piano SoundFont from resources.
- *          The SoundFont is extracted to a temporary location for FluidSynth to use.
+ * @details Initializes the FluidSynth synthesizer for the synth quality and an audio
+ *          driver for the latency profile stored in the settings (see
+ *          startAudioDriver()), and starts loading
+ *          the piano SoundFont from resources on a background thread, so constructing
+ *          the keyboard does not wait for it. With the Samples engine the notes are
+ *          rendered in the background instead and the SoundFont is only loaded if
+ *          the engine is switched.
  */
 Keyboard::Keyboard() {
     settings = new_fluid_settings();
@@ -27,127 +52,905 @@ Keyboard::Keyboard() {
         return;
     }
 
-    // Configure FluidSynth settings for better polyphony
-    fluid_settings_setint(settings, "synth.polyphony", 128);  // Allow up to 128 simultaneous notes
+    // Polyphony and effects follow the quality; the rendering threads can only be set here
+    quality = synthQualityFromString(LoadDataManager::instance()->getSynthQuality());
+    const KeyboardSynthTier& tier = KEYBOARD_SYNTH_TIERS[static_cast<int>(quality)];
+    const int cores = tier.multiCore ? std::clamp(QThread::idealThreadCount(), 1, MAX_RENDER_THREADS) : 1;
+    fluid_settings_setint(settings, "synth.polyphony", tier.polyphony);
+    fluid_settings_setint(settings, "synth.cpu-cores", cores);
     fluid_settings_setnum(settings, "synth.sample-rate", 44100.0);
     fluid_settings_setnum(settings, "synth.gain", 0.5);
     fluid_settings_setint(settings, "synth.audio-channels", 2);
     fluid_settings_setint(settings, "synth.audio-groups", 1);
     fluid_settings_setint(settings, "synth.effects-channels", 2);
-    fluid_settings_setint(settings, "synth.reverb.active", 0);
-    fluid_settings_setint(settings, "synth.chorus.active", 0);
-    fluid_settings_setint(settings, "audio.periods", 8);
-    fluid_settings_setint(settings, "audio.period-size", 256);
+    fluid_settings_setint(settings, "synth.reverb.active", tier.effects ? 1 : 0);
+    fluid_settings_setint(settings, "synth.chorus.active", tier.effects ? 1 : 0);
     fluid_settings_setstr(settings, "audio.sample-format", "float");
 
-// **Set Correct Audio Driver Based on OS**
-#ifdef Q_OS_MAC
-    fluid_settings_setstr(settings, "audio.driver", "coreaudio");
-#elif defined(Q_OS_WIN)
-    fluid_settings_setstr(settings, "audio.driver", "dsound");
-#elif defined(Q_OS_LINUX)
-    fluid_settings_setstr(settings, "audio.driver", "pulseaudio");
-#endif
+    // Voice stealing: released notes go first, then quiet and old ones
+    fluid_settings_setnum(settings, "synth.overflow.released", -4000.0);
+    fluid_settings_setnum(settings, "synth.overflow.volume", 1000.0);
+    fluid_settings_setnum(settings, "synth.overflow.age", 500.0);
 
     synth = new_fluid_synth(settings);
     if (!synth) {
         qDebug() << "ERROR: Failed to create FluidSynth synthesizer!";
         return;
     }
+    fluid_settings_getnum(settings, "synth.sample-rate", &sampleRate);
+    effectsActive = tier.effects;
 
-    adriver = new_fluid_audio_driver(settings, synth);
-    if (!adriver) {
-        qDebug() << "ERROR: Failed to create FluidSynth audio driver!";
+    profile = latencyProfileFromString(LoadDataManager::instance()->getLatencyProfile());
+    if (!startAudioDriver()) {
         return;
     }
 
-    // Extract the SoundFont from Qt Resources
-    QString tempPath = QStandardPaths::writableLocation(QStandardPaths::TempLocation) + "/piano.sf2";
-    QFile soundFontFile(":/sounds/piano.sf2"); // Make sure this matches your .qrc prefix!
+    // Watch for underruns while the low-latency profile is active
+    underrunTimer = new QTimer();
+    underrunTimer->setInterval(UNDERRUN_CHECK_MS);
+    QObject::connect(underrunTimer, &QTimer::timeout, [this]() {
+        checkUnderruns();
+        sampler.collect();
+    });
+    underrunTimer->start();
 
-    if (!QFile::exists(tempPath)) { // Check if file is already extracted
-        if (soundFontFile.exists()) { // Check if the file exists in resources
-            if (soundFontFile.open(QIODevice::ReadOnly)) {
-                QFile tempFile(tempPath);
-                if (tempFile.open(QIODevice::WriteOnly)) {
-                    if (tempFile.write(soundFontFile.readAll()) == -1) {
-                        qDebug() << "ERROR: Failed to write SoundFont to disk!";
-                        return;
-                    }
-                    tempFile.close();
+    sequencerTimer = new QTimer();
+    sequencerTimer->setTimerType(Qt::PreciseTimer);
+    sequencerTimer->setInterval(SEQUENCER_INTERVAL_MS);
+    QObject::connect(sequencerTimer, &QTimer::timeout, [this]() { feedSequencer(); });
 
-#ifdef Q_OS_WIN
-                    QFile::setPermissions(tempPath, QFile::ReadUser | QFile::WriteUser);
-#else
-                    QFile::setPermissions(tempPath, QFile::ReadOwner | QFile::WriteOwner);
-#endif
-                    qDebug() << "Extracted SoundFont to:" << tempPath;
-                } else {
-                    qDebug() << "ERROR: Failed to create temp file!";
-                    return;
-                }
-                soundFontFile.close();
-            } else {
-                qDebug() << "ERROR: Failed to open resource SoundFont file!";
-                return;
-            }
-        } else {
-            qDebug() << "ERROR: SoundFont resource not found!";
-            return;
-        }
-    } else {
-        qDebug() << "SoundFont already exists at:" << tempPath;
-    }
+    // Load the SoundFont in the background; notes are silent until it is ready
+    loader = new SoundFontLoader(settings, synth, KEYBOARD_SOUNDFONT);
+    QObject::connect(loader, &SoundFontLoader::finished, [this](bool ok) {
+        soundFontReady = ok;
+        soundFontBytes = ok ? QResource(KEYBOARD_SOUNDFONT).uncompressedSize() : 0;
+    });
 
-    // **Load SoundFont in FluidSynth**
-    int sf_id = fluid_synth_sfload(synth, tempPath.toUtf8().constData(), 1);
-    if (sf_id == -1) {
-        qDebug() << "ERROR: Failed to load SoundFont!";
+    engine = soundEngineFromString(LoadDataManager::instance()->getSoundEngine());
+    samplesEngine = engine == SoundEngine::Samples;
+    if (engine == SoundEngine::Samples) {
+        buildSamples();
     } else {
-        qDebug() << "SoundFont Loaded Successfully!";
-        // Set the instrument to piano (program 0) after loading the soundfont
-        fluid_synth_program_select(synth, 0, sf_id, 0, 0);
+        loader->start();
     }
 }
 
 /**
  * @brief Destructor for Keyboard
  * @details Cleans up FluidSynth resources by deleting the audio driver,
- *          synthesizer, and settings in the correct order.
+ *          synthesizer, and settings in the correct order. A SoundFont load that is
+ *          still running is waited for first, and a sample render is stopped.
  */
 Keyboard::~Keyboard() {
+    sampleStopping = true;
+    if (sampleBuilder) {
+        sampleBuilder->wait();
+        delete sampleBuilder;
+    }
+    delete loader;
+    delete underrunTimer;
+    delete sequencerTimer;
     delete_fluid_audio_driver(adriver);
     delete_fluid_synth(synth);
     delete_fluid_settings(settings);
 }
 
+/**
+ * @brief Converts a stored profile name to a profile
+ * @param name "safe" or "low"
+ * @return The profile; Safe for unknown names
+ */
+Keyboard::LatencyProfile Keyboard::latencyProfileFromString(const QString& name) {
+    return name == "low" ? LatencyProfile::Low : LatencyProfile::Safe;
+}
+
+/**
+ * @brief Converts a profile to the name it is stored under
+ * @param profile The profile
+ * @return "safe" or "low"
+ */
+QString Keyboard::latencyProfileToString(LatencyProfile profile) {
+    return profile == LatencyProfile::Low ? "low" : "safe";
+}
+
+/**
+ * @brief Converts a stored quality name to a quality
+ * @param name "light", "standard" or "rich"
+ * @return The quality; Standard for unknown names
+ */
+Keyboard::SynthQuality Keyboard::synthQualityFromString(const QString& name) {
+    if (name == "light") return SynthQuality::Light;
+    if (name == "rich") return SynthQuality::Rich;
+    return SynthQuality::Standard;
+}
+
+/**
+ * @brief Converts a quality to the name it is stored under
+ * @param quality The quality
+ * @return "light", "standard" or "rich"
+ */
+QString Keyboard::synthQualityToString(SynthQuality quality) {
+    switch (quality) {
+    case SynthQuality::Light: return "light";
+    case SynthQuality::Rich: return "rich";
+    default: return "standard";
+    }
+}
+
+/**
+ * @brief Converts a stored engine name to an engine
+ * @param name "synth" or "samples"
+ * @return The engine; Synth for unknown names
+ */
+Keyboard::SoundEngine Keyboard::soundEngineFromString(const QString& name) {
+    return name == "samples" ? SoundEngine::Samples : SoundEngine::Synth;
+}
+
+/**
+ * @brief Converts an engine to the name it is stored under
+ * @param engine The engine
+ * @return "synth" or "samples"
+ */
+QString Keyboard::soundEngineToString(SoundEngine engine) {
+    return engine == SoundEngine::Samples ? "samples" : "synth";
+}
+
+/**
+ * @brief Creates the audio driver for the current latency profile
+ * @return true if a driver was created
+ * @details The safe profile uses the platform's default backend (CoreAudio on
+ *          macOS, DirectSound on Windows, PulseAudio on Linux) with 8 periods of
+ *          256 frames. The low-latency profile uses 2 periods of 128 frames and
+ *          prefers JACK, then ALSA on Linux and exclusive-mode WASAPI on Windows,
+ *          falling back to the default backend if none of them can be opened.
+ */
+bool Keyboard::startAudioDriver() {
+    const bool low = profile == LatencyProfile::Low;
+    fluid_settings_setint(settings, "audio.periods", low ? 2 : 8);
+    fluid_settings_setint(settings, "audio.period-size", low ? 128 : 256);
+
+// **Set Correct Audio Driver Based on OS**
+#ifdef Q_OS_MAC
+    const QStringList drivers = {"coreaudio"};
+#elif defined(Q_OS_WIN)
+    const QStringList drivers = low ? QStringList{"wasapi", "dsound"} : QStringList{"dsound"};
+    fluid_settings_setint(settings, "audio.wasapi.exclusive-mode", low ? 1 : 0);
+#elif defined(Q_OS_LINUX)
+    const QStringList drivers = low ? QStringList{"jack", "alsa", "pulseaudio"} : QStringList{"pulseaudio"};
+    fluid_settings_setint(settings, "audio.jack.autoconnect", 1);
+#else
+    const QStringList drivers;
+#endif
+
+    lastCallbackTime = 0;
+    underruns = 0;
+    for (const QString& driver : drivers) {
+        fluid_settings_setstr(settings, "audio.driver", driver.toUtf8().constData());
+
+        // Render through our own callback so queued note events are applied on the audio thread
+        adriver = new_fluid_audio_driver2(settings, &Keyboard::audioCallback, this);
+        if (adriver) {
+            qDebug() << "Audio driver:" << driver << "profile:" << latencyProfileToString(profile);
+            return true;
+        }
+    }
+    if (drivers.isEmpty()) {
+        adriver = new_fluid_audio_driver2(settings, &Keyboard::audioCallback, this);
+        if (adriver) {
+            return true;
+        }
+    }
+
+    qDebug() << "ERROR: Failed to create FluidSynth audio driver!";
+    return false;
+}
+
+/**
+ * @brief Switches the audio driver to another latency profile
+ * @param newProfile The profile
+ */
+void Keyboard::setLatencyProfile(LatencyProfile newProfile) {
+    if (newProfile == profile || !synth) return;
+    if (audioSuspended.load(std::memory_order_relaxed)) {
+        // resumeAudio() opens the driver of the new profile
+        profile = newProfile;
+        return;
+    }
+
+    // Deleting the driver stops its callback before the new one starts
+    delete_fluid_audio_driver(adriver);
+    adriver = nullptr;
+    fluid_synth_all_sounds_off(synth, -1);
+
+    profile = newProfile;
+    if (!startAudioDriver() && profile == LatencyProfile::Low) {
+        profile = LatencyProfile::Safe;
+        startAudioDriver();
+    }
+}
+
+/**
+ * @brief Closes the audio driver while nothing is being played
+ * @details Deleting the driver stops its callback, so the synthesizer and the
+ *          sampler can be silenced from this thread afterwards.
+ */
+void Keyboard::suspendAudio() {
+    if (audioSuspended.load(std::memory_order_relaxed) || !adriver) return;
+
+    delete_fluid_audio_driver(adriver);
+    adriver = nullptr;
+    audioSuspended.store(true, std::memory_order_release);
+    fluid_synth_all_sounds_off(synth, -1);
+    sampler.stopAll();
+    underrunTimer->stop();
+    qDebug() << "Keyboard: audio suspended";
+}
+
+/**
+ * @brief Opens the audio driver again after suspendAudio()
+ * @details Falls back to the safe profile like setLatencyProfile() if the
+ *          low-latency backends cannot be opened.
+ */
+void Keyboard::resumeAudio() {
+    if (!audioSuspended.load(std::memory_order_relaxed)) return;
+
+    audioSuspended.store(false, std::memory_order_release);
+    if (!startAudioDriver() && profile == LatencyProfile::Low) {
+        profile = LatencyProfile::Safe;
+        startAudioDriver();
+    }
+    underrunTimer->start();
+    qDebug() << "Keyboard: audio resumed";
+}
+
+/**
+ * @brief Switches the synthesizer to another quality
+ * @param newQuality The quality
+ */
+void Keyboard::setSynthQuality(SynthQuality newQuality) {
+    if (newQuality == quality || !synth) return;
+    quality = newQuality;
+    overloadedChecks = 0;
+    applySynthQuality();
+}
+
+/**
+ * @brief Applies the polyphony and effects of the current quality to the synth
+ * @details FluidSynth takes both while it renders. The callback only mixes the
+ *          effect buffers into the output while effects are on.
+ */
+void Keyboard::applySynthQuality() {
+    const KeyboardSynthTier& tier = KEYBOARD_SYNTH_TIERS[static_cast<int>(quality)];
+    fluid_synth_set_polyphony(synth, tier.polyphony);
+    fluid_synth_reverb_on(synth, -1, tier.effects ? 1 : 0);
+    fluid_synth_chorus_on(synth, -1, tier.effects ? 1 : 0);
+    effectsActive.store(tier.effects, std::memory_order_release);
+    qDebug() << "Synth quality:" << synthQualityToString(quality) << "polyphony:" << tier.polyphony;
+}
+
+/**
+ * @brief Switches to another sound engine
+ * @param newEngine The engine
+ * @details The callback goes on with the old engine until the new one can play:
+ *          the samples have been rendered or the SoundFont has been loaded.
+ */
+void Keyboard::setSoundEngine(SoundEngine newEngine) {
+    if (newEngine == engine || !synth) return;
+    engine = newEngine;
+    samplesEngine.store(engine == SoundEngine::Samples, std::memory_order_release);
+    if (engine == SoundEngine::Samples) {
+        buildSamples();
+    } else if (loader) {
+        loader->start();
+    }
+    qDebug() << "Sound engine:" << soundEngineToString(engine);
+}
+
+/**
+ * @brief Sets the notes the Samples engine can play
+ * @param firstNote Lowest note
+ * @param lastNote Highest note
+ */
+void Keyboard::setSampleRange(int firstNote, int lastNote) {
+    {
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        if (firstNote == sampleFirstNote && lastNote == sampleLastNote) {
+            return;
+        }
+        sampleFirstNote = firstNote;
+        sampleLastNote = lastNote;
+        sampleBankReady = false;
+    }
+    if (engine == SoundEngine::Samples) {
+        buildSamples();
+    }
+}
+
+/**
+ * @brief Starts rendering the samples of the key range in the background
+ * @details The render thread checks sampleGeneration when it is done and renders
+ *          again if the range changed meanwhile, so at most one thread runs.
+ */
+void Keyboard::buildSamples() {
+    if (!adriver) return;
+
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    const bool ready = sampleBuiltFirst == sampleFirstNote && sampleBuiltLast == sampleLastNote;
+    sampleBankReady = ready;
+    if (ready) {
+        return;
+    }
+    sampleRequested = ++sampleGeneration;
+    if (sampleBuilding) {
+        return;
+    }
+
+    // The previous thread has left buildSampleBanks() and only has to finish
+    if (sampleBuilder) {
+        sampleBuilder->wait();
+        delete sampleBuilder;
+    }
+    sampleBuilding = true;
+    sampleBuilder = QThread::create([this]() { buildSampleBanks(); });
+    sampleBuilder->setObjectName("NoteSampler");
+    sampleBuilder->start(QThread::LowPriority);
+}
+
+/**
+ * @brief Renders key ranges until the latest one is done; runs on the worker thread
+ * @details A render is abandoned as soon as a newer range is requested. If the
+ *          notes cannot be rendered at all the SoundFont is loaded into the live
+ *          synthesizer, so the keyboard does not stay silent.
+ */
+void Keyboard::buildSampleBanks() {
+    while (true) {
+        int first = 0;
+        int last = 0;
+        quint32 generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(sampleMutex);
+            first = sampleFirstNote;
+            last = sampleLastNote;
+            generation = sampleGeneration;
+        }
+
+        const auto stale = [this, generation]() {
+            return sampleStopping.load() || sampleRequested.load() != generation;
+        };
+        std::unique_ptr<NoteSampler::Bank> bank = NoteSampler::render(KEYBOARD_SOUNDFONT, first, last, sampleRate, stale);
+
+        std::lock_guard<std::mutex> lock(sampleMutex);
+        if (bank) {
+            sampler.publish(std::move(bank));
+            sampleBuiltFirst = first;
+            sampleBuiltLast = last;
+        } else if (!sampleStopping && sampleGeneration == generation) {
+            qDebug() << "Keyboard: Failed to render the samples, playing the synthesizer instead";
+            QMetaObject::invokeMethod(loader, [this]() { loader->start(); }, Qt::QueuedConnection);
+        }
+        if (sampleStopping || sampleGeneration == generation) {
+            sampleBankReady = sampleBuiltFirst == sampleFirstNote && sampleBuiltLast == sampleLastNote;
+            sampleBuilding = false;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Gets the memory the sound of the notes holds
+ * @return Bytes of the SoundFont loaded into the synthesizer plus the samples
+ *         of the Samples engine
+ * @details FluidSynth reads the whole sample data of the SoundFont into memory,
+ *          so its size stands for the synthesizer's share.
+ */
+qint64 Keyboard::memoryUsage() const {
+    return soundFontBytes + sampler.memoryUsage();
+}
+
+/**
+ * @brief Gets the load of the synthesizer
+ * @return Time spent rendering, in percent of the time the audio lasts
+ */
+double Keyboard::cpuLoad() const {
+    return synth ? fluid_synth_get_cpu_load(synth) : 0.0;
+}
+
+/**
+ * @brief Gets the number of threads rendering the synthesizer
+ * @return The synth.cpu-cores the synth was created with
+ */
+int Keyboard::renderThreads() const {
+    int cores = 1;
+    if (settings) {
+        fluid_settings_getint(settings, "synth.cpu-cores", &cores);
+    }
+    return cores;
+}
+
+/**
+ * @brief Falls back to the safe profile or a lower quality if the callback ran late too often
+ * @details A callback that starts more than two blocks after the previous one
+ *          means the output buffer ran dry. At the low-latency profile that first
+ *          switches to the safe profile. Underruns at the safe profile, or a synth
+ *          load above CPU_LOAD_LIMIT, for OVERLOAD_FALLBACK_CHECKS checks in a row
+ *          lower the quality one step, unless the Samples engine is playing. Either
+ *          switch is stored in the settings so the next start uses it as well.
+ */
+void Keyboard::checkUnderruns() {
+    const int count = underruns.exchange(0);
+    if (profile == LatencyProfile::Low && count >= UNDERRUN_FALLBACK_COUNT) {
+        qDebug() << "Keyboard:" << count << "audio underruns, switching to the safe latency profile";
+        setLatencyProfile(LatencyProfile::Safe);
+        LoadDataManager::instance()->setLatencyProfile(latencyProfileToString(profile));
+        return;
+    }
+
+    const bool overloaded = count >= UNDERRUN_FALLBACK_COUNT || cpuLoad() > CPU_LOAD_LIMIT;
+    overloadedChecks = overloaded ? overloadedChecks + 1 : 0;
+    if (overloadedChecks < OVERLOAD_FALLBACK_CHECKS || quality == SynthQuality::Light
+            || engine == SoundEngine::Samples) {
+        return;
+    }
+
+    qDebug() << "Keyboard: synth overloaded at" << cpuLoad() << "% load, lowering the quality";
+    setSynthQuality(static_cast<SynthQuality>(static_cast<int>(quality) - 1));
+    LoadDataManager::instance()->setSynthQuality(synthQualityToString(quality));
+}
+
+/**
+ * @brief Gets the latency added by the driver's output buffers
+ * @return The latency in milliseconds
+ */
+double Keyboard::bufferLatencyMs() const {
+    int periods = 0;
+    int periodSize = 0;
+    fluid_settings_getint(settings, "audio.periods", &periods);
+    fluid_settings_getint(settings, "audio.period-size", &periodSize);
+    return periods * periodSize * 1000.0 / sampleRate;
+}
+
+/**
+ * @brief Estimates the key-to-sound latency from the events played so far
+ * @return Buffer latency plus the mean delay before an event was rendered,
+ *         in milliseconds, or -1 if no event has been rendered yet
+ */
+double Keyboard::estimatedLatencyMs() const {
+    const int count = renderDelayCount.load();
+    if (count == 0) {
+        return -1.0;
+    }
+    return bufferLatencyMs() + renderDelaySumNs.load() / 1e6 / count;
+}
+
+/**
+ * @brief Gets the best known key-to-sound latency
+ * @return The latency stored by the last estimateLatency(), else the live
+ *         estimate, else the buffer latency, in milliseconds
+ * @details The stored estimate is kept with the settings, so it also covers the
+ *          time before any note has been played in this session.
+ */
+double Keyboard::outputLatencyMs() const {
+    const double stored = LoadDataManager::instance()->getEstimatedLatency();
+    if (stored >= 0.0) {
+        return stored;
+    }
+    const double estimated = estimatedLatencyMs();
+    return estimated >= 0.0 ? estimated : bufferLatencyMs();
+}
+
+/**
+ * @brief Estimates the key-to-sound latency by playing a few quiet notes
+ * @param finished Called on the GUI thread with the estimated latency in
+ *                 milliseconds, or -1 if no note reached the audio callback
+ * @details Plays LATENCY_PROBE_NOTES notes at the lowest velocity and times how
+ *          long each one waits before the audio callback renders it. The driver's
+ *          buffering, computed from its period size and count, is added on top.
+ *          The time the sound card and speakers take after that is not included.
+ */
+void Keyboard::estimateLatency(std::function<void(double)> finished) {
+    renderDelaySumNs = 0;
+    renderDelayCount = 0;
+
+    for (int i = 0; i < LATENCY_PROBE_NOTES; ++i) {
+        QTimer::singleShot(i * LATENCY_PROBE_INTERVAL_MS, [this]() { playNote(LATENCY_PROBE_NOTE, 1); });
+        QTimer::singleShot(i * LATENCY_PROBE_INTERVAL_MS + LATENCY_PROBE_INTERVAL_MS / 2, [this]() { stopNote(LATENCY_PROBE_NOTE); });
+    }
+    QTimer::singleShot((LATENCY_PROBE_NOTES + 1) * LATENCY_PROBE_INTERVAL_MS, [this, finished]() {
+        finished(estimatedLatencyMs());
+    });
+}
+
 /**
  * @brief Plays a musical note using FluidSynth
  * @param note The MIDI note number to play (0-127)
- * @details Starts playing the specified note at maximum velocity.
+ * @param velocity Note-on velocity (0-127)
+ * @param time When to start it, from MidiEventQueue::now(); 0 starts it immediately
+ * @details Starts playing the specified note, at maximum velocity by default.
  *          The note will continue playing until stopNote is called.
  */
-void Keyboard::playNote(int note) {
-    if (!synth) return;
-
-    // Use a single lock for the entire operation
-    std::lock_guard<std::mutex> lock(mtx);
-    
-    // Play the note with maximum velocity (127)
-    fluid_synth_noteon(synth, 0, note, 127);
+void Keyboard::playNote(int note, int velocity, qint64 time) {
+    KEYQUEST_TRACE_SCOPE("Keyboard::playNote");
+    MidiEvent event;
+    event.type = MidiEvent::NoteOn;
+    event.key = static_cast<quint8>(std::clamp(note, 0, 127));
+    event.velocity = static_cast<quint8>(std::clamp(velocity, 0, 127));
+    event.time = time ? time : MidiEventQueue::now();
+    queueEvent(event);
 }
 
 /**
  * @brief Stops playing a musical note
  * @param note The MIDI note number to stop (0-127)
+ * @param time When to stop it, from MidiEventQueue::now(); 0 stops it immediately
  * @details Stops the specified note that was previously started with playNote.
  */
-void Keyboard::stopNote(int note) {
-    if (!synth) return;
+void Keyboard::stopNote(int note, qint64 time) {
+    MidiEvent event;
+    event.type = MidiEvent::NoteOff;
+    event.key = static_cast<quint8>(std::clamp(note, 0, 127));
+    event.time = time ? time : MidiEventQueue::now();
+    queueEvent(event);
+}
+
+/**
+ * @brief Queues an event for the audio callback
+ * @param event The event
+ */
+void Keyboard::queueEvent(const MidiEvent& event) {
+    if (!adriver) return;
+
+    if (!events.push(event)) {
+        qDebug() << "Keyboard: MIDI event queue full, dropping event for note" << int(event.key);
+    }
+}
 
-    // Use a single lock for the entire operation
-    std::lock_guard<std::mutex> lock(mtx);
-    
-    // Stop the note
-    fluid_synth_noteoff(synth, 0, note);
+/**
+ * @brief Queues an event from the MIDI input thread for the audio callback
+ * @param event The event, timestamped with MidiEventQueue::now()
+ * @return false if the queue is full and the event was dropped
+ * @details Never blocks or logs, since it runs on the MIDI driver's thread. The
+ *          driver pointer belongs to the GUI thread and is not read here: while it
+ *          is closed the event waits in the queue, and the first callback of the
+ *          next driver plays it at its first frame.
+ */
+bool Keyboard::queueExternalEvent(const MidiEvent& event) {
+    return externalEvents.push(event);
+}
+
+/**
+ * @brief Starts a sequence of scheduled notes
+ * @param channel MIDI channel the sequence plays on; a sequence still playing on it is cancelled
+ * @return ID of the sequence for scheduleNote() and cancelSequence()
+ */
+quint16 Keyboard::beginSequence(int channel) {
+    channel = std::clamp(channel, 0, CHANNEL_COUNT - 1);
+    if (channelSequences[channel]) {
+        cancelSequence(channelSequences[channel]);
+    }
+
+    const quint16 sequence = nextSequence;
+    nextSequence = nextSequence == 0xFFFF ? 1 : nextSequence + 1;
+    channelSequences[channel] = sequence;
+    return sequence;
+}
+
+/**
+ * @brief Schedules a note of a sequence
+ * @param sequence ID returned by beginSequence()
+ * @param note The MIDI note number
+ * @param velocity Note-on velocity (0-127)
+ * @param start When the note starts, from MidiEventQueue::now()
+ * @param end When the note stops, from MidiEventQueue::now()
+ */
+void Keyboard::scheduleNote(quint16 sequence, int note, int velocity, qint64 start, qint64 end) {
+    scheduleNoteOn(sequence, note, velocity, start);
+    scheduleNoteOff(sequence, note, std::max(end, start + 1));
+}
+
+/**
+ * @brief Schedules the start of a note of a sequence
+ * @param sequence ID returned by beginSequence()
+ * @param note The MIDI note number
+ * @param velocity Note-on velocity (0-127)
+ * @param time When the note starts, from MidiEventQueue::now()
+ */
+void Keyboard::scheduleNoteOn(quint16 sequence, int note, int velocity, qint64 time) {
+    MidiEvent event;
+    event.type = MidiEvent::NoteOn;
+    event.key = static_cast<quint8>(std::clamp(note, 0, 127));
+    event.velocity = static_cast<quint8>(std::clamp(velocity, 0, 127));
+    event.sequence = sequence;
+    event.time = time;
+    scheduleEvent(event);
+}
+
+/**
+ * @brief Schedules the end of a note of a sequence
+ * @param sequence ID returned by beginSequence()
+ * @param note The MIDI note number
+ * @param time When the note stops, from MidiEventQueue::now()
+ */
+void Keyboard::scheduleNoteOff(quint16 sequence, int note, qint64 time) {
+    MidiEvent event;
+    event.type = MidiEvent::NoteOff;
+    event.key = static_cast<quint8>(std::clamp(note, 0, 127));
+    event.sequence = sequence;
+    event.time = time;
+    scheduleEvent(event);
+}
+
+/**
+ * @brief Adds an event of a sequence to the pending events
+ * @param event The event; its channel is set from the sequence
+ * @details The event is inserted into pendingEvents in time order, behind
+ *          events due at the same time.
+ */
+void Keyboard::scheduleEvent(MidiEvent event) {
+    const int channel = sequenceChannel(event.sequence);
+    if (channel < 0 || !adriver) {
+        return;
+    }
+
+    event.channel = static_cast<quint8>(channel);
+    const auto byTime = [](qint64 time, const MidiEvent& pending) { return time < pending.time; };
+    pendingEvents.insert(std::upper_bound(pendingEvents.begin(), pendingEvents.end(), event.time, byTime), event);
+    feedSequencer();
+}
+
+/**
+ * @brief Cancels a sequence and silences its notes
+ * @param sequence ID returned by beginSequence()
+ * @details Events not handed over yet are removed. Those already in the queue are
+ *          dropped by the callback, which checks the channel's cancelled sequence,
+ *          and an all-notes-off on the channel ends the notes that are sounding.
+ */
+void Keyboard::cancelSequence(quint16 sequence) {
+    const int channel = sequenceChannel(sequence);
+    if (channel < 0) {
+        return;
+    }
+    channelSequences[channel] = 0;
+    pendingEvents.erase(std::remove_if(pendingEvents.begin(), pendingEvents.end(),
+                                       [sequence](const MidiEvent& event) { return event.sequence == sequence; }),
+                        pendingEvents.end());
+    cancelledSequences[channel].store(sequence, std::memory_order_release);
+
+    MidiEvent allNotesOff;
+    allNotesOff.type = MidiEvent::ControlChange;
+    allNotesOff.channel = static_cast<quint8>(channel);
+    allNotesOff.key = 123;
+    allNotesOff.time = MidiEventQueue::now();
+    queueEvent(allNotesOff);
+}
+
+/**
+ * @brief Finds the channel a sequence plays on
+ * @param sequence ID returned by beginSequence()
+ * @return The channel, or -1 if the sequence is not playing
+ */
+int Keyboard::sequenceChannel(quint16 sequence) const {
+    for (int channel = 0; sequence && channel < CHANNEL_COUNT; ++channel) {
+        if (channelSequences[channel] == sequence) {
+            return channel;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Hands the scheduled events due within the lookahead to the callback
+ * @details Runs every SEQUENCER_INTERVAL_MS while events are pending. Events
+ *          leave in time order, so the callback never waits behind a later one.
+ */
+void Keyboard::feedSequencer() {
+    const qint64 horizon = MidiEventQueue::now() + qint64(SEQUENCER_LOOKAHEAD_MS) * 1000000;
+    while (!pendingEvents.empty() && pendingEvents.front().time <= horizon) {
+        if (!scheduledEvents.push(pendingEvents.front())) {
+            break;  // Full; try again on the next tick
+        }
+        pendingEvents.pop_front();
+    }
+
+    if (pendingEvents.empty()) {
+        sequencerTimer->stop();
+    } else if (!sequencerTimer->isActive()) {
+        sequencerTimer->start();
+    }
+}
+
+/**
+ * @brief Picks the queue whose front event is due first
+ * @return The queue, or nullptr if all are empty
+ * @details On equal times live notes go first.
+ */
+MidiEventQueue* Keyboard::nextEventQueue() {
+    MidiEventQueue* next = nullptr;
+    const MidiEvent* first = nullptr;
+    for (MidiEventQueue* queue : {&events, &externalEvents, &scheduledEvents}) {
+        const MidiEvent* event = queue->peek();
+        if (event && (!first || event->time < first->time)) {
+            first = event;
+            next = queue;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Audio driver callback: applies queued events and renders one block
+ * @param data The Keyboard
+ * @param len Number of frames to render
+ * @param nfx Number of effect buffers
+ * @param fx Effect buffers
+ * @param nout Number of output buffers
+ * @param out Output buffers
+ * @return FLUID_OK, or FLUID_FAILED if rendering failed
+ * @details Runs on the audio thread. Events due before this block are applied at
+ *          its first frame; events due inside it are applied at the frame their
+ *          timestamp falls on, by rendering the block in pieces. Events due after
+ *          it stay queued, together with everything queued behind them. The GUI,
+ *          MIDI input and sequencer queues are merged by timestamp, and events of
+ *          cancelled sequences are dropped. With the Samples engine and a bank
+ *          ready, the events go to the sampler and the block is mixed from it.
+ */
+int Keyboard::audioCallback(void* data, int len, int nfx, float* fx[], int nout, float* out[]) {
+    Keyboard* self = static_cast<Keyboard*>(data);
+
+    // fluid_synth_process() mixes into the buffers, so start from silence
+    for (int i = 0; i < nout; ++i) {
+        std::fill_n(out[i], len, 0.0f);
+    }
+    for (int i = 0; i < nfx; ++i) {
+        std::fill_n(fx[i], len, 0.0f);
+    }
+
+    // Drivers pass no effect buffers; point them at the output so reverb and chorus are heard
+    float* wetFx[EFFECT_BUFFERS];
+    if (nfx == 0 && nout >= 2 && self->effectsActive.load(std::memory_order_acquire)) {
+        for (int i = 0; i < EFFECT_BUFFERS; ++i) {
+            wetFx[i] = out[i % 2];
+        }
+        fx = wetFx;
+        nfx = EFFECT_BUFFERS;
+    }
+
+    // Switching engines cuts off what the other one was playing
+    const bool samples = self->samplesEngine.load(std::memory_order_acquire) && self->sampler.prepare();
+    if (samples != self->samplesActive) {
+        if (samples && self->soundFontReady.load(std::memory_order_acquire)) {
+            fluid_synth_all_sounds_off(self->synth, -1);
+        } else if (!samples) {
+            self->sampler.stopAll();
+        }
+        self->samplesActive = samples;
+    }
+
+    // Stay silent and leave the synth alone while the SoundFont is being loaded
+    if (!samples && !self->soundFontReady.load(std::memory_order_acquire)) {
+        while (MidiEventQueue* queue = self->nextEventQueue()) {
+            queue->pop();
+        }
+        return FLUID_OK;
+    }
+
+    const qint64 blockStart = MidiEventQueue::now();
+    const double framesPerNs = self->sampleRate / 1e9;
+    int rendered = 0;
+
+    // A callback that comes more than two blocks after the last one means the output ran dry
+    if (self->lastCallbackTime > 0 && blockStart - self->lastCallbackTime > 2 * len / framesPerNs) {
+        self->underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    self->lastCallbackTime = blockStart;
+
+    while (MidiEventQueue* queue = self->nextEventQueue()) {
+        const MidiEvent* event = queue->peek();
+
+        // Notes of a cancelled sequence that were already handed over
+        if (event->sequence
+                && event->sequence == self->cancelledSequences[event->channel].load(std::memory_order_acquire)) {
+            queue->pop();
+            continue;
+        }
+
+        int frame = 0;
+        if (event->time > blockStart) {
+            frame = static_cast<int>((event->time - blockStart) * framesPerNs);
+            if (frame >= len) {
+                break;
+            }
+        }
+
+        if (frame > rendered) {
+            if (self->render(rendered, frame, nfx, fx, nout, out) != FLUID_OK) {
+                return FLUID_FAILED;
+            }
+            rendered = frame;
+        }
+
+        // How long the event waited for this block, for latency estimates; sequences are played on time
+        const qint64 playedAt = blockStart + static_cast<qint64>(frame / framesPerNs);
+        if (event->sequence == 0) {
+            if (event->time > 0 && playedAt > event->time) {
+                self->renderDelaySumNs.fetch_add(playedAt - event->time, std::memory_order_relaxed);
+            }
+            self->renderDelayCount.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (samples) {
+            switch (event->type) {
+            case MidiEvent::NoteOn:
+                self->sampler.noteOn(event->channel, event->key, event->velocity);
+                break;
+            case MidiEvent::NoteOff:
+                self->sampler.noteOff(event->channel, event->key);
+                break;
+            case MidiEvent::ControlChange:
+                self->sampler.controlChange(event->channel, event->key, event->velocity);
+                break;
+            }
+        } else {
+            switch (event->type) {
+            case MidiEvent::NoteOn:
+                fluid_synth_noteon(self->synth, event->channel, event->key, event->velocity);
+                break;
+            case MidiEvent::NoteOff:
+                fluid_synth_noteoff(self->synth, event->channel, event->key);
+                break;
+            case MidiEvent::ControlChange:
+                fluid_synth_cc(self->synth, event->channel, event->key, event->velocity);
+                break;
+            }
+        }
+
+        // Live notes go to the recorder; a full queue drops the note rather than wait
+        if (event->sequence == 0 && event->channel == 0 && event->type != MidiEvent::ControlChange
+                && self->recording.load(std::memory_order_acquire)) {
+            MidiEvent played = *event;
+            played.time = event->time > 0 ? event->time : playedAt;
+            self->recordedEvents.push(played);
+        }
+        queue->pop();
+    }
+
+    return self->render(rendered, len, nfx, fx, nout, out);
+}
+
+/**
+ * @brief Renders frames [begin, end) of the current block
+ * @param begin First frame
+ * @param end One past the last frame
+ * @param nfx Number of effect buffers
+ * @param fx Effect buffers
+ * @param nout Number of output buffers
+ * @param out Output buffers
+ * @return FLUID_OK, or FLUID_FAILED if rendering failed
+ */
+int Keyboard::render(int begin, int end, int nfx, float* fx[], int nout, float* out[]) {
+    if (begin >= end) {
+        return FLUID_OK;
+    }
+    if (samplesActive) {
+        if (nout > 0) {
+            sampler.mix(out[0] + begin, nout > 1 ? out[1] + begin : nullptr, end - begin);
+        }
+        return FLUID_OK;
+    }
+    if (begin == 0) {
+        return fluid_synth_process(synth, end, nfx, fx, nout, out);
+    }
+
+    // Point at the unrendered tail of each buffer
+    constexpr int MAX_BUFFERS = 16;
+    float* fxTail[MAX_BUFFERS];
+    float* outTail[MAX_BUFFERS];
+    nfx = std::min(nfx, MAX_BUFFERS);
+    nout = std::min(nout, MAX_BUFFERS);
+    for (int i = 0; i < nfx; ++i) {
+        fxTail[i] = fx[i] + begin;
+    }
+    for (int i = 0; i < nout; ++i) {
+        outTail[i] = out[i] + begin;
+    }
+    return fluid_synth_process(synth, end - begin, nfx, fxTail, nout, outTail);
 }
@@ -13,17 +13,140 @@
 
 #include <QtCore/QObject>
 #include <QMap>
+#include <QString>
+#include <QTimer>
 #include <fluidsynth.h>
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <mutex>
+#include "midieventqueue.h"
+#include "notesampler.h"
+#include "soundfontloader.h"
 
 /**
  * @brief Class managing keyboard input and MIDI note mapping
  * 
  * Handles keyboard input events and maps them to MIDI note numbers
  * for the piano interface
+ *
+ * Note events never call into FluidSynth from the GUI thread. They are pushed
+ * onto a lock-free queue that the audio driver callback drains before rendering
+ * each block, so pressing a key cannot block on the synthesizer's locks. Each
+ * event is rendered at the sample offset in the block that its timestamp falls
+ * on, so events can also be scheduled ahead of time.
+ *
+ * Notes from an external MIDI keyboard arrive on the MIDI driver's thread and
+ * go through a second queue of the same kind (see MidiInput), so they never wait
+ * for the GUI thread. The callback merges both queues in timestamp order.
+ *
+ * Notes scheduled further ahead, such as a played-back prompt or a metronome,
+ * go through a small sequencer instead: beginSequence() opens a sequence on a
+ * channel of its own and scheduleNote() adds notes to it. The sequencer keeps
+ * the events on the GUI thread and hands them to the callback through a third
+ * queue a short lookahead before they are due, so they never hold up live
+ * notes behind them, and cancelSequence() can still silence them at once.
+ *
+ * While recording is on, the callback copies every live note it applies into a
+ * fourth queue, in the order it applied them, for PerformanceRecorder to drain
+ * on a thread of its own. Recording therefore adds nothing to playNote().
+ *
+ * The audio backend and its buffering follow the latency profile chosen in the
+ * settings. The low-latency profile falls back to the safe one by itself when the
+ * callback keeps arriving late (buffer underruns).
+ *
+ * How much the synthesizer does follows the synth quality chosen in the
+ * settings: the number of voices, reverb and chorus, and the number of threads
+ * rendering them. When the polyphony is used up, FluidSynth steals released
+ * voices first, then the quietest and oldest ones, so held notes of a chord keep
+ * sounding. If the callback keeps running late at the safe profile, or the synth
+ * needs more than CPU_LOAD_LIMIT percent of the time of a block, the quality
+ * steps down by itself, the same way the latency profile does.
+ *
+ * For computers too slow for any quality, the Samples sound engine plays the
+ * notes of the active key range from a NoteSampler instead. The notes are
+ * pre-rendered once on a worker thread, or read back from the disk cache, and
+ * the callback then only mixes samples and never runs the synthesizer. Until the
+ * samples are ready the synthesizer keeps playing if its SoundFont is loaded.
+ * When the Samples engine is chosen at startup the SoundFont is not loaded into
+ * the live synthesizer at all, which also saves its memory.
  */
 class Keyboard {
 public:
+    /**
+     * @brief Audio buffering profile
+     */
+    enum class LatencyProfile {
+        Safe,  ///< Default backend with 8 periods of 256 frames (about 46 ms)
+        Low    ///< JACK/ALSA, WASAPI exclusive or CoreAudio with 2 periods of 128 frames (about 6 ms)
+    };
+
+    /**
+     * @brief Synthesis quality tier
+     */
+    enum class SynthQuality {
+        Light,     ///< 48 voices without effects, for slow computers
+        Standard,  ///< 128 voices without effects
+        Rich       ///< 256 voices with reverb and chorus, rendered on up to MAX_RENDER_THREADS cores
+    };
+
+    /**
+     * @brief Where the sound of the notes comes from
+     */
+    enum class SoundEngine {
+        Synth,   ///< FluidSynth renders every note live
+        Samples  ///< Notes of the key range are pre-rendered and mixed from memory
+    };
+
+    static constexpr int MAX_RENDER_THREADS = 4;  ///< Most cores the Rich quality renders on
+    static constexpr double CPU_LOAD_LIMIT = 80.0; ///< Synth load, in percent of real time, that steps the quality down
+
+    static constexpr int PROMPT_CHANNEL = 1;  ///< MIDI channel of prompt playback
+    static constexpr int CLICK_CHANNEL = 2;   ///< MIDI channel of metronome clicks
+    static constexpr int PLAYBACK_CHANNEL = 3; ///< MIDI channel of recorded performances played back
+
+    /**
+     * @brief Converts a stored profile name to a profile
+     * @param name "safe" or "low"
+     * @return The profile; Safe for unknown names
+     */
+    static LatencyProfile latencyProfileFromString(const QString& name);
+
+    /**
+     * @brief Converts a profile to the name it is stored under
+     * @param profile The profile
+     * @return "safe" or "low"
+     */
+    static QString latencyProfileToString(LatencyProfile profile);
+
+    /**
+     * @brief Converts a stored quality name to a quality
+     * @param name "light", "standard" or "rich"
+     * @return The quality; Standard for unknown names
+     */
+    static SynthQuality synthQualityFromString(const QString& name);
+
+    /**
+     * @brief Converts a quality to the name it is stored under
+     * @param quality The quality
+     * @return "light", "standard" or "rich"
+     */
+    static QString synthQualityToString(SynthQuality quality);
+
+    /**
+     * @brief Converts a stored engine name to an engine
+     * @param name "synth" or "samples"
+     * @return The engine; Synth for unknown names
+     */
+    static SoundEngine soundEngineFromString(const QString& name);
+
+    /**
+     * @brief Converts an engine to the name it is stored under
+     * @param engine The engine
+     * @return "synth" or "samples"
+     */
+    static QString soundEngineToString(SoundEngine engine);
+
     /**
      * @brief Constructs a new Keyboard object
      */
@@ -44,20 +167,379 @@ public:
     /**
      * @brief Plays a note using FluidSynth
      * @param note The MIDI note number to play
+     * @param velocity Note-on velocity (0-127)
+     * @param time When to start it, from MidiEventQueue::now(); 0 starts it immediately
      */
-    void playNote(int note);
+    void playNote(int note, int velocity = 127, qint64 time = 0);
 
     /**
      * @brief Stops playing a note
      * @param note The MIDI note number to stop
+     * @param time When to stop it, from MidiEventQueue::now(); 0 stops it immediately
+     */
+    void stopNote(int note, qint64 time = 0);
+
+    /**
+     * @brief Queues an event from the MIDI input thread for the audio callback
+     * @param event The event, timestamped with MidiEventQueue::now()
+     * @return false if the queue is full and the event was dropped
+     * @details Must only be called from the one MIDI input thread; the GUI thread
+     *          uses playNote() and stopNote(). The event is queued even while the
+     *          audio driver is closed, and the first callback after resumeAudio()
+     *          plays it.
+     */
+    bool queueExternalEvent(const MidiEvent& event);
+
+    /**
+     * @brief Starts a sequence of scheduled notes
+     * @param channel MIDI channel the sequence plays on, e.g. PROMPT_CHANNEL; a
+     *                sequence still playing on it is cancelled
+     * @return ID of the sequence for scheduleNote() and cancelSequence()
+     */
+    quint16 beginSequence(int channel);
+
+    /**
+     * @brief Schedules a note of a sequence
+     * @param sequence ID returned by beginSequence()
+     * @param note The MIDI note number
+     * @param velocity Note-on velocity (0-127)
+     * @param start When the note starts, from MidiEventQueue::now()
+     * @param end When the note stops, from MidiEventQueue::now()
+     * @details Does nothing if the sequence has been cancelled. Notes should be
+     *          scheduled at least SEQUENCER_LOOKAHEAD_MS ahead; earlier ones can
+     *          be delayed by notes of other sequences that were queued before them.
+     */
+    void scheduleNote(quint16 sequence, int note, int velocity, qint64 start, qint64 end);
+
+    /**
+     * @brief Schedules the start of a note of a sequence
+     * @param sequence ID returned by beginSequence()
+     * @param note The MIDI note number
+     * @param velocity Note-on velocity (0-127)
+     * @param time When the note starts, from MidiEventQueue::now()
+     * @details For notes whose end is not known yet; see scheduleNote().
+     */
+    void scheduleNoteOn(quint16 sequence, int note, int velocity, qint64 time);
+
+    /**
+     * @brief Schedules the end of a note of a sequence
+     * @param sequence ID returned by beginSequence()
+     * @param note The MIDI note number
+     * @param time When the note stops, from MidiEventQueue::now()
+     */
+    void scheduleNoteOff(quint16 sequence, int note, qint64 time);
+
+    /**
+     * @brief Cancels a sequence and silences its notes
+     * @param sequence ID returned by beginSequence()
+     * @details Notes already handed to the audio callback are dropped there, so
+     *          nothing of the sequence sounds after the current audio block.
+     */
+    void cancelSequence(quint16 sequence);
+
+    /**
+     * @brief Starts or stops copying live notes to the record queue
+     * @param on Whether to record
+     * @details The callback reads the flag for every event, so a note in flight
+     *          when recording stops may still be copied.
+     */
+    void setRecording(bool on) { recording.store(on, std::memory_order_release); }
+
+    /**
+     * @brief Gets the queue of recorded notes
+     * @return The queue; the one recording thread is its consumer
+     * @details Holds the live note-on and note-off events of channel 0 in the
+     *          order they were played, with the time they were queued at.
+     */
+    MidiEventQueue& recordQueue() { return recordedEvents; }
+
+    /**
+     * @brief Gets the active latency profile
+     * @return The profile
+     */
+    LatencyProfile latencyProfile() const { return profile; }
+
+    /**
+     * @brief Switches the audio driver to another latency profile
+     * @param newProfile The profile
+     * @details Restarts the audio driver, which cuts off any sounding notes.
+     */
+    void setLatencyProfile(LatencyProfile newProfile);
+
+    /**
+     * @brief Gets the active synth quality
+     * @return The quality
+     */
+    SynthQuality synthQuality() const { return quality; }
+
+    /**
+     * @brief Switches the synthesizer to another quality
+     * @param newQuality The quality
+     * @details Polyphony and effects change at once; voices beyond a lower limit
+     *          are stolen. The number of rendering threads is fixed when the synth
+     *          is created, so it follows from the next start.
+     */
+    void setSynthQuality(SynthQuality newQuality);
+
+    /**
+     * @brief Gets the load of the synthesizer
+     * @return Time spent rendering, in percent of the time the audio lasts
+     */
+    double cpuLoad() const;
+
+    /**
+     * @brief Gets the number of threads rendering the synthesizer
+     * @return The synth.cpu-cores the synth was created with
+     */
+    int renderThreads() const;
+
+    /**
+     * @brief Gets the active sound engine
+     * @return The engine
+     */
+    SoundEngine soundEngine() const { return engine; }
+
+    /**
+     * @brief Switches to another sound engine
+     * @param newEngine The engine
+     * @details Switching to Samples renders the notes of the key range in the
+     *          background first; switching to Synth loads the SoundFont if it is
+     *          not loaded yet. Sounding notes are cut off when the callback switches.
      */
-    void stopNote(int note);
+    void setSoundEngine(SoundEngine newEngine);
+
+    /**
+     * @brief Sets the notes the Samples engine can play
+     * @param firstNote Lowest note
+     * @param lastNote Highest note
+     * @details Renders the new range in the background while the Samples engine is
+     *          active; the old range keeps playing until it is ready.
+     */
+    void setSampleRange(int firstNote, int lastNote);
+
+    /**
+     * @brief Checks whether the samples of the key range are ready
+     * @return true once the Samples engine can play the current range
+     */
+    bool samplesReady() const { return sampleBankReady; }
+
+    /**
+     * @brief Gets the memory the sound of the notes holds
+     * @return Bytes of the SoundFont loaded into the synthesizer plus the samples
+     *         of the Samples engine
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief Gets the latency added by the driver's output buffers
+     * @return The latency in milliseconds
+     */
+    double bufferLatencyMs() const;
+
+    /**
+     * @brief Estimates the key-to-sound latency from the events played so far
+     * @return Buffer latency plus the mean delay before an event was rendered,
+     *         in milliseconds, or -1 if no event has been rendered yet
+     */
+    double estimatedLatencyMs() const;
+
+    /**
+     * @brief Gets the best known key-to-sound latency
+     * @return The latency stored by the last estimateLatency(), else the live
+     *         estimate, else the buffer latency, in milliseconds
+     */
+    double outputLatencyMs() const;
+
+    /**
+     * @brief Estimates the key-to-sound latency by playing a few quiet notes
+     * @param finished Called on the GUI thread with the estimated latency in
+     *                 milliseconds, or -1 if no note reached the audio callback
+     * @details An estimate, not a measurement of the sound: it covers the wait for
+     *          the audio callback and the driver's buffers, but not the sound card
+     *          and speakers, which KeyQuest cannot observe.
+     */
+    void estimateLatency(std::function<void(double)> finished);
+
+    /**
+     * @brief Gets the loader of the piano SoundFont
+     * @return The loader; its finished() signal reports when notes become audible
+     */
+    SoundFontLoader* soundFontLoader() const { return loader; }
+
+    /**
+     * @brief Checks whether the SoundFont has been loaded
+     * @return true once notes are audible, from the SoundFont or the samples
+     */
+    bool isReady() const { return soundFontReady || (engine == SoundEngine::Samples && sampleBankReady); }
+
+    /**
+     * @brief Closes the audio driver while nothing is being played
+     * @details The synthesizer, its SoundFont and the samples are kept, so
+     *          resumeAudio() only has to open the driver again. Sounding notes are
+     *          cut off and the underrun checks stop until then.
+     */
+    void suspendAudio();
+
+    /**
+     * @brief Opens the audio driver again after suspendAudio()
+     * @details Takes a few milliseconds. Notes queued in the meantime are played by
+     *          the first callback.
+     */
+    void resumeAudio();
+
+    /**
+     * @brief Checks whether the audio driver is closed by suspendAudio()
+     * @return true while suspended
+     * @details Safe to call from the MIDI input thread.
+     */
+    bool isAudioSuspended() const { return audioSuspended.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Checks whether something would be cut off by suspendAudio()
+     * @return true while scheduled notes are pending or notes are recorded
+     */
+    bool isBusy() const { return !pendingEvents.empty() || recording.load(std::memory_order_relaxed); }
 
 private:
-    fluid_settings_t* settings;
-    fluid_synth_t* synth;
-    fluid_audio_driver_t* adriver;
-    std::mutex mtx;
+    static const int UNDERRUN_CHECK_MS = 1000;     // How often underruns are checked
+    static const int UNDERRUN_FALLBACK_COUNT = 3;  // Underruns per check that switch to Safe
+    static const int LATENCY_PROBE_NOTES = 8;        // Notes played by estimateLatency
+    static const int LATENCY_PROBE_NOTE = 60;        // MIDI note used by estimateLatency
+    static const int LATENCY_PROBE_INTERVAL_MS = 120; // Time between those notes
+    static const int SEQUENCER_LOOKAHEAD_MS = 100; // How early scheduled notes are handed to the callback
+    static const int SEQUENCER_INTERVAL_MS = 20;   // How often the sequencer hands them over
+    static const int CHANNEL_COUNT = 16;           // MIDI channels of the synthesizer
+    static const int OVERLOAD_FALLBACK_CHECKS = 3; // Overloaded checks in a row that lower the quality
+    static const int EFFECT_BUFFERS = 4;           // Reverb and chorus, stereo
+
+    /**
+     * @brief Creates the audio driver for the current latency profile
+     * @return true if a driver was created
+     * @details Tries the backends of the profile in order of preference.
+     */
+    bool startAudioDriver();
+
+    /**
+     * @brief Falls back to the safe profile or a lower quality if the callback ran late too often
+     */
+    void checkUnderruns();
+
+    /**
+     * @brief Applies the polyphony and effects of the current quality to the synth
+     */
+    void applySynthQuality();
+
+    /**
+     * @brief Starts rendering the samples of the key range in the background
+     * @details Does nothing if they are ready. A render already running picks the
+     *          new range up instead of a second one starting.
+     */
+    void buildSamples();
+
+    /**
+     * @brief Renders key ranges until the latest one is done; runs on the worker thread
+     */
+    void buildSampleBanks();
+
+    /**
+     * @brief Queues an event for the audio callback
+     * @param event The event
+     */
+    void queueEvent(const MidiEvent& event);
+
+    /**
+     * @brief Adds an event of a sequence to the pending events
+     * @param event The event; its channel is set from the sequence
+     */
+    void scheduleEvent(MidiEvent event);
+
+    /**
+     * @brief Hands the scheduled events due within the lookahead to the callback
+     */
+    void feedSequencer();
+
+    /**
+     * @brief Finds the channel a sequence plays on
+     * @param sequence ID returned by beginSequence()
+     * @return The channel, or -1 if the sequence is not playing
+     */
+    int sequenceChannel(quint16 sequence) const;
+
+    /**
+     * @brief Audio driver callback: applies queued events and renders one block
+     * @param data The Keyboard
+     * @param len Number of frames to render
+     * @param nfx Number of effect buffers
+     * @param fx Effect buffers
+     * @param nout Number of output buffers
+     * @param out Output buffers
+     * @return FLUID_OK, or FLUID_FAILED if rendering failed
+     */
+    static int audioCallback(void* data, int len, int nfx, float* fx[], int nout, float* out[]);
+
+    /**
+     * @brief Renders frames [begin, end) of the current block
+     * @param begin First frame
+     * @param end One past the last frame
+     * @param nfx Number of effect buffers
+     * @param fx Effect buffers
+     * @param nout Number of output buffers
+     * @param out Output buffers
+     * @return FLUID_OK, or FLUID_FAILED if rendering failed
+     */
+    int render(int begin, int end, int nfx, float* fx[], int nout, float* out[]);
+
+    /**
+     * @brief Picks the queue whose front event is due first
+     * @return The queue, or nullptr if all are empty
+     * @details Audio thread only.
+     */
+    MidiEventQueue* nextEventQueue();
+
+    fluid_settings_t* settings = nullptr;
+    fluid_synth_t* synth = nullptr;
+    fluid_audio_driver_t* adriver = nullptr;
+    std::atomic<bool> audioSuspended{false};  // Whether suspendAudio() closed the driver
+    double sampleRate = 44100.0;
+    MidiEventQueue events;  // GUI thread to audio callback
+    MidiEventQueue externalEvents;  // MIDI input thread to audio callback
+    MidiEventQueue scheduledEvents;  // Sequencer to audio callback
+    MidiEventQueue recordedEvents;  // Audio callback to the recording thread
+    std::atomic<bool> recording{false};  // Whether live notes are copied to recordedEvents
+    std::deque<MidiEvent> pendingEvents;  // Scheduled events not yet handed over, by time
+    QTimer* sequencerTimer = nullptr;     // Hands pendingEvents over while there are any
+    quint16 nextSequence = 1;             // ID of the next sequence
+    quint16 channelSequences[CHANNEL_COUNT] = {};  // Sequence playing on each channel, 0 if none
+    std::atomic<quint16> cancelledSequences[CHANNEL_COUNT] = {};  // Last sequence cancelled on each channel
+    LatencyProfile profile = LatencyProfile::Safe;
+    SynthQuality quality = SynthQuality::Standard;
+    std::atomic<bool> effectsActive{false};  // Whether the callback mixes reverb and chorus into the output
+    int overloadedChecks = 0;               // Underrun checks in a row that found the synth overloaded
+    QTimer* underrunTimer = nullptr;
+    SoundFontLoader* loader = nullptr;     // Loads piano.sf2 in the background
+    std::atomic<bool> soundFontReady{false}; // Set once the SoundFont is loaded
+    qint64 soundFontBytes = 0;               // Size of the loaded SoundFont, 0 until it is loaded
+    SoundEngine engine = SoundEngine::Synth;
+    std::atomic<bool> samplesEngine{false};   // engine == Samples, for the callback
+    NoteSampler sampler;                      // Plays the pre-rendered notes
+    std::mutex sampleMutex;                   // Guards the range and the state of the render below
+    int sampleFirstNote = 60;                 // Range the samples should cover
+    int sampleLastNote = 72;
+    int sampleBuiltFirst = -1;                // Range of the samples last published
+    int sampleBuiltLast = -1;
+    quint32 sampleGeneration = 0;             // Counts range requests, so a render sees it is stale
+    std::atomic<quint32> sampleRequested{0};  // sampleGeneration, readable without the lock
+    bool sampleBuilding = false;              // Whether the render thread is running
+    std::atomic<bool> sampleStopping{false};  // Set by the destructor to end the render
+    std::atomic<bool> sampleBankReady{false}; // Set once samples of the current range are published
+    QThread* sampleBuilder = nullptr;         // Renders the samples
+
+    // Written by the audio callback
+    bool samplesActive = false;               // Whether the current block comes from the sampler
+    qint64 lastCallbackTime = 0;              // Start of the previous callback
+    std::atomic<int> underruns{0};            // Late callbacks since the last check
+    std::atomic<qint64> renderDelaySumNs{0};  // Total delay from queueing to rendering
+    std::atomic<int> renderDelayCount{0};     // Events included in renderDelaySumNs
 };
 
 #endif // KEYBOARD_H
@@ -16,6 +16,7 @@
  */
 LessonsbackgroundPage::LessonsbackgroundPage(QWidget *parent)
     : QWidget(parent)
+    , m_background(":/lessons/lessonsImages/lessonsBackground.png")
 {
     // Enable widget to receive mouse and keyboard events directly
     setFocusPolicy(Qt::StrongFocus);
@@ -25,31 +26,29 @@ LessonsbackgroundPage::LessonsbackgroundPage(QWidget *parent)
  * @brief Handles the painting of the lessons background page
  * @param event The paint event that triggered this function
  * @details This method draws the custom background image for the lessons section.
- *          It scales the background to fill the widget while maintaining aspect ratio
- *          and centers the image within the widget.
+ *          The image is scaled to fill the widget while maintaining aspect ratio and
+ *          centered within the widget. Scaling only happens after a resize, so an
+ *          ordinary repaint just blits the cached copy.
  */
 void LessonsbackgroundPage::paintEvent(QPaintEvent *event)
 {
-    // Handle the base widget painting first
+    // Handle the base widget painting first (for stylesheet support)
     QStyleOption opt;
     opt.initFrom(this);
     QPainter p(this);
     style()->drawPrimitive(QStyle::PE_Widget, &opt, &p, this);
 
     // draws custom background
-    QPixmap background(":/lessons/lessonsImages/lessonsBackground.png");
-    if (!background.isNull()) {
-        // Get the widget size
-        QSize widgetSize = size();
-
-        // Scale the background to fill the entire widget while maintaining aspect ratio
-        QSize scaledSize = background.size().scaled(widgetSize, Qt::KeepAspectRatioByExpanding);
-
-        // Calculate position to center the image
-        int x = (widgetSize.width() - scaledSize.width()) / 2;
-        int y = (widgetSize.height() - scaledSize.height()) / 2;
+    m_background.paint(p, this);
+}
 
-        // Draw the background
-        p.drawPixmap(x, y, scaledSize.width(), scaledSize.height(), background);
-    }
+/**
+ * @brief Handles resizing of the lessons background page
+ * @param event The resize event that triggered this function
+ * @details Drops the scaled background so it is rebuilt for the new size.
+ */
+void LessonsbackgroundPage::resizeEvent(QResizeEvent *event)
+{
+    m_background.invalidate();
+    QWidget::resizeEvent(event);
 }
@@ -14,6 +14,7 @@
 #include <QWidget>
 #include <QPainter>
 #include <QStyleOption>
+#include "backgroundrenderer.h"
 
 /**
  * @brief Widget class for displaying the lessons background page
@@ -36,6 +37,15 @@ protected:
      * @param event The paint event
      */
     void paintEvent(QPaintEvent *event) override;
+
+    /**
+     * @brief Handles resize events for the widget
+     * @param event The resize event
+     */
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    BackgroundRenderer m_background;  ///< Cached, pre-scaled background image
 };
 
 #endif // LESSONSBACKGROUNDPAGE_H
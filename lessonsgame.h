@@ -13,57 +13,42 @@
 
 #include <QtCore/QString>
 #include <QtCore/QObject>
-#include <QJsonDocument>
-#include <QtCore/QJsonObject>
-#include <QtCore/QJsonArray>
-#include <QVector>
-
-/**
- * @brief Structure representing a game question
- */
-struct QuestionLesson {
-    int questionID;
-    QString title;
-    QString description;
-    QString expectedInput;
-};
+#include "gamesession.h"
+#include "rhythmengine.h"
 
 /**
  * @brief Class managing the lessons game logic
  * 
- * Handles game state, question management, scoring, and accuracy tracking
- * for the lessons mode of the application
+ * Asks every question of a topic once in shuffled order and tracks the
+ * score and accuracy of a single player. The question loop and answer
+ * matching are provided by GameSession. Attempts submitted with
+ * timedAttempt() must also pass on timing, which the Rhythm/Melody lesson
+ * measures with a RhythmEngine.
  */
-class Lessonsgame: public QObject
+class Lessonsgame: public GameSession
 {
     Q_OBJECT
 public:
-    // Topic IDs
-    static const int GENERAL_TOPIC_ID = 101;
-    static const int MAJOR_MINOR_CHORDS_TOPIC_ID = 102;
-    static const int TRIAD_TOPIC_ID = 103;
-    static const int MAJOR_SCALE_ID = 104;
-    static const int PERFECT_ID = 105;
-    static const int MELODY_ID = 106;
-
     /**
      * @brief Constructs a new Lessonsgame object
      * @param parent The parent QObject
      * @param topicID The ID of the game topic to load
+     * @param seed Seed of the session's question order; replaying a seed replays the order
+     * @param questionBank Question bank the topic is taken from; must outlive the game
      */
-    explicit Lessonsgame(QObject *parent = nullptr, int topicID = GENERAL_TOPIC_ID);
+    explicit Lessonsgame(QObject *parent = nullptr, int topicID = GENERAL_TOPIC_ID,
+                         quint64 seed = SessionRng::randomSeed(),
+                         const QuestionBank& questionBank = *QuestionBank::instance());
     ~Lessonsgame();
 
     /**
-     * @brief Starts a new round of the game
-     */
-    void startNewRound();
-
-    /**
-     * @brief Processes a player's attempt at answering
-     * @param playedPattern The player's input attempt
+     * @brief Prepares the game for a new session in place
+     * @param topicID The ID of the game topic to load
+     * @param seed Seed of the new session's question order
+     * @details Clears the score and accuracy and deals the topic again. The first
+     *          question is asked by start().
      */
-    void playerAttempt(const QString& playedPattern);
+    void reset(int topicID, quint64 seed = SessionRng::randomSeed());
 
     /**
      * @brief Gets the current player's score
@@ -71,24 +56,6 @@ public:
      */
     int getPlayerScore() const;
 
-    /**
-     * @brief Gets the current pattern to be played
-     * @return QString The current pattern string
-     */
-    QString getCurrentPattern() const;
-
-    /**
-     * @brief Gets the current question description
-     * @return QString The current question description
-     */
-    QString getCurrentDescription() const;
-
-    /**
-     * @brief Checks if the game has ended
-     * @return bool true if the game is over, false otherwise
-     */
-    bool isGameOver() const;
-
     /**
      * @brief Gets the current accuracy percentage
      * @return double The accuracy as a percentage (0-100)
@@ -101,7 +68,13 @@ public:
      */
     int getTotalAttempts() const;
 
-    int noteNameToValue(const QString& noteName);
+    /**
+     * @brief Answers the current question with notes and their timing
+     * @param playedNotes The notes played during the pattern
+     * @param rhythm The timing of the onsets
+     * @return bool true if both the notes and the timing are correct
+     */
+    bool timedAttempt(const NoteSet& playedNotes, const RhythmResult& rhythm);
 
 signals:
     /**
@@ -120,47 +93,36 @@ signals:
      */
     void gameOver(int playerScore, double accuracy);
 
+protected:
     /**
-     * @brief Signal emitted for key highlighting feedback
-     * @param isCorrect True if the answer was correct, false otherwise
-     */
-    void highlightKeys(bool isCorrect);
-
-private:
-    /**
-     * @brief Loads questions from the question bank
-     * @param topicID The ID of the topic to load questions for
+     * @brief Scores an attempt; every attempt moves on to the next question
+     * @param correct Whether the attempt was correct
+     * @return bool Always true
      */
-    void loadQuestions(int topicID);
+    bool scoreAttempt(bool correct) override;
 
     /**
-     * @brief Randomly shuffles the order of questions
+     * @brief Checks the notes and, for a timed attempt, the timing
+     * @param playedNotes The notes played by the player
+     * @return bool true if the attempt is correct
      */
-    void shuffleQuestions();
+    bool judgeAttempt(const NoteSet& playedNotes) const override;
 
     /**
-     * @brief Compares two chords for equality
-     * @param chord1 First chord string
-     * @param chord2 Second chord string
-     * @return true if chords contain the same notes, false otherwise
+     * @brief Emits updateUI for the current question
      */
-    bool areChordsSame(const QString& chord1, const QString& chord2);
+    void showQuestion() override;
 
     /**
-     * @brief Advances to the next question
-     * @details Increments the question index and either starts a new round or ends the game.
+     * @brief Emits gameOver with the final score and accuracy
      */
-    void moveToNextQuestion();
+    void finish() override;
 
-    QVector<QuestionLesson> questions;
+private:
     int playerScore;
-    int currentQuestionIndex;
-    bool gameEnded;
-    QString currentPattern;
-    QString currentDescription;
     int correctAnswers;
     int totalAttempts;
-    double accuracy;
+    const RhythmResult* pendingRhythm;  // Timing of the attempt being judged, nullptr if untimed
 };
 
 #endif // LESSONSGAME_H
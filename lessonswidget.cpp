@@ -7,7 +7,14 @@
  */
 
 #include "lessonswidget.h"
+#include "keyboard.h"
+#include "midieventqueue.h"
+#include "notetable.h"
+#include "trace.h"
 #include "pianowidget.h"
+#include "promptplayer.h"
+#include "questionbankwatcher.h"
+#include "theme.h"
 #include <QFont>
 #include <QFontDatabase>
 #include <QMessageBox>
@@ -17,6 +24,7 @@
 #include <QApplication>
 #include "loaddatamanager.h"
 #include <QDebug>
+#include <cmath>
 
 /**
  * @brief Constructor for LessonsWidget
@@ -29,8 +37,9 @@ LessonsWidget::LessonsWidget(QWidget *parent, int topicId)
     : QWidget(parent)
     , game(nullptr)
     , currentTopicId(topicId)
-    , chordTimer(new QTimer(this))
+    , chordCapture(new ChordCapture(this))
     , isProcessingSubmission(false)
+    , rhythmTimer(new QTimer(this))
 {
     // Find the labels from the UI
     titleLabel = parent->findChild<QLabel*>("titleLabel");
@@ -39,14 +48,19 @@ LessonsWidget::LessonsWidget(QWidget *parent, int topicId)
     accuracyLabel = parent->findChild<QLabel*>("accuracyLabel");
 
     setupUI();
+    connectPiano();
     
-    // Set up chord timer
-    chordTimer->setSingleShot(true);
-    connect(chordTimer, &QTimer::timeout, this, &LessonsWidget::submitChord);
+    // Submit every chord the capture groups together
+    connect(chordCapture, &ChordCapture::chordCaptured, this, &LessonsWidget::submitChord);
+
+    rhythmTimer->setSingleShot(true);
+    connect(rhythmTimer, &QTimer::timeout, this, &LessonsWidget::submitRhythm);
 
     game = new Lessonsgame(this, topicId);
     connect(game, &Lessonsgame::updateUI, this, &LessonsWidget::updateGameUI);
     connect(game, &Lessonsgame::gameOver, this, &LessonsWidget::handleGameOver);
+    connect(QuestionBankWatcher::instance(), &QuestionBankWatcher::questionBankChanged,
+            game, &Lessonsgame::handleQuestionBankChanged);
     
      // Connect visual feedback signal
     auto piano = PianoWidget::instance();
@@ -54,7 +68,7 @@ LessonsWidget::LessonsWidget(QWidget *parent, int topicId)
         connect(game, &Lessonsgame::highlightKeys, piano, &PianoWidget::highlightAttempt);
     }
     
-    game->startNewRound();
+    game->start();
 }
 
 /**
@@ -95,82 +109,97 @@ void LessonsWidget::setupUI()
     // Apply fonts to labels if they exist
     if (titleLabel) {
         titleLabel->setFont(titleFont);
-        titleLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(titleLabel, Theme::TEXT);
         titleLabel->setWordWrap(true);
     }
 
     if (descriptionLabel) {
         descriptionLabel->setFont(descriptionFont);
-        descriptionLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(descriptionLabel, Theme::TEXT);
         descriptionLabel->setWordWrap(true);
     }
 
     if (playerScoreLabel) {
         playerScoreLabel->setFont(playerFont);
-        playerScoreLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(playerScoreLabel, Theme::TEXT);
     }
 
     if (accuracyLabel) {
         accuracyLabel->setFont(accuracyFont);
-        accuracyLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(accuracyLabel, Theme::TEXT);
     }
+}
 
-    // Ensure piano is properly attached
+/**
+ * @brief Attaches the piano to the game screen and listens to its keys
+ * @details Connections are unique, so calling this for every session does not
+ *          deliver a key twice.
+ */
+void LessonsWidget::connectPiano()
+{
     auto piano = PianoWidget::instance();
-    if (piano) {
-        // Find the piano placeholder in the parent widget
-        QFrame* pianoPlaceholder = parentWidget()->findChild<QFrame*>("pianoLocalPlaceholder");
-        if (pianoPlaceholder) {
-            piano->attachToPlaceholder(pianoPlaceholder);
-            connect(piano, &PianoWidget::keyPressed, this, &LessonsWidget::handleKeyPressed);
-            connect(piano, &PianoWidget::keyReleased, this, &LessonsWidget::handleKeyReleased);
-        }
+    if (!piano) {
+        return;
     }
-
-    // Setup chord timer
-    chordTimer = new QTimer(this);
-    chordTimer->setSingleShot(true);
-    connect(chordTimer, &QTimer::timeout, this, &LessonsWidget::handleChordTimeout);
+    // Find the piano placeholder in the parent widget
+    QFrame* pianoPlaceholder = parentWidget()->findChild<QFrame*>("pianoLocalPlaceholder");
+    if (pianoPlaceholder) {
+        piano->attachToPlaceholder(pianoPlaceholder);
+    }
+    connect(piano, &PianoWidget::keyPressed, this, &LessonsWidget::handleKeyPressed, Qt::UniqueConnection);
+    connect(piano, &PianoWidget::keyReleased, this, &LessonsWidget::handleKeyReleased, Qt::UniqueConnection);
+    connect(piano, &PianoWidget::notePlayed, this, &LessonsWidget::handleNotePlayed, Qt::UniqueConnection);
+    connect(piano->promptPlayer(), &PromptPlayer::finished, this, &LessonsWidget::handlePromptFinished, Qt::UniqueConnection);
 }
 
 /**
- * @brief Starts a new game round
- * @details Triggers the start of a new round in the game logic.
+ * @brief Starts a new session of a topic, reusing the game and the labels
+ * @param topicId The ID of the topic to load
+ * @details The fonts and styles set up by the constructor are kept; only the game
+ *          state is reset.
  */
-void LessonsWidget::startGame()
+void LessonsWidget::reset(int topicId)
 {
-    game->startNewRound();
+    currentTopicId = topicId;
+    chordCapture->clear();
+    rhythmFeedback.clear();
+    connectPiano();
+    game->reset(topicId);
+    game->start();
 }
 
 /**
- * @brief Converts a MIDI note index to its corresponding note name
- * @param noteIndex The MIDI note number (60-72)
- * @return The note name as a string (e.g., "C4", "D#4")
- * @details Maps MIDI note numbers to their corresponding note names in the fourth octave.
+ * @brief Stops listening to the piano
+ * @details Called when the game ends or its screen is left. The widget and its
+ *          game are kept for the next reset().
  */
-QString LessonsWidget::noteIndexToName(int noteIndex)
+void LessonsWidget::stop()
 {
-    // MIDI note numbers to note names mapping
-    // White keys: 60, 62, 64, 65, 67, 69, 71, 72 (C4 to C5)
-    // Black keys: 61, 63, 66, 68, 70 (C#4 to A#4)
-    switch (noteIndex) {
-    case 60: return "C4";
-    case 61: return "C#4";
-    case 62: return "D4";
-    case 63: return "D#4";
-    case 64: return "E4";
-    case 65: return "F4";
-    case 66: return "F#4";
-    case 67: return "G4";
-    case 68: return "G#4";
-    case 69: return "A4";
-    case 70: return "A#4";
-    case 71: return "B4";
-    case 72: return "C5";
-    default: return QString();
+    chordCapture->clear();
+    rhythm.stop();
+    rhythmTimer->stop();
+    auto piano = PianoWidget::instance();
+    if (piano) {
+        piano->promptPlayer()->cancel();
+        disconnect(piano->promptPlayer(), &PromptPlayer::finished, this, &LessonsWidget::handlePromptFinished);
+        if (piano->keyboard() && clickSequence) {
+            piano->keyboard()->cancelSequence(clickSequence);
+        }
+        disconnect(piano, &PianoWidget::keyPressed, this, &LessonsWidget::handleKeyPressed);
+        disconnect(piano, &PianoWidget::keyReleased, this, &LessonsWidget::handleKeyReleased);
+        disconnect(piano, &PianoWidget::notePlayed, this, &LessonsWidget::handleNotePlayed);
     }
 }
 
+/**
+ * @brief Starts a new game round
+ * @details Triggers the start of a new round in the game logic.
+ */
+void LessonsWidget::startGame()
+{
+    game->start();
+}
+
 /**
  * @brief Handles keyboard input for note playing
  * @param noteIndex The MIDI note number pressed
@@ -178,47 +207,176 @@ QString LessonsWidget::noteIndexToName(int noteIndex)
  */
 void LessonsWidget::handleKeyPressed(int noteIndex)
 {
+    KEYQUEST_TRACE_SCOPE("LessonsWidget::handleKeyPressed");
     // If we're currently processing a submission, ignore new key presses
     if (isProcessingSubmission) {
         return;
     }
 
-    // Add to currently pressed keys set
-    currentlyPressedKeys.insert(noteIndex);
-    
-    // Collect the new note
-    QString noteName = noteIndexToName(noteIndex);
+    QString noteName = NoteTable::name(noteIndex);
     qDebug() << "LessonsWidget: Key pressed - MIDI index:" << noteIndex << "Note name:" << noteName;
-    
-    if (!noteName.isEmpty()) {
-        // Keep the original formatting of the note from noteIndexToName
-        if (!currentChordNotes.contains(noteName)) {
-            currentChordNotes.append(noteName);
-            qDebug() << "LessonsWidget: Added note to chord:" << noteName << "- Current chord:" << currentChordNotes.join("-");
-        }
+
+    // Rhythm patterns are collected by handleNotePlayed() with their exact times
+    if (currentTopicId == GameSession::MELODY_ID) {
+        return;
     }
-    
-    // Restart the timer with a longer window (1 second)
-    chordTimer->start(1000);
+    chordCapture->noteOn(noteIndex);
 }
 
 void LessonsWidget::handleKeyReleased(int noteIndex)
 {
     // Get the note name for debugging
-    QString noteName = noteIndexToName(noteIndex);
+    QString noteName = NoteTable::name(noteIndex);
     qDebug() << "LessonsWidget: Key released - MIDI index:" << noteIndex << "Note name:" << noteName;
     
-    // Remove from currently pressed keys set
-    currentlyPressedKeys.remove(noteIndex);
-    
-    // If all keys are released, submit the collected notes
-    if (currentlyPressedKeys.isEmpty()) {
-        qDebug() << "LessonsWidget: All keys released, submitting chord:" << currentChordNotes.join("-");
-        isProcessingSubmission = false;
-        submitChord();
+    // The capture submits the chord once all keys are released
+    if (currentTopicId != GameSession::MELODY_ID) {
+        chordCapture->noteOff(noteIndex);
+    }
+}
+
+/**
+ * @brief Records the exact time of a key press for the rhythm lesson
+ * @param note The MIDI note
+ * @param velocity Note-on velocity
+ * @param time When the key went down, from MidiEventQueue::now()
+ * @details The time comes from the input itself, so how late this slot runs does
+ *          not affect the score. Presses during the count-in are ignored.
+ */
+void LessonsWidget::handleNotePlayed(int note, int velocity, qint64 time)
+{
+    Q_UNUSED(velocity);
+    if (!rhythm.isActive()) {
+        // Any key skips the demonstration, or counts in again after an attempt with no notes
+        if (currentTopicId == GameSession::MELODY_ID && !rhythmPrompt.isEmpty()) {
+            startRhythmPattern();
+        }
+        return;
+    }
+    // Every note inside the window counts towards the pitches, chord notes included
+    rhythm.addOnset(time);
+    const qint64 heard = time + rhythm.outputLatency();
+    if (heard >= rhythm.beatTime(0) - rhythm.period() / 2 && heard <= rhythm.windowEnd()) {
+        rhythmNotes.addMidiNote(note);
+    }
+
+    // Give the other fingers of a final chord a moment before submitting
+    if (rhythm.isComplete()) {
+        rhythmTimer->start(static_cast<int>(RhythmEngine::CHORD_WINDOW_NS / 1000000));
     }
 }
 
+/**
+ * @brief Starts the count-in and the tempo grid of the current rhythm question
+ * @details One onset is expected per element of the pattern, e.g. five for
+ *          "C-D-E-G-F" and four for "C-Dm-Em-F". Every click is scheduled on the
+ *          synthesizer's own clock at once, ahead of the output latency, so it is
+ *          heard on its beat however busy the GUI thread is. A demonstration of
+ *          the pattern that is still playing is cut off.
+ */
+void LessonsWidget::startRhythmPattern()
+{
+    auto piano = PianoWidget::instance();
+    Keyboard* keyboard = piano ? piano->keyboard() : nullptr;
+    const int beats = game->getCurrentPattern().split('-', Qt::SkipEmptyParts).size();
+    if (beats == 0) {
+        rhythm.stop();
+        return;
+    }
+
+    rhythm.setOutputLatency(keyboard ? static_cast<qint64>(keyboard->outputLatencyMs() * 1e6) : 0);
+    const qint64 firstBeat = MidiEventQueue::now() + qint64(COUNT_IN_LEAD_MS) * 1000000
+                             + rhythm.outputLatency() + RhythmEngine::COUNT_IN_BEATS * rhythm.period();
+    rhythm.start(firstBeat, beats);
+    rhythmNotes.clear();
+    if (piano) {
+        piano->promptPlayer()->cancel();
+    }
+    if (keyboard) {
+        clickSequence = keyboard->beginSequence(Keyboard::CLICK_CHANNEL);
+    }
+
+    for (int beat = -RhythmEngine::COUNT_IN_BEATS; beat < beats; ++beat) {
+        scheduleClick(beat);
+    }
+
+    // Onsets stop counting half a beat after the last one
+    const qint64 remaining = rhythm.windowEnd() - rhythm.outputLatency() - MidiEventQueue::now();
+    rhythmTimer->start(static_cast<int>(remaining / 1000000) + 1);
+}
+
+/**
+ * @brief Schedules a metronome click on the synthesizer
+ * @param beat Index of the beat; negative indices are the count-in
+ * @details The count-in is loud with an accent on its first click; the clicks
+ *          under the pattern are quieter so the player's notes stay in front. The
+ *          clicks go through the keyboard's sequencer, so they do not hold up the
+ *          notes the player presses meanwhile and stop() can silence them.
+ */
+void LessonsWidget::scheduleClick(int beat)
+{
+    auto piano = PianoWidget::instance();
+    if (!piano || !piano->keyboard()) {
+        return;
+    }
+    const int velocity = beat == -RhythmEngine::COUNT_IN_BEATS ? 110 : beat < 0 ? 80 : 45;
+    const qint64 time = rhythm.beatTime(beat) - rhythm.outputLatency();
+    piano->keyboard()->scheduleNote(clickSequence, CLICK_NOTE, velocity, time, time + qint64(CLICK_LENGTH_MS) * 1000000);
+}
+
+/**
+ * @brief Counts the rhythm pattern in once its demonstration has been played
+ */
+void LessonsWidget::handlePromptFinished()
+{
+    if (game && currentTopicId == GameSession::MELODY_ID && !rhythm.isActive()) {
+        startRhythmPattern();
+    }
+}
+
+/**
+ * @brief Submits the notes and timing of the rhythm pattern
+ * @details The timing of this attempt is shown under the next question. An
+ *          attempt without any notes is not scored; the lesson waits for a key.
+ */
+void LessonsWidget::submitRhythm()
+{
+    if (!game || !rhythm.isActive()) {
+        return;
+    }
+    rhythmTimer->stop();
+    const RhythmResult result = rhythm.result();
+    const NoteSet played = rhythmNotes;
+    rhythm.stop();
+    rhythmNotes.clear();
+
+    // Nobody played: wait for a key instead of clicking through the next question
+    if (played.isEmpty()) {
+        descriptionLabel->setText(rhythmPrompt + "\nNo notes heard. Press any key to count in again.");
+        return;
+    }
+
+    qDebug() << "LessonsWidget: Rhythm" << result.hits << "of" << result.beats << "beats, mean"
+             << result.meanDeviationMs << "ms, tempo" << result.playedBpm << "BPM, score" << result.score;
+
+    if (result.hits == 0) {
+        rhythmFeedback = "Last attempt: no notes on the beat.";
+    } else {
+        rhythmFeedback = QString("Last attempt: %1 of %2 beats, %3 ms %4 on average")
+                             .arg(result.hits).arg(result.beats)
+                             .arg(QString::number(std::abs(result.meanDeviationMs), 'f', 0))
+                             .arg(result.meanDeviationMs < 0 ? "early" : "late");
+        if (result.playedBpm > 0.0) {
+            rhythmFeedback += QString(", %1 BPM (target %2)")
+                                  .arg(QString::number(result.playedBpm, 'f', 0))
+                                  .arg(QString::number(result.targetBpm, 'f', 0));
+        }
+    }
+
+    // The game asks the next question and its updateUI starts the next count-in
+    game->timedAttempt(played, result);
+}
+
 /**
  * @brief Updates the game UI with current game state
  * @param playerScore The current player's score
@@ -235,18 +393,35 @@ void LessonsWidget::updateGameUI(int playerScore, QString title, QString descrip
     }
 
     // Clear any existing chord notes when updating UI (new pattern)
-    currentChordNotes.clear();
+    chordCapture->clear();
+    chordCapture->setExpectedNoteCount(game->getCurrentExpectedNotes().size());
+
+    // Play the answer first; the rhythm pattern is counted in once it has been heard
+    auto piano = PianoWidget::instance();
+    PromptPlayer* player = piano ? piano->promptPlayer() : nullptr;
+    rhythm.stop();
+    rhythmTimer->stop();
+    if (player) {
+        player->setTempo(currentTopicId == GameSession::MELODY_ID ? rhythm.tempo() : PromptPlayer::DEFAULT_BPM);
+        player->play(game->getCurrentPrompt());
+    }
 
     titleLabel->setText(title.toUpper());
-    descriptionLabel->setText(description);
+    if (currentTopicId == GameSession::MELODY_ID) {
+        rhythmPrompt = description;
+        descriptionLabel->setText(rhythmFeedback.isEmpty() ? description : description + "\n" + rhythmFeedback);
+        if (!player || !player->isPlaying()) {
+            startRhythmPattern();
+        }
+    } else {
+        descriptionLabel->setText(description);
+    }
 
     // Update scores with more prominent formatting
     playerScoreLabel->setText(QString("%1").arg(playerScore));
-    playerScoreLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
 
     // Update accuracy with percentage
     accuracyLabel->setText(QString("%1%").arg(QString::number(playerAccuracy, 'f', 0)));
-    accuracyLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
 }
 
 /**
@@ -257,21 +432,8 @@ void LessonsWidget::updateGameUI(int playerScore, QString title, QString descrip
  */
 void LessonsWidget::handleGameOver(int playerScore, double accuracy)
 {
-    // Stop and disconnect the chord timer first
-    if (chordTimer) {
-        chordTimer->stop();
-        disconnect(chordTimer, nullptr, this, nullptr);
-    }
-
-    // Clear any pending chord notes
-    currentChordNotes.clear();
-
-    // Disconnect piano signals first
-    auto piano = PianoWidget::instance();
-    if (piano) {
-        disconnect(piano, &PianoWidget::keyPressed, this, &LessonsWidget::handleKeyPressed);
-        disconnect(piano, &PianoWidget::keyReleased, this, &LessonsWidget::handleKeyReleased);
-    }
+    // Drop any pending chord notes and stop listening to the piano
+    stop();
 
     // Update UI elements one last time to show final state
     titleLabel->setText("Lesson Complete!");
@@ -294,50 +456,24 @@ void LessonsWidget::handleGameOver(int playerScore, double accuracy)
         1  // Increment attempts by 1
     );
 
-    // Clean up the game object last, after all UI updates and message box
-    if (game) {
-        disconnect(game, nullptr, this, nullptr);
-        game->deleteLater();
-        game = nullptr;
-    }
-
     // Emit signal with the current topic ID
     emit gameFinished(currentTopicId);
 }
 
 /**
  * @brief Submits a collected chord to the game logic
- * @details Processes collected notes into a chord and submits it to the game.
- *          Clears the chord buffer after submission.
+ * @param chord The chord captured from the piano
+ * @details Submits the collected notes to the game as a single chord.
  */
-void LessonsWidget::submitChord()
+void LessonsWidget::submitChord(const NoteSet& chord)
 {
-    if (currentChordNotes.isEmpty()) {
+    KEYQUEST_TRACE_SCOPE("LessonsWidget::submitChord");
+    if (!game || chord.isEmpty()) {
         return;
     }
 
-    // Sort the notes
-    currentChordNotes.sort();
-    QString attempt = currentChordNotes.join("-");
-    qDebug() << "LessonsWidget: Submitting chord:" << attempt;
+    qDebug() << "LessonsWidget: Submitting chord:" << chord.toString();
     
     // Submit the attempt and let the game logic handle validation
-    game->playerAttempt(attempt);
-    
-    // Clear the chord buffer
-    currentChordNotes.clear();
+    game->playerAttempt(chord);
 }
-
-/**
- * @brief Handles the chord input timeout
- * @details Submits the collected chord when no new keys are pressed for the timeout period
- */
-void LessonsWidget::handleChordTimeout()
-{
-    // If we have collected notes and we're not currently processing a submission,
-    // submit the chord
-    if (!currentChordNotes.isEmpty() && !isProcessingSubmission) {
-        qDebug() << "LessonsWidget: Chord timeout - submitting chord:" << currentChordNotes.join("-");
-        submitChord();
-    }
-} 
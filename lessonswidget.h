@@ -16,35 +16,44 @@
 #include <QVBoxLayout>
 #include <QMessageBox>
 #include "lessonsgame.h"
-#include <QtCore/QTimer>
-#include <QSet>
+#include "chordcapture.h"
+#include "rhythmengine.h"
+
+class QTimer;
 
 /**
  * @brief Widget class for the lessons game interface
  * 
  * Provides the user interface for the lessons game mode, including
- * display of game information, handling of user input, and chord processing
+ * display of game information, handling of user input, and chord processing.
+ * The Rhythm/Melody lesson plays a count-in on the synthesizer and scores the
+ * timestamped onsets of the pattern with a RhythmEngine instead of grouping
+ * them into chords.
  */
 class LessonsWidget : public QWidget
 {
     Q_OBJECT
 public:
-    // Topic IDs
-    static const int GENERAL_TOPIC_ID = 101;
-    static const int MAJOR_MINOR_CHORDS_TOPIC_ID = 102;
-    static const int TRIAD_TOPIC_ID = 103;
-    static const int MAJOR_SCALE_ID = 104;
-    static const int PERFECT_ID = 105;
-    static const int MELODY_ID = 106;
-
     /**
      * @brief Constructs a new LessonsWidget
      * @param parent The parent widget
      * @param topicId The ID of the lesson topic to display
      */
-    explicit LessonsWidget(QWidget *parent = nullptr, int topicId = GENERAL_TOPIC_ID);
+    explicit LessonsWidget(QWidget *parent = nullptr, int topicId = GameSession::GENERAL_TOPIC_ID);
     ~LessonsWidget();
 
+    /**
+     * @brief Starts a new session of a topic, reusing the game and the labels
+     * @param topicId The ID of the topic to load
+     */
+    void reset(int topicId);
+
+    /**
+     * @brief Stops listening to the piano
+     * @details The widget and its game are kept for the next reset().
+     */
+    void stop();
+
 public slots:
     /**
      * @brief Handles key press events from the piano
@@ -58,6 +67,19 @@ public slots:
      */
     void handleKeyReleased(int noteIndex);
 
+    /**
+     * @brief Records the exact time of a key press for the rhythm lesson
+     * @param note The MIDI note
+     * @param velocity Note-on velocity
+     * @param time When the key went down, from MidiEventQueue::now()
+     */
+    void handleNotePlayed(int note, int velocity, qint64 time);
+
+    /**
+     * @brief Counts the rhythm pattern in once its demonstration has been played
+     */
+    void handlePromptFinished();
+
     /**
      * @brief Updates the game interface with current game state
      * @param playerScore The current player score
@@ -74,12 +96,6 @@ public slots:
      */
     void handleGameOver(int playerScore, double accuracy);
 
-    /**
-     * @brief Handles the chord input timeout
-     * @details Submits the collected chord when no new keys are pressed for the timeout period
-     */
-    void handleChordTimeout();
-
 signals:
     /**
      * @brief Signal emitted when the game is finished
@@ -93,22 +109,37 @@ private:
      */
     void setupUI();
 
+    /**
+     * @brief Attaches the piano to the game screen and listens to its keys
+     */
+    void connectPiano();
+
     /**
      * @brief Initializes and starts the game
      */
     void startGame();
 
     /**
-     * @brief Converts a note index to its name
-     * @param noteIndex The index of the note
-     * @return QString The name of the note
+     * @brief Submits the current chord for evaluation
+     * @param chord The chord captured from the piano
      */
-    QString noteIndexToName(int noteIndex);
+    void submitChord(const NoteSet& chord);
 
     /**
-     * @brief Submits the current chord for evaluation
+     * @brief Starts the count-in and the tempo grid of the current rhythm question
      */
-    void submitChord();
+    void startRhythmPattern();
+
+    /**
+     * @brief Submits the notes and timing of the rhythm pattern
+     */
+    void submitRhythm();
+
+    /**
+     * @brief Schedules a metronome click on the synthesizer
+     * @param beat Index of the beat; negative indices are the count-in
+     */
+    void scheduleClick(int beat);
 
     Lessonsgame *game;
     QLabel *titleLabel;
@@ -118,10 +149,18 @@ private:
     int currentTopicId;
 
     // For handling chords
-    QStringList currentChordNotes;
-    static const int CHORD_TIMEOUT_MS = 1000;
-    QTimer* chordTimer;
-    QSet<int> currentlyPressedKeys;  // Track which keys are currently pressed
+    ChordCapture* chordCapture;      // Groups key presses into submitted chords
     bool isProcessingSubmission;     // Flag to prevent multiple rapid submissions
+
+    // For the Rhythm/Melody lesson
+    static const int CLICK_NOTE = 108;           // Note of the metronome click (C8)
+    static const int CLICK_LENGTH_MS = 40;       // How long a click sounds
+    static const int COUNT_IN_LEAD_MS = 300;     // Pause before the first count-in click
+    RhythmEngine rhythm;             // Tempo grid and onset scoring of the current pattern
+    NoteSet rhythmNotes;             // Notes played during the current pattern
+    QTimer* rhythmTimer;             // Ends the pattern's window; timing itself does not depend on it
+    quint16 clickSequence = 0;       // Keyboard sequence of the metronome clicks
+    QString rhythmFeedback;          // Timing of the previous attempt, shown under the next question
+    QString rhythmPrompt;            // Description of the current rhythm question
 };
 #endif // LESSONSWIDGET_H
@@ -3,10 +3,16 @@
  * @brief Implementation of the LoadDataManager class
  * @author Alan Cruz, Bashar Hamo
  * @details This file implements the LoadDataManager class which handles loading and saving
- *          of application data, including settings and lesson statistics.
+ *          of application data, including settings, player profiles and their lesson
+ *          statistics. Writes are coalesced and performed by a DataWriter on a worker thread.
  */
 
 #include "loaddatamanager.h"
+#include "datawriter.h"
+#include "quizreport.h"
+#include <algorithm>
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QStandardPaths>
@@ -29,18 +35,38 @@ LoadDataManager* LoadDataManager::instance()
 /**
  * @brief Constructs a new LoadDataManager
  * @param parent The parent QObject
+ * @details Reads data.json and the profile index only; the active profile's shard
+ *          is read when first needed.
  */
 LoadDataManager::LoadDataManager(QObject *parent)
     : QObject(parent)
+    , m_saveTimer(new QTimer(this))
+    , m_writerThread(new QThread(this))
+    , m_writer(new DataWriter())
 {
+    // Writes happen on a worker thread so the GUI never waits on disk I/O
+    m_writer->moveToThread(m_writerThread);
+    connect(m_writerThread, &QThread::finished, m_writer, &QObject::deleteLater);
+    m_writerThread->start();
+
+    // Changes are collected for a short while and then written together
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SAVE_DELAY_MS);
+    connect(m_saveTimer, &QTimer::timeout, this, &LoadDataManager::flush);
+
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &LoadDataManager::shutdown);
+    }
+
     // Set up the data file path in the user's local app data directory
-    QString appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir dir(appDataPath);
+    m_appDataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir dir(m_appDataPath);
     if (!dir.exists()) {
         dir.mkpath(".");
-        qDebug() << "Created app data directory at:" << appDataPath;
+        qDebug() << "Created app data directory at:" << m_appDataPath;
     }
     m_dataFilePath = dir.filePath("data.json");
+    m_indexFilePath = dir.filePath("profiles.json");
     qDebug() << "User data file location:" << m_dataFilePath;
 
     // Try to load existing user data
@@ -66,36 +92,37 @@ LoadDataManager::LoadDataManager(QObject *parent)
         qDebug() << "Failed to load data, creating default structure";
         // Create default data structure as fallback
         m_data = QJsonObject{
-            {"lessons", QJsonObject{
-                {"topics", QJsonObject{
-                    {"101", QJsonObject{{"statistics", QJsonObject{{"scores", QJsonArray()}, {"accuracy", QJsonArray()}, {"attempts", QJsonArray()}}}}},
-                    {"102", QJsonObject{{"statistics", QJsonObject{{"scores", QJsonArray()}, {"accuracy", QJsonArray()}, {"attempts", QJsonArray()}}}}},
-                    {"103", QJsonObject{{"statistics", QJsonObject{{"scores", QJsonArray()}, {"accuracy", QJsonArray()}, {"attempts", QJsonArray()}}}}},
-                    {"104", QJsonObject{{"statistics", QJsonObject{{"scores", QJsonArray()}, {"accuracy", QJsonArray()}, {"attempts", QJsonArray()}}}}},
-                    {"105", QJsonObject{{"statistics", QJsonObject{{"scores", QJsonArray()}, {"accuracy", QJsonArray()}, {"attempts", QJsonArray()}}}}},
-                    {"106", QJsonObject{{"statistics", QJsonObject{{"scores", QJsonArray()}, {"accuracy", QJsonArray()}, {"attempts", QJsonArray()}}}}}
-                }}
-            }},
             {"settings", QJsonObject{
                 {"backgroundMusicLevel", 100},
-                {"fxsoundLevel", 100}
-            }},
-            {"qtable", QJsonObject{
-                {"newUser", true},
-                {"table", QJsonObject{}},
-                {"userState", QJsonObject{
-                    {"notes", 0},
-                    {"chords", 0},
-                    {"scales", 0}
-                }}
+                {"fxsoundLevel", 100},
+                {"latencyProfile", "safe"},
+                {"keyboardRange", "octave"},
+                {"synthQuality", "standard"},
+                {"soundEngine", "synth"},
+                {"memoryBudgets", QJsonObject{{"images", 128}, {"total", 512}}}
             }}
         };
         saveData();
     }
+
+    loadProfiles();
+
+    // A lab login script can pass the student's name to open their profile
+    const QStringList arguments = QCoreApplication::arguments();
+    for (const QString& argument : arguments) {
+        if (argument.startsWith("--profile=")) {
+            QString name = argument.mid(10).trimmed();
+            if (name.isEmpty()) {
+                continue;
+            }
+            QString profileId = findProfile(name);
+            switchProfile(profileId.isEmpty() ? createProfile(name) : profileId);
+        }
+    }
 }
 
 /**
- * @brief Loads all data from the data.json file
+ * @brief Loads the settings from the data.json file
  * @return true if loading was successful, false otherwise
  */
 bool LoadDataManager::loadData()
@@ -122,9 +149,101 @@ bool LoadDataManager::loadData()
 
     m_data = doc.object();
     
-    // Ensure the qtable structure exists
-    if (!m_data.contains("qtable")) {
-        m_data["qtable"] = QJsonObject{
+    qDebug() << "Successfully loaded data from:" << m_dataFilePath;
+    return true;
+}
+
+/**
+ * @brief Reads the index of the profiles, creating it on first start
+ * @details Without an index, the "lessons" and "qtable" sections and the session
+ *          log of data.json are moved into the shard of a first profile. That
+ *          shard is kept loaded, so nothing reads it back before it is written.
+ */
+void LoadDataManager::loadProfiles()
+{
+    QFile file(m_indexFilePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+        file.close();
+        if (doc.isObject() && !doc.object()["profiles"].toObject().isEmpty()) {
+            m_index = doc.object();
+            m_activeProfile = m_index["active"].toString();
+            if (!m_index["profiles"].toObject().contains(m_activeProfile)) {
+                m_activeProfile = getProfileIds().first();
+            }
+            qDebug() << "Loaded" << m_index["profiles"].toObject().size() << "profiles from:" << m_indexFilePath;
+            return;
+        }
+        qDebug() << "Invalid JSON format in profiles.json at:" << m_indexFilePath;
+    }
+
+    // First start with profiles: the existing data becomes the first player's
+    m_index = QJsonObject{{"active", QString()}, {"nextId", 1}, {"profiles", QJsonObject{}}};
+    m_activeProfile = createProfile("Player 1");
+    m_index["active"] = m_activeProfile;
+    if (!m_data.contains("lessons") && !m_data.contains("qtable")) {
+        // Nothing to move; an existing shard of the profile is read as usual
+        return;
+    }
+
+    auto shard = std::make_unique<Profile>();
+    QDir shardDir(profileDirectory(m_activeProfile));
+    shardDir.mkpath(".");
+    shard->filePath = shardDir.filePath("profile.json");
+    shard->data = defaultProfileData();
+    for (const QString& section : {QString("lessons"), QString("qtable")}) {
+        if (m_data.contains(section)) {
+            shard->data[section] = m_data.take(section);
+        }
+    }
+    shard->dirtySections = {"lessons", "qtable"};
+    shard->generation = m_profileSwitches;
+
+    QString legacyLog = QDir(m_appDataPath).filePath("sessions.jsonl");
+    if (QFile::exists(legacyLog) && !QFile::rename(legacyLog, shardDir.filePath("sessions.jsonl"))) {
+        qDebug() << "Failed to move" << legacyLog << "into the first profile";
+    }
+    shard->sessionLog.setFilePath(shardDir.filePath("sessions.jsonl"));
+    shard->quizHistory.setFilePath(shardDir.filePath("quiz_history.kqr"));
+
+    m_profile = std::move(shard);
+    loadTopicStatistics(*m_profile);
+    loadQTableAsync(*m_profile);
+    qDebug() << "Moved the existing data into profile" << m_activeProfile;
+
+    // Rewrite data.json without the moved sections
+    m_dirtySections.insert("settings");
+    markDirty("profiles");
+}
+
+/**
+ * @brief Gets the folder of a profile's shard
+ * @param profileId The ID of the profile
+ * @return The folder path
+ */
+QString LoadDataManager::profileDirectory(const QString& profileId) const
+{
+    return QDir(m_appDataPath).filePath("profiles/" + profileId);
+}
+
+/**
+ * @brief Creates the data of a profile without any results
+ * @return The "lessons" and "qtable" sections
+ */
+QJsonObject LoadDataManager::defaultProfileData()
+{
+    return QJsonObject{
+        {"lessons", QJsonObject{
+            {"topics", QJsonObject{
+                {"101", QJsonObject{{"statistics", TopicStatistics().toJson()}}},
+                {"102", QJsonObject{{"statistics", TopicStatistics().toJson()}}},
+                {"103", QJsonObject{{"statistics", TopicStatistics().toJson()}}},
+                {"104", QJsonObject{{"statistics", TopicStatistics().toJson()}}},
+                {"105", QJsonObject{{"statistics", TopicStatistics().toJson()}}},
+                {"106", QJsonObject{{"statistics", TopicStatistics().toJson()}}}
+            }}
+        }},
+        {"qtable", QJsonObject{
             {"newUser", true},
             {"table", QJsonObject{}},
             {"userState", QJsonObject{
@@ -132,32 +251,261 @@ bool LoadDataManager::loadData()
                 {"chords", 0},
                 {"scales", 0}
             }}
-        };
-        saveData();
+        }}
+    };
+}
+
+/**
+ * @brief Gets the shard of the active profile, reading it on first use
+ * @return The shard
+ * @details Only this one file is read, whatever the number of profiles. A missing
+ *          or damaged shard starts the profile over without results.
+ */
+LoadDataManager::Profile& LoadDataManager::profile() const
+{
+    if (m_profile) {
+        return *m_profile;
     }
-    
-    qDebug() << "Successfully loaded data from:" << m_dataFilePath;
+
+    auto shard = std::make_unique<Profile>();
+    QDir shardDir(profileDirectory(m_activeProfile));
+    if (!shardDir.exists()) {
+        shardDir.mkpath(".");
+    }
+    shard->filePath = shardDir.filePath("profile.json");
+    shard->sessionLog.setFilePath(shardDir.filePath("sessions.jsonl"));
+    shard->quizHistory.setFilePath(shardDir.filePath("quiz_history.kqr"));
+    shard->generation = m_profileSwitches;
+
+    QFile file(shard->filePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+        file.close();
+        if (doc.isObject()) {
+            shard->data = doc.object();
+        } else {
+            qDebug() << "Invalid JSON format in profile at:" << shard->filePath;
+        }
+    }
+
+    // Fill in the sections a new or older shard lacks
+    const QJsonObject defaults = defaultProfileData();
+    for (auto it = defaults.begin(); it != defaults.end(); ++it) {
+        if (!shard->data.contains(it.key())) {
+            shard->data[it.key()] = it.value();
+            shard->dirtySections.insert(it.key());
+        }
+    }
+
+    m_profile = std::move(shard);
+    loadTopicStatistics(*m_profile);
+    loadQTableAsync(*m_profile);
+    if (!m_profile->dirtySections.isEmpty() && !m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+    qDebug() << "Loaded profile" << m_activeProfile << "from:" << m_profile->filePath;
+    return *m_profile;
+}
+
+/**
+ * @brief Gets the IDs of all player profiles
+ * @return The IDs in the order the profiles were created
+ */
+QStringList LoadDataManager::getProfileIds() const
+{
+    QStringList profileIds = m_index["profiles"].toObject().keys();
+    std::sort(profileIds.begin(), profileIds.end(), [](const QString& a, const QString& b) {
+        return a.toInt() < b.toInt();
+    });
+    return profileIds;
+}
+
+/**
+ * @brief Gets the name of a player profile
+ * @param profileId The ID of the profile
+ * @return The name, empty if there is no such profile
+ */
+QString LoadDataManager::getProfileName(const QString& profileId) const
+{
+    return m_index["profiles"].toObject()[profileId].toObject()["name"].toString();
+}
+
+/**
+ * @brief Gets the ID of the profile of a player
+ * @param name The player's name, compared without case
+ * @return The ID, empty if no profile has that name
+ */
+QString LoadDataManager::findProfile(const QString& name) const
+{
+    const QJsonObject profiles = m_index["profiles"].toObject();
+    for (auto it = profiles.begin(); it != profiles.end(); ++it) {
+        if (it.value().toObject()["name"].toString().compare(name, Qt::CaseInsensitive) == 0) {
+            return it.key();
+        }
+    }
+    return QString();
+}
+
+/**
+ * @brief Adds a player profile
+ * @param name The player's name
+ * @return The ID of the new profile
+ */
+QString LoadDataManager::createProfile(const QString& name)
+{
+    int nextId = m_index["nextId"].toInt(1);
+    QJsonObject profiles = m_index["profiles"].toObject();
+    while (profiles.contains(QString::number(nextId))) {
+        ++nextId;
+    }
+    const QString profileId = QString::number(nextId);
+
+    profiles[profileId] = QJsonObject{{"name", name}};
+    m_index["profiles"] = profiles;
+    m_index["nextId"] = nextId + 1;
+    markDirty("profiles");
+    return profileId;
+}
+
+/**
+ * @brief Makes a profile the active one
+ * @param profileId The ID of the profile
+ * @return false if there is no such profile
+ * @details Queues the pending writes of the old shard and drops it. Nothing is read
+ *          here; the new shard is read by the first call that needs it.
+ */
+bool LoadDataManager::switchProfile(const QString& profileId)
+{
+    if (!m_index["profiles"].toObject().contains(profileId)) {
+        qDebug() << "No profile with ID" << profileId;
+        return false;
+    }
+    if (profileId == m_activeProfile) {
+        return true;
+    }
+
+    if (m_profile) {
+        flush();
+        const QString oldFilePath = m_profile->filePath;
+        QMetaObject::invokeMethod(m_writer, [writer = m_writer, oldFilePath]() {
+            writer->forget(oldFilePath);
+        }, Qt::QueuedConnection);
+        m_profile.reset();
+    }
+    ++m_profileSwitches;
+    m_activeProfile = profileId;
+    m_index["active"] = profileId;
+    markDirty("profiles");
+
+    qDebug() << "Switched to profile" << profileId << getProfileName(profileId);
+    emit profileChanged(profileId);
     return true;
 }
 
 /**
- * @brief Saves all data back to the data.json file
- * @return true if saving was successful, false otherwise
+ * @brief Saves all data back to the data.json file, the index and the active shard
+ * @return true if the write was queued, false if there is no data file path
  */
 bool LoadDataManager::saveData()
 {
-    QFile file(m_dataFilePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        qDebug() << "Failed to open data.json file for writing";
+    if (m_dataFilePath.isEmpty()) {
+        qDebug() << "No data.json file path to save to";
         return false;
     }
 
-    QJsonDocument doc(m_data);
-    QByteArray data = doc.toJson(QJsonDocument::Indented);
-    qint64 bytesWritten = file.write(data);
-    file.close();
+    const QStringList sections = m_data.keys();
+    for (const QString& section : sections) {
+        m_dirtySections.insert(section);
+    }
+    if (!m_index.isEmpty()) {
+        m_indexDirty = true;
+    }
+    if (m_profile) {
+        const QStringList profileSections = m_profile->data.keys();
+        for (const QString& section : profileSections) {
+            m_profile->dirtySections.insert(section);
+        }
+    }
+    flush();
+    return true;
+}
+
+/**
+ * @brief Writes pending changes without waiting for the save delay
+ * @details Hands snapshots of the changed files to the writer thread. QJsonObject is
+ *          implicitly shared and the Q-table is immutable, so the snapshots are cheap
+ *          and later edits on the GUI thread do not affect them.
+ */
+void LoadDataManager::flush()
+{
+    m_saveTimer->stop();
+    if (!m_dirtySections.isEmpty()) {
+        queueWrite(m_dataFilePath, m_data, m_dirtySections, nullptr);
+        m_dirtySections.clear();
+    }
+    if (m_indexDirty) {
+        const QStringList keys = m_index.keys();
+        queueWrite(m_indexFilePath, m_index, QSet<QString>(keys.begin(), keys.end()), nullptr);
+        m_indexDirty = false;
+    }
+    if (m_profile && !m_profile->dirtySections.isEmpty()) {
+        queueWrite(m_profile->filePath, m_profile->data, m_profile->dirtySections, m_profile->qTable);
+        m_profile->dirtySections.clear();
+    }
+}
+
+/**
+ * @brief Hands a snapshot of a file's data to the writer thread
+ * @param filePath The file to replace
+ * @param data The data
+ * @param dirtySections Top-level keys of data that changed since the last write
+ * @param qTable Q-table injected into the "qtable" section, or null
+ */
+void LoadDataManager::queueWrite(const QString& filePath, const QJsonObject& data, const QSet<QString>& dirtySections,
+                                 std::shared_ptr<const QTable> qTable) const
+{
+    QStringList sections(dirtySections.begin(), dirtySections.end());
+    QMetaObject::invokeMethod(m_writer, [writer = m_writer, filePath, data, sections, qTable]() {
+        writer->write(filePath, data, sections, qTable);
+    }, Qt::QueuedConnection);
+}
 
-    return bytesWritten != -1;
+/**
+ * @brief Marks a top-level section as changed and schedules a write
+ * @param section Name of the section, e.g. "settings"
+ * @details The timer is not restarted by later changes, so a continuous stream of
+ *          changes is still written at least every SAVE_DELAY_MS.
+ */
+void LoadDataManager::markDirty(const QString& section) const
+{
+    if (section == "lessons" || section == "qtable" || section == "reviews") {
+        profile().dirtySections.insert(section);
+    } else if (section == "profiles") {
+        m_indexDirty = true;
+    } else {
+        m_dirtySections.insert(section);
+    }
+    if (!m_saveTimer->isActive()) {
+        m_saveTimer->start();
+    }
+}
+
+/**
+ * @brief Flushes pending changes and stops the writer thread
+ */
+void LoadDataManager::shutdown()
+{
+    m_saveTimer->stop();
+    if (!m_writerThread->isRunning()) {
+        return;
+    }
+
+    // Queue the final writes behind any earlier ones and wait until all are done
+    flush();
+    QMetaObject::invokeMethod(m_writer, []() {}, Qt::BlockingQueuedConnection);
+
+    m_writerThread->quit();
+    m_writerThread->wait();
 }
 
 /**
@@ -169,35 +517,106 @@ bool LoadDataManager::saveData()
  */
 void LoadDataManager::updateLessonStats(int topicId, int score, double accuracy, int attempts)
 {
-    // Convert topicId to string format (e.g., "101")
-    QString topicStr = QString::number(topicId);
+    Profile& shard = profile();
 
-    // Navigate to the correct topic in the JSON structure
-    QJsonObject lessons = m_data["lessons"].toObject();
-    QJsonObject topics = lessons["topics"].toObject();
-    QJsonObject topicData = topics[topicStr].toObject();
-    QJsonObject stats = topicData["statistics"].toObject();
+    SessionLog::Entry entry;
+    entry.topicId = topicId;
+    entry.score = score;
+    entry.accuracy = accuracy;
+    entry.attempts = attempts;
+    entry.timestamp = QDateTime::currentMSecsSinceEpoch();
+    shard.sessionLog.append(entry);
+
+    shard.topicStats[topicId].add(score, accuracy, attempts);
+    storeTopicStatistics(shard, topicId);
+
+    // Schedule the updated data to be saved
+    markDirty("lessons");
+}
 
-    // Update the statistics arrays
-    QJsonArray scores = stats["scores"].toArray();
-    QJsonArray accuracies = stats["accuracy"].toArray();
-    QJsonArray attemptsArray = stats["attempts"].toArray();
+/**
+ * @brief Gets the running statistics of a lesson topic
+ * @param topicId The ID of the topic
+ * @return The statistics, empty if the topic has no completed lessons
+ */
+TopicStatistics LoadDataManager::getTopicStatistics(int topicId) const
+{
+    const Profile& shard = profile();
+    auto it = shard.topicStats.find(topicId);
+    if (it == shard.topicStats.end()) {
+        return TopicStatistics();
+    }
+    return it->second;
+}
+
+/**
+ * @brief Reads the per-topic statistics from the loaded shard
+ * @param shard The shard
+ */
+void LoadDataManager::loadTopicStatistics(Profile& shard) const
+{
+    shard.topicStats.clear();
+    bool migrated = false;
+
+    QJsonObject topics = shard.data["lessons"].toObject()["topics"].toObject();
+    for (auto it = topics.begin(); it != topics.end(); ++it) {
+        int topicId = it.key().toInt();
+        QJsonObject stats = it.value().toObject()["statistics"].toObject();
+
+        if (!stats["scores"].isArray()) {
+            shard.topicStats[topicId] = TopicStatistics::fromJson(stats);
+            continue;
+        }
+
+        // Old format: one ever-growing array per value
+        QJsonArray scores = stats["scores"].toArray();
+        QJsonArray accuracies = stats["accuracy"].toArray();
+        QJsonArray attemptsArray = stats["attempts"].toArray();
+        TopicStatistics& topicStats = shard.topicStats[topicId];
+        for (qsizetype i = 0; i < scores.size(); ++i) {
+            SessionLog::Entry entry;
+            entry.topicId = topicId;
+            entry.score = scores[i].toInt();
+            entry.accuracy = accuracies[i].toDouble();
+            entry.attempts = attemptsArray[i].toInt();
+            shard.sessionLog.append(entry);
+            topicStats.add(entry.score, entry.accuracy, entry.attempts);
+        }
+        migrated = true;
+    }
+
+    if (migrated) {
+        for (const auto& topic : shard.topicStats) {
+            storeTopicStatistics(shard, topic.first);
+        }
+        shard.dirtySections.insert("lessons");
+        if (!m_saveTimer->isActive()) {
+            m_saveTimer->start();
+        }
+    }
 
-    scores.append(score);
-    accuracies.append(accuracy);
-    attemptsArray.append(attempts);
+    if (shard.sessionLog.size() > SESSION_LOG_COMPACT_BYTES) {
+        shard.sessionLog.compact(SESSION_LOG_KEEP_PER_TOPIC);
+    }
+}
 
-    stats["scores"] = scores;
-    stats["accuracy"] = accuracies;
-    stats["attempts"] = attemptsArray;
+/**
+ * @brief Stores the statistics of one topic back into the lessons section
+ * @param shard The shard
+ * @param topicId The ID of the topic
+ */
+void LoadDataManager::storeTopicStatistics(Profile& shard, int topicId) const
+{
+    QString topicStr = QString::number(topicId);
 
-    topicData["statistics"] = stats;
+    // The statistics object has a fixed size, so this copy does not grow with the history
+    QJsonObject lessons = shard.data["lessons"].toObject();
+    QJsonObject topics = lessons["topics"].toObject();
+    QJsonObject topicData = topics[topicStr].toObject();
+    topicData["statistics"] = shard.topicStats[topicId].toJson();
     topics[topicStr] = topicData;
     lessons["topics"] = topics;
-    m_data["lessons"] = lessons;
-
-    // Save the updated data
-    saveData();
+    shard.data["lessons"] = lessons;
 }
 
 /**
@@ -227,7 +646,7 @@ void LoadDataManager::setBackgroundMusicLevel(int level)
     QJsonObject settings = m_data["settings"].toObject();
     settings["backgroundMusicLevel"] = level;
     m_data["settings"] = settings;
-    saveData();
+    markDirty("settings");
 }
 
 /**
@@ -239,81 +658,304 @@ void LoadDataManager::setFXSoundLevel(int level)
     QJsonObject settings = m_data["settings"].toObject();
     settings["fxsoundLevel"] = level;
     m_data["settings"] = settings;
-    saveData();
+    markDirty("settings");
+}
+
+/**
+ * @brief Gets the selected audio latency profile
+ * @return "safe" or "low"; "safe" if none was chosen
+ */
+QString LoadDataManager::getLatencyProfile() const
+{
+    return m_data["settings"].toObject()["latencyProfile"].toString("safe");
+}
+
+/**
+ * @brief Updates the selected audio latency profile
+ * @param profile "safe" or "low"
+ */
+void LoadDataManager::setLatencyProfile(const QString& profile)
+{
+    QJsonObject settings = m_data["settings"].toObject();
+    if (settings["latencyProfile"].toString() == profile) {
+        return;
+    }
+    settings["latencyProfile"] = profile;
+    m_data["settings"] = settings;
+    markDirty("settings");
+}
+
+/**
+ * @brief Gets the selected piano key range
+ * @return "octave", "61" or "88"; "octave" if none was chosen
+ */
+QString LoadDataManager::getKeyboardRange() const
+{
+    return m_data["settings"].toObject()["keyboardRange"].toString("octave");
+}
+
+/**
+ * @brief Updates the selected piano key range
+ * @param range "octave", "61" or "88"
+ */
+void LoadDataManager::setKeyboardRange(const QString& range)
+{
+    QJsonObject settings = m_data["settings"].toObject();
+    if (settings["keyboardRange"].toString() == range) {
+        return;
+    }
+    settings["keyboardRange"] = range;
+    m_data["settings"] = settings;
+    markDirty("settings");
+}
+
+/**
+ * @brief Gets the selected synth quality
+ * @return "light", "standard" or "rich"; "standard" if none was chosen
+ */
+QString LoadDataManager::getSynthQuality() const
+{
+    return m_data["settings"].toObject()["synthQuality"].toString("standard");
+}
+
+/**
+ * @brief Updates the selected synth quality
+ * @param quality "light", "standard" or "rich"
+ */
+void LoadDataManager::setSynthQuality(const QString& quality)
+{
+    QJsonObject settings = m_data["settings"].toObject();
+    if (settings["synthQuality"].toString() == quality) {
+        return;
+    }
+    settings["synthQuality"] = quality;
+    m_data["settings"] = settings;
+    markDirty("settings");
+}
+
+/**
+ * @brief Gets the selected sound engine
+ * @return "synth" or "samples"; "synth" if none was chosen
+ */
+QString LoadDataManager::getSoundEngine() const
+{
+    return m_data["settings"].toObject()["soundEngine"].toString("synth");
+}
+
+/**
+ * @brief Updates the selected sound engine
+ * @param engine "synth" or "samples"
+ */
+void LoadDataManager::setSoundEngine(const QString& engine)
+{
+    QJsonObject settings = m_data["settings"].toObject();
+    if (settings["soundEngine"].toString() == engine) {
+        return;
+    }
+    settings["soundEngine"] = engine;
+    m_data["settings"] = settings;
+    markDirty("settings");
+}
+
+/**
+ * @brief Gets the memory budgets
+ * @return Budget in megabytes by MemoryMonitor source name, "total" for all of
+ *         them; 128 for images and 512 in total if none were set
+ */
+QJsonObject LoadDataManager::getMemoryBudgets() const
+{
+    const QJsonValue budgets = m_data["settings"].toObject()["memoryBudgets"];
+    if (!budgets.isObject()) {
+        return QJsonObject{{"images", 128}, {"total", 512}};
+    }
+    return budgets.toObject();
+}
+
+/**
+ * @brief Gets an estimate of the memory the loaded data holds
+ * @return Size of the data as compact JSON, in bytes
+ * @details The parsed objects take somewhat more than their text; the estimate
+ *          grows with it.
+ */
+qint64 LoadDataManager::memoryUsage() const
+{
+    return QJsonDocument(m_data).toJson(QJsonDocument::Compact).size();
+}
+
+/**
+ * @brief Gets the key-to-sound latency stored by the last Keyboard::estimateLatency()
+ * @return The latency in milliseconds, or -1 if none was estimated
+ * @details Settings written before the rename keep the same value under
+ *          "measuredLatencyMs".
+ */
+double LoadDataManager::getEstimatedLatency() const
+{
+    const QJsonObject settings = m_data["settings"].toObject();
+    return settings.value("estimatedLatencyMs").toDouble(settings.value("measuredLatencyMs").toDouble(-1.0));
+}
+
+/**
+ * @brief Stores the key-to-sound latency estimated by Keyboard::estimateLatency()
+ * @param latencyMs The latency in milliseconds
+ */
+void LoadDataManager::setEstimatedLatency(double latencyMs)
+{
+    QJsonObject settings = m_data["settings"].toObject();
+    settings.remove("measuredLatencyMs");
+    settings["estimatedLatencyMs"] = latencyMs;
+    m_data["settings"] = settings;
+    markDirty("settings");
 }
 
 /**
  * @brief Get the user's Q-table for adaptive quiz
- * @return The Q-table as a map of States to maps of action IDs and Q-values
+ * @return The Q-table of States and action IDs to Q-values
  */
-std::map<State, std::map<int, float>> LoadDataManager::getQTable() const
+QTable LoadDataManager::getQTable() const
 {
-    std::map<State, std::map<int, float>> qTable;
-    
-    // Get the QTable from the JSON data
-    QJsonObject qtableObj = m_data["qtable"].toObject();
-    QJsonObject tableObj = qtableObj["table"].toObject();
-    
-    // Iterate through each state in the Q-table
-    for (auto stateIt = tableObj.begin(); stateIt != tableObj.end(); ++stateIt) {
-        QString stateKey = stateIt.key();
-        State state = State::fromKey(stateKey);
-        
-        // Get the actions for this state
-        if (stateIt.value().isObject()) {
-            QJsonObject actionMap = stateIt.value().toObject();
-            
-            // Iterate through each action for this state
-            for (auto actionIt = actionMap.begin(); actionIt != actionMap.end(); ++actionIt) {
-                QString actionKey = actionIt.key();
-                // Parse the question ID from the action key (format: "[id]")
-                QString processedKey = actionKey.mid(1, actionKey.length() - 2);
-                int questionID = processedKey.toInt();
-                float qValue = actionIt.value().toDouble();
-                
-                // Add to our map
-                qTable[state][questionID] = qValue;
-            }
-        }
+    const Profile& shard = profile();
+    if (shard.qTable) {
+        return *shard.qTable;
     }
-    
-    return qTable;
+
+    // The background load has not finished yet, parse the JSON data directly
+    QJsonObject qtableObj = shard.data["qtable"].toObject();
+    QTable table = QTable::fromJson(qtableObj["table"].toObject());
+    return table.isEmpty() ? priorQTable() : table;
+}
+
+/**
+ * @brief Reads the Q-table new profiles start from
+ * @return The prior trained by bench/qtrainer, or an empty table if none is shipped
+ */
+QTable LoadDataManager::priorQTable()
+{
+    QFile file(":/resources/qtablePrior.kqt");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QTable();
+    }
+    return QTable::fromBinary(file.readAll());
 }
 
 /**
  * @brief Save the user's Q-table for adaptive quiz
  * @param qTable The Q-table to save
+ * @details Only copies the table; converting it to JSON is left to the writer thread.
  */
-void LoadDataManager::saveQTable(const std::map<State, std::map<int, float>>& qTable)
+void LoadDataManager::saveQTable(const QTable& qTable)
 {
-    // Get the qtable object from the data
-    QJsonObject qtableObj = m_data["qtable"].toObject();
-    QJsonObject tableObj;
-    
-    // Convert the Q-table map to JSON format
-    for (const auto& [state, actionMap] : qTable) {
-        QString stateKey = state.toKey();
-        QJsonObject actionObj;
-        
-        for (const auto& [questionID, qValue] : actionMap) {
-            QString actionKey = QString("[%1]").arg(questionID);
-            actionObj[actionKey] = qValue;
-        }
-        
-        tableObj[stateKey] = actionObj;
-    }
-    
-    // Update the Q-table in our data
-    qtableObj["table"] = tableObj;
-    
+    Profile& shard = profile();
+    shard.qTable = std::make_shared<const QTable>(qTable);
+
     // If we're saving a Q-table, the user is no longer new
+    QJsonObject qtableObj = shard.data["qtable"].toObject();
     qtableObj["newUser"] = false;
-    
-    // Update the main data object
-    m_data["qtable"] = qtableObj;
-    
-    // Save changes to disk
-    saveData();
+    shard.data["qtable"] = qtableObj;
+
+    // Schedule the changes to be saved
+    markDirty("qtable");
+}
+
+/**
+ * @brief Get the user's spaced-repetition schedule for adaptive quiz
+ * @return The schedule of every question answered so far, empty for a new profile
+ */
+ReviewSchedule LoadDataManager::getReviewSchedule() const
+{
+    const QString encoded = profile().data["reviews"].toObject()["schedule"].toString();
+    if (encoded.isEmpty()) {
+        return ReviewSchedule();
+    }
+    return ReviewSchedule::fromBinary(QByteArray::fromBase64(encoded.toLatin1()));
+}
+
+/**
+ * @brief Save the user's spaced-repetition schedule for adaptive quiz
+ * @param schedule The schedule to save
+ */
+void LoadDataManager::saveReviewSchedule(const ReviewSchedule& schedule)
+{
+    Profile& shard = profile();
+    QJsonObject reviewsObj = shard.data["reviews"].toObject();
+    reviewsObj["schedule"] = QString::fromLatin1(schedule.toBinary().toBase64());
+    shard.data["reviews"] = reviewsObj;
+    markDirty("reviews");
+}
+
+/**
+ * @brief Records the start of a quiz in the active profile's quiz history
+ * @param seed Seed of the quiz session
+ * @param state Skill state the quiz starts from
+ */
+void LoadDataManager::beginQuizSession(quint64 seed, const State& state)
+{
+    profile().quizHistory.beginSession(seed, state);
+}
+
+/**
+ * @brief Records an answer of the running quiz
+ * @param entry The answered question
+ */
+void LoadDataManager::recordQuizAnswer(const QuizReport::Entry& entry)
+{
+    profile().quizHistory.appendAnswer(entry);
+}
+
+/**
+ * @brief Records the end of a completed quiz
+ * @param score Final score
+ * @param totalQuestions Number of questions answered
+ * @param correctAnswers Number of correct answers
+ */
+void LoadDataManager::endQuizSession(int score, int totalQuestions, int correctAnswers)
+{
+    profile().quizHistory.endSession(score, totalQuestions, correctAnswers);
+}
+
+/**
+ * @brief Reads the most recent quiz of the active profile back
+ * @return The quiz, or an empty report if the profile has none
+ */
+QuizReport LoadDataManager::lastQuizReport()
+{
+    return profile().quizHistory.lastSession();
+}
+
+/**
+ * @brief Gets a new file for a free-style recording of the active profile
+ * @return Path of a MIDI file named after the current time
+ */
+QString LoadDataManager::recordingPath() const
+{
+    QDir dir(profileDirectory(m_activeProfile));
+    if (!dir.mkpath("recordings")) {
+        qDebug() << "LoadDataManager: Failed to create recordings folder in:" << dir.path();
+    }
+    const QString name = "freestyle-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".mid";
+    return dir.filePath("recordings/" + name);
+}
+
+/**
+ * @brief Parses the stored Q-table of the shard on the writer thread
+ * @param shard The shard
+ * @details The result is handed back to the GUI thread and kept unless a table
+ *          has been saved or another profile chosen in the meantime.
+ */
+void LoadDataManager::loadQTableAsync(const Profile& shard) const
+{
+    QJsonObject tableObj = shard.data["qtable"].toObject()["table"].toObject();
+    const quint64 generation = shard.generation;
+    LoadDataManager* self = const_cast<LoadDataManager*>(this);
+    QMetaObject::invokeMethod(m_writer, [self, tableObj, generation]() {
+        // A profile that has not learned anything yet starts from the shipped prior
+        QTable parsed = QTable::fromJson(tableObj);
+        auto table = std::make_shared<const QTable>(parsed.isEmpty() ? priorQTable() : std::move(parsed));
+        QMetaObject::invokeMethod(self, [self, table, generation]() {
+            if (self->m_profile && self->m_profile->generation == generation && !self->m_profile->qTable) {
+                self->m_profile->qTable = table;
+            }
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
 }
 
 /**
@@ -322,7 +964,7 @@ void LoadDataManager::saveQTable(const std::map<State, std::map<int, float>>& qT
  */
 bool LoadDataManager::isNewUser() const
 {
-    QJsonObject qtableObj = m_data["qtable"].toObject();
+    QJsonObject qtableObj = profile().data["qtable"].toObject();
     return qtableObj["newUser"].toBool(true);
 }
 
@@ -332,10 +974,11 @@ bool LoadDataManager::isNewUser() const
  */
 void LoadDataManager::setNewUser(bool isNew)
 {
-    QJsonObject qtableObj = m_data["qtable"].toObject();
+    Profile& shard = profile();
+    QJsonObject qtableObj = shard.data["qtable"].toObject();
     qtableObj["newUser"] = isNew;
-    m_data["qtable"] = qtableObj;
-    saveData();
+    shard.data["qtable"] = qtableObj;
+    markDirty("qtable");
 }
 
 /**
@@ -344,10 +987,11 @@ void LoadDataManager::setNewUser(bool isNew)
  */
 void LoadDataManager::saveUserState(const State& state)
 {
-    QJsonObject qtableObj = m_data["qtable"].toObject();
+    Profile& shard = profile();
+    QJsonObject qtableObj = shard.data["qtable"].toObject();
     qtableObj["userState"] = state.toJson();
-    m_data["qtable"] = qtableObj;
-    saveData();
+    shard.data["qtable"] = qtableObj;
+    markDirty("qtable");
 }
 
 /**
@@ -356,10 +1000,10 @@ void LoadDataManager::saveUserState(const State& state)
  */
 State LoadDataManager::getUserState() const
 {
-    QJsonObject qtableObj = m_data["qtable"].toObject();
+    QJsonObject qtableObj = profile().data["qtable"].toObject();
     QJsonObject stateObj = qtableObj["userState"].toObject();
     
     State state;
     state.fromJson(stateObj);
     return state;
-} 
\ No newline at end of file
+}
@@ -3,8 +3,9 @@
  * @brief Header file for the LoadDataManager class
  * @author Alan Cruz, Bashar Hamo
  * @details This file defines the LoadDataManager class which handles loading and saving
- *          of application data, including settings and lesson statistics. It implements
- *          a singleton pattern to ensure only one instance manages all data.
+ *          of application data, including settings, player profiles and their lesson
+ *          statistics. It implements a singleton pattern to ensure only one instance
+ *          manages all data.
  */
 
 #ifndef LOADDATAMANAGER_H
@@ -17,16 +18,60 @@
 #include <QFile>
 #include <QString>
 #include <QDebug>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
 #include <map>
+#include <memory>
+#include "qtable.h"
+#include "reviewschedule.h"
+#include "quizhistory.h"
+#include "runningstats.h"
+#include "sessionlog.h"
 #include "state.h"
 
 /**
  * @brief Manages loading and saving of application data
  * 
- * The LoadDataManager class is responsible for loading settings and lesson statistics
- * from the data.json file, and saving updates back to the file. It implements a
- * singleton pattern to ensure only one instance exists and manages all data.
+ * The LoadDataManager class is responsible for loading settings, profiles and lesson
+ * statistics, and saving updates back to their files. It implements a singleton
+ * pattern to ensure only one instance exists and manages all data.
+ *
+ * The data is split over three kinds of files in the application data folder:
+ * - data.json holds the settings of the machine (volumes, latency, key range)
+ * - profiles.json is the index of the players: their names and the active one
+ * - profiles/<id>/profile.json is the shard of one player, with the "lessons",
+ *   "qtable" and "reviews" sections, next to that player's sessions.jsonl and quiz_history.kqr
+ *
+ * Start-up reads only data.json and the index, however many players share the
+ * machine. The shard of the active player is read the first time its statistics,
+ * quiz state or Q-table are asked for. Switching players writes the old shard in
+ * the background and drops it, so it takes the same time for any number of players.
+ * A data.json from before profiles is moved into the shard of a first player.
+ *
+ * Setters only update the in-memory data and mark the changed top-level section
+ * ("lessons", "settings", "qtable", "reviews") dirty. Dirty sections are collected for
+ * SAVE_DELAY_MS and then handed to a DataWriter on a worker thread, so a burst of
+ * changes such as a slider drag results in a single file write and the GUI thread
+ * never waits on disk I/O. Pending changes are flushed when the application quits.
+ *
+ * Lesson results are appended to an append-only SessionLog, while the shard only
+ * stores constant-size running aggregates per topic. Reading the statistics of a
+ * topic is therefore O(1) however long the history is. Quiz answers are appended
+ * one fixed-size record at a time to the player's QuizHistory while the quiz runs,
+ * so finishing a quiz writes a single record.
+ *
+ * The Q-table is kept as an immutable shared snapshot rather than as JSON. Saving it
+ * only swaps the pointer; the writer thread turns it into JSON when the "qtable"
+ * section is written. The table is parsed on the writer thread right after the shard
+ * is read, so it is usually ready before the user opens the quiz page.
+ *
+ * Starting KeyQuest with "--profile=<name>" selects the player of that name,
+ * creating it if needed, so a lab login script can open each student's profile.
  */
+class DataWriter;
+
 class LoadDataManager : public QObject
 {
     Q_OBJECT
@@ -38,17 +83,26 @@ public:
     static LoadDataManager* instance();
 
     /**
-     * @brief Loads all data from the data.json file
+     * @brief Loads the settings from the data.json file
      * @return true if loading was successful, false otherwise
+     * @details The active player's shard is read separately, when first needed.
      */
     bool loadData();
 
     /**
-     * @brief Saves all data back to the data.json file
-     * @return true if saving was successful, false otherwise
+     * @brief Saves all data back to the data.json file, the index and the active shard
+     * @return true if the write was queued, false if there is no data file path
+     * @details Marks every section dirty and writes without waiting for the save delay.
+     *          The write itself still happens on the writer thread.
      */
     bool saveData();
 
+    /**
+     * @brief Writes pending changes without waiting for the save delay
+     * @details Does nothing if no section is dirty.
+     */
+    void flush();
+
     /**
      * @brief Updates lesson statistics for a specific topic
      * @param topicId The ID of the topic
@@ -58,6 +112,13 @@ public:
      */
     void updateLessonStats(int topicId, int score, double accuracy, int attempts);
 
+    /**
+     * @brief Gets the running statistics of a lesson topic
+     * @param topicId The ID of the topic
+     * @return The statistics, empty if the topic has no completed lessons
+     */
+    TopicStatistics getTopicStatistics(int topicId) const;
+
     /**
      * @brief Gets the background music volume level
      * @return int The volume level (0-100)
@@ -82,17 +143,142 @@ public:
      */
     void setFXSoundLevel(int level);
 
+    /**
+     * @brief Gets the selected audio latency profile
+     * @return "safe" or "low"; "safe" if none was chosen
+     */
+    QString getLatencyProfile() const;
+
+    /**
+     * @brief Updates the selected audio latency profile
+     * @param profile "safe" or "low"
+     */
+    void setLatencyProfile(const QString& profile);
+
+    /**
+     * @brief Gets the selected piano key range
+     * @return "octave", "61" or "88"; "octave" if none was chosen
+     */
+    QString getKeyboardRange() const;
+
+    /**
+     * @brief Updates the selected piano key range
+     * @param range "octave", "61" or "88"
+     */
+    void setKeyboardRange(const QString& range);
+
+    /**
+     * @brief Gets the selected synth quality
+     * @return "light", "standard" or "rich"; "standard" if none was chosen
+     */
+    QString getSynthQuality() const;
+
+    /**
+     * @brief Updates the selected synth quality
+     * @param quality "light", "standard" or "rich"
+     */
+    void setSynthQuality(const QString& quality);
+
+    /**
+     * @brief Gets the selected sound engine
+     * @return "synth" or "samples"; "synth" if none was chosen
+     */
+    QString getSoundEngine() const;
+
+    /**
+     * @brief Updates the selected sound engine
+     * @param engine "synth" or "samples"
+     */
+    void setSoundEngine(const QString& engine);
+
+    /**
+     * @brief Gets the memory budgets
+     * @return Budget in megabytes by MemoryMonitor source name, "total" for all of them
+     */
+    QJsonObject getMemoryBudgets() const;
+
+    /**
+     * @brief Gets an estimate of the memory the loaded data holds
+     * @return Size of the data as compact JSON, in bytes
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief Gets the key-to-sound latency stored by the last Keyboard::estimateLatency()
+     * @return The latency in milliseconds, or -1 if none was estimated
+     */
+    double getEstimatedLatency() const;
+
+    /**
+     * @brief Stores the key-to-sound latency estimated by Keyboard::estimateLatency()
+     * @param latencyMs The latency in milliseconds
+     */
+    void setEstimatedLatency(double latencyMs);
+
     /**
      * @brief Get the user's Q-table for adaptive quiz
-     * @return The Q-table as a map of States to maps of action IDs and Q-values
+     * @return The Q-table of States and action IDs to Q-values
+     * @details Returns the table loaded in the background at start-up, or parses it
+     *          on the spot if that load has not finished yet. A profile that has not
+     *          learned anything yet gets priorQTable().
      */
-    std::map<State, std::map<int, float>> getQTable() const;
+    QTable getQTable() const;
 
     /**
      * @brief Save the user's Q-table for adaptive quiz
      * @param qTable The Q-table to save
+     * @details Stores a snapshot of the table; it is serialized on the writer thread.
+     */
+    void saveQTable(const QTable& qTable);
+
+    /**
+     * @brief Get the user's spaced-repetition schedule for adaptive quiz
+     * @return The schedule of every question answered so far, empty for a new profile
+     */
+    ReviewSchedule getReviewSchedule() const;
+
+    /**
+     * @brief Save the user's spaced-repetition schedule for adaptive quiz
+     * @param schedule The schedule to save
+     * @details Stored as the schedule's binary form in base64, 16 characters per
+     *          answered question, in the "reviews" section.
+     */
+    void saveReviewSchedule(const ReviewSchedule& schedule);
+
+    /**
+     * @brief Records the start of a quiz in the active profile's quiz history
+     * @param seed Seed of the quiz session
+     * @param state Skill state the quiz starts from
+     */
+    void beginQuizSession(quint64 seed, const State& state);
+
+    /**
+     * @brief Records an answer of the running quiz
+     * @param entry The answered question
+     * @details Appends one 16-byte record; nothing is rewritten.
+     */
+    void recordQuizAnswer(const QuizReport::Entry& entry);
+
+    /**
+     * @brief Records the end of a completed quiz
+     * @param score Final score
+     * @param totalQuestions Number of questions answered
+     * @param correctAnswers Number of correct answers
+     */
+    void endQuizSession(int score, int totalQuestions, int correctAnswers);
+
+    /**
+     * @brief Reads the most recent quiz of the active profile back
+     * @return The quiz, or an empty report if the profile has none
+     */
+    QuizReport lastQuizReport();
+
+    /**
+     * @brief Gets a new file for a free-style recording of the active profile
+     * @return Path of a MIDI file named after the current time
+     * @details Creates the profile's recordings folder if needed.
      */
-    void saveQTable(const std::map<State, std::map<int, float>>& qTable);
+    QString recordingPath() const;
 
     /**
      * @brief Get whether this is a new user (no Q-table data yet)
@@ -118,9 +304,70 @@ public:
      */
     State getUserState() const;
 
-    // Add method to get data
+    /**
+     * @brief Gets the IDs of all player profiles
+     * @return The IDs in the order the profiles were created
+     */
+    QStringList getProfileIds() const;
+
+    /**
+     * @brief Gets the name of a player profile
+     * @param profileId The ID of the profile
+     * @return The name, empty if there is no such profile
+     */
+    QString getProfileName(const QString& profileId) const;
+
+    /**
+     * @brief Gets the ID of the profile of a player
+     * @param name The player's name, compared without case
+     * @return The ID, empty if no profile has that name
+     */
+    QString findProfile(const QString& name) const;
+
+    /**
+     * @brief Gets the ID of the active profile
+     * @return The ID of the profile whose data is used
+     */
+    QString getActiveProfile() const { return m_activeProfile; }
+
+    /**
+     * @brief Adds a player profile
+     * @param name The player's name
+     * @return The ID of the new profile
+     * @details The profile starts without results; its shard is created when it is first used.
+     */
+    QString createProfile(const QString& name);
+
+    /**
+     * @brief Makes a profile the active one
+     * @param profileId The ID of the profile
+     * @return false if there is no such profile
+     * @details Pending changes of the previous profile are written in the background;
+     *          the new profile's shard is read when first needed.
+     */
+    bool switchProfile(const QString& profileId);
+
+    /**
+     * @brief Gets the settings data
+     * @return The contents of data.json
+     */
     QJsonObject getData() const { return m_data; }
 
+signals:
+    /**
+     * @brief Signal emitted after another profile became the active one
+     * @param profileId The ID of the new active profile
+     */
+    void profileChanged(const QString& profileId);
+
+private slots:
+    /**
+     * @brief Flushes pending changes and stops the writer thread
+     * @details Connected to QCoreApplication::aboutToQuit. Blocks until the last
+     *          write has reached the disk.
+     */
+    void shutdown();
+
 private:
     /**
      * @brief Private constructor to enforce singleton pattern
@@ -128,9 +375,112 @@ private:
      */
     explicit LoadDataManager(QObject *parent = nullptr);
 
+    /**
+     * @brief The loaded shard of the active profile
+     */
+    struct Profile {
+        QString filePath;                    ///< Path of the shard's profile.json
+        QJsonObject data;                    ///< The "lessons", "qtable" and "reviews" sections
+        QSet<QString> dirtySections;         ///< Sections changed since the last write
+        SessionLog sessionLog;               ///< Raw history of completed lessons
+        QuizHistory quizHistory;             ///< Every quiz answer, in compact records
+        std::map<int, TopicStatistics> topicStats;  ///< Running statistics of every topic
+        std::shared_ptr<const QTable> qTable;  ///< Latest Q-table, null until loaded or saved
+        quint64 generation = 0;              ///< Value of m_profileSwitches when the shard was read
+    };
+
+    /**
+     * @brief Gets the shard of the active profile, reading it on first use
+     * @return The shard
+     */
+    Profile& profile() const;
+
+    /**
+     * @brief Reads the index of the profiles, creating it on first start
+     * @details A data.json from before profiles becomes the shard of a first profile.
+     */
+    void loadProfiles();
+
+    /**
+     * @brief Gets the folder of a profile's shard
+     * @param profileId The ID of the profile
+     * @return The folder path
+     */
+    QString profileDirectory(const QString& profileId) const;
+
+    /**
+     * @brief Creates the data of a profile without any results
+     * @return The "lessons" and "qtable" sections
+     */
+    static QJsonObject defaultProfileData();
+
+    /**
+     * @brief Reads the Q-table new profiles start from
+     * @return The prior trained by bench/qtrainer, or an empty table if none is shipped
+     * @details Safe to call from the writer thread.
+     */
+    static QTable priorQTable();
+
+    /**
+     * @brief Marks a top-level section as changed and schedules a write
+     * @param section Name of the section, e.g. "settings"; "lessons", "qtable" and
+     *        "reviews" belong to the active profile's shard, "profiles" is the index
+     */
+    void markDirty(const QString& section) const;
+
+    /**
+     * @brief Hands a snapshot of a file's data to the writer thread
+     * @param filePath The file to replace
+     * @param data The data
+     * @param dirtySections Top-level keys of data that changed since the last write
+     * @param qTable Q-table injected into the "qtable" section, or null
+     */
+    void queueWrite(const QString& filePath, const QJsonObject& data, const QSet<QString>& dirtySections,
+                    std::shared_ptr<const QTable> qTable) const;
+
+    /**
+     * @brief Reads the per-topic statistics from the loaded shard
+     * @param shard The shard
+     * @details Topics still stored in the old format of one array per value are
+     *          folded into running aggregates and their entries moved to the session log.
+     */
+    void loadTopicStatistics(Profile& shard) const;
+
+    /**
+     * @brief Stores the statistics of one topic back into the lessons section
+     * @param shard The shard
+     * @param topicId The ID of the topic
+     */
+    void storeTopicStatistics(Profile& shard, int topicId) const;
+
+    /**
+     * @brief Parses the stored Q-table of the shard on the writer thread
+     * @param shard The shard
+     * @details The result is handed back to the GUI thread and kept unless a table
+     *          has been saved or another profile chosen in the meantime.
+     */
+    void loadQTableAsync(const Profile& shard) const;
+
     static LoadDataManager* m_instance;  ///< The singleton instance
-    QJsonObject m_data;                 ///< The loaded data
+    QJsonObject m_data;                 ///< The loaded settings
     QString m_dataFilePath;             ///< Path to the data.json file
+    QString m_appDataPath;              ///< Folder of all data files
+
+    QJsonObject m_index;                ///< The loaded profiles.json
+    QString m_indexFilePath;            ///< Path to the profiles.json file
+    QString m_activeProfile;            ///< ID of the active profile
+    mutable bool m_indexDirty = false;  ///< Whether the index changed since the last write
+    quint64 m_profileSwitches = 0;      ///< Number of profile switches, tells stale loads apart
+    mutable std::unique_ptr<Profile> m_profile;  ///< Shard of the active profile, null until needed
+
+    static const int SAVE_DELAY_MS = 500;  ///< Time changes are collected before a write
+    mutable QSet<QString> m_dirtySections;  ///< Sections of data.json changed since the last write
+    QTimer* m_saveTimer;                ///< Starts a write once the save delay has passed
+    QThread* m_writerThread;            ///< Thread the DataWriter lives on
+    DataWriter* m_writer;               ///< Serializes and writes the data files
+
+    static const qint64 SESSION_LOG_COMPACT_BYTES = 256 * 1024;  ///< Log size that triggers compaction
+    static const int SESSION_LOG_KEEP_PER_TOPIC = 100;  ///< Entries per topic kept by compaction
 };
 
 #endif // LOADDATAMANAGER_H 
\ No newline at end of file
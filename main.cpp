@@ -7,8 +7,15 @@
  */
 
 #include "mainwindow.h"
+#include "memorymonitor.h"
+#include "questionbankwatcher.h"
+#include "startupprofiler.h"
+#include "theme.h"
 
+#include <memory>
 #include <QApplication>
+#include <QDebug>
+#include <QResource>
 
 /**
  * @brief Main entry point of the application
@@ -17,16 +24,57 @@
  * @return Exit code of the application
  * @details Initializes the Qt application with high DPI support,
  *          creates and displays the main window, and enters the event loop.
+ *          When built with external assets, the image resource file next to the
+ *          executable is registered before any widget is created.
+ *
+ *          "--profile-startup[=<file>]" times the startup phases and writes a
+ *          report once the main menu is up and the background warm-up is done.
+ *          "--profile=<name>" plays as that player; LoadDataManager reads it.
+ *          "--memory-report[=<file>]" writes the memory breakdown on quit.
+ *          "--question-bank=<file>" plays the questions of that file and reloads
+ *          them whenever it is saved.
  */
 int main(int argc, char *argv[])
 {
+    StartupProfiler::enableFromArguments(argc, argv);
+
     // Enable High DPI scaling
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
     
-    QApplication a(argc, argv);
-    MainWindow w;
-    w.show();
+    std::unique_ptr<QApplication> app;
+    {
+        StartupProfiler::Phase phase("QApplication");
+        app = std::make_unique<QApplication>(argc, argv);
+    }
+    {
+        // One stylesheet for the whole application, parsed before any widget exists
+        StartupProfiler::Phase phase("Theme");
+        Theme::install(*app);
+    }
+
+#ifdef KEYQUEST_EXTERNAL_ASSETS
+    {
+        // Images ship as a separate resource file that Qt memory-maps
+        StartupProfiler::Phase phase("Register assets");
+        QString assetsPath = QCoreApplication::applicationDirPath() + "/KeyQuestAssets.rcc";
+        if (!QResource::registerResource(assetsPath)) {
+            qDebug() << "Failed to register image assets at:" << assetsPath;
+        }
+    }
+#endif
+
+    std::unique_ptr<MainWindow> w;
+    {
+        StartupProfiler::Phase phase("MainWindow");
+        w = std::make_unique<MainWindow>();
+    }
+    {
+        StartupProfiler::Phase phase("Show");
+        w->show();
+    }
+    MemoryMonitor::instance()->reportFromArguments(app->arguments());
+    QuestionBankWatcher::instance()->watchFromArguments(app->arguments());
 
-    return a.exec();
+    return app->exec();
 }
@@ -8,20 +8,42 @@
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include <QResizeEvent>
 #include <QScreen>
-#include "mathutils.h"
+#include "screenlayout.h"
 #include <QKeyEvent>
 #include <QtCore/QTimer>
 #include "pianowidget.h"
+#include "notevisualizer.h"
+#include "performancerecorder.h"
 #include <QPainter>
 #include "soundmanager.h"
 #include "loaddatamanager.h"
+#include "idlemanager.h"
+#include "midiinput.h"
+#include "memorymonitor.h"
+#include "questionbank.h"
+#include "startupprofiler.h"
+#include "backgroundrenderer.h"
+#ifdef KEYQUEST_TRACE
+#include <QDateTime>
+#include <QDir>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QShortcut>
+#include <QStandardPaths>
+#include <QThread>
+#include "trace.h"
+#include "traceoverlay.h"
+#endif
 
 /**
  * @brief Constructor for MainWindow
  * @param parent Pointer to the parent widget
  * @details Initializes the main window, sets up the UI, handles screen resolution,
- *          and initializes navigation and connections.
+ *          and initializes navigation and connections. Only what the main menu needs
+ *          is done here; data, audio, the piano and the question bank are loaded by
+ *          warmUp() once the first frame is on screen.
  */
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -31,42 +53,39 @@ MainWindow::MainWindow(QWidget *parent)
     , lessonsWidget(nullptr)
     , statisticsWidget(nullptr)
     , quizWidget(nullptr)
+    , onlineMatch(nullptr)
+    , noteVisualizer(nullptr)
+    , screenLayout(nullptr)
+    , synthLoadTimer(nullptr)
+    , warmedUp(false)
 {
-    ui->setupUi(this);
-
-    // Get the primary screen
-    QScreen* screen = QGuiApplication::primaryScreen();
-    QSize screenSize = screen->size();
-
-    // Ensure we don't exceed 4K resolution (3840x2160)
-    if (screenSize.width() > 3840 || screenSize.height() > 2160) {
-        double scaleX = 3840.0 / screenSize.width();
-        double scaleY = 2160.0 / screenSize.height();
-        double scale = qMin(scaleX, scaleY);
-
-        screenSize = QSize(screenSize.width() * scale, screenSize.height() * scale);
+    {
+        StartupProfiler::Phase phase("setupUi");
+        ui->setupUi(this);
     }
 
     // Set window to full screen
     showFullScreen();
 
-    // Scale widgets based on the actual screen size
-    scaleAllButtons();
-
-    setupNavigation();
-    setupConnections();
-
-    // Load saved volume levels
-    int bgMusicLevel = LoadDataManager::instance()->getBackgroundMusicLevel();
-    int fxSoundLevel = LoadDataManager::instance()->getFXSoundLevel();
-    
-    // Set the slider values
-    ui->musicVolumeSlider->setValue(bgMusicLevel);
-    ui->sfxVolumeSlider->setValue(fxSoundLevel);
-    
-    // Apply the volumes
-    SoundManager::instance()->setBGMusicVolume(bgMusicLevel);
-    SoundManager::instance()->setSFXVolume(fxSoundLevel);
+    // Scale the pages from their design geometry to the screen; later screen and
+    // pixel ratio changes arrive as resize events
+    {
+        StartupProfiler::Phase phase("Scale widgets");
+        screenLayout = new ScreenLayout(ui->stackedWidget);
+        screenLayout->apply(ScreenLayout::targetSize(QGuiApplication::primaryScreen()->size()));
+    }
+
+    {
+        StartupProfiler::Phase phase("Navigation and connections");
+        setupNavigation();
+        setupConnections();
+    }
+#ifdef KEYQUEST_TRACE
+    setupTracing();
+#endif
+
+    // Everything the main menu does not need is loaded after it has been drawn
+    StartupProfiler::afterFirstFrame(this, [this]() { warmUp(0); });
 }
 
 /**
@@ -75,35 +94,142 @@ MainWindow::MainWindow(QWidget *parent)
  */
 MainWindow::~MainWindow()
 {
+    delete screenLayout;
     delete ui;
     delete navigationManager;
 }
 
+/**
+ * @brief Loads one part of the deferred startup work
+ * @param step Index of the part to load
+ * @details Each part runs in its own event loop pass, so input that arrives while
+ *          warming up is handled between them. Every part is a lazily created
+ *          singleton, so pressing a button before its part has run only loads it
+ *          earlier. The last step ends the startup profile.
+ */
+void MainWindow::warmUp(int step)
+{
+    switch (step) {
+    case 0: {
+        // Reads data.json and starts parsing the Q-table on the writer thread
+        StartupProfiler::Phase phase("Load data");
+        LoadDataManager::instance();
+
+        // Each subsystem joins the memory account once the warm-up has created it;
+        // background images and the pages built around them are what can be freed
+        MemoryMonitor* memory = MemoryMonitor::instance();
+        memory->loadBudgets();
+        memory->addSource("images", &BackgroundRenderer::memoryUsage, [this]() {
+            navigationManager->releaseUnusedPages();
+            BackgroundRenderer::releaseHidden();
+        });
+        memory->addSource("settings", []() { return LoadDataManager::instance()->memoryUsage(); });
+        break;
+    }
+    case 1: {
+        // Load saved volume levels; the sliders are set when the settings page is first shown
+        StartupProfiler::Phase phase("Audio");
+        SoundManager::instance()->setBGMusicVolume(LoadDataManager::instance()->getBackgroundMusicLevel());
+        SoundManager::instance()->setSFXVolume(LoadDataManager::instance()->getFXSoundLevel());
+        SoundManager::instance()->startBackgroundMusic();
+        MemoryMonitor::instance()->addSource("effects", []() { return SoundManager::instance()->memoryUsage(); });
+        break;
+    }
+    case 2: {
+        // The SoundFont keeps loading in the background after this
+        StartupProfiler::Phase phase("Piano");
+        connect(PianoWidget::instance()->recorder(), &PerformanceRecorder::playbackFinished, this, [this]() {
+            ui->playRecordingButton->setChecked(false);
+        });
+        MemoryMonitor::instance()->addSource("piano", []() { return PianoWidget::instance()->memoryUsage(); });
+        MemoryMonitor::instance()->addSource("synth", []() { return PianoWidget::instance()->keyboard()->memoryUsage(); });
+
+        // The audio driver renders silence from now on; close it while nobody plays
+        IdleManager* idle = IdleManager::instance();
+        idle->setKeyboard(PianoWidget::instance()->keyboard());
+        idle->addBusyCheck([]() { return PianoWidget::instance()->recorder()->isPlaying(); });
+        connect(PianoWidget::instance()->midiInput(), &MidiInput::noteOn, idle, &IdleManager::notifyActivity);
+        connect(PianoWidget::instance()->midiInput(), &MidiInput::wakeRequested, idle, &IdleManager::notifyActivity,
+                Qt::QueuedConnection);
+        break;
+    }
+    case 3: {
+        // Index the question bank so starting a game or quiz reads no files
+        StartupProfiler::Phase phase("Question bank");
+        QuestionBank::instance();
+        MemoryMonitor::instance()->addSource("quiz", [this]() {
+            return QuestionBank::instance()->memoryUsage() + (quizWidget ? quizWidget->memoryUsage() : 0);
+        });
+        break;
+    }
+    default:
+        warmedUp = true;
+        StartupProfiler::finish();
+        return;
+    }
+    QTimer::singleShot(0, this, [this, step]() { warmUp(step + 1); });
+}
+
 /**
  * @brief Sets up the navigation system
- * @details Initializes the navigation manager and connects its signals.
+ * @details Initializes the navigation manager and connects its signals. Pages with
+ *          content of their own are registered as lazy pages, so only the main page
+ *          is set up at startup.
  */
 void MainWindow::setupNavigation()
 {
     navigationManager = new NavigationManager(ui->stackedWidget, this);
     connect(navigationManager, &NavigationManager::pageChanged, this, &MainWindow::handlePageChange);
+
+    // Statistics are built on the first visit and refreshed on every later one
+    navigationManager->registerPage(ui->statisticsPage,
+        [this]() {
+            statisticsWidget = new StatisticsWidget(ui->statisticsPage);
+            statisticsWidget->setParent(ui->statisticsWidget);  // Use the frame from UI
+            statisticsWidget->setGeometry(ui->statisticsWidget->rect());
+            statisticsWidget->show();
+        },
+        [this]() {
+            statisticsWidget->deleteLater();
+            statisticsWidget = nullptr;
+        });
+
+    // The sliders are only loaded once, they keep their values afterwards
+    navigationManager->registerPage(ui->settingsPage, [this]() {
+        ui->musicVolumeSlider->setValue(LoadDataManager::instance()->getBackgroundMusicLevel());
+        ui->sfxVolumeSlider->setValue(LoadDataManager::instance()->getFXSoundLevel());
+        bool lowLatency = LoadDataManager::instance()->getLatencyProfile() == "low";
+        ui->latencyProfileBox->setCurrentIndex(lowLatency ? 1 : 0);
+        PianoWidget::KeyboardRange range = PianoWidget::keyboardRangeFromString(LoadDataManager::instance()->getKeyboardRange());
+        ui->keyboardRangeBox->setCurrentIndex(static_cast<int>(range));
+        Keyboard::SynthQuality quality = Keyboard::synthQualityFromString(LoadDataManager::instance()->getSynthQuality());
+        ui->synthQualityBox->setCurrentIndex(static_cast<int>(quality));
+        Keyboard::SoundEngine engine = Keyboard::soundEngineFromString(LoadDataManager::instance()->getSoundEngine());
+        ui->soundEngineBox->setCurrentIndex(static_cast<int>(engine));
+        showLatency(LoadDataManager::instance()->getEstimatedLatency());
+    });
 }
 
 /**
  * @brief Sets up all signal and slot connections
  * @details Connects all UI buttons to their respective navigation and game mode functions.
+ *          The click sound goes through a lambda so the SoundManager is not created
+ *          before the first frame.
  */
 void MainWindow::setupConnections()
 {
+    auto playButtonClick = []() { SoundManager::instance()->playButtonClick(); };
+
     // Connect navigation buttons with sound effects
-    connect(ui->settingsButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->lessonsButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->statisticsButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->quizzesButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->multiplayerButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->freeStyleButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->exitButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->localMatchButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
+    connect(ui->settingsButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->lessonsButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->statisticsButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->quizzesButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->multiplayerButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->freeStyleButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->exitButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->localMatchButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->onlineMatchButton, &QPushButton::pressed, this, playButtonClick);
 
     // Connect navigation actions
     connect(ui->settingsButton, &QPushButton::clicked, navigationManager, &NavigationManager::navigateToSettings);
@@ -114,21 +240,22 @@ void MainWindow::setupConnections()
     connect(ui->freeStyleButton, &QPushButton::clicked, navigationManager, &NavigationManager::navigateToFreeStyle);
     connect(ui->exitButton, &QPushButton::clicked, this, &MainWindow::exitApplication);
     connect(ui->localMatchButton, &QPushButton::clicked, navigationManager, &NavigationManager::navigateToLocalMultiplayer);
+    connect(ui->onlineMatchButton, &QPushButton::clicked, this, &MainWindow::startOnlineMatch);
 
     // Connect game mode buttons with sound effects
-    connect(ui->generalGamePlay, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->multiplayerMajorMinorChords, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->lessonOneButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->Scales, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->identifyingMajorThird, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->Triad, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->Rhythm, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->lessonTwoButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->lessonThreeButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->lessonFourButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->lessonFiveButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->lessonSixButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->startButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
+    connect(ui->generalGamePlay, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->multiplayerMajorMinorChords, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->lessonOneButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->Scales, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->identifyingMajorThird, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->Triad, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->Rhythm, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->lessonTwoButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->lessonThreeButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->lessonFourButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->lessonFiveButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->lessonSixButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->startButton, &QPushButton::pressed, this, playButtonClick);
 
     // Connect game mode actions
     connect(ui->generalGamePlay, &QPushButton::clicked, this, &MainWindow::startGeneralGamePlay);
@@ -146,15 +273,15 @@ void MainWindow::setupConnections()
     connect(ui->startButton, &QPushButton::clicked, this, &MainWindow::startAdaptiveQuiz);
 
     // Connect return buttons with sound effects
-    connect(ui->returnFromSettingsButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->returnFromLessonsButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->returnFromMultiplayerButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->returnFromQuizzesButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->returnFromStatisticsButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->returnFromFreeStyleButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->returnToLocalGamePlayScreen, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->returnFromLocalButton, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
-    connect(ui->ReturnToLessonsPage, &QPushButton::pressed, SoundManager::instance(), &SoundManager::playButtonClick);
+    connect(ui->returnFromSettingsButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->returnFromLessonsButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->returnFromMultiplayerButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->returnFromQuizzesButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->returnFromStatisticsButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->returnFromFreeStyleButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->returnToLocalGamePlayScreen, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->returnFromLocalButton, &QPushButton::pressed, this, playButtonClick);
+    connect(ui->ReturnToLessonsPage, &QPushButton::pressed, this, playButtonClick);
 
     // Connect return actions
     connect(ui->returnFromSettingsButton, &QPushButton::clicked, navigationManager, &NavigationManager::navigateToMainPage);
@@ -176,13 +303,132 @@ void MainWindow::setupConnections()
         SoundManager::instance()->setSFXVolume(value);
         LoadDataManager::instance()->setFXSoundLevel(value);
     });
+    connect(ui->latencyProfileBox, &QComboBox::currentIndexChanged, this, [](int index) {
+        Keyboard::LatencyProfile profile = index == 1 ? Keyboard::LatencyProfile::Low : Keyboard::LatencyProfile::Safe;
+        PianoWidget::instance()->keyboard()->setLatencyProfile(profile);
+        LoadDataManager::instance()->setLatencyProfile(Keyboard::latencyProfileToString(profile));
+    });
+    connect(ui->synthQualityBox, &QComboBox::currentIndexChanged, this, [this](int index) {
+        Keyboard::SynthQuality quality = static_cast<Keyboard::SynthQuality>(index);
+        PianoWidget::instance()->keyboard()->setSynthQuality(quality);
+        LoadDataManager::instance()->setSynthQuality(Keyboard::synthQualityToString(quality));
+        showSynthLoad();
+    });
+    connect(ui->soundEngineBox, &QComboBox::currentIndexChanged, this, [this](int index) {
+        Keyboard::SoundEngine engine = static_cast<Keyboard::SoundEngine>(index);
+        PianoWidget::instance()->keyboard()->setSoundEngine(engine);
+        LoadDataManager::instance()->setSoundEngine(Keyboard::soundEngineToString(engine));
+        showSynthLoad();
+    });
+    synthLoadTimer = new QTimer(this);
+    synthLoadTimer->setInterval(1000);
+    connect(synthLoadTimer, &QTimer::timeout, this, &MainWindow::showSynthLoad);
+    connect(ui->keyboardRangeBox, &QComboBox::currentIndexChanged, this, [](int index) {
+        PianoWidget::KeyboardRange range = static_cast<PianoWidget::KeyboardRange>(index);
+        PianoWidget::instance()->setKeyboardRange(range);
+        LoadDataManager::instance()->setKeyboardRange(PianoWidget::keyboardRangeToString(range));
+    });
+    connect(ui->estimateLatencyButton, &QPushButton::clicked, this, [this]() {
+        ui->estimateLatencyButton->setEnabled(false);
+        ui->latencyLabel->setText("Estimating...");
+        PianoWidget::instance()->keyboard()->estimateLatency([this](double latencyMs) {
+            ui->estimateLatencyButton->setEnabled(true);
+            if (latencyMs >= 0) {
+                LoadDataManager::instance()->setEstimatedLatency(latencyMs);
+            }
+            showLatency(latencyMs);
+
+            // The driver may have fallen back to the safe profile while estimating
+            bool lowLatency = PianoWidget::instance()->keyboard()->latencyProfile() == Keyboard::LatencyProfile::Low;
+            ui->latencyProfileBox->setCurrentIndex(lowLatency ? 1 : 0);
+        });
+    });
+
+    // Connect free-style recording; either button is released again by leaving the page
+    connect(ui->recordButton, &QPushButton::toggled, this, [this](bool on) {
+        PerformanceRecorder* recorder = PianoWidget::instance()->recorder();
+        if (on) {
+            ui->playRecordingButton->setChecked(false);
+            if (!recorder->startRecording(LoadDataManager::instance()->recordingPath())) {
+                ui->recordButton->setChecked(false);
+                return;
+            }
+        } else {
+            recorder->stopRecording();
+        }
+        ui->recordButton->setText(on ? "Stop" : "Record");
+        ui->playRecordingButton->setEnabled(!on && !recorder->lastRecording().isEmpty());
+    });
+    connect(ui->playRecordingButton, &QPushButton::toggled, this, [this](bool on) {
+        PerformanceRecorder* recorder = PianoWidget::instance()->recorder();
+        if (on) {
+            if (!recorder->play(recorder->lastRecording())) {
+                ui->playRecordingButton->setChecked(false);
+                return;
+            }
+        } else {
+            recorder->stopPlayback();
+        }
+        ui->playRecordingButton->setText(on ? "Stop" : "Play");
+    });
+}
+
+/**
+ * @brief Shows an estimated key-to-sound latency on the settings page
+ * @param latencyMs The latency in milliseconds, or a negative value if unknown
+ */
+void MainWindow::showLatency(double latencyMs)
+{
+    if (latencyMs < 0) {
+        ui->latencyLabel->setText("Latency not estimated");
+    } else {
+        ui->latencyLabel->setText(QString("Estimated: %1 ms").arg(latencyMs, 0, 'f', 1));
+    }
+}
+
+/**
+ * @brief Shows the synthesizer's load and quality on the settings page
+ * @details The quality box follows a quality the keyboard lowered by itself.
+ *          While the pre-rendered piano plays, the label shows whether its notes
+ *          are ready instead, and the quality does not apply.
+ */
+void MainWindow::showSynthLoad()
+{
+    Keyboard* keyboard = PianoWidget::instance()->keyboard();
+    ui->synthQualityBox->setCurrentIndex(static_cast<int>(keyboard->synthQuality()));
+    const bool samples = keyboard->soundEngine() == Keyboard::SoundEngine::Samples;
+    ui->synthQualityBox->setEnabled(!samples);
+    if (samples) {
+        ui->synthLoadLabel->setText(keyboard->samplesReady() ? "Notes ready" : "Preparing notes...");
+        ui->synthLoadLabel->setToolTip("Notes of the key range are played from memory");
+        return;
+    }
+    ui->synthLoadLabel->setText(QString("Synth load: %1%").arg(keyboard->cpuLoad(), 0, 'f', 0));
+    ui->synthLoadLabel->setToolTip(QString("Rendered on %1 of %2 cores; the quality is lowered above %3%")
+                                       .arg(keyboard->renderThreads()).arg(QThread::idealThreadCount())
+                                       .arg(Keyboard::CPU_LOAD_LIMIT, 0, 'f', 0));
+}
+
+/**
+ * @brief Shows the note visualizer in a placeholder, creating it the first time
+ * @param placeholder The frame to show it in
+ * @details The visualizer is created on the first page that shows it, so the main
+ *          menu does not wait for a GL context.
+ */
+void MainWindow::attachVisualizer(QFrame* placeholder)
+{
+    if (!noteVisualizer) {
+        noteVisualizer = new NoteVisualizer(PianoWidget::instance(), placeholder);
+    }
+    noteVisualizer->attachToPlaceholder(placeholder);
 }
 
 /**
  * @brief Starts a game with a specific topic ID
  * @param topicId The ID of the topic to load
- * @details Initializes either a lessons widget or game widget based on the current page,
- *          sets up the piano widget, and connects necessary signals.
+ * @details Starts a session in either the lessons widget or the game widget based on
+ *          the current page and sets up the piano widget. Each widget is created on
+ *          first use and reset in place for every later session.
  */
 void MainWindow::startGameWithTopicId(int topicId)
 {
@@ -194,25 +440,19 @@ void MainWindow::startGameWithTopicId(int topicId)
         navigationManager->navigateToLessonsPageScreen();
 
 
-        // Clean up old widget if it exists
+        // Reuse the widget of the previous lesson, or create it the first time
         if (lessonsWidget) {
-            if (piano) {
-                disconnect(piano, nullptr, lessonsWidget, nullptr);
-            }
-            lessonsWidget->deleteLater();
-            lessonsWidget = nullptr;
+            lessonsWidget->reset(topicId);
+        } else {
+            lessonsWidget = new LessonsWidget(this, topicId);
+            lessonsWidget->setParent(ui->lessonsPlayPlaceHolder);
+            lessonsWidget->setGeometry(ui->lessonsPlayPlaceHolder->rect());
         }
-
-        // Create and setup new widget
-        lessonsWidget = new LessonsWidget(this, topicId);
-        lessonsWidget->setParent(ui->lessonsPlayPlaceHolder);
-        lessonsWidget->setGeometry(ui->lessonsPlayPlaceHolder->rect());
         lessonsWidget->show();
 
-        // Setup piano after widget is ready
+        // Setup piano after widget is ready; the widget connects its own key handlers
         if (piano && ui->lessonsPagePianoHolder) {
             piano->attachToPlaceholder(ui->lessonsPagePianoHolder);
-            connect(piano, &PianoWidget::keyPressed, lessonsWidget, &LessonsWidget::handleKeyPressed);
         }
 
     }
@@ -221,25 +461,19 @@ void MainWindow::startGameWithTopicId(int topicId)
         // First navigate to the game play screen
         navigationManager->navigateToGamePlay();
 
-        // Clean up old widget if it exists
+        // Reuse the widget of the previous game, or create it the first time
         if (gameWidget) {
-            if (piano) {
-                disconnect(piano, nullptr, gameWidget, nullptr);
-            }
-            gameWidget->deleteLater();
-            gameWidget = nullptr;
+            gameWidget->reset(topicId);
+        } else {
+            gameWidget = new MultiplayerGameWidget(this, topicId);
+            gameWidget->setParent(ui->gamePlayPlaceHolder);
+            gameWidget->setGeometry(ui->gamePlayPlaceHolder->rect());
         }
-
-        // Create and setup new widget
-        gameWidget = new MultiplayerGameWidget(this, topicId);
-        gameWidget->setParent(ui->gamePlayPlaceHolder);
-        gameWidget->setGeometry(ui->gamePlayPlaceHolder->rect());
         gameWidget->show();
 
-        // Setup piano after widget is ready
+        // Setup piano after widget is ready; the widget connects its own key handlers
         if (piano && ui->pianoLocalPlaceholder) {
             piano->attachToPlaceholder(ui->pianoLocalPlaceholder);
-            connect(piano, &PianoWidget::keyPressed, gameWidget, &MultiplayerGameWidget::handleKeyPressed);
         }
     }
 }
@@ -310,61 +544,112 @@ void MainWindow::startAdaptiveQuiz()
     // First navigate to the quiz page screen (reusing the lessons page screen)
     navigationManager->navigateToLessonsPageScreen();
 
-    // Clean up old widget if it exists
-    if (quizWidget) {
-        if (piano) {
-            disconnect(piano, nullptr, quizWidget, nullptr);
-        }
-        quizWidget->deleteLater();
-        quizWidget = nullptr;
+    // The quiz widget and its engine are created once and reused by every quiz
+    if (!quizWidget) {
+        quizWidget = new QuizWidget(ui->lessonsPageScreen);
+        connect(quizWidget, &QuizWidget::quizFinished, navigationManager, &NavigationManager::navigateToQuizzes);
     }
 
-    // Create a new quiz widget
-    quizWidget = new QuizWidget(ui->lessonsPageScreen);
-    
-    // Connect the quiz finished signal
-    connect(quizWidget, &QuizWidget::quizFinished, navigationManager, &NavigationManager::navigateToQuizzes);
-
     // Explicitly attach the piano to the lessons page piano holder
     if (piano && ui->lessonsPagePianoHolder) {
         piano->attachToPlaceholder(ui->lessonsPagePianoHolder);
-        connect(piano, &PianoWidget::keyPressed, quizWidget, &QuizWidget::handleKeyPressed);
-        connect(piano, &PianoWidget::keyReleased, quizWidget, &QuizWidget::handleKeyReleased);
     }
 
-    // Start the quiz
+    // Start the quiz; it connects its own key handlers
     quizWidget->startQuiz();
 }
 
+/**
+ * @brief Asks whether to host or join an online match and starts it
+ * @details The host plays the general topic as player 1 and waits on the game
+ *          screen for a client; the client joins by address as player 2.
+ */
+void MainWindow::startOnlineMatch()
+{
+    const QStringList roles = {"Host a match", "Join a match"};
+    bool ok = false;
+    const QString role = QInputDialog::getItem(this, "Online Match", "Play as:", roles, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    if (!onlineMatch) {
+        onlineMatch = new OnlineMatch(this);
+    }
+
+    bool started = false;
+    if (role == roles[0]) {
+        started = onlineMatch->host(GameSession::GENERAL_TOPIC_ID);
+    } else {
+        const QString address = QInputDialog::getText(this, "Online Match", "Address of the host (host or host:port):",
+                                                      QLineEdit::Normal, QString(), &ok);
+        if (!ok || address.trimmed().isEmpty()) {
+            return;
+        }
+        started = onlineMatch->join(address);
+    }
+    if (!started) {
+        QMessageBox::warning(this, "Online Match", "The match could not be started. Check the address and your network connection.");
+        return;
+    }
+
+    // Same screen and widget as a local game; the widget follows the match instead
+    navigationManager->navigateToGamePlay();
+    if (!gameWidget) {
+        gameWidget = new MultiplayerGameWidget(this, GameSession::GENERAL_TOPIC_ID);
+        gameWidget->setParent(ui->gamePlayPlaceHolder);
+        gameWidget->setGeometry(ui->gamePlayPlaceHolder->rect());
+    }
+    gameWidget->startOnline(onlineMatch);
+    gameWidget->show();
+
+    auto piano = PianoWidget::instance();
+    if (piano && ui->pianoLocalPlaceholder) {
+        piano->attachToPlaceholder(ui->pianoLocalPlaceholder);
+    }
+}
+
 /**
  * @brief Handles page change events
  * @param newPage Pointer to the new page widget
- * @details Manages piano widget attachment/detachment and cleanup of game widgets
+ * @details Manages piano widget attachment/detachment and stops the game widgets
  *          when navigating between different pages.
  */
 void MainWindow::handlePageChange(QWidget* newPage)
 {
     auto piano = PianoWidget::instance();
 
+    // A recording or its playback ends with the free-style page
+    ui->recordButton->setChecked(false);
+    ui->playRecordingButton->setChecked(false);
+
+    // The synth load is only measured for the settings page
+    if (newPage == ui->settingsPage) {
+        showSynthLoad();
+        synthLoadTimer->start();
+    } else {
+        synthLoadTimer->stop();
+    }
+
     // First detach piano from its current location and reset its state
     if (piano) {
         piano->reset();  // Reset piano state before detaching
         piano->detach();
     }
+    if (noteVisualizer) {
+        noteVisualizer->detach();
+    }
 
     // Handle different page transitions
     if (newPage == ui->freeStylePage) {
         if (piano && ui->pianoPlaceholder) {
             piano->attachToPlaceholder(ui->pianoPlaceholder);
         }
+        attachVisualizer(ui->visualizerPlaceholder);
 
-        // Cleanup game widget if it exists
+        // Stop the game widget if it exists; it is reused by the next game
         if (gameWidget) {
-            if (piano) {
-                disconnect(piano, nullptr, gameWidget, nullptr);
-            }
-            gameWidget->deleteLater();
-            gameWidget = nullptr;
+            gameWidget->stop();
         }
     }
     else if (newPage == ui->lessonsPageScreen) {
@@ -373,6 +658,7 @@ void MainWindow::handlePageChange(QWidget* newPage)
         if (piano) {
             piano->detach();
         }
+        attachVisualizer(ui->lessonsVisualizerHolder);
     }
     else if (newPage == ui->localGamePlayScreen) {
         // For local game screen, we don't cleanup widgets as they are managed by the game screen
@@ -382,162 +668,84 @@ void MainWindow::handlePageChange(QWidget* newPage)
         }
     }
     else if (newPage == ui->statisticsPage) {
-        // Clean up old statistics widget if it exists
+        // The widget is built by the navigation manager; show the latest values
         if (statisticsWidget) {
-            statisticsWidget->deleteLater();
-            statisticsWidget = nullptr;
+            statisticsWidget->setQuizAnalytics(quizWidget ? quizWidget->scoring() : nullptr);
+            statisticsWidget->updateStatistics();
         }
-
-        // Create and setup new statistics widget
-        statisticsWidget = new StatisticsWidget(ui->statisticsPage);
-        statisticsWidget->setParent(ui->statisticsWidget);  // Use the frame from UI
-        statisticsWidget->setGeometry(ui->statisticsWidget->rect());
-        statisticsWidget->show();
     }
     else {
-        // For all other pages, cleanup all widgets
+        // For all other pages, stop all widgets; they are reused by the next session
         if (gameWidget) {
-            if (piano) {
-                disconnect(piano, nullptr, gameWidget, nullptr);
-            }
-            gameWidget->deleteLater();
-            gameWidget = nullptr;
+            gameWidget->stop();
         }
         if (lessonsWidget) {
-            if (piano) {
-                disconnect(piano, nullptr, lessonsWidget, nullptr);
-            }
-            lessonsWidget->deleteLater();
-            lessonsWidget = nullptr;
+            lessonsWidget->stop();
         }
-        if (statisticsWidget) {
-            statisticsWidget->deleteLater();
-            statisticsWidget = nullptr;
+        if (quizWidget) {
+            quizWidget->stop();
         }
     }
 }
 
 /**
- * @brief Scales all UI elements based on screen resolution
- * @details Adjusts the size and position of all buttons, labels, and frames
- *          to maintain proper proportions across different screen resolutions.
- *          Handles scaling for both 4K and standard resolutions, ensuring
- *          the UI remains consistent with the original design (1920x1080).
+ * @brief Exits the application
+ * @details Terminates the application by calling QCoreApplication::quit()
  */
-void MainWindow::scaleAllButtons()
+void MainWindow::exitApplication()
 {
-    // Get the primary screen
-    QScreen* screen = QGuiApplication::primaryScreen();
-    QSize screenSize = screen->size();
-
-    // Ensure we don't exceed 4K resolution
-    if (screenSize.width() > 3840 || screenSize.height() > 2160) {
-        double scaleX = 3840.0 / screenSize.width();
-        double scaleY = 2160.0 / screenSize.height();
-        double scale = qMin(scaleX, scaleY);
-
-        screenSize = QSize(screenSize.width() * scale, screenSize.height() * scale);
-    }
-
-    // scaling parameters of the UI when it was designed
-    int designWidth = 1920;
-    int designHeight = 1080;
-
-    QList<QComboBox*> boxes = {
-        ui->colourblindModeBox
-    };
-
-    QList<QSlider*> sliders = {
-        ui->musicVolumeSlider, ui->sfxVolumeSlider
-    };
-
-    QList<QLabel*> labels = {
-        ui->selectGameModeLabel, ui->selectLesson, ui->accuracyLabel,
-        ui->star1, ui->star2, ui->star3, ui->star4, ui->star5, ui->selectGameMode1, ui->descriptionLabel, ui->playerScoreLabel,
-        ui->titleLabel, ui->descriptionLabelLocal, ui->currentPlayerLabelLocal, ui->player1ScoreLabelLocal, ui->player2ScoreLabelLocal,
-        ui->titleLabelLocal, ui->selectQuizzesLabel, ui->settingsLabel, ui->settingsLabel
-    };
-
-    // Scale buttons only once
-    QList<QPushButton*> buttons = {
-        ui->lessonsButton, ui->quizzesButton, ui->statisticsButton,
-        ui->settingsButton, ui->exitButton, ui->multiplayerButton,
-        ui->returnFromLessonsButton, ui->returnFromSettingsButton,
-        ui->returnFromMultiplayerButton, ui->returnFromQuizzesButton,
-        ui->returnFromStatisticsButton, ui->onlineMatchButton,
-        ui->localMatchButton, ui->freeStyleButton, ui->lessonOneButton,
-        ui->lessonTwoButton, ui->lessonThreeButton, ui->lessonFourButton,
-        ui->lessonFiveButton, ui->lessonSixButton, ui->returnFromFreeStyleButton,
-        ui->generalGamePlay, ui->returnFromLocalButton, ui->returnToLocalGamePlayScreen,
-        ui->multiplayerMajorMinorChords, ui->Scales, ui->identifyingMajorThird, ui->Triad, ui->Rhythm, ui->ReturnToLessonsPage,
-        ui->resetButton
-    };
-
-    QList<QFrame*> frames = {
-        ui->pianoPlaceholder, ui->pianoLocalPlaceholder, ui->gamePlayPlaceHolder, ui->lessonsPlayPlaceHolder,
-        ui->lessonsPagePianoHolder, ui->settingsBackgroundFrame, ui->statisticsWidget
-    };
-
-    // Scale the stacked widget to fill the window
-    ui->stackedWidget->setGeometry(0, 0, screenSize.width(), screenSize.height());
-
-    for (QSlider* sld : sliders){
-        // Get the original geometry and scale it
-        QRect geo = sld->geometry();
-        MathUtils::scaleWidget(sld, geo.x(), geo.y(),
-                               geo.width(), geo.height(),
-                               screenSize.width(), screenSize.height(),
-                               designWidth, designHeight);
-    }
-
-    for (QComboBox* box : boxes){
-        // Get the original geometry and scale it
-        QRect geo = box->geometry();
-        MathUtils::scaleWidget(box, geo.x(), geo.y(),
-                               geo.width(), geo.height(),
-                               screenSize.width(), screenSize.height(),
-                               designWidth, designHeight);
-    }
-
-    for (QPushButton* btn : buttons) {
-        // Get the original geometry and scale it
-        QRect geo = btn->geometry();
-        MathUtils::scaleWidget(btn, geo.x(), geo.y(),
-                               geo.width(), geo.height(),
-                               screenSize.width(), screenSize.height(),
-                               designWidth, designHeight);
-    }
-
-    for (QLabel* lbl : labels) {
-        // Get the original geometry and scale it
-        QRect geo = lbl->geometry();
-        MathUtils::scaleWidget(lbl, geo.x(), geo.y(),
-                               geo.width(), geo.height(),
-                               screenSize.width(), screenSize.height(),
-                               designWidth, designHeight);
-    }
-
-    for (QFrame* frm : frames){
-        QRect geo = frm->geometry();
-        MathUtils::scaleWidget(frm, geo.x(), geo.y(),
-                               geo.width(), geo.height(),
-                               screenSize.width(), screenSize.height(),
-                               designWidth, designHeight);
-    }
+    QCoreApplication::quit();
 }
 
 /**
- * @brief Exits the application
- * @details Terminates the application by calling QCoreApplication::quit()
+ * @brief Scales the pages to the new window size
+ * @param event The resize event
+ * @details A move to another screen or a change of pixel ratio resizes the full
+ *          screen window; a resize to the size already laid out does nothing.
  */
-void MainWindow::exitApplication()
+void MainWindow::resizeEvent(QResizeEvent* event)
 {
-    QCoreApplication::quit();
+    QMainWindow::resizeEvent(event);
+    if (screenLayout) {
+        screenLayout->apply(ScreenLayout::targetSize(event->size()));
+    }
 }
 
 void MainWindow::showEvent(QShowEvent* event)
 {
     QMainWindow::showEvent(event);
-    // Start background music when the window is shown
-    SoundManager::instance()->startBackgroundMusic();
+    // Start background music when the window is shown again; the first time it is
+    // started by warmUp() after the first frame
+    if (warmedUp) {
+        SoundManager::instance()->startBackgroundMusic();
+    }
+}
+
+#ifdef KEYQUEST_TRACE
+/**
+ * @brief Sets up the trace overlay and its shortcuts
+ * @details F3 toggles the latency overlay, Ctrl+F3 writes the buffered spans to
+ *          trace-<date>.json and F4 writes the memory breakdown to memory-<date>.txt,
+ *          both in the application data folder.
+ */
+void MainWindow::setupTracing()
+{
+    TraceOverlay* overlay = new TraceOverlay(this);
+    connect(new QShortcut(QKeySequence(Qt::Key_F3), this), &QShortcut::activated,
+            overlay, &TraceOverlay::toggle);
+
+    connect(new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_F3), this), &QShortcut::activated, this, []() {
+        QString folder = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(folder);
+        QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+        Trace::writeChromeTrace(folder + "/trace-" + stamp + ".json");
+    });
+
+    connect(new QShortcut(QKeySequence(Qt::Key_F4), this), &QShortcut::activated, this, []() {
+        QString folder = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(folder);
+        QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss");
+        MemoryMonitor::instance()->writeReport(folder + "/memory-" + stamp + ".txt");
+    });
 }
+#endif
@@ -23,6 +23,9 @@ QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
+class NoteVisualizer;
+class ScreenLayout;
+
 /**
  * @brief Main window class for the KeyQuest application
  * 
@@ -43,6 +46,7 @@ public:
 
 protected:
     void showEvent(QShowEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
 
 private Q_SLOTS:
     /**
@@ -82,6 +86,10 @@ private Q_SLOTS:
      * @brief Starts the adaptive quiz
      */
     void startAdaptiveQuiz();
+    /**
+     * @brief Asks whether to host or join an online match and starts it
+     */
+    void startOnlineMatch();
     /**
      * @brief Starts a game with the specified topic ID
      * @param topicId The ID of the game topic to start
@@ -98,9 +106,30 @@ private:
      */
     void setupConnections();
     /**
-     * @brief Scales all buttons to fit the window
+     * @brief Loads one part of the deferred startup work
+     * @param step Index of the part to load; the next part is queued after it
+     */
+    void warmUp(int step);
+    /**
+     * @brief Shows an estimated key-to-sound latency on the settings page
+     * @param latencyMs The latency in milliseconds, or a negative value if unknown
+     */
+    void showLatency(double latencyMs);
+    /**
+     * @brief Shows the synthesizer's load and quality on the settings page
+     */
+    void showSynthLoad();
+    /**
+     * @brief Shows the note visualizer in a placeholder, creating it the first time
+     * @param placeholder The frame to show it in
+     */
+    void attachVisualizer(QFrame* placeholder);
+#ifdef KEYQUEST_TRACE
+    /**
+     * @brief Sets up the trace overlay and its shortcuts
      */
-    void scaleAllButtons();
+    void setupTracing();
+#endif
 
     Ui::MainWindow *ui;
     NavigationManager* navigationManager;
@@ -108,6 +137,11 @@ private:
     LessonsWidget* lessonsWidget;
     StatisticsWidget *statisticsWidget;
     QuizWidget* quizWidget;
+    OnlineMatch* onlineMatch;  ///< Transport of online matches, created by the first one
+    NoteVisualizer* noteVisualizer;  ///< Falling notes over the piano, created by the first page that shows it
+    ScreenLayout* screenLayout;  ///< Scales every page from its design geometry
+    QTimer* synthLoadTimer;  ///< Refreshes the synth load while the settings page is shown
+    bool warmedUp;  ///< Whether warmUp() has loaded everything deferred at startup
 };
 
 #endif // MAINWINDOW_H
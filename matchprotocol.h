@@ -0,0 +1,224 @@
+/**
+ * @file matchprotocol.h
+ * @brief Wire format of online matches
+ * @author Alan Cruz, Hadeed Pall
+ * @details This file defines the datagrams exchanged by OnlineMatch. Every datagram
+ *          is a MatchPacketHeader followed by the fixed-size payload of its type, so
+ *          the largest packet is 52 bytes and fits any Wi-Fi frame with room to spare.
+ *
+ *          Layout (all integers little-endian, times in nanoseconds on the host's
+ *          MidiEventQueue::now() clock). The structures hold host byte order in
+ *          memory; matchByteOrder() converts a payload right before it is sent and
+ *          right after it is received, so big-endian hosts interoperate too:
+ *          - Hello, client to host: MatchHello, repeated until a Welcome arrives;
+ *            the host ignores it unless the question banks match
+ *          - Welcome, host to client: MatchWelcome
+ *          - Ping, client to host: MatchPing; Pong, host to client: MatchPong
+ *          - Note, both ways: MatchNote, one per key press or release
+ *          - Attempt, client to host: MatchAttempt, repeated until a State acknowledges it
+ *          - State, host to client: MatchState, sent on every change and as a heartbeat
+ *          - Bye, both ways: no payload
+ *
+ *          Any change to these structures must bump MATCH_PROTOCOL_VERSION.
+ */
+
+#pragma once
+#include <cstdint>
+#include <QtEndian>
+
+/// Magic bytes at the start of every datagram
+constexpr char MATCH_MAGIC[2] = {'K', 'Q'};
+
+/// Version of the layout below; datagrams with any other version are dropped
+constexpr uint8_t MATCH_PROTOCOL_VERSION = 2;
+
+/// UDP port a host listens on unless another one is given
+constexpr uint16_t MATCH_DEFAULT_PORT = 45454;
+
+/// Set in MatchState::flags once the game is over
+constexpr uint8_t MATCH_STATE_GAME_OVER = 0x01;
+
+/// Set in MatchState::flags when the latest verdict was a correct answer
+constexpr uint8_t MATCH_STATE_VERDICT_CORRECT = 0x02;
+
+/**
+ * @brief Type of a datagram, stored in MatchPacketHeader::type
+ */
+enum MatchPacketType : uint8_t {
+    MatchHelloPacket = 1,
+    MatchWelcomePacket,
+    MatchPingPacket,
+    MatchPongPacket,
+    MatchNotePacket,
+    MatchAttemptPacket,
+    MatchStatePacket,
+    MatchByePacket
+};
+
+/**
+ * @brief Header at the start of every datagram
+ */
+struct MatchPacketHeader {
+    char magic[2];      ///< Always MATCH_MAGIC
+    uint8_t version;    ///< Always MATCH_PROTOCOL_VERSION
+    uint8_t type;       ///< A MatchPacketType
+};
+
+/**
+ * @brief Request of a client to join the host's match
+ */
+struct MatchHello {
+    uint32_t questionCount;  ///< Questions in the client's bank; both sides must use the same bank
+    uint32_t reserved;       ///< Padding, always 0
+    uint64_t bankHash;       ///< QuestionBank::contentHash() of the client's bank
+};
+
+/**
+ * @brief Answer of the host accepting a client as player 2
+ */
+struct MatchWelcome {
+    uint64_t seed;           ///< Seed of the host's session, for replaying it
+    int32_t topicID;         ///< Topic the match is played on
+    uint32_t questionCount;  ///< Questions in the host's bank
+    uint64_t bankHash;       ///< QuestionBank::contentHash() of the host's bank
+};
+
+/**
+ * @brief Clock probe sent by the client
+ */
+struct MatchPing {
+    int64_t clientSend;  ///< Client clock when the ping was sent
+};
+
+/**
+ * @brief Answer of the host to a MatchPing
+ * @details With the client's receive time this gives one NTP-style sample of the
+ *          clock offset and the round-trip time.
+ */
+struct MatchPong {
+    int64_t clientSend;   ///< MatchPing::clientSend, echoed
+    int64_t hostReceive;  ///< Host clock when the ping arrived
+    int64_t hostSend;     ///< Host clock when the pong was sent
+};
+
+/**
+ * @brief A key pressed or released by the player whose turn it is
+ */
+struct MatchNote {
+    int64_t time;        ///< When the key was played, on the host clock
+    uint8_t player;      ///< Player who played it (1 or 2)
+    uint8_t note;        ///< MIDI note number
+    uint8_t velocity;    ///< Note-on velocity, 0 for a release
+    uint8_t reserved[5]; ///< Padding, always 0
+};
+
+/**
+ * @brief An answer of the client, to be judged by the host
+ * @details The played notes are sent as the NoteSet masks, so the host judges them
+ *          exactly like a local attempt.
+ */
+struct MatchAttempt {
+    uint32_t attemptID;       ///< Increases with every attempt of the client
+    int32_t questionID;       ///< Question the attempt answers
+    int64_t shownTime;        ///< When the question appeared on the client, on the host clock
+    int64_t firstNoteTime;    ///< When the first note of the attempt was played, on the host clock
+    uint64_t midiMask[2];     ///< NoteSet::midiMask() of the played notes
+    uint16_t pitchClassMask;  ///< NoteSet::pitchClassMask() of the played notes
+    uint8_t flags;            ///< NoteSet::flags() of the played notes
+    uint8_t reserved[5];      ///< Padding, always 0
+};
+
+/**
+ * @brief Authoritative state of the host's MultiplayerGame
+ * @details Every State carries the whole replicated state, so a lost datagram is
+ *          repaired by the next one and the client never has to ask for a resend.
+ */
+struct MatchState {
+    uint32_t stateID;          ///< Increases with every change; older states are dropped
+    int32_t questionID;        ///< Question being asked, -1 if none
+    uint32_t ackedAttemptID;   ///< Latest MatchAttempt::attemptID the host has judged
+    uint32_t verdictID;        ///< Increases with every judged attempt of either player
+    int32_t reactionUs;        ///< Time from question to first note of the latest verdict
+    int16_t player1Score;      ///< Score of the host
+    int16_t player2Score;      ///< Score of the client
+    uint16_t questionsAsked;   ///< Questions moved past so far
+    uint8_t currentPlayer;     ///< Player whose turn it is (1 or 2)
+    uint8_t flags;             ///< MATCH_STATE_* flags
+    uint8_t verdictPlayer;     ///< Player of the latest verdict, 0 before the first one
+    uint8_t reserved[3];       ///< Padding, always 0
+};
+
+static_assert(sizeof(MatchPacketHeader) == 4, "Match header layout changed");
+static_assert(sizeof(MatchHello) == 16, "Match hello layout changed");
+static_assert(sizeof(MatchWelcome) == 24, "Match welcome layout changed");
+static_assert(sizeof(MatchPong) == 24, "Match pong layout changed");
+static_assert(sizeof(MatchNote) == 16, "Match note layout changed");
+static_assert(sizeof(MatchAttempt) == 48, "Match attempt layout changed");
+static_assert(sizeof(MatchState) == 32, "Match state layout changed");
+
+/**
+ * @brief Converts payloads between host and little-endian wire byte order
+ * @param packet The payload, converted in place
+ * @details Swapping bytes is its own inverse, so the same call prepares a payload
+ *          for sending and fixes one up after receiving it. On little-endian hosts
+ *          it does nothing. Single bytes and padding are left alone.
+ */
+inline void matchByteOrder(MatchHello& packet)
+{
+    packet.questionCount = qToLittleEndian(packet.questionCount);
+    packet.bankHash = qToLittleEndian(packet.bankHash);
+}
+
+/// @copydoc matchByteOrder(MatchHello&)
+inline void matchByteOrder(MatchWelcome& packet)
+{
+    packet.seed = qToLittleEndian(packet.seed);
+    packet.topicID = qToLittleEndian(packet.topicID);
+    packet.questionCount = qToLittleEndian(packet.questionCount);
+    packet.bankHash = qToLittleEndian(packet.bankHash);
+}
+
+/// @copydoc matchByteOrder(MatchHello&)
+inline void matchByteOrder(MatchPing& packet)
+{
+    packet.clientSend = qToLittleEndian(packet.clientSend);
+}
+
+/// @copydoc matchByteOrder(MatchHello&)
+inline void matchByteOrder(MatchPong& packet)
+{
+    packet.clientSend = qToLittleEndian(packet.clientSend);
+    packet.hostReceive = qToLittleEndian(packet.hostReceive);
+    packet.hostSend = qToLittleEndian(packet.hostSend);
+}
+
+/// @copydoc matchByteOrder(MatchHello&)
+inline void matchByteOrder(MatchNote& packet)
+{
+    packet.time = qToLittleEndian(packet.time);
+}
+
+/// @copydoc matchByteOrder(MatchHello&)
+inline void matchByteOrder(MatchAttempt& packet)
+{
+    packet.attemptID = qToLittleEndian(packet.attemptID);
+    packet.questionID = qToLittleEndian(packet.questionID);
+    packet.shownTime = qToLittleEndian(packet.shownTime);
+    packet.firstNoteTime = qToLittleEndian(packet.firstNoteTime);
+    packet.midiMask[0] = qToLittleEndian(packet.midiMask[0]);
+    packet.midiMask[1] = qToLittleEndian(packet.midiMask[1]);
+    packet.pitchClassMask = qToLittleEndian(packet.pitchClassMask);
+}
+
+/// @copydoc matchByteOrder(MatchHello&)
+inline void matchByteOrder(MatchState& packet)
+{
+    packet.stateID = qToLittleEndian(packet.stateID);
+    packet.questionID = qToLittleEndian(packet.questionID);
+    packet.ackedAttemptID = qToLittleEndian(packet.ackedAttemptID);
+    packet.verdictID = qToLittleEndian(packet.verdictID);
+    packet.reactionUs = qToLittleEndian(packet.reactionUs);
+    packet.player1Score = qToLittleEndian(packet.player1Score);
+    packet.player2Score = qToLittleEndian(packet.player2Score);
+    packet.questionsAsked = qToLittleEndian(packet.questionsAsked);
+}
@@ -9,30 +9,23 @@
 #include "mathutils.h"
 
 /**
- * @brief Scales a widget's position and size based on screen resolution
- * @param widget Pointer to the widget to scale
- * @param x Original x position in design resolution
- * @param y Original y position in design resolution
- * @param w Original width in design resolution
- * @param h Original height in design resolution
- * @param screenWidth Current screen width
- * @param screenHeight Current screen height
- * @param designWidth Original design width (typically 1920)
- * @param designHeight Original design height (typically 1080)
- * @details Calculates the scaled position and size of a widget based on the ratio
- *          between the current screen resolution and the original design resolution.
- *          This ensures UI elements maintain their relative positions and sizes
- *          across different screen sizes.
+ * @brief Scales a rectangle from the design resolution to the screen
+ * @param rect The rectangle at the design resolution
+ * @param screenSize Current screen size
+ * @param designSize Original design size (typically 1920x1080)
+ * @return The scaled rectangle
+ * @details Calculates the scaled position and size based on the ratio between the
+ *          current screen resolution and the original design resolution. This
+ *          ensures UI elements maintain their relative positions and sizes across
+ *          different screen sizes.
  */
-void MathUtils::scaleWidget(QWidget *widget, int x, int y, int w, int h,
-                            int screenWidth, int screenHeight,
-                            int designWidth, int designHeight)
+QRect MathUtils::scaleRect(const QRect& rect, const QSize& screenSize, const QSize& designSize)
 {
     // Scale position and size relative to design resolution
-    int scaledX = (x * screenWidth) / designWidth;
-    int scaledY = (y * screenHeight) / designHeight;
-    int scaledW = (w * screenWidth) / designWidth;
-    int scaledH = (h * screenHeight) / designHeight;
+    int scaledX = (rect.x() * screenSize.width()) / designSize.width();
+    int scaledY = (rect.y() * screenSize.height()) / designSize.height();
+    int scaledW = (rect.width() * screenSize.width()) / designSize.width();
+    int scaledH = (rect.height() * screenSize.height()) / designSize.height();
 
-    widget->setGeometry(scaledX, scaledY, scaledW, scaledH);
+    return QRect(scaledX, scaledY, scaledW, scaledH);
 }
@@ -11,7 +11,8 @@
 #ifndef MATHUTILS_H
 #define MATHUTILS_H
 
-#include <QWidget>
+#include <QRect>
+#include <QSize>
 
 /**
  * @brief Class containing utility functions for mathematical operations
@@ -20,22 +21,14 @@
  */
 class MathUtils {
 public:
-    // Function to scale a widget's position and size based on screen size
     /**
-     * @brief Scales a widget's position and size based on screen size
-     * @param widget The widget to scale
-     * @param x The x-coordinate position
-     * @param y The y-coordinate position
-     * @param w The width of the widget
-     * @param h The height of the widget
-     * @param screenWidth The current screen width
-     * @param screenHeight The current screen height
-     * @param designWidth The design-time width
-     * @param designHeight The design-time height
+     * @brief Scales a rectangle from the design resolution to the screen
+     * @param rect The rectangle at the design resolution
+     * @param screenSize The current screen size
+     * @param designSize The design-time size
+     * @return The scaled rectangle
      */
-    static void scaleWidget(QWidget *widget, int x, int y, int w, int h,
-                            int screenWidth, int screenHeight,
-                            int designWidth, int designHeight);
+    static QRect scaleRect(const QRect& rect, const QSize& screenSize, const QSize& designSize);
 };
 
 #endif // MATHUTILS_H
@@ -0,0 +1,253 @@
+/**
+ * @file memorymonitor.cpp
+ * @brief Implementation of the MemoryMonitor class
+ * @author Alan Cruz
+ * @details This file implements the memory breakdown, the budget checks and the
+ *          report of the memory monitor.
+ */
+
+#include "memorymonitor.h"
+#include "loaddatamanager.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QJsonObject>
+#include <QPixmap>
+#include <QStandardPaths>
+#include <QTextStream>
+
+MemoryMonitor* MemoryMonitor::m_instance = nullptr;
+
+/**
+ * @brief Formats a byte count for the report
+ * @param bytes The count
+ * @return The count in MiB with one decimal
+ */
+static QString formatMiB(qint64 bytes)
+{
+    return QString::number(bytes / (1024.0 * 1024.0), 'f', 1);
+}
+
+/**
+ * @brief Gets the application-wide monitor
+ * @return The monitor, created the first time it is requested
+ */
+MemoryMonitor* MemoryMonitor::instance()
+{
+    if (!m_instance) {
+        m_instance = new MemoryMonitor();
+    }
+    return m_instance;
+}
+
+/**
+ * @brief Creates the monitor
+ * @details The checks start with the first source.
+ */
+MemoryMonitor::MemoryMonitor()
+{
+    m_checkTimer.setInterval(CHECK_INTERVAL_MS);
+    connect(&m_checkTimer, &QTimer::timeout, this, &MemoryMonitor::check);
+}
+
+/**
+ * @brief Gets the memory of a decoded pixmap
+ * @param pixmap The pixmap
+ * @return Width times height times bytes per pixel, 0 for a null pixmap
+ */
+qint64 MemoryMonitor::pixmapBytes(const QPixmap& pixmap)
+{
+    if (pixmap.isNull()) {
+        return 0;
+    }
+    return qint64(pixmap.width()) * pixmap.height() * ((pixmap.depth() + 7) / 8);
+}
+
+/**
+ * @brief Registers a source and starts the budget checks
+ * @param name Name it is reported and budgeted under
+ * @param usage Reports the bytes it holds
+ * @param evict Frees its caches; empty if it has nothing to free
+ */
+void MemoryMonitor::addSource(const QString& name, UsageFunction usage, EvictFunction evict)
+{
+    if (!usage) {
+        qDebug() << "MemoryMonitor: Source without a usage function:" << name;
+        return;
+    }
+    if (Source* source = findSource(name)) {
+        source->usage = std::move(usage);
+        source->evict = std::move(evict);
+    } else {
+        m_sources.push_back({name, std::move(usage), std::move(evict)});
+    }
+    if (!m_checkTimer.isActive()) {
+        m_checkTimer.start();
+    }
+}
+
+/**
+ * @brief Sets the budget of a source
+ * @param name Name of the source, or TOTAL
+ * @param bytes The budget; 0 removes it
+ */
+void MemoryMonitor::setBudget(const QString& name, qint64 bytes)
+{
+    if (bytes > 0) {
+        m_budgets.insert(name, bytes);
+    } else {
+        m_budgets.remove(name);
+    }
+}
+
+/**
+ * @brief Sets the budgets from the settings
+ * @details Budgets that are not numbers are ignored.
+ */
+void MemoryMonitor::loadBudgets()
+{
+    m_budgets.clear();
+    const QJsonObject budgets = LoadDataManager::instance()->getMemoryBudgets();
+    for (auto it = budgets.constBegin(); it != budgets.constEnd(); ++it) {
+        if (it.value().isDouble()) {
+            setBudget(it.key(), qint64(it.value().toDouble() * 1024 * 1024));
+        }
+    }
+}
+
+/**
+ * @brief Finds a source by name
+ * @param name Name of the source
+ * @return The source, or nullptr
+ */
+MemoryMonitor::Source* MemoryMonitor::findSource(const QString& name)
+{
+    for (Source& source : m_sources) {
+        if (source.name == name) {
+            return &source;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Takes the current breakdown
+ * @return One entry per source in the order they were added
+ */
+std::vector<MemoryMonitor::Entry> MemoryMonitor::snapshot() const
+{
+    std::vector<Entry> entries;
+    entries.reserve(m_sources.size());
+    for (const Source& source : m_sources) {
+        entries.push_back({source.name, source.usage(), m_budgets.value(source.name)});
+    }
+    return entries;
+}
+
+/**
+ * @brief Formats the current breakdown
+ * @return One line per source with its budget, and a total line
+ */
+QString MemoryMonitor::report() const
+{
+    QString text;
+    QTextStream out(&text);
+    qint64 total = 0;
+    out << "source           MiB    budget\n";
+    for (const Entry& entry : snapshot()) {
+        total += entry.bytes;
+        out << entry.name.leftJustified(12) << qSetFieldWidth(9) << formatMiB(entry.bytes)
+            << qSetFieldWidth(10) << (entry.budget > 0 ? formatMiB(entry.budget) : QString("-"))
+            << qSetFieldWidth(0) << "\n";
+    }
+    const qint64 totalBudget = m_budgets.value(TOTAL);
+    out << QString(TOTAL).leftJustified(12) << qSetFieldWidth(9) << formatMiB(total)
+        << qSetFieldWidth(10) << (totalBudget > 0 ? formatMiB(totalBudget) : QString("-"))
+        << qSetFieldWidth(0) << "\n";
+    return text;
+}
+
+/**
+ * @brief Writes the current breakdown to a file
+ * @param path The file
+ * @return true if it was written
+ */
+bool MemoryMonitor::writeReport(const QString& path) const
+{
+    QFile file(path);
+    const QByteArray text = report().toUtf8();
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text) || file.write(text) != text.size()) {
+        qDebug() << "MemoryMonitor: Failed to write the memory report to:" << path;
+        return false;
+    }
+    qDebug() << "Memory report written to" << path;
+    return true;
+}
+
+/**
+ * @brief Finds the report flag in the command line
+ * @param arguments The application's arguments
+ * @return true if "--memory-report" or "--memory-report=<file>" was given
+ */
+bool MemoryMonitor::reportFromArguments(const QStringList& arguments)
+{
+    static const QString flag = "--memory-report";
+    for (const QString& argument : arguments) {
+        if (argument != flag && !argument.startsWith(flag + "=")) {
+            continue;
+        }
+
+        QString path = argument.mid(flag.size() + 1);
+        if (path.isEmpty()) {
+            QString folder = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+            QDir().mkpath(folder);
+            path = folder + "/memory-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".txt";
+        }
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this,
+                [this, path]() { writeReport(path); });
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Compares the sources with their budgets and frees caches over them
+ * @details Each source is asked at most once per check. The total is taken
+ *          after the sources over their own budgets have been freed.
+ */
+void MemoryMonitor::check()
+{
+    std::vector<bool> evicted(m_sources.size(), false);
+    qint64 total = 0;
+    for (size_t i = 0; i < m_sources.size(); ++i) {
+        Source& source = m_sources[i];
+        qint64 bytes = source.usage();
+        const qint64 budget = m_budgets.value(source.name);
+        if (budget > 0 && bytes > budget && source.evict) {
+            qDebug() << "MemoryMonitor:" << source.name << "holds" << formatMiB(bytes)
+                     << "MiB, over its budget of" << formatMiB(budget) << "MiB";
+            source.evict();
+            evicted[i] = true;
+            bytes = source.usage();
+        }
+        total += bytes;
+    }
+
+    const qint64 totalBudget = m_budgets.value(TOTAL);
+    if (totalBudget <= 0 || total <= totalBudget) {
+        return;
+    }
+    qDebug() << "MemoryMonitor: Holding" << formatMiB(total) << "MiB, over the total budget of"
+             << formatMiB(totalBudget) << "MiB";
+    for (size_t i = 0; i < m_sources.size() && total > totalBudget; ++i) {
+        Source& source = m_sources[i];
+        if (!source.evict || evicted[i]) {
+            continue;
+        }
+        const qint64 before = source.usage();
+        source.evict();
+        total -= before - source.usage();
+    }
+}
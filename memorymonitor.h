@@ -0,0 +1,160 @@
+/**
+ * @file memorymonitor.h
+ * @brief Header file for the MemoryMonitor class
+ * @author Alan Cruz
+ * @details This file defines MemoryMonitor, which keeps a per-subsystem account of
+ *          the memory the application holds and frees caches when a subsystem, or
+ *          the application as a whole, goes over its budget.
+ */
+
+#ifndef MEMORYMONITOR_H
+#define MEMORYMONITOR_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <functional>
+#include <vector>
+
+class QPixmap;
+
+/**
+ * @brief Per-subsystem memory breakdown with budgets
+ * @details Each subsystem registers a source with addSource(): a function that
+ *          reports the bytes it holds and, for caches that can be rebuilt, a
+ *          function that frees them. The figures are estimates from what the
+ *          subsystem owns (decoded pixmaps, sample data, container capacities), not
+ *          measurements of the heap, so they are cheap enough to take every check.
+ *
+ *          Every CHECK_INTERVAL_MS the sources are compared with their budgets. A
+ *          source over its own budget is asked to free its cache; when the total is
+ *          over the "total" budget, every source that can free something is asked,
+ *          in the order they were added. Budgets are set in megabytes in the
+ *          "memoryBudgets" object of the settings; a missing budget means none.
+ *
+ *          report() formats the breakdown as a table. "--memory-report[=<file>]"
+ *          writes it when the application quits, and trace builds show it in the
+ *          trace overlay.
+ */
+class MemoryMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int CHECK_INTERVAL_MS = 5000;  ///< Time between two budget checks
+    static constexpr const char* TOTAL = "total";   ///< Name of the budget for all sources together
+
+    /// Reports the bytes a source holds
+    using UsageFunction = std::function<qint64()>;
+
+    /// Frees what a source can rebuild later
+    using EvictFunction = std::function<void()>;
+
+    /**
+     * @brief Memory of one source at one moment
+     */
+    struct Entry {
+        QString name;      ///< Name of the source
+        qint64 bytes = 0;  ///< Bytes it holds
+        qint64 budget = 0; ///< Its budget in bytes, 0 if it has none
+    };
+
+    /**
+     * @brief Gets the application-wide monitor
+     * @return The monitor
+     */
+    static MemoryMonitor* instance();
+
+    /**
+     * @brief Gets the memory of a decoded pixmap
+     * @param pixmap The pixmap
+     * @return Width times height times bytes per pixel, 0 for a null pixmap
+     */
+    static qint64 pixmapBytes(const QPixmap& pixmap);
+
+    /**
+     * @brief Registers a source and starts the budget checks
+     * @param name Name it is reported and budgeted under, e.g. "images"
+     * @param usage Reports the bytes it holds; called on the GUI thread
+     * @param evict Frees its caches; empty if it has nothing to free
+     * @details A source registered again under the same name is replaced.
+     */
+    void addSource(const QString& name, UsageFunction usage, EvictFunction evict = EvictFunction());
+
+    /**
+     * @brief Sets the budget of a source
+     * @param name Name of the source, or TOTAL; it need not be added yet
+     * @param bytes The budget; 0 removes it
+     */
+    void setBudget(const QString& name, qint64 bytes);
+
+    /**
+     * @brief Sets the budgets from the settings
+     * @details Reads LoadDataManager::getMemoryBudgets(), in megabytes.
+     */
+    void loadBudgets();
+
+    /**
+     * @brief Takes the current breakdown
+     * @return One entry per source in the order they were added
+     */
+    std::vector<Entry> snapshot() const;
+
+    /**
+     * @brief Formats the current breakdown
+     * @return One line per source and a total line
+     */
+    QString report() const;
+
+    /**
+     * @brief Writes the current breakdown to a file
+     * @param path The file
+     * @return true if it was written
+     */
+    bool writeReport(const QString& path) const;
+
+    /**
+     * @brief Finds the report flag in the command line
+     * @param arguments The application's arguments
+     * @return true if "--memory-report" or "--memory-report=<file>" was given
+     * @details Writes the report when the application is about to quit, to the
+     *          file given or to memory-<date>.txt in the application data folder.
+     */
+    bool reportFromArguments(const QStringList& arguments);
+
+public Q_SLOTS:
+    /**
+     * @brief Compares the sources with their budgets and frees caches over them
+     */
+    void check();
+
+private:
+    /**
+     * @brief A registered source
+     */
+    struct Source {
+        QString name;         ///< Name it is reported under
+        UsageFunction usage;  ///< Reports its bytes
+        EvictFunction evict;  ///< Frees its caches, may be empty
+    };
+
+    /**
+     * @brief Creates the monitor
+     */
+    MemoryMonitor();
+
+    /**
+     * @brief Finds a source by name
+     * @param name Name of the source
+     * @return The source, or nullptr
+     */
+    Source* findSource(const QString& name);
+
+    static MemoryMonitor* m_instance;  ///< The application-wide instance
+    std::vector<Source> m_sources;     ///< Sources in the order they were added
+    QHash<QString, qint64> m_budgets;  ///< Budget in bytes by source name and TOTAL
+    QTimer m_checkTimer;               ///< Drives check()
+};
+
+#endif // MEMORYMONITOR_H
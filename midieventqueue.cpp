@@ -0,0 +1,60 @@
+/**
+ * @file midieventqueue.cpp
+ * @brief Implementation of the MidiEventQueue class
+ * @author Alan Cruz
+ * @details This file implements the lock-free ring buffer between the GUI thread
+ *          and the audio callback.
+ */
+
+#include "midieventqueue.h"
+#include <chrono>
+
+/**
+ * @brief Gets the current time on the clock used for MidiEvent::time
+ * @return Monotonic time in nanoseconds
+ */
+qint64 MidiEventQueue::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Adds an event to the back of the queue
+ * @param event The event
+ * @return false if the queue is full and the event was dropped
+ */
+bool MidiEventQueue::push(const MidiEvent& event)
+{
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == CAPACITY) {
+        return false;
+    }
+    m_events[tail & (CAPACITY - 1)] = event;
+
+    // Publish the slot only after it has been written
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Gets the event at the front of the queue without removing it
+ * @return The event, or nullptr if the queue is empty
+ */
+const MidiEvent* MidiEventQueue::peek() const
+{
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    return &m_events[head & (CAPACITY - 1)];
+}
+
+/**
+ * @brief Removes the event at the front of the queue
+ */
+void MidiEventQueue::pop()
+{
+    // Hand the slot back to the producer once the event has been read
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
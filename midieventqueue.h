@@ -0,0 +1,82 @@
+/**
+ * @file midieventqueue.h
+ * @brief Header file for the MidiEventQueue class
+ * @author Alan Cruz
+ * @details This file defines MidiEvent and MidiEventQueue, the lock-free channel
+ *          that carries note events from the GUI and MIDI input threads to the
+ *          FluidSynth audio callback.
+ */
+
+#ifndef MIDIEVENTQUEUE_H
+#define MIDIEVENTQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief A timestamped MIDI event
+ */
+struct MidiEvent {
+    /// Kind of event
+    enum Type : quint8 {
+        NoteOn,
+        NoteOff,
+        ControlChange
+    };
+
+    Type type = NoteOn;   ///< Kind of event
+    quint8 channel = 0;   ///< MIDI channel (0-15)
+    quint8 key = 0;       ///< MIDI note number (0-127), or the controller of a ControlChange
+    quint8 velocity = 0;  ///< Note-on velocity (0-127), or the value of a ControlChange
+    quint16 sequence = 0; ///< Keyboard sequence that scheduled the event, 0 for live notes
+    qint64 time = 0;      ///< When to play it, from MidiEventQueue::now(); 0 plays it as soon as possible
+};
+
+/**
+ * @brief Single-producer, single-consumer lock-free queue of MIDI events
+ * @details A fixed-size ring buffer. One thread may push and one other thread may
+ *          peek and pop at the same time without any locking; neither side ever
+ *          blocks or allocates, so the consumer can run inside an audio callback.
+ *          Events leave the queue in the order they were pushed.
+ */
+class MidiEventQueue {
+public:
+    static constexpr std::size_t CAPACITY = 1024;  ///< Number of slots, a power of two
+
+    /**
+     * @brief Gets the current time on the clock used for MidiEvent::time
+     * @return Monotonic time in nanoseconds
+     */
+    static qint64 now();
+
+    /**
+     * @brief Adds an event to the back of the queue
+     * @param event The event
+     * @return false if the queue is full and the event was dropped
+     * @details Producer side only.
+     */
+    bool push(const MidiEvent& event);
+
+    /**
+     * @brief Gets the event at the front of the queue without removing it
+     * @return The event, or nullptr if the queue is empty
+     * @details Consumer side only. The pointer stays valid until pop().
+     */
+    const MidiEvent* peek() const;
+
+    /**
+     * @brief Removes the event at the front of the queue
+     * @details Consumer side only. Must follow a peek() that returned an event.
+     */
+    void pop();
+
+private:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    MidiEvent m_events[CAPACITY];
+    alignas(64) std::atomic<std::size_t> m_head{0};  ///< Next slot to read, written by the consumer
+    alignas(64) std::atomic<std::size_t> m_tail{0};  ///< Next slot to write, written by the producer
+};
+
+#endif // MIDIEVENTQUEUE_H
@@ -0,0 +1,137 @@
+/**
+ * @file midiinput.cpp
+ * @brief Implementation of the MidiInput class
+ * @author Alan Cruz
+ * @details This file implements reading external MIDI keyboards with FluidSynth's
+ *          MIDI driver.
+ */
+
+#include "midiinput.h"
+#include "keyboard.h"
+#include <QDebug>
+#include <QMetaObject>
+
+/// MIDI status of a note-on message, without the channel
+static constexpr int MIDI_NOTE_ON = 0x90;
+/// MIDI status of a note-off message, without the channel
+static constexpr int MIDI_NOTE_OFF = 0x80;
+/// MIDI status of a control change message, without the channel
+static constexpr int MIDI_CONTROL_CHANGE = 0xB0;
+
+/**
+ * @brief Creates the input; nothing is read before start()
+ * @param keyboard The synthesizer the notes are played on
+ * @param parent The parent QObject
+ */
+MidiInput::MidiInput(Keyboard* keyboard, QObject* parent)
+    : QObject(parent)
+    , keyboard(keyboard)
+{
+}
+
+/**
+ * @brief Closes the MIDI driver
+ * @details Deleting the driver joins its thread, so no callback runs afterwards.
+ */
+MidiInput::~MidiInput()
+{
+    delete_fluid_midi_driver(driver);
+    delete_fluid_settings(settings);
+}
+
+/**
+ * @brief Opens the MIDI driver and connects to the available keyboards
+ * @return true if the driver was opened
+ * @details Without a MIDI device or backend the application keeps working with
+ *          the mouse and computer keyboard only.
+ */
+bool MidiInput::start()
+{
+    if (driver) {
+        return true;
+    }
+    if (!settings) {
+        settings = new_fluid_settings();
+        if (!settings) {
+            qDebug() << "MidiInput: Failed to create FluidSynth settings";
+            return false;
+        }
+        fluid_settings_setstr(settings, "midi.portname", "KeyQuest");
+        // Connect to every keyboard that is plugged in (FluidSynth 2.2 and later)
+        fluid_settings_setint(settings, "midi.autoconnect", 1);
+    }
+
+    driver = new_fluid_midi_driver(settings, &MidiInput::handleMidiEvent, this);
+    if (!driver) {
+        qDebug() << "MidiInput: No MIDI input available";
+        return false;
+    }
+    qDebug() << "MidiInput: Listening for MIDI keyboards";
+    return true;
+}
+
+/**
+ * @brief MIDI driver callback
+ * @param data The MidiInput
+ * @param event The received event
+ * @return FLUID_OK
+ * @details Runs on the MIDI driver's thread. A note-on with velocity 0 is a
+ *          note-off. Only the first event after a drain posts a call to the GUI
+ *          thread, so a chord costs one queued call. A note-on while the audio is
+ *          suspended first requests the wake-up, which the GUI thread then handles
+ *          before the drain.
+ */
+int MidiInput::handleMidiEvent(void* data, fluid_midi_event_t* event)
+{
+    MidiInput* self = static_cast<MidiInput*>(data);
+
+    MidiEvent midiEvent;
+    midiEvent.time = MidiEventQueue::now();
+    midiEvent.key = static_cast<quint8>(fluid_midi_event_get_key(event) & 0x7F);
+    midiEvent.velocity = static_cast<quint8>(fluid_midi_event_get_velocity(event) & 0x7F);
+
+    switch (fluid_midi_event_get_type(event)) {
+    case MIDI_NOTE_ON:
+        midiEvent.type = midiEvent.velocity > 0 ? MidiEvent::NoteOn : MidiEvent::NoteOff;
+        break;
+    case MIDI_NOTE_OFF:
+        midiEvent.type = MidiEvent::NoteOff;
+        break;
+    case MIDI_CONTROL_CHANGE:
+        midiEvent.type = MidiEvent::ControlChange;
+        midiEvent.key = static_cast<quint8>(fluid_midi_event_get_control(event) & 0x7F);
+        midiEvent.velocity = static_cast<quint8>(fluid_midi_event_get_value(event) & 0x7F);
+        self->keyboard->queueExternalEvent(midiEvent);
+        return FLUID_OK;
+    default:
+        return FLUID_OK;
+    }
+
+    self->keyboard->queueExternalEvent(midiEvent);
+    if (midiEvent.type == MidiEvent::NoteOn && self->keyboard->isAudioSuspended()) {
+        emit self->wakeRequested();
+    }
+    if (self->guiEvents.push(midiEvent) && !self->drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(self, [self]() { self->drain(); }, Qt::QueuedConnection);
+    }
+    return FLUID_OK;
+}
+
+/**
+ * @brief Emits the events collected for the GUI thread
+ * @details Clears the flag before reading, so an event pushed while draining
+ *          schedules another call instead of being left behind.
+ */
+void MidiInput::drain()
+{
+    drainScheduled.store(false, std::memory_order_release);
+    while (const MidiEvent* event = guiEvents.peek()) {
+        const MidiEvent received = *event;
+        guiEvents.pop();
+        if (received.type == MidiEvent::NoteOn) {
+            emit noteOn(received.key, received.velocity, received.time);
+        } else {
+            emit noteOff(received.key, received.time);
+        }
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * @file midiinput.h
+ * @brief Header file for the MidiInput class
+ * @author Alan Cruz
+ * @details This file defines MidiInput, which reads an external MIDI keyboard
+ *          through FluidSynth's MIDI driver and plays and reports its notes.
+ */
+
+#ifndef MIDIINPUT_H
+#define MIDIINPUT_H
+
+#include <QObject>
+#include <fluidsynth.h>
+#include <atomic>
+#include "midieventqueue.h"
+
+class Keyboard;
+
+/**
+ * @brief Input from USB and other external MIDI keyboards
+ * @details FluidSynth's MIDI driver (ALSA sequencer on Linux, CoreMIDI on macOS,
+ *          WinMM on Windows) calls handleMidiEvent() on its own thread. Every note
+ *          is stamped with MidiEventQueue::now() on arrival and goes two ways
+ *          without taking a lock:
+ *          - straight to the audio callback through Keyboard::queueExternalEvent(),
+ *            with the key's velocity, so the sound does not depend on the GUI
+ *            thread being idle
+ *          - into a lock-free queue for the GUI thread, which is drained in one
+ *            queued call and emitted as noteOn() and noteOff()
+ *
+ *          A key pressed while the keyboard's audio driver is suspended also emits
+ *          wakeRequested() from the MIDI thread, ahead of the drain, so the driver is
+ *          reopened before the GUI thread sees the note; the note itself waits in
+ *          the keyboard's queue and is played by the reopened driver.
+ *
+ *          The sustain pedal and other controllers are passed to the synthesizer
+ *          as well. Every channel is played on channel 0, the piano.
+ */
+class MidiInput : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Creates the input; nothing is read before start()
+     * @param keyboard The synthesizer the notes are played on
+     * @param parent The parent QObject
+     */
+    explicit MidiInput(Keyboard* keyboard, QObject* parent = nullptr);
+
+    /**
+     * @brief Closes the MIDI driver
+     */
+    ~MidiInput();
+
+    /**
+     * @brief Opens the MIDI driver and connects to the available keyboards
+     * @return true if the driver was opened
+     */
+    bool start();
+
+    /**
+     * @brief Checks whether the MIDI driver is open
+     * @return true while notes can be received
+     */
+    bool isActive() const { return driver != nullptr; }
+
+Q_SIGNALS:
+    /**
+     * @brief Emitted on the GUI thread when a key is pressed
+     * @param note The MIDI note
+     * @param velocity Note-on velocity (1-127)
+     * @param time When the key was pressed, from MidiEventQueue::now()
+     */
+    void noteOn(int note, int velocity, qint64 time);
+
+    /**
+     * @brief Emitted on the GUI thread when a key is released
+     * @param note The MIDI note
+     * @param time When the key was released, from MidiEventQueue::now()
+     */
+    void noteOff(int note, qint64 time);
+
+    /**
+     * @brief Emitted on the MIDI thread when a key is pressed while the audio is suspended
+     * @details Connect it with a queued connection to what resumes the audio,
+     *          IdleManager::notifyActivity().
+     */
+    void wakeRequested();
+
+private:
+    /**
+     * @brief MIDI driver callback
+     * @param data The MidiInput
+     * @param event The received event
+     * @return FLUID_OK
+     */
+    static int handleMidiEvent(void* data, fluid_midi_event_t* event);
+
+    /**
+     * @brief Emits the events collected for the GUI thread
+     */
+    void drain();
+
+    Keyboard* keyboard;                            // Plays the received notes
+    fluid_settings_t* settings = nullptr;          // Settings of the MIDI driver
+    fluid_midi_driver_t* driver = nullptr;         // Calls handleMidiEvent() on its thread
+    MidiEventQueue guiEvents;                      // MIDI thread to GUI thread
+    std::atomic<bool> drainScheduled{false};       // Whether a drain() call is queued
+};
+
+#endif // MIDIINPUT_H
@@ -13,58 +13,40 @@
 
 #include <QtCore/QString>
 #include <QtCore/QObject>
-#include <QJsonDocument>
-#include <QtCore/QJsonObject>
-#include <QtCore/QJsonArray>
-#include <QVector>
-
-/**
- * @brief Structure representing a game question
- */
-struct MultiplayerQuestion {
-    int questionID;
-    QString title;
-    QString description;
-    QString expectedInput;
-};
+#include "gamesession.h"
 
 /**
  * @brief Class managing the multiplayer game logic
  * 
- * Handles game state, question management, scoring, and turn management
- * for two players competing in the game
+ * Handles scoring and turn management for two players competing on the
+ * shuffled questions of a topic. A player keeps the turn while answering
+ * correctly; a wrong answer passes the same question to the other player.
+ * The question loop and answer matching are provided by GameSession.
  */
-class MultiplayerGame: public QObject
+class MultiplayerGame: public GameSession
 {
     Q_OBJECT
 public:
-    // Topic IDs
-    static const int GENERAL_TOPIC_ID = 101;
-    static const int MAJOR_MINOR_CHORDS_TOPIC_ID = 102;
-    static const int TRIAD_TOPIC_ID = 103;
-    static const int MAJOR_SCALE_ID = 104;
-    static const int PERFECT_ID = 105;
-    static const int MELODY_ID = 106;
-
     /**
      * @brief Constructs a new MultiplayerGame object
      * @param parent The parent QObject
      * @param topicID The ID of the game topic to load
+     * @param seed Seed of the session's question order; replaying a seed replays the order
+     * @param questionBank Question bank the topic is taken from; must outlive the game
      */
-    explicit MultiplayerGame(QObject *parent = nullptr, int topicID = GENERAL_TOPIC_ID);
+    explicit MultiplayerGame(QObject *parent = nullptr, int topicID = GENERAL_TOPIC_ID,
+                             quint64 seed = SessionRng::randomSeed(),
+                             const QuestionBank& questionBank = *QuestionBank::instance());
     ~MultiplayerGame();
 
     /**
-     * @brief Starts a new round of the game
-     */
-    void startNewRound();
-
-    /**
-     * @brief Processes a player's attempt at answering
-     * @param playedPattern The player's input attempt
-     * @return bool True if the attempt was correct, false otherwise
+     * @brief Prepares the game for a new session in place
+     * @param topicID The ID of the game topic to load
+     * @param seed Seed of the new session's question order
+     * @details Clears both scores, gives player 1 the first turn and deals the
+     *          topic again. The first question is asked by start().
      */
-    bool playerAttempt(const QString& playedPattern);
+    void reset(int topicID, quint64 seed = SessionRng::randomSeed());
 
     /**
      * @brief Gets the current active player number
@@ -84,26 +66,6 @@ public:
      */
     int getPlayer2Score() const;
 
-    /**
-     * @brief Gets the current pattern to be played
-     * @return QString The current pattern string
-     */
-    QString getCurrentPattern() const;
-
-    /**
-     * @brief Gets the current question description
-     * @return QString The current question description
-     */
-    QString getCurrentDescription() const;
-
-    /**
-     * @brief Checks if the game has ended
-     * @return bool true if the game is over, false otherwise
-     */
-    bool isGameOver() const;
-
-    int noteNameToValue(const QString& noteName);
-
 signals:
     /**
      * @brief Signal emitted when the UI needs to be updated
@@ -122,46 +84,28 @@ signals:
      */
     void gameOver(int player1Score, int player2Score);
 
+protected:
     /**
-     * @brief Signal emitted for key highlighting feedback
-     * @param isCorrect True if the answer was correct, false otherwise
+     * @brief Scores an attempt for the current player or passes the turn
+     * @param correct Whether the attempt was correct
+     * @return bool true if the game moves on to the next question
      */
-    void highlightKeys(bool isCorrect);
+    bool scoreAttempt(bool correct) override;
 
-private:
     /**
-     * @brief Switches turn to the next player
+     * @brief Emits updateUI for the current question and player
      */
-    void switchTurn();
+    void showQuestion() override;
 
     /**
-     * @brief Loads questions from the question bank
-     * @param topicID The ID of the topic to load questions for
+     * @brief Emits gameOver with both final scores
      */
-    void loadQuestions(int topicID);
-
-    /**
-     * @brief Randomly shuffles the order of questions
-     */
-    void shuffleQuestions();
-
-    /**
-     * @brief Compares two chords for equality
-     * @param chord1 First chord string
-     * @param chord2 Second chord string
-     * @return true if chords contain the same notes, false otherwise
-     */
-    bool areChordsSame(const QString& chord1, const QString& chord2);
+    void finish() override;
 
+private:
     int currentPlayer;
     int player1Score;
     int player2Score;
-    QString currentPattern;
-    QString currentDescription;
-    
-    QVector<MultiplayerQuestion> questions;
-    int currentQuestionIndex;
-    bool gameEnded;
 };
 
 #endif // MULTIPLAYERGAME_H
@@ -7,7 +7,13 @@
  */
 
 #include "multiplayergamewidget.h"
+#include "keyboard.h"
+#include "midieventqueue.h"
+#include "notetable.h"
+#include "trace.h"
 #include "pianowidget.h"
+#include "questionbankwatcher.h"
+#include "theme.h"
 #include <QFont>
 #include <QFontDatabase>
 #include <QMessageBox>
@@ -28,11 +34,14 @@
 MultiplayerGameWidget::MultiplayerGameWidget(QWidget *parent, int topicId)
     : QWidget(parent)
     , game(nullptr)
+    , match(nullptr)
     , winnerLabel(new QLabel(this))
     , mainLayout(new QVBoxLayout(this))
     , currentTopicId(topicId)
-    , chordTimer(new QTimer(this))
+    , chordCapture(new ChordCapture(this))
     , isProcessingSubmission(false)
+    , questionShownTime(0)
+    , firstNoteTime(-1)
 {
     // Find the labels from the UI
     titleLabelLocal = parent->findChild<QLabel*>("titleLabelLocal");
@@ -42,14 +51,16 @@ MultiplayerGameWidget::MultiplayerGameWidget(QWidget *parent, int topicId)
     player2ScoreLabelLocal = parent->findChild<QLabel*>("player2ScoreLabelLocal");
 
     setupUI();
+    connectPiano();
     
-    // Set up chord timer
-    chordTimer->setSingleShot(true);
-    connect(chordTimer, &QTimer::timeout, this, &MultiplayerGameWidget::submitChord);
+    // Submit every chord the capture groups together
+    connect(chordCapture, &ChordCapture::chordCaptured, this, &MultiplayerGameWidget::submitChord);
     
     game = new MultiplayerGame(this, topicId);
     connect(game, &MultiplayerGame::updateUI, this, &MultiplayerGameWidget::updateGameUI);
     connect(game, &MultiplayerGame::gameOver, this, &MultiplayerGameWidget::handleGameOver);
+    connect(QuestionBankWatcher::instance(), &QuestionBankWatcher::questionBankChanged,
+            game, &MultiplayerGame::handleQuestionBankChanged);
     
     // Connect visual feedback signal
     auto piano = PianoWidget::instance();
@@ -57,7 +68,7 @@ MultiplayerGameWidget::MultiplayerGameWidget(QWidget *parent, int topicId)
         connect(game, &MultiplayerGame::highlightKeys, piano, &PianoWidget::highlightAttempt);
     }
     
-    game->startNewRound();
+    game->start();
 }
 
 /**
@@ -101,85 +112,177 @@ void MultiplayerGameWidget::setupUI()
 
     if (titleLabelLocal) {
         titleLabelLocal->setFont(titleFont);
-        titleLabelLocal->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(titleLabelLocal, Theme::TEXT);
     }
 
     if (descriptionLabelLocal) {
         descriptionLabelLocal->setFont(descriptionFont);
-        descriptionLabelLocal->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(descriptionLabelLocal, Theme::TEXT);
     }
 
     if (currentPlayerLabelLocal) {
         currentPlayerLabelLocal->setFont(currentPlayerFont);
         currentPlayerLabelLocal->setAlignment(Qt::AlignCenter);  // Center both horizontally and vertically
-        currentPlayerLabelLocal->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(currentPlayerLabelLocal, Theme::TEXT);
     }
 
     if (player1ScoreLabelLocal) {
         player1ScoreLabelLocal->setFont(scoreFont);
-        player1ScoreLabelLocal->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(player1ScoreLabelLocal, Theme::TEXT);
     }
 
     if (player2ScoreLabelLocal) {
         player2ScoreLabelLocal->setFont(scoreFont);
-        player2ScoreLabelLocal->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(player2ScoreLabelLocal, Theme::TEXT);
     }
-    
-    // Ensure piano is properly attached
+}
+
+/**
+ * @brief Attaches the piano to the game screen and listens to its keys
+ * @details Connections are unique, so calling this for every session does not
+ *          deliver a key twice.
+ */
+void MultiplayerGameWidget::connectPiano()
+{
     auto piano = PianoWidget::instance();
-    if (piano) {
-        QFrame* pianoPlaceholder = parentWidget()->findChild<QFrame*>("pianoLocalPlaceholder");
-        if (pianoPlaceholder) {
-            piano->attachToPlaceholder(pianoPlaceholder);
-            connect(piano, &PianoWidget::keyPressed, this, &MultiplayerGameWidget::handleKeyPressed);
-            connect(piano, &PianoWidget::keyReleased, this, &MultiplayerGameWidget::handleKeyReleased);
+    if (!piano) {
+        return;
+    }
+    // Find the piano placeholder in the parent widget
+    QFrame* pianoPlaceholder = parentWidget()->findChild<QFrame*>("pianoLocalPlaceholder");
+    if (pianoPlaceholder) {
+        piano->attachToPlaceholder(pianoPlaceholder);
+    }
+    connect(piano, &PianoWidget::keyPressed, this, &MultiplayerGameWidget::handleKeyPressed, Qt::UniqueConnection);
+    connect(piano, &PianoWidget::keyReleased, this, &MultiplayerGameWidget::handleKeyReleased, Qt::UniqueConnection);
+}
+
+/**
+ * @brief Starts a new session of a topic, reusing the game and the labels
+ * @param topicId The ID of the topic to load
+ * @details The fonts and styles set up by the constructor are kept; only the game
+ *          state is reset.
+ */
+void MultiplayerGameWidget::reset(int topicId)
+{
+    leaveOnline();
+    currentTopicId = topicId;
+    chordCapture->clear();
+    connectPiano();
+    game->reset(topicId);
+    game->start();
+}
+
+/**
+ * @brief Plays an online match instead of the local game
+ * @param onlineMatch The match, already hosting or joining
+ * @details The match's signals drive the labels and the piano feedback exactly
+ *          like those of the local game. Notes of the other player are played on
+ *          the local piano at the time the match gives them, without passing
+ *          through the key handlers.
+ */
+void MultiplayerGameWidget::startOnline(OnlineMatch* onlineMatch)
+{
+    leaveOnline();
+    match = onlineMatch;
+    chordCapture->clear();
+    firstNoteTime = -1;
+    connectPiano();
+
+    connect(match, &OnlineMatch::updateUI, this, &MultiplayerGameWidget::updateGameUI, Qt::UniqueConnection);
+    connect(match, &OnlineMatch::gameOver, this, &MultiplayerGameWidget::handleGameOver, Qt::UniqueConnection);
+    connect(match, &OnlineMatch::disconnected, this, [this](const QString& reason) {
+        // The host keeps listening and deals a new game to the next opponent
+        chordCapture->clear();
+        titleLabelLocal->setText("MATCH ENDED");
+        if (match && match->role() == OnlineMatch::Role::Host) {
+            descriptionLabelLocal->setText(reason + "\nWaiting for a new opponent...");
+        } else {
+            disconnectPiano();
+            descriptionLabelLocal->setText(reason);
+        }
+        currentPlayerLabelLocal->setText("");
+    });
+    connect(match, &OnlineMatch::remoteNote, this, [](int note, int velocity, qint64 time) {
+        auto piano = PianoWidget::instance();
+        if (!piano || !piano->keyboard()) {
+            return;
+        }
+        if (velocity > 0) {
+            piano->keyboard()->playNote(note, velocity, time);
+        } else {
+            piano->keyboard()->stopNote(note, time);
         }
+    });
+    auto piano = PianoWidget::instance();
+    if (piano) {
+        connect(match, &OnlineMatch::highlightKeys, piano, &PianoWidget::highlightAttempt, Qt::UniqueConnection);
     }
 
-    // Setup chord timer
-    chordTimer = new QTimer(this);
-    chordTimer->setSingleShot(true);
-    connect(chordTimer, &QTimer::timeout, this, &MultiplayerGameWidget::handleChordTimeout);
+    titleLabelLocal->setText("ONLINE MATCH");
+    if (match->role() == OnlineMatch::Role::Host) {
+        descriptionLabelLocal->setText(QString("Waiting for an opponent at %1, port %2")
+                                       .arg(OnlineMatch::localAddresses().join(" or ")).arg(match->port()));
+    } else {
+        descriptionLabelLocal->setText("Connecting...");
+    }
+    currentPlayerLabelLocal->setText("");
+    player1ScoreLabelLocal->setText("0");
+    player2ScoreLabelLocal->setText("0");
 }
 
 /**
- * @brief Starts a new game round
- * @details Triggers the start of a new round in the game logic.
+ * @brief Stops following the online match and returns to the local game
  */
-void MultiplayerGameWidget::startGame()
+void MultiplayerGameWidget::leaveOnline()
 {
-    game->startNewRound();
+    if (!match) {
+        return;
+    }
+    disconnect(match, nullptr, this, nullptr);
+    if (auto piano = PianoWidget::instance()) {
+        disconnect(match, nullptr, piano, nullptr);
+    }
+    match = nullptr;
 }
 
 /**
- * @brief Converts a MIDI note index to its corresponding note name
- * @param noteIndex The MIDI note number (60-72)
- * @return The note name as a string (e.g., "C4", "D#4")
- * @details Maps MIDI note numbers to their corresponding note names in the fourth octave.
+ * @brief Stops listening to the piano and leaves an online match
+ * @details Called when the game's screen is left. The widget and its game are
+ *          kept for the next reset().
  */
-QString MultiplayerGameWidget::noteIndexToName(int noteIndex)
+void MultiplayerGameWidget::stop()
 {
-    // MIDI note numbers to note names mapping
-    // White keys: 60, 62, 64, 65, 67, 69, 71, 72 (C4 to C5)
-    // Black keys: 61, 63, 66, 68, 70 (C#4 to A#4)
-    switch (noteIndex) {
-        case 60: return "C4";
-        case 61: return "C#4";
-        case 62: return "D4";
-        case 63: return "D#4";
-        case 64: return "E4";
-        case 65: return "F4";
-        case 66: return "F#4";
-        case 67: return "G4";
-        case 68: return "G#4";
-        case 69: return "A4";
-        case 70: return "A#4";
-        case 71: return "B4";
-        case 72: return "C5";
-        default: return QString();
+    disconnectPiano();
+    if (match) {
+        match->close();
+        leaveOnline();
     }
 }
 
+/**
+ * @brief Stops listening to the piano's keys
+ * @details Also drops any pending chord notes.
+ */
+void MultiplayerGameWidget::disconnectPiano()
+{
+    chordCapture->clear();
+    auto piano = PianoWidget::instance();
+    if (piano) {
+        disconnect(piano, &PianoWidget::keyPressed, this, &MultiplayerGameWidget::handleKeyPressed);
+        disconnect(piano, &PianoWidget::keyReleased, this, &MultiplayerGameWidget::handleKeyReleased);
+    }
+}
+
+/**
+ * @brief Starts a new game round
+ * @details Triggers the start of a new round in the game logic.
+ */
+void MultiplayerGameWidget::startGame()
+{
+    game->start();
+}
+
 /**
  * @brief Handles keyboard input for note playing
  * @param noteIndex The MIDI note number pressed
@@ -187,28 +290,26 @@ QString MultiplayerGameWidget::noteIndexToName(int noteIndex)
  */
 void MultiplayerGameWidget::handleKeyPressed(int noteIndex)
 {
+    KEYQUEST_TRACE_SCOPE("MultiplayerGameWidget::handleKeyPressed");
     // If we're currently processing a submission, ignore new key presses
     if (isProcessingSubmission) {
         return;
     }
+    // Online, only the player whose turn it is answers; the other only listens
+    if (match && !match->isLocalTurn()) {
+        return;
+    }
+    if (firstNoteTime < 0) {
+        firstNoteTime = MidiEventQueue::now();
+    }
+    if (match) {
+        match->sendNote(noteIndex, 127);
+    }
 
-    // Add to currently pressed keys set
-    currentlyPressedKeys.insert(noteIndex);
-    
-    // Collect the new note
-    QString noteName = noteIndexToName(noteIndex);
+    QString noteName = NoteTable::name(noteIndex);
     qDebug() << "MultiplayerGameWidget: Key pressed - MIDI index:" << noteIndex << "Note name:" << noteName;
     
-    if (!noteName.isEmpty()) {
-        // Keep the original note with its octave
-        if (!currentChordNotes.contains(noteName)) {
-            currentChordNotes.append(noteName);
-            qDebug() << "MultiplayerGameWidget: Added note to chord:" << noteName << "- Current chord:" << currentChordNotes.join("-");
-        }
-    }
-    
-    // Restart the timer with a longer window (1 second)
-    chordTimer->start(1000);
+    chordCapture->noteOn(noteIndex);
 }
 
 /**
@@ -219,40 +320,39 @@ void MultiplayerGameWidget::handleKeyPressed(int noteIndex)
 void MultiplayerGameWidget::handleKeyReleased(int noteIndex)
 {
     // Get the note name for debugging
-    QString noteName = noteIndexToName(noteIndex);
+    QString noteName = NoteTable::name(noteIndex);
     qDebug() << "MultiplayerGameWidget: Key released - MIDI index:" << noteIndex << "Note name:" << noteName;
     
-    // Remove from currently pressed keys set
-    currentlyPressedKeys.remove(noteIndex);
-    
-    // If all keys are released, submit the collected notes
-    if (currentlyPressedKeys.isEmpty()) {
-        qDebug() << "MultiplayerGameWidget: All keys released, submitting chord:" << currentChordNotes.join("-");
-        isProcessingSubmission = false;
-        submitChord();
+    if (match) {
+        match->sendNote(noteIndex, 0);
     }
+
+    // The capture submits the chord once all keys are released
+    chordCapture->noteOff(noteIndex);
 }
 
 /**
  * @brief Submits the current chord for evaluation
- * @details Formats the collected notes into a chord and submits it to the game logic
+ * @param chord The chord captured from the piano
+ * @details Submits the collected notes to the game logic as a single chord
  */
-void MultiplayerGameWidget::submitChord()
+void MultiplayerGameWidget::submitChord(const NoteSet& chord)
 {
-    if (currentChordNotes.isEmpty()) {
+    KEYQUEST_TRACE_SCOPE("MultiplayerGameWidget::submitChord");
+    if (!game || chord.isEmpty()) {
         return;
     }
     
-    // Sort the notes
-    currentChordNotes.sort();
-    QString attempt = currentChordNotes.join("-");
-    qDebug() << "MultiplayerGameWidget: Submitting chord:" << attempt;
-    
-    // Submit the attempt and let the game logic handle validation
-    game->playerAttempt(attempt);
-    
-    // Clear the chord buffer
-    currentChordNotes.clear();
+    qDebug() << "MultiplayerGameWidget: Submitting chord:" << chord.toString();
+    const qint64 attemptStart = firstNoteTime < 0 ? MidiEventQueue::now() : firstNoteTime;
+    firstNoteTime = -1;
+
+    // Submit the attempt and let the game logic, or the host of a match, handle validation
+    if (match) {
+        match->submitAttempt(chord, questionShownTime, attemptStart);
+    } else {
+        game->playerAttempt(chord);
+    }
 }
 
 /**
@@ -272,11 +372,19 @@ void MultiplayerGameWidget::updateGameUI(int currentPlayer, int player1Score, in
     }
 
     // Clear any existing chord notes when updating UI (new pattern)
-    currentChordNotes.clear();
+    chordCapture->clear();
+    chordCapture->setExpectedNoteCount(match ? match->currentExpectedNotes().size()
+                                             : game->getCurrentExpectedNotes().size());
+    questionShownTime = MidiEventQueue::now();
+    firstNoteTime = -1;
     
     titleLabelLocal->setText(title.toUpper());
     descriptionLabelLocal->setText(description);
-    currentPlayerLabelLocal->setText(QString("%1").arg(currentPlayer));
+    if (match && currentPlayer == match->localPlayer()) {
+        currentPlayerLabelLocal->setText(QString("%1 (You)").arg(currentPlayer));
+    } else {
+        currentPlayerLabelLocal->setText(QString("%1").arg(currentPlayer));
+    }
     player1ScoreLabelLocal->setText(QString("%1").arg(player1Score));
     player2ScoreLabelLocal->setText(QString("%1").arg(player2Score));
 }
@@ -289,21 +397,9 @@ void MultiplayerGameWidget::updateGameUI(int currentPlayer, int player1Score, in
  */
 void MultiplayerGameWidget::handleGameOver(int player1Score, int player2Score)
 {
-    // Stop and disconnect the chord timer first
-    if (chordTimer) {
-        chordTimer->stop();
-        disconnect(chordTimer, nullptr, this, nullptr);
-    }
-
-    // Clear any pending chord notes
-    currentChordNotes.clear();
-
-    // Disconnect piano signals first
-    auto piano = PianoWidget::instance();
-    if (piano) {
-        disconnect(piano, &PianoWidget::keyPressed, this, &MultiplayerGameWidget::handleKeyPressed);
-        disconnect(piano, &PianoWidget::keyReleased, this, &MultiplayerGameWidget::handleKeyReleased);
-    }
+    // Drop any pending chord notes and stop listening to the piano; an online
+    // match stays open so the host can repeat the final state
+    disconnectPiano();
 
     // Prepare the winner text
     QString winnerText;
@@ -322,23 +418,6 @@ void MultiplayerGameWidget::handleGameOver(int player1Score, int player2Score)
     player1ScoreLabelLocal->setText(QString("%1").arg(player1Score));
     player2ScoreLabelLocal->setText(QString("%1").arg(player2Score));
 
-    // Clean up the game object last, after all UI updates and message box
-    if (game) {
-        disconnect(game, nullptr, this, nullptr);
-        game->deleteLater();
-        game = nullptr;
-    }
-
     // Emit signal with the current topic ID
     emit gameFinished(currentTopicId);
 }
-
-void MultiplayerGameWidget::handleChordTimeout()
-{
-    // If we have collected notes and we're not currently processing a submission,
-    // submit the chord
-    if (!currentChordNotes.isEmpty() && !isProcessingSubmission) {
-        qDebug() << "MultiplayerGameWidget: Chord timeout - submitting chord:" << currentChordNotes.join("-");
-        submitChord();
-    }
-} 
@@ -16,8 +16,8 @@
 #include <QVBoxLayout>
 #include <QMessageBox>
 #include "multiplayergame.h"
-#include <QtCore/QTimer>
-#include <QSet>
+#include "onlinematch.h"
+#include "chordcapture.h"
 
 /**
  * @brief Widget class for the multiplayer game interface
@@ -31,22 +31,33 @@ class MultiplayerGameWidget : public QWidget
 {
     Q_OBJECT
 public:
-    // Topic IDs
-    static const int GENERAL_TOPIC_ID = 101;
-    static const int MAJOR_MINOR_CHORDS_TOPIC_ID = 102;
-    static const int TRIAD_TOPIC_ID = 103;
-    static const int MAJOR_SCALE_ID = 104;
-    static const int PERFECT_ID = 105;
-    static const int MELODY_ID = 106;
-
     /**
      * @brief Constructs a new MultiplayerGameWidget
      * @param parent The parent widget
      * @param topicId The ID of the game topic to display
      */
-    explicit MultiplayerGameWidget(QWidget *parent = nullptr, int topicId = GENERAL_TOPIC_ID);
+    explicit MultiplayerGameWidget(QWidget *parent = nullptr, int topicId = GameSession::GENERAL_TOPIC_ID);
     ~MultiplayerGameWidget();
 
+    /**
+     * @brief Starts a new session of a topic, reusing the game and the labels
+     * @param topicId The ID of the topic to load
+     */
+    void reset(int topicId);
+
+    /**
+     * @brief Plays an online match instead of the local game
+     * @param onlineMatch The match, already hosting or joining; must outlive the widget's use of it
+     * @details The local game is left as it is until the next reset().
+     */
+    void startOnline(OnlineMatch* onlineMatch);
+
+    /**
+     * @brief Stops listening to the piano and leaves an online match
+     * @details The widget and its game are kept for the next reset().
+     */
+    void stop();
+
 public slots:
     /**
      * @brief Handles key press events from the piano
@@ -79,12 +90,6 @@ public slots:
      */
     void handleGameOver(int player1Score, int player2Score);
 
-    /**
-     * @brief Handles the chord input timeout
-     * @details Submits the collected chord when no new keys are pressed for the timeout period
-     */
-    void handleChordTimeout();
-
 signals:
     /**
      * @brief Signal emitted when the game is finished
@@ -99,24 +104,34 @@ private:
     void setupUI();
 
     /**
-     * @brief Initializes and starts the game
+     * @brief Attaches the piano to the game screen and listens to its keys
      */
-    void startGame();
+    void connectPiano();
+
+    /**
+     * @brief Stops listening to the piano's keys
+     */
+    void disconnectPiano();
 
     /**
-     * @brief Converts a note index to its name
-     * @param noteIndex The index of the note
-     * @return QString The name of the note
+     * @brief Stops following the online match and returns to the local game
      */
-    QString noteIndexToName(int noteIndex);
+    void leaveOnline();
+
+    /**
+     * @brief Initializes and starts the game
+     */
+    void startGame();
 
     /**
      * @brief Submits the current chord for evaluation
-     * @details Formats the collected notes into a chord and submits it to the game logic
+     * @param chord The chord captured from the piano
+     * @details Submits the captured chord to the game logic
      */
-    void submitChord();
+    void submitChord(const NoteSet& chord);
 
     MultiplayerGame *game;
+    OnlineMatch *match;              // Online match being played, nullptr for the local game
     QLabel *titleLabelLocal;
     QLabel *descriptionLabelLocal;
     QLabel *currentPlayerLabelLocal;
@@ -127,11 +142,10 @@ private:
     int currentTopicId;
     
     // For handling chords
-    QStringList currentChordNotes;
-    static const int CHORD_TIMEOUT_MS = 1000;  // Time window for chord input (1 second)
-    QTimer* chordTimer;
-    QSet<int> currentlyPressedKeys;  // Track which keys are currently pressed
+    ChordCapture* chordCapture;      // Groups key presses into submitted chords
     bool isProcessingSubmission;     // Flag to prevent multiple rapid submissions
+    qint64 questionShownTime;        // When the current question appeared, from MidiEventQueue::now()
+    qint64 firstNoteTime;            // When the first note of the current attempt was played, -1 before it
 };
 
 #endif // MULTIPLAYERGAMEWIDGET_H 
@@ -8,6 +8,9 @@
 
 #include "navigationmanager.h"
 #include <QDebug>
+#include <QGuiApplication>
+#include <algorithm>
+#include <vector>
 
 /**
  * @brief Constructor for NavigationManager
@@ -20,6 +23,124 @@ NavigationManager::NavigationManager(QStackedWidget* stackedWidget, QObject* par
     : QObject(parent)
     , m_stackedWidget(stackedWidget)
 {
+    // Hidden or suspended applications give back the memory of pages not on screen
+    connect(qGuiApp, &QGuiApplication::applicationStateChanged, this, [this](Qt::ApplicationState state) {
+        if (state == Qt::ApplicationHidden || state == Qt::ApplicationSuspended) {
+            releaseUnusedPages();
+        }
+    });
+}
+
+/**
+ * @brief Registers a page whose content is built on first use
+ * @param page The page widget in the stacked widget
+ * @param create Builds the page content; called before the page is first shown
+ * @param release Frees the page content; if empty the page is never released
+ */
+void NavigationManager::registerPage(QWidget* page, PageFactory create, PageReleaser release)
+{
+    if (!page || !create) {
+        qDebug() << "NavigationManager: Cannot register a lazy page without a page and a factory";
+        return;
+    }
+
+    LazyPage lazyPage;
+    lazyPage.create = std::move(create);
+    lazyPage.release = std::move(release);
+    m_lazyPages.insert(page, lazyPage);
+}
+
+/**
+ * @brief Checks whether the content of a lazy page is currently built
+ * @param page The page widget
+ * @return true if the page is built or is not a lazy page
+ */
+bool NavigationManager::isPageMaterialized(QWidget* page) const
+{
+    auto it = m_lazyPages.constFind(page);
+    return it == m_lazyPages.constEnd() || it->materialized;
+}
+
+/**
+ * @brief Gets the number of lazy pages kept built at the same time
+ * @return The maximum number of built lazy pages
+ */
+int NavigationManager::maxResidentPages() const
+{
+    return m_maxResidentPages;
+}
+
+/**
+ * @brief Sets the number of lazy pages kept built at the same time
+ * @param count The maximum number of built lazy pages, at least 1
+ */
+void NavigationManager::setMaxResidentPages(int count)
+{
+    m_maxResidentPages = std::max(1, count);
+    evictPages(m_maxResidentPages);
+}
+
+/**
+ * @brief Releases every built lazy page except the current one
+ */
+void NavigationManager::releaseUnusedPages()
+{
+    evictPages(1);
+}
+
+/**
+ * @brief Shows a page of the stacked widget
+ * @param index Index of the page
+ */
+void NavigationManager::showPage(int index)
+{
+    QWidget* page = m_stackedWidget->widget(index);
+    auto it = m_lazyPages.find(page);
+    if (it != m_lazyPages.end()) {
+        it->lastShown = ++m_showCounter;
+        if (!it->materialized) {
+            it->materialized = true;
+            it->create();
+        }
+    }
+
+    m_stackedWidget->setCurrentIndex(index);
+    emit pageChanged(m_stackedWidget->currentWidget());
+    evictPages(m_maxResidentPages);
+}
+
+/**
+ * @brief Releases the least recently shown lazy pages
+ * @param keep Number of built lazy pages to keep
+ * @details The current page and pages without a releaser are never released.
+ */
+void NavigationManager::evictPages(int keep)
+{
+    std::vector<QWidget*> resident;
+    for (auto it = m_lazyPages.begin(); it != m_lazyPages.end(); ++it) {
+        // Pages without a releaser stay built and do not count towards the limit
+        if (it->materialized && it->release) {
+            resident.push_back(it.key());
+        }
+    }
+    if (static_cast<int>(resident.size()) <= keep) {
+        return;
+    }
+
+    // Most recently shown first
+    std::sort(resident.begin(), resident.end(), [this](QWidget* a, QWidget* b) {
+        return m_lazyPages[a].lastShown > m_lazyPages[b].lastShown;
+    });
+
+    QWidget* current = m_stackedWidget ? m_stackedWidget->currentWidget() : nullptr;
+    for (size_t i = keep; i < resident.size(); ++i) {
+        LazyPage& lazyPage = m_lazyPages[resident[i]];
+        if (resident[i] == current) {
+            continue;
+        }
+        lazyPage.materialized = false;
+        lazyPage.release();
+    }
 }
 
 /**
@@ -30,8 +151,7 @@ NavigationManager::NavigationManager(QStackedWidget* stackedWidget, QObject* par
 void NavigationManager::navigateToMainPage()
 {
     if (m_stackedWidget) {
-        m_stackedWidget->setCurrentIndex(0);  // mainPage
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(0);  // mainPage
         SoundManager::instance()->startBackgroundMusic();
     }
 }
@@ -44,8 +164,7 @@ void NavigationManager::navigateToMainPage()
 void NavigationManager::navigateToQuizzes()
 {
     if (m_stackedWidget) {
-        m_stackedWidget->setCurrentIndex(4);  // quizzesPage
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(4);  // quizzesPage
         SoundManager::instance()->startBackgroundMusic();
     }
 }
@@ -58,8 +177,7 @@ void NavigationManager::navigateToQuizzes()
 void NavigationManager::navigateToSettings()
 {
     if (m_stackedWidget) {
-        m_stackedWidget->setCurrentIndex(5);  // settingsPage
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(5);  // settingsPage
         SoundManager::instance()->startBackgroundMusic();
     }
 }
@@ -72,8 +190,7 @@ void NavigationManager::navigateToSettings()
 void NavigationManager::navigateToLessons()
 {
     if (m_stackedWidget) {
-        m_stackedWidget->setCurrentIndex(6);  // lessonsPage
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(6);  // lessonsPage
         SoundManager::instance()->startBackgroundMusic();
     }
 }
@@ -86,8 +203,7 @@ void NavigationManager::navigateToLessons()
 void NavigationManager::navigateToMultiplayer()
 {
     if (m_stackedWidget) {
-        m_stackedWidget->setCurrentIndex(7);  // multiplayerPage
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(7);  // multiplayerPage
         SoundManager::instance()->startBackgroundMusic();
     }
 }
@@ -100,8 +216,7 @@ void NavigationManager::navigateToMultiplayer()
 void NavigationManager::navigateToStatistics()
 {
     if (m_stackedWidget) {
-        m_stackedWidget->setCurrentIndex(8);  // statisticsPage
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(8);  // statisticsPage
         SoundManager::instance()->startBackgroundMusic();
     }
 }
@@ -114,8 +229,7 @@ void NavigationManager::navigateToStatistics()
 void NavigationManager::navigateToFreeStyle()
 {
     if (m_stackedWidget) {
-        m_stackedWidget->setCurrentIndex(9);  // freeStylePage
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(9);  // freeStylePage
         SoundManager::instance()->stopBackgroundMusic();
     }
 }
@@ -128,8 +242,7 @@ void NavigationManager::navigateToFreeStyle()
 void NavigationManager::navigateToLocalMultiplayer()
 {
     if (m_stackedWidget) {
-        m_stackedWidget->setCurrentIndex(2);  // LocalMultiplayerPage
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(2);  // LocalMultiplayerPage
         SoundManager::instance()->startBackgroundMusic();
     }
 }
@@ -142,8 +255,7 @@ void NavigationManager::navigateToLocalMultiplayer()
 void NavigationManager::navigateToLessonsPageScreen()
 {
     if(m_stackedWidget){
-        m_stackedWidget->setCurrentIndex(1);  // lessonsPageScreen
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(1);  // lessonsPageScreen
         SoundManager::instance()->stopBackgroundMusic();
     }
 }
@@ -156,8 +268,7 @@ void NavigationManager::navigateToLessonsPageScreen()
 void NavigationManager::navigateToGamePlay()
 {
     if (m_stackedWidget) {
-        m_stackedWidget->setCurrentIndex(3);  // localGamePlayScreen
-        emit pageChanged(m_stackedWidget->currentWidget());
+        showPage(3);  // localGamePlayScreen
         SoundManager::instance()->stopBackgroundMusic();
     }
 }
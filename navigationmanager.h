@@ -12,7 +12,9 @@
 #define NAVIGATIONMANAGER_H
 
 #include <QtCore/QObject>
+#include <QHash>
 #include <QStackedWidget>
+#include <functional>
 #include "soundmanager.h"
 
 /**
@@ -20,6 +22,12 @@
  * 
  * Handles the navigation logic and page transitions throughout the application,
  * ensuring proper cleanup and state management between page changes
+ *
+ * Pages can be registered as lazy pages with a factory that builds their content.
+ * The factory runs the first time the page is navigated to rather than at startup.
+ * At most maxResidentPages() releasable lazy pages are kept built; the least
+ * recently shown ones are released again, as are all hidden ones when the application is hidden
+ * or suspended.
  */
 class NavigationManager : public QObject
 {
@@ -33,6 +41,39 @@ public:
      */
     explicit NavigationManager(QStackedWidget* stackedWidget, QObject* parent = nullptr);
 
+    /// Builds the content of a lazy page
+    using PageFactory = std::function<void()>;
+
+    /// Frees the content of a lazy page built by its PageFactory
+    using PageReleaser = std::function<void()>;
+
+    /**
+     * @brief Registers a page whose content is built on first use
+     * @param page The page widget in the stacked widget
+     * @param create Builds the page content; called before the page is first shown
+     * @param release Frees the page content; if empty the page is never released
+     */
+    void registerPage(QWidget* page, PageFactory create, PageReleaser release = PageReleaser());
+
+    /**
+     * @brief Checks whether the content of a lazy page is currently built
+     * @param page The page widget
+     * @return true if the page is built or is not a lazy page
+     */
+    bool isPageMaterialized(QWidget* page) const;
+
+    /**
+     * @brief Gets the number of lazy pages kept built at the same time
+     * @return The maximum number of built lazy pages
+     */
+    int maxResidentPages() const;
+
+    /**
+     * @brief Sets the number of lazy pages kept built at the same time
+     * @param count The maximum number of built lazy pages, at least 1
+     */
+    void setMaxResidentPages(int count);
+
 public Q_SLOTS:
     /**
      * @brief Navigates to the main menu page
@@ -84,6 +125,11 @@ public Q_SLOTS:
      */
     void navigateToLessonsPageScreen();
 
+    /**
+     * @brief Releases every built lazy page except the current one
+     */
+    void releaseUnusedPages();
+
 Q_SIGNALS:
     /**
      * @brief Emitted when the page changes
@@ -92,7 +138,34 @@ Q_SIGNALS:
     void pageChanged(QWidget* newPage);
 
 private:
+    /**
+     * @brief Lazy page bookkeeping
+     */
+    struct LazyPage {
+        PageFactory create;         ///< Builds the page content
+        PageReleaser release;       ///< Frees the page content, may be empty
+        bool materialized = false;  ///< Whether the content is currently built
+        quint64 lastShown = 0;      ///< Value of m_showCounter when the page was last shown
+    };
+
+    /**
+     * @brief Shows a page of the stacked widget
+     * @param index Index of the page
+     * @details Builds the page first if it is a lazy page, then emits pageChanged
+     *          and releases pages beyond maxResidentPages().
+     */
+    void showPage(int index);
+
+    /**
+     * @brief Releases the least recently shown lazy pages
+     * @param keep Number of built lazy pages to keep
+     */
+    void evictPages(int keep);
+
     QStackedWidget* m_stackedWidget;
+    QHash<QWidget*, LazyPage> m_lazyPages;  ///< Registered lazy pages
+    quint64 m_showCounter = 0;              ///< Incremented every time a page is shown
+    int m_maxResidentPages = 3;             ///< Maximum number of built lazy pages
 };
 
 #endif // NAVIGATIONMANAGER_H 
@@ -0,0 +1,489 @@
+/**
+ * @file notesampler.cpp
+ * @brief Implementation of the NoteSampler class
+ * @author Alan Cruz
+ * @details This file implements rendering and caching the piano notes and the
+ *          allocation-free mixer that plays them.
+ */
+
+#include "notesampler.h"
+#include "soundfontloader.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QResource>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <fluidsynth.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief Header of a sample cache file
+ * @details Followed by the length of every note of the range as a quint32, then
+ *          the samples of all notes in the same order.
+ */
+struct NoteSamplerCacheHeader {
+    char magic[4];        ///< "KQSM"
+    quint16 version;      ///< Format version
+    quint8 firstNote;     ///< Lowest note
+    quint8 lastNote;      ///< Highest note
+    quint32 sampleRate;   ///< Sample rate in Hz
+    quint32 sampleCount;  ///< Samples of all notes together
+};
+
+/// Magic bytes of a sample cache file
+static const char NOTESAMPLER_MAGIC[4] = {'K', 'Q', 'S', 'M'};
+
+/// Version of the sample cache format
+static const quint16 NOTESAMPLER_VERSION = 1;
+
+/**
+ * @brief Deletes the banks still held
+ */
+NoteSampler::~NoteSampler()
+{
+    delete m_bank;
+    delete m_pending.load();
+    delete m_retired.load();
+}
+
+/**
+ * @brief Renders the notes of a key range, or reads them from the disk cache
+ * @param soundFontPath SoundFont resource, e.g. ":/sounds/piano.sf2"
+ * @param firstNote Lowest note
+ * @param lastNote Highest note
+ * @param sampleRate Sample rate of the audio output
+ * @param cancelled Checked between notes; rendering stops once it returns true
+ * @return The bank, or nullptr if it was cancelled or the SoundFont could not be loaded
+ * @details The notes are rendered on a synthesizer of their own, without effects,
+ *          at the gain the live synthesizer uses. A note is held for NOTE_SECONDS,
+ *          faded out over its last FADE_MS and converted to mono.
+ */
+std::unique_ptr<NoteSampler::Bank> NoteSampler::render(const QString& soundFontPath, int firstNote, int lastNote,
+                                                       double sampleRate, const std::function<bool()>& cancelled)
+{
+    auto bank = std::make_unique<Bank>();
+    bank->firstNote = std::clamp(firstNote, 0, 127);
+    bank->lastNote = std::clamp(lastNote, bank->firstNote, 127);
+    bank->sampleRate = sampleRate;
+
+    const QString path = cachePath(soundFontPath, bank->firstNote, bank->lastNote, sampleRate);
+    if (readCache(path, *bank)) {
+        qDebug() << "NoteSampler: Read" << bank->lastNote - bank->firstNote + 1 << "notes from" << path;
+        return bank;
+    }
+    bank->samples.clear();
+    std::fill(std::begin(bank->notes), std::end(bank->notes), Bank::Note());
+
+    fluid_settings_t* settings = new_fluid_settings();
+    if (!settings) {
+        qDebug() << "NoteSampler: Failed to create FluidSynth settings";
+        return nullptr;
+    }
+    fluid_settings_setnum(settings, "synth.sample-rate", sampleRate);
+    fluid_settings_setnum(settings, "synth.gain", 0.5);
+    fluid_settings_setint(settings, "synth.polyphony", 16);
+    fluid_settings_setint(settings, "synth.reverb.active", 0);
+    fluid_settings_setint(settings, "synth.chorus.active", 0);
+
+    fluid_synth_t* synth = new_fluid_synth(settings);
+    if (!synth) {
+        qDebug() << "NoteSampler: Failed to create FluidSynth synthesizer";
+        delete_fluid_settings(settings);
+        return nullptr;
+    }
+
+    bool ok = false;
+    {
+        SoundFontLoader loader(settings, synth, soundFontPath);
+        loader.start();
+        loader.wait();
+        ok = loader.soundFontId() >= 0;
+    }
+
+    const int frames = static_cast<int>(NOTE_SECONDS * sampleRate);
+    const int fadeFrames = static_cast<int>(FADE_MS * sampleRate / 1000.0);
+    float left[RENDER_BLOCK];
+    float right[RENDER_BLOCK];
+    bank->samples.reserve(size_t(frames) * (bank->lastNote - bank->firstNote + 1));
+
+    for (int key = bank->firstNote; ok && key <= bank->lastNote; ++key) {
+        if (cancelled && cancelled()) {
+            ok = false;
+            break;
+        }
+
+        const size_t offset = bank->samples.size();
+        bank->samples.resize(offset + frames);
+        qint16* note = bank->samples.data() + offset;
+
+        fluid_synth_noteon(synth, 0, key, 127);
+        for (int done = 0; done < frames; done += RENDER_BLOCK) {
+            const int count = std::min(RENDER_BLOCK, frames - done);
+            if (fluid_synth_write_float(synth, count, left, 0, 1, right, 0, 1) != FLUID_OK) {
+                ok = false;
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                const float fade = std::min(1.0f, float(frames - done - i) / fadeFrames);
+                const float mono = (left[i] + right[i]) * 0.5f * fade;
+                note[done + i] = static_cast<qint16>(std::lround(std::clamp(mono, -1.0f, 1.0f) * 32767.0f));
+            }
+        }
+        fluid_synth_all_sounds_off(synth, 0);
+
+        // Notes that die away early need not keep their silence
+        quint32 length = static_cast<quint32>(frames);
+        while (length > 0 && std::abs(note[length - 1]) <= SILENCE_LEVEL) {
+            --length;
+        }
+        bank->samples.resize(offset + length);
+        bank->notes[key] = {static_cast<quint32>(offset), length};
+    }
+
+    delete_fluid_synth(synth);
+    delete_fluid_settings(settings);
+    if (!ok) {
+        return nullptr;
+    }
+
+    bank->samples.shrink_to_fit();
+    writeCache(path, *bank);
+    qDebug() << "NoteSampler: Rendered" << bank->lastNote - bank->firstNote + 1 << "notes,"
+             << bank->memoryUsage() / 1024 << "KiB";
+    return bank;
+}
+
+/**
+ * @brief Gets the cache file of a key range
+ * @param soundFontPath SoundFont resource
+ * @param firstNote Lowest note
+ * @param lastNote Highest note
+ * @param sampleRate Sample rate
+ * @return The path in the SoundFont cache directory
+ * @details The name starts with the size and build time of the SoundFont
+ *          resource, so a new SoundFont never plays the samples of the old one.
+ */
+QString NoteSampler::cachePath(const QString& soundFontPath, int firstNote, int lastNote, double sampleRate)
+{
+    QResource resource(soundFontPath);
+    const QString source = QString::number(resource.uncompressedSize(), 16)
+                           + QString::number(resource.lastModified().toSecsSinceEpoch(), 16);
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/soundfonts/"
+           + QString("samples-%1-%2-%3-%4.kqs").arg(source).arg(firstNote).arg(lastNote).arg(qRound(sampleRate));
+}
+
+/**
+ * @brief Reads a bank from the disk cache
+ * @param path Cache file
+ * @param bank Receives the notes; its range and sample rate must be set
+ * @return true if the file holds that range at that rate
+ * @details A file that is shorter or longer than its header says is not used.
+ */
+bool NoteSampler::readCache(const QString& path, Bank& bank)
+{
+    QFile file(path);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    NoteSamplerCacheHeader header;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) != qint64(sizeof(header))
+            || std::memcmp(header.magic, NOTESAMPLER_MAGIC, sizeof(NOTESAMPLER_MAGIC)) != 0
+            || header.version != NOTESAMPLER_VERSION || header.firstNote != bank.firstNote
+            || header.lastNote != bank.lastNote || header.sampleRate != quint32(qRound(bank.sampleRate))) {
+        qDebug() << "NoteSampler: Ignoring a sample cache of another format at:" << path;
+        return false;
+    }
+
+    const int count = bank.lastNote - bank.firstNote + 1;
+    std::vector<quint32> lengths(count);
+    const qint64 lengthBytes = qint64(count) * qint64(sizeof(quint32));
+    const qint64 sampleBytes = qint64(header.sampleCount) * qint64(sizeof(qint16));
+    if (file.size() != qint64(sizeof(header)) + lengthBytes + sampleBytes
+            || file.read(reinterpret_cast<char*>(lengths.data()), lengthBytes) != lengthBytes) {
+        qDebug() << "NoteSampler: Sample cache is damaged:" << path;
+        return false;
+    }
+
+    quint64 offset = 0;
+    for (int i = 0; i < count; ++i) {
+        bank.notes[bank.firstNote + i] = {static_cast<quint32>(offset), lengths[i]};
+        offset += lengths[i];
+    }
+    if (offset != header.sampleCount) {
+        qDebug() << "NoteSampler: Sample cache is damaged:" << path;
+        return false;
+    }
+
+    bank.samples.resize(header.sampleCount);
+    return file.read(reinterpret_cast<char*>(bank.samples.data()), sampleBytes) == sampleBytes;
+}
+
+/**
+ * @brief Writes a bank to the disk cache
+ * @param path Cache file
+ * @param bank The bank
+ * @details Samples of an older SoundFont are removed. A cache that cannot be
+ *          written only means the notes are rendered again next time.
+ */
+void NoteSampler::writeCache(const QString& path, const Bank& bank)
+{
+    const QFileInfo info(path);
+    if (!QDir().mkpath(info.path())) {
+        qDebug() << "NoteSampler: Failed to create the sample cache directory:" << info.path();
+        return;
+    }
+
+    NoteSamplerCacheHeader header;
+    std::memcpy(header.magic, NOTESAMPLER_MAGIC, sizeof(NOTESAMPLER_MAGIC));
+    header.version = NOTESAMPLER_VERSION;
+    header.firstNote = static_cast<quint8>(bank.firstNote);
+    header.lastNote = static_cast<quint8>(bank.lastNote);
+    header.sampleRate = static_cast<quint32>(qRound(bank.sampleRate));
+    header.sampleCount = static_cast<quint32>(bank.samples.size());
+
+    std::vector<quint32> lengths;
+    for (int key = bank.firstNote; key <= bank.lastNote; ++key) {
+        lengths.push_back(bank.notes[key].length);
+    }
+
+    QSaveFile file(path);
+    const qint64 lengthBytes = qint64(lengths.size()) * qint64(sizeof(quint32));
+    const qint64 sampleBytes = qint64(bank.samples.size()) * qint64(sizeof(qint16));
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header))
+            || file.write(reinterpret_cast<const char*>(lengths.data()), lengthBytes) != lengthBytes
+            || file.write(reinterpret_cast<const char*>(bank.samples.data()), sampleBytes) != sampleBytes
+            || !file.commit()) {
+        qDebug() << "NoteSampler: Failed to write the sample cache:" << path;
+        return;
+    }
+
+    const QString prefix = info.fileName().section('-', 0, 1) + "-";
+    QDir dir(info.path());
+    for (const QString& name : dir.entryList({"samples-*.kqs"}, QDir::Files)) {
+        if (!name.startsWith(prefix)) {
+            dir.remove(name);
+        }
+    }
+}
+
+/**
+ * @brief Hands a bank to the audio thread
+ * @param bank The bank; the sampler owns it from now on
+ * @details A bank published before that the audio thread has not taken yet is
+ *          never played and can be deleted here.
+ */
+void NoteSampler::publish(std::unique_ptr<Bank> bank)
+{
+    m_bankBytes.store(bank ? bank->memoryUsage() : 0, std::memory_order_relaxed);
+    delete m_pending.exchange(bank.release(), std::memory_order_acq_rel);
+}
+
+/**
+ * @brief Deletes the bank the audio thread has replaced, if any
+ */
+void NoteSampler::collect()
+{
+    delete m_retired.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+/**
+ * @brief Takes a published bank; audio thread only
+ * @return true if there is a bank to play
+ * @details The switch waits until collect() has deleted the previously replaced
+ *          bank, so there is always a free slot to hand the old one back in.
+ */
+bool NoteSampler::prepare()
+{
+    if (m_pending.load(std::memory_order_acquire) && !m_retired.load(std::memory_order_acquire)) {
+        Bank* bank = m_pending.exchange(nullptr, std::memory_order_acq_rel);
+        if (bank) {
+            stopAll();
+            m_retired.store(m_bank, std::memory_order_release);
+            m_bank = bank;
+            m_releaseFrames = float(RELEASE_MS * bank->sampleRate / 1000.0);
+        }
+    }
+    return m_bank != nullptr;
+}
+
+/**
+ * @brief Starts a note; audio thread only
+ * @param channel MIDI channel
+ * @param key MIDI note
+ * @param velocity Note-on velocity; 0 stops the note
+ */
+void NoteSampler::noteOn(int channel, int key, int velocity)
+{
+    if (velocity <= 0) {
+        noteOff(channel, key);
+        return;
+    }
+    if (!m_bank || key < 0 || key > 127) {
+        return;
+    }
+    const int source = std::clamp(key, m_bank->firstNote, m_bank->lastNote);
+    if (m_bank->notes[source].length == 0) {
+        return;
+    }
+
+    // A free voice, else a released one, else the one that started first
+    Voice* voice = &m_voices[0];
+    for (Voice& candidate : m_voices) {
+        if (!candidate.samples) {
+            voice = &candidate;
+            break;
+        }
+        const bool released = candidate.release > 0.0f;
+        const bool voiceReleased = voice->release > 0.0f;
+        if (released != voiceReleased ? released : candidate.position > voice->position) {
+            voice = &candidate;
+        }
+    }
+
+    // A repeated key fades out the note it played before
+    for (Voice& other : m_voices) {
+        if (other.samples && other.channel == channel && other.key == key && &other != voice) {
+            releaseVoice(other);
+        }
+    }
+
+    const float level = velocity / 127.0f;
+    const Bank::Note& note = m_bank->notes[source];
+    voice->samples = m_bank->samples.data() + note.offset;
+    voice->length = note.length;
+    voice->position = 0;
+    voice->step = static_cast<quint32>(std::lround(std::exp2((key - source) / 12.0) * 65536.0));
+    voice->gain = level * level;
+    voice->release = 0.0f;
+    voice->channel = static_cast<qint8>(channel);
+    voice->key = static_cast<quint8>(key);
+    voice->sustained = false;
+}
+
+/**
+ * @brief Releases a note; audio thread only
+ * @param channel MIDI channel
+ * @param key MIDI note
+ * @details While the sustain pedal is down the note keeps sounding until the
+ *          pedal is lifted.
+ */
+void NoteSampler::noteOff(int channel, int key)
+{
+    const bool sustain = channel >= 0 && channel < VOICE_CHANNELS && m_sustain[channel];
+    for (Voice& voice : m_voices) {
+        if (voice.samples && voice.channel == channel && voice.key == key && voice.release == 0.0f) {
+            if (sustain) {
+                voice.sustained = true;
+            } else {
+                releaseVoice(voice);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Applies a control change; audio thread only
+ * @param channel MIDI channel
+ * @param control Controller number
+ * @param value Controller value
+ */
+void NoteSampler::controlChange(int channel, int control, int value)
+{
+    if (channel < 0 || channel >= VOICE_CHANNELS) {
+        return;
+    }
+
+    if (control == 64) {
+        m_sustain[channel] = value >= 64;
+        if (m_sustain[channel]) {
+            return;
+        }
+        for (Voice& voice : m_voices) {
+            if (voice.samples && voice.channel == channel && voice.sustained) {
+                releaseVoice(voice);
+            }
+        }
+    } else if (control == 120 || control == 123) {
+        for (Voice& voice : m_voices) {
+            if (voice.samples && voice.channel == channel) {
+                if (control == 120) {
+                    voice.samples = nullptr;
+                } else {
+                    releaseVoice(voice);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Cuts off every note at once; audio thread only
+ */
+void NoteSampler::stopAll()
+{
+    for (Voice& voice : m_voices) {
+        voice.samples = nullptr;
+    }
+    std::fill(std::begin(m_sustain), std::end(m_sustain), false);
+}
+
+/**
+ * @brief Mixes the sounding notes into a block; audio thread only
+ * @param left Left output, added to
+ * @param right Right output, added to; nullptr for mono output
+ * @param frames Number of frames
+ * @details Notes at their own pitch step one sample per frame; resampled notes
+ *          are interpolated linearly between neighbouring samples.
+ */
+void NoteSampler::mix(float* left, float* right, int frames)
+{
+    constexpr float scale = 1.0f / 32768.0f;
+    constexpr float fraction = 1.0f / 65536.0f;
+    for (Voice& voice : m_voices) {
+        if (!voice.samples) {
+            continue;
+        }
+
+        const qint16* samples = voice.samples;
+        const quint64 end = quint64(voice.length - 1) << 16;
+        quint64 position = voice.position;
+        float gain = voice.gain * scale;
+        const float release = voice.release * scale;
+        for (int i = 0; i < frames && position < end && gain > 0.0f; ++i) {
+            const quint32 index = static_cast<quint32>(position >> 16);
+            const float weight = (position & 0xFFFF) * fraction;
+            const float sample = (samples[index] + (samples[index + 1] - samples[index]) * weight) * gain;
+            left[i] += sample;
+            if (right) {
+                right[i] += sample;
+            }
+            position += voice.step;
+            gain -= release;
+        }
+
+        voice.position = position;
+        voice.gain = gain / scale;
+        if (position >= end || voice.gain <= 0.0f) {
+            voice.samples = nullptr;
+        }
+    }
+}
+
+/**
+ * @brief Starts fading a voice out
+ * @param voice The voice
+ */
+void NoteSampler::releaseVoice(Voice& voice)
+{
+    if (voice.release == 0.0f) {
+        voice.release = voice.gain / std::max(1.0f, m_releaseFrames);
+    }
+    voice.sustained = false;
+}
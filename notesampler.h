@@ -0,0 +1,227 @@
+/**
+ * @file notesampler.h
+ * @brief Header file for the NoteSampler class
+ * @author Alan Cruz
+ * @details This file defines NoteSampler, a low-CPU alternative to rendering the
+ *          piano with FluidSynth: every note of the active key range is rendered
+ *          once into memory and played back from there by a plain sample mixer.
+ */
+
+#ifndef NOTESAMPLER_H
+#define NOTESAMPLER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Plays pre-rendered piano notes in the audio callback
+ * @details render() plays each note of a key range on a FluidSynth instance of
+ *          its own, held for NOTE_SECONDS at full velocity, and keeps the result
+ *          as mono 16-bit samples with the trailing silence cut off. The samples
+ *          are cached on disk next to the extracted SoundFont, so later starts
+ *          read them back instead of loading the SoundFont at all.
+ *
+ *          The mixer plays up to VOICE_COUNT notes from a fixed voice array. A note
+ *          outside the range, such as a metronome click, is played from the
+ *          nearest rendered note, resampled to its pitch. Velocity scales a note's
+ *          gain with the usual square-law MIDI curve, a note-off fades the voice
+ *          out over RELEASE_MS, and the sustain pedal holds released notes.
+ *          Nothing in noteOn(), noteOff() or mix() allocates, locks or waits, so
+ *          they are safe on the audio thread.
+ *
+ *          Banks are handed to the audio thread with publish(). The audio thread
+ *          takes a published bank in prepare() and hands the one it replaces back,
+ *          which collect() deletes on another thread, so the audio thread never
+ *          frees memory either.
+ */
+class NoteSampler
+{
+public:
+    static const int VOICE_COUNT = 32;  ///< Most notes sounding at once
+    static const int NOTE_SECONDS = 3;  ///< Longest a note sounds while held
+    static const int RELEASE_MS = 150;  ///< Fade-out after a note-off
+
+    /**
+     * @brief Samples of a key range
+     */
+    struct Bank {
+        /**
+         * @brief Where a note is in the samples
+         */
+        struct Note {
+            quint32 offset = 0;  ///< First sample of the note
+            quint32 length = 0;  ///< Number of samples, 0 if the note is not in the bank
+        };
+
+        int firstNote = 0;            ///< Lowest note rendered
+        int lastNote = -1;            ///< Highest note rendered
+        double sampleRate = 44100.0;  ///< Sample rate the notes were rendered at
+        Note notes[128];              ///< Every MIDI note, by key
+        std::vector<qint16> samples;  ///< Mono samples of all notes, one after another
+
+        /**
+         * @brief Gets the memory the bank holds
+         * @return The size in bytes
+         */
+        qint64 memoryUsage() const { return qint64(sizeof(Bank)) + qint64(samples.capacity()) * qint64(sizeof(qint16)); }
+    };
+
+    /**
+     * @brief Constructs a sampler without a bank; it is silent until one is published
+     */
+    NoteSampler() = default;
+
+    /**
+     * @brief Deletes the banks still held
+     * @details The audio callback must not run any more.
+     */
+    ~NoteSampler();
+
+    NoteSampler(const NoteSampler&) = delete;
+    NoteSampler& operator=(const NoteSampler&) = delete;
+
+    /**
+     * @brief Renders the notes of a key range, or reads them from the disk cache
+     * @param soundFontPath SoundFont resource, e.g. ":/sounds/piano.sf2"
+     * @param firstNote Lowest note
+     * @param lastNote Highest note
+     * @param sampleRate Sample rate of the audio output
+     * @param cancelled Checked between notes; rendering stops once it returns true
+     * @return The bank, or nullptr if it was cancelled or the SoundFont could not be loaded
+     * @details Runs for a few seconds; call it on a worker thread.
+     */
+    static std::unique_ptr<Bank> render(const QString& soundFontPath, int firstNote, int lastNote,
+                                        double sampleRate, const std::function<bool()>& cancelled);
+
+    /**
+     * @brief Hands a bank to the audio thread
+     * @param bank The bank; the sampler owns it from now on
+     * @details The audio thread switches to it at its next prepare(). Only one
+     *          thread may publish at a time.
+     */
+    void publish(std::unique_ptr<Bank> bank);
+
+    /**
+     * @brief Deletes the bank the audio thread has replaced, if any
+     * @details Call regularly from one thread other than the audio thread.
+     */
+    void collect();
+
+    /**
+     * @brief Takes a published bank; audio thread only
+     * @return true if there is a bank to play
+     * @details Switching banks silences the notes of the old one.
+     */
+    bool prepare();
+
+    /**
+     * @brief Starts a note; audio thread only
+     * @param channel MIDI channel
+     * @param key MIDI note
+     * @param velocity Note-on velocity; 0 stops the note
+     * @details Takes a free voice, or steals a released one, else the oldest. A
+     *          note not in the bank is resampled from the nearest one that is.
+     */
+    void noteOn(int channel, int key, int velocity);
+
+    /**
+     * @brief Releases a note; audio thread only
+     * @param channel MIDI channel
+     * @param key MIDI note
+     */
+    void noteOff(int channel, int key);
+
+    /**
+     * @brief Applies a control change; audio thread only
+     * @param channel MIDI channel
+     * @param control Controller number; sustain (64), all sounds off (120) and
+     *                all notes off (123) are handled
+     * @param value Controller value
+     */
+    void controlChange(int channel, int control, int value);
+
+    /**
+     * @brief Cuts off every note at once; audio thread only
+     */
+    void stopAll();
+
+    /**
+     * @brief Mixes the sounding notes into a block; audio thread only
+     * @param left Left output, added to
+     * @param right Right output, added to; nullptr for mono output
+     * @param frames Number of frames
+     */
+    void mix(float* left, float* right, int frames);
+
+    /**
+     * @brief Gets the memory of the bank last published
+     * @return The size in bytes, 0 if none was published
+     */
+    qint64 memoryUsage() const { return m_bankBytes.load(std::memory_order_relaxed); }
+
+private:
+    static const int VOICE_CHANNELS = 16;  // MIDI channels the sustain pedal is tracked on
+    static const int SILENCE_LEVEL = 4;    // Trailing samples this quiet are cut off
+    static const int FADE_MS = 100;        // Fade at the end of a note held for NOTE_SECONDS
+    static const int RENDER_BLOCK = 1024;  // Frames rendered at a time
+
+    /**
+     * @brief A note being played
+     */
+    struct Voice {
+        const qint16* samples = nullptr;  ///< Samples of the note, nullptr if the voice is free
+        quint32 length = 0;               ///< Number of samples
+        quint64 position = 0;             ///< Next sample to play, 16.16 fixed point
+        quint32 step = 0;                 ///< Samples advanced per frame, 16.16 fixed point
+        float gain = 0.0f;                ///< Gain of the next sample
+        float release = 0.0f;             ///< Gain lost per sample, 0 while held
+        qint8 channel = 0;                ///< MIDI channel
+        quint8 key = 0;                   ///< MIDI note
+        bool sustained = false;           ///< Released while the sustain pedal was down
+    };
+
+    /**
+     * @brief Gets the cache file of a key range
+     * @param soundFontPath SoundFont resource
+     * @param firstNote Lowest note
+     * @param lastNote Highest note
+     * @param sampleRate Sample rate
+     * @return The path; its name changes with the SoundFont
+     */
+    static QString cachePath(const QString& soundFontPath, int firstNote, int lastNote, double sampleRate);
+
+    /**
+     * @brief Reads a bank from the disk cache
+     * @param path Cache file
+     * @param bank Receives the notes; its range and sample rate must be set
+     * @return true if the file holds that range at that rate
+     */
+    static bool readCache(const QString& path, Bank& bank);
+
+    /**
+     * @brief Writes a bank to the disk cache
+     * @param path Cache file
+     * @param bank The bank
+     */
+    static void writeCache(const QString& path, const Bank& bank);
+
+    /**
+     * @brief Starts fading a voice out
+     * @param voice The voice
+     */
+    void releaseVoice(Voice& voice);
+
+    Voice m_voices[VOICE_COUNT];               // Fixed voice array
+    bool m_sustain[VOICE_CHANNELS] = {};       // Whether the sustain pedal is down on each channel
+    float m_releaseFrames = 0.0f;              // Length of the release fade in samples
+    Bank* m_bank = nullptr;                    // Bank being played; audio thread only
+    std::atomic<Bank*> m_pending{nullptr};     // Published and not taken yet
+    std::atomic<Bank*> m_retired{nullptr};     // Replaced and not deleted yet
+    std::atomic<qint64> m_bankBytes{0};        // memoryUsage() of the last published bank
+};
+
+#endif // NOTESAMPLER_H
@@ -0,0 +1,138 @@
+/**
+ * @file noteset.cpp
+ * @brief Implementation of the NoteSet class
+ * @author Alan Cruz
+ * @details This file implements note name parsing and formatting for NoteSet.
+ */
+
+#include "noteset.h"
+#include "notetable.h"
+#include <QStringList>
+
+/**
+ * @brief Creates a set from precomputed masks
+ * @param pitchClasses Pitch-class mask, bit n set for pitch class n
+ * @param midiLow MIDI mask for notes 0-63
+ * @param midiHigh MIDI mask for notes 64-127
+ * @param flags Combination of NoteSet::Flag values
+ * @return The set described by the masks
+ */
+NoteSet NoteSet::fromMasks(quint16 pitchClasses, quint64 midiLow, quint64 midiHigh, quint8 flags)
+{
+    NoteSet set;
+    set.m_pitchClasses = pitchClasses & 0x0FFF;
+    set.m_midi[0] = midiLow;
+    set.m_midi[1] = midiHigh;
+    set.m_flags = flags & (Valid | ExactOctave);
+    return set;
+}
+
+/**
+ * @brief Parses a '-' separated list of note names
+ * @param notes Notes such as "C4-E4-G4", "C-Eb-G" or "F#"
+ * @return The parsed set; isValid() is false if any note name was not recognized
+ */
+NoteSet NoteSet::fromString(const QString& notes)
+{
+    NoteSet set;
+    bool allHaveOctave = true;
+
+    const QStringList names = notes.split('-');
+    for (const QString& name : names) {
+        bool hasOctave = false;
+        int midiNote = noteNameToMidi(name, &hasOctave);
+        if (midiNote < 0) {
+            set.m_flags &= ~Valid;
+            continue;
+        }
+        allHaveOctave = allHaveOctave && hasOctave;
+        set.addMidiNote(midiNote);
+    }
+
+    if (allHaveOctave && !set.isEmpty()) {
+        set.m_flags |= ExactOctave;
+    }
+    return set;
+}
+
+/**
+ * @brief Converts a note name to its MIDI note number
+ * @param noteName The note name (e.g., "C#4", "Bb3", "Ebb")
+ * @param hasOctave Optional output, set to whether the name carried an octave number
+ * @return The MIDI note number (C4 = 60), or -1 if the name is not a note
+ * @details A double accidental anywhere in the name shifts by two semitones;
+ *          otherwise every '#' and 'b' shifts by one. Other characters after the
+ *          letter are ignored.
+ */
+int NoteSet::noteNameToMidi(const QString& noteName, bool* hasOctave)
+{
+    // Semitone of each natural note, indexed by letter - 'A'
+    static constexpr int letterValues[7] = {9, 11, 0, 2, 4, 5, 7};
+
+    int length = noteName.size();
+    if (hasOctave) {
+        *hasOctave = false;
+    }
+    if (length == 0) {
+        return -1;
+    }
+
+    char16_t letter = noteName.at(0).unicode();
+    if (letter < u'A' || letter > u'G') {
+        return -1;
+    }
+    int value = letterValues[letter - u'A'];
+
+    // Strip the octave number if present
+    int octave = 4;
+    if (length > 1 && noteName.at(length - 1).isDigit()) {
+        octave = noteName.at(length - 1).digitValue();
+        --length;
+        if (hasOctave) {
+            *hasOctave = true;
+        }
+    }
+
+    int sharps = 0;
+    int flats = 0;
+    bool doubleSharp = false;
+    bool doubleFlat = false;
+    char16_t previous = 0;
+    for (int i = 1; i < length; ++i) {
+        char16_t c = noteName.at(i).unicode();
+        if (c == u'#') {
+            ++sharps;
+            doubleSharp = doubleSharp || previous == u'#';
+        } else if (c == u'b') {
+            ++flats;
+            doubleFlat = doubleFlat || previous == u'b';
+        }
+        previous = c;
+    }
+
+    if (doubleSharp) {
+        value += 2;
+    } else if (doubleFlat) {
+        value -= 2;
+    } else {
+        value += sharps - flats;
+    }
+
+    int midiNote = (octave + 1) * 12 + ((value % 12) + 12) % 12;
+    return midiNote <= 127 ? midiNote : -1;
+}
+
+/**
+ * @brief Formats the set for debug output
+ * @return The MIDI notes of the set, e.g. "C4-E4-G4"
+ */
+QString NoteSet::toString() const
+{
+    QStringList notes;
+    for (int midiNote = 0; midiNote < NoteTable::NOTE_COUNT; ++midiNote) {
+        if (containsMidiNote(midiNote)) {
+            notes.append(NoteTable::name(midiNote));
+        }
+    }
+    return notes.join("-");
+}
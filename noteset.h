@@ -0,0 +1,186 @@
+/**
+ * @file noteset.h
+ * @brief Header file for the NoteSet class
+ * @author Alan Cruz
+ * @details This file defines NoteSet, the bitmask representation of a set of notes
+ *          used for all answer checking in KeyQuest. Expected answers are compiled
+ *          into a NoteSet once when the question bank is loaded, and played notes
+ *          are added to one as keys are pressed, so that checking an answer is a
+ *          plain integer comparison instead of string manipulation.
+ */
+
+#ifndef NOTESET_H
+#define NOTESET_H
+
+#include <QString>
+#include <QtAlgorithms>
+#include <QtGlobal>
+
+/**
+ * @brief Set of notes stored as pitch-class and MIDI note bitmasks
+ * @details Every note contributes one bit to a 12-bit pitch-class mask (C=0 ... B=11)
+ *          and one bit to a 128-bit MIDI note mask. Enharmonic spellings such as
+ *          "C#" and "Db" therefore produce the same set, and the order in which the
+ *          notes were played does not matter.
+ *
+ *          By default two sets match when they contain the same pitch classes, so a
+ *          chord may be played in any octave or inversion. A set parsed from input
+ *          where every note carries an octave number is marked exact-octave, and then
+ *          only the same MIDI notes match it.
+ */
+class NoteSet {
+public:
+    /**
+     * @brief Flags describing how a set was built
+     * @details The values are stored as-is in the compiled question bank.
+     */
+    enum Flag : quint8 {
+        Valid = 0x01,        ///< Every note name was recognized
+        ExactOctave = 0x02   ///< Answers must use the same octaves, not only pitch classes
+    };
+
+    /**
+     * @brief Default constructor
+     * @details Creates an empty, valid set that is not exact-octave.
+     */
+    NoteSet() = default;
+
+    /**
+     * @brief Creates a set from precomputed masks
+     * @param pitchClasses Pitch-class mask, bit n set for pitch class n
+     * @param midiLow MIDI mask for notes 0-63
+     * @param midiHigh MIDI mask for notes 64-127
+     * @param flags Combination of NoteSet::Flag values
+     * @return The set described by the masks
+     */
+    static NoteSet fromMasks(quint16 pitchClasses, quint64 midiLow, quint64 midiHigh, quint8 flags);
+
+    /**
+     * @brief Parses a '-' separated list of note names
+     * @param notes Notes such as "C4-E4-G4", "C-Eb-G" or "F#"
+     * @return The parsed set; isValid() is false if any note name was not recognized
+     * @details Notes without an octave number are placed in octave 4. The set is
+     *          exact-octave only if every note had an octave number.
+     */
+    static NoteSet fromString(const QString& notes);
+
+    /**
+     * @brief Converts a note name to its MIDI note number
+     * @param noteName The note name (e.g., "C#4", "Bb3", "Ebb")
+     * @param hasOctave Optional output, set to whether the name carried an octave number
+     * @return The MIDI note number (C4 = 60), or -1 if the name is not a note
+     * @details Handles sharps, flats, double sharps, and double flats. Octave 4 is
+     *          used when the name has no octave number. Accidentals wrap within the
+     *          octave, so "Cb4" is B4 rather than B3.
+     */
+    static int noteNameToMidi(const QString& noteName, bool* hasOctave = nullptr);
+
+    /**
+     * @brief Adds a note to the set
+     * @param midiNote MIDI note number (0-127); other values are ignored
+     */
+    void addMidiNote(int midiNote)
+    {
+        if (midiNote < 0 || midiNote > 127) {
+            return;
+        }
+        m_pitchClasses |= static_cast<quint16>(1u << (midiNote % 12));
+        m_midi[midiNote / 64] |= quint64(1) << (midiNote % 64);
+    }
+
+    /**
+     * @brief Removes every note from the set
+     * @details The set becomes valid and not exact-octave again.
+     */
+    void clear() { *this = NoteSet(); }
+
+    /**
+     * @brief Checks whether the set has no notes
+     * @return true if no note was added
+     */
+    bool isEmpty() const { return m_pitchClasses == 0; }
+
+    /**
+     * @brief Gets the number of notes an answer to this set has to play
+     * @return The number of MIDI notes if the set is exact-octave, otherwise the
+     *         number of pitch classes
+     */
+    int size() const
+    {
+        if (isExactOctave()) {
+            return qPopulationCount(m_midi[0]) + qPopulationCount(m_midi[1]);
+        }
+        return qPopulationCount(m_pitchClasses);
+    }
+
+    /**
+     * @brief Checks whether every note name of the source was recognized
+     * @return true if the set is valid
+     */
+    bool isValid() const { return (m_flags & Valid) != 0; }
+
+    /**
+     * @brief Checks whether the set must be matched with exact octaves
+     * @return true if matches compare MIDI notes instead of pitch classes
+     */
+    bool isExactOctave() const { return (m_flags & ExactOctave) != 0; }
+
+    /**
+     * @brief Gets the flags of the set
+     * @return Combination of NoteSet::Flag values
+     */
+    quint8 flags() const { return m_flags; }
+
+    /**
+     * @brief Gets the pitch-class mask
+     * @return 12-bit mask, bit n set for pitch class n (C=0)
+     */
+    quint16 pitchClassMask() const { return m_pitchClasses; }
+
+    /**
+     * @brief Gets half of the MIDI note mask
+     * @param half 0 for notes 0-63, 1 for notes 64-127
+     * @return 64-bit MIDI mask of that half
+     */
+    quint64 midiMask(int half) const { return m_midi[half & 1]; }
+
+    /**
+     * @brief Checks whether a MIDI note is in the set
+     * @param midiNote MIDI note number (0-127)
+     * @return true if the note was added to the set
+     */
+    bool containsMidiNote(int midiNote) const
+    {
+        return midiNote >= 0 && midiNote <= 127
+            && (m_midi[midiNote / 64] & (quint64(1) << (midiNote % 64))) != 0;
+    }
+
+    /**
+     * @brief Checks whether a played set answers this expected set
+     * @param played The notes played by the user
+     * @return true if the notes match, false otherwise or if this set is invalid or empty
+     */
+    bool isAnsweredBy(const NoteSet& played) const
+    {
+        if (!isValid() || isEmpty()) {
+            return false;
+        }
+        if (isExactOctave()) {
+            return m_midi[0] == played.m_midi[0] && m_midi[1] == played.m_midi[1];
+        }
+        return m_pitchClasses == played.m_pitchClasses;
+    }
+
+    /**
+     * @brief Formats the set for debug output
+     * @return The MIDI notes of the set, e.g. "C4-E4-G4"
+     */
+    QString toString() const;
+
+private:
+    quint16 m_pitchClasses = 0;   ///< Bit n set for pitch class n (C=0)
+    quint8 m_flags = Valid;       ///< Combination of NoteSet::Flag values
+    quint64 m_midi[2] = {0, 0};   ///< Bit n set for MIDI note n
+};
+
+#endif // NOTESET_H
@@ -0,0 +1,19 @@
+/**
+ * @file notetable.cpp
+ * @brief Implementation of the NoteTable class
+ * @author Alan Cruz
+ * @details This file implements the NoteTable lookups that return Qt strings; the
+ *          table itself is built at compile time in notetable.h.
+ */
+
+#include "notetable.h"
+
+/**
+ * @brief Gets the name of a note spelled with a sharp
+ * @param midiNote MIDI note number
+ * @return The name, e.g. "C#4", or an empty string if the note is not valid
+ */
+QString NoteTable::name(int midiNote)
+{
+    return isValid(midiNote) ? QString::fromLatin1(NOTES[midiNote].sharpName) : QString();
+}
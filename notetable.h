@@ -0,0 +1,148 @@
+/**
+ * @file notetable.h
+ * @brief Header file for the NoteTable class
+ * @author Alan Cruz
+ * @details This file defines the table describing every MIDI note: its names,
+ *          pitch class, octave and the key it is played on. The table is generated
+ *          at compile time, so every lookup is a single index.
+ */
+
+#ifndef NOTETABLE_H
+#define NOTETABLE_H
+
+#include <array>
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @brief Description of one MIDI note
+ */
+struct NoteInfo {
+    quint8 pitchClass = 0;    ///< Pitch class, C = 0
+    qint8 octave = 0;         ///< Octave in scientific pitch notation, C4 = 60
+    bool black = false;       ///< Whether the note is played on a black key
+    quint8 whiteIndex = 0;    ///< White keys below the note; a black key sits on the right edge of white key whiteIndex - 1
+    float blackOffset = 0.0f; ///< Shift of a black key from the edge between its white neighbours, in black key widths
+    char sharpName[5] = {};   ///< Name spelled with a sharp, e.g. "C#4"
+    char flatName[5] = {};    ///< Name spelled with a flat, e.g. "Db4"
+};
+
+/**
+ * @brief Builds the note table
+ * @return Entries for MIDI 0-127
+ * @details Evaluated by the compiler; see NoteTable.
+ */
+constexpr std::array<NoteInfo, 128> buildNoteTable()
+{
+    constexpr bool blackKeys[12] = {false, true, false, true, false, false, true, false, true, false, true, false};
+    constexpr quint8 whiteBefore[12] = {0, 1, 1, 2, 2, 3, 4, 4, 5, 5, 6, 6};
+    constexpr float offsets[12] = {0, -0.2f, 0, 0.2f, 0, 0, -0.25f, 0, 0, 0, 0.25f, 0};
+    constexpr char letters[12] = {'C', 'C', 'D', 'D', 'E', 'F', 'F', 'G', 'G', 'A', 'A', 'B'};
+    constexpr char flatLetters[12] = {'C', 'D', 'D', 'E', 'E', 'F', 'G', 'G', 'A', 'A', 'B', 'B'};
+
+    std::array<NoteInfo, 128> notes{};
+    for (int midi = 0; midi < 128; ++midi) {
+        const int pitchClass = midi % 12;
+        const int octave = midi / 12 - 1;
+        NoteInfo& info = notes[midi];
+        info.pitchClass = static_cast<quint8>(pitchClass);
+        info.octave = static_cast<qint8>(octave);
+        info.black = blackKeys[pitchClass];
+        info.whiteIndex = static_cast<quint8>(midi / 12 * 7 + whiteBefore[pitchClass]);
+        info.blackOffset = offsets[pitchClass];
+
+        // Letter, accidental, then the octave with its sign
+        int sharp = 0;
+        int flat = 0;
+        info.sharpName[sharp++] = letters[pitchClass];
+        info.flatName[flat++] = flatLetters[pitchClass];
+        if (info.black) {
+            info.sharpName[sharp++] = '#';
+            info.flatName[flat++] = 'b';
+        }
+        if (octave < 0) {
+            info.sharpName[sharp++] = '-';
+            info.flatName[flat++] = '-';
+        }
+        info.sharpName[sharp] = info.flatName[flat] = static_cast<char>('0' + (octave < 0 ? -octave : octave));
+    }
+    return notes;
+}
+
+/**
+ * @brief Compile-time table of all 128 MIDI notes
+ * @details Pianos, quizzes and scoring look notes up here instead of keeping
+ *          their own ranges and name switches. MIDI 0 is C-1 and MIDI 127 is G9;
+ *          an 88-key piano spans FIRST_88_KEY_NOTE to LAST_88_KEY_NOTE.
+ *
+ *          Black keys are not centered between their white neighbours on a real
+ *          keyboard: C# and F# lean left, D# and A# lean right. blackOffset holds
+ *          that shift so the drawn keys follow the usual proportions.
+ */
+class NoteTable
+{
+public:
+    static constexpr int NOTE_COUNT = 128;        ///< Number of MIDI notes
+    static constexpr int MIDDLE_C = 60;           ///< MIDI note of C4
+    static constexpr int FIRST_88_KEY_NOTE = 21;  ///< Lowest key of an 88-key piano (A0)
+    static constexpr int LAST_88_KEY_NOTE = 108;  ///< Highest key of an 88-key piano (C8)
+
+    /**
+     * @brief Checks whether a number is a MIDI note
+     * @param midiNote The number to check
+     * @return true if the number is within 0-127
+     */
+    static constexpr bool isValid(int midiNote) { return midiNote >= 0 && midiNote < NOTE_COUNT; }
+
+    /**
+     * @brief Gets the description of a note
+     * @param midiNote MIDI note number; must be valid
+     * @return The note's entry in the table
+     */
+    static constexpr const NoteInfo& note(int midiNote) { return NOTES[midiNote]; }
+
+    /**
+     * @brief Checks whether a note is played on a black key
+     * @param midiNote MIDI note number; must be valid
+     * @return true for black keys
+     */
+    static constexpr bool isBlack(int midiNote) { return NOTES[midiNote].black; }
+
+    /**
+     * @brief Gets the name of a note spelled with a sharp
+     * @param midiNote MIDI note number
+     * @return The name, e.g. "C#4", or an empty string if the note is not valid
+     */
+    static QString name(int midiNote);
+
+    /**
+     * @brief Gets the enharmonic spellings of a pitch class
+     * @param pitchClass The pitch class, 0-11
+     * @return The spellings separated by "<br>", e.g. "B#<br>C<br>Dbb"
+     */
+    static const char* spellings(int pitchClass) { return SPELLINGS[pitchClass % 12]; }
+
+private:
+    static constexpr std::array<NoteInfo, NOTE_COUNT> NOTES = buildNoteTable();  ///< The table
+
+    /// Note names of each pitch class, one per enharmonic spelling
+    static constexpr const char* SPELLINGS[12] = {
+        "B#<br>C<br>Dbb",   // C
+        "C#<br>Db",         // C#/Db
+        "C##<br>D<br>Ebb",  // D
+        "D#<br>Eb",         // D#/Eb
+        "D##<br>E<br>Fb",   // E
+        "E#<br>F<br>Gbb",   // F
+        "F#<br>Gb",         // F#/Gb
+        "F##<br>G<br>Abb",  // G
+        "G#<br>Ab",         // G#/Ab
+        "G##<br>A<br>Bbb",  // A
+        "A#<br>Bb",         // A#/Bb
+        "A##<br>B<br>Cb"    // B
+    };
+};
+
+static_assert(NoteTable::note(NoteTable::MIDDLE_C).octave == 4, "C4 must be MIDI 60");
+static_assert(NoteTable::note(127).whiteIndex == 74, "MIDI 0-127 has 75 white keys");
+
+#endif // NOTETABLE_H
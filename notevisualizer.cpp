@@ -0,0 +1,395 @@
+/**
+ * @file notevisualizer.cpp
+ * @brief Implementation of the NoteVisualizer class
+ * @author Alan Cruz
+ * @details This file implements the note quads, their incremental upload and
+ *          the shaders that scroll them with the current time.
+ */
+
+#include "notevisualizer.h"
+#include "midieventqueue.h"
+#include "notetable.h"
+#include "pianowidget.h"
+#include "promptplayer.h"
+#include <algorithm>
+#include <QColor>
+#include <QDebug>
+#include <QFrame>
+#include <QVector2D>
+
+/// The quad of a black note is this many white keys wide, like the keys of PianoWidget
+static constexpr float VISUALIZER_BLACK_WIDTH = 0.6f;
+
+/// Space left free on each side of a quad, in white keys
+static constexpr float VISUALIZER_NOTE_GAP = 0.06f;
+
+/// Thickness of the now line in device-independent pixels
+static constexpr int VISUALIZER_LINE_WIDTH = 2;
+
+static const QColor VISUALIZER_BACKGROUND(250, 245, 235);
+static const QColor VISUALIZER_PROMPT(70, 130, 220);
+static const QColor VISUALIZER_PLAYED(200, 110, 40);
+static const QColor VISUALIZER_NOW_LINE(103, 49, 0);
+
+/// Maps a vertex from white keys and seconds to the screen; a held note ends now
+static const char* const VISUALIZER_VERTEX_SHADER = R"(
+attribute vec3 vertex;
+uniform float now;
+uniform vec2 keyTransform;
+uniform vec2 timeTransform;
+varying float kind;
+void main()
+{
+    float time = vertex.y < 0.0 ? now : vertex.y;
+    gl_Position = vec4((vertex.x - keyTransform.x) * keyTransform.y - 1.0,
+                       timeTransform.x + (time - now) * timeTransform.y, 0.0, 1.0);
+    kind = vertex.z;
+}
+)";
+
+/// Colours a note by who played it, darker on a black key
+static const char* const VISUALIZER_FRAGMENT_SHADER = R"(
+#ifdef GL_ES
+precision mediump float;
+#endif
+uniform vec4 promptColor;
+uniform vec4 playedColor;
+varying float kind;
+void main()
+{
+    vec4 color = kind >= 1.5 ? playedColor : promptColor;
+    if (mod(kind, 2.0) >= 0.5) {
+        color.rgb *= 0.75;
+    }
+    gl_FragColor = color;
+}
+)";
+
+/**
+ * @brief Creates a visualizer of a piano's notes
+ * @param piano The piano whose played notes and prompts are shown
+ * @param parent Parent widget
+ */
+NoteVisualizer::NoteVisualizer(PianoWidget* piano, QWidget* parent)
+    : QOpenGLWidget(parent)
+    , m_piano(piano)
+    , m_program(nullptr)
+    , m_vertexBuffer(QOpenGLBuffer::VertexBuffer)
+    , m_vertices(MAX_NOTES * 6, Vertex{0.0f, 0.0f, 0.0f})
+    , m_nextSlot(0)
+    , m_usedSlots(0)
+    , m_dirtyFirst(-1)
+    , m_dirtyLast(-1)
+    , m_heldCount(0)
+    , m_epoch(MidiEventQueue::now())
+    , m_lastEnd(0.0f)
+    , m_nowLocation(-1)
+    , m_keyTransformLocation(-1)
+    , m_timeTransformLocation(-1)
+    , m_promptColorLocation(-1)
+    , m_playedColorLocation(-1)
+{
+    std::fill(std::begin(m_heldSlot), std::end(m_heldSlot), -1);
+    setFocusPolicy(Qt::NoFocus);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+
+    connect(this, &QOpenGLWidget::frameSwapped, this, &NoteVisualizer::scheduleFrame);
+    if (!m_piano) {
+        return;
+    }
+
+    connect(m_piano, &PianoWidget::notePlayed, this, [this](int note, int, qint64 time) {
+        releaseNote(note);
+        addNote(note, time, -1, true);
+    });
+    connect(m_piano, &PianoWidget::keyReleased, this, &NoteVisualizer::releaseNote);
+    connect(m_piano, &PianoWidget::keyWindowChanged, this, [this]() { update(); });
+
+    if (PromptPlayer* player = m_piano->promptPlayer()) {
+        connect(player, &PromptPlayer::notePlanned, this, [this](int note, qint64 start, qint64 end) {
+            const float now = seconds(MidiEventQueue::now());
+            while (!m_promptSlots.empty() && m_vertices[m_promptSlots.front() * 6 + 2].time < now) {
+                m_promptSlots.pop_front();
+            }
+            const int slot = addNote(note, start, end, false);
+            if (slot >= 0) {
+                m_promptSlots.push_back(slot);
+            }
+        });
+        connect(player, &PromptPlayer::cancelled, this, &NoteVisualizer::cancelPrompt);
+    }
+}
+
+/**
+ * @brief Releases the GPU resources
+ */
+NoteVisualizer::~NoteVisualizer()
+{
+    releaseGL();
+}
+
+/**
+ * @brief Shows the visualizer in a placeholder frame
+ * @param placeholder The frame to fill
+ */
+void NoteVisualizer::attachToPlaceholder(QFrame* placeholder)
+{
+    if (!placeholder) return;
+
+    if (parentWidget() != placeholder) {
+        setParent(placeholder);
+    }
+    setGeometry(0, 0, placeholder->width(), placeholder->height());
+    show();
+    raise();
+}
+
+/**
+ * @brief Hides the visualizer until it is attached again
+ */
+void NoteVisualizer::detach()
+{
+    hide();
+}
+
+/**
+ * @brief Compiles the shaders and uploads the notes
+ * @details Also runs again when the widget moves to another window and gets a new
+ *          context, so every note is uploaded from the CPU copy.
+ */
+void NoteVisualizer::initializeGL()
+{
+    initializeOpenGLFunctions();
+    connect(context(), &QOpenGLContext::aboutToBeDestroyed, this, &NoteVisualizer::releaseGL);
+
+    m_program = new QOpenGLShaderProgram;
+    m_program->bindAttributeLocation("vertex", 0);
+    if (!m_program->addCacheableShaderFromSourceCode(QOpenGLShader::Vertex, VISUALIZER_VERTEX_SHADER)
+            || !m_program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, VISUALIZER_FRAGMENT_SHADER)
+            || !m_program->link()) {
+        qDebug() << "NoteVisualizer: Failed to build the shaders:" << m_program->log();
+        delete m_program;
+        m_program = nullptr;
+        return;
+    }
+    m_nowLocation = m_program->uniformLocation("now");
+    m_keyTransformLocation = m_program->uniformLocation("keyTransform");
+    m_timeTransformLocation = m_program->uniformLocation("timeTransform");
+    m_promptColorLocation = m_program->uniformLocation("promptColor");
+    m_playedColorLocation = m_program->uniformLocation("playedColor");
+
+    m_vertexBuffer.create();
+    m_vertexBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_vertexBuffer.bind();
+    m_vertexBuffer.allocate(m_vertices.data(), static_cast<int>(m_vertices.size() * sizeof(Vertex)));
+    m_vertexBuffer.release();
+    m_dirtyFirst = -1;
+}
+
+/**
+ * @brief Uploads the changed notes and draws the view
+ * @details The notes are one draw call; the now line is a scissored clear on top.
+ */
+void NoteVisualizer::paintGL()
+{
+    glClearColor(VISUALIZER_BACKGROUND.redF(), VISUALIZER_BACKGROUND.greenF(), VISUALIZER_BACKGROUND.blueF(), 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (!m_program || !m_piano) {
+        return;
+    }
+
+    m_vertexBuffer.bind();
+    if (m_dirtyFirst >= 0) {
+        const int first = m_dirtyFirst * 6;
+        const int count = (m_dirtyLast - m_dirtyFirst + 1) * 6;
+        m_vertexBuffer.write(static_cast<int>(first * sizeof(Vertex)), &m_vertices[first],
+                             static_cast<int>(count * sizeof(Vertex)));
+        m_dirtyFirst = -1;
+    }
+
+    const float span = PAST_SECONDS + FUTURE_SECONDS;
+    m_program->bind();
+    m_program->setUniformValue(m_nowLocation, seconds(MidiEventQueue::now()));
+    m_program->setUniformValue(m_keyTransformLocation,
+                               QVector2D(static_cast<float>(m_piano->firstVisibleWhiteIndex()),
+                                         static_cast<float>(2.0 * m_piano->whiteKeyWidthShare())));
+    m_program->setUniformValue(m_timeTransformLocation, QVector2D(-1.0f + 2.0f * PAST_SECONDS / span, 2.0f / span));
+    m_program->setUniformValue(m_promptColorLocation, VISUALIZER_PROMPT);
+    m_program->setUniformValue(m_playedColorLocation, VISUALIZER_PLAYED);
+    m_program->enableAttributeArray(0);
+    m_program->setAttributeBuffer(0, GL_FLOAT, 0, 3, sizeof(Vertex));
+    glDrawArrays(GL_TRIANGLES, 0, m_usedSlots * 6);
+    m_program->disableAttributeArray(0);
+    m_program->release();
+    m_vertexBuffer.release();
+
+    const qreal ratio = devicePixelRatioF();
+    const int lineWidth = qMax(1, qRound(VISUALIZER_LINE_WIDTH * ratio));
+    const int lineY = qRound(height() * ratio * PAST_SECONDS / span) - lineWidth / 2;
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, lineY, qRound(width() * ratio), lineWidth);
+    glClearColor(VISUALIZER_NOW_LINE.redF(), VISUALIZER_NOW_LINE.greenF(), VISUALIZER_NOW_LINE.blueF(), 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+/**
+ * @brief Starts drawing frames when the widget is shown
+ * @param event The show event
+ */
+void NoteVisualizer::showEvent(QShowEvent* event)
+{
+    QOpenGLWidget::showEvent(event);
+    update();
+}
+
+/**
+ * @brief Adds a note
+ * @param note The MIDI note
+ * @param start When it starts, from MidiEventQueue::now()
+ * @param end When it ends, or -1 while it is held
+ * @param played Whether the player played it rather than a prompt
+ * @return Slot of the note
+ * @details Overwrites the oldest note once MAX_NOTES are kept; a held note that
+ *          is overwritten is no longer held.
+ */
+int NoteVisualizer::addNote(int note, qint64 start, qint64 end, bool played)
+{
+    if (!NoteTable::isValid(note)) {
+        return -1;
+    }
+
+    const int slot = m_nextSlot;
+    m_nextSlot = (m_nextSlot + 1) % MAX_NOTES;
+    m_usedSlots = std::min(m_usedSlots + 1, MAX_NOTES);
+    if (m_heldCount > 0) {
+        for (int held = 0; held < NoteTable::NOTE_COUNT; ++held) {
+            if (m_heldSlot[held] == slot) {
+                m_heldSlot[held] = -1;
+                --m_heldCount;
+            }
+        }
+    }
+
+    const NoteInfo& info = NoteTable::note(note);
+    float left = info.whiteIndex + VISUALIZER_NOTE_GAP;
+    float right = info.whiteIndex + 1.0f - VISUALIZER_NOTE_GAP;
+    if (info.black) {
+        left = info.whiteIndex + (info.blackOffset - 0.5f) * VISUALIZER_BLACK_WIDTH + VISUALIZER_NOTE_GAP;
+        right = left + VISUALIZER_BLACK_WIDTH - 2.0f * VISUALIZER_NOTE_GAP;
+    }
+    const float kind = (played ? 2.0f : 0.0f) + (info.black ? 1.0f : 0.0f);
+
+    // Two triangles; vertices 0, 1 and 3 are the start, 2, 4 and 5 the end
+    Vertex* quad = &m_vertices[slot * 6];
+    const float corners[6] = {left, right, right, left, right, left};
+    for (int i = 0; i < 6; ++i) {
+        quad[i].key = corners[i];
+        quad[i].kind = kind;
+    }
+
+    if (end < 0) {
+        m_heldSlot[note] = slot;
+        ++m_heldCount;
+        setNoteTimes(slot, seconds(start), OPEN_END);
+    } else {
+        const float endSeconds = seconds(end);
+        m_lastEnd = std::max(m_lastEnd, endSeconds);
+        setNoteTimes(slot, seconds(start), endSeconds);
+    }
+    update();
+    return slot;
+}
+
+/**
+ * @brief Moves the start and end of a note
+ * @param slot Slot of the note
+ * @param start New start in seconds since m_epoch
+ * @param end New end in seconds since m_epoch, or OPEN_END
+ */
+void NoteVisualizer::setNoteTimes(int slot, float start, float end)
+{
+    Vertex* quad = &m_vertices[slot * 6];
+    quad[0].time = quad[1].time = quad[3].time = start;
+    quad[2].time = quad[4].time = quad[5].time = end;
+
+    if (m_dirtyFirst < 0) {
+        m_dirtyFirst = m_dirtyLast = slot;
+    } else {
+        m_dirtyFirst = std::min(m_dirtyFirst, slot);
+        m_dirtyLast = std::max(m_dirtyLast, slot);
+    }
+}
+
+/**
+ * @brief Ends a held note now
+ * @param note The MIDI note
+ */
+void NoteVisualizer::releaseNote(int note)
+{
+    if (!NoteTable::isValid(note) || m_heldSlot[note] < 0) {
+        return;
+    }
+    const int slot = m_heldSlot[note];
+    m_heldSlot[note] = -1;
+    --m_heldCount;
+
+    const float now = seconds(MidiEventQueue::now());
+    m_lastEnd = std::max(m_lastEnd, now);
+    setNoteTimes(slot, m_vertices[slot * 6].time, now);
+    update();
+}
+
+/**
+ * @brief Cuts the prompt notes that have not ended at the current time
+ * @details Notes that had not started yet are left with no length.
+ */
+void NoteVisualizer::cancelPrompt()
+{
+    const float now = seconds(MidiEventQueue::now());
+    for (int slot : m_promptSlots) {
+        const Vertex* quad = &m_vertices[slot * 6];
+        if (quad[0].kind < 2.0f && quad[2].time > now) {
+            setNoteTimes(slot, std::min(quad[0].time, now), now);
+        }
+    }
+    m_promptSlots.clear();
+    update();
+}
+
+/**
+ * @brief Converts a MidiEventQueue::now() time to the time of a vertex
+ * @param time The time in nanoseconds
+ * @return Seconds since m_epoch, at least 0
+ */
+float NoteVisualizer::seconds(qint64 time) const
+{
+    return static_cast<float>(std::max<qint64>(0, time - m_epoch) * 1e-9);
+}
+
+/**
+ * @brief Requests the next frame if a note is still in view
+ * @details Runs after every buffer swap, so frames follow the display's refresh
+ *          rate while notes move and stop once the last one has scrolled out.
+ */
+void NoteVisualizer::scheduleFrame()
+{
+    if (isVisible() && (m_heldCount > 0 || seconds(MidiEventQueue::now()) <= m_lastEnd + PAST_SECONDS)) {
+        update();
+    }
+}
+
+/**
+ * @brief Destroys the shaders and the vertex buffer
+ */
+void NoteVisualizer::releaseGL()
+{
+    if (!m_program && !m_vertexBuffer.isCreated()) {
+        return;
+    }
+    makeCurrent();
+    m_vertexBuffer.destroy();
+    delete m_program;
+    m_program = nullptr;
+    doneCurrent();
+}
@@ -0,0 +1,171 @@
+/**
+ * @file notevisualizer.h
+ * @brief Header file for the NoteVisualizer class
+ * @author Alan Cruz
+ * @details This file defines NoteVisualizer, the falling-notes view shown with
+ *          the piano on the free-style and lesson screens.
+ */
+
+#ifndef NOTEVISUALIZER_H
+#define NOTEVISUALIZER_H
+
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLWidget>
+#include <deque>
+#include <vector>
+
+class PianoWidget;
+class QFrame;
+
+/**
+ * @brief Falling notes of the prompts and scrolling piano roll of the played notes
+ * @details Time runs from the top of the widget to the bottom: the notes of a
+ *          prompt fall towards the now line as they are about to sound, and every
+ *          note, prompted or played, keeps scrolling down past it for
+ *          PAST_SECONDS. Notes line up with the keys of the piano and follow its
+ *          scrolling and zoom.
+ *
+ *          Every note is one quad in a ring of MAX_NOTES quads kept in a single
+ *          vertex buffer, so the whole view is one draw call. A vertex holds its
+ *          key position in white keys and its time in seconds; the vertex shader
+ *          maps both to the screen from the current time and the piano's window,
+ *          so the buffer only changes when a note starts or ends, and only the
+ *          quads that changed are uploaded. A held note's end is stored as "now"
+ *          and stretches on the GPU until it is released.
+ *
+ *          Frames are requested only while the widget is shown and a note is in
+ *          view; each one is paced by the buffer swap, i.e. the display's refresh
+ *          rate.
+ */
+class NoteVisualizer : public QOpenGLWidget, protected QOpenGLFunctions
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_NOTES = 4096;            ///< Notes kept; the oldest is overwritten first
+    static constexpr float FUTURE_SECONDS = 3.0f;     ///< Time shown above the now line
+    static constexpr float PAST_SECONDS = 1.0f;       ///< Time shown below the now line
+
+    /**
+     * @brief Creates a visualizer of a piano's notes
+     * @param piano The piano whose played notes and prompts are shown
+     * @param parent Parent widget
+     */
+    explicit NoteVisualizer(PianoWidget* piano, QWidget* parent = nullptr);
+
+    /**
+     * @brief Releases the GPU resources
+     */
+    ~NoteVisualizer() override;
+
+    /**
+     * @brief Shows the visualizer in a placeholder frame
+     * @param placeholder The frame to fill
+     */
+    void attachToPlaceholder(QFrame* placeholder);
+
+    /**
+     * @brief Hides the visualizer until it is attached again
+     * @details The widget keeps its parent, so its GL context survives.
+     */
+    void detach();
+
+protected:
+    /**
+     * @brief Compiles the shaders and uploads the notes
+     */
+    void initializeGL() override;
+
+    /**
+     * @brief Uploads the changed notes and draws the view
+     */
+    void paintGL() override;
+
+    /**
+     * @brief Starts drawing frames when the widget is shown
+     * @param event The show event
+     */
+    void showEvent(QShowEvent* event) override;
+
+private:
+    static constexpr float OPEN_END = -1.0f;  // Time of the end of a held note
+
+    /**
+     * @brief Vertex of a note quad
+     */
+    struct Vertex {
+        float key;   ///< Horizontal position in white keys, from NoteTable::NoteInfo::whiteIndex
+        float time;  ///< Seconds since m_epoch, or OPEN_END
+        float kind;  ///< Kind: 0 prompt, 2 played; plus 1 for a black key
+    };
+
+    /**
+     * @brief Adds a note
+     * @param note The MIDI note
+     * @param start When it starts, from MidiEventQueue::now()
+     * @param end When it ends, or -1 while it is held
+     * @param played Whether the player played it rather than a prompt
+     * @return Slot of the note
+     */
+    int addNote(int note, qint64 start, qint64 end, bool played);
+
+    /**
+     * @brief Moves the start and end of a note
+     * @param slot Slot of the note
+     * @param start New start in seconds since m_epoch
+     * @param end New end in seconds since m_epoch, or OPEN_END
+     */
+    void setNoteTimes(int slot, float start, float end);
+
+    /**
+     * @brief Ends a held note now
+     * @param note The MIDI note
+     */
+    void releaseNote(int note);
+
+    /**
+     * @brief Cuts the prompt notes that have not ended at the current time
+     */
+    void cancelPrompt();
+
+    /**
+     * @brief Converts a MidiEventQueue::now() time to the time of a vertex
+     * @param time The time in nanoseconds
+     * @return Seconds since m_epoch, at least 0
+     */
+    float seconds(qint64 time) const;
+
+    /**
+     * @brief Requests the next frame if a note is still in view
+     */
+    void scheduleFrame();
+
+    /**
+     * @brief Destroys the shaders and the vertex buffer
+     * @details Called before the GL context goes away.
+     */
+    void releaseGL();
+
+    PianoWidget* m_piano;                     // Piano the notes line up with
+    QOpenGLShaderProgram* m_program;          // Maps the vertices to the screen, nullptr before initializeGL()
+    QOpenGLBuffer m_vertexBuffer;             // MAX_NOTES quads of 6 vertices
+    std::vector<Vertex> m_vertices;           // CPU copy of m_vertexBuffer
+    int m_nextSlot;                           // Slot the next note is written to
+    int m_usedSlots;                          // Slots written so far, up to MAX_NOTES
+    int m_dirtyFirst;                         // First slot not uploaded yet, -1 if all are
+    int m_dirtyLast;                          // Last slot not uploaded yet
+    int m_heldSlot[128];                      // Slot of each held note, -1 if not held
+    int m_heldCount;                          // Number of held notes
+    std::deque<int> m_promptSlots;            // Slots of prompt notes that may not have ended
+    qint64 m_epoch;                           // MidiEventQueue::now() at time 0
+    float m_lastEnd;                          // Latest end of a note, in seconds since m_epoch
+    int m_nowLocation;                        // Locations of the shader uniforms
+    int m_keyTransformLocation;
+    int m_timeTransformLocation;
+    int m_promptColorLocation;
+    int m_playedColorLocation;
+};
+
+#endif // NOTEVISUALIZER_H
@@ -0,0 +1,735 @@
+/**
+ * @file onlinematch.cpp
+ * @brief Implementation of the OnlineMatch class
+ * @author Alan Cruz, Hadeed Pall
+ * @details This file implements the UDP transport, the clock offset estimation, the
+ *          state replication from the host and the client-side verdict prediction
+ *          of online matches.
+ */
+
+#include "onlinematch.h"
+#include "midieventqueue.h"
+#include <cstring>
+#include <QDebug>
+#include <QHostInfo>
+#include <QNetworkDatagram>
+#include <QNetworkInterface>
+#include <QTimer>
+#include <QUdpSocket>
+
+/**
+ * @brief Constructs an idle match
+ * @param parent The parent QObject
+ * @param questionBank Question bank both sides play from
+ */
+OnlineMatch::OnlineMatch(QObject* parent, const QuestionBank& questionBank)
+    : QObject(parent)
+    , m_questionBank(questionBank)
+    , m_socket(nullptr)
+    , m_timer(new QTimer(this))
+    , m_role(Role::None)
+    , m_connected(false)
+    , m_lookupID(-1)
+    , m_peerPort(0)
+    , m_lastReceived(0)
+    , m_lastHeartbeat(0)
+    , m_openedAt(0)
+    , m_game(nullptr)
+    , m_topicID(GameSession::GENERAL_TOPIC_ID)
+    , m_pendingReaction(0)
+    , m_judgingLocal(false)
+    , m_state{}
+    , m_hasState(false)
+    , m_pendingAttempt{}
+    , m_hasPendingAttempt(false)
+    , m_predictedCorrect(false)
+    , m_nextAttemptID(1)
+    , m_lastResend(0)
+    , m_clockSamples{}
+    , m_clockSampleCount(0)
+    , m_clockOffset(0)
+    , m_roundTrip(-1)
+{
+    m_timer->setInterval(RESEND_MS);
+    connect(m_timer, &QTimer::timeout, this, &OnlineMatch::tick);
+}
+
+/**
+ * @brief Destructor, leaves an open match
+ */
+OnlineMatch::~OnlineMatch()
+{
+    close();
+}
+
+/**
+ * @brief Opens the socket and starts the timer
+ * @param port Port to bind, 0 for any
+ * @return false if the socket could not be bound
+ * @details The datagrams are marked for the voice class (DSCP EF), which Wi-Fi
+ *          access points with WMM send ahead of bulk traffic.
+ */
+bool OnlineMatch::openSocket(quint16 port)
+{
+    close();
+    m_socket = new QUdpSocket(this);
+    if (!m_socket->bind(QHostAddress::AnyIPv4, port)) {
+        qDebug() << "OnlineMatch: Could not open UDP port" << port << ":" << m_socket->errorString();
+        delete m_socket;
+        m_socket = nullptr;
+        return false;
+    }
+    m_socket->setSocketOption(QAbstractSocket::TypeOfServiceOption, 0xB8);
+    connect(m_socket, &QUdpSocket::readyRead, this, &OnlineMatch::readPendingDatagrams);
+
+    m_connected = false;
+    m_hasState = false;
+    m_state = MatchState{};
+    m_hasPendingAttempt = false;
+    m_clockSampleCount = 0;
+    m_clockOffset = 0;
+    m_roundTrip = -1;
+    m_openedAt = m_lastReceived = MidiEventQueue::now();
+    m_lastHeartbeat = 0;
+    m_timer->start();
+    return true;
+}
+
+/**
+ * @brief Opens a match and waits for a client
+ * @param topicID The topic to play
+ * @param port UDP port to listen on
+ * @return false if the port could not be opened
+ * @details The game is dealt when the client joins.
+ */
+bool OnlineMatch::host(int topicID, quint16 port)
+{
+    if (!openSocket(port)) {
+        return false;
+    }
+    m_role = Role::Host;
+    m_topicID = topicID;
+
+    if (!m_game) {
+        m_game = new MultiplayerGame(this, topicID, SessionRng::randomSeed(), m_questionBank);
+        connect(m_game, &MultiplayerGame::highlightKeys, this, &OnlineMatch::recordVerdict);
+        connect(m_game, &MultiplayerGame::updateUI, this,
+                [this](int currentPlayer, int player1Score, int player2Score, QString title, QString description) {
+            sendState();
+            emit updateUI(currentPlayer, player1Score, player2Score, title, description);
+        });
+        connect(m_game, &MultiplayerGame::gameOver, this, [this](int player1Score, int player2Score) {
+            sendState();
+            emit gameOver(player1Score, player2Score);
+        });
+    }
+    qDebug() << "OnlineMatch: Hosting on port" << port << "at" << localAddresses();
+    return true;
+}
+
+/**
+ * @brief Joins the match of a host
+ * @param address Address of the host as "host" or "host:port"; names are resolved
+ * @return false if the address is invalid or no socket could be opened
+ * @details A host name is looked up in the background so a slow name server does
+ *          not freeze the window; the first hello is sent once it has answered. If
+ *          the lookup fails or no socket can be opened then, disconnected() is
+ *          emitted.
+ */
+bool OnlineMatch::join(const QString& address)
+{
+    QString hostName = address.trimmed();
+    quint16 hostPort = MATCH_DEFAULT_PORT;
+    int colon = hostName.lastIndexOf(':');
+    if (colon > 0 && hostName.indexOf(':') == colon) {
+        bool ok = false;
+        hostPort = hostName.mid(colon + 1).toUShort(&ok);
+        if (!ok || hostPort == 0) {
+            qDebug() << "OnlineMatch: Invalid port in" << address;
+            return false;
+        }
+        hostName = hostName.left(colon);
+    }
+
+    QHostAddress hostAddress(hostName);
+    if (!hostAddress.isNull()) {
+        return connectToHost(hostAddress, hostPort);
+    }
+
+    close();
+    m_role = Role::Client;
+    m_lookupID = QHostInfo::lookupHost(hostName, this, [this, hostName, hostPort](const QHostInfo& info) {
+        m_lookupID = -1;
+        const QList<QHostAddress> found = info.addresses();
+        for (const QHostAddress& candidate : found) {
+            if (candidate.protocol() == QAbstractSocket::IPv4Protocol) {
+                if (!connectToHost(candidate, hostPort)) {
+                    m_role = Role::None;
+                    emit disconnected("Could not open a network port.");
+                }
+                return;
+            }
+        }
+        qDebug() << "OnlineMatch: Could not resolve" << hostName << ":" << info.errorString();
+        m_role = Role::None;
+        emit disconnected(QString("Could not find the host %1.").arg(hostName));
+    });
+    return true;
+}
+
+/**
+ * @brief Opens the socket of a client and starts sending hellos
+ * @param hostAddress Address of the host
+ * @param hostPort Port of the host
+ * @return false if no socket could be opened
+ */
+bool OnlineMatch::connectToHost(const QHostAddress& hostAddress, quint16 hostPort)
+{
+    if (!openSocket(0)) {
+        return false;
+    }
+    m_role = Role::Client;
+    m_peerAddress = hostAddress;
+    m_peerPort = hostPort;
+    tick();
+    return true;
+}
+
+/**
+ * @brief Leaves the match and tells the other side
+ */
+void OnlineMatch::close()
+{
+    if (m_lookupID != -1) {
+        QHostInfo::abortHostLookup(m_lookupID);
+        m_lookupID = -1;
+        m_role = Role::None;
+    }
+    if (!m_socket) {
+        return;
+    }
+    if (m_connected) {
+        send(MatchByePacket, nullptr, 0);
+    }
+    m_timer->stop();
+    m_socket->deleteLater();
+    m_socket = nullptr;
+    m_role = Role::None;
+    m_connected = false;
+    m_hasPendingAttempt = false;
+}
+
+/**
+ * @brief Gets the IPv4 addresses a client can join this computer on
+ * @return The addresses of all interfaces except loopback
+ */
+QStringList OnlineMatch::localAddresses()
+{
+    QStringList addresses;
+    const QList<QHostAddress> all = QNetworkInterface::allAddresses();
+    for (const QHostAddress& address : all) {
+        if (address.protocol() == QAbstractSocket::IPv4Protocol && !address.isLoopback()) {
+            addresses.append(address.toString());
+        }
+    }
+    return addresses;
+}
+
+/**
+ * @brief Gets the port the host listens on
+ * @return The port, 0 if no match is hosted
+ */
+quint16 OnlineMatch::port() const
+{
+    return m_socket && m_role == Role::Host ? m_socket->localPort() : 0;
+}
+
+/**
+ * @brief Checks whether this side may answer the current question
+ * @return true if the game is running and it is this side's turn
+ */
+bool OnlineMatch::isLocalTurn() const
+{
+    if (!m_connected || !m_hasState || (m_state.flags & MATCH_STATE_GAME_OVER) || m_state.questionID < 0) {
+        return false;
+    }
+    return m_state.currentPlayer == localPlayer() && !m_hasPendingAttempt;
+}
+
+/**
+ * @brief Gets the notes the current question expects
+ * @return The expected notes, empty if no question is being asked
+ */
+NoteSet OnlineMatch::currentExpectedNotes() const
+{
+    const QuestionBank::AnswerKey* answer = m_hasState ? m_questionBank.answerKey(m_state.questionID) : nullptr;
+    return answer ? answer->notes : NoteSet();
+}
+
+/**
+ * @brief Sends a key press or release of the local player
+ * @param note MIDI note number
+ * @param velocity Note-on velocity, 0 for a release
+ */
+void OnlineMatch::sendNote(int note, int velocity)
+{
+    if (!isLocalTurn() || note < 0 || note > 127) {
+        return;
+    }
+    MatchNote packet{};
+    packet.time = MidiEventQueue::now() + m_clockOffset;
+    packet.player = static_cast<uint8_t>(localPlayer());
+    packet.note = static_cast<uint8_t>(note);
+    packet.velocity = static_cast<uint8_t>(qBound(0, velocity, 127));
+    sendPayload(MatchNotePacket, packet);
+}
+
+/**
+ * @brief Answers the current question
+ * @param playedNotes The notes played
+ * @param shownTime When the question appeared on screen, on the local clock
+ * @param firstNoteTime When the first note was played, on the local clock
+ */
+void OnlineMatch::submitAttempt(const NoteSet& playedNotes, qint64 shownTime, qint64 firstNoteTime)
+{
+    if (!isLocalTurn() || playedNotes.isEmpty()) {
+        return;
+    }
+
+    if (m_role == Role::Host) {
+        if (!m_game || m_game->isGameOver()) {
+            return;
+        }
+        m_pendingReaction = firstNoteTime - shownTime;
+        m_judgingLocal = true;
+        m_game->playerAttempt(playedNotes);
+        m_judgingLocal = false;
+        return;
+    }
+
+    // Show the predicted verdict now; the host's verdict corrects it if needed
+    m_predictedCorrect = m_questionBank.answerKey(m_state.questionID)
+                         && m_questionBank.answerKey(m_state.questionID)->notes.isAnsweredBy(playedNotes);
+    emit highlightKeys(m_predictedCorrect);
+
+    m_pendingAttempt = MatchAttempt{};
+    m_pendingAttempt.attemptID = m_nextAttemptID++;
+    m_pendingAttempt.questionID = m_state.questionID;
+    m_pendingAttempt.shownTime = shownTime + m_clockOffset;
+    m_pendingAttempt.firstNoteTime = firstNoteTime + m_clockOffset;
+    m_pendingAttempt.midiMask[0] = playedNotes.midiMask(0);
+    m_pendingAttempt.midiMask[1] = playedNotes.midiMask(1);
+    m_pendingAttempt.pitchClassMask = playedNotes.pitchClassMask();
+    m_pendingAttempt.flags = playedNotes.flags();
+    m_hasPendingAttempt = true;
+    m_lastResend = MidiEventQueue::now();
+    sendPayload(MatchAttemptPacket, m_pendingAttempt);
+}
+
+/**
+ * @brief Sends a datagram to the other side
+ * @param type The MatchPacketType
+ * @param payload The payload, or nullptr if the type has none
+ * @param size Size of the payload in bytes
+ */
+void OnlineMatch::send(MatchPacketType type, const void* payload, int size)
+{
+    if (!m_socket || m_peerPort == 0) {
+        return;
+    }
+    char datagram[sizeof(MatchPacketHeader) + sizeof(MatchAttempt)];
+    Q_ASSERT(size <= static_cast<int>(sizeof(datagram) - sizeof(MatchPacketHeader)));
+
+    MatchPacketHeader header{{MATCH_MAGIC[0], MATCH_MAGIC[1]}, MATCH_PROTOCOL_VERSION, static_cast<uint8_t>(type)};
+    std::memcpy(datagram, &header, sizeof(header));
+    if (size > 0) {
+        std::memcpy(datagram + sizeof(header), payload, size);
+    }
+    m_socket->writeDatagram(datagram, sizeof(header) + size, m_peerAddress, m_peerPort);
+}
+
+/**
+ * @brief Reads and dispatches every datagram that has arrived
+ * @details Datagrams with a wrong magic, version or size are dropped, as are
+ *          datagrams from anyone but the peer once a match is connected.
+ */
+void OnlineMatch::readPendingDatagrams()
+{
+    while (m_socket && m_socket->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_socket->receiveDatagram(sizeof(MatchPacketHeader) + sizeof(MatchAttempt));
+        const qint64 receiveTime = MidiEventQueue::now();
+        const QByteArray data = datagram.data();
+
+        MatchPacketHeader header;
+        if (data.size() < static_cast<int>(sizeof(header))) {
+            continue;
+        }
+        std::memcpy(&header, data.constData(), sizeof(header));
+        if (header.magic[0] != MATCH_MAGIC[0] || header.magic[1] != MATCH_MAGIC[1]
+                || header.version != MATCH_PROTOCOL_VERSION) {
+            continue;
+        }
+
+        const QHostAddress sender = datagram.senderAddress();
+        const quint16 senderPort = static_cast<quint16>(datagram.senderPort());
+        const bool fromPeer = m_peerPort != 0 && sender.isEqual(m_peerAddress, QHostAddress::TolerantConversion)
+                              && senderPort == m_peerPort;
+        if (!fromPeer && !(m_role == Role::Host && header.type == MatchHelloPacket)) {
+            continue;
+        }
+
+        const char* payload = data.constData() + sizeof(header);
+        const int payloadSize = data.size() - static_cast<int>(sizeof(header));
+        auto read = [payload, payloadSize](auto& value) {
+            if (payloadSize != static_cast<int>(sizeof(value))) {
+                return false;
+            }
+            std::memcpy(&value, payload, sizeof(value));
+            matchByteOrder(value);
+            return true;
+        };
+
+        if (fromPeer) {
+            m_lastReceived = receiveTime;
+        }
+
+        switch (header.type) {
+        case MatchHelloPacket: {
+            MatchHello hello;
+            if (m_role == Role::Host && read(hello)) {
+                handleHello(sender, senderPort, hello);
+            }
+            break;
+        }
+        case MatchWelcomePacket: {
+            MatchWelcome welcome;
+            if (m_role == Role::Client && read(welcome)) {
+                handleWelcome(welcome);
+            }
+            break;
+        }
+        case MatchPingPacket: {
+            MatchPing ping;
+            if (m_role == Role::Host && read(ping)) {
+                sendPayload(MatchPongPacket, MatchPong{ping.clientSend, receiveTime, MidiEventQueue::now()});
+            }
+            break;
+        }
+        case MatchPongPacket: {
+            MatchPong pong;
+            if (m_role == Role::Client && read(pong)) {
+                handlePong(pong, receiveTime);
+            }
+            break;
+        }
+        case MatchNotePacket: {
+            MatchNote note;
+            if (m_connected && read(note) && note.player != localPlayer() && note.note <= 127) {
+                // Played a little later than it happened, so uneven delivery keeps its rhythm
+                qint64 localTime = note.time - m_clockOffset + PLAYOUT_DELAY_NS;
+                emit remoteNote(note.note, note.velocity, qMax(localTime, receiveTime));
+            }
+            break;
+        }
+        case MatchAttemptPacket: {
+            MatchAttempt attempt;
+            if (m_role == Role::Host && m_connected && read(attempt)) {
+                handleAttempt(attempt);
+            }
+            break;
+        }
+        case MatchStatePacket: {
+            MatchState state;
+            if (m_role == Role::Client && m_connected && read(state)) {
+                handleState(state);
+            }
+            break;
+        }
+        case MatchByePacket:
+            dropPeer("The other player left the match.");
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Handles a join request on the host
+ * @param sender Address of the client
+ * @param senderPort Port of the client
+ * @param hello The request
+ * @details The first client with the same question bank, by size and content
+ *          hash, becomes player 2 and the game is dealt. A repeated hello of that
+ *          client is answered again, since the first welcome may have been lost;
+ *          other clients are turned away.
+ */
+void OnlineMatch::handleHello(const QHostAddress& sender, quint16 senderPort, const MatchHello& hello)
+{
+    const bool fromPeer = m_connected && sender.isEqual(m_peerAddress, QHostAddress::TolerantConversion)
+                          && senderPort == m_peerPort;
+    if (m_connected && !fromPeer) {
+        return;
+    }
+    if (hello.questionCount != static_cast<uint32_t>(m_questionBank.size())
+            || hello.bankHash != m_questionBank.contentHash()) {
+        qDebug() << "OnlineMatch: Client has a different question bank," << hello.questionCount
+                 << "questions instead of" << m_questionBank.size() << "or other questions";
+        return;
+    }
+
+    const bool newPeer = !m_connected;
+    m_peerAddress = sender;
+    m_peerPort = senderPort;
+    m_connected = true;
+    m_lastReceived = MidiEventQueue::now();
+
+    if (newPeer) {
+        m_state = MatchState{};
+        m_game->reset(m_topicID);
+    }
+
+    sendPayload(MatchWelcomePacket, MatchWelcome{m_game->getSeed(), m_topicID,
+                                                 static_cast<uint32_t>(m_questionBank.size()),
+                                                 m_questionBank.contentHash()});
+
+    if (newPeer) {
+        qDebug() << "OnlineMatch: Player 2 joined from" << sender.toString() << senderPort;
+        emit connected();
+        m_game->start();
+    } else {
+        sendState();
+    }
+}
+
+/**
+ * @brief Handles the host's welcome on the client
+ * @param welcome The welcome
+ */
+void OnlineMatch::handleWelcome(const MatchWelcome& welcome)
+{
+    if (m_connected) {
+        return;
+    }
+    if (welcome.questionCount != static_cast<uint32_t>(m_questionBank.size())
+            || welcome.bankHash != m_questionBank.contentHash()) {
+        dropPeer("The host uses a different version of KeyQuest.");
+        return;
+    }
+    m_topicID = welcome.topicID;
+    m_connected = true;
+    qDebug() << "OnlineMatch: Joined the match of" << m_peerAddress.toString() << "with seed" << welcome.seed;
+    emit connected();
+}
+
+/**
+ * @brief Adds a clock sample from a pong on the client
+ * @param pong The pong
+ * @param receiveTime Local time the pong arrived
+ * @details The sample with the shortest round trip among the latest CLOCK_SAMPLES
+ *          is used: its offset error is at most half of that round trip, and the
+ *          queueing delays that spoil the others are mostly gone from it.
+ */
+void OnlineMatch::handlePong(const MatchPong& pong, qint64 receiveTime)
+{
+    ClockSample sample;
+    sample.roundTrip = (receiveTime - pong.clientSend) - (pong.hostSend - pong.hostReceive);
+    sample.offset = ((pong.hostReceive - pong.clientSend) + (pong.hostSend - receiveTime)) / 2;
+    if (sample.roundTrip < 0) {
+        return;
+    }
+    m_clockSamples[m_clockSampleCount % CLOCK_SAMPLES] = sample;
+    ++m_clockSampleCount;
+
+    const int count = qMin(m_clockSampleCount, CLOCK_SAMPLES);
+    const ClockSample* best = &m_clockSamples[0];
+    for (int i = 1; i < count; ++i) {
+        if (m_clockSamples[i].roundTrip < best->roundTrip) {
+            best = &m_clockSamples[i];
+        }
+    }
+    m_clockOffset = best->offset;
+    m_roundTrip = best->roundTrip;
+}
+
+/**
+ * @brief Judges an attempt of the client on the host
+ * @param attempt The attempt
+ * @details Each attempt ID is judged once; repeats only get the state again, which
+ *          acknowledges them. An attempt that is not for the current question or
+ *          arrives out of turn is acknowledged without being judged.
+ */
+void OnlineMatch::handleAttempt(const MatchAttempt& attempt)
+{
+    if (attempt.attemptID <= m_state.ackedAttemptID) {
+        sendState();
+        return;
+    }
+    m_state.ackedAttemptID = attempt.attemptID;
+
+    if (!m_game || m_game->isGameOver() || m_game->getCurrentPlayer() != 2
+            || attempt.questionID != m_game->getCurrentQuestionID()) {
+        sendState();
+        return;
+    }
+
+    NoteSet played = NoteSet::fromMasks(attempt.pitchClassMask, attempt.midiMask[0], attempt.midiMask[1], attempt.flags);
+    m_pendingReaction = attempt.firstNoteTime - attempt.shownTime;
+    m_judgingLocal = false;
+    m_game->playerAttempt(played);
+}
+
+/**
+ * @brief Records the verdict of an attempt on the host
+ * @param isCorrect Whether the attempt was correct
+ * @details Called by the game before it scores the attempt, so the current player
+ *          is still the one who answered. The feedback is only shown here for the
+ *          host's own attempts; the client shows its own.
+ */
+void OnlineMatch::recordVerdict(bool isCorrect)
+{
+    const int player = m_game->getCurrentPlayer();
+    ++m_state.verdictID;
+    m_state.verdictPlayer = static_cast<uint8_t>(player);
+    m_state.reactionUs = static_cast<int32_t>(qBound<qint64>(0, m_pendingReaction / 1000, INT32_MAX));
+    if (isCorrect) {
+        m_state.flags |= MATCH_STATE_VERDICT_CORRECT;
+    } else {
+        m_state.flags &= ~MATCH_STATE_VERDICT_CORRECT;
+    }
+
+    if (m_judgingLocal) {
+        emit highlightKeys(isCorrect);
+    }
+    emit verdict(player, isCorrect, m_state.reactionUs / 1000.0);
+}
+
+/**
+ * @brief Sends the current state of the host's game
+ */
+void OnlineMatch::sendState()
+{
+    if (m_role != Role::Host || !m_game) {
+        return;
+    }
+    ++m_state.stateID;
+    m_state.questionID = m_game->getCurrentQuestionID();
+    m_state.player1Score = static_cast<int16_t>(m_game->getPlayer1Score());
+    m_state.player2Score = static_cast<int16_t>(m_game->getPlayer2Score());
+    m_state.questionsAsked = static_cast<uint16_t>(m_game->getQuestionsAsked());
+    m_state.currentPlayer = static_cast<uint8_t>(m_game->getCurrentPlayer());
+    if (m_game->isGameOver()) {
+        m_state.flags |= MATCH_STATE_GAME_OVER;
+    } else {
+        m_state.flags &= ~MATCH_STATE_GAME_OVER;
+    }
+    m_hasState = true;
+    m_lastHeartbeat = MidiEventQueue::now();
+
+    if (m_connected) {
+        sendPayload(MatchStatePacket, m_state);
+    }
+}
+
+/**
+ * @brief Applies a replicated state on the client
+ * @param state The state
+ * @details Repeats and reordered older states are dropped. The UI is only updated
+ *          when the question, the turn or a score changed, so heartbeats cost nothing.
+ */
+void OnlineMatch::handleState(const MatchState& state)
+{
+    if (m_hasState && state.stateID <= m_state.stateID) {
+        return;
+    }
+    const MatchState previous = m_state;
+    const bool first = !m_hasState;
+    m_state = state;
+    m_hasState = true;
+
+    if (m_hasPendingAttempt && state.ackedAttemptID >= m_pendingAttempt.attemptID) {
+        m_hasPendingAttempt = false;
+    }
+
+    if (state.verdictID != previous.verdictID && state.verdictPlayer != 0) {
+        const bool correct = (state.flags & MATCH_STATE_VERDICT_CORRECT) != 0;
+        if (state.verdictPlayer == localPlayer() && correct != m_predictedCorrect) {
+            emit highlightKeys(correct);
+        }
+        emit verdict(state.verdictPlayer, correct, state.reactionUs / 1000.0);
+    }
+
+    if (first || state.questionID != previous.questionID || state.currentPlayer != previous.currentPlayer
+            || state.player1Score != previous.player1Score || state.player2Score != previous.player2Score
+            || state.questionsAsked != previous.questionsAsked) {
+        const Question* question = m_questionBank.question(state.questionID);
+        emit updateUI(state.currentPlayer, state.player1Score, state.player2Score,
+                      question ? question->getTitle() : QString(),
+                      question ? question->getDescription() : QString());
+    }
+
+    if ((state.flags & MATCH_STATE_GAME_OVER) && (first || !(previous.flags & MATCH_STATE_GAME_OVER))) {
+        emit gameOver(state.player1Score, state.player2Score);
+    }
+}
+
+/**
+ * @brief Sends heartbeats, pings and attempt resends, and detects a lost peer
+ */
+void OnlineMatch::tick()
+{
+    if (!m_socket) {
+        return;
+    }
+    const qint64 now = MidiEventQueue::now();
+    const qint64 heartbeatNs = qint64(HEARTBEAT_MS) * 1000000;
+
+    if (m_role == Role::Client) {
+        if (!m_connected) {
+            if (now - m_openedAt > qint64(TIMEOUT_MS) * 1000000) {
+                dropPeer("No match was found at that address.");
+                return;
+            }
+            if (m_lastHeartbeat == 0 || now - m_lastHeartbeat >= heartbeatNs) {
+                sendPayload(MatchHelloPacket, MatchHello{static_cast<uint32_t>(m_questionBank.size()), 0,
+                                                         m_questionBank.contentHash()});
+            }
+        }
+        if (m_lastHeartbeat == 0 || now - m_lastHeartbeat >= heartbeatNs) {
+            sendPayload(MatchPingPacket, MatchPing{now});
+            m_lastHeartbeat = now;
+        }
+        if (m_hasPendingAttempt && now - m_lastResend >= qint64(RESEND_MS) * 1000000) {
+            sendPayload(MatchAttemptPacket, m_pendingAttempt);
+            m_lastResend = now;
+        }
+    } else if (m_role == Role::Host && m_connected && now - m_lastHeartbeat >= heartbeatNs) {
+        sendPayload(MatchStatePacket, m_state);
+        m_lastHeartbeat = now;
+    }
+
+    if (m_connected && now - m_lastReceived > qint64(TIMEOUT_MS) * 1000000) {
+        dropPeer("The connection to the other player was lost.");
+    }
+}
+
+/**
+ * @brief Ends the match after the other side left or went silent
+ * @param reason Text describing why, for the player
+ * @details The host keeps listening for a new client; the client closes.
+ */
+void OnlineMatch::dropPeer(const QString& reason)
+{
+    qDebug() << "OnlineMatch:" << reason;
+    const bool gameFinished = m_hasState && (m_state.flags & MATCH_STATE_GAME_OVER);
+    if (m_role == Role::Host) {
+        m_connected = false;
+        m_peerPort = 0;
+    } else {
+        m_connected = false;
+        close();
+    }
+    if (!gameFinished) {
+        emit disconnected(reason);
+    }
+}
@@ -0,0 +1,363 @@
+/**
+ * @file onlinematch.h
+ * @brief Header file for the OnlineMatch class
+ * @author Alan Cruz, Hadeed Pall
+ * @details This file defines OnlineMatch, the networked version of the two-player
+ *          game: one KeyQuest hosts an authoritative MultiplayerGame and a second one
+ *          joins it over UDP.
+ */
+
+#ifndef ONLINEMATCH_H
+#define ONLINEMATCH_H
+
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include "matchprotocol.h"
+#include "multiplayergame.h"
+#include "noteset.h"
+#include "questionbank.h"
+
+class QTimer;
+class QUdpSocket;
+
+/**
+ * @brief A two-player match between two computers
+ * @details The host is player 1 and runs the only MultiplayerGame; the client is
+ *          player 2 and replicates its state. The transport is plain UDP with the
+ *          small fixed-size datagrams of matchprotocol.h, so a round costs one
+ *          datagram each way and nothing waits for retransmission:
+ *          - the host sends the full MatchState on every change and as a heartbeat,
+ *            so a lost state is repaired by the next one
+ *          - the client repeats an attempt every RESEND_MS until a state
+ *            acknowledges it; the host judges each attempt ID once
+ *          - note events are sent once; a lost one is only a missed sound
+ *
+ *          The client pings the host every HEARTBEAT_MS. Of the last CLOCK_SAMPLES
+ *          pings the one with the shortest round trip gives the clock offset, so
+ *          times leave the client already converted to the host clock. Reaction
+ *          times are measured from the moment the question appeared on the
+ *          answering player's own screen, so neither player is penalized by the
+ *          network delay.
+ *
+ *          The client predicts the verdict of its own attempts with the shared
+ *          question bank and emits highlightKeys() at once. If the host's verdict
+ *          differs, highlightKeys() is emitted again with the host's verdict.
+ *
+ *          Both sides use the same interface, so MultiplayerGameWidget drives a
+ *          match like a local game: updateUI(), gameOver() and highlightKeys() have
+ *          the same meaning as those of MultiplayerGame.
+ */
+class OnlineMatch : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int HEARTBEAT_MS = 100;   ///< Interval of the host's state and the client's ping
+    static constexpr int RESEND_MS = 30;       ///< Interval at which an unacknowledged attempt is repeated
+    static constexpr int TIMEOUT_MS = 5000;    ///< Silence after which the other side counts as gone
+    static constexpr int CLOCK_SAMPLES = 8;    ///< Pings the clock offset is estimated from
+    static constexpr qint64 PLAYOUT_DELAY_NS = 40000000;  ///< Delay added to remote notes to even out jitter
+
+    /**
+     * @brief Role of this side of the match
+     */
+    enum class Role {
+        None,    ///< No match is open
+        Host,    ///< Player 1, runs the authoritative game
+        Client   ///< Player 2, replicates the host's game
+    };
+
+    /**
+     * @brief Constructs an idle match
+     * @param parent The parent QObject
+     * @param questionBank Question bank both sides play from; must outlive the match
+     */
+    explicit OnlineMatch(QObject* parent = nullptr, const QuestionBank& questionBank = *QuestionBank::instance());
+    ~OnlineMatch();
+
+    /**
+     * @brief Opens a match and waits for a client
+     * @param topicID The topic to play
+     * @param port UDP port to listen on
+     * @return false if the port could not be opened
+     */
+    bool host(int topicID, quint16 port = MATCH_DEFAULT_PORT);
+
+    /**
+     * @brief Joins the match of a host
+     * @param address Address of the host as "host" or "host:port"; names are resolved
+     * @return false if the address is invalid or no socket could be opened
+     * @details A host name is looked up in the background; if the lookup fails or
+     *          no socket can be opened afterwards, disconnected() is emitted.
+     */
+    bool join(const QString& address);
+
+    /**
+     * @brief Leaves the match and tells the other side
+     */
+    void close();
+
+    /**
+     * @brief Gets the role of this side
+     * @return The role, Role::None if no match is open
+     */
+    Role role() const { return m_role; }
+
+    /**
+     * @brief Checks whether the other side has answered
+     * @return true once the client has been welcomed
+     */
+    bool isConnected() const { return m_connected; }
+
+    /**
+     * @brief Gets the IPv4 addresses a client can join this computer on
+     * @return The addresses of all interfaces except loopback
+     */
+    static QStringList localAddresses();
+
+    /**
+     * @brief Gets the port the host listens on
+     * @return The port, 0 if no match is hosted
+     */
+    quint16 port() const;
+
+    /**
+     * @brief Gets the player number of this side
+     * @return 1 for the host, 2 for the client
+     */
+    int localPlayer() const { return m_role == Role::Client ? 2 : 1; }
+
+    /**
+     * @brief Checks whether this side may answer the current question
+     * @return true if the game is running and it is this side's turn
+     */
+    bool isLocalTurn() const;
+
+    /**
+     * @brief Gets the notes the current question expects
+     * @return The expected notes, empty if no question is being asked
+     */
+    NoteSet currentExpectedNotes() const;
+
+    /**
+     * @brief Gets the estimated clock offset
+     * @return Host clock minus local clock in nanoseconds; 0 on the host
+     */
+    qint64 clockOffset() const { return m_clockOffset; }
+
+    /**
+     * @brief Gets the round-trip time of the best clock sample
+     * @return Round-trip time in nanoseconds, -1 before the first sample
+     */
+    qint64 roundTripTime() const { return m_roundTrip; }
+
+    /**
+     * @brief Sends a key press or release of the local player
+     * @param note MIDI note number
+     * @param velocity Note-on velocity, 0 for a release
+     * @details Ignored unless it is this side's turn.
+     */
+    void sendNote(int note, int velocity);
+
+    /**
+     * @brief Answers the current question
+     * @param playedNotes The notes played
+     * @param shownTime When the question appeared on screen, on the local clock
+     * @param firstNoteTime When the first note was played, on the local clock
+     * @details Ignored unless it is this side's turn. The host judges its own attempts
+     *          directly; the client predicts the verdict and sends the attempt.
+     */
+    void submitAttempt(const NoteSet& playedNotes, qint64 shownTime, qint64 firstNoteTime);
+
+signals:
+    /**
+     * @brief Signal emitted when the other side has joined or welcomed this side
+     */
+    void connected();
+
+    /**
+     * @brief Signal emitted when the match ended without a game over
+     * @param reason Text describing why, for the player
+     */
+    void disconnected(const QString& reason);
+
+    /**
+     * @brief Signal emitted when the question, turn or scores change
+     * @param currentPlayer The current player number
+     * @param player1Score Player 1's score
+     * @param player2Score Player 2's score
+     * @param title The current question title
+     * @param description The current question description
+     */
+    void updateUI(int currentPlayer, int player1Score, int player2Score, QString title, QString description);
+
+    /**
+     * @brief Signal emitted when the game ends
+     * @param player1Score Player 1's final score
+     * @param player2Score Player 2's final score
+     */
+    void gameOver(int player1Score, int player2Score);
+
+    /**
+     * @brief Signal emitted for key highlighting feedback of a local attempt
+     * @param isCorrect True if the answer was correct, false otherwise
+     */
+    void highlightKeys(bool isCorrect);
+
+    /**
+     * @brief Signal emitted when the host has judged an attempt of either player
+     * @param player The player who answered
+     * @param correct Whether the answer was correct
+     * @param reactionMs Time from the question to the first note in milliseconds
+     */
+    void verdict(int player, bool correct, double reactionMs);
+
+    /**
+     * @brief Signal emitted for a key played by the other player
+     * @param note MIDI note number
+     * @param velocity Note-on velocity, 0 for a release
+     * @param time When to play it, on the local MidiEventQueue::now() clock
+     */
+    void remoteNote(int note, int velocity, qint64 time);
+
+private slots:
+    /**
+     * @brief Reads and dispatches every datagram that has arrived
+     */
+    void readPendingDatagrams();
+
+    /**
+     * @brief Sends heartbeats, pings and attempt resends, and detects a lost peer
+     */
+    void tick();
+
+private:
+    /**
+     * @brief Opens the socket and starts the timer
+     * @param port Port to bind, 0 for any
+     * @return false if the socket could not be bound
+     */
+    bool openSocket(quint16 port);
+
+    /**
+     * @brief Opens the socket of a client and starts sending hellos
+     * @param hostAddress Address of the host
+     * @param hostPort Port of the host
+     * @return false if no socket could be opened
+     */
+    bool connectToHost(const QHostAddress& hostAddress, quint16 hostPort);
+
+    /**
+     * @brief Sends a datagram to the other side
+     * @param type The MatchPacketType
+     * @param payload The payload, or nullptr if the type has none
+     * @param size Size of the payload in bytes
+     */
+    void send(MatchPacketType type, const void* payload, int size);
+
+    /**
+     * @brief Sends a datagram with a payload in wire byte order
+     * @param type The MatchPacketType
+     * @param payload The payload in host byte order; a copy is converted
+     */
+    template <typename Payload>
+    void sendPayload(MatchPacketType type, Payload payload)
+    {
+        matchByteOrder(payload);
+        send(type, &payload, sizeof(payload));
+    }
+
+    /**
+     * @brief Handles a join request on the host
+     * @param sender Address of the client
+     * @param senderPort Port of the client
+     * @param hello The request
+     */
+    void handleHello(const QHostAddress& sender, quint16 senderPort, const MatchHello& hello);
+
+    /**
+     * @brief Handles the host's welcome on the client
+     * @param welcome The welcome
+     */
+    void handleWelcome(const MatchWelcome& welcome);
+
+    /**
+     * @brief Adds a clock sample from a pong on the client
+     * @param pong The pong
+     * @param receiveTime Local time the pong arrived
+     */
+    void handlePong(const MatchPong& pong, qint64 receiveTime);
+
+    /**
+     * @brief Judges an attempt of the client on the host
+     * @param attempt The attempt
+     */
+    void handleAttempt(const MatchAttempt& attempt);
+
+    /**
+     * @brief Applies a replicated state on the client
+     * @param state The state
+     */
+    void handleState(const MatchState& state);
+
+    /**
+     * @brief Sends the current state of the host's game
+     */
+    void sendState();
+
+    /**
+     * @brief Records the verdict of an attempt on the host
+     * @param isCorrect Whether the attempt was correct
+     */
+    void recordVerdict(bool isCorrect);
+
+    /**
+     * @brief Ends the match after the other side left or went silent
+     * @param reason Text describing why, for the player
+     */
+    void dropPeer(const QString& reason);
+
+    /**
+     * @brief One NTP-style clock measurement
+     */
+    struct ClockSample {
+        qint64 offset;     ///< Host clock minus local clock
+        qint64 roundTrip;  ///< Network round-trip time
+    };
+
+    const QuestionBank& m_questionBank;  ///< Questions both sides play from
+    QUdpSocket* m_socket;        ///< Socket of the match, nullptr while idle
+    QTimer* m_timer;             ///< Drives tick() every RESEND_MS
+    Role m_role;                 ///< Role of this side
+    bool m_connected;            ///< Whether the other side has answered
+    int m_lookupID;              ///< Pending QHostInfo lookup of the host, -1 if none
+    QHostAddress m_peerAddress;  ///< Address of the other side
+    quint16 m_peerPort;          ///< Port of the other side
+    qint64 m_lastReceived;       ///< Local time of the last datagram from the other side
+    qint64 m_lastHeartbeat;      ///< Local time of the last heartbeat, ping or hello
+    qint64 m_openedAt;           ///< Local time the match was opened
+
+    // Host
+    MultiplayerGame* m_game;     ///< Authoritative game, host only
+    int m_topicID;               ///< Topic of the match
+    qint64 m_pendingReaction;    ///< Reaction time of the attempt being judged, in nanoseconds
+    bool m_judgingLocal;         ///< Whether the attempt being judged was played on this side
+
+    // Replicated state
+    MatchState m_state;          ///< Latest state sent (host) or received (client)
+    bool m_hasState;             ///< Whether the client has received a state yet
+
+    // Client
+    MatchAttempt m_pendingAttempt;  ///< Attempt waiting for the host's acknowledgement
+    bool m_hasPendingAttempt;    ///< Whether m_pendingAttempt is waiting
+    bool m_predictedCorrect;     ///< Verdict predicted for the latest own attempt
+    quint32 m_nextAttemptID;     ///< ID of the next own attempt
+    qint64 m_lastResend;         ///< Local time the pending attempt was last sent
+    ClockSample m_clockSamples[CLOCK_SAMPLES];  ///< Latest clock samples, oldest overwritten first
+    int m_clockSampleCount;      ///< Samples taken so far
+    qint64 m_clockOffset;        ///< Host clock minus local clock of the best sample
+    qint64 m_roundTrip;          ///< Round-trip time of the best sample, -1 without samples
+};
+
+#endif // ONLINEMATCH_H
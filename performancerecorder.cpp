@@ -0,0 +1,201 @@
+/**
+ * @file performancerecorder.cpp
+ * @brief Implementation of the PerformanceRecorder class
+ * @author Alan Cruz
+ * @details This file implements the writer thread of recordings and the
+ *          streamed playback of MIDI files on the keyboard's sequencer.
+ */
+
+#include "performancerecorder.h"
+#include "keyboard.h"
+#include "midieventqueue.h"
+#include <QDebug>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+
+/**
+ * @brief Creates a recorder
+ * @param keyboard Keyboard whose notes are recorded and which plays recordings
+ * @param parent Parent object
+ */
+PerformanceRecorder::PerformanceRecorder(Keyboard* keyboard, QObject* parent)
+    : QObject(parent)
+    , m_keyboard(keyboard)
+    , m_writerThread(nullptr)
+    , m_stopWriting(false)
+    , m_recordedNotes(0)
+    , m_playbackTimer(new QTimer(this))
+    , m_hasNextEvent(false)
+    , m_sequence(0)
+    , m_playbackStart(0)
+    , m_playbackEnd(0)
+{
+    m_playbackTimer->setInterval(PLAYBACK_INTERVAL_MS);
+    m_playbackTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_playbackTimer, &QTimer::timeout, this, &PerformanceRecorder::advancePlayback);
+}
+
+/**
+ * @brief Stops recording and playback
+ */
+PerformanceRecorder::~PerformanceRecorder()
+{
+    stopRecording();
+    stopPlayback();
+}
+
+/**
+ * @brief Starts recording
+ * @param filePath The MIDI file to write
+ * @return true if the writer thread was started
+ * @details The file is created on the writer thread; a file that cannot be
+ *          created ends the recording with no notes.
+ */
+bool PerformanceRecorder::startRecording(const QString& filePath)
+{
+    if (!m_keyboard || filePath.isEmpty()) {
+        return false;
+    }
+    stopRecording();
+
+    const qint64 startTime = MidiEventQueue::now();
+    m_recordingPath = filePath;
+    m_recordedNotes.store(0, std::memory_order_relaxed);
+    m_stopWriting.store(false, std::memory_order_release);
+    m_writerThread = QThread::create([this, filePath, startTime]() { writeRecording(filePath, startTime); });
+    m_writerThread->setObjectName("PerformanceRecorder");
+    m_writerThread->start();
+    m_keyboard->setRecording(true);
+    qDebug() << "PerformanceRecorder: Recording to" << filePath;
+    return true;
+}
+
+/**
+ * @brief Stops recording and completes the file
+ */
+void PerformanceRecorder::stopRecording()
+{
+    if (!m_writerThread) {
+        return;
+    }
+    m_keyboard->setRecording(false);
+    m_stopWriting.store(true, std::memory_order_release);
+    m_writerThread->wait();
+    delete m_writerThread;
+    m_writerThread = nullptr;
+
+    const qint64 notes = m_recordedNotes.load(std::memory_order_acquire);
+    m_lastRecording = m_recordingPath;
+    qDebug() << "PerformanceRecorder: Recorded" << notes << "notes to" << m_recordingPath;
+    emit recordingFinished(m_recordingPath, notes);
+}
+
+/**
+ * @brief Drains the record queue into the file until stopRecording()
+ * @param filePath The MIDI file
+ * @param startTime Time of the start of the recording
+ * @details Events left in the queue by an earlier recording are older than the
+ *          start and are dropped. Each pass flushes the file, so at most one
+ *          interval of notes is lost if the application is killed.
+ */
+void PerformanceRecorder::writeRecording(const QString& filePath, qint64 startTime)
+{
+    MidiEventQueue& queue = m_keyboard->recordQueue();
+    SmfWriter writer;
+    const bool open = writer.open(filePath, startTime);
+
+    while (true) {
+        const bool stopping = m_stopWriting.load(std::memory_order_acquire);
+        while (const MidiEvent* event = queue.peek()) {
+            if (open && event->time >= startTime) {
+                writer.write(*event);
+            }
+            queue.pop();
+        }
+        if (open) {
+            writer.flush();
+            m_recordedNotes.store(writer.noteCount(), std::memory_order_release);
+        }
+        if (stopping) {
+            break;
+        }
+        QThread::msleep(DRAIN_INTERVAL_MS);
+    }
+
+    if (open) {
+        writer.close(MidiEventQueue::now());
+    }
+}
+
+/**
+ * @brief Plays a MIDI file, stopping the one that is playing
+ * @param filePath The file
+ * @return true if the file could be read
+ */
+bool PerformanceRecorder::play(const QString& filePath)
+{
+    stopPlayback();
+    if (!m_keyboard || !m_reader.open(filePath)) {
+        return false;
+    }
+
+    m_hasNextEvent = m_reader.next(m_nextEvent);
+    if (!m_hasNextEvent) {
+        m_reader.close();
+        return false;
+    }
+    m_playbackStart = MidiEventQueue::now() + qint64(START_DELAY_MS) * 1000000;
+    m_playbackEnd = m_playbackStart;
+    m_sequence = m_keyboard->beginSequence(Keyboard::PLAYBACK_CHANNEL);
+    qDebug() << "PerformanceRecorder: Playing" << filePath;
+    advancePlayback();
+    m_playbackTimer->start();
+    return true;
+}
+
+/**
+ * @brief Stops playback and silences its notes
+ */
+void PerformanceRecorder::stopPlayback()
+{
+    if (!m_sequence) {
+        return;
+    }
+    m_playbackTimer->stop();
+    m_keyboard->cancelSequence(m_sequence);
+    m_sequence = 0;
+    m_hasNextEvent = false;
+    m_reader.close();
+}
+
+/**
+ * @brief Schedules the events of the playback that are due soon
+ * @details Finishes once the file is read and its last event has been played.
+ */
+void PerformanceRecorder::advancePlayback()
+{
+    if (!m_sequence) {
+        return;
+    }
+
+    const qint64 now = MidiEventQueue::now();
+    const qint64 horizon = now + qint64(SCHEDULE_AHEAD_MS) * 1000000;
+    while (m_hasNextEvent && m_playbackStart + m_nextEvent.time <= horizon) {
+        const qint64 time = m_playbackStart + m_nextEvent.time;
+        if (m_nextEvent.type == MidiEvent::NoteOn) {
+            m_keyboard->scheduleNoteOn(m_sequence, m_nextEvent.key, m_nextEvent.velocity, time);
+        } else {
+            m_keyboard->scheduleNoteOff(m_sequence, m_nextEvent.key, time);
+        }
+        m_playbackEnd = std::max(m_playbackEnd, time);
+        m_hasNextEvent = m_reader.next(m_nextEvent);
+    }
+
+    if (!m_hasNextEvent && now >= m_playbackEnd) {
+        m_playbackTimer->stop();
+        m_sequence = 0;
+        m_reader.close();
+        emit playbackFinished();
+    }
+}
@@ -0,0 +1,142 @@
+/**
+ * @file performancerecorder.h
+ * @brief Header file for the PerformanceRecorder class
+ * @author Alan Cruz
+ * @details This file defines PerformanceRecorder, which records what is played
+ *          on the piano to a MIDI file and plays recordings back.
+ */
+
+#ifndef PERFORMANCERECORDER_H
+#define PERFORMANCERECORDER_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include "smffile.h"
+
+class Keyboard;
+class QThread;
+class QTimer;
+
+/**
+ * @brief Records live notes to a Standard MIDI File and plays recordings back
+ * @details Recording taps the audio callback: Keyboard copies every live note it
+ *          applies into its record queue (see Keyboard::setRecording()), and a
+ *          writer thread drains that queue every DRAIN_INTERVAL_MS into an
+ *          SmfWriter. Nothing runs on the path of a key press, the queue and the
+ *          writer's buffer have fixed sizes, and the file is flushed as it grows,
+ *          so a recording of any length uses the same memory.
+ *
+ *          Playback streams the file with an SmfReader and hands its events to
+ *          the keyboard's sequencer on PLAYBACK_CHANNEL a short while ahead, like
+ *          a prompt, so it starts at once however long the recording is.
+ */
+class PerformanceRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DRAIN_INTERVAL_MS = 20;  ///< How often the writer thread drains the record queue
+
+    /**
+     * @brief Creates a recorder
+     * @param keyboard Keyboard whose notes are recorded and which plays recordings
+     * @param parent Parent object
+     */
+    explicit PerformanceRecorder(Keyboard* keyboard, QObject* parent = nullptr);
+
+    /**
+     * @brief Stops recording and playback
+     */
+    ~PerformanceRecorder() override;
+
+    /**
+     * @brief Starts recording
+     * @param filePath The MIDI file to write
+     * @return true if the file was created
+     */
+    bool startRecording(const QString& filePath);
+
+    /**
+     * @brief Stops recording and completes the file
+     * @details Waits for the writer thread's last drain, at most one interval.
+     */
+    void stopRecording();
+
+    /**
+     * @brief Checks whether a recording is running
+     * @return true from startRecording() until stopRecording()
+     */
+    bool isRecording() const { return m_writerThread != nullptr; }
+
+    /**
+     * @brief Gets the file of the last completed recording
+     * @return The path, empty if nothing was recorded yet
+     */
+    QString lastRecording() const { return m_lastRecording; }
+
+    /**
+     * @brief Plays a MIDI file, stopping the one that is playing
+     * @param filePath The file
+     * @return true if the file could be read
+     */
+    bool play(const QString& filePath);
+
+    /**
+     * @brief Stops playback and silences its notes
+     */
+    void stopPlayback();
+
+    /**
+     * @brief Checks whether a recording is playing
+     * @return true from play() until playbackFinished() or stopPlayback()
+     */
+    bool isPlaying() const { return m_sequence != 0; }
+
+signals:
+    /**
+     * @brief Emitted when a recording has been completed
+     * @param filePath The MIDI file
+     * @param notes Number of notes recorded
+     */
+    void recordingFinished(const QString& filePath, qint64 notes);
+
+    /**
+     * @brief Emitted when the last note of a recording played back has ended
+     */
+    void playbackFinished();
+
+private:
+    static const int START_DELAY_MS = 150;      // Time from play() to the first note
+    static const int SCHEDULE_AHEAD_MS = 250;   // How early an event is handed to the keyboard
+    static const int PLAYBACK_INTERVAL_MS = 50; // How often more events are scheduled
+
+    /**
+     * @brief Drains the record queue into the file until stopRecording()
+     * @param filePath The MIDI file
+     * @param startTime Time of the start of the recording
+     * @details Runs on the writer thread, the only consumer of the queue.
+     */
+    void writeRecording(const QString& filePath, qint64 startTime);
+
+    /**
+     * @brief Schedules the events of the playback that are due soon
+     */
+    void advancePlayback();
+
+    Keyboard* m_keyboard;                  // Records and plays the notes
+    QThread* m_writerThread;               // Runs writeRecording(), nullptr when not recording
+    std::atomic<bool> m_stopWriting;       // Asks the writer thread to finish
+    std::atomic<qint64> m_recordedNotes;   // Notes of the recording, set by the writer thread
+    QString m_recordingPath;               // File being recorded
+    QString m_lastRecording;               // File of the last completed recording
+    SmfReader m_reader;                    // File being played back
+    QTimer* m_playbackTimer;               // Wakes advancePlayback()
+    MidiEvent m_nextEvent;                 // Next event of the playback, read but not scheduled
+    bool m_hasNextEvent;                   // Whether m_nextEvent holds an event
+    quint16 m_sequence;                    // Keyboard sequence of the playback, 0 if none
+    qint64 m_playbackStart;                // MidiEventQueue::now() time of the start of the file
+    qint64 m_playbackEnd;                  // Time of the last event scheduled
+};
+
+#endif // PERFORMANCERECORDER_H
@@ -5,20 +5,78 @@
  * @details This file implements a virtual piano widget that provides an interactive
  *          piano interface with both visual and keyboard input support. It includes
  *          features for key visualization, note labeling, and MIDI note emission.
+ *          The keys are painted by the widget itself rather than being child widgets.
  */
 
 #include "pianowidget.h"
-#include <QVBoxLayout>
-#include <QGridLayout>
+#include "loaddatamanager.h"
+#include "memorymonitor.h"
+#include "midieventqueue.h"
+#include "midiinput.h"
+#include "notetable.h"
+#include "performancerecorder.h"
+#include "promptplayer.h"
+#include "theme.h"
+#include "trace.h"
 #include <QKeyEvent>
-#include <QScreen>
-#include <QGuiApplication>
-#include <QtCore/QTimer>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPaintEvent>
+#include <QTextOption>
+#include <QWheelEvent>
 #include <QDebug>
+#include <algorithm>
 
 // Initialize static instance pointer
 PianoWidget* PianoWidget::s_instance = nullptr;
 
+/**
+ * @brief Gets the font used for the key labels
+ * @return Bold 14px font
+ */
+static QFont keyLabelFont()
+{
+    QFont font;
+    font.setPixelSize(14);
+    font.setBold(true);
+    return font;
+}
+
+/**
+ * @brief Renders the image of one key
+ * @param size Key size in device-independent pixels
+ * @param dpr Device pixel ratio to render at
+ * @param fill Key colour
+ * @param border Outline colour
+ * @return The key image with rounded bottom corners
+ */
+static QPixmap renderKeySprite(const QSize& size, qreal dpr, const QColor& fill, const QColor& border)
+{
+    QPixmap sprite(size * dpr);
+    sprite.setDevicePixelRatio(dpr);
+    sprite.fill(Qt::transparent);
+    if (size.isEmpty()) {
+        return sprite;
+    }
+
+    // Rounded bottom corners with a square top, as the keys used to be styled
+    const qreal radius = 4.0;
+    QRectF body = QRectF(QPointF(0, 0), QSizeF(size)).adjusted(0.5, 0.5, -0.5, -0.5);
+    QPainterPath path;
+    path.addRoundedRect(body, radius, radius);
+    QPainterPath top;
+    top.addRect(body.adjusted(0, 0, 0, -body.height() / 2));
+    path = path.united(top);
+
+    QPainter p(&sprite);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(QPen(border, 1.0));
+    p.setBrush(fill);
+    p.drawPath(path);
+    return sprite;
+}
+
 /**
  * @brief Gets the singleton instance of the PianoWidget
  * @return Pointer to the PianoWidget instance
@@ -40,261 +98,575 @@ PianoWidget* PianoWidget::instance() {
  */
 PianoWidget::PianoWidget(QWidget* parent)
     : QWidget(parent)
+    , m_labelToggleButton(new QPushButton(this))
     , m_currentPlaceholder(nullptr)
     , m_keyboard(new Keyboard())
-    , m_labelToggleButton(new QPushButton(this))
+    , m_midiInput(new MidiInput(m_keyboard, this))
+    , m_promptPlayer(new PromptPlayer(m_keyboard, this))
+    , m_recorder(new PerformanceRecorder(m_keyboard, this))
     , m_showLabels(false)
     , m_isKeyboardInput(false)
+    , m_currentNote(0)
+    , m_firstNote(NoteTable::MIDDLE_C)
+    , m_lastNote(NoteTable::MIDDLE_C + 12)
+    , m_visibleWhiteKeys(0)
+    , m_scrollKeys(0)
+    , m_wheelRemainder(0)
+    , m_whiteKeyWidth(0)
+    , m_blackKeyBottom(0)
+    , m_mouseNote(-1)
+    , m_hoverNote(-1)
+    , m_highlightAnimation(new QVariantAnimation(this))
 {
     // Set focus policy to receive keyboard events
     setFocusPolicy(Qt::StrongFocus);
-    
+
+    // Hover feedback needs move events without a pressed button
+    setMouseTracking(true);
+
     // Setup toggle button
     m_labelToggleButton->setText("Keys");
     m_labelToggleButton->setCheckable(true);
-    m_labelToggleButton->setStyleSheet(
-        "QPushButton {"
-        "    background-color: #333;"
-        "    color: white;"
-        "    border: 1px solid #666;"
-        "    border-radius: 4px;"
-        "    padding: 4px 8px;"
-        "}"
-        "QPushButton:checked {"
-        "    background-color: #666;"
-        "    border: 1px solid #999;"
-        "}"
-    );
+    m_labelToggleButton->setFocusProxy(this);
+    Theme::setRole(m_labelToggleButton, Theme::KEY_TOGGLE);
     connect(m_labelToggleButton, &QPushButton::toggled, this, &PianoWidget::onToggleLabels);
-    
-    initializePiano();
-    setupKeyboardMapping();
+
+    // Light the keys of a played-back prompt while its notes are heard
+    connect(m_promptPlayer, &PromptPlayer::noteStarted, this, [this](int note) {
+        m_promptNotes.set(note);
+        updateKey(note);
+    });
+    connect(m_promptPlayer, &PromptPlayer::noteStopped, this, [this](int note) {
+        m_promptNotes.reset(note);
+        updateKey(note);
+    });
+
+    // The highlight starts at 50% opacity and fades out over 500ms
+    m_highlightAnimation->setStartValue(0.5);
+    m_highlightAnimation->setEndValue(0.0);
+    m_highlightAnimation->setDuration(500);
+    m_highlightAnimation->setEasingCurve(QEasingCurve::InQuad);
+    connect(m_highlightAnimation, &QVariantAnimation::valueChanged, this, [this]() { update(); });
+
+    setKeyboardRange(keyboardRangeFromString(LoadDataManager::instance()->getKeyboardRange()));
+
+    // Notes from a MIDI keyboard are answered like clicks and key presses
+    connect(m_midiInput, &MidiInput::noteOn, this, [this](int note, int velocity, qint64 time) {
+        externalNoteOn(note, velocity, time);
+    });
+    connect(m_midiInput, &MidiInput::noteOff, this, [this](int note) { externalNoteOff(note); });
+    m_midiInput->start();
 }
 
 /**
- * @brief Initializes the piano interface
- * @details Creates and positions the white and black keys, sets up their labels,
- *          applies styling, and connects signal handlers.
+ * @brief Converts a stored range name to a range
+ * @param name "octave", "61" or "88"
+ * @return The range; Octave for unknown names
  */
-void PianoWidget::initializePiano() {
-    // Set focus policy to receive keyboard events
-    setFocusPolicy(Qt::StrongFocus);
-    
-    // Create white keys first (they go in the back)
-    const int numWhiteKeys = 8;
-    for (int i = 0; i < numWhiteKeys; i++) {
-        QPushButton* key = new QPushButton(this);
-        m_whiteKeys.append(key);
-        
-        // Create label for this key
-        QLabel* label = new QLabel(this);
-        label->setAlignment(Qt::AlignCenter);
-        label->hide();
-        m_whiteKeyLabels.append(label);
-    }
-
-    // Create black keys (they go on top)
-    const int numBlackKeys = 5;
-    for (int i = 0; i < numBlackKeys; i++) {
-        QPushButton* key = new QPushButton(this);
-        m_blackKeys.append(key);
-        
-        // Create label for this key
-        QLabel* label = new QLabel(this);
-        label->setAlignment(Qt::AlignCenter);
-        label->hide();
-        m_blackKeyLabels.append(label);
-    }
-
-    applyKeyStyles();
-    setupKeyLabels();
-    connectKeySignals();
+PianoWidget::KeyboardRange PianoWidget::keyboardRangeFromString(const QString& name) {
+    if (name == "61") {
+        return KeyboardRange::Keys61;
+    }
+    return name == "88" ? KeyboardRange::Keys88 : KeyboardRange::Octave;
+}
+
+/**
+ * @brief Converts a range to the name it is stored under
+ * @param range The range
+ * @return "octave", "61" or "88"
+ */
+QString PianoWidget::keyboardRangeToString(KeyboardRange range) {
+    switch (range) {
+    case KeyboardRange::Keys61: return "61";
+    case KeyboardRange::Keys88: return "88";
+    default: return "octave";
+    }
 }
 
 /**
  * @brief Sets up keyboard mapping for piano keys
- * @details Maps computer keyboard keys to piano keys:
- *          - White keys: A, S, D, F, G, H, J, K
+ * @details Maps computer keyboard keys to one octave of piano keys:
+ *          - White keys: A, S, D, F, G, H, J, K (C to C)
  *          - Black keys: W, E, T, Y, U
+ *          The octave starts at C4 when it is in the window, otherwise at the
+ *          first C of the window. The bindings are stored in a table indexed by
+ *          Qt key code, together with the index of the key in m_keys, so a key
+ *          event needs no search. Called again whenever the window moves.
  */
 void PianoWidget::setupKeyboardMapping() {
-    // Map computer keyboard keys to piano keys
-    const Qt::Key whiteKeyMapping[] = {
-        Qt::Key_A, Qt::Key_S, Qt::Key_D, Qt::Key_F,
-        Qt::Key_G, Qt::Key_H, Qt::Key_J, Qt::Key_K
-    };
-    
-    const Qt::Key blackKeyMapping[] = {
-        Qt::Key_W, Qt::Key_E, Qt::Key_T, Qt::Key_Y, Qt::Key_U
-    };
-    
-    // Map white keys
-    for (int i = 0; i < m_whiteKeys.size(); i++) {
-        m_keyToButton[whiteKeyMapping[i]] = m_whiteKeys[i];
-    }
-    
-    // Map black keys
-    for (int i = 0; i < m_blackKeys.size(); i++) {
-        m_keyToButton[blackKeyMapping[i]] = m_blackKeys[i];
-    }
-}
-
-/**
- * @brief Applies visual styles to piano keys
- * @details Sets up the appearance of white and black keys with hover and pressed states.
- */
-void PianoWidget::applyKeyStyles() {
-    // White key style
-    QString whiteKeyStyle = 
-        "QPushButton {"
-        "    background-color: white;"
-        "    border: 1px solid #999;"
-        "    border-bottom-left-radius: 4px;"
-        "    border-bottom-right-radius: 4px;"
-        "}"
-        "QPushButton:hover {"
-        "    background-color: #f0f0f0;"
-        "}"
-        "QPushButton:pressed {"
-        "    background-color: #e0e0e0;"
-        "    border: 1px solid #666;"
-        "}";
-
-    // Black key style
-    QString blackKeyStyle = 
-        "QPushButton {"
-        "    background-color: #111;"
-        "    border: 1px solid #000;"
-        "    border-bottom-left-radius: 4px;"
-        "    border-bottom-right-radius: 4px;"
-        "}"
-        "QPushButton:hover {"
-        "    background-color: #222;"
-        "}"
-        "QPushButton:pressed {"
-        "    background-color: #333;"
-        "    border: 1px solid #000;"
-        "}";
-
-    // Apply styles
-    for (auto key : m_whiteKeys) {
-        key->setStyleSheet(whiteKeyStyle);
-    }
-    for (auto key : m_blackKeys) {
-        key->setStyleSheet(blackKeyStyle);
-    }
-}
-
-/**
- * @brief Sets up labels for piano keys
- * @details Configures note labels for both white and black keys with appropriate styling.
- */
-void PianoWidget::setupKeyLabels() {
-    // White key labels with multiple notes
-    const QString whiteKeyNotes[][3] = {
-        {"B#", "C", "Dbb"},  // First C
-        {"C##", "D", "Ebb"}, // D
-        {"D##", "E", "Fb"},  // E
-        {"E#", "F", "Gbb"},  // F
-        {"F##", "G", "Abb"}, // G
-        {"G##", "A", "Bbb"}, // A
-        {"A##", "B", "Cb"},  // B
-        {"B#", "C", "Dbb"}   // Second C
+    // Map computer keyboard keys to semitones above the octave's C
+    static const struct { Qt::Key key; int offset; } mapping[] = {
+        // White keys
+        {Qt::Key_A, 0}, {Qt::Key_S, 2}, {Qt::Key_D, 4}, {Qt::Key_F, 5},
+        {Qt::Key_G, 7}, {Qt::Key_H, 9}, {Qt::Key_J, 11}, {Qt::Key_K, 12},
+        // Black keys
+        {Qt::Key_W, 1}, {Qt::Key_E, 3}, {Qt::Key_T, 6}, {Qt::Key_Y, 8}, {Qt::Key_U, 10}
     };
-    
-    for (int i = 0; i < m_whiteKeyLabels.size(); i++) {
-        QString labelText = whiteKeyNotes[i][0] + "\n" + whiteKeyNotes[i][1] + "\n" + whiteKeyNotes[i][2];
-        m_whiteKeyLabels[i]->setText(labelText);
-        m_whiteKeyLabels[i]->setStyleSheet(
-            "QLabel {"
-            "    color: black;"
-            "    background: transparent;"
-            "    font-size: 14px;"  // Smaller font to fit multiple lines
-            "    font-weight: bold;"
-            "    padding: 2px;"
-            "}"
-        );
-    }
-    
-    // Black key labels with multiple notes
-    const QString blackKeyNotes[][2] = {
-        {"C#", "Db"},  // C#/Db
-        {"D#", "Eb"},  // D#/Eb
-        {"F#", "Gb"},  // F#/Gb
-        {"G#", "Ab"},  // G#/Ab
-        {"A#", "Bb"}   // A#/Bb
-    };
-    
-    for (int i = 0; i < m_blackKeyLabels.size(); i++) {
-        QString labelText = blackKeyNotes[i][0] + "\n" + blackKeyNotes[i][1];
-        m_blackKeyLabels[i]->setText(labelText);
-        m_blackKeyLabels[i]->setStyleSheet(
-            "QLabel {"
-            "    color: white;"
-            "    background: transparent;"
-            "    font-size: 14px;"  // Even smaller font for black keys
-            "    font-weight: bold;"
-            "    padding: 1px;"
-            "}"
-        );
+
+    static_assert(Qt::Key_Z < KEY_BINDING_COUNT, "letter keys must fit the binding table");
+
+    std::fill(std::begin(m_keyBindings), std::end(m_keyBindings), KeyBinding());
+    if (m_whiteKeyIndexes.isEmpty()) {
+        return;
+    }
+
+    const int lastSlot = std::min<int>(m_scrollKeys + m_visibleWhiteKeys, m_whiteKeyIndexes.size()) - 1;
+    const int firstVisible = m_keys[m_whiteKeyIndexes[m_scrollKeys]].note;
+    const int lastVisible = m_keys[m_whiteKeyIndexes[std::max(lastSlot, m_scrollKeys)]].note;
+    int base = NoteTable::MIDDLE_C;
+    if (base < firstVisible || base > lastVisible) {
+        base = firstVisible + (12 - NoteTable::note(firstVisible).pitchClass) % 12;
+    }
+
+    for (const auto& entry : mapping) {
+        const int note = base + entry.offset;
+        if (!NoteTable::isValid(note)) {
+            continue;
+        }
+        KeyBinding& binding = m_keyBindings[entry.key];
+        binding.note = note;
+        binding.keyIndex = m_keyIndexByNote[note];
     }
 }
 
 /**
- * @brief Updates the visibility of key labels
- * @details Shows or hides all key labels based on the current visibility setting.
+ * @brief Looks up the piano key bound to a computer key
+ * @param key Qt key code
+ * @return The binding, or nullptr if the key is unbound or its note is not shown
  */
-void PianoWidget::updateKeyLabelsVisibility() {
-    for (auto label : m_whiteKeyLabels) {
-        label->setVisible(m_showLabels);
+const PianoWidget::KeyBinding* PianoWidget::bindingForKey(int key) const {
+    if (key < 0 || key >= KEY_BINDING_COUNT) {
+        return nullptr;
+    }
+    const KeyBinding& binding = m_keyBindings[key];
+    return binding.keyIndex >= 0 ? &binding : nullptr;
+}
+
+/**
+ * @brief Sets the range of keys shown
+ * @param firstNote MIDI note of the lowest key; moved down to a white key if needed
+ * @param lastNote MIDI note of the highest key; moved up to a white key if needed
+ */
+void PianoWidget::setNoteRange(int firstNote, int lastNote) {
+    firstNote = std::clamp(firstNote, 0, 127);
+    lastNote = std::clamp(lastNote, 0, 127);
+    if (firstNote > lastNote) {
+        qDebug() << "PianoWidget: Invalid note range" << firstNote << lastNote;
+        return;
+    }
+
+    // The keyboard has to start and end on white keys
+    if (NoteTable::isBlack(firstNote)) {
+        --firstNote;
     }
-    for (auto label : m_blackKeyLabels) {
-        label->setVisible(m_showLabels);
+    if (NoteTable::isBlack(lastNote)) {
+        ++lastNote;
     }
+
+    releaseAllNotes();
+    m_firstNote = firstNote;
+    m_lastNote = lastNote;
+    buildKeys();
+    m_keyboard->setSampleRange(firstNote, lastNote);
+
+    // Wide ranges open zoomed in around middle C
+    m_visibleWhiteKeys = std::min<int>(DEFAULT_VISIBLE_WHITE_KEYS, m_whiteKeyIndexes.size());
+    scrollToNote(NoteTable::MIDDLE_C);
 }
 
 /**
- * @brief Handles the label toggle button state change
- * @details Updates the visibility of key labels when the toggle button is clicked.
+ * @brief Shows one of the ranges offered in the settings
+ * @param range The range
  */
-void PianoWidget::onToggleLabels() {
-    m_showLabels = m_labelToggleButton->isChecked();
-    updateKeyLabelsVisibility();
+void PianoWidget::setKeyboardRange(KeyboardRange range) {
+    switch (range) {
+    case KeyboardRange::Keys61:
+        setNoteRange(36, 96);
+        break;
+    case KeyboardRange::Keys88:
+        setNoteRange(NoteTable::FIRST_88_KEY_NOTE, NoteTable::LAST_88_KEY_NOTE);
+        break;
+    default:
+        setNoteRange(NoteTable::MIDDLE_C, NoteTable::MIDDLE_C + 12);
+        break;
+    }
+}
+
+/**
+ * @brief Gets the memory the piano's drawing holds
+ * @return Bytes of the key sprites and key geometry
+ * @details The synthesizer is accounted for separately, see Keyboard::memoryUsage().
+ */
+qint64 PianoWidget::memoryUsage() const {
+    qint64 bytes = qint64(m_keys.capacity()) * qint64(sizeof(PianoKey))
+                   + qint64(m_whiteKeyIndexes.capacity()) * qint64(sizeof(int));
+    for (int state = 0; state < KeyStateCount; ++state) {
+        bytes += MemoryMonitor::pixmapBytes(m_whiteSprites[state]) + MemoryMonitor::pixmapBytes(m_blackSprites[state]);
+    }
+    return bytes;
+}
+
+/**
+ * @brief Sets how many white keys are shown at once
+ * @param count Number of white keys; clamped to MIN_VISIBLE_WHITE_KEYS and the range
+ * @details Zooms around the middle of the current window.
+ */
+void PianoWidget::setVisibleWhiteKeys(int count) {
+    const int total = m_whiteKeyIndexes.size();
+    count = std::clamp(count, std::min(MIN_VISIBLE_WHITE_KEYS, total), total);
+    if (count == m_visibleWhiteKeys) {
+        return;
+    }
+    const int middle = m_scrollKeys + m_visibleWhiteKeys / 2;
+    m_visibleWhiteKeys = count;
+    setScroll(middle - count / 2);
 }
 
 /**
- * @brief Connects signal handlers for piano keys
- * @details Sets up click and release event handlers for both white and black keys.
+ * @brief Scrolls the keyboard so that a note is in the middle of the window
+ * @param note The MIDI note; notes outside the range scroll to the nearest end
  */
-void PianoWidget::connectKeySignals() {
-    // Connect white keys
-    for (auto key : m_whiteKeys) {
-        connect(key, &QPushButton::pressed, this, &PianoWidget::onWhiteKeyPressed);
-        connect(key, &QPushButton::released, this, &PianoWidget::onKeyReleased);
+void PianoWidget::scrollToNote(int note) {
+    if (!NoteTable::isValid(note)) {
+        return;
     }
-    
-    // Connect black keys
-    for (auto key : m_blackKeys) {
-        connect(key, &QPushButton::pressed, this, &PianoWidget::onBlackKeyPressed);
-        connect(key, &QPushButton::released, this, &PianoWidget::onKeyReleased);
+    const int slot = NoteTable::note(note).whiteIndex - NoteTable::note(m_firstNote).whiteIndex;
+    setScroll(slot - m_visibleWhiteKeys / 2);
+}
+
+/**
+ * @brief Scrolls the window to a white key
+ * @param scrollKeys White keys to the left of the window; clamped to the range
+ * @details Held keys are released first, since the computer keys move with the window.
+ */
+void PianoWidget::setScroll(int scrollKeys) {
+    const int maxScroll = std::max<int>(0, m_whiteKeyIndexes.size() - m_visibleWhiteKeys);
+    releaseAllNotes();
+    m_scrollKeys = std::clamp(scrollKeys, 0, maxScroll);
+    m_hoverNote = -1;
+    setupKeyboardMapping();
+    layoutKeys();
+    update();
+}
+
+/**
+ * @brief Releases every pressed key
+ */
+void PianoWidget::releaseAllNotes() {
+    for (int note = 0; note < NoteTable::NOTE_COUNT && m_pressedNotes.any(); ++note) {
+        if (m_pressedNotes.test(note)) {
+            releaseNote(note);
+        }
     }
+    m_mouseNote = -1;
+}
+
+/**
+ * @brief Builds the list of keys for the current note range
+ * @details White keys are stored first so that painting the list in order draws
+ *          the black keys on top of them.
+ */
+void PianoWidget::buildKeys() {
+    m_keys.clear();
+    m_whiteKeyIndexes.clear();
+    std::fill(std::begin(m_keyIndexByNote), std::end(m_keyIndexByNote), -1);
+
+    for (int pass = 0; pass < 2; ++pass) {
+        const bool black = pass == 1;
+        for (int note = m_firstNote; note <= m_lastNote; ++note) {
+            const NoteInfo& info = NoteTable::note(note);
+            if (info.black != black) {
+                continue;
+            }
+            PianoKey key;
+            key.note = note;
+            key.black = black;
+            key.label.setTextFormat(Qt::RichText);
+            key.label.setText(QString::fromLatin1(NoteTable::spellings(info.pitchClass)));
+            m_keyIndexByNote[note] = m_keys.size();
+            if (!black) {
+                m_whiteKeyIndexes.append(m_keys.size());
+            }
+            m_keys.append(key);
+        }
+    }
+}
+
+/**
+ * @brief Computes the key and label rectangles for the current size
+ * @details Only m_visibleWhiteKeys white keys fit the width; keys outside the
+ *          window get rectangles outside the widget and are never painted.
+ */
+void PianoWidget::layoutKeys() {
+    if (m_whiteKeyIndexes.isEmpty()) {
+        return;
+    }
+
+    // Calculate white key dimensions
+    const int containerHeight = height();
+    m_whiteKeyWidth = std::max(1, width() / std::max(1, m_visibleWhiteKeys));
+    const int whiteKeyHeight = containerHeight * 0.9; // 90% of container height
+    const int whiteKeyY = containerHeight * 0.05; // 5% padding from top
+
+    // Calculate black key dimensions
+    const int blackKeyWidth = m_whiteKeyWidth * 0.6; // 60% of white key width
+    const int blackKeyHeight = whiteKeyHeight * 0.6; // 60% of white key height
+    m_blackKeyBottom = whiteKeyY + blackKeyHeight;
+
+    QTextOption labelOption(Qt::AlignHCenter);
+    const QFont font = keyLabelFont();
+
+    // Position white keys and their labels
+    for (int slot = 0; slot < m_whiteKeyIndexes.size(); ++slot) {
+        PianoKey& key = m_keys[m_whiteKeyIndexes[slot]];
+        key.rect = QRect((slot - m_scrollKeys) * m_whiteKeyWidth, whiteKeyY, m_whiteKeyWidth, whiteKeyHeight);
+        key.labelRect = QRect(key.rect.x(), whiteKeyY + whiteKeyHeight * 0.6, m_whiteKeyWidth, whiteKeyHeight / 3);
+    }
+
+    // Black keys sit on the edge between their two white neighbours, shifted as on a real piano
+    const int firstWhite = firstVisibleWhiteIndex();
+    for (PianoKey& key : m_keys) {
+        if (key.black) {
+            const NoteInfo& info = NoteTable::note(key.note);
+            int edge = (info.whiteIndex - firstWhite) * m_whiteKeyWidth;
+            int x = edge - blackKeyWidth / 2.0 + info.blackOffset * blackKeyWidth;
+            key.rect = QRect(x, whiteKeyY, blackKeyWidth, blackKeyHeight);
+            key.labelRect = QRect(x, whiteKeyY + blackKeyHeight * 0.1, blackKeyWidth, blackKeyHeight / 2);
+        }
+        key.label.setTextOption(labelOption);
+        key.label.setTextWidth(key.labelRect.width());
+        key.label.prepare(QTransform(), font);
+    }
+
+    renderSprites();
+    emit keyWindowChanged();
+}
+
+/**
+ * @brief Gets the white key at the left edge of the window
+ * @return Its NoteTable::NoteInfo::whiteIndex
+ */
+int PianoWidget::firstVisibleWhiteIndex() const {
+    return NoteTable::note(m_firstNote).whiteIndex + m_scrollKeys;
+}
+
+/**
+ * @brief Renders the key sprites for the current key size and pixel ratio
+ */
+void PianoWidget::renderSprites() {
+    const int whiteIndex = m_whiteKeyIndexes.isEmpty() ? -1 : m_whiteKeyIndexes.first();
+    const int blackIndex = m_keys.size() > m_whiteKeyIndexes.size() ? m_whiteKeyIndexes.size() : -1;
+    const qreal dpr = devicePixelRatioF();
+
+    // Colours match the stylesheets the keys used to have
+    if (whiteIndex >= 0) {
+        const QSize size = m_keys[whiteIndex].rect.size();
+        m_whiteSprites[Normal] = renderKeySprite(size, dpr, Qt::white, QColor("#999"));
+        m_whiteSprites[Hover] = renderKeySprite(size, dpr, QColor("#f0f0f0"), QColor("#999"));
+        m_whiteSprites[Pressed] = renderKeySprite(size, dpr, QColor("#e0e0e0"), QColor("#666"));
+        m_whiteSprites[Prompt] = renderKeySprite(size, dpr, QColor("#cfe3ff"), QColor("#6a8fc7"));
+    }
+    if (blackIndex >= 0) {
+        const QSize size = m_keys[blackIndex].rect.size();
+        m_blackSprites[Normal] = renderKeySprite(size, dpr, QColor("#111"), QColor("#000"));
+        m_blackSprites[Hover] = renderKeySprite(size, dpr, QColor("#222"), QColor("#000"));
+        m_blackSprites[Pressed] = renderKeySprite(size, dpr, QColor("#333"), QColor("#000"));
+        m_blackSprites[Prompt] = renderKeySprite(size, dpr, QColor("#2f5a94"), QColor("#000"));
+    }
+}
+
+/**
+ * @brief Draws the keys inside the dirty region and the highlight layer
+ * @param event The paint event
+ */
+void PianoWidget::paintEvent(QPaintEvent* event) {
+    KEYQUEST_TRACE_FRAME("PianoWidget::paintEvent");
+    if (m_keys.isEmpty()) {
+        return;
+    }
+
+    // Moving to a screen with another pixel ratio needs new sprites
+    if (m_whiteSprites[Normal].devicePixelRatio() != devicePixelRatioF()) {
+        renderSprites();
+    }
+
+    QPainter p(this);
+    const QRect dirty = event->rect();
+    if (m_showLabels) {
+        p.setFont(keyLabelFont());
+    }
+
+    for (const PianoKey& key : m_keys) {
+        if (!key.rect.intersects(dirty)) {
+            continue;
+        }
+        KeyState state = m_pressedNotes.test(key.note) ? Pressed
+                       : m_promptNotes.test(key.note) ? Prompt
+                       : key.note == m_hoverNote ? Hover
+                       : Normal;
+        p.drawPixmap(key.rect.topLeft(), key.black ? m_blackSprites[state] : m_whiteSprites[state]);
+
+        if (m_showLabels) {
+            p.setPen(key.black ? Qt::white : Qt::black);
+            QSizeF labelSize = key.label.size();
+            QPointF labelPos(key.labelRect.x(),
+                             key.labelRect.y() + (key.labelRect.height() - labelSize.height()) / 2);
+            p.drawStaticText(labelPos, key.label);
+        }
+    }
+
+    // Correct/incorrect feedback over all keys
+    if (m_highlightAnimation->state() == QAbstractAnimation::Running) {
+        QColor color = m_highlightColor;
+        color.setAlphaF(m_highlightAnimation->currentValue().toReal());
+        p.fillRect(rect(), color);
+    }
+}
+
+/**
+ * @brief Recomputes the key geometry and sprites for the new size
+ * @param event The resize event
+ */
+void PianoWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    layoutKeys();
+}
+
+/**
+ * @brief Finds the key at a position
+ * @param pos Position in widget coordinates
+ * @return The MIDI note of the key, or -1 if there is no key
+ * @details Only the white key under the position and its two neighbours are
+ *          checked, so the cost does not depend on the number of keys.
+ */
+int PianoWidget::noteAt(const QPoint& pos) const {
+    if (m_whiteKeyWidth <= 0 || pos.x() < 0) {
+        return -1;
+    }
+    int slot = pos.x() / m_whiteKeyWidth + m_scrollKeys;
+    if (slot >= m_whiteKeyIndexes.size()) {
+        return -1;
+    }
+
+    const PianoKey& white = m_keys[m_whiteKeyIndexes[slot]];
+
+    // Black keys lie on top of the upper part of the white keys
+    if (pos.y() < m_blackKeyBottom) {
+        for (int neighbour : {white.note - 1, white.note + 1}) {
+            if (neighbour < 0 || neighbour > 127) {
+                continue;
+            }
+            int index = m_keyIndexByNote[neighbour];
+            if (index >= 0 && m_keys[index].black && m_keys[index].rect.contains(pos)) {
+                return neighbour;
+            }
+        }
+    }
+    return white.rect.contains(pos) ? white.note : -1;
+}
+
+/**
+ * @brief Presses a key, plays its note and emits notePlayed and keyPressed
+ * @param note The MIDI note
+ * @details Called straight from the mouse and key event handlers, so the time is
+ *          taken before anything else runs.
+ */
+void PianoWidget::pressNote(int note) {
+    const qint64 time = MidiEventQueue::now();
+    KEYQUEST_TRACE_SCOPE("PianoWidget::pressNote");
+    if (note < 0 || note > 127 || m_pressedNotes.test(note) || !m_keyboard) {
+        return;
+    }
+    KEYQUEST_TRACE_INPUT();
+    m_pressedNotes.set(note);
+    m_keyboard->playNote(note);
+    emit notePlayed(note, 127, time);
+    emit keyPressed(note);
+    updateKey(note);
+}
+
+/**
+ * @brief Releases a key, stops its note and emits keyReleased
+ * @param note The MIDI note
+ */
+void PianoWidget::releaseNote(int note) {
+    if (note < 0 || note > 127 || !m_pressedNotes.test(note) || !m_keyboard) {
+        return;
+    }
+    m_pressedNotes.reset(note);
+    m_keyboard->stopNote(note);
+    emit keyReleased(note);
+    updateKey(note);
+}
+
+/**
+ * @brief Schedules a repaint of one key
+ * @param note The MIDI note of the key
+ * @details White keys also repaint the black keys overlapping them, since the
+ *          dirty rectangle covers those too.
+ */
+void PianoWidget::updateKey(int note) {
+    if (note < 0 || note > 127 || m_keyIndexByNote[note] < 0) {
+        return;
+    }
+    update(m_keys[m_keyIndexByNote[note]].rect);
+}
+
+/**
+ * @brief Presses a key played on an external MIDI keyboard
+ * @param note The MIDI note
+ * @param velocity Note-on velocity (1-127)
+ * @param time When the key went down, stamped by MidiInput on the MIDI thread
+ * @details The note is already sounding; MidiInput sent it to the synthesizer.
+ */
+void PianoWidget::externalNoteOn(int note, int velocity, qint64 time) {
+    if (!NoteTable::isValid(note) || m_pressedNotes.test(note)) {
+        return;
+    }
+    KEYQUEST_TRACE_INPUT();
+    m_pressedNotes.set(note);
+    emit notePlayed(note, velocity, time);
+    emit keyPressed(note);
+    updateKey(note);
+}
+
+/**
+ * @brief Releases a key played on an external MIDI keyboard
+ * @param note The MIDI note
+ */
+void PianoWidget::externalNoteOff(int note) {
+    if (!NoteTable::isValid(note) || !m_pressedNotes.test(note)) {
+        return;
+    }
+    m_pressedNotes.reset(note);
+    emit keyReleased(note);
+    updateKey(note);
+}
+
+/**
+ * @brief Updates the visibility of key labels
+ * @details Called when the label toggle button changes state.
+ */
+void PianoWidget::onToggleLabels() {
+    m_showLabels = m_labelToggleButton->isChecked();
+    update();
 }
 
 /**
  * @brief Attaches the piano widget to a placeholder frame
  * @param placeholder Pointer to the QFrame where the piano should be displayed
- * @details Positions and sizes the piano widget and its components within the
- *          specified placeholder frame.
+ * @details Positions and sizes the piano widget within the specified placeholder
+ *          frame; the keys are laid out again by the resulting resize event.
  */
 void PianoWidget::attachToPlaceholder(QFrame* placeholder) {
     if (!placeholder) return;
-    
+
     m_currentPlaceholder = placeholder;
-    
+
     // Set this widget's size to match placeholder
     this->setParent(placeholder);
     this->setGeometry(0, 0, placeholder->width(), placeholder->height());
-    
+
     // Position toggle button in top-right corner
     const int buttonWidth = 60;
     const int buttonHeight = 25;
@@ -303,73 +675,12 @@ void PianoWidget::attachToPlaceholder(QFrame* placeholder) {
     m_labelToggleButton->move(placeholder->width() - buttonWidth - buttonMargin, buttonMargin);
     m_labelToggleButton->raise();
     m_labelToggleButton->show();
-    
-    // Calculate key dimensions based on placeholder size
-    const int containerWidth = placeholder->width();
-    const int containerHeight = placeholder->height();
-    const int numWhiteKeys = 8;
-    
-    // Calculate white key dimensions
-    const int whiteKeyWidth = containerWidth / numWhiteKeys;
-    const int whiteKeyHeight = containerHeight * 0.9; // 90% of container height
-    const int whiteKeyY = containerHeight * 0.05; // 5% padding from top
-    
-    // Calculate black key dimensions
-    const int blackKeyWidth = whiteKeyWidth * 0.6; // 60% of white key width
-    const int blackKeyHeight = whiteKeyHeight * 0.6; // 60% of white key height
-    
-    // Position white keys and their labels
-    for (int i = 0; i < m_whiteKeys.size(); i++) {
-        QPushButton* key = m_whiteKeys[i];
-        key->setFixedSize(whiteKeyWidth, whiteKeyHeight);
-        key->move(i * whiteKeyWidth, whiteKeyY);
-        key->show();
-        
-        // Position label
-        QLabel* label = m_whiteKeyLabels[i];
-        label->setFixedSize(whiteKeyWidth, whiteKeyHeight / 3);
-        label->move(i * whiteKeyWidth, whiteKeyY + whiteKeyHeight * 0.6);
-        label->setVisible(m_showLabels);
-    }
-    
-    // Position black keys and their labels
-    const double blackKeyPositions[] = {
-        whiteKeyWidth - (blackKeyWidth / 2.0),  // C#
-        whiteKeyWidth * 2 - (blackKeyWidth / 2.0),  // D#
-        whiteKeyWidth * 4 - (blackKeyWidth / 2.0),  // F#
-        whiteKeyWidth * 5 - (blackKeyWidth / 2.0),  // G#
-        whiteKeyWidth * 6 - (blackKeyWidth / 2.0)   // A#
-    };
-    
-    for (int i = 0; i < m_blackKeys.size(); i++) {
-        QPushButton* key = m_blackKeys[i];
-        key->setFixedSize(blackKeyWidth, blackKeyHeight);
-        key->move(blackKeyPositions[i], whiteKeyY);
-        key->raise();
-        key->show();
-        
-        // Position label
-        QLabel* label = m_blackKeyLabels[i];
-        label->setFixedSize(blackKeyWidth, blackKeyHeight / 2);
-        label->move(blackKeyPositions[i], whiteKeyY + blackKeyHeight * 0.1);
-        label->raise();
-        label->setVisible(m_showLabels);
-    }
-    
+
     this->show();
     this->raise();
-    
+
     // Set focus to receive keyboard events immediately
     this->setFocus();
-    
-    // Also grab keyboard focus when clicked anywhere on the piano
-    this->setFocusPolicy(Qt::StrongFocus);
-    for (auto key : m_whiteKeys) {
-        key->setFocusProxy(this);
-    }
-    for (auto key : m_blackKeys) {
-        key->setFocusProxy(this);
-    }
 }
 
 /**
@@ -390,111 +701,98 @@ void PianoWidget::reset() {
     // Reset keyboard input flag
     m_isKeyboardInput = false;
 
-    // Release all pressed white keys
-    for (auto key : m_whiteKeys) {
-        if (key->isDown()) {
-            key->setDown(false);
-            key->update();
-            int index = m_whiteKeys.indexOf(key);
-            if (index >= 0) {
-                const int whiteKeyNotes[] = {60, 62, 64, 65, 67, 69, 71, 72};
-                int noteNumber = whiteKeyNotes[index];
-                emit keyReleased(noteNumber);
-            }
-        }
-    }
-
-    // Release all pressed black keys
-    for (auto key : m_blackKeys) {
-        if (key->isDown()) {
-            key->setDown(false);
-            key->update();
-            int index = m_blackKeys.indexOf(key);
-            if (index >= 0) {
-                const int blackKeyNotes[] = {61, 63, 66, 68, 70};
-                int noteNumber = blackKeyNotes[index];
-                emit keyReleased(noteNumber);
-            }
-        }
-    }
+    // Release all pressed keys and stop a prompt that is playing
+    releaseAllNotes();
+    m_promptPlayer->cancel();
 
     // Reset label toggle state if needed
     if (m_labelToggleButton && m_labelToggleButton->isChecked()) {
         m_labelToggleButton->setChecked(false);
         m_showLabels = false;
-        updateKeyLabelsVisibility();
+        update();
     }
 }
 
 /**
- * @brief Handles white key press events
- * @details Processes white key clicks and emits corresponding MIDI note events.
+ * @brief Presses the key under the mouse
+ * @param event The mouse event
  */
-void PianoWidget::onWhiteKeyPressed() {
+void PianoWidget::mousePressEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+    }
+
     // This is a mouse click event
     m_isKeyboardInput = false;
-    QPushButton* key = qobject_cast<QPushButton*>(sender());
-    if (key && m_keyboard) {
-        int index = m_whiteKeys.indexOf(key);
-        if (index >= 0) {
-            const int whiteKeyNotes[] = {60, 62, 64, 65, 67, 69, 71, 72};
-            int noteNumber = whiteKeyNotes[index];
-            if (!currentlyPressedKeys.contains(noteNumber)) {
-                m_keyboard->playNote(noteNumber);
-                emit keyPressed(noteNumber);
-                currentlyPressedKeys.insert(noteNumber);
-            }
-        }
+    setFocus();
+    m_mouseNote = noteAt(event->position().toPoint());
+    pressNote(m_mouseNote);
+}
+
+/**
+ * @brief Tracks hover and slides the pressed note to the key under the mouse
+ * @param event The mouse event
+ */
+void PianoWidget::mouseMoveEvent(QMouseEvent* event) {
+    int note = noteAt(event->position().toPoint());
+    if (note != m_hoverNote) {
+        updateKey(m_hoverNote);
+        m_hoverNote = note;
+        updateKey(m_hoverNote);
+    }
+
+    // Dragging across the keys plays each key in turn
+    if ((event->buttons() & Qt::LeftButton) && note != m_mouseNote) {
+        releaseNote(m_mouseNote);
+        m_mouseNote = note;
+        pressNote(m_mouseNote);
     }
 }
 
 /**
- * @brief Handles black key press events
- * @details Processes black key clicks and emits corresponding MIDI note events.
+ * @brief Releases the key pressed with the mouse
+ * @param event The mouse event
  */
-void PianoWidget::onBlackKeyPressed() {
-    // This is a mouse click event
-    m_isKeyboardInput = false;
-    QPushButton* key = qobject_cast<QPushButton*>(sender());
-    if (key && m_keyboard) {
-        int index = m_blackKeys.indexOf(key);
-        if (index >= 0) {
-            const int blackKeyNotes[] = {61, 63, 66, 68, 70};
-            int noteNumber = blackKeyNotes[index];
-            if (!currentlyPressedKeys.contains(noteNumber)) {
-                m_keyboard->playNote(noteNumber);
-                emit keyPressed(noteNumber);
-                currentlyPressedKeys.insert(noteNumber);
-            }
-        }
+void PianoWidget::mouseReleaseEvent(QMouseEvent* event) {
+    if (event->button() != Qt::LeftButton) {
+        QWidget::mouseReleaseEvent(event);
+        return;
     }
+    releaseNote(m_mouseNote);
+    m_mouseNote = -1;
 }
 
 /**
- * @brief Handles key release events
- * @details Processes key releases and emits corresponding MIDI note-off events.
+ * @brief Clears the hover state when the mouse leaves the widget
+ * @param event The leave event
  */
-void PianoWidget::onKeyReleased() {
-    QPushButton* key = qobject_cast<QPushButton*>(sender());
-    if (key && m_keyboard) {
-        int noteNumber = -1;
-        
-        if (m_whiteKeys.contains(key)) {
-            int index = m_whiteKeys.indexOf(key);
-            const int whiteKeyNotes[] = {60, 62, 64, 65, 67, 69, 71, 72};
-            noteNumber = whiteKeyNotes[index];
-        } else if (m_blackKeys.contains(key)) {
-            int index = m_blackKeys.indexOf(key);
-            const int blackKeyNotes[] = {61, 63, 66, 68, 70};
-            noteNumber = blackKeyNotes[index];
-        }
-        
-        if (noteNumber != -1 && currentlyPressedKeys.contains(noteNumber)) {
-            m_keyboard->stopNote(noteNumber);
-            emit keyReleased(noteNumber);
-            currentlyPressedKeys.remove(noteNumber);
+void PianoWidget::leaveEvent(QEvent* event) {
+    updateKey(m_hoverNote);
+    m_hoverNote = -1;
+    QWidget::leaveEvent(event);
+}
+
+/**
+ * @brief Scrolls the keys, or zooms them with Ctrl held
+ * @param event The wheel event
+ * @details One notch of a standard wheel (120 units) scrolls by one white key
+ *          or zooms by one key; touchpad deltas are accumulated until they add
+ *          up to a notch.
+ */
+void PianoWidget::wheelEvent(QWheelEvent* event) {
+    const QPoint delta = event->angleDelta();
+    m_wheelRemainder += std::abs(delta.x()) > std::abs(delta.y()) ? delta.x() : delta.y();
+    const int steps = m_wheelRemainder / 120;
+    m_wheelRemainder %= 120;
+    if (steps != 0) {
+        if (event->modifiers() & Qt::ControlModifier) {
+            setVisibleWhiteKeys(m_visibleWhiteKeys - steps);
+        } else if (m_visibleWhiteKeys < m_whiteKeyIndexes.size()) {
+            setScroll(m_scrollKeys - steps);
         }
     }
+    event->accept();
 }
 
 /**
@@ -509,38 +807,10 @@ void PianoWidget::keyPressEvent(QKeyEvent* event) {
     }
 
     m_isKeyboardInput = true;  // Mark that we're handling keyboard input
-    
+
     // Check if this key maps to a piano key
-    if (m_keyToButton.contains(event->key())) {
-        QPushButton* button = m_keyToButton[event->key()];
-        if (button) {
-            // Set the button's visual state
-            button->setDown(true);
-            button->update();
-            
-            // Determine which note to play
-            int noteNumber = -1;
-            if (m_whiteKeys.contains(button)) {
-                int index = m_whiteKeys.indexOf(button);
-                if (index >= 0) {
-                    const int whiteKeyNotes[] = {60, 62, 64, 65, 67, 69, 71, 72};
-                    noteNumber = whiteKeyNotes[index];
-                }
-            } else {
-                int index = m_blackKeys.indexOf(button);
-                if (index >= 0) {
-                    const int blackKeyNotes[] = {61, 63, 66, 68, 70};
-                    noteNumber = blackKeyNotes[index];
-                }
-            }
-            
-            // If we found a valid note and it's not already playing, play it
-            if (noteNumber != -1 && !currentlyPressedKeys.contains(noteNumber)) {
-                currentlyPressedKeys.insert(noteNumber);
-                m_keyboard->playNote(noteNumber);
-                emit keyPressed(noteNumber);
-            }
-        }
+    if (const KeyBinding* binding = bindingForKey(event->key())) {
+        pressNote(binding->note);
     }
 }
 
@@ -556,33 +826,12 @@ void PianoWidget::keyReleaseEvent(QKeyEvent* event) {
     }
 
     // Check if this key maps to a piano key
-    if (m_keyToButton.contains(event->key())) {
-        QPushButton* button = m_keyToButton[event->key()];
-        if (button) {
-            button->setDown(false);
-            button->update();
-            
-            int noteNumber = -1;
-            if (m_whiteKeys.contains(button)) {
-                int index = m_whiteKeys.indexOf(button);
-                const int whiteKeyNotes[] = {60, 62, 64, 65, 67, 69, 71, 72};
-                noteNumber = whiteKeyNotes[index];
-            } else if (m_blackKeys.contains(button)) {
-                int index = m_blackKeys.indexOf(button);
-                const int blackKeyNotes[] = {61, 63, 66, 68, 70};
-                noteNumber = blackKeyNotes[index];
-            }
-            
-            if (noteNumber != -1 && currentlyPressedKeys.contains(noteNumber)) {
-                m_keyboard->stopNote(noteNumber);
-                emit keyReleased(noteNumber);
-                currentlyPressedKeys.remove(noteNumber);
-            }
-        }
+    if (const KeyBinding* binding = bindingForKey(event->key())) {
+        releaseNote(binding->note);
     }
 
     // If all keys are released, reset the keyboard input flag
-    if (currentlyPressedKeys.isEmpty()) {
+    if (m_pressedNotes.none()) {
         m_isKeyboardInput = false;
     }
 }
@@ -590,6 +839,7 @@ void PianoWidget::keyReleaseEvent(QKeyEvent* event) {
 /**
  * @brief Highlights keys to indicate correct/incorrect attempt
  * @param isCorrect Whether the attempt was correct
+ * @details Starts a translucent layer over the keys that fades out over 500ms.
  */
 void PianoWidget::highlightAttempt(bool isCorrect)
 {
@@ -597,38 +847,12 @@ void PianoWidget::highlightAttempt(bool isCorrect)
         return;
     }
 
-    // Create a new label for the highlight as a child of the piano widget
-    QLabel* highlightLabel = new QLabel(this);
-    highlightLabel->setAttribute(Qt::WA_TransparentForMouseEvents);
-    highlightLabel->setGeometry(0, 0, width(), height());
-    
-    // Set the highlight color using a solid background with alpha
-    QString highlightColor = isCorrect ? 
-        "background-color: rgba(144, 238, 144, 0.5);" :  // Light green overlay (50% opacity)
-        "background-color: rgba(255, 182, 193, 0.5);";   // Light red overlay (50% opacity)
-    highlightLabel->setStyleSheet(highlightColor);
-    
-    // Show and raise the highlight label to the very top
-    highlightLabel->show();
-    highlightLabel->raise();
-    
-    // Ensure all piano keys are below the highlight
-    for (auto key : m_whiteKeys) {
-        key->stackUnder(highlightLabel);
-    }
-    for (auto key : m_blackKeys) {
-        key->stackUnder(highlightLabel);
-    }
-    for (auto label : m_whiteKeyLabels) {
-        label->stackUnder(highlightLabel);
-    }
-    for (auto label : m_blackKeyLabels) {
-        label->stackUnder(highlightLabel);
-    }
-    
-    // Make sure the toggle button stays on top
-    m_labelToggleButton->raise();
+    m_highlightColor = isCorrect ?
+        QColor(144, 238, 144) :  // Light green overlay
+        QColor(255, 182, 193);   // Light red overlay
 
-    // Delete the highlight label after 500ms
-    QTimer::singleShot(500, highlightLabel, &QLabel::deleteLater);
-} 
+    m_highlightAnimation->stop();
+    m_highlightAnimation->start();
+    update();
+    KEYQUEST_TRACE_FEEDBACK();
+}
@@ -4,7 +4,7 @@
  * @brief Header file for the piano widget interface
  * @version 1.0
  * @date 2024-03-21
- * 
+ *
  * @copyright Copyright (c) 2024
  */
 
@@ -15,22 +15,68 @@
 #include <QPushButton>
 #include <QVector>
 #include <QFrame>
-#include <QLabel>
-#include <QSet>
-#include <QMap>
+#include <QColor>
+#include <QPixmap>
+#include <QRect>
+#include <QStaticText>
+#include <QVariantAnimation>
+#include <bitset>
 #include "keyboard.h"
 
+class MidiInput;
+class PerformanceRecorder;
+class PromptPlayer;
+
 /**
  * @brief Class representing a piano widget with interactive keys
- * 
+ *
  * Provides a visual and interactive piano interface with both white and black keys,
  * supporting keyboard input and visual feedback
+ *
+ * The whole keyboard is drawn by this one widget. Key rectangles are computed
+ * once per resize and mouse input is hit-tested against them directly; black
+ * keys are checked first since they lie on top. Pressed keys are kept in a
+ * bitmask indexed by MIDI note. Each key state (normal, hover, pressed, prompt) is
+ * rendered once into a cached sprite, so a repaint only blits the sprites of the
+ * keys inside the dirty region. Correct/incorrect feedback fades out as a
+ * translucent layer drawn over the keys.
+ *
+ * Key colours, positions and labels come from NoteTable. Wide ranges show a
+ * window of the keys: the mouse wheel scrolls it by one white key per step and
+ * Ctrl+wheel zooms in and out. The computer keys play the octave from the C
+ * nearest the left of the window, C4 whenever it is visible.
  */
 class PianoWidget : public QWidget {
     Q_OBJECT
     Q_PROPERTY(int currentNote READ getCurrentNote WRITE setCurrentNote)
 
 public:
+    static constexpr int DEFAULT_VISIBLE_WHITE_KEYS = 22;  ///< White keys shown at once after a range change, three octaves
+    static constexpr int MIN_VISIBLE_WHITE_KEYS = 8;       ///< Smallest number of white keys Ctrl+wheel zooms in to
+
+    /**
+     * @brief Key ranges offered in the settings
+     */
+    enum class KeyboardRange {
+        Octave,  ///< C4-C5, 13 keys
+        Keys61,  ///< C2-C7, a 61-key keyboard
+        Keys88   ///< A0-C8, a full piano
+    };
+
+    /**
+     * @brief Converts a stored range name to a range
+     * @param name "octave", "61" or "88"
+     * @return The range; Octave for unknown names
+     */
+    static KeyboardRange keyboardRangeFromString(const QString& name);
+
+    /**
+     * @brief Converts a range to the name it is stored under
+     * @param range The range
+     * @return "octave", "61" or "88"
+     */
+    static QString keyboardRangeToString(KeyboardRange range);
+
     /**
      * @brief Gets the singleton instance of the piano widget
      * @return Pointer to the PianoWidget instance
@@ -59,6 +105,75 @@ public:
      */
     void highlightAttempt(bool isCorrect);
 
+    /**
+     * @brief Sets the range of keys shown
+     * @param firstNote MIDI note of the lowest key; moved down to a white key if needed
+     * @param lastNote MIDI note of the highest key; moved up to a white key if needed
+     * @details The window is reset to DEFAULT_VISIBLE_WHITE_KEYS around middle C.
+     *          A 61-key keyboard is 36-96 and an 88-key keyboard is 21-108.
+     */
+    void setNoteRange(int firstNote, int lastNote);
+
+    /**
+     * @brief Shows one of the ranges offered in the settings
+     * @param range The range
+     */
+    void setKeyboardRange(KeyboardRange range);
+
+    /**
+     * @brief Sets how many white keys are shown at once
+     * @param count Number of white keys; clamped to MIN_VISIBLE_WHITE_KEYS and the range
+     */
+    void setVisibleWhiteKeys(int count);
+
+    /**
+     * @brief Scrolls the keyboard so that a note is in the middle of the window
+     * @param note The MIDI note; notes outside the range scroll to the nearest end
+     */
+    void scrollToNote(int note);
+
+    /**
+     * @brief Gets the synthesizer the keys play through
+     * @return Pointer to the Keyboard
+     */
+    Keyboard* keyboard() const { return m_keyboard; }
+
+    /**
+     * @brief Gets the player of question prompts
+     * @return The player; the keys of the notes it plays light up while they sound
+     */
+    PromptPlayer* promptPlayer() const { return m_promptPlayer; }
+
+    /**
+     * @brief Gets the recorder of performances
+     * @return The recorder of the notes played on m_keyboard
+     */
+    PerformanceRecorder* recorder() const { return m_recorder; }
+
+    /**
+     * @brief Gets the input from external MIDI keyboards
+     * @return The input; its notes sound without passing through this widget
+     */
+    MidiInput* midiInput() const { return m_midiInput; }
+
+    /**
+     * @brief Gets the memory the piano's drawing holds
+     * @return Bytes of the key sprites and key geometry
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief Gets the white key at the left edge of the window
+     * @return Its NoteTable::NoteInfo::whiteIndex
+     */
+    int firstVisibleWhiteIndex() const;
+
+    /**
+     * @brief Gets the width of a white key relative to the widget
+     * @return The key width divided by the widget width, 0 before the first layout
+     */
+    double whiteKeyWidthShare() const { return width() > 0 ? double(m_whiteKeyWidth) / width() : 0.0; }
+
     // Property accessors
     int getCurrentNote() const { return m_currentNote; }
     void setCurrentNote(int note) { m_currentNote = note; }
@@ -76,6 +191,48 @@ protected:
      */
     void keyReleaseEvent(QKeyEvent* event) override;
 
+    /**
+     * @brief Draws the keys inside the dirty region and the highlight layer
+     * @param event The paint event
+     */
+    void paintEvent(QPaintEvent* event) override;
+
+    /**
+     * @brief Recomputes the key geometry and sprites for the new size
+     * @param event The resize event
+     */
+    void resizeEvent(QResizeEvent* event) override;
+
+    /**
+     * @brief Presses the key under the mouse
+     * @param event The mouse event
+     */
+    void mousePressEvent(QMouseEvent* event) override;
+
+    /**
+     * @brief Tracks hover and slides the pressed note to the key under the mouse
+     * @param event The mouse event
+     */
+    void mouseMoveEvent(QMouseEvent* event) override;
+
+    /**
+     * @brief Releases the key pressed with the mouse
+     * @param event The mouse event
+     */
+    void mouseReleaseEvent(QMouseEvent* event) override;
+
+    /**
+     * @brief Clears the hover state when the mouse leaves the widget
+     * @param event The leave event
+     */
+    void leaveEvent(QEvent* event) override;
+
+    /**
+     * @brief Scrolls the keys, or zooms them with Ctrl held
+     * @param event The wheel event
+     */
+    void wheelEvent(QWheelEvent* event) override;
+
 private:
     /**
      * @brief Constructs a new PianoWidget
@@ -83,81 +240,154 @@ private:
      */
     explicit PianoWidget(QWidget* parent = nullptr);
 
+    /**
+     * @brief Geometry and label of one key
+     */
+    struct PianoKey {
+        int note = 0;            ///< MIDI note of the key
+        bool black = false;      ///< Whether the key is a black key
+        QRect rect;              ///< Key rectangle in widget coordinates
+        QRect labelRect;         ///< Area the note names are drawn in
+        QStaticText label;       ///< Note names of the key, one per line
+    };
+
+    /**
+     * @brief Piano key bound to a computer key
+     */
+    struct KeyBinding {
+        qint16 note = -1;        ///< MIDI note, -1 if the computer key is not bound
+        qint16 keyIndex = -1;    ///< Index into m_keys, -1 if the note is not shown
+    };
+
+    /// Qt key codes below this value (ASCII) are looked up directly in m_keyBindings
+    static constexpr int KEY_BINDING_COUNT = 128;
+
+    /// Visual state of a key, used to index the sprite cache
+    enum KeyState { Normal = 0, Hover = 1, Pressed = 2, Prompt = 3, KeyStateCount = 4 };
+
     static PianoWidget* s_instance;
-    QWidget* m_overlayWidget;  // Temporary overlay for highlighting
 
     // UI Elements
-    QVector<QPushButton*> m_whiteKeys;
-    QVector<QPushButton*> m_blackKeys;
-    QVector<QLabel*> m_whiteKeyLabels;      // Labels for white keys
-    QVector<QLabel*> m_blackKeyLabels;      // Labels for black keys
     QPushButton* m_labelToggleButton;       // Button to toggle labels
     QFrame* m_currentPlaceholder;
     Keyboard* m_keyboard;
-    QMap<int, QPushButton*> m_keyToButton;
-    QSet<int> currentlyPressedKeys;         // Track currently pressed keys
+    MidiInput* m_midiInput;                 // External MIDI keyboard, plays on m_keyboard
+    PromptPlayer* m_promptPlayer;           // Plays question prompts on m_keyboard
+    PerformanceRecorder* m_recorder;        // Records and plays back performances on m_keyboard
+    KeyBinding m_keyBindings[KEY_BINDING_COUNT]; // Computer key code to piano key
     bool m_showLabels;                      // Whether labels are currently shown
     bool m_isKeyboardInput;                 // Flag to track if current input is from keyboard
     int m_currentNote;                      // Current note being played
 
+    // Key layout
+    int m_firstNote;                        // MIDI note of the lowest key
+    int m_lastNote;                         // MIDI note of the highest key
+    QVector<PianoKey> m_keys;               // All keys, white keys first
+    int m_keyIndexByNote[128];              // Index into m_keys for every MIDI note, -1 if not shown
+    QVector<int> m_whiteKeyIndexes;         // m_keys index of every white key, left to right
+    int m_visibleWhiteKeys;                 // Number of white keys in the window
+    int m_scrollKeys;                       // White keys scrolled off to the left
+    int m_wheelRemainder;                   // Wheel delta not yet turned into a step
+    int m_whiteKeyWidth;                    // Width of a white key in pixels
+    int m_blackKeyBottom;                   // Bottom edge of the black keys
+
+    // Input state
+    std::bitset<128> m_pressedNotes;        // Notes currently held down
+    std::bitset<128> m_promptNotes;         // Notes of the prompt currently sounding
+    int m_mouseNote;                        // Note held with the mouse, -1 if none
+    int m_hoverNote;                        // Note under the mouse, -1 if none
+
+    // Rendering
+    QPixmap m_whiteSprites[KeyStateCount];  // Cached white key images per state
+    QPixmap m_blackSprites[KeyStateCount];  // Cached black key images per state
+    QVariantAnimation* m_highlightAnimation; // Fades the highlight layer out
+    QColor m_highlightColor;                // Colour of the current highlight
+
     // Setup methods
     /**
-     * @brief Initializes the piano widget
+     * @brief Sets up keyboard mapping for key events
      */
-    void initializePiano();
+    void setupKeyboardMapping();
 
     /**
-     * @brief Sets up the piano keys
-     * @param container The container widget for the keys
+     * @brief Looks up the piano key bound to a computer key
+     * @param key Qt key code
+     * @return The binding, or nullptr if the key is unbound or its note is not shown
      */
-    void setupKeys(QWidget* container);
+    const KeyBinding* bindingForKey(int key) const;
 
     /**
-     * @brief Applies styles to the piano keys
+     * @brief Builds the list of keys for the current note range
      */
-    void applyKeyStyles();
+    void buildKeys();
 
     /**
-     * @brief Connects key signals to their respective slots
+     * @brief Scrolls the window to a white key
+     * @param scrollKeys White keys to the left of the window; clamped to the range
      */
-    void connectKeySignals();
+    void setScroll(int scrollKeys);
 
     /**
-     * @brief Sets up keyboard mapping for key events
+     * @brief Releases every pressed key
      */
-    void setupKeyboardMapping();
+    void releaseAllNotes();
 
     /**
-     * @brief Sets up labels for the piano keys
+     * @brief Computes the key and label rectangles for the current size
      */
-    void setupKeyLabels();                  // New method to setup key labels
+    void layoutKeys();
 
     /**
-     * @brief Updates the visibility of key labels
+     * @brief Renders the key sprites for the current key size and pixel ratio
      */
-    void updateKeyLabelsVisibility();       // New method to update label visibility
+    void renderSprites();
 
-private Q_SLOTS:
     /**
-     * @brief Handles white key press events
+     * @brief Finds the key at a position
+     * @param pos Position in widget coordinates
+     * @return The MIDI note of the key, or -1 if there is no key
      */
-    void onWhiteKeyPressed();
+    int noteAt(const QPoint& pos) const;
 
     /**
-     * @brief Handles black key press events
+     * @brief Presses a key, plays its note and emits notePlayed and keyPressed
+     * @param note The MIDI note
      */
-    void onBlackKeyPressed();
+    void pressNote(int note);
 
     /**
-     * @brief Handles key release events
+     * @brief Releases a key, stops its note and emits keyReleased
+     * @param note The MIDI note
+     */
+    void releaseNote(int note);
+
+    /**
+     * @brief Schedules a repaint of one key
+     * @param note The MIDI note of the key
      */
-    void onKeyReleased();
+    void updateKey(int note);
 
+private Q_SLOTS:
     /**
      * @brief Toggles the visibility of key labels
      */
     void onToggleLabels();                 // New slot for toggle button
 
+    /**
+     * @brief Presses a key played on an external MIDI keyboard
+     * @param note The MIDI note
+     * @param velocity Note-on velocity (1-127)
+     * @param time When the key went down, stamped by MidiInput on the MIDI thread
+     * @details The note is already sounding; MidiInput sent it to the synthesizer.
+     */
+    void externalNoteOn(int note, int velocity, qint64 time);
+
+    /**
+     * @brief Releases a key played on an external MIDI keyboard
+     * @param note The MIDI note
+     */
+    void externalNoteOff(int note);
+
 Q_SIGNALS:
     /**
      * @brief Emitted when a key is pressed
@@ -165,11 +395,28 @@ Q_SIGNALS:
      */
     void keyPressed(int noteIndex);
 
+    /**
+     * @brief Emitted with the exact time of a key press, just before keyPressed
+     * @param note The MIDI note
+     * @param velocity Note-on velocity (1-127)
+     * @param time When the key went down, from MidiEventQueue::now()
+     * @details For timing-sensitive listeners such as the rhythm lesson. The time
+     *          of a MIDI keyboard's note is stamped on arrival on the MIDI thread,
+     *          so the queued hop to the GUI thread does not add to it.
+     */
+    void notePlayed(int note, int velocity, qint64 time);
+
     /**
      * @brief Emitted when a key is released
      * @param noteIndex The index of the released note
      */
     void keyReleased(int noteIndex);
+
+    /**
+     * @brief Emitted when the window of keys has been laid out again
+     * @details After a resize, a scroll, a zoom or a range change.
+     */
+    void keyWindowChanged();
 };
 
-#endif // PIANOWIDGET_H 
\ No newline at end of file
+#endif // PIANOWIDGET_H
@@ -0,0 +1,188 @@
+/**
+ * @file promptplayer.cpp
+ * @brief Implementation of the PromptPlayer class
+ * @author Alan Cruz
+ * @details This file implements the step-by-step scheduling of question prompts
+ *          on the keyboard's sequencer and the cues that light the piano keys.
+ */
+
+#include "promptplayer.h"
+#include "keyboard.h"
+#include "midieventqueue.h"
+#include <algorithm>
+#include <QDebug>
+#include <QTimer>
+
+/**
+ * @brief Creates a player
+ * @param keyboard Keyboard the prompts play on
+ * @param parent Parent object
+ */
+PromptPlayer::PromptPlayer(Keyboard* keyboard, QObject* parent)
+    : QObject(parent)
+    , m_keyboard(keyboard)
+    , m_timer(new QTimer(this))
+    , m_bpm(DEFAULT_BPM)
+    , m_sequence(0)
+    , m_steps(0)
+    , m_nextStep(0)
+    , m_nextNote(0)
+    , m_nextStepTime(0)
+    , m_latency(0)
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &PromptPlayer::advance);
+}
+
+/**
+ * @brief Plays a prompt, cancelling the one that is playing
+ * @param prompt The notes to play
+ * @details The output latency is read once per prompt, so the keys light up
+ *          when the notes are heard rather than when they are rendered. All
+ *          notes are announced with notePlanned() before the first one is due.
+ */
+void PromptPlayer::play(QuestionBank::PromptRange prompt)
+{
+    cancel();
+    if (!m_keyboard || prompt.isEmpty()) {
+        return;
+    }
+
+    m_notes.assign(prompt.begin(), prompt.end());
+    m_steps = m_notes.back().step + 1;
+    m_nextStep = 0;
+    m_nextNote = 0;
+    m_latency = static_cast<qint64>(m_keyboard->outputLatencyMs() * 1e6);
+    m_nextStepTime = MidiEventQueue::now() + qint64(START_DELAY_MS) * 1000000;
+    m_sequence = m_keyboard->beginSequence(Keyboard::PROMPT_CHANNEL);
+    qDebug() << "PromptPlayer: Playing" << m_notes.size() << "notes in" << m_steps << "steps at" << m_bpm << "BPM";
+
+    qint64 stepTime = m_nextStepTime + m_latency;
+    int step = 0;
+    for (const QuestionBank::PromptNote& note : m_notes) {
+        for (; step < note.step; ++step) {
+            stepTime += stepLength(step);
+        }
+        emit notePlanned(note.note, stepTime, stepTime + static_cast<qint64>(stepLength(step) * NOTE_LENGTH));
+    }
+    advance();
+}
+
+/**
+ * @brief Cancels the prompt that is playing
+ */
+void PromptPlayer::cancel()
+{
+    if (!m_sequence) {
+        return;
+    }
+    m_timer->stop();
+    m_keyboard->cancelSequence(m_sequence);
+    m_sequence = 0;
+    m_cues.clear();
+    for (int note = 0; note < 128 && m_sounding.any(); ++note) {
+        if (m_sounding.test(note)) {
+            m_sounding.reset(note);
+            emit noteStopped(note);
+        }
+    }
+    emit cancelled();
+}
+
+/**
+ * @brief Sets the tempo
+ * @param bpm Steps per minute, clamped to MIN_BPM-MAX_BPM
+ */
+void PromptPlayer::setTempo(double bpm)
+{
+    m_bpm = std::clamp(bpm, MIN_BPM, MAX_BPM);
+}
+
+/**
+ * @brief Hands the notes of the next step to the keyboard
+ * @details Queues the start cues of the step before its end cues, which keeps
+ *          m_cues in time order since a note ends before the next step starts.
+ */
+void PromptPlayer::scheduleStep()
+{
+    const qint64 length = stepLength(m_nextStep);
+    const qint64 start = m_nextStepTime;
+    const qint64 end = start + static_cast<qint64>(length * NOTE_LENGTH);
+
+    int last = m_nextNote;
+    while (last < static_cast<int>(m_notes.size()) && m_notes[last].step == m_nextStep) {
+        m_keyboard->scheduleNote(m_sequence, m_notes[last].note, VELOCITY, start, end);
+        m_cues.push_back({start + m_latency, m_notes[last].note, m_nextStep});
+        ++last;
+    }
+    for (int i = m_nextNote; i < last; ++i) {
+        m_cues.push_back({end + m_latency, m_notes[i].note, -1});
+    }
+
+    m_nextNote = last;
+    m_nextStepTime += length;
+    ++m_nextStep;
+}
+
+/**
+ * @brief Gets the length of a step at the current tempo
+ * @param step The step
+ * @return The length in nanoseconds
+ */
+qint64 PromptPlayer::stepLength(int step) const
+{
+    const qint64 beat = static_cast<qint64>(60e9 / m_bpm);
+    return (step == m_steps - 1 ? FINAL_STEP_BEATS : 1) * beat;
+}
+
+/**
+ * @brief Schedules the steps that are due soon and emits the cues that are due
+ */
+void PromptPlayer::advance()
+{
+    if (!m_sequence) {
+        return;
+    }
+
+    const qint64 now = MidiEventQueue::now();
+    const qint64 ahead = qint64(SCHEDULE_AHEAD_MS) * 1000000;
+    while (m_nextStep < m_steps && m_nextStepTime - ahead <= now) {
+        scheduleStep();
+    }
+
+    const quint16 sequence = m_sequence;
+    int lastStep = -1;
+    while (!m_cues.empty() && m_cues.front().time <= now) {
+        const Cue cue = m_cues.front();
+        m_cues.pop_front();
+        if (cue.step >= 0) {
+            m_sounding.set(cue.note);
+            emit noteStarted(cue.note);
+            if (cue.step != lastStep) {
+                lastStep = cue.step;
+                emit stepStarted(cue.step, m_steps);
+            }
+        } else {
+            m_sounding.reset(cue.note);
+            emit noteStopped(cue.note);
+        }
+
+        // A receiver may have cancelled the prompt or started another one
+        if (m_sequence != sequence) {
+            return;
+        }
+    }
+
+    if (m_nextStep >= m_steps && m_cues.empty()) {
+        m_sequence = 0;
+        emit finished();
+        return;
+    }
+
+    qint64 next = m_cues.empty() ? m_nextStepTime - ahead : m_cues.front().time;
+    if (m_nextStep < m_steps) {
+        next = std::min(next, m_nextStepTime - ahead);
+    }
+    m_timer->start(static_cast<int>(std::max<qint64>(0, next - now) / 1000000) + 1);
+}
@@ -0,0 +1,174 @@
+/**
+ * @file promptplayer.h
+ * @brief Header file for the PromptPlayer class
+ * @author Alan Cruz
+ * @details This file defines PromptPlayer, which plays the answer of a question
+ *          back to the player on the synthesizer and reports each note as it is
+ *          heard, so the piano can light the keys in time with the sound.
+ */
+
+#ifndef PROMPTPLAYER_H
+#define PROMPTPLAYER_H
+
+#include <QObject>
+#include <bitset>
+#include <deque>
+#include <vector>
+#include "questionbank.h"
+
+class Keyboard;
+class QTimer;
+
+/**
+ * @brief Plays question prompts through the keyboard's sequencer
+ * @details A prompt is compiled with the question bank (see
+ *          QuestionBank::prompt()): notes on the same step sound together, and
+ *          each step lasts one beat, the last one FINAL_STEP_BEATS beats.
+ *
+ *          Steps are handed to Keyboard::scheduleNote() SCHEDULE_AHEAD_MS before
+ *          they are due, so the notes start on the audio clock and a busy GUI
+ *          thread cannot make them uneven. Scheduling a step at a time keeps
+ *          tempo changes cheap: setTempo() applies from the next step that has
+ *          not been scheduled. cancel() silences the prompt at once.
+ *
+ *          noteStarted() and noteStopped() are emitted when a note is heard, i.e.
+ *          its scheduled time plus the output latency, from the same timer.
+ *          notePlanned() announces every note of a prompt up front, for displays
+ *          that show notes before they sound.
+ */
+class PromptPlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr double DEFAULT_BPM = 100.0;  ///< Tempo prompts start at
+    static constexpr double MIN_BPM = 30.0;       ///< Slowest accepted tempo
+    static constexpr double MAX_BPM = 240.0;      ///< Fastest accepted tempo
+
+    /**
+     * @brief Creates a player
+     * @param keyboard Keyboard the prompts play on
+     * @param parent Parent object
+     */
+    explicit PromptPlayer(Keyboard* keyboard, QObject* parent = nullptr);
+
+    /**
+     * @brief Plays a prompt, cancelling the one that is playing
+     * @param prompt The notes to play; copied, so the bank may be reloaded meanwhile
+     */
+    void play(QuestionBank::PromptRange prompt);
+
+    /**
+     * @brief Cancels the prompt that is playing
+     * @details Lit keys are reported as stopped; finished() is not emitted.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks whether a prompt is playing
+     * @return true from play() until finished() or cancel()
+     */
+    bool isPlaying() const { return m_sequence != 0; }
+
+    /**
+     * @brief Sets the tempo
+     * @param bpm Steps per minute, clamped to MIN_BPM-MAX_BPM
+     * @details A prompt that is playing changes tempo from its next unscheduled step.
+     */
+    void setTempo(double bpm);
+
+    /**
+     * @brief Gets the tempo
+     * @return Steps per minute
+     */
+    double tempo() const { return m_bpm; }
+
+signals:
+    /**
+     * @brief Emitted when a note of the prompt is heard
+     * @param note The MIDI note
+     */
+    void noteStarted(int note);
+
+    /**
+     * @brief Emitted when a note of the prompt ends
+     * @param note The MIDI note
+     */
+    void noteStopped(int note);
+
+    /**
+     * @brief Emitted when a step of the prompt is heard
+     * @param step The step, counted from 0
+     * @param steps Number of steps of the prompt
+     */
+    void stepStarted(int step, int steps);
+
+    /**
+     * @brief Emitted when the last note of the prompt has ended
+     */
+    void finished();
+
+    /**
+     * @brief Emitted by play() for every note of the prompt
+     * @param note The MIDI note
+     * @param start When the note will be heard, from MidiEventQueue::now()
+     * @param end When it will end
+     * @details The times assume the tempo stays as it is.
+     */
+    void notePlanned(int note, qint64 start, qint64 end);
+
+    /**
+     * @brief Emitted when a prompt is cancelled before it finished
+     * @details Notes announced with notePlanned() that have not ended will not sound.
+     */
+    void cancelled();
+
+private:
+    static const int START_DELAY_MS = 150;      // Time from play() to the first note
+    static const int SCHEDULE_AHEAD_MS = 250;   // How early a step is handed to the keyboard
+    static const int FINAL_STEP_BEATS = 2;      // Length of the last step, so a chord can ring
+    static const int VELOCITY = 90;             // Velocity of prompt notes
+    static constexpr double NOTE_LENGTH = 0.9;  // Part of its step a note sounds
+
+    /**
+     * @brief A note start or end, at the time it is heard
+     */
+    struct Cue {
+        qint64 time = 0;    ///< When it is heard, from MidiEventQueue::now()
+        int note = 0;       ///< MIDI note
+        int step = -1;      ///< Step a note start begins, -1 for a note end
+    };
+
+    /**
+     * @brief Schedules the steps that are due soon and emits the cues that are due
+     * @details Restarts the timer for the next of the two.
+     */
+    void advance();
+
+    /**
+     * @brief Hands the notes of the next step to the keyboard
+     */
+    void scheduleStep();
+
+    /**
+     * @brief Gets the length of a step at the current tempo
+     * @param step The step
+     * @return The length in nanoseconds
+     */
+    qint64 stepLength(int step) const;
+
+    Keyboard* m_keyboard;                          // Plays the notes
+    QTimer* m_timer;                               // Wakes advance() at the next deadline
+    std::vector<QuestionBank::PromptNote> m_notes; // Notes of the prompt in step order
+    std::deque<Cue> m_cues;                        // Scheduled cues in time order
+    std::bitset<128> m_sounding;                   // Notes reported started and not yet stopped
+    double m_bpm;                                  // Tempo
+    quint16 m_sequence;                            // Keyboard sequence of the prompt, 0 if none
+    int m_steps;                                   // Number of steps of the prompt
+    int m_nextStep;                                // First step not scheduled yet
+    int m_nextNote;                                // Index of the first note not scheduled yet
+    qint64 m_nextStepTime;                         // When m_nextStep starts
+    qint64 m_latency;                              // Output latency in nanoseconds
+};
+
+#endif // PROMPTPLAYER_H
@@ -0,0 +1,397 @@
+/**
+ * @file qtable.cpp
+ * @brief Implementation of the QTable class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file implements the flat Q-table used by the adaptive quiz engine,
+ *          including the per-state maximum cache and conversion to and from the
+ *          data.json representation.
+ */
+
+#include "qtable.h"
+#include <algorithm>
+#include <cstring>
+#include <QDebug>
+
+/// Question IDs are dense; anything outside this range is rejected
+static const int MAX_QUESTION_ID = 1 << 20;
+
+/// Identifies the binary form of a table
+static const char QTABLE_MAGIC[4] = {'K', 'Q', 'Q', 'T'};
+
+/// Version of the binary form; bumped whenever its layout changes
+static const quint16 QTABLE_VERSION = 1;
+
+/**
+ * @brief Header of the binary form of a table
+ */
+struct QTableHeader {
+    char magic[4];        ///< QTABLE_MAGIC
+    quint16 version;      ///< QTABLE_VERSION
+    quint16 stateCount;   ///< QTable::STATE_COUNT
+    quint32 actionCount;  ///< Number of slots
+};
+
+/**
+ * @brief Default constructor
+ */
+QTable::QTable()
+{
+    std::fill(std::begin(m_rowMax), std::end(m_rowMax), 0.0f);
+    std::fill(std::begin(m_rowArgMax), std::end(m_rowArgMax), -1);
+}
+
+/**
+ * @brief Packs a skill state into a row index
+ * @param state The skill state; each level is clamped to 0-2
+ * @return Row index in the range [0, STATE_COUNT)
+ */
+int QTable::stateIndex(const State& state)
+{
+    int notes = std::clamp(state.notes, 0, LEVEL_COUNT - 1);
+    int chords = std::clamp(state.chords, 0, LEVEL_COUNT - 1);
+    int scales = std::clamp(state.scales, 0, LEVEL_COUNT - 1);
+    return (notes * LEVEL_COUNT + chords) * LEVEL_COUNT + scales;
+}
+
+/**
+ * @brief Unpacks a row index into a skill state
+ * @param index Row index in the range [0, STATE_COUNT)
+ * @return The skill state of that row
+ */
+State QTable::stateAt(int index)
+{
+    State state;
+    state.notes = index / (LEVEL_COUNT * LEVEL_COUNT);
+    state.chords = (index / LEVEL_COUNT) % LEVEL_COUNT;
+    state.scales = index % LEVEL_COUNT;
+    return state;
+}
+
+/**
+ * @brief Adds slots for questions that do not have one yet
+ * @param questionIDs IDs of the questions to add
+ */
+void QTable::addActions(const std::vector<int>& questionIDs)
+{
+    int oldCount = actionCount();
+    for (int questionID : questionIDs) {
+        if (questionID < 0 || questionID >= MAX_QUESTION_ID) {
+            qDebug() << "QTable: Ignoring out of range question ID" << questionID;
+            continue;
+        }
+        if (questionID >= static_cast<int>(m_slotByID.size())) {
+            m_slotByID.resize(questionID + 1, -1);
+        }
+        if (m_slotByID[questionID] == -1) {
+            m_slotByID[questionID] = static_cast<int>(m_questionIDs.size());
+            m_questionIDs.push_back(questionID);
+        }
+    }
+
+    int newCount = actionCount();
+    if (newCount == oldCount) {
+        return;
+    }
+
+    // Re-lay the rows with the wider stride; new slots start at 0
+    std::vector<float> values(static_cast<size_t>(STATE_COUNT) * newCount, 0.0f);
+    for (int row = 0; row < STATE_COUNT; ++row) {
+        std::copy_n(m_values.begin() + static_cast<size_t>(row) * oldCount, oldCount,
+                    values.begin() + static_cast<size_t>(row) * newCount);
+    }
+    m_values.swap(values);
+
+    for (int row = 0; row < STATE_COUNT; ++row) {
+        refreshRowMax(row);
+    }
+}
+
+/**
+ * @brief Gets the number of question slots
+ * @return The number of columns of the table
+ */
+int QTable::actionCount() const
+{
+    return static_cast<int>(m_questionIDs.size());
+}
+
+/**
+ * @brief Gets the question ID stored in a slot
+ * @param slot Slot index in the range [0, actionCount())
+ * @return The question ID of the slot
+ */
+int QTable::questionIDAt(int slot) const
+{
+    return m_questionIDs[slot];
+}
+
+/**
+ * @brief Gets the slot of a question
+ * @param questionID The question ID
+ * @return The slot index, or -1 if the question has no slot
+ */
+int QTable::slotOf(int questionID) const
+{
+    if (questionID < 0 || questionID >= static_cast<int>(m_slotByID.size())) {
+        return -1;
+    }
+    return m_slotByID[questionID];
+}
+
+/**
+ * @brief Gets a Q-value
+ * @param state The skill state
+ * @param questionID The question ID (action)
+ * @return The stored Q-value, or 0 if none is stored
+ */
+float QTable::value(const State& state, int questionID) const
+{
+    int slot = slotOf(questionID);
+    if (slot < 0) {
+        return 0.0f;
+    }
+    return m_values[static_cast<size_t>(stateIndex(state)) * actionCount() + slot];
+}
+
+/**
+ * @brief Gets all Q-values of a state
+ * @param state The skill state
+ * @return The state's row, actionCount() values indexed by slot
+ */
+const float* QTable::row(const State& state) const
+{
+    return m_values.data() + static_cast<size_t>(stateIndex(state)) * actionCount();
+}
+
+/**
+ * @brief Stores a Q-value
+ * @param state The skill state
+ * @param questionID The question ID (action); a slot is added if needed
+ * @param value The new Q-value
+ */
+void QTable::setValue(const State& state, int questionID, float value)
+{
+    int slot = slotOf(questionID);
+    if (slot < 0) {
+        addActions({questionID});
+        slot = slotOf(questionID);
+        if (slot < 0) {
+            return;
+        }
+    }
+
+    int row = stateIndex(state);
+    m_values[static_cast<size_t>(row) * actionCount() + slot] = value;
+
+    if (m_rowArgMax[row] == -1 || value > m_rowMax[row]) {
+        m_rowMax[row] = value;
+        m_rowArgMax[row] = slot;
+    } else if (slot == m_rowArgMax[row] && value < m_rowMax[row]) {
+        // The previous maximum went down, so another slot may hold it now
+        refreshRowMax(row);
+    }
+}
+
+/**
+ * @brief Gets the best Q-value of a state
+ * @param state The skill state
+ * @return The largest stored value of the state, or 0 if no value is larger
+ */
+float QTable::maxValue(const State& state) const
+{
+    return std::max(0.0f, m_rowMax[stateIndex(state)]);
+}
+
+/**
+ * @brief Picks the candidate with the highest Q-value
+ * @param state The skill state
+ * @param candidates Question IDs to choose from
+ * @return The first candidate with the highest value, or -1 if there are none
+ */
+int QTable::bestAction(const State& state, const std::vector<int>& candidates) const
+{
+    if (candidates.empty()) {
+        return -1;
+    }
+
+    const float* row = m_values.data() + static_cast<size_t>(stateIndex(state)) * actionCount();
+    int bestQID = candidates[0];
+    float bestValue = -1e9f;
+    for (int questionID : candidates) {
+        int slot = slotOf(questionID);
+        float q = slot < 0 ? 0.0f : row[slot];
+        if (q > bestValue) {
+            bestValue = q;
+            bestQID = questionID;
+        }
+    }
+    return bestQID;
+}
+
+/**
+ * @brief Checks whether any value is stored
+ * @return true if every value of the table is 0
+ */
+bool QTable::isEmpty() const
+{
+    return std::all_of(m_values.begin(), m_values.end(), [](float q) { return q == 0.0f; });
+}
+
+/**
+ * @brief Gets the memory held by the table
+ * @return Bytes used by the table object and its arrays, counting reserved capacity
+ */
+std::size_t QTable::memoryUsage() const
+{
+    return sizeof(*this)
+        + m_values.capacity() * sizeof(float)
+        + m_questionIDs.capacity() * sizeof(int)
+        + m_slotByID.capacity() * sizeof(int);
+}
+
+/**
+ * @brief Rescans a row to find its maximum
+ * @param stateRow Row index
+ */
+void QTable::refreshRowMax(int stateRow)
+{
+    int count = actionCount();
+    if (count == 0) {
+        m_rowMax[stateRow] = 0.0f;
+        m_rowArgMax[stateRow] = -1;
+        return;
+    }
+
+    const float* row = m_values.data() + static_cast<size_t>(stateRow) * count;
+    const float* best = std::max_element(row, row + count);
+    m_rowMax[stateRow] = *best;
+    m_rowArgMax[stateRow] = static_cast<int>(best - row);
+}
+
+/**
+ * @brief Builds a table from its data.json representation
+ * @param table Object mapping "[notes,chords,scales]" keys to objects of "[questionID]": value
+ * @return The parsed table
+ */
+QTable QTable::fromJson(const QJsonObject& table)
+{
+    QTable qTable;
+
+    // Collect every question ID first so the rows are laid out only once
+    std::vector<int> questionIDs;
+    for (auto stateIt = table.begin(); stateIt != table.end(); ++stateIt) {
+        QJsonObject actionMap = stateIt.value().toObject();
+        for (auto actionIt = actionMap.begin(); actionIt != actionMap.end(); ++actionIt) {
+            // Parse the question ID from the action key (format: "[id]")
+            QString actionKey = actionIt.key();
+            questionIDs.push_back(actionKey.mid(1, actionKey.length() - 2).toInt());
+        }
+    }
+    std::sort(questionIDs.begin(), questionIDs.end());
+    questionIDs.erase(std::unique(questionIDs.begin(), questionIDs.end()), questionIDs.end());
+    qTable.addActions(questionIDs);
+
+    for (auto stateIt = table.begin(); stateIt != table.end(); ++stateIt) {
+        if (!stateIt.value().isObject()) {
+            continue;
+        }
+        State state = State::fromKey(stateIt.key());
+        QJsonObject actionMap = stateIt.value().toObject();
+        for (auto actionIt = actionMap.begin(); actionIt != actionMap.end(); ++actionIt) {
+            QString actionKey = actionIt.key();
+            int questionID = actionKey.mid(1, actionKey.length() - 2).toInt();
+            qTable.setValue(state, questionID, static_cast<float>(actionIt.value().toDouble()));
+        }
+    }
+
+    return qTable;
+}
+
+/**
+ * @brief Converts the table to its data.json representation
+ * @return Object mapping "[notes,chords,scales]" keys to objects of "[questionID]": value
+ */
+QJsonObject QTable::toJson() const
+{
+    QJsonObject table;
+    int count = actionCount();
+    for (int row = 0; row < STATE_COUNT; ++row) {
+        QJsonObject actionObj;
+        const float* values = m_values.data() + static_cast<size_t>(row) * count;
+        for (int slot = 0; slot < count; ++slot) {
+            if (values[slot] != 0.0f) {
+                actionObj[QString("[%1]").arg(m_questionIDs[slot])] = values[slot];
+            }
+        }
+        if (!actionObj.isEmpty()) {
+            table[stateAt(row).toKey()] = actionObj;
+        }
+    }
+    return table;
+}
+
+/**
+ * @brief Builds a table from its binary form
+ * @param data Bytes produced by toBinary()
+ * @return The parsed table, empty if the data is not a table of this version
+ */
+QTable QTable::fromBinary(const QByteArray& data)
+{
+    QTable qTable;
+    QTableHeader header;
+    if (data.size() < qsizetype(sizeof(header))) {
+        qDebug() << "QTable: Binary table is too short";
+        return qTable;
+    }
+    std::memcpy(&header, data.constData(), sizeof(header));
+    if (std::memcmp(header.magic, QTABLE_MAGIC, sizeof(QTABLE_MAGIC)) != 0
+            || header.version != QTABLE_VERSION || header.stateCount != STATE_COUNT) {
+        qDebug() << "QTable: Not a binary table of version" << QTABLE_VERSION;
+        return qTable;
+    }
+
+    const qsizetype count = header.actionCount;
+    const qsizetype expected = qsizetype(sizeof(header)) + count * qsizetype(sizeof(int))
+                               + qsizetype(STATE_COUNT) * count * qsizetype(sizeof(float));
+    if (count > MAX_QUESTION_ID || data.size() != expected) {
+        qDebug() << "QTable: Binary table has the wrong size";
+        return qTable;
+    }
+
+    const char* cursor = data.constData() + sizeof(header);
+    std::vector<int> questionIDs(count);
+    std::memcpy(questionIDs.data(), cursor, count * sizeof(int));
+    cursor += count * sizeof(int);
+
+    // Duplicate or out of range IDs would shift the slots
+    qTable.addActions(questionIDs);
+    if (qTable.actionCount() != count) {
+        qDebug() << "QTable: Binary table has invalid question IDs";
+        return QTable();
+    }
+    std::memcpy(qTable.m_values.data(), cursor, qTable.m_values.size() * sizeof(float));
+    for (int row = 0; row < STATE_COUNT; ++row) {
+        qTable.refreshRowMax(row);
+    }
+    return qTable;
+}
+
+/**
+ * @brief Converts the table to its binary form
+ * @return A header, the question ID of every slot and then every row of values
+ */
+QByteArray QTable::toBinary() const
+{
+    QTableHeader header;
+    std::memcpy(header.magic, QTABLE_MAGIC, sizeof(QTABLE_MAGIC));
+    header.version = QTABLE_VERSION;
+    header.stateCount = STATE_COUNT;
+    header.actionCount = static_cast<quint32>(actionCount());
+
+    QByteArray data;
+    data.reserve(sizeof(header) + m_questionIDs.size() * sizeof(int) + m_values.size() * sizeof(float));
+    data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    data.append(reinterpret_cast<const char*>(m_questionIDs.data()), m_questionIDs.size() * sizeof(int));
+    data.append(reinterpret_cast<const char*>(m_values.data()), m_values.size() * sizeof(float));
+    return data;
+}
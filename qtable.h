@@ -0,0 +1,188 @@
+/**
+ * @file qtable.h
+ * @brief Header file for the QTable class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file defines the QTable class, the dense Q-value store used by the
+ *          adaptive quiz engine. The skill state space is only 3x3x3, so every state
+ *          gets one contiguous row of Q-values indexed by question slot, and the best
+ *          value of each row is cached so that max(Q(s,a)) is a constant-time lookup.
+ */
+
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <QByteArray>
+#include <QJsonObject>
+#include "state.h"
+
+/**
+ * @brief Flat Q-table indexed by packed skill state and question slot
+ * @details Values live in a single float array with one row per skill state. Each
+ *          question ID that has been seen is given a column ("slot"); a question
+ *          without a stored value reads as 0, matching the previous map-based table.
+ *
+ *          Every row keeps its maximum value and the slot holding it. The cache is
+ *          updated on each write, and the row is only rescanned when the slot that
+ *          held the maximum decreases.
+ *
+ *          The table is stored in data.json in the same form as before:
+ *          "[notes,chords,scales]" -> { "[questionID]": value }. The binary form of
+ *          toBinary() holds the rows as they are in memory; it is the form of the
+ *          prior table shipped for new players (see bench/qtrainer.cpp).
+ */
+class QTable {
+public:
+    static constexpr int LEVEL_COUNT = 3;   ///< Skill levels per domain (0-2)
+    static constexpr int STATE_COUNT = LEVEL_COUNT * LEVEL_COUNT * LEVEL_COUNT;  ///< Number of skill states
+
+    /**
+     * @brief Default constructor
+     * @details Creates an empty table without any question slots.
+     */
+    QTable();
+
+    /**
+     * @brief Packs a skill state into a row index
+     * @param state The skill state; each level is clamped to 0-2
+     * @return Row index in the range [0, STATE_COUNT)
+     */
+    static int stateIndex(const State& state);
+
+    /**
+     * @brief Unpacks a row index into a skill state
+     * @param index Row index in the range [0, STATE_COUNT)
+     * @return The skill state of that row
+     */
+    static State stateAt(int index);
+
+    /**
+     * @brief Adds slots for questions that do not have one yet
+     * @param questionIDs IDs of the questions to add
+     * @details Existing values are kept. Reserving all known questions up front
+     *          avoids growing the table while a quiz is running.
+     */
+    void addActions(const std::vector<int>& questionIDs);
+
+    /**
+     * @brief Gets the number of question slots
+     * @return The number of columns of the table
+     */
+    int actionCount() const;
+
+    /**
+     * @brief Gets the question ID stored in a slot
+     * @param slot Slot index in the range [0, actionCount())
+     * @return The question ID of the slot
+     */
+    int questionIDAt(int slot) const;
+
+    /**
+     * @brief Gets the slot of a question
+     * @param questionID The question ID
+     * @return The slot index, or -1 if the question has no slot
+     */
+    int slotOf(int questionID) const;
+
+    /**
+     * @brief Gets a Q-value
+     * @param state The skill state
+     * @param questionID The question ID (action)
+     * @return The stored Q-value, or 0 if none is stored
+     */
+    float value(const State& state, int questionID) const;
+
+    /**
+     * @brief Gets all Q-values of a state
+     * @param state The skill state
+     * @return The state's row, actionCount() values indexed by slot
+     * @details The pointer is valid until a slot is added.
+     */
+    const float* row(const State& state) const;
+
+    /**
+     * @brief Stores a Q-value
+     * @param state The skill state
+     * @param questionID The question ID (action); a slot is added if needed
+     * @param value The new Q-value
+     */
+    void setValue(const State& state, int questionID, float value);
+
+    /**
+     * @brief Gets the best Q-value of a state
+     * @param state The skill state
+     * @return The largest stored value of the state, or 0 if no value is larger
+     * @details Constant time; reads the cached row maximum.
+     */
+    float maxValue(const State& state) const;
+
+    /**
+     * @brief Picks the candidate with the highest Q-value
+     * @param state The skill state
+     * @param candidates Question IDs to choose from
+     * @return The first candidate with the highest value, or -1 if there are none
+     * @details Candidates without a slot read as 0.
+     */
+    int bestAction(const State& state, const std::vector<int>& candidates) const;
+
+    /**
+     * @brief Checks whether any value is stored
+     * @return true if every value of the table is 0
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Gets the memory held by the table
+     * @return Bytes used by the table object and its arrays, counting reserved capacity
+     */
+    std::size_t memoryUsage() const;
+
+    /**
+     * @brief Builds a table from its data.json representation
+     * @param table Object mapping "[notes,chords,scales]" keys to objects of "[questionID]": value
+     * @return The parsed table
+     */
+    static QTable fromJson(const QJsonObject& table);
+
+    /**
+     * @brief Converts the table to its data.json representation
+     * @return Object mapping "[notes,chords,scales]" keys to objects of "[questionID]": value
+     * @details Values that are exactly 0 are left out, since they read as 0 anyway.
+     */
+    QJsonObject toJson() const;
+
+    /**
+     * @brief Builds a table from its binary form
+     * @param data Bytes produced by toBinary()
+     * @return The parsed table, empty if the data is not a table of this version
+     */
+    static QTable fromBinary(const QByteArray& data);
+
+    /**
+     * @brief Converts the table to its binary form
+     * @return A header, the question ID of every slot and then every row of values
+     * @details Values are stored in the byte order of the machine, like the quiz history.
+     */
+    QByteArray toBinary() const;
+
+private:
+    /**
+     * @brief Rescans a row to find its maximum
+     * @param stateRow Row index
+     */
+    void refreshRowMax(int stateRow);
+
+    /// Q-values, STATE_COUNT rows of actionCount() values each
+    std::vector<float> m_values;
+
+    /// Question ID of every slot
+    std::vector<int> m_questionIDs;
+
+    /// Slot of every question ID, -1 where the ID has no slot; indexed by ID
+    std::vector<int> m_slotByID;
+
+    /// Cached maximum value of every row
+    float m_rowMax[STATE_COUNT];
+
+    /// Slot holding the cached maximum of every row, -1 for an empty row
+    int m_rowArgMax[STATE_COUNT];
+};
@@ -4,11 +4,15 @@
  * @author Alan Cruz, Sarah Lahourpour
  * @details This file implements the Question class methods, including
  *          constructors, getters, setters, and JSON serialization functions.
+ *          Text fields are interned in the StringPool by the setters.
  */
 
 #include "question.h"
 #include <QJsonObject>
 
+// Hot fields plus four string IDs; keep the record small when adding fields
+static_assert(sizeof(Question) <= 24, "Question record grew");
+
 /**
  * @brief Parameterized constructor for Question
  * @param qid Question ID
@@ -21,12 +25,12 @@
  */
 Question::Question(int qid, int tid, const QString& qTitle, const QString& desc, const QString expecIn, int diff, const QString& tname)
     : questionID(qid), 
-    topicID(tid), 
-    title(qTitle),
-    description(desc), 
-    expectedInput(expecIn),
-    difficulty(diff), 
-    topicName(tname) {}
+    topicID(static_cast<qint16>(tid)), 
+    difficulty(static_cast<qint8>(diff)),
+    title(StringPool::instance()->intern(qTitle)),
+    description(StringPool::instance()->intern(desc)), 
+    expectedInput(StringPool::instance()->intern(expecIn)),
+    topicName(StringPool::instance()->intern(tname)) {}
 
 /**
  * @brief JSON constructor for Question
@@ -49,7 +53,7 @@ void Question::setQuestionID(int id) {
  * @param id The new topic ID
  */
 void Question::setTopicID(int id) {
-    topicID = id;
+    topicID = static_cast<qint16>(id);
 }
 
 /**
@@ -57,7 +61,7 @@ void Question::setTopicID(int id) {
  * @param desc The new description
  */
 void Question::setDescription(const QString& desc) {
-    description = desc;
+    description = StringPool::instance()->intern(desc);
 }
 
 /**
@@ -65,7 +69,7 @@ void Question::setDescription(const QString& desc) {
  * @param qTitle The new title
  */
 void Question::setTitle(const QString& qTitle) {
-    title = qTitle;
+    title = StringPool::instance()->intern(qTitle);
 }
 
 /**
@@ -73,7 +77,7 @@ void Question::setTitle(const QString& qTitle) {
  * @param expecIn The new expected input
  */
 void Question::setExpectedInput(const QString& expecIn){
-    expectedInput = expecIn;
+    expectedInput = StringPool::instance()->intern(expecIn);
 }
 
 /**
@@ -81,7 +85,7 @@ void Question::setExpectedInput(const QString& expecIn){
  * @param diff The new difficulty level
  */
 void Question::setDifficulty(int diff) {
-    difficulty = diff;
+    difficulty = static_cast<qint8>(diff);
 }
 
 /**
@@ -89,7 +93,7 @@ void Question::setDifficulty(int diff) {
  * @param name The new topic name
  */
 void Question::setTopicName(const QString& name) {
-    topicName = name;
+    topicName = StringPool::instance()->intern(name);
 }
 
 /**
@@ -110,26 +114,26 @@ int Question::getTopicID() const {
 
 /**
  * @brief Gets the question description
- * @return The description as a QString
+ * @return The description as a pooled QString
  */
-QString Question::getDescription() const {
-    return description;
+const QString& Question::getDescription() const {
+    return StringPool::instance()->string(description);
 }
 
 /**
  * @brief Gets the question title
- * @return The title as a QString
+ * @return The title as a pooled QString
  */
-QString Question::getTitle() const {
-    return title;
+const QString& Question::getTitle() const {
+    return StringPool::instance()->string(title);
 }
 
 /**
  * @brief Gets the expected input/answer
- * @return The expected input as a QString
+ * @return The expected input as a pooled QString
  */
-QString Question::getExpectedInput() const {
-    return expectedInput;
+const QString& Question::getExpectedInput() const {
+    return StringPool::instance()->string(expectedInput);
 }
 
 /**
@@ -142,10 +146,10 @@ int Question::getDifficulty() const {
 
 /**
  * @brief Gets the topic name
- * @return The topic name as a QString
+ * @return The topic name as a pooled QString
  */
-QString Question::getTopicName() const {
-    return topicName;
+const QString& Question::getTopicName() const {
+    return StringPool::instance()->string(topicName);
 }
 
 /**
@@ -156,11 +160,11 @@ QJsonObject Question::toJson() const {
     QJsonObject json;
     json["questionID"] = questionID;
     json["topicID"] = topicID;
-    json["Description"] = description;
-    json["ExpectedInput"] = expectedInput;
-    json["Title"] = title;
+    json["Description"] = getDescription();
+    json["ExpectedInput"] = getExpectedInput();
+    json["Title"] = getTitle();
     json["difficulty"] = difficulty;
-    json["topicName"] = topicName;
+    json["topicName"] = getTopicName();
     return json;
 }
 
@@ -169,11 +173,11 @@ QJsonObject Question::toJson() const {
  * @param json QJsonObject containing question data
  */
 void Question::fromJson(const QJsonObject &json) {
-    if (json.contains("questionID")) questionID = json["questionID"].toInt();
-    if (json.contains("topicID")) topicID = json["topicID"].toInt();
-    if (json.contains("Description")) description = json["Description"].toString();
-    if (json.contains("ExpectedInput")) expectedInput = json["ExpectedInput"].toString();
-    if (json.contains("Title")) title = json["Title"].toString();
-    if (json.contains("difficulty")) difficulty = json["difficulty"].toInt();
-    if (json.contains("topicName")) topicName = json["topicName"].toString();
+    if (json.contains("questionID")) setQuestionID(json["questionID"].toInt());
+    if (json.contains("topicID")) setTopicID(json["topicID"].toInt());
+    if (json.contains("Description")) setDescription(json["Description"].toString());
+    if (json.contains("ExpectedInput")) setExpectedInput(json["ExpectedInput"].toString());
+    if (json.contains("Title")) setTitle(json["Title"].toString());
+    if (json.contains("difficulty")) setDifficulty(json["difficulty"].toInt());
+    if (json.contains("topicName")) setTopicName(json["topicName"].toString());
 }
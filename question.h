@@ -6,6 +6,7 @@
  *          questions in the KeyQuest application. Each question contains
  *          metadata such as topic, difficulty, expected input, and descriptive
  *          text, and provides serialization to/from JSON for persistence.
+ *          The text of a question lives in the shared StringPool.
  */
 
 #ifndef QUESTION_H
@@ -14,6 +15,8 @@
 #include <string>
 #include <QJsonObject>
 #include <QString>
+#include <QtGlobal>
+#include "stringpool.h"
 
 /**
  * @brief Class representing a question in the adaptive quiz system
@@ -25,16 +28,22 @@
  *          Questions are primarily categorized by topic (notes, chords, scales)
  *          and difficulty level, which is used by the adaptive quiz engine to
  *          select appropriate questions based on the user's current skill level.
+ *
+ *          The record is kept small so that scanning the question bank stays cheap:
+ *          the fields used for selection are stored inline, while the title,
+ *          description, expected input and topic name are interned in the
+ *          StringPool and only referenced by ID. A topic name shared by all the
+ *          questions of a topic is therefore stored once.
  */
 class Question {
     private:
-        int questionID;       ///< Unique identifier for the question
-        int topicID;          ///< Topic identifier (101=notes, 102-103=chords, 104+=scales)
-        QString description;  ///< Detailed description or instruction for the question
-        QString expectedInput; ///< The expected input/answer in standardized format
-        QString title;        ///< Short title or summary of the question
-        int difficulty;       ///< Difficulty level (0=beginner, 1=intermediate, 2=advanced)
-        QString topicName;    ///< Human-readable name of the topic
+        qint32 questionID = 0;  ///< Unique identifier for the question
+        qint16 topicID = 0;     ///< Topic identifier (101=notes, 102-103=chords, 104+=scales)
+        qint8 difficulty = 0;   ///< Difficulty level (0=beginner, 1=intermediate, 2=advanced)
+        StringPool::Id title = StringPool::EMPTY;          ///< Short title or summary of the question
+        StringPool::Id description = StringPool::EMPTY;    ///< Detailed description or instruction for the question
+        StringPool::Id expectedInput = StringPool::EMPTY;  ///< The expected input/answer in standardized format
+        StringPool::Id topicName = StringPool::EMPTY;      ///< Human-readable name of the topic
 
     public:
         /**
@@ -121,21 +130,21 @@ class Question {
         
         /**
          * @brief Gets the question description
-         * @return The description as a QString
+         * @return The description as a pooled QString
          */
-        QString getDescription() const;
+        const QString& getDescription() const;
         
         /**
          * @brief Gets the question title
-         * @return The title as a QString
+         * @return The title as a pooled QString
          */
-        QString getTitle() const;
+        const QString& getTitle() const;
         
         /**
          * @brief Gets the expected input/answer
-         * @return The expected input as a QString
+         * @return The expected input as a pooled QString
          */
-        QString getExpectedInput() const;
+        const QString& getExpectedInput() const;
         
         /**
          * @brief Gets the difficulty level
@@ -145,9 +154,9 @@ class Question {
         
         /**
          * @brief Gets the topic name
-         * @return The topic name as a QString
+         * @return The topic name as a pooled QString
          */
-        QString getTopicName() const;
+        const QString& getTopicName() const;
 
         // JSON methods
         /**
@@ -0,0 +1,675 @@
+/**
+ * @file questionbank.cpp
+ * @brief Implementation of the QuestionBank class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file implements the shared question bank, including lazy loading
+ *          of the compiled question bank blob (with the JSON resource as fallback),
+ *          answer normalization, and construction of the topic and difficulty
+ *          indexes used for fast question lookups.
+ */
+
+#include "questionbank.h"
+#include "questionbankformat.h"
+#include "questionloader.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <QDebug>
+#include <QStringList>
+
+#ifdef KEYQUEST_HAVE_QBANK_BLOB
+// Generated from resources/questionBank.json by tools/qbank_compile.py
+extern const unsigned char questionBankBlob[];
+extern const std::size_t questionBankBlobSize;
+#endif
+
+// Record flags are handed to NoteSet::fromMasks() unchanged
+static_assert(QBANK_ANSWER_VALID == NoteSet::Valid, "Question bank flags must match NoteSet flags");
+static_assert(QBANK_ANSWER_EXACT_OCTAVE == NoteSet::ExactOctave, "Question bank flags must match NoteSet flags");
+
+// Initialize static member
+QuestionBank* QuestionBank::m_instance = nullptr;
+
+/**
+ * @brief Gets the application-wide question bank
+ * @return Pointer to the shared QuestionBank instance
+ * @details Creates the bank the first time it is requested. The compiled blob is
+ *          preferred; the JSON resource is only parsed if the blob is missing or
+ *          rejected.
+ */
+QuestionBank* QuestionBank::instance()
+{
+    if (!m_instance) {
+        m_instance = new QuestionBank();
+#ifdef KEYQUEST_HAVE_QBANK_BLOB
+        if (m_instance->loadFromBlob(questionBankBlob, static_cast<qsizetype>(questionBankBlobSize))) {
+            return m_instance;
+        }
+        qDebug() << "QuestionBank: Compiled question bank rejected, falling back to JSON";
+#endif
+        if (!m_instance->loadFromFile(":/resources/questionBank.json")) {
+            qDebug() << "QuestionBank: Failed to load questionBank.json";
+        }
+    }
+    return m_instance;
+}
+
+/**
+ * @brief Loads and indexes questions from a JSON question bank file
+ * @param filename Path to the JSON file containing questions
+ * @return true if at least one question was loaded, false otherwise
+ */
+bool QuestionBank::loadFromFile(const QString& filename)
+{
+    setQuestions(loadQuestionsFromFile(filename));
+    qDebug() << "QuestionBank: Loaded" << size() << "questions in" << m_topicIDs.size() << "topics from" << filename;
+    return !isEmpty();
+}
+
+/**
+ * @brief Reads a string from the string table of a compiled question bank
+ * @param strings Start of the string table
+ * @param stringsSize Size of the string table in bytes
+ * @param offset Byte offset of the string within the table
+ * @param ok Set to false if the string lies outside the table
+ * @return A QString referencing the UTF-16 data in place
+ */
+static QString blobString(const uchar* strings, quint32 stringsSize, quint32 offset, bool& ok)
+{
+    quint32 length = 0;
+    if (offset > stringsSize || stringsSize - offset < sizeof(length)) {
+        ok = false;
+        return QString();
+    }
+    std::memcpy(&length, strings + offset, sizeof(length));
+    if ((stringsSize - offset - sizeof(length)) / sizeof(QChar) < length) {
+        ok = false;
+        return QString();
+    }
+    return QString::fromRawData(reinterpret_cast<const QChar*>(strings + offset + sizeof(length)),
+                                static_cast<qsizetype>(length));
+}
+
+/**
+ * @brief Loads questions from a compiled question bank blob
+ * @param data Pointer to the blob produced by tools/qbank_compile.py
+ * @param size Size of the blob in bytes
+ * @return true if the blob was valid and at least one question was loaded
+ * @details Records are already grouped by topic and the answers are already
+ *          normalized, so this only checks the layout and wraps the records.
+ */
+bool QuestionBank::loadFromBlob(const uchar* data, qsizetype size)
+{
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    // The blob is written little-endian and read in place
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    return false;
+#else
+    QuestionBankBlobHeader header;
+    if (!data || size < static_cast<qsizetype>(sizeof(header))
+            || reinterpret_cast<quintptr>(data) % alignof(QuestionBankBlobRecord) != 0) {
+        qDebug() << "QuestionBank: Compiled question bank is truncated or misaligned";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, QBANK_BLOB_MAGIC, sizeof(header.magic)) != 0
+            || header.version != QBANK_BLOB_VERSION
+            || header.headerSize != sizeof(header)) {
+        qDebug() << "QuestionBank: Compiled question bank has an unsupported format version";
+        return false;
+    }
+
+    const quint64 blobSize = static_cast<quint64>(size);
+    if (header.recordsOffset % alignof(QuestionBankBlobRecord) != 0
+            || header.topicsOffset % alignof(QuestionBankBlobTopic) != 0
+            || header.stringsOffset % alignof(quint32) != 0
+            || header.recordsOffset + quint64(header.questionCount) * sizeof(QuestionBankBlobRecord) > blobSize
+            || header.topicsOffset + quint64(header.topicCount) * sizeof(QuestionBankBlobTopic) > blobSize
+            || header.stringsOffset + quint64(header.stringsSize) > blobSize
+            || header.promptsOffset + quint64(header.promptNoteCount) * sizeof(QuestionBankBlobPromptNote) > blobSize) {
+        qDebug() << "QuestionBank: Compiled question bank sections are out of bounds";
+        return false;
+    }
+
+    const auto* records = reinterpret_cast<const QuestionBankBlobRecord*>(data + header.recordsOffset);
+    const auto* topics = reinterpret_cast<const QuestionBankBlobTopic*>(data + header.topicsOffset);
+    const uchar* strings = data + header.stringsOffset;
+
+    static_assert(sizeof(PromptNote) == sizeof(QuestionBankBlobPromptNote), "PromptNote must match the blob");
+    std::vector<PromptNote> promptNotes(header.promptNoteCount);
+    if (!promptNotes.empty()) {
+        std::memcpy(promptNotes.data(), data + header.promptsOffset, promptNotes.size() * sizeof(PromptNote));
+    }
+
+    std::vector<Question> questions;
+    std::vector<AnswerKey> answers;
+    questions.reserve(header.questionCount);
+    answers.reserve(header.questionCount);
+    bool ok = true;
+
+    for (quint32 t = 0; t < header.topicCount && ok; ++t) {
+        const QuestionBankBlobTopic& topic = topics[t];
+        if (topic.firstRecord != questions.size()
+                || topic.recordCount > header.questionCount - topic.firstRecord) {
+            ok = false;
+            break;
+        }
+        QString topicName = blobString(strings, header.stringsSize, topic.topicName, ok);
+
+        for (quint32 r = topic.firstRecord; r < topic.firstRecord + topic.recordCount && ok; ++r) {
+            const QuestionBankBlobRecord& record = records[r];
+            questions.emplace_back(record.questionID, record.topicID,
+                                   blobString(strings, header.stringsSize, record.title, ok),
+                                   blobString(strings, header.stringsSize, record.description, ok),
+                                   blobString(strings, header.stringsSize, record.expectedInput, ok),
+                                   record.difficulty, topicName);
+
+            AnswerKey answer;
+            answer.normalizedInput = blobString(strings, header.stringsSize, record.normalizedInput, ok);
+            answer.notes = NoteSet::fromMasks(record.pitchClassMask, record.midiMask[0],
+                                              record.midiMask[1], record.flags);
+            answer.promptFirst = record.promptFirst;
+            answer.promptCount = record.promptCount;
+            ok = ok && quint32(record.promptFirst) + record.promptCount <= header.promptNoteCount;
+            answers.push_back(answer);
+        }
+    }
+
+    if (!ok || questions.size() != header.questionCount) {
+        qDebug() << "QuestionBank: Compiled question bank records are inconsistent";
+        return false;
+    }
+
+    m_questions = std::move(questions);
+    m_answers = std::move(answers);
+    m_promptNotes = std::move(promptNotes);
+    buildIndexes();
+    qDebug() << "QuestionBank: Loaded" << size() << "compiled questions in" << m_topicIDs.size() << "topics";
+    return !isEmpty();
+#endif
+}
+
+/**
+ * @brief Replaces the contents of the bank and rebuilds all indexes
+ * @param questionBank Map of question IDs to Question objects
+ * @details The questions are grouped by topic with a stable sort, so they keep
+ *          their ID order within a topic, and their answer keys are computed.
+ */
+void QuestionBank::setQuestions(const std::map<int, Question>& questionBank)
+{
+    m_questions.clear();
+    m_questions.reserve(questionBank.size());
+    for (const auto& [qid, question] : questionBank) {
+        m_questions.push_back(question);
+    }
+
+    std::stable_sort(m_questions.begin(), m_questions.end(),
+                     [](const Question& a, const Question& b) {
+                         return a.getTopicID() < b.getTopicID();
+                     });
+
+    m_answers.clear();
+    m_answers.reserve(m_questions.size());
+    m_promptNotes.clear();
+    for (const Question& question : m_questions) {
+        m_answers.push_back(makeAnswerKey(question.getExpectedInput()));
+        appendPrompt(question, m_answers.back());
+    }
+
+    buildIndexes();
+}
+
+/**
+ * @brief Checks whether two versions of a question are the same
+ * @param a One version
+ * @param b The other version
+ * @return true if every field matches
+ */
+static bool sameQuestionContent(const Question& a, const Question& b)
+{
+    return a.getQuestionID() == b.getQuestionID() && a.getTopicID() == b.getTopicID()
+           && a.getDifficulty() == b.getDifficulty() && a.getTitle() == b.getTitle()
+           && a.getDescription() == b.getDescription() && a.getExpectedInput() == b.getExpectedInput()
+           && a.getTopicName() == b.getTopicName();
+}
+
+/**
+ * @brief Applies an edited question set, rebuilding only what changed
+ * @param questionBank Map of question IDs to Question objects, the whole new set
+ * @return The questions and topics that changed
+ * @details Every topic is compared span by span. A topic with the same questions
+ *          in the same order is edited in place; any other topic is marked for a
+ *          rebuild, and the question array is only reassembled if there is one.
+ */
+QuestionBank::Changes QuestionBank::update(const std::map<int, Question>& questionBank)
+{
+    Changes changes;
+
+    // Group the new questions by topic, in ID order like setQuestions()
+    std::map<int, std::vector<const Question*>> newTopics;
+    for (const auto& [qid, question] : questionBank) {
+        newTopics[question.getTopicID()].push_back(&question);
+    }
+
+    std::vector<int> topics = m_topicIDs;
+    for (const auto& entry : newTopics) {
+        topics.push_back(entry.first);
+    }
+    std::sort(topics.begin(), topics.end());
+    topics.erase(std::unique(topics.begin(), topics.end()), topics.end());
+
+    static const std::vector<const Question*> noQuestions;
+    std::vector<int> rebuiltTopics;
+    for (int topicID : topics) {
+        auto span = m_topicSpans.find(topicID);
+        const int first = span == m_topicSpans.end() ? 0 : span->second.first;
+        const int count = span == m_topicSpans.end() ? 0 : span->second.second - first;
+        auto incoming = newTopics.find(topicID);
+        const std::vector<const Question*>& edited = incoming == newTopics.end() ? noQuestions : incoming->second;
+
+        bool sameLayout = count == static_cast<int>(edited.size());
+        for (int i = 0; sameLayout && i < count; ++i) {
+            sameLayout = m_questions[first + i].getQuestionID() == edited[i]->getQuestionID();
+        }
+
+        if (!sameLayout) {
+            // Questions were added, removed or moved; only those are reported
+            rebuiltTopics.push_back(topicID);
+            changes.topicIDs.push_back(topicID);
+            for (const Question* question : edited) {
+                const Question* current = this->question(question->getQuestionID());
+                if (!current || !sameQuestionContent(*current, *question)) {
+                    changes.questionIDs.push_back(question->getQuestionID());
+                }
+            }
+            for (int slot = first; slot < first + count; ++slot) {
+                if (questionBank.find(m_questions[slot].getQuestionID()) == questionBank.end()) {
+                    changes.questionIDs.push_back(m_questions[slot].getQuestionID());
+                }
+            }
+            continue;
+        }
+
+        bool difficultyChanged = false;
+        for (int i = 0; i < count; ++i) {
+            Question& current = m_questions[first + i];
+            if (sameQuestionContent(current, *edited[i])) {
+                continue;
+            }
+            difficultyChanged = difficultyChanged || current.getDifficulty() != edited[i]->getDifficulty();
+            const bool answerChanged = current.getExpectedInput() != edited[i]->getExpectedInput();
+            current = *edited[i];
+            if (answerChanged) {
+                m_answers[first + i] = makeAnswerKey(current.getExpectedInput());
+                appendPrompt(current, m_answers[first + i]);
+            }
+            changes.questionIDs.push_back(current.getQuestionID());
+        }
+        if (difficultyChanged) {
+            changes.topicIDs.push_back(topicID);
+        }
+    }
+
+    if (!rebuiltTopics.empty()) {
+        // Reassemble the array; unchanged topics keep their answer keys and prompts
+        std::vector<Question> questions;
+        std::vector<AnswerKey> answers;
+        questions.reserve(questionBank.size());
+        answers.reserve(questionBank.size());
+        for (const auto& [topicID, edited] : newTopics) {
+            if (!std::binary_search(rebuiltTopics.begin(), rebuiltTopics.end(), topicID)) {
+                const std::pair<int, int>& span = m_topicSpans[topicID];
+                questions.insert(questions.end(), m_questions.begin() + span.first, m_questions.begin() + span.second);
+                answers.insert(answers.end(), m_answers.begin() + span.first, m_answers.begin() + span.second);
+                continue;
+            }
+            for (const Question* question : edited) {
+                questions.push_back(*question);
+                auto slot = m_slotByID.find(question->getQuestionID());
+                if (slot != m_slotByID.end() && m_questions[slot->second].getTopicID() == question->getTopicID()
+                        && m_questions[slot->second].getExpectedInput() == question->getExpectedInput()) {
+                    answers.push_back(m_answers[slot->second]);
+                } else {
+                    answers.push_back(makeAnswerKey(question->getExpectedInput()));
+                    appendPrompt(*question, answers.back());
+                }
+            }
+        }
+        m_questions = std::move(questions);
+        m_answers = std::move(answers);
+        buildSpans();
+    }
+
+    // Removed topics lose their entries, since their span is gone
+    for (int topicID : changes.topicIDs) {
+        buildTopicIndex(topicID);
+    }
+    compactPrompts();
+
+    std::sort(changes.questionIDs.begin(), changes.questionIDs.end());
+    changes.questionIDs.erase(std::unique(changes.questionIDs.begin(), changes.questionIDs.end()),
+                              changes.questionIDs.end());
+    return changes;
+}
+
+/**
+ * @brief Computes the answer key of an expected input string
+ * @param expectedInput The expected input as authored in the question bank
+ * @return The normalized answer with its note set
+ * @details Notes are separated by '-' and a note without an octave number gets
+ *          octave 4. tools/qbank_compile.py mirrors this.
+ */
+QuestionBank::AnswerKey QuestionBank::makeAnswerKey(const QString& expectedInput)
+{
+    QStringList normalizedNotes = expectedInput.split("-");
+    for (QString& note : normalizedNotes) {
+        // Add octave 4 unless the note already has an octave number
+        if (!(note.length() > 1 && note.at(note.length()-1).isDigit())) {
+            note += "4";
+        }
+    }
+
+    AnswerKey answer;
+    answer.normalizedInput = normalizedNotes.join("-");
+    answer.notes = NoteSet::fromString(expectedInput);
+    return answer;
+}
+
+/**
+ * @brief Compiles the prompt of a question and appends it to the prompt notes
+ * @param question The question
+ * @param answer Receives the position of the prompt
+ * @details Notes that are not recognized are left out. tools/qbank_compile.py
+ *          mirrors this for the compiled bank.
+ */
+void QuestionBank::appendPrompt(const Question& question, AnswerKey& answer)
+{
+    const bool sequential = isSequentialTopic(question.getTopicID());
+    const QStringList names = question.getExpectedInput().split('-');
+    answer.promptFirst = static_cast<int>(m_promptNotes.size());
+    for (int step = 0; step < names.size() && step < 256; ++step) {
+        const int midiNote = NoteSet::noteNameToMidi(names[step]);
+        if (midiNote >= 0) {
+            m_promptNotes.push_back({static_cast<quint8>(midiNote), static_cast<quint8>(sequential ? step : 0)});
+        }
+    }
+    answer.promptCount = static_cast<int>(m_promptNotes.size()) - answer.promptFirst;
+}
+
+/**
+ * @brief Rebuilds the topic spans and lookup indexes
+ * @details Expects m_questions to be grouped by topic already.
+ */
+void QuestionBank::buildIndexes()
+{
+    m_idsByTopicDifficulty.clear();
+    buildSpans();
+    for (int topicID : m_topicIDs) {
+        buildTopicIndex(topicID);
+    }
+}
+
+/**
+ * @brief Rebuilds the ID lookup and the topic spans
+ * @details Expects m_questions to be grouped by topic already.
+ */
+void QuestionBank::buildSpans()
+{
+    m_slotByID.clear();
+    m_topicSpans.clear();
+    m_topicIDs.clear();
+
+    for (int slot = 0; slot < static_cast<int>(m_questions.size()); ++slot) {
+        const Question& question = m_questions[slot];
+        int topicID = question.getTopicID();
+
+        m_slotByID[question.getQuestionID()] = slot;
+
+        auto span = m_topicSpans.find(topicID);
+        if (span == m_topicSpans.end()) {
+            m_topicSpans[topicID] = {slot, slot + 1};
+            m_topicIDs.push_back(topicID);
+        } else {
+            span->second.second = slot + 1;
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds the (topic ID, difficulty) entries of one topic
+ * @param topicID The ID of the topic; its span must be up to date
+ * @details The IDs keep the order of the topic's span.
+ */
+void QuestionBank::buildTopicIndex(int topicID)
+{
+    m_idsByTopicDifficulty.erase(m_idsByTopicDifficulty.lower_bound({topicID, INT_MIN}),
+                                 m_idsByTopicDifficulty.upper_bound({topicID, INT_MAX}));
+    for (const Question& question : topicQuestions(topicID)) {
+        m_idsByTopicDifficulty[{topicID, question.getDifficulty()}].push_back(question.getQuestionID());
+    }
+}
+
+/**
+ * @brief Drops the prompt notes no answer key refers to any more
+ */
+void QuestionBank::compactPrompts()
+{
+    std::size_t live = 0;
+    for (const AnswerKey& answer : m_answers) {
+        live += static_cast<std::size_t>(answer.promptCount);
+    }
+    if (m_promptNotes.size() <= 2 * live) {
+        return;
+    }
+
+    std::vector<PromptNote> promptNotes;
+    promptNotes.reserve(live);
+    for (AnswerKey& answer : m_answers) {
+        const int first = static_cast<int>(promptNotes.size());
+        promptNotes.insert(promptNotes.end(), m_promptNotes.begin() + answer.promptFirst,
+                           m_promptNotes.begin() + answer.promptFirst + answer.promptCount);
+        answer.promptFirst = first;
+    }
+    m_promptNotes = std::move(promptNotes);
+}
+
+/**
+ * @brief Checks whether the bank holds any questions
+ * @return true if the bank is empty, false otherwise
+ */
+bool QuestionBank::isEmpty() const
+{
+    return m_questions.empty();
+}
+
+/**
+ * @brief Gets the number of questions in the bank
+ * @return The question count
+ */
+int QuestionBank::size() const
+{
+    return static_cast<int>(m_questions.size());
+}
+
+/**
+ * @brief Estimates the memory the bank holds
+ * @return Bytes of its containers, including an estimate of the map nodes
+ * @details Node-based containers are counted as their elements plus one
+ *          pointer per hash node and its bucket, or three per tree node.
+ *          Question texts live in the StringPool and are not counted here.
+ */
+qint64 QuestionBank::memoryUsage() const
+{
+    constexpr qint64 pointer = sizeof(void*);
+    qint64 bytes = qint64(sizeof(QuestionBank));
+    bytes += qint64(m_questions.capacity() * sizeof(Question));
+    bytes += qint64(m_answers.capacity() * sizeof(AnswerKey));
+    bytes += qint64(m_promptNotes.capacity() * sizeof(PromptNote));
+    bytes += qint64(m_topicIDs.capacity() * sizeof(int));
+    bytes += qint64(m_slotByID.size()) * (qint64(sizeof(std::pair<const int, int>)) + pointer)
+             + qint64(m_slotByID.bucket_count()) * pointer;
+    bytes += qint64(m_topicSpans.size()) * (qint64(sizeof(std::pair<const int, std::pair<int, int>>)) + 3 * pointer);
+    for (const auto& entry : m_idsByTopicDifficulty) {
+        bytes += qint64(sizeof(entry)) + 3 * pointer + qint64(entry.second.capacity() * sizeof(int));
+    }
+    return bytes;
+}
+
+/**
+ * @brief Adds bytes to a 64-bit FNV-1a hash
+ * @param hash The hash so far
+ * @param value The value, fed least significant byte first
+ * @param bytes Number of bytes of value to feed
+ * @return The updated hash
+ */
+static quint64 fnv1a(quint64 hash, quint64 value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) {
+        hash ^= (value >> (8 * i)) & 0xFF;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief Adds a string to a 64-bit FNV-1a hash
+ * @param hash The hash so far
+ * @param text The string, fed as its length and UTF-16 code units
+ * @return The updated hash
+ */
+static quint64 fnv1a(quint64 hash, const QString& text)
+{
+    hash = fnv1a(hash, quint64(text.size()), 4);
+    for (QChar c : text) {
+        hash = fnv1a(hash, c.unicode(), 2);
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes a fingerprint of the questions
+ * @return 64-bit FNV-1a hash of the questions in bank order
+ * @details Every value is fed in a fixed byte order, so the hash does not depend
+ *          on the host's endianness.
+ */
+quint64 QuestionBank::contentHash() const
+{
+    quint64 hash = 0xCBF29CE484222325ULL;
+    for (const Question& question : m_questions) {
+        hash = fnv1a(hash, quint32(question.getQuestionID()), 4);
+        hash = fnv1a(hash, quint32(question.getTopicID()), 4);
+        hash = fnv1a(hash, quint32(question.getDifficulty()), 4);
+        hash = fnv1a(hash, question.getTitle());
+        hash = fnv1a(hash, question.getExpectedInput());
+    }
+    return hash;
+}
+
+/**
+ * @brief Looks up a question by its ID
+ * @param questionID The ID of the question
+ * @return Pointer to the question, or nullptr if the ID is unknown
+ */
+const Question* QuestionBank::question(int questionID) const
+{
+    auto it = m_slotByID.find(questionID);
+    if (it == m_slotByID.end()) {
+        return nullptr;
+    }
+    return &m_questions[it->second];
+}
+
+/**
+ * @brief Looks up the precomputed answer of a question
+ * @param questionID The ID of the question
+ * @return Pointer to the answer key, or nullptr if the ID is unknown
+ */
+const QuestionBank::AnswerKey* QuestionBank::answerKey(int questionID) const
+{
+    auto it = m_slotByID.find(questionID);
+    if (it == m_slotByID.end()) {
+        return nullptr;
+    }
+    return &m_answers[it->second];
+}
+
+/**
+ * @brief Gets the prompt of a question
+ * @param questionID The ID of the question
+ * @return The notes of the prompt in step order, empty if the ID is unknown
+ */
+QuestionBank::PromptRange QuestionBank::prompt(int questionID) const
+{
+    PromptRange range;
+    const AnswerKey* answer = answerKey(questionID);
+    if (answer && answer->promptCount > 0) {
+        range.first = m_promptNotes.data() + answer->promptFirst;
+        range.last = range.first + answer->promptCount;
+    }
+    return range;
+}
+
+/**
+ * @brief Gets all questions belonging to a topic
+ * @param topicID The ID of the topic
+ * @return Contiguous range of the topic's questions, empty if the topic is unknown
+ */
+QuestionBank::QuestionRange QuestionBank::topicQuestions(int topicID) const
+{
+    QuestionRange range;
+    auto it = m_topicSpans.find(topicID);
+    if (it != m_topicSpans.end()) {
+        range.first = m_questions.data() + it->second.first;
+        range.last = m_questions.data() + it->second.second;
+    }
+    return range;
+}
+
+/**
+ * @brief Gets the IDs of the questions of a topic at a given difficulty
+ * @param topicID The ID of the topic
+ * @param difficulty The difficulty level
+ * @return Vector of question IDs, empty if no question matches
+ */
+const std::vector<int>& QuestionBank::questionIDs(int topicID, int difficulty) const
+{
+    static const std::vector<int> noQuestions;
+    auto it = m_idsByTopicDifficulty.find({topicID, difficulty});
+    if (it == m_idsByTopicDifficulty.end()) {
+        return noQuestions;
+    }
+    return it->second;
+}
+
+/**
+ * @brief Gets the IDs of all topics in the bank
+ * @return Vector of topic IDs in ascending order
+ */
+const std::vector<int>& QuestionBank::topicIDs() const
+{
+    return m_topicIDs;
+}
+
+/**
+ * @brief Gets every question in the bank
+ * @return Vector of all questions, grouped by topic
+ */
+const std::vector<Question>& QuestionBank::questions() const
+{
+    return m_questions;
+}
+
+/**
+ * @brief Converts the bank back to a map keyed by question ID
+ * @return Map of question IDs to Question objects
+ */
+std::map<int, Question> QuestionBank::toMap() const
+{
+    std::map<int, Question> questionBank;
+    for (const Question& question : m_questions) {
+        questionBank[question.getQuestionID()] = question;
+    }
+    return questionBank;
+}
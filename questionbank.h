@@ -0,0 +1,318 @@
+/**
+ * @file questionbank.h
+ * @brief Header file for the QuestionBank class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file defines the QuestionBank class, the process-wide store of
+ *          every question in KeyQuest. The bank is parsed once and keeps
+ *          precomputed indexes so that lessons, multiplayer matches and the
+ *          adaptive quiz can look questions up without re-reading the JSON file.
+ */
+
+#pragma once
+#include <map>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <QString>
+#include <QtGlobal>
+#include "noteset.h"
+#include "question.h"
+
+/**
+ * @brief Shared, parse-once store of all questions with indexed lookups
+ * @details Questions are stored contiguously and grouped by topic, so every topic
+ *          maps to a single span of the question array. On top of that the bank
+ *          keeps two indexes:
+ *          - question ID to record
+ *          - (topic ID, difficulty) to the IDs of the matching questions
+ *
+ *          Every question also has an AnswerKey holding its expected input in
+ *          normalized form (an octave on every note) together with its NoteSet, so
+ *          games do not have to rewrite or parse answers themselves, and a prompt:
+ *          the answer as a sequence of notes to play back to the player.
+ *
+ *          The application-wide bank returned by instance() is loaded lazily the
+ *          first time it is requested, from the compiled blob linked into the
+ *          executable when available and from the question bank JSON resource
+ *          otherwise. Additional banks can be created and filled with loadFromFile(),
+ *          loadFromBlob() or setQuestions(), which is useful for tools that work on
+ *          an alternative question set.
+ *
+ *          update() applies an edited question set in place, recomputing only the
+ *          answer keys and index entries of what changed; QuestionBankWatcher uses
+ *          it to reload the bank while content is being authored.
+ */
+class QuestionBank {
+public:
+    /**
+     * @brief Lightweight view over a contiguous run of questions
+     * @details Used to iterate the questions of a single topic without copying them.
+     *          The view stays valid until the owning bank is reloaded.
+     */
+    struct QuestionRange {
+        const Question* first = nullptr;  ///< First question of the range
+        const Question* last = nullptr;   ///< One past the last question of the range
+
+        const Question* begin() const { return first; }
+        const Question* end() const { return last; }
+        int size() const { return static_cast<int>(last - first); }
+        bool isEmpty() const { return first == last; }
+    };
+
+    /**
+     * @brief Precomputed form of a question's expected answer
+     * @details Notes of normalizedInput always carry an octave number; octave 4 is
+     *          assumed for notes authored without one. notes is what played input
+     *          is checked against.
+     */
+    struct AnswerKey {
+        QString normalizedInput;  ///< Expected input with an octave on every note
+        NoteSet notes;            ///< Expected notes as pitch-class and MIDI masks
+        int promptFirst = 0;      ///< Index of the first note of the prompt in the bank
+        int promptCount = 0;      ///< Number of notes in the prompt
+    };
+
+    /**
+     * @brief One note of a question's prompt
+     * @details Notes on the same step sound together; see isSequentialTopic().
+     *          Has the layout of QuestionBankBlobPromptNote.
+     */
+    struct PromptNote {
+        quint8 note = 0;          ///< MIDI note to play
+        quint8 step = 0;          ///< Beat the note starts on, counted from 0
+    };
+
+    /**
+     * @brief Lightweight view over the notes of a prompt
+     * @details The view stays valid until the owning bank is reloaded.
+     */
+    struct PromptRange {
+        const PromptNote* first = nullptr;  ///< First note of the prompt
+        const PromptNote* last = nullptr;   ///< One past the last note of the prompt
+
+        const PromptNote* begin() const { return first; }
+        const PromptNote* end() const { return last; }
+        int size() const { return static_cast<int>(last - first); }
+        bool isEmpty() const { return first == last; }
+    };
+
+    /**
+     * @brief What update() changed in the bank
+     */
+    struct Changes {
+        std::vector<int> questionIDs;  ///< Questions added, removed or edited, in ascending order
+        std::vector<int> topicIDs;     ///< Topics whose questions or difficulties changed, in ascending order
+
+        bool isEmpty() const { return questionIDs.empty() && topicIDs.empty(); }
+    };
+
+    /**
+     * @brief Checks whether a topic's answers are played one note after another
+     * @param topicID The ID of the topic
+     * @return true for scales and melodies, false for notes, chords and intervals
+     * @details tools/qbank_compile.py mirrors this.
+     */
+    static bool isSequentialTopic(int topicID) { return topicID == 104 || topicID == 106; }
+
+    /**
+     * @brief Gets the application-wide question bank
+     * @return Pointer to the shared QuestionBank instance
+     * @details Creates the bank and loads the bundled question bank resource on
+     *          first use. Subsequent calls return the already indexed bank.
+     */
+    static QuestionBank* instance();
+
+    /**
+     * @brief Default constructor
+     * @details Creates an empty bank; use loadFromFile() or setQuestions() to fill it.
+     */
+    QuestionBank() = default;
+
+    /**
+     * @brief Loads and indexes questions from a JSON question bank file
+     * @param filename Path to the JSON file containing questions
+     * @return true if at least one question was loaded, false otherwise
+     * @details Replaces the current contents of the bank. See loadQuestionsFromFile()
+     *          for the expected file format.
+     */
+    bool loadFromFile(const QString& filename);
+
+    /**
+     * @brief Loads questions from a compiled question bank blob
+     * @param data Pointer to the blob produced by tools/qbank_compile.py
+     * @param size Size of the blob in bytes
+     * @return true if the blob was valid and at least one question was loaded
+     * @details The strings of the bank point straight into the blob and are interned
+     *          in the StringPool as they are, so the data must stay alive and unchanged
+     *          for the rest of the process. The blob is validated first; on any
+     *          mismatch the bank is left unchanged.
+     */
+    bool loadFromBlob(const uchar* data, qsizetype size);
+
+    /**
+     * @brief Replaces the contents of the bank and rebuilds all indexes
+     * @param questionBank Map of question IDs to Question objects
+     */
+    void setQuestions(const std::map<int, Question>& questionBank);
+
+    /**
+     * @brief Applies an edited question set, rebuilding only what changed
+     * @param questionBank Map of question IDs to Question objects, the whole new set
+     * @return The questions and topics that changed
+     * @details The result is the bank setQuestions() would build. Questions that
+     *          keep their topic and place are edited in place, and only an edited
+     *          answer is normalized and compiled again. A topic that gains, loses
+     *          or reorders questions is rebuilt; the slots of the following topics
+     *          shift, so the ID lookup and the topic spans are renumbered, while
+     *          the answer keys, prompts and difficulty lists of the other topics are
+     *          kept. Views returned earlier may become invalid.
+     */
+    Changes update(const std::map<int, Question>& questionBank);
+
+    /**
+     * @brief Checks whether the bank holds any questions
+     * @return true if the bank is empty, false otherwise
+     */
+    bool isEmpty() const;
+
+    /**
+     * @brief Gets the number of questions in the bank
+     * @return The question count
+     */
+    int size() const;
+
+    /**
+     * @brief Estimates the memory the bank holds
+     * @return Bytes of its containers, including an estimate of the map nodes
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief Computes a fingerprint of the questions
+     * @return 64-bit FNV-1a hash of every question's ID, topic, difficulty, title
+     *         and expected input, in bank order
+     * @details The same on every host for the same question set, whether it came
+     *          from the compiled blob or the JSON file, so online matches can check
+     *          that both players ask the same questions. Computed on every call.
+     */
+    quint64 contentHash() const;
+
+    /**
+     * @brief Looks up a question by its ID
+     * @param questionID The ID of the question
+     * @return Pointer to the question, or nullptr if the ID is unknown
+     */
+    const Question* question(int questionID) const;
+
+    /**
+     * @brief Looks up the precomputed answer of a question
+     * @param questionID The ID of the question
+     * @return Pointer to the answer key, or nullptr if the ID is unknown
+     */
+    const AnswerKey* answerKey(int questionID) const;
+
+    /**
+     * @brief Gets the prompt of a question
+     * @param questionID The ID of the question
+     * @return The notes of the prompt in step order, empty if the ID is unknown
+     */
+    PromptRange prompt(int questionID) const;
+
+    /**
+     * @brief Gets all questions belonging to a topic
+     * @param topicID The ID of the topic
+     * @return Contiguous range of the topic's questions, empty if the topic is unknown
+     */
+    QuestionRange topicQuestions(int topicID) const;
+
+    /**
+     * @brief Gets the IDs of the questions of a topic at a given difficulty
+     * @param topicID The ID of the topic
+     * @param difficulty The difficulty level (0=beginner, 1=intermediate, 2=advanced)
+     * @return Vector of question IDs, empty if no question matches
+     */
+    const std::vector<int>& questionIDs(int topicID, int difficulty) const;
+
+    /**
+     * @brief Gets the IDs of all topics in the bank
+     * @return Vector of topic IDs in ascending order
+     */
+    const std::vector<int>& topicIDs() const;
+
+    /**
+     * @brief Gets every question in the bank
+     * @return Vector of all questions, grouped by topic
+     */
+    const std::vector<Question>& questions() const;
+
+    /**
+     * @brief Converts the bank back to a map keyed by question ID
+     * @return Map of question IDs to Question objects
+     */
+    std::map<int, Question> toMap() const;
+
+private:
+    /**
+     * @brief Rebuilds the topic spans and lookup indexes
+     * @details Expects the question array to be grouped by topic already and fills
+     *          the ID, topic and (topic, difficulty) indexes from it.
+     */
+    void buildIndexes();
+
+    /**
+     * @brief Rebuilds the ID lookup and the topic spans
+     * @details Expects the question array to be grouped by topic already.
+     */
+    void buildSpans();
+
+    /**
+     * @brief Rebuilds the (topic ID, difficulty) entries of one topic
+     * @param topicID The ID of the topic; its span must be up to date
+     */
+    void buildTopicIndex(int topicID);
+
+    /**
+     * @brief Drops the prompt notes no answer key refers to any more
+     * @details update() appends the prompts of edited answers, so the old notes
+     *          are left behind; they are only copied out once they outnumber the
+     *          live ones.
+     */
+    void compactPrompts();
+
+    /**
+     * @brief Computes the answer key of an expected input string
+     * @param expectedInput The expected input as authored in the question bank
+     * @return The normalized answer with its note masks
+     */
+    static AnswerKey makeAnswerKey(const QString& expectedInput);
+
+    /**
+     * @brief Compiles the prompt of a question and appends it to the prompt notes
+     * @param question The question
+     * @param answer Receives the position of the prompt
+     */
+    void appendPrompt(const Question& question, AnswerKey& answer);
+
+    static QuestionBank* m_instance;  ///< The application-wide instance
+
+    /// All questions, grouped by topic
+    std::vector<Question> m_questions;
+
+    /// Answer keys, parallel to m_questions
+    std::vector<AnswerKey> m_answers;
+
+    /// Prompt notes of all questions, addressed by AnswerKey::promptFirst
+    std::vector<PromptNote> m_promptNotes;
+
+    /// Maps a question ID to its position in m_questions
+    std::unordered_map<int, int> m_slotByID;
+
+    /// Maps a topic ID to the [first, last) positions of its questions in m_questions
+    std::map<int, std::pair<int, int>> m_topicSpans;
+
+    /// Maps a (topic ID, difficulty) pair to the IDs of the matching questions
+    std::map<std::pair<int, int>, std::vector<int>> m_idsByTopicDifficulty;
+
+    /// IDs of all topics in ascending order
+    std::vector<int> m_topicIDs;
+};
@@ -0,0 +1,102 @@
+/**
+ * @file questionbankformat.h
+ * @brief On-disk layout of the compiled question bank
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file defines the binary layout produced by tools/qbank_compile.py
+ *          from resources/questionBank.json. The blob is linked into the executable
+ *          as read-only data and read in place by QuestionBank::loadFromBlob(), so
+ *          no JSON has to be parsed when the application starts.
+ *
+ *          Layout (all integers little-endian, every section 8-byte aligned):
+ *          - QuestionBankBlobHeader
+ *          - questionCount x QuestionBankBlobRecord, sorted by topic then question ID
+ *          - topicCount x QuestionBankBlobTopic, sorted by topic ID
+ *          - promptNoteCount x QuestionBankBlobPromptNote, the prompts of all
+ *            questions in record order
+ *          - string table: for each interned string a uint32 length in UTF-16 code
+ *            units followed by the UTF-16LE code units, padded to 4 bytes
+ *
+ *          Any change to these structures must bump QBANK_BLOB_VERSION and be
+ *          mirrored in tools/qbank_compile.py.
+ */
+
+#pragma once
+#include <cstdint>
+
+/// Magic bytes at the start of every compiled question bank
+constexpr char QBANK_BLOB_MAGIC[4] = {'K', 'Q', 'Q', 'B'};
+
+/// Version of the layout below; blobs with any other version are rejected
+constexpr uint16_t QBANK_BLOB_VERSION = 3;
+
+/// Set in QuestionBankBlobRecord::flags when every note of the answer was recognized
+constexpr uint8_t QBANK_ANSWER_VALID = 0x01;
+
+/// Set in QuestionBankBlobRecord::flags when every note of the answer was authored with an octave
+constexpr uint8_t QBANK_ANSWER_EXACT_OCTAVE = 0x02;
+
+/**
+ * @brief Fixed-size header at the start of the blob
+ */
+struct QuestionBankBlobHeader {
+    char magic[4];            ///< Always QBANK_BLOB_MAGIC
+    uint16_t version;         ///< Always QBANK_BLOB_VERSION
+    uint16_t headerSize;      ///< sizeof(QuestionBankBlobHeader)
+    uint32_t questionCount;   ///< Number of question records
+    uint32_t topicCount;      ///< Number of topic records
+    uint32_t recordsOffset;   ///< Byte offset of the first question record
+    uint32_t topicsOffset;    ///< Byte offset of the first topic record
+    uint32_t stringsOffset;   ///< Byte offset of the string table
+    uint32_t stringsSize;     ///< Size of the string table in bytes
+    uint32_t promptsOffset;   ///< Byte offset of the first prompt note
+    uint32_t promptNoteCount; ///< Number of prompt notes
+};
+
+/**
+ * @brief Fixed-size record describing one question
+ * @details String fields are byte offsets into the string table. The answer masks
+ *          are precomputed from the normalized expected input, whose notes always
+ *          carry an octave number (octave 4 is assumed when the JSON omits it).
+ *          The prompt is the answer compiled for playback, see
+ *          QuestionBankBlobPromptNote.
+ */
+struct QuestionBankBlobRecord {
+    int32_t questionID;              ///< Unique identifier for the question
+    int32_t topicID;                 ///< Topic the question belongs to
+    uint8_t difficulty;              ///< Difficulty level (0-2)
+    uint8_t flags;                   ///< QBANK_ANSWER_* flags
+    uint8_t noteCount;               ///< Number of notes in the expected input
+    uint8_t promptCount;             ///< Number of prompt notes of the question
+    uint16_t pitchClassMask;         ///< Bit n set when pitch class n (C=0) is in the answer
+    uint16_t promptFirst;            ///< Index of the question's first prompt note
+    uint32_t title;                  ///< String offset of the title
+    uint32_t description;            ///< String offset of the description
+    uint32_t expectedInput;          ///< String offset of the expected input as authored
+    uint32_t normalizedInput;        ///< String offset of the expected input with octaves
+    uint64_t midiMask[2];            ///< Bit n set when MIDI note n is in the answer
+};
+
+/**
+ * @brief Fixed-size record describing one topic
+ */
+struct QuestionBankBlobTopic {
+    int32_t topicID;        ///< Topic identifier
+    uint32_t topicName;     ///< String offset of the topic name
+    uint32_t firstRecord;   ///< Index of the topic's first question record
+    uint32_t recordCount;   ///< Number of question records in the topic
+};
+
+/**
+ * @brief One note of a question's prompt
+ * @details Notes with the same step sound together. Chords and intervals put
+ *          every note on step 0; scales and melodies put note n on step n.
+ */
+struct QuestionBankBlobPromptNote {
+    uint8_t midiNote;       ///< MIDI note to play
+    uint8_t step;           ///< Beat the note starts on, counted from 0
+};
+
+static_assert(sizeof(QuestionBankBlobHeader) == 40, "Question bank header layout changed");
+static_assert(sizeof(QuestionBankBlobRecord) == 48, "Question bank record layout changed");
+static_assert(sizeof(QuestionBankBlobTopic) == 16, "Question bank topic layout changed");
+static_assert(sizeof(QuestionBankBlobPromptNote) == 2, "Question bank prompt layout changed");
@@ -0,0 +1,124 @@
+/**
+ * @file questionbankwatcher.cpp
+ * @brief Implementation of the QuestionBankWatcher class
+ * @author Alan Cruz
+ * @details This file implements the reloading of the question bank from a
+ *          watched file while content is being authored.
+ */
+
+#include "questionbankwatcher.h"
+#include "questionloader.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+QuestionBankWatcher* QuestionBankWatcher::m_instance = nullptr;
+
+/**
+ * @brief Gets the application-wide watcher
+ * @return The watcher, created the first time it is requested
+ */
+QuestionBankWatcher* QuestionBankWatcher::instance()
+{
+    if (!m_instance) {
+        m_instance = new QuestionBankWatcher();
+    }
+    return m_instance;
+}
+
+/**
+ * @brief Creates the watcher; nothing is watched before watch()
+ */
+QuestionBankWatcher::QuestionBankWatcher()
+{
+    m_reloadTimer.setSingleShot(true);
+    m_reloadTimer.setInterval(RELOAD_DELAY_MS);
+    connect(&m_reloadTimer, &QTimer::timeout, this, &QuestionBankWatcher::reload);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &QuestionBankWatcher::handleFileChanged);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &QuestionBankWatcher::handleFileChanged);
+}
+
+/**
+ * @brief Starts watching the file named on the command line
+ * @param arguments The application's arguments
+ * @return true if "--question-bank=<file>" was given
+ */
+bool QuestionBankWatcher::watchFromArguments(const QStringList& arguments)
+{
+    static const QString flag = "--question-bank=";
+    for (const QString& argument : arguments) {
+        if (argument.startsWith(flag)) {
+            watch(argument.mid(flag.size()));
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Loads the question bank from a file and reloads it on every change
+ * @param filePath The JSON question bank file
+ * @return true if the file could be loaded
+ */
+bool QuestionBankWatcher::watch(const QString& filePath)
+{
+    if (!m_watcher.files().isEmpty()) {
+        m_watcher.removePaths(m_watcher.files());
+    }
+    if (!m_watcher.directories().isEmpty()) {
+        m_watcher.removePaths(m_watcher.directories());
+    }
+
+    QFileInfo info(filePath);
+    m_filePath = info.absoluteFilePath();
+    m_watcher.addPath(info.absolutePath());
+    if (!info.exists() || !m_watcher.addPath(m_filePath)) {
+        qDebug() << "QuestionBankWatcher: Waiting for" << m_filePath << "to be created";
+    } else {
+        qDebug() << "QuestionBankWatcher: Watching" << m_filePath;
+    }
+    return reload();
+}
+
+/**
+ * @brief Schedules a reload and watches the file again if it was replaced
+ * @details Changes to other files of the folder restart the timer as well, which
+ *          only delays the reload.
+ */
+void QuestionBankWatcher::handleFileChanged()
+{
+    if (m_filePath.isEmpty()) {
+        return;
+    }
+    if (!m_watcher.files().contains(m_filePath) && QFileInfo::exists(m_filePath)) {
+        m_watcher.addPath(m_filePath);
+    }
+    m_reloadTimer.start();
+}
+
+/**
+ * @brief Reads the watched file and applies it to the shared question bank
+ * @return true if the file held questions
+ */
+bool QuestionBankWatcher::reload()
+{
+    if (m_filePath.isEmpty()) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const std::map<int, Question> questions = loadQuestionsFromFile(m_filePath);
+    if (questions.empty()) {
+        qDebug() << "QuestionBankWatcher: No questions in" << m_filePath << "- keeping the current bank";
+        return false;
+    }
+
+    const QuestionBank::Changes changes = QuestionBank::instance()->update(questions);
+    qDebug() << "QuestionBankWatcher: Reloaded" << questions.size() << "questions in" << timer.elapsed() << "ms,"
+             << changes.questionIDs.size() << "changed in" << changes.topicIDs.size() << "reindexed topics";
+    if (!changes.isEmpty()) {
+        emit questionBankChanged(changes);
+    }
+    return true;
+}
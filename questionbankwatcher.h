@@ -0,0 +1,103 @@
+/**
+ * @file questionbankwatcher.h
+ * @brief Header file for the QuestionBankWatcher class
+ * @author Alan Cruz
+ * @details This file defines QuestionBankWatcher, the development mode that loads
+ *          the question bank from a file on disk and applies every saved edit to
+ *          the running application, so content can be authored without a rebuild.
+ */
+
+#ifndef QUESTIONBANKWATCHER_H
+#define QUESTIONBANKWATCHER_H
+
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include "questionbank.h"
+
+/**
+ * @brief Reloads the shared question bank whenever its source file is saved
+ * @details Starting KeyQuest with "--question-bank=<file>" calls watch() with the
+ *          file, usually resources/questionBank.json of the source tree. The file
+ *          is applied to QuestionBank::instance() right away and again after every
+ *          change, RELOAD_DELAY_MS after the last one so an editor that saves in
+ *          several steps is only read once.
+ *
+ *          A reload goes through QuestionBank::update(), so only the edited
+ *          questions and the topics whose questions changed are rebuilt, and
+ *          questionBankChanged() tells the running sessions; the game widgets
+ *          connect it to GameSession::handleQuestionBankChanged(). A file that
+ *          does not parse or holds no questions is reported and leaves the bank
+ *          as it was.
+ *
+ *          Editors that save by replacing the file make the watcher lose it, so the
+ *          folder is watched as well and the file is added again when it reappears.
+ */
+class QuestionBankWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int RELOAD_DELAY_MS = 100;  ///< Quiet time after a change before the file is read
+
+    /**
+     * @brief Gets the application-wide watcher
+     * @return The watcher
+     */
+    static QuestionBankWatcher* instance();
+
+    /**
+     * @brief Starts watching the file named on the command line
+     * @param arguments The application's arguments
+     * @return true if "--question-bank=<file>" was given
+     */
+    bool watchFromArguments(const QStringList& arguments);
+
+    /**
+     * @brief Loads the question bank from a file and reloads it on every change
+     * @param filePath The JSON question bank file
+     * @return true if the file could be loaded
+     */
+    bool watch(const QString& filePath);
+
+    /**
+     * @brief Gets the watched file
+     * @return Its path, empty when the bank is not being watched
+     */
+    QString filePath() const { return m_filePath; }
+
+public slots:
+    /**
+     * @brief Reads the watched file and applies it to the shared question bank
+     * @return true if the file held questions
+     */
+    bool reload();
+
+signals:
+    /**
+     * @brief Signal emitted when a reload has changed the shared question bank
+     * @param changes The questions and topics that changed
+     */
+    void questionBankChanged(const QuestionBank::Changes& changes);
+
+private slots:
+    /**
+     * @brief Schedules a reload and watches the file again if it was replaced
+     */
+    void handleFileChanged();
+
+private:
+    /**
+     * @brief Creates the watcher; nothing is watched before watch()
+     */
+    QuestionBankWatcher();
+
+    static QuestionBankWatcher* m_instance;  ///< The application-wide instance
+    QFileSystemWatcher m_watcher;            ///< Watches the file and its folder
+    QTimer m_reloadTimer;                    ///< Reloads RELOAD_DELAY_MS after the last change
+    QString m_filePath;                      ///< The watched file, empty if none
+};
+
+#endif // QUESTIONBANKWATCHER_H
@@ -0,0 +1,301 @@
+/**
+ * @file quizhistory.cpp
+ * @brief Implementation of the QuizHistory class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file implements appending quiz records with crash-safe framing
+ *          and streaming them back as sessions.
+ */
+
+#include "quizhistory.h"
+#include "qtable.h"
+#include <QByteArrayView>
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <cstring>
+
+/**
+ * @brief Computes the checksum of a record
+ * @param record The record; its checksum field is ignored
+ * @return The checksum to store in Record::checksum
+ */
+static quint16 recordChecksum(QuizHistory::Record record)
+{
+    record.checksum = 0;
+    return qChecksum(QByteArrayView(reinterpret_cast<const char*>(&record), sizeof(record)));
+}
+
+/**
+ * @brief Opens a file for reading
+ * @param filePath Path of the quiz history
+ */
+QuizHistory::Reader::Reader(const QString& filePath)
+    : m_file(filePath)
+{
+    if (!m_file.exists()) {
+        return;
+    }
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qDebug() << "QuizHistory: Failed to open quiz history for reading at:" << filePath;
+        return;
+    }
+
+    Header header;
+    if (m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header)
+            || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+            || header.version != VERSION || header.recordSize != sizeof(Record)) {
+        qDebug() << "QuizHistory: Not a quiz history of version" << VERSION << "at:" << filePath;
+        return;
+    }
+    m_valid = true;
+}
+
+/**
+ * @brief Reads the next record
+ * @param record Receives the record
+ * @return true if a record was read, false at the end of the file
+ * @details A torn record at the end of the file is shorter than a record and is
+ *          never returned.
+ */
+bool QuizHistory::Reader::next(Record& record)
+{
+    while (m_valid) {
+        if (m_chunkNext == m_chunkSize) {
+            qint64 bytes = m_file.read(reinterpret_cast<char*>(m_chunk), sizeof(m_chunk));
+            m_chunkSize = bytes > 0 ? static_cast<int>(bytes / sizeof(Record)) : 0;
+            m_chunkNext = 0;
+            if (m_chunkSize == 0) {
+                return false;
+            }
+        }
+
+        const Record& candidate = m_chunk[m_chunkNext++];
+        if (candidate.checksum == recordChecksum(candidate)) {
+            record = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads the next session
+ * @param report Receives the session
+ * @return true if a session was read, false at the end of the file
+ * @details A session ends at its SessionEnd, or at the SessionStart of the next
+ *          session if it was interrupted. That SessionStart is kept for the next call.
+ */
+bool QuizHistory::Reader::nextSession(QuizReport& report)
+{
+    report = QuizReport();
+    bool started = false;
+
+    Record record;
+    while (true) {
+        if (m_hasPending) {
+            record = m_pending;
+            m_hasPending = false;
+        } else if (!next(record)) {
+            break;
+        }
+
+        const int stateIndex = record.state & ~CORRECT_FLAG;
+        if (stateIndex >= QTable::STATE_COUNT) {
+            continue;
+        }
+
+        if (record.type == SessionStart) {
+            if (started) {
+                m_pending = record;
+                m_hasPending = true;
+                return true;
+            }
+            started = true;
+            report.seed = static_cast<quint64>(record.payload);
+            report.startState = QTable::stateAt(stateIndex);
+        } else if (!started) {
+            continue;
+        } else if (record.type == Answer) {
+            const bool correct = (record.state & CORRECT_FLAG) != 0;
+            report.history.push_back({QTable::stateAt(stateIndex), record.value, correct, record.payload});
+            ++report.totalQuestions;
+            report.correctAnswers += correct ? 1 : 0;
+        } else if (record.type == SessionEnd) {
+            report.score = static_cast<float>(record.value);
+            report.totalQuestions = static_cast<int>(static_cast<quint64>(record.payload) >> 32);
+            report.correctAnswers = static_cast<int>(record.payload & 0xffffffff);
+            report.finished = true;
+            break;
+        }
+    }
+
+    if (report.totalQuestions > 0) {
+        report.accuracy = static_cast<float>(report.correctAnswers) / report.totalQuestions * 100.0f;
+    }
+    return started;
+}
+
+/**
+ * @brief Sets the file the history is stored in
+ * @param filePath Path of the history file
+ */
+void QuizHistory::setFilePath(const QString& filePath)
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_filePath = filePath;
+    m_file.setFileName(filePath);
+}
+
+/**
+ * @brief Records the start of a quiz
+ * @param seed Seed of the session
+ * @param state Skill state the session starts from
+ * @return true if the record was written, false otherwise
+ */
+bool QuizHistory::beginSession(quint64 seed, const State& state)
+{
+    Record record;
+    record.type = SessionStart;
+    record.state = static_cast<quint8>(QTable::stateIndex(state));
+    record.payload = static_cast<qint64>(seed);
+    return append(record);
+}
+
+/**
+ * @brief Records an answer of the running quiz
+ * @param entry The answer; the current time is used if it has no timestamp
+ * @return true if the record was written, false otherwise
+ */
+bool QuizHistory::appendAnswer(const QuizReport::Entry& entry)
+{
+    Record record;
+    record.type = Answer;
+    record.state = static_cast<quint8>(QTable::stateIndex(entry.state) | (entry.correct ? CORRECT_FLAG : 0));
+    record.value = entry.questionID;
+    record.payload = entry.timestamp ? entry.timestamp : QDateTime::currentMSecsSinceEpoch();
+    return append(record);
+}
+
+/**
+ * @brief Records the end of a completed quiz
+ * @param score Final score
+ * @param totalQuestions Number of questions answered
+ * @param correctAnswers Number of correct answers
+ * @return true if the record was written, false otherwise
+ */
+bool QuizHistory::endSession(int score, int totalQuestions, int correctAnswers)
+{
+    Record record;
+    record.type = SessionEnd;
+    record.value = score;
+    record.payload = static_cast<qint64>((static_cast<quint64>(static_cast<quint32>(totalQuestions)) << 32)
+                                         | static_cast<quint32>(correctAnswers));
+    return append(record);
+}
+
+/**
+ * @brief Reads the most recent session back
+ * @return The session, or an empty report if there is none
+ */
+QuizReport QuizHistory::lastSession()
+{
+    if (m_file.isOpen()) {
+        m_file.flush();
+    }
+
+    QuizReport last;
+    QuizReport session;
+    Reader reader(m_filePath);
+    while (reader.nextSession(session)) {
+        last = std::move(session);
+    }
+    return last;
+}
+
+/**
+ * @brief Gets the size of the history file
+ * @return The size in bytes, 0 if the file does not exist
+ */
+qint64 QuizHistory::size() const
+{
+    if (m_file.isOpen()) {
+        return m_file.size();
+    }
+    return QFileInfo(m_filePath).size();
+}
+
+/**
+ * @brief Opens the file for appending, writing the header or cutting a torn tail
+ * @return true if the file is open
+ * @details A file with another header is left untouched and nothing is recorded.
+ */
+bool QuizHistory::open()
+{
+    if (m_file.isOpen()) {
+        return true;
+    }
+    if (m_filePath.isEmpty()) {
+        qDebug() << "QuizHistory: No file path set";
+        return false;
+    }
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qDebug() << "QuizHistory: Failed to open quiz history for appending at:" << m_filePath;
+        return false;
+    }
+
+    const qint64 headerSize = sizeof(Header);
+    const qint64 size = m_file.size();
+    if (size < headerSize) {
+        // New file, or one whose header was torn before any record was written
+        Header header;
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.recordSize = sizeof(Record);
+        if (!m_file.resize(0) || m_file.write(reinterpret_cast<const char*>(&header), headerSize) != headerSize) {
+            qDebug() << "QuizHistory: Failed to write the header of:" << m_filePath;
+            m_file.close();
+            return false;
+        }
+    } else {
+        Header header;
+        if (m_file.read(reinterpret_cast<char*>(&header), headerSize) != headerSize
+                || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+                || header.version != VERSION || header.recordSize != sizeof(Record)) {
+            qDebug() << "QuizHistory: Not a quiz history of version" << VERSION << "at:" << m_filePath;
+            m_file.close();
+            return false;
+        }
+
+        const qint64 whole = headerSize + (size - headerSize) / qint64(sizeof(Record)) * qint64(sizeof(Record));
+        if (whole != size) {
+            qDebug() << "QuizHistory: Dropping a torn record at the end of:" << m_filePath;
+            if (!m_file.resize(whole)) {
+                m_file.close();
+                return false;
+            }
+        }
+    }
+    return m_file.seek(m_file.size());
+}
+
+/**
+ * @brief Checksums and appends one record
+ * @param record The record; its checksum is filled in
+ * @return true if the record was written and flushed
+ */
+bool QuizHistory::append(Record record)
+{
+    if (!open()) {
+        return false;
+    }
+
+    record.checksum = recordChecksum(record);
+    if (m_file.write(reinterpret_cast<const char*>(&record), sizeof(record)) != qint64(sizeof(record))
+            || !m_file.flush()) {
+        qDebug() << "QuizHistory: Failed to append to quiz history at:" << m_filePath;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file quizhistory.h
+ * @brief Header file for the QuizHistory class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file defines QuizHistory, the append-only binary record of every
+ *          quiz answer, and its streaming reader. It replaces the quiz_report.json
+ *          that used to be rewritten at the end of every quiz.
+ */
+
+#ifndef QUIZHISTORY_H
+#define QUIZHISTORY_H
+
+#include <QFile>
+#include <QString>
+#include "quizreport.h"
+
+/**
+ * @brief Append-only record of quiz sessions and their answers
+ * @details The file starts with a Header and continues with fixed-size Records:
+ *          a SessionStart, one Answer per question as it is answered, and a
+ *          SessionEnd when the quiz is completed. Questions are stored by ID, so
+ *          a whole quiz of ten questions takes 200 bytes; the texts are looked up
+ *          in the QuestionBank when a report is shown.
+ *
+ *          Every record carries a checksum and is flushed as soon as it is
+ *          written. A crash can therefore only tear the last record, and opening
+ *          the file for appending cuts such a tail back to whole records. A
+ *          SessionStart without a SessionEnd is a quiz that was left or
+ *          interrupted; its answers are still read back.
+ *
+ *          Integers are stored in the byte order of the machine, like the Q-table
+ *          and the review schedule, so a history is not portable between
+ *          machines of different byte order.
+ */
+class QuizHistory {
+public:
+    /// Magic bytes at the start of every quiz history file
+    static constexpr char MAGIC[4] = {'K', 'Q', 'Q', 'R'};
+
+    /// Version of the layout below; files with any other version are not read
+    static constexpr quint16 VERSION = 1;
+
+    /// Set in Record::state of an Answer that was correct
+    static constexpr quint8 CORRECT_FLAG = 0x80;
+
+    /**
+     * @brief Kind of a record
+     */
+    enum RecordType : quint8 {
+        SessionStart = 1,  ///< value: 0, payload: session seed, state: starting skill state
+        Answer = 2,        ///< value: question ID, payload: time in ms since the epoch, state: skill state when asked
+        SessionEnd = 3     ///< value: final score, payload: questions << 32 | correct answers
+    };
+
+    /**
+     * @brief Fixed-size header at the start of the file
+     */
+    struct Header {
+        char magic[4];        ///< Always MAGIC
+        quint16 version;      ///< Always VERSION
+        quint16 recordSize;   ///< sizeof(Record)
+    };
+
+    /**
+     * @brief One fixed-size record
+     */
+    struct Record {
+        quint8 type = 0;      ///< RecordType
+        quint8 state = 0;     ///< Skill state packed with QTable::stateIndex(), plus CORRECT_FLAG
+        quint16 checksum = 0; ///< qChecksum() of the record with this field zeroed
+        qint32 value = 0;     ///< Meaning depends on the type
+        qint64 payload = 0;   ///< Meaning depends on the type
+    };
+
+    /**
+     * @brief Streams the records of a quiz history file
+     * @details Reads READ_CHUNK_RECORDS records at a time, so memory use does not
+     *          depend on the length of the history. Records with a bad checksum
+     *          are skipped.
+     */
+    class Reader {
+    public:
+        /**
+         * @brief Opens a file for reading
+         * @param filePath Path of the quiz history
+         */
+        explicit Reader(const QString& filePath);
+
+        /**
+         * @brief Checks whether the file was opened and has a valid header
+         * @return true if records can be read
+         */
+        bool isValid() const { return m_valid; }
+
+        /**
+         * @brief Reads the next record
+         * @param record Receives the record
+         * @return true if a record was read, false at the end of the file
+         */
+        bool next(Record& record);
+
+        /**
+         * @brief Reads the next session
+         * @param report Receives the session; QuizReport::finished is false for an interrupted one
+         * @return true if a session was read, false at the end of the file
+         * @details Answers outside of a session are skipped.
+         */
+        bool nextSession(QuizReport& report);
+
+    private:
+        static const int READ_CHUNK_RECORDS = 256;  // Records read from the file at a time
+
+        QFile m_file;                         // The history
+        Record m_chunk[READ_CHUNK_RECORDS];   // Records read but not returned yet
+        int m_chunkSize = 0;                  // Number of records in m_chunk
+        int m_chunkNext = 0;                  // Index of the next record to return
+        bool m_hasPending = false;            // Whether m_pending was read ahead by nextSession()
+        Record m_pending;                     // SessionStart that ended the previous session
+        bool m_valid = false;                 // Whether the header was valid
+    };
+
+    /**
+     * @brief Constructs a history without a file
+     * @details setFilePath() must be called before sessions can be recorded.
+     */
+    QuizHistory() = default;
+
+    /**
+     * @brief Sets the file the history is stored in
+     * @param filePath Path of the history file
+     */
+    void setFilePath(const QString& filePath);
+
+    /**
+     * @brief Gets the file the history is stored in
+     * @return The path, empty if none is set
+     */
+    const QString& filePath() const { return m_filePath; }
+
+    /**
+     * @brief Records the start of a quiz
+     * @param seed Seed of the session
+     * @param state Skill state the session starts from
+     * @return true if the record was written, false otherwise
+     */
+    bool beginSession(quint64 seed, const State& state);
+
+    /**
+     * @brief Records an answer of the running quiz
+     * @param entry The answer
+     * @return true if the record was written, false otherwise
+     */
+    bool appendAnswer(const QuizReport::Entry& entry);
+
+    /**
+     * @brief Records the end of a completed quiz
+     * @param score Final score
+     * @param totalQuestions Number of questions answered
+     * @param correctAnswers Number of correct answers
+     * @return true if the record was written, false otherwise
+     */
+    bool endSession(int score, int totalQuestions, int correctAnswers);
+
+    /**
+     * @brief Reads the most recent session back
+     * @return The session, or an empty report if there is none
+     * @details Streams the file with a Reader; only one session is held at a time.
+     */
+    QuizReport lastSession();
+
+    /**
+     * @brief Gets the size of the history file
+     * @return The size in bytes, 0 if the file does not exist
+     */
+    qint64 size() const;
+
+private:
+    /**
+     * @brief Opens the file for appending, writing the header or cutting a torn tail
+     * @return true if the file is open
+     */
+    bool open();
+
+    /**
+     * @brief Checksums and appends one record
+     * @param record The record; its checksum is filled in
+     * @return true if the record was written and flushed
+     */
+    bool append(Record record);
+
+    QString m_filePath;  ///< Path of the history file
+    QFile m_file;        ///< History file, open for appending once the first record is written
+};
+
+static_assert(sizeof(QuizHistory::Header) == 8, "QuizHistory::Header must stay 8 bytes");
+static_assert(sizeof(QuizHistory::Record) == 16, "QuizHistory::Record must stay 16 bytes");
+
+#endif // QUIZHISTORY_H
@@ -9,9 +9,13 @@
  */
 
 #include "quizwidget.h"
+#include "trace.h"
 #include "pianowidget.h"
+#include "promptplayer.h"
 #include "datamanager.h"
-#include "questionloader.h"
+#include "questionbank.h"
+#include "questionbankwatcher.h"
+#include "theme.h"
 #include "loaddatamanager.h"
 #include <QFont>
 #include <QFontDatabase>
@@ -81,10 +85,9 @@ int NewUserDialog::getScalesLevel() const { return scalesSpinBox->value(); }
 QuizWidget::QuizWidget(QWidget *parent)
     : QWidget(parent)
     , quiz(nullptr)
-    , currentQuestionId(0)
-    , chordTimer(new QTimer(this))
+    , qTableLoaded(false)
+    , chordCapture(new ChordCapture(this))
     , isProcessingSubmission(false)
-    , questionsAnswered(0)
 {
     // Reset the static flag
     resetQuizOverHandled();
@@ -97,9 +100,11 @@ QuizWidget::QuizWidget(QWidget *parent)
 
     setupUI();
     
-    // Set up chord timer
-    chordTimer->setSingleShot(true);
-    connect(chordTimer, &QTimer::timeout, this, &QuizWidget::submitChord);
+    // Submit every chord the capture groups together
+    connect(chordCapture, &ChordCapture::chordCaptured, this, &QuizWidget::submitChord);
+
+    // The Q-table and review schedule belong to the active profile
+    connect(LoadDataManager::instance(), &LoadDataManager::profileChanged, this, &QuizWidget::handleProfileChanged);
 }
 
 /**
@@ -116,9 +121,8 @@ QuizWidget::~QuizWidget()
 
 /**
  * @brief Sets up the user interface elements
- * @details Configures all UI elements including labels, fonts, and styles.
- *          Connects the piano widget to the quiz for handling user input and
- *          sets up the chord timer for collecting multi-note inputs.
+ * @details Configures all UI elements including labels, fonts, and styles. Runs
+ *          once per widget; the piano is connected by startQuiz().
  */
 void QuizWidget::setupUI()
 {
@@ -145,47 +149,30 @@ void QuizWidget::setupUI()
     // Apply fonts to labels if they exist
     if (titleLabel) {
         titleLabel->setFont(titleFont);
-        titleLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(titleLabel, Theme::TEXT);
         titleLabel->setWordWrap(true);
     }
 
     if (descriptionLabel) {
         descriptionLabel->setFont(descriptionFont);
-        descriptionLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(descriptionLabel, Theme::TEXT);
         descriptionLabel->setWordWrap(true);
     }
 
     if (scoreLabel) {
         scoreLabel->setFont(scoreFont);
-        scoreLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
+        Theme::setRole(scoreLabel, Theme::TEXT);
     }
 
     if (accuracyLabel) {
         accuracyLabel->setFont(accuracyFont);
-        accuracyLabel->setStyleSheet("QLabel { color: rgb(103, 49, 0); }");
-    }
-
-    // Ensure piano is properly attached
-    auto piano = PianoWidget::instance();
-    if (piano) {
-        // Find the piano placeholder in the parent widget
-        QFrame* pianoPlaceholder = parentWidget()->findChild<QFrame*>("lessonsPagePianoHolder");
-        if (pianoPlaceholder) {
-            piano->attachToPlaceholder(pianoPlaceholder);
-            connect(piano, &PianoWidget::keyPressed, this, &QuizWidget::handleKeyPressed);
-            connect(piano, &PianoWidget::keyReleased, this, &QuizWidget::handleKeyReleased);
-        }
+        Theme::setRole(accuracyLabel, Theme::TEXT);
     }
-
-    // Setup chord timer
-    chordTimer = new QTimer(this);
-    chordTimer->setSingleShot(true);
-    connect(chordTimer, &QTimer::timeout, this, &QuizWidget::handleChordTimeout);
 }
 
 /**
  * @brief Starts the quiz with appropriate checks and initialization
- * @details Initializes the adaptive quiz by loading questions, checking if the
+ * @details Initializes the adaptive quiz with the shared question bank, checking if the
  *          user is new, and initializing either with user-provided skill levels
  *          or previously saved state. Sets up the quiz engine with appropriate
  *          parameters and displays the first question to the user.
@@ -195,9 +182,9 @@ void QuizWidget::startQuiz()
     // Reset static flag for quiz over handling
     resetQuizOverHandled();
     
-    // 1. Load questions
-    std::map<int, Question> questionBank = loadQuestions();
-    if (questionBank.empty()) {
+    // 1. Get the shared question bank (parsed once per process)
+    const QuestionBank* questionBank = QuestionBank::instance();
+    if (questionBank->isEmpty()) {
         QMessageBox::warning(this, "Error", "Failed to load questions for the quiz.");
         return;
     }
@@ -205,7 +192,6 @@ void QuizWidget::startQuiz()
     // 2. Check if this is a new user
     bool isNewUser = LoadDataManager::instance()->isNewUser();
     State userState;
-    std::map<State, std::map<int, float>> qTable;
 
     // 3. If new user, ask for skill levels
     if (isNewUser) {
@@ -219,34 +205,106 @@ void QuizWidget::startQuiz()
         userState = LoadDataManager::instance()->getUserState();
     }
 
-    // 4. Load or create Q-table
-    qTable = LoadDataManager::instance()->getQTable();
+    // 4. Load the Q-table and the review schedule once per profile; later quizzes
+    //    keep learning in the same ones
+    if (!qTableLoaded) {
+        qTable = LoadDataManager::instance()->getQTable();
+        reviewSchedule = LoadDataManager::instance()->getReviewSchedule();
+        qTableLoaded = true;
+    }
 
-    // 5. Initialize quiz with questions, Q-table, and user state
+    // 5. Initialize the quiz with questions, Q-table, and user state, or reuse the
+    //    engine of the previous quiz
     if (quiz) {
-        delete quiz;
+        quiz->restart(userState, SessionRng::randomSeed());
+    } else {
+        quiz = new AdaptiveQuiz(*questionBank, qTable, userState, SessionRng::randomSeed(), this);
+        quiz->setQuestionLimit(NUM_QUIZ_QUESTIONS);
+        quiz->setReviewSchedule(&reviewSchedule);
+        connect(quiz, &AdaptiveQuiz::highlightKeys, PianoWidget::instance(), &PianoWidget::highlightAttempt);
+        connect(quiz, &AdaptiveQuiz::updateUI, this, &QuizWidget::updateQuizUI);
+        connect(quiz, &AdaptiveQuiz::quizOver, this, &QuizWidget::handleQuizOver);
+        connect(quiz, &AdaptiveQuiz::answerEvaluated, LoadDataManager::instance(), &LoadDataManager::recordQuizAnswer);
+        connect(QuestionBankWatcher::instance(), &QuestionBankWatcher::questionBankChanged,
+                quiz, &AdaptiveQuiz::handleQuestionBankChanged);
     }
-    quiz = new AdaptiveQuiz(questionBank, qTable, userState, this);
-    connect(quiz, &AdaptiveQuiz::highlightKeys, PianoWidget::instance(), &PianoWidget::highlightAttempt);
-    questionsAnswered = 0;
-    
-    // 6. Start the first question
-    if (!quiz) {
-        QMessageBox::warning(this, "Error", "Failed to initialize quiz.");
+    LoadDataManager::instance()->beginQuizSession(quiz->getSeed(), userState);
+    chordCapture->clear();
+    connectPiano();
+
+    // 6. Ask the first question
+    quiz->start();
+}
+
+/**
+ * @brief Stops listening to the piano
+ * @details Called when the quiz page is left. The quiz engine and the labels are
+ *          kept for the next startQuiz().
+ */
+void QuizWidget::stop()
+{
+    chordCapture->clear();
+    auto piano = PianoWidget::instance();
+    if (piano) {
+        disconnect(piano, &PianoWidget::keyPressed, this, &QuizWidget::handleKeyPressed);
+        disconnect(piano, &PianoWidget::keyReleased, this, &QuizWidget::handleKeyReleased);
+        piano->promptPlayer()->cancel();
+    }
+}
+
+/**
+ * @brief Drops the quiz state of the previous profile
+ * @details The engine borrows qTable and reviewSchedule, so it is deleted before
+ *          they are cleared. handleQuizOver() never runs for the abandoned quiz,
+ *          which would save it into the new profile.
+ */
+void QuizWidget::handleProfileChanged()
+{
+    stop();
+    delete quiz;
+    quiz = nullptr;
+    qTable = QTable();
+    reviewSchedule = ReviewSchedule();
+    qTableLoaded = false;
+}
+
+/**
+ * @brief Gets the analytics of the quizzes played on this page
+ * @return The quiz engine's scoring system, or nullptr before the first quiz
+ */
+const ScoringSystem* QuizWidget::scoring() const
+{
+    return quiz ? &quiz->getScoring() : nullptr;
+}
+
+/**
+ * @brief Gets the memory the quiz engine's own state holds
+ * @return Bytes of the Q-table and the review schedule; the question bank is
+ *         shared and counted apart
+ */
+qint64 QuizWidget::memoryUsage() const
+{
+    return static_cast<qint64>(qTable.memoryUsage() + reviewSchedule.memoryUsage());
+}
+
+/**
+ * @brief Attaches the piano to the quiz page and listens to its keys
+ * @details Connections are unique, so calling this for every quiz does not
+ *          deliver a key twice.
+ */
+void QuizWidget::connectPiano()
+{
+    auto piano = PianoWidget::instance();
+    if (!piano) {
         return;
     }
-    
-    // Get the first question
-    currentQuestionId = quiz->getNextAction();
-    Question question = quiz->getQuestion(currentQuestionId);
-    
-    // Update the UI
-    updateQuizUI(
-        quiz->getScore(),
-        question.getTitle(),
-        question.getDescription(),
-        quiz->getAccuracy()
-    );
+    // Find the piano placeholder in the parent widget
+    QFrame* pianoPlaceholder = parentWidget()->findChild<QFrame*>("lessonsPagePianoHolder");
+    if (pianoPlaceholder) {
+        piano->attachToPlaceholder(pianoPlaceholder);
+    }
+    connect(piano, &PianoWidget::keyPressed, this, &QuizWidget::handleKeyPressed, Qt::UniqueConnection);
+    connect(piano, &PianoWidget::keyReleased, this, &QuizWidget::handleKeyReleased, Qt::UniqueConnection);
 }
 
 /**
@@ -272,76 +330,28 @@ State QuizWidget::showNewUserDialog()
     };
 }
 
-/**
- * @brief Converts a MIDI note index to its corresponding note name
- * @param noteIndex The MIDI note number (60-72)
- * @return The note name as a string (e.g., "C4", "D#4")
- * @details Maps MIDI note numbers to their corresponding note names with octave
- *          information. Handles both white and black keys in the octave range
- *          from C4 to C5.
- */
-QString QuizWidget::noteIndexToName(int noteIndex)
-{
-    // MIDI note numbers to note names mapping
-    // White keys: 60, 62, 64, 65, 67, 69, 71, 72 (C4 to C5)
-    // Black keys: 61, 63, 66, 68, 70 (C#4 to A#4)
-    switch (noteIndex) {
-    case 60: return "C4";
-    case 61: return "C#4";
-    case 62: return "D4";
-    case 63: return "D#4";
-    case 64: return "E4";
-    case 65: return "F4";
-    case 66: return "F#4";
-    case 67: return "G4";
-    case 68: return "G#4";
-    case 69: return "A4";
-    case 70: return "A#4";
-    case 71: return "B4";
-    case 72: return "C5";
-    default: return QString();
-    }
-}
-
 /**
  * @brief Handles keyboard input for note playing
  * @param noteIndex The MIDI note number pressed
- * @details Processes piano key presses, converts them to note names,
- *          and adds them to the current chord collection. Manages
- *          the chord timer to collect multi-note inputs when needed.
+ * @details Passes piano key presses on to the chord capture, which groups
+ *          them into a chord.
  */
 void QuizWidget::handleKeyPressed(int noteIndex)
 {
+    KEYQUEST_TRACE_SCOPE("QuizWidget::handleKeyPressed");
     // If we're currently processing a submission, ignore new key presses
     if (isProcessingSubmission || !quiz) {
         return;
     }
 
-    // Add to currently pressed keys set
-    currentlyPressedKeys.insert(noteIndex);
-    
-    // Collect the new note
-    QString noteName = noteIndexToName(noteIndex);
-    
-    if (!noteName.isEmpty()) {
-        QString baseNote = noteName;
-        baseNote.chop(1);  // Remove the octave number
-        QString noteWithOctave = baseNote + "4";
-        
-        if (!currentChordNotes.contains(noteWithOctave)) {
-            currentChordNotes.append(noteWithOctave);
-        }
-    }
-    
-    // Restart the timer with a longer window
-    chordTimer->start(CHORD_TIMEOUT_MS);
+    chordCapture->noteOn(noteIndex);
 }
 
 /**
  * @brief Handles key release events from the piano
  * @param noteIndex The index of the released note
- * @details Processes key release events, updates the currently pressed keys set,
- *          and submits the collected chord when all keys have been released.
+ * @details Passes key releases on to the chord capture, which submits the
+ *          collected chord once all keys have been released.
  */
 void QuizWidget::handleKeyReleased(int noteIndex)
 {
@@ -350,114 +360,36 @@ void QuizWidget::handleKeyReleased(int noteIndex)
         return;
     }
     
-    // Remove from currently pressed keys set
-    currentlyPressedKeys.remove(noteIndex);
-    
-    // If all keys are released, submit the collected notes
-    if (currentlyPressedKeys.isEmpty()) {
-        isProcessingSubmission = false;
-        submitChord();
-    }
-}
-
-/**
- * @brief Handles the chord timeout event
- * @details Submits the collected chord when no new keys are pressed for the timeout period,
- *          even if not all keys have been released. This ensures the user's input
- *          is processed after a reasonable waiting period.
- */
-void QuizWidget::handleChordTimeout()
-{
-    // Only submit if there are notes to submit and we're not already processing
-    if (!currentChordNotes.isEmpty() && !isProcessingSubmission && quiz) {
-        submitChord();
-    }
+    chordCapture->noteOff(noteIndex);
 }
 
 /**
  * @brief Submits the current chord for evaluation
- * @details Normalizes the collected notes, compares them with the expected input,
- *          and sends the result to the adaptive quiz engine. Handles progression
- *          to the next question or quiz completion based on the number of questions
- *          answered.
+ * @param chord The chord captured from the piano
+ * @details Hands the collected notes to the quiz session, which compares them with
+ *          the question's expected notes by pitch class, asks the next question or
+ *          ends the quiz. A wrong answer is followed by a playback of the right one.
  */
-void QuizWidget::submitChord()
+void QuizWidget::submitChord(const NoteSet& chord)
 {
-    if (!quiz || currentChordNotes.isEmpty()) {
+    KEYQUEST_TRACE_SCOPE("QuizWidget::submitChord");
+    if (!quiz || chord.isEmpty()) {
         return;
     }
     
     isProcessingSubmission = true;
-    
-    // Get the current question
-    Question question = quiz->getQuestion(currentQuestionId);
-    
-    // Prepare the user input and expected input for comparison
-    QStringList normalizedUserNotes;
-    for (const QString& note : currentChordNotes) {
-        // Strip octave numbers from user input
-        QString baseNote = note;
-        baseNote.chop(1);  // Remove the octave number
-        normalizedUserNotes.append(baseNote);
-    }
-    
-    // Sort notes alphabetically to make order irrelevant
-    normalizedUserNotes.sort();
-    QString normalizedUserInput = normalizedUserNotes.join("-");
-    
-    // Similarly normalize the expected input
-    QStringList expectedNotes = question.getExpectedInput().split("-");
-    QStringList normalizedExpectedNotes;
-    for (const QString& note : expectedNotes) {
-        // Remove octave numbers if present
-        QString baseNote = note;
-        if (baseNote.length() > 1 && baseNote.at(baseNote.length()-1).isDigit()) {
-            baseNote.chop(1);
-        }
-        normalizedExpectedNotes.append(baseNote);
-    }
-    normalizedExpectedNotes.sort();
-    QString normalizedExpectedInput = normalizedExpectedNotes.join("-");
-    
-    // Format original input for debug display
-    QString originalUserInput;
-    if (currentChordNotes.size() > 1) {
-        originalUserInput = currentChordNotes.join("-");
-    } else {
-        originalUserInput = currentChordNotes.first();
-    }
-    
-    // Check if the answer is correct using normalized inputs
-    bool correct = (normalizedUserInput == normalizedExpectedInput);
-    
-    // Submit the answer to the quiz
-    quiz->evaluateResponse(currentQuestionId, correct);
-    
-    // No popup messages - rely on the piano's visual feedback through the highlightKeys signal
-    
-    // Increment the number of questions answered
-    questionsAnswered++;
-    
-    // Check if we've reached the end of the quiz
-    if (questionsAnswered >= NUM_QUIZ_QUESTIONS) {
-        // Quiz is complete, save data and show final results
-        handleQuizOver(quiz->getScore(), quiz->getAccuracy());
-    } else {
-        // Get the next question
-        currentQuestionId = quiz->getNextAction();
-        Question nextQuestion = quiz->getQuestion(currentQuestionId);
-        
-        // Update the UI
-        updateQuizUI(
-            quiz->getScore(),
-            nextQuestion.getTitle(),
-            nextQuestion.getDescription(),
-            quiz->getAccuracy()
-        );
+
+    // The session compares pitch classes, asks the next question and ends the
+    // quiz after NUM_QUIZ_QUESTIONS answers
+    const QuestionBank::PromptRange answer = quiz->getCurrentPrompt();
+    const bool correct = quiz->playerAttempt(chord);
+
+    // Let the player hear what a missed answer sounds like
+    auto piano = PianoWidget::instance();
+    if (!correct && piano && !quizOverHandled) {
+        piano->promptPlayer()->play(answer);
     }
-    
-    // Clear current chord notes for the next question
-    currentChordNotes.clear();
+
     isProcessingSubmission = false;
 }
 
@@ -478,8 +410,9 @@ void QuizWidget::updateQuizUI(int score, QString title, QString description, dou
         return;
     }
 
-    // Clear any existing chord notes when updating UI (new pattern)
-    currentChordNotes.clear();
+    // Clear any existing chord notes and expect the new question's note count
+    chordCapture->clear();
+    chordCapture->setExpectedNoteCount(quiz->getCurrentExpectedNotes().size());
     
     if (titleLabel) {
         titleLabel->setText(title.toUpper());
@@ -505,33 +438,29 @@ void QuizWidget::updateQuizUI(int score, QString title, QString description, dou
  * @param score The final score
  * @param accuracy The final accuracy percentage
  * @details Saves the final quiz state, including the Q-table and user state,
- *          creates and saves a quiz report, displays completion information,
- *          and emits the quizFinished signal.
+ *          closes the quiz in the quiz history, displays completion information,
+ *          and emits the quizFinished signal. Only snapshots are taken here; the
+ *          serialization and file writes run on the data writer thread, so the
+ *          dialog appears without waiting for them. The answers themselves were
+ *          recorded as they were given, so ending the quiz appends one record.
  */
 void QuizWidget::handleQuizOver(int score, double accuracy)
 {
     // Prevent multiple quiz over events for the same session
-    static bool quizOverHandled = false;
     if (quizOverHandled || !quiz) {
         return;
     }
     quizOverHandled = true;
     
-    // 1. Save the updated Q-table
+    // 1. Save a snapshot of the updated Q-table and review schedule
     LoadDataManager::instance()->saveQTable(quiz->getQTable());
+    LoadDataManager::instance()->saveReviewSchedule(reviewSchedule);
     State currentState = quiz->getCurrentState();
     LoadDataManager::instance()->saveUserState(currentState);
     
-    // 2. Create and save quiz report
-    QuizReport report(
-        quiz->getScore(),
-        quiz->getAccuracy(),
-        quiz->getTotalQuestions(),
-        quiz->getCorrectAnswers(),
-        quiz->getHistory()
-    );
-    
-    DataManager::saveQuizReport("quiz_report.json", report);
+    // 2. Close the session in the quiz history
+    LoadDataManager::instance()->endQuizSession(static_cast<int>(quiz->getScore()),
+                                                quiz->getTotalQuestions(), quiz->getCorrectAnswers());
     
     // 3. Show completion dialog
     QString message = QString(
@@ -548,22 +477,11 @@ void QuizWidget::handleQuizOver(int score, double accuracy)
     
     QMessageBox::information(this, "Quiz Complete", message);
     
-    // 4. Emit signal that quiz is finished
+    // 4. Stop listening to the piano and emit signal that quiz is finished
+    stop();
     emit quizFinished();
 }
 
-/**
- * @brief Loads questions from the question bank
- * @return A map of question IDs to Question objects
- * @details Loads questions from the resource file using the QuestionLoader,
- *          and returns them as a map for use by the adaptive quiz engine.
- */
-std::map<int, Question> QuizWidget::loadQuestions()
-{
-    auto questions = loadQuestionsFromFile(":/resources/questionBank.json");
-    return questions;
-}
-
 /**
  * @brief Resets the quiz over handled flag
  * @details Static method to reset the flag that prevents multiple calls to
@@ -20,9 +20,9 @@
 #include <QPushButton>
 #include <QFormLayout>
 #include <QDialogButtonBox>
-#include <QtCore/QTimer>
-#include <QSet>
 #include "adaptivequiz.h"
+#include "chordcapture.h"
+#include "noteset.h"
 // "Question.h" is already included by AdaptiveQuiz.h, no need to include it again
 
 /**
@@ -55,28 +55,47 @@ public:
 
     /**
      * @brief Starts the quiz with appropriate checks and initialization
-     * @details Initializes the adaptive quiz by loading questions, checking if the
+     * @details Initializes the adaptive quiz with the shared question bank, checking if the
      *          user is new, and initializing either with user-provided skill levels
      *          or previously saved state. Sets up the quiz engine with appropriate
      *          parameters and displays the first question to the user.
      */
     void startQuiz();
 
+    /**
+     * @brief Stops listening to the piano
+     * @details Called when the quiz page is left. The quiz engine and the labels are
+     *          kept for the next startQuiz().
+     */
+    void stop();
+
+    /**
+     * @brief Gets the analytics of the quizzes played on this page
+     * @return The quiz engine's scoring system, or nullptr before the first quiz
+     */
+    const ScoringSystem* scoring() const;
+
+    /**
+     * @brief Gets the memory the quiz engine's own state holds
+     * @return Bytes of the Q-table and the review schedule; the question bank is
+     *         shared and counted apart
+     */
+    qint64 memoryUsage() const;
+
 public slots:
     /**
      * @brief Handles keyboard input for note playing
      * @param noteIndex The MIDI note number pressed
-     * @details Processes piano key presses, converts them to note names,
-     *          and adds them to the current chord collection. Manages
-     *          the chord timer to collect multi-note inputs when needed.
+     * @details Passes piano key presses within the keyboard range on to the
+     *          chord capture, which groups them into a chord.
      */
     void handleKeyPressed(int noteIndex);
 
     /**
      * @brief Handles key release events from the piano
      * @param noteIndex The index of the released note
-     * @details Processes key release events, updates the currently pressed keys set,
-     *          and submits the collected chord when all keys have been released.
+     * @details Passes key releases on to the chord capture, which submits the
+     *          collected chord once all keys have been released.
      */
     void handleKeyReleased(int noteIndex);
 
@@ -97,19 +116,11 @@ public slots:
      * @param score The final score
      * @param accuracy The final accuracy percentage
      * @details Saves the final quiz state, including the Q-table and user state,
-     *          creates and saves a quiz report, displays completion information,
+     *          closes the quiz in the quiz history, displays completion information,
      *          and emits the quizFinished signal.
      */
     void handleQuizOver(int score, double accuracy);
 
-    /**
-     * @brief Handles the chord timeout event
-     * @details Submits the collected chord when no new keys are pressed for the timeout period,
-     *          even if not all keys have been released. This ensures the user's input
-     *          is processed after a reasonable waiting period.
-     */
-    void handleChordTimeout();
-
 signals:
     /**
      * @brief Signal emitted when the quiz is finished
@@ -119,15 +130,31 @@ signals:
      */
     void quizFinished();
 
+private slots:
+    /**
+     * @brief Drops the quiz state of the previous profile
+     * @details Connected to LoadDataManager::profileChanged(). The engine is deleted
+     *          and the Q-table and review schedule are read again by the next
+     *          startQuiz(), so nothing the previous player learned is trained on,
+     *          scheduled or saved into the new profile's data. A quiz that was
+     *          still running is abandoned; its answers were already recorded for
+     *          the previous profile.
+     */
+    void handleProfileChanged();
+
 private:
     /**
      * @brief Sets up the user interface elements
      * @details Configures all UI elements including labels, fonts, and styles.
-     *          Connects the piano widget to the quiz for handling user input and
-     *          sets up the chord timer for collecting multi-note inputs.
+     *          Connects the piano widget to the quiz for handling user input.
      */
     void setupUI();
 
+    /**
+     * @brief Attaches the piano to the quiz page and listens to its keys
+     */
+    void connectPiano();
+
     /**
      * @brief Shows a dialog for new users to input their skill levels
      * @return A State object with the user's skill levels
@@ -137,32 +164,14 @@ private:
      */
     State showNewUserDialog();
 
-    /**
-     * @brief Converts a MIDI note index to its corresponding note name
-     * @param noteIndex The MIDI note number (60-72)
-     * @return The note name as a string (e.g., "C4", "D#4")
-     * @details Maps MIDI note numbers to their corresponding note names with octave
-     *          information. Handles both white and black keys in the octave range
-     *          from C4 to C5.
-     */
-    QString noteIndexToName(int noteIndex);
-
     /**
      * @brief Submits the current chord for evaluation
-     * @details Normalizes the collected notes, compares them with the expected input,
-     *          and sends the result to the adaptive quiz engine. Handles progression
-     *          to the next question or quiz completion based on the number of questions
-     *          answered.
-     */
-    void submitChord();
-    
-    /**
-     * @brief Loads questions from the question bank
-     * @return A map of question IDs to Question objects
-     * @details Loads questions from the resource file using the QuestionLoader,
-     *          and returns them as a map for use by the adaptive quiz engine.
+     * @param chord The chord captured from the piano
+     * @details Hands the collected notes to the quiz session, which compares them with
+     *          the question's expected notes by pitch class, asks the next question or
+     *          ends the quiz.
      */
-    std::map<int, Question> loadQuestions();
+    void submitChord(const NoteSet& chord);
     
     /**
      * @brief Resets the quiz over handled flag
@@ -171,24 +180,21 @@ private:
      */
     static void resetQuizOverHandled();
 
-    AdaptiveQuiz *quiz;                 ///< Pointer to the adaptive quiz engine
+    AdaptiveQuiz *quiz;                 ///< Pointer to the adaptive quiz engine, reused by every quiz
+    QTable qTable;                      ///< Q-table the quiz learns in, borrowed by the engine
+    ReviewSchedule reviewSchedule;      ///< Spaced-repetition schedule, borrowed by the engine
+    bool qTableLoaded;                  ///< Whether qTable and reviewSchedule have been read from the active profile's data
     QLabel *titleLabel;                 ///< Label displaying the question title
     QLabel *descriptionLabel;           ///< Label displaying the question description
     QLabel *scoreLabel;                 ///< Label displaying the current score
     QLabel *accuracyLabel;              ///< Label displaying the current accuracy
     
-    int currentQuestionId;              ///< ID of the current question being displayed
-    
     // For handling chords
-    QStringList currentChordNotes;      ///< Collection of notes in the current chord attempt
-    static const int CHORD_TIMEOUT_MS = 1000;  ///< Timeout in milliseconds for chord collection
-    QTimer* chordTimer;                 ///< Timer for handling chord input timeouts
-    QSet<int> currentlyPressedKeys;     ///< Set of currently pressed piano keys
+    ChordCapture* chordCapture;         ///< Groups key presses into submitted chords
     bool isProcessingSubmission;        ///< Flag to prevent multiple rapid submissions
     
     // Constants
     static const int NUM_QUIZ_QUESTIONS = 10;  ///< Number of questions in a quiz session
-    int questionsAnswered;              ///< Count of questions answered in current session
     
     // Static flag to prevent multiple quiz over handling
     static bool quizOverHandled;        ///< Flag to prevent multiple calls to handleQuizOver
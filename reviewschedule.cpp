@@ -0,0 +1,266 @@
+/**
+ * @file reviewschedule.cpp
+ * @brief Implementation of the ReviewSchedule class
+ * @author Alan Cruz
+ * @details This file implements the interval updates, the indexed due-time heap
+ *          and the binary form of the spaced-repetition schedule.
+ */
+
+#include "reviewschedule.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <QDebug>
+
+/// Question IDs are dense; anything outside this range is rejected
+static const int REVIEW_MAX_QUESTION_ID = 1 << 20;
+
+/// Identifies the binary form of a schedule
+static const char REVIEW_MAGIC[4] = {'K', 'Q', 'R', 'S'};
+
+/// Version of the binary form; bumped whenever its layout changes
+static const quint16 REVIEW_VERSION = 1;
+
+/**
+ * @brief Header of the binary form of a schedule
+ */
+struct ReviewScheduleHeader {
+    char magic[4];        ///< REVIEW_MAGIC
+    quint16 version;      ///< REVIEW_VERSION
+    quint16 itemSize;     ///< sizeof(ReviewSchedule::Item)
+    quint32 itemCount;    ///< Number of items
+};
+
+/**
+ * @brief Records an answer and schedules the question's next review
+ * @param questionID The answered question; negative IDs are ignored
+ * @param correct Whether the answer was correct
+ * @param now Time of the answer, in seconds since the epoch
+ */
+void ReviewSchedule::review(int questionID, bool correct, qint64 now)
+{
+    if (questionID < 0 || questionID >= REVIEW_MAX_QUESTION_ID) {
+        return;
+    }
+
+    int index = questionID < static_cast<int>(m_itemByID.size()) ? m_itemByID[questionID] : -1;
+    if (index < 0) {
+        Item item;
+        item.questionID = questionID;
+        index = insert(item);
+    }
+
+    Item& item = m_items[index];
+    const quint32 previous = item.due;
+    if (!correct) {
+        item.interval = LAPSE_INTERVAL_S;
+    } else if (item.interval == 0) {
+        item.interval = FIRST_INTERVAL_S;
+    } else {
+        item.interval = static_cast<quint32>(std::min<double>(double(item.interval) * INTERVAL_GROWTH, MAX_INTERVAL_S));
+    }
+    item.due = static_cast<quint32>(qBound<qint64>(0, now + item.interval, std::numeric_limits<quint32>::max()));
+
+    const int position = m_heapPositions[index];
+    if (item.due < previous) {
+        siftUp(position);
+    } else {
+        siftDown(position);
+    }
+}
+
+/**
+ * @brief Gets the earliest due questions
+ * @param now The current time, in seconds since the epoch
+ * @param questionIDs Receives the questions, earliest due first
+ * @param capacity Size of questionIDs; at most MAX_LOOKAHEAD are returned
+ * @return Number of questions due at now written to questionIDs
+ * @details Walks the heap from the root and keeps a frontier of the children of
+ *          the items taken so far; the earliest of the frontier is always the next
+ *          earliest item. The frontier never holds more than one item per step, so
+ *          it fits a fixed array.
+ */
+int ReviewSchedule::dueQuestions(qint64 now, int* questionIDs, int capacity) const
+{
+    capacity = std::min(capacity, MAX_LOOKAHEAD);
+    if (capacity <= 0 || m_heap.empty()) {
+        return 0;
+    }
+
+    int frontier[MAX_LOOKAHEAD + 1];
+    int frontierSize = 0;
+    frontier[frontierSize++] = 0;
+    int count = 0;
+    const int heapSize = static_cast<int>(m_heap.size());
+    while (count < capacity && frontierSize > 0) {
+        int earliest = 0;
+        for (int i = 1; i < frontierSize; ++i) {
+            if (m_items[m_heap[frontier[i]]].due < m_items[m_heap[frontier[earliest]]].due) {
+                earliest = i;
+            }
+        }
+        const int position = frontier[earliest];
+        const Item& item = m_items[m_heap[position]];
+        if (item.due > now) {
+            break;
+        }
+        questionIDs[count++] = item.questionID;
+
+        frontier[earliest] = frontier[--frontierSize];
+        for (int child = 2 * position + 1; child <= 2 * position + 2 && child < heapSize; ++child) {
+            frontier[frontierSize++] = child;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Gets the schedule of a question
+ * @param questionID The question
+ * @return Its item, or nullptr if it has never been answered
+ */
+const ReviewSchedule::Item* ReviewSchedule::item(int questionID) const
+{
+    if (questionID < 0 || questionID >= static_cast<int>(m_itemByID.size()) || m_itemByID[questionID] < 0) {
+        return nullptr;
+    }
+    return &m_items[m_itemByID[questionID]];
+}
+
+/**
+ * @brief Gets the memory held by the schedule
+ * @return Bytes used by the object and its arrays, counting reserved capacity
+ */
+std::size_t ReviewSchedule::memoryUsage() const
+{
+    return sizeof(*this) + m_items.capacity() * sizeof(Item)
+           + (m_heap.capacity() + m_heapPositions.capacity() + m_itemByID.capacity()) * sizeof(int);
+}
+
+/**
+ * @brief Builds a schedule from its binary form
+ * @param data Bytes produced by toBinary()
+ * @return The parsed schedule, empty if the data is not a schedule of this version
+ */
+ReviewSchedule ReviewSchedule::fromBinary(const QByteArray& data)
+{
+    ReviewSchedule schedule;
+    ReviewScheduleHeader header;
+    if (data.size() < qsizetype(sizeof(header))) {
+        qDebug() << "ReviewSchedule: Binary schedule is too short";
+        return schedule;
+    }
+    std::memcpy(&header, data.constData(), sizeof(header));
+    if (std::memcmp(header.magic, REVIEW_MAGIC, sizeof(REVIEW_MAGIC)) != 0
+            || header.version != REVIEW_VERSION || header.itemSize != sizeof(Item)) {
+        qDebug() << "ReviewSchedule: Not a binary schedule of version" << REVIEW_VERSION;
+        return schedule;
+    }
+    if (header.itemCount > quint32(REVIEW_MAX_QUESTION_ID)
+            || data.size() != qsizetype(sizeof(header)) + qsizetype(header.itemCount) * qsizetype(sizeof(Item))) {
+        qDebug() << "ReviewSchedule: Binary schedule has the wrong size";
+        return schedule;
+    }
+
+    std::vector<Item> items(header.itemCount);
+    std::memcpy(items.data(), data.constData() + sizeof(header), items.size() * sizeof(Item));
+    schedule.m_items.reserve(items.size());
+    schedule.m_heap.reserve(items.size());
+    schedule.m_heapPositions.reserve(items.size());
+    for (const Item& item : items) {
+        if (item.questionID < 0 || item.questionID >= REVIEW_MAX_QUESTION_ID || schedule.item(item.questionID)) {
+            qDebug() << "ReviewSchedule: Binary schedule has invalid question IDs";
+            return ReviewSchedule();
+        }
+        schedule.insert(item);
+    }
+    return schedule;
+}
+
+/**
+ * @brief Converts the schedule to its binary form
+ * @return A header and then every item
+ */
+QByteArray ReviewSchedule::toBinary() const
+{
+    ReviewScheduleHeader header;
+    std::memcpy(header.magic, REVIEW_MAGIC, sizeof(REVIEW_MAGIC));
+    header.version = REVIEW_VERSION;
+    header.itemSize = sizeof(Item);
+    header.itemCount = static_cast<quint32>(m_items.size());
+
+    QByteArray data;
+    data.reserve(sizeof(header) + m_items.size() * sizeof(Item));
+    data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    data.append(reinterpret_cast<const char*>(m_items.data()), m_items.size() * sizeof(Item));
+    return data;
+}
+
+/**
+ * @brief Adds an item to the heap
+ * @param item The item; its question must not be scheduled yet
+ * @return Index of the item in m_items
+ */
+int ReviewSchedule::insert(const Item& item)
+{
+    const int index = static_cast<int>(m_items.size());
+    if (item.questionID >= static_cast<int>(m_itemByID.size())) {
+        m_itemByID.resize(item.questionID + 1, -1);
+    }
+    m_itemByID[item.questionID] = index;
+    m_items.push_back(item);
+    m_heapPositions.push_back(static_cast<int>(m_heap.size()));
+    m_heap.push_back(index);
+    siftUp(static_cast<int>(m_heap.size()) - 1);
+    return index;
+}
+
+/**
+ * @brief Moves an item up the heap until its parent is due earlier
+ * @param position Position of the item in m_heap
+ */
+void ReviewSchedule::siftUp(int position)
+{
+    while (position > 0) {
+        const int parent = (position - 1) / 2;
+        if (m_items[m_heap[parent]].due <= m_items[m_heap[position]].due) {
+            break;
+        }
+        swapPositions(position, parent);
+        position = parent;
+    }
+}
+
+/**
+ * @brief Moves an item down the heap until its children are due later
+ * @param position Position of the item in m_heap
+ */
+void ReviewSchedule::siftDown(int position)
+{
+    const int size = static_cast<int>(m_heap.size());
+    while (true) {
+        int earliest = position;
+        for (int child = 2 * position + 1; child <= 2 * position + 2 && child < size; ++child) {
+            if (m_items[m_heap[child]].due < m_items[m_heap[earliest]].due) {
+                earliest = child;
+            }
+        }
+        if (earliest == position) {
+            return;
+        }
+        swapPositions(position, earliest);
+        position = earliest;
+    }
+}
+
+/**
+ * @brief Swaps two heap positions and updates the index of both items
+ * @param a First position
+ * @param b Second position
+ */
+void ReviewSchedule::swapPositions(int a, int b)
+{
+    std::swap(m_heap[a], m_heap[b]);
+    m_heapPositions[m_heap[a]] = a;
+    m_heapPositions[m_heap[b]] = b;
+}
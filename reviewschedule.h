@@ -0,0 +1,144 @@
+/**
+ * @file reviewschedule.h
+ * @brief Header file for the ReviewSchedule class
+ * @author Alan Cruz
+ * @details This file defines the ReviewSchedule class, the spaced-repetition memory
+ *          of the adaptive quiz. It remembers, across quizzes, how well each answered
+ *          question is known and when it should be asked again.
+ */
+
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <QByteArray>
+#include <QtGlobal>
+
+/**
+ * @brief Spaced-repetition schedule of the answered questions
+ * @details Every question answered at least once has an item with its memory
+ *          strength, the interval until it should be reviewed, and the time it is
+ *          due. A correct answer multiplies the interval by INTERVAL_GROWTH, up to
+ *          MAX_INTERVAL_S; a wrong one drops it back to LAPSE_INTERVAL_S, so missed
+ *          questions come back in the next quiz and well-known ones only every few
+ *          weeks.
+ *
+ *          The items are kept in an indexed binary min-heap on the due time. An
+ *          answer moves its item in O(log n), and dueQuestions() reads the earliest
+ *          due items in time that depends on how many are asked for, not on the
+ *          size of the schedule, without changing the heap or allocating.
+ *
+ *          Times are seconds since the Unix epoch. The binary form of toBinary()
+ *          holds 12 bytes per item; LoadDataManager stores it in the profile.
+ */
+class ReviewSchedule {
+public:
+    static constexpr quint32 FIRST_INTERVAL_S = 10 * 60;           ///< Interval after the first correct answer
+    static constexpr quint32 LAPSE_INTERVAL_S = 2 * 60;            ///< Interval after a wrong answer
+    static constexpr quint32 MAX_INTERVAL_S = 60 * 24 * 60 * 60;   ///< Longest interval, 60 days
+    static constexpr float INTERVAL_GROWTH = 2.5f;                 ///< Factor a correct answer grows the interval by
+    static constexpr int MAX_LOOKAHEAD = 16;                       ///< Most items dueQuestions() returns
+
+    /**
+     * @brief Schedule of one question
+     */
+    struct Item {
+        int questionID = -1;    ///< The question
+        quint32 due = 0;        ///< When it should be asked again, in seconds since the epoch
+        quint32 interval = 0;   ///< Memory strength: the last interval in seconds
+    };
+
+    /**
+     * @brief Records an answer and schedules the question's next review
+     * @param questionID The answered question; negative IDs are ignored
+     * @param correct Whether the answer was correct
+     * @param now Time of the answer, in seconds since the epoch
+     */
+    void review(int questionID, bool correct, qint64 now);
+
+    /**
+     * @brief Gets the earliest due questions
+     * @param now The current time, in seconds since the epoch
+     * @param questionIDs Receives the questions, earliest due first
+     * @param capacity Size of questionIDs; at most MAX_LOOKAHEAD are returned
+     * @return Number of questions due at now written to questionIDs
+     */
+    int dueQuestions(qint64 now, int* questionIDs, int capacity) const;
+
+    /**
+     * @brief Gets the schedule of a question
+     * @param questionID The question
+     * @return Its item, or nullptr if it has never been answered
+     */
+    const Item* item(int questionID) const;
+
+    /**
+     * @brief Gets the number of scheduled questions
+     * @return The number of items
+     */
+    int size() const { return static_cast<int>(m_items.size()); }
+
+    /**
+     * @brief Checks whether any question is scheduled
+     * @return true if no question has been answered yet
+     */
+    bool isEmpty() const { return m_items.empty(); }
+
+    /**
+     * @brief Gets the memory held by the schedule
+     * @return Bytes used by the object and its arrays, counting reserved capacity
+     */
+    std::size_t memoryUsage() const;
+
+    /**
+     * @brief Builds a schedule from its binary form
+     * @param data Bytes produced by toBinary()
+     * @return The parsed schedule, empty if the data is not a schedule of this version
+     */
+    static ReviewSchedule fromBinary(const QByteArray& data);
+
+    /**
+     * @brief Converts the schedule to its binary form
+     * @return A header and then every item
+     * @details Values are stored in the byte order of the machine, like the Q-table.
+     */
+    QByteArray toBinary() const;
+
+private:
+    /**
+     * @brief Adds an item to the heap
+     * @param item The item; its question must not be scheduled yet
+     * @return Index of the item in m_items
+     */
+    int insert(const Item& item);
+
+    /**
+     * @brief Moves an item up the heap until its parent is due earlier
+     * @param position Position of the item in m_heap
+     */
+    void siftUp(int position);
+
+    /**
+     * @brief Moves an item down the heap until its children are due later
+     * @param position Position of the item in m_heap
+     */
+    void siftDown(int position);
+
+    /**
+     * @brief Swaps two heap positions and updates the index of both items
+     * @param a First position
+     * @param b Second position
+     */
+    void swapPositions(int a, int b);
+
+    /// Every item, in the order the questions were first answered
+    std::vector<Item> m_items;
+
+    /// Indexes into m_items, as a binary min-heap on the due time
+    std::vector<int> m_heap;
+
+    /// Position in m_heap of every item
+    std::vector<int> m_heapPositions;
+
+    /// Index into m_items of every question ID, -1 where the ID is not scheduled; indexed by ID
+    std::vector<int> m_itemByID;
+};
@@ -0,0 +1,163 @@
+/**
+ * @file rhythmengine.cpp
+ * @brief Implementation of the RhythmEngine class
+ * @author Alan Cruz
+ * @details This file implements the alignment of note onsets with the tempo grid and
+ *          the onset deviation and tempo drift scores of the Rhythm/Melody lesson.
+ */
+
+#include "rhythmengine.h"
+#include <cmath>
+
+/**
+ * @brief Checks whether the timing passes the lesson
+ * @return true if the score reaches RhythmEngine::PASS_SCORE
+ */
+bool RhythmResult::passed() const
+{
+    return score >= RhythmEngine::PASS_SCORE;
+}
+
+/**
+ * @brief Creates an engine without a pattern
+ * @param bpm Tempo of the grid in beats per minute
+ */
+RhythmEngine::RhythmEngine(double bpm)
+    : m_bpm(DEFAULT_BPM)
+    , m_period(0)
+{
+    setTempo(bpm);
+}
+
+/**
+ * @brief Sets the tempo of the grid
+ * @param bpm Beats per minute; values outside 20-300 are clamped
+ */
+void RhythmEngine::setTempo(double bpm)
+{
+    m_bpm = qBound(20.0, bpm, 300.0);
+    m_period = static_cast<qint64>(60e9 / m_bpm);
+}
+
+/**
+ * @brief Starts a pattern
+ * @param firstBeat When the first beat of the pattern is heard
+ * @param beats Number of beats of the pattern
+ */
+void RhythmEngine::start(qint64 firstBeat, int beats)
+{
+    m_firstBeat = firstBeat;
+    m_beats = qMax(0, beats);
+    m_lastPress = 0;
+    m_onsets.clear();
+    m_onsets.reserve(m_beats + 4);
+}
+
+/**
+ * @brief Drops the pattern and its onsets
+ */
+void RhythmEngine::stop()
+{
+    m_beats = 0;
+    m_onsets.clear();
+}
+
+/**
+ * @brief Records a key press
+ * @param pressTime When the key went down
+ * @return true if the press started a new onset
+ * @details The window opens half a beat before the first beat, so a player who
+ *          rushes the first note is still scored.
+ */
+bool RhythmEngine::addOnset(qint64 pressTime)
+{
+    if (m_beats == 0) {
+        return false;
+    }
+    const qint64 heard = pressTime + m_latency;
+    if (heard < m_firstBeat - m_period / 2 || heard > windowEnd()) {
+        return false;
+    }
+    if (!m_onsets.empty() && pressTime - m_lastPress < CHORD_WINDOW_NS) {
+        // Another finger of the same chord
+        m_lastPress = pressTime;
+        return false;
+    }
+    m_lastPress = pressTime;
+    m_onsets.push_back(heard);
+    return true;
+}
+
+/**
+ * @brief Scores the onsets recorded so far
+ * @return The timing of the attempt
+ * @details Each hit beat earns full credit within FULL_CREDIT_MS and falls off
+ *          linearly to nothing at ZERO_CREDIT_MS. Missed beats earn nothing and
+ *          every extra onset costs as much as a missed beat. The score is the
+ *          credit as a percentage of the beats.
+ */
+RhythmResult RhythmEngine::result() const
+{
+    RhythmResult result;
+    result.beats = m_beats;
+    result.targetBpm = m_bpm;
+    if (m_beats == 0) {
+        return result;
+    }
+
+    // Nearest beat of every onset; the first onset on a beat keeps it
+    std::vector<qint64> deviation(m_beats, 0);
+    std::vector<bool> hit(m_beats, false);
+    for (qint64 heard : m_onsets) {
+        const double position = double(heard - m_firstBeat) / m_period;
+        const int beat = qBound(0, static_cast<int>(std::lround(position)), m_beats - 1);
+        if (hit[beat]) {
+            ++result.extraOnsets;
+            continue;
+        }
+        hit[beat] = true;
+        deviation[beat] = heard - beatTime(beat);
+    }
+
+    double credit = 0.0;
+    double signedSum = 0.0;
+    double absSum = 0.0;
+    double beatSum = 0.0;
+    double beatSquareSum = 0.0;
+    double timeSum = 0.0;
+    double crossSum = 0.0;
+    for (int beat = 0; beat < m_beats; ++beat) {
+        if (!hit[beat]) {
+            continue;
+        }
+        const double ms = deviation[beat] / 1e6;
+        const double absMs = std::fabs(ms);
+        ++result.hits;
+        signedSum += ms;
+        absSum += absMs;
+        result.maxAbsDeviationMs = qMax(result.maxAbsDeviationMs, absMs);
+        credit += qBound(0.0, (ZERO_CREDIT_MS - absMs) / (ZERO_CREDIT_MS - FULL_CREDIT_MS), 1.0);
+
+        // Onset time relative to the first beat, in milliseconds, for the tempo fit
+        const double time = double(beatTime(beat) - m_firstBeat) / 1e6 + ms;
+        beatSum += beat;
+        beatSquareSum += double(beat) * beat;
+        timeSum += time;
+        crossSum += beat * time;
+    }
+
+    if (result.hits > 0) {
+        result.meanDeviationMs = signedSum / result.hits;
+        result.meanAbsDeviationMs = absSum / result.hits;
+    }
+    const double denominator = result.hits * beatSquareSum - beatSum * beatSum;
+    if (result.hits >= 2 && denominator > 0.0) {
+        const double periodMs = (result.hits * crossSum - beatSum * timeSum) / denominator;
+        if (periodMs > 0.0) {
+            result.playedBpm = 60000.0 / periodMs;
+            result.driftPercent = (result.playedBpm / m_bpm - 1.0) * 100.0;
+        }
+    }
+    result.score = qMax(0.0, credit - result.extraOnsets) / m_beats * 100.0;
+    return result;
+}
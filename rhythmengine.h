@@ -0,0 +1,163 @@
+/**
+ * @file rhythmengine.h
+ * @brief Header file for the RhythmEngine class
+ * @author Alan Cruz
+ * @details This file defines the timing engine of the Rhythm/Melody lesson. It aligns
+ *          timestamped note onsets against a tempo grid and scores how far each one
+ *          lands from its beat and how far the player's tempo drifts.
+ */
+
+#ifndef RHYTHMENGINE_H
+#define RHYTHMENGINE_H
+
+#include <vector>
+#include <QtGlobal>
+
+/**
+ * @brief Timing of one attempt at a rhythm question
+ */
+struct RhythmResult {
+    int beats = 0;                ///< Beats of the pattern
+    int hits = 0;                 ///< Beats an onset was aligned to
+    int extraOnsets = 0;          ///< Onsets beyond those aligned to a beat
+    double meanDeviationMs = 0.0;   ///< Mean signed onset deviation; negative is early
+    double meanAbsDeviationMs = 0.0;  ///< Mean absolute onset deviation
+    double maxAbsDeviationMs = 0.0;   ///< Largest absolute onset deviation
+    double targetBpm = 0.0;       ///< Tempo of the grid
+    double playedBpm = 0.0;       ///< Tempo fitted to the onsets, 0 with fewer than two hits
+    double driftPercent = 0.0;    ///< How much faster than the grid the player went; negative is slower
+    double score = 0.0;           ///< Timing score, 0-100
+
+    /**
+     * @brief Checks whether the timing passes the lesson
+     * @return true if the score reaches RhythmEngine::PASS_SCORE
+     */
+    bool passed() const;
+};
+
+/**
+ * @brief Aligns note onsets against a tempo grid
+ * @details All times are nanoseconds on the MidiEventQueue::now() clock, so onsets
+ *          stamped by MidiInput on the MIDI driver's thread are scored with the time
+ *          the key went down, not the time the GUI thread got to them. Delivery
+ *          jitter of the event loop therefore never reaches the score.
+ *
+ *          The grid is defined in heard time: beat k of the pattern sounds at
+ *          firstBeat + k * period. A key pressed at t is heard at t plus the output
+ *          latency of the synthesizer, so that latency is added to every onset
+ *          before it is compared with the grid. Metronome clicks scheduled at
+ *          beatTime() minus the same latency are heard on the beat.
+ *
+ *          Onsets within CHORD_WINDOW_NS of the previous one belong to the same
+ *          chord and count once. Each onset is aligned to the nearest beat of the
+ *          pattern; a second onset on a beat counts as extra. The played tempo is
+ *          the least-squares slope of the aligned onsets over their beats.
+ */
+class RhythmEngine
+{
+public:
+    static constexpr double DEFAULT_BPM = 80.0;            ///< Tempo of the lesson
+    static constexpr int COUNT_IN_BEATS = 4;               ///< Clicks before the first beat
+    static constexpr qint64 CHORD_WINDOW_NS = 60000000;    ///< Onsets this close form one chord
+    static constexpr double FULL_CREDIT_MS = 30.0;         ///< Deviation still counted as on the beat
+    static constexpr double ZERO_CREDIT_MS = 150.0;        ///< Deviation that earns nothing
+    static constexpr double PASS_SCORE = 60.0;             ///< Score needed to pass a question
+
+    /**
+     * @brief Creates an engine without a pattern
+     * @param bpm Tempo of the grid in beats per minute
+     */
+    explicit RhythmEngine(double bpm = DEFAULT_BPM);
+
+    /**
+     * @brief Sets the tempo of the grid
+     * @param bpm Beats per minute; takes effect with the next start()
+     */
+    void setTempo(double bpm);
+
+    /**
+     * @brief Gets the tempo of the grid
+     * @return Beats per minute
+     */
+    double tempo() const { return m_bpm; }
+
+    /**
+     * @brief Gets the time between two beats
+     * @return The period in nanoseconds
+     */
+    qint64 period() const { return m_period; }
+
+    /**
+     * @brief Sets the latency from a key press to its sound
+     * @param latencyNs The output latency in nanoseconds
+     */
+    void setOutputLatency(qint64 latencyNs) { m_latency = qMax<qint64>(0, latencyNs); }
+
+    /**
+     * @brief Gets the latency added to every onset
+     * @return The output latency in nanoseconds
+     */
+    qint64 outputLatency() const { return m_latency; }
+
+    /**
+     * @brief Starts a pattern
+     * @param firstBeat When the first beat of the pattern is heard
+     * @param beats Number of beats of the pattern
+     */
+    void start(qint64 firstBeat, int beats);
+
+    /**
+     * @brief Drops the pattern and its onsets
+     */
+    void stop();
+
+    /**
+     * @brief Checks whether a pattern is being played
+     * @return true between start() and stop()
+     */
+    bool isActive() const { return m_beats > 0; }
+
+    /**
+     * @brief Gets when a beat is heard
+     * @param beat Index of the beat; negative indices are the count-in
+     * @return The time of the beat
+     */
+    qint64 beatTime(int beat) const { return m_firstBeat + beat * m_period; }
+
+    /**
+     * @brief Gets when onsets stop counting
+     * @return Half a beat after the last beat
+     */
+    qint64 windowEnd() const { return beatTime(m_beats - 1) + m_period / 2; }
+
+    /**
+     * @brief Records a key press
+     * @param pressTime When the key went down
+     * @return true if the press started a new onset, false if it belongs to the
+     *         previous chord or lies outside the pattern's window
+     */
+    bool addOnset(qint64 pressTime);
+
+    /**
+     * @brief Checks whether every beat has received an onset
+     * @return true if as many onsets as beats were recorded
+     */
+    bool isComplete() const { return m_beats > 0 && static_cast<int>(m_onsets.size()) >= m_beats; }
+
+    /**
+     * @brief Scores the onsets recorded so far
+     * @return The timing of the attempt
+     */
+    RhythmResult result() const;
+
+private:
+    double m_bpm;                  ///< Tempo of the grid
+    qint64 m_period;               ///< Nanoseconds per beat
+    qint64 m_latency = 0;          ///< Output latency added to every press
+    qint64 m_firstBeat = 0;        ///< When beat 0 is heard
+    int m_beats = 0;               ///< Beats of the pattern, 0 when stopped
+    qint64 m_lastPress = 0;        ///< Press time of the latest onset or chord note
+    std::vector<qint64> m_onsets;  ///< Heard times of the onsets, in order
+};
+
+#endif // RHYTHMENGINE_H
@@ -0,0 +1,161 @@
+/**
+ * @file runningstats.cpp
+ * @brief Implementation of the RunningStats class
+ * @author Alan Cruz, Bashar Hamo
+ * @details This file implements the running aggregate used for lesson statistics
+ *          and its conversion to and from the data.json representation.
+ */
+
+#include "runningstats.h"
+#include <algorithm>
+#include <QJsonArray>
+
+/**
+ * @brief Adds a value to the series
+ * @param value The new value
+ */
+void RunningStats::add(double value)
+{
+    if (m_count == 0) {
+        m_min = value;
+        m_max = value;
+    } else {
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+    ++m_count;
+    m_sum += value;
+    m_sumSquares += value * value;
+
+    m_window[m_windowNext] = value;
+    m_windowNext = (m_windowNext + 1) % WINDOW_SIZE;
+    m_windowCount = std::min(m_windowCount + 1, WINDOW_SIZE);
+}
+
+/**
+ * @brief Adds all values of another series
+ * @param other The series to add
+ */
+void RunningStats::merge(const RunningStats& other)
+{
+    if (other.m_count == 0) {
+        return;
+    }
+    if (m_count == 0) {
+        m_min = other.m_min;
+        m_max = other.m_max;
+    } else {
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_sumSquares += other.m_sumSquares;
+
+    for (double value : other.recent()) {
+        m_window[m_windowNext] = value;
+        m_windowNext = (m_windowNext + 1) % WINDOW_SIZE;
+        m_windowCount = std::min(m_windowCount + 1, WINDOW_SIZE);
+    }
+}
+
+/**
+ * @brief Gets the mean of all values
+ * @return The mean, 0 if the series is empty
+ */
+double RunningStats::mean() const
+{
+    return m_count > 0 ? m_sum / m_count : 0.0;
+}
+
+/**
+ * @brief Gets the population variance of all values
+ * @return The variance, 0 if the series is empty
+ */
+double RunningStats::variance() const
+{
+    if (m_count == 0) {
+        return 0.0;
+    }
+    double average = mean();
+    // Rounding can make the difference slightly negative for constant series
+    return std::max(0.0, m_sumSquares / m_count - average * average);
+}
+
+/**
+ * @brief Gets the most recent values
+ * @return Up to WINDOW_SIZE values, oldest first
+ */
+QList<double> RunningStats::recent() const
+{
+    QList<double> values;
+    values.reserve(m_windowCount);
+    int first = (m_windowNext - m_windowCount + WINDOW_SIZE) % WINDOW_SIZE;
+    for (int i = 0; i < m_windowCount; ++i) {
+        values.append(m_window[(first + i) % WINDOW_SIZE]);
+    }
+    return values;
+}
+
+/**
+ * @brief Gets the mean of the most recent values
+ * @return The mean of recent(), 0 if the series is empty
+ */
+double RunningStats::recentMean() const
+{
+    if (m_windowCount == 0) {
+        return 0.0;
+    }
+    double total = 0.0;
+    for (int i = 0; i < m_windowCount; ++i) {
+        total += m_window[i];
+    }
+    return total / m_windowCount;
+}
+
+/**
+ * @brief Builds an aggregate from its data.json representation
+ * @param json Object with count, sum, sumSquares, min, max and recent
+ * @return The parsed aggregate
+ */
+RunningStats RunningStats::fromJson(const QJsonObject& json)
+{
+    RunningStats stats;
+    stats.m_count = std::max<qint64>(0, json["count"].toInteger());
+    if (stats.m_count == 0) {
+        return stats;
+    }
+    stats.m_sum = json["sum"].toDouble();
+    stats.m_sumSquares = json["sumSquares"].toDouble();
+    stats.m_min = json["min"].toDouble();
+    stats.m_max = json["max"].toDouble();
+
+    // Keep the newest values if the file holds more than fit in the window
+    QJsonArray recent = json["recent"].toArray();
+    for (qsizetype i = std::max<qsizetype>(0, recent.size() - WINDOW_SIZE); i < recent.size(); ++i) {
+        stats.m_window[stats.m_windowNext] = recent[i].toDouble();
+        stats.m_windowNext = (stats.m_windowNext + 1) % WINDOW_SIZE;
+        ++stats.m_windowCount;
+    }
+    return stats;
+}
+
+/**
+ * @brief Converts the aggregate to its data.json representation
+ * @return Object with count, sum, sumSquares, min, max and recent
+ */
+QJsonObject RunningStats::toJson() const
+{
+    QJsonArray recentValues;
+    for (double value : recent()) {
+        recentValues.append(value);
+    }
+    return QJsonObject{
+        {"count", m_count},
+        {"sum", m_sum},
+        {"sumSquares", m_sumSquares},
+        {"min", m_min},
+        {"max", m_max},
+        {"recent", recentValues}
+    };
+}
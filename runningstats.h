@@ -0,0 +1,181 @@
+/**
+ * @file runningstats.h
+ * @brief Header file for the RunningStats class
+ * @author Alan Cruz, Bashar Hamo
+ * @details This file defines RunningStats, a constant-size summary of a series of
+ *          values, and TopicStatistics, the per-topic lesson statistics built from it.
+ *          They replace the ever-growing arrays that data.json used to keep for every
+ *          lesson topic.
+ */
+
+#ifndef RUNNINGSTATS_H
+#define RUNNINGSTATS_H
+
+#include <QJsonObject>
+#include <QList>
+
+/**
+ * @brief Running aggregate of a series of values
+ * @details Keeps the count, sum, sum of squares, minimum and maximum of every value
+ *          added so far, plus the last WINDOW_SIZE values. Adding a value and reading
+ *          any aggregate are constant time, no matter how long the series gets.
+ */
+class RunningStats {
+public:
+    static constexpr int WINDOW_SIZE = 10;  ///< Number of recent values that are kept
+
+    /**
+     * @brief Default constructor
+     * @details Creates an empty aggregate.
+     */
+    RunningStats() = default;
+
+    /**
+     * @brief Adds a value to the series
+     * @param value The new value
+     */
+    void add(double value);
+
+    /**
+     * @brief Adds all values of another series
+     * @param other The series to add
+     * @details The aggregates are exact. The recent values of other follow those of
+     *          this series, as if its values had been added last.
+     */
+    void merge(const RunningStats& other);
+
+    /**
+     * @brief Gets the number of values added
+     * @return The number of values
+     */
+    qint64 count() const { return m_count; }
+
+    /**
+     * @brief Gets the sum of all values
+     * @return The sum, 0 if the series is empty
+     */
+    double sum() const { return m_sum; }
+
+    /**
+     * @brief Gets the mean of all values
+     * @return The mean, 0 if the series is empty
+     */
+    double mean() const;
+
+    /**
+     * @brief Gets the population variance of all values
+     * @return The variance, 0 if the series is empty
+     */
+    double variance() const;
+
+    /**
+     * @brief Gets the smallest value
+     * @return The minimum, 0 if the series is empty
+     */
+    double min() const { return m_min; }
+
+    /**
+     * @brief Gets the largest value
+     * @return The maximum, 0 if the series is empty
+     */
+    double max() const { return m_max; }
+
+    /**
+     * @brief Gets the most recent values
+     * @return Up to WINDOW_SIZE values, oldest first
+     */
+    QList<double> recent() const;
+
+    /**
+     * @brief Gets the mean of the most recent values
+     * @return The mean of recent(), 0 if the series is empty
+     */
+    double recentMean() const;
+
+    /**
+     * @brief Builds an aggregate from its data.json representation
+     * @param json Object with count, sum, sumSquares, min, max and recent
+     * @return The parsed aggregate
+     */
+    static RunningStats fromJson(const QJsonObject& json);
+
+    /**
+     * @brief Converts the aggregate to its data.json representation
+     * @return Object with count, sum, sumSquares, min, max and recent
+     */
+    QJsonObject toJson() const;
+
+private:
+    qint64 m_count = 0;              ///< Number of values added
+    double m_sum = 0.0;              ///< Sum of all values
+    double m_sumSquares = 0.0;       ///< Sum of the squares of all values
+    double m_min = 0.0;              ///< Smallest value
+    double m_max = 0.0;              ///< Largest value
+    double m_window[WINDOW_SIZE] = {};  ///< Ring buffer of the most recent values
+    int m_windowNext = 0;            ///< Ring buffer slot the next value goes to
+    int m_windowCount = 0;           ///< Number of values in the ring buffer
+};
+
+/**
+ * @brief Statistics of one lesson topic
+ * @details Stored in data.json under lessons/topics/<id>/statistics. The number of
+ *          completed lessons is scores.count().
+ */
+struct TopicStatistics {
+    RunningStats scores;     ///< Final score of every completed lesson
+    RunningStats accuracy;   ///< Accuracy percentage of every completed lesson
+    RunningStats attempts;   ///< Attempts of every completed lesson
+
+    /**
+     * @brief Adds a completed lesson
+     * @param score The score achieved
+     * @param accuracyValue The accuracy percentage
+     * @param attemptCount The number of attempts made
+     */
+    void add(int score, double accuracyValue, int attemptCount)
+    {
+        scores.add(score);
+        accuracy.add(accuracyValue);
+        attempts.add(attemptCount);
+    }
+
+    /**
+     * @brief Adds the lessons of other statistics of the same topic
+     * @param other The statistics to add, e.g. of another player
+     */
+    void merge(const TopicStatistics& other)
+    {
+        scores.merge(other.scores);
+        accuracy.merge(other.accuracy);
+        attempts.merge(other.attempts);
+    }
+
+    /**
+     * @brief Builds topic statistics from their data.json representation
+     * @param json The statistics object of a topic
+     * @return The parsed statistics
+     */
+    static TopicStatistics fromJson(const QJsonObject& json)
+    {
+        TopicStatistics stats;
+        stats.scores = RunningStats::fromJson(json["scores"].toObject());
+        stats.accuracy = RunningStats::fromJson(json["accuracy"].toObject());
+        stats.attempts = RunningStats::fromJson(json["attempts"].toObject());
+        return stats;
+    }
+
+    /**
+     * @brief Converts topic statistics to their data.json representation
+     * @return The statistics object of a topic
+     */
+    QJsonObject toJson() const
+    {
+        return QJsonObject{
+            {"scores", scores.toJson()},
+            {"accuracy", accuracy.toJson()},
+            {"attempts", attempts.toJson()}
+        };
+    }
+};
+
+#endif // RUNNINGSTATS_H
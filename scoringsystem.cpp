@@ -1,4 +1,62 @@
 #include "scoringsystem.h"
+#include <algorithm>
+#include <cstdlib>
+
+/*!
+ * \brief Moves a weighted accuracy towards a new result.
+ * \param weighted The accuracy to update.
+ * \param count Results recorded before this one; the first result is taken as is.
+ * \param result 1 for a success, 0 for a failure.
+ */
+static void smooth(float& weighted, quint32 count, float result)
+{
+    weighted = count == 0 ? result : weighted + ScoringSystem::SMOOTHING * (result - weighted);
+}
+
+/*!
+ * \brief Finds the pitch class of a mask closest to a pitch class around the octave.
+ * \param pitchClass The pitch class to search from.
+ * \param mask The candidates; must not be empty.
+ * \return The nearest candidate; the lower one on a tie.
+ */
+static int nearestPitchClass(int pitchClass, quint16 mask)
+{
+    int best = -1;
+    int bestDistance = ScoringSystem::PITCH_CLASS_COUNT;
+    for (quint16 bits = mask; bits; bits &= bits - 1) {
+        const int candidate = qCountTrailingZeroBits(bits);
+        const int distance = std::abs(candidate - pitchClass);
+        const int around = std::min(distance, ScoringSystem::PITCH_CLASS_COUNT - distance);
+        if (around < bestDistance) {
+            best = candidate;
+            bestDistance = around;
+        }
+    }
+    return best;
+}
+
+/*!
+ * \brief Finds the MIDI note of a mask closest to a MIDI note.
+ * \param note The note to search from.
+ * \param mask The candidates, notes 0-63 then 64-127; must not be empty.
+ * \return The nearest candidate; the lower one on a tie.
+ */
+static int nearestMidiNote(int note, const quint64 mask[2])
+{
+    int best = -1;
+    int bestDistance = NoteTable::NOTE_COUNT;
+    for (int half = 0; half < 2; ++half) {
+        for (quint64 bits = mask[half]; bits; bits &= bits - 1) {
+            const int candidate = half * 64 + qCountTrailingZeroBits(bits);
+            const int distance = std::abs(candidate - note);
+            if (distance < bestDistance) {
+                best = candidate;
+                bestDistance = distance;
+            }
+        }
+    }
+    return best;
+}
 
 /*!
  * \brief The constructor of the ScoringSystem object.
@@ -14,16 +72,18 @@ ScoringSystem::~ScoringSystem() {}
  * \brief Compares two notes together and checks if they are equal. If they are, increment the number of correct inputs.
  * \param inputNote The note input by the user through the Keyboard object.
  * \param expectedNote The note currently expected by the lesson/quiz.
- * \return Returns 0 if no error occurs (inputNote and expectedNote) are within the expected range (60 - 72), -1 otherwise.
+ * \return Returns 0 if no error occurs (inputNote and expectedNote) are valid MIDI notes (0 - 127), -1 otherwise.
  */
 int ScoringSystem::evaluate(unsigned int inputNote, unsigned int expectedNote) {
-    // Checking that inputNote and expectedNote are valid notes with the expected range of note values. This will help catch errors.
-    if (inputNote < minNoteValue || inputNote > maxNoteValue) return -1;
-    if (expectedNote < minNoteValue || expectedNote > maxNoteValue) return -1;
+    // Checking that inputNote and expectedNote are valid MIDI notes. This will help catch errors.
+    if (!NoteTable::isValid(static_cast<int>(inputNote))) return -1;
+    if (!NoteTable::isValid(static_cast<int>(expectedNote))) return -1;
 
     // Updating key press counters, based on whether the input and expected keys are the same or not.
     totalKeyPresses++;
     if (inputNote == expectedNote) correctKeyPresses++;
+    pitchClassMatrix[expectedNote % 12][inputNote % 12]++;
+    midiMatrix[expectedNote][inputNote]++;
 
     // Calculating the new overall accuracy.
     accuracy = (float)correctKeyPresses / totalKeyPresses;
@@ -62,6 +122,17 @@ void ScoringSystem::reset() {
     accuracy = 0.0f;
     totalKeyPresses = 0;
     correctKeyPresses = 0;
+    for (auto& row : pitchClassMatrix) row.fill(0);
+    for (auto& row : midiMatrix) row.fill(0);
+    responseBuckets.fill(0);
+    for (auto& buckets : questionResponseBuckets) buckets.fill(0);
+    weightedAccuracy = 0.0f;
+    attempts = 0;
+    pitchClassWeighted.fill(0.0f);
+    pitchClassAttempts.fill(0);
+    topicWeighted.fill(0.0f);
+    topicAttempts.fill(0);
+    weakMask = 0;
 }
 
 /*!
@@ -79,3 +150,188 @@ unsigned int ScoringSystem::rate() {
     }
     return 0;   // If, for some reason, the algorithm cannot calculate a rating, the method returns a default of zero stars.
 }
+
+/*!
+ * \brief Reserves a response-time histogram for every question ID.
+ * \param questionIDs One more than the largest question ID.
+ */
+void ScoringSystem::setQuestionCapacity(int questionIDs) {
+    questionResponseBuckets.assign(static_cast<size_t>(std::max(0, questionIDs)), {});
+}
+
+/*!
+ * \brief Counts what was played for each expected note of one attempt.
+ * \param expected The notes asked for.
+ * \param played The notes played.
+ * \return Mask of the expected pitch classes that were played.
+ * \details Also updates the key press counters. The work is bounded by the number of notes in the two sets.
+ */
+quint16 ScoringSystem::countConfusions(const NoteSet& expected, const NoteSet& played) {
+    // Pitch classes
+    const quint16 asked = expected.pitchClassMask();
+    const quint16 heard = asked & played.pitchClassMask();
+    const quint16 missing = asked & ~heard;
+    quint16 substituted = 0;
+    for (quint16 bits = heard; bits; bits &= bits - 1) {
+        const int pitchClass = qCountTrailingZeroBits(bits);
+        pitchClassMatrix[pitchClass][pitchClass]++;
+    }
+    for (quint16 bits = played.pitchClassMask() & ~asked; bits; bits &= bits - 1) {
+        const int wrong = qCountTrailingZeroBits(bits);
+        const int target = nearestPitchClass(wrong, missing ? missing : asked);
+        pitchClassMatrix[target][wrong]++;
+        substituted |= static_cast<quint16>(1u << target);
+    }
+    for (quint16 bits = missing & ~substituted; bits; bits &= bits - 1) {
+        pitchClassMatrix[qCountTrailingZeroBits(bits)][PITCH_CLASS_MISSED]++;
+    }
+
+    // MIDI notes
+    const quint64 askedMidi[2] = {expected.midiMask(0), expected.midiMask(1)};
+    quint64 missingMidi[2] = {askedMidi[0] & ~played.midiMask(0), askedMidi[1] & ~played.midiMask(1)};
+    const bool anyMissing = missingMidi[0] || missingMidi[1];
+    quint64 substitutedMidi[2] = {0, 0};
+    unsigned int hits = 0;
+    for (int half = 0; half < 2; ++half) {
+        for (quint64 bits = played.midiMask(half); bits; bits &= bits - 1) {
+            const int note = half * 64 + qCountTrailingZeroBits(bits);
+            if (askedMidi[half] & (quint64(1) << (note % 64))) {
+                midiMatrix[note][note]++;
+                hits++;
+                continue;
+            }
+            const int target = nearestMidiNote(note, anyMissing ? missingMidi : askedMidi);
+            midiMatrix[target][note]++;
+            substitutedMidi[target / 64] |= quint64(1) << (target % 64);
+        }
+    }
+    for (int half = 0; half < 2; ++half) {
+        for (quint64 bits = missingMidi[half] & ~substitutedMidi[half]; bits; bits &= bits - 1) {
+            midiMatrix[half * 64 + qCountTrailingZeroBits(bits)][MIDI_MISSED]++;
+        }
+    }
+
+    totalKeyPresses += static_cast<unsigned int>(played.size());
+    correctKeyPresses += hits;
+    accuracy = totalKeyPresses ? (float)correctKeyPresses / totalKeyPresses : 0.0f;
+    return heard;
+}
+
+/*!
+ * \brief Adds a response time to the histograms.
+ * \param questionID The question answered, or -1.
+ * \param responseMs Time from the question to the answer in milliseconds.
+ */
+void ScoringSystem::countResponse(int questionID, qint64 responseMs) {
+    const quint64 steps = static_cast<quint64>(std::max<qint64>(responseMs / RESPONSE_BUCKET_MS, 1));
+    const int bucket = std::min(63 - static_cast<int>(qCountLeadingZeroBits(steps)), RESPONSE_BUCKETS - 1);
+    responseBuckets[bucket]++;
+    if (questionID >= 0 && questionID < static_cast<int>(questionResponseBuckets.size())) {
+        quint16& count = questionResponseBuckets[questionID][bucket];
+        if (count < 0xffff) count++;
+    }
+}
+
+/*!
+ * \brief Records one attempt at a question.
+ * \param questionID The question, or -1.
+ * \param topicID The question's topic.
+ * \param expected The notes the question asks for.
+ * \param played The notes played, empty if not known.
+ * \param correct Whether the attempt answered the question.
+ * \param responseMs Time from the question to the answer in milliseconds, -1 if not known.
+ * \details Constant time: the weak spots are re-derived from the twelve pitch-class accuracies.
+ */
+void ScoringSystem::evaluateAttempt(int questionID, int topicID, const NoteSet& expected, const NoteSet& played,
+                                    bool correct, qint64 responseMs) {
+    const quint16 asked = expected.pitchClassMask();
+    const quint16 heard = played.isEmpty() ? (correct ? asked : 0) : countConfusions(expected, played);
+
+    for (quint16 bits = asked; bits; bits &= bits - 1) {
+        const int pitchClass = qCountTrailingZeroBits(bits);
+        smooth(pitchClassWeighted[pitchClass], pitchClassAttempts[pitchClass], (heard >> pitchClass) & 1 ? 1.0f : 0.0f);
+        pitchClassAttempts[pitchClass]++;
+    }
+    weakMask = 0;
+    for (int pitchClass = 0; pitchClass < PITCH_CLASS_COUNT; ++pitchClass) {
+        if (pitchClassAttempts[pitchClass] >= WEAK_MIN_ATTEMPTS && pitchClassWeighted[pitchClass] < WEAK_ACCURACY) {
+            weakMask |= static_cast<quint16>(1u << pitchClass);
+        }
+    }
+
+    smooth(weightedAccuracy, attempts, correct ? 1.0f : 0.0f);
+    attempts++;
+    const int topic = topicID - FIRST_TOPIC_ID;
+    if (topic >= 0 && topic < TOPIC_COUNT) {
+        smooth(topicWeighted[topic], topicAttempts[topic], correct ? 1.0f : 0.0f);
+        topicAttempts[topic]++;
+    }
+
+    if (responseMs >= 0) {
+        countResponse(questionID, responseMs);
+    }
+}
+
+/*!
+ * \brief Returns the pitch class most often played instead of an expected one.
+ * \param expected The pitch class asked for (0-11).
+ * \return The pitch class, or -1 if no other pitch class was played for it.
+ */
+int ScoringSystem::mostConfusedWith(int expected) const {
+    int best = -1;
+    quint32 bestCount = 0;
+    for (int played = 0; played < PITCH_CLASS_COUNT; ++played) {
+        if (played != expected && pitchClassMatrix[expected][played] > bestCount) {
+            best = played;
+            bestCount = pitchClassMatrix[expected][played];
+        }
+    }
+    return best;
+}
+
+/*!
+ * \brief Returns the exponentially weighted accuracy of a topic.
+ * \param topicID The topic.
+ * \return The accuracy from 0 to 1, 0 for unknown topics.
+ */
+float ScoringSystem::getTopicAccuracy(int topicID) const {
+    const int topic = topicID - FIRST_TOPIC_ID;
+    return topic >= 0 && topic < TOPIC_COUNT ? topicWeighted[topic] : 0.0f;
+}
+
+/*!
+ * \brief Finds the median of a response-time histogram.
+ * \param buckets The histogram.
+ * \return The geometric middle of the bucket holding the median in milliseconds, or -1 if the histogram is empty.
+ */
+template <typename Counter>
+qint64 ScoringSystem::medianOf(const std::array<Counter, RESPONSE_BUCKETS>& buckets) {
+    quint64 total = 0;
+    for (Counter count : buckets) total += count;
+    if (total == 0) return -1;
+
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < RESPONSE_BUCKETS; ++bucket) {
+        seen += buckets[bucket];
+        if (seen * 2 >= total) {
+            // Bucket b spans a factor of two from RESPONSE_BUCKET_MS << b
+            return static_cast<qint64>((RESPONSE_BUCKET_MS << bucket) * 1.4142135);
+        }
+    }
+    return RESPONSE_BUCKET_MS << (RESPONSE_BUCKETS - 1);
+}
+
+/*!
+ * \brief Returns the median response time.
+ * \param questionID The question, or -1 for all questions.
+ * \return The median in milliseconds, accurate to the histogram bucket; -1 if nothing was recorded.
+ */
+qint64 ScoringSystem::medianResponseMs(int questionID) const {
+    if (questionID < 0) {
+        return medianOf(responseBuckets);
+    }
+    if (questionID >= static_cast<int>(questionResponseBuckets.size())) {
+        return -1;
+    }
+    return medianOf(questionResponseBuckets[questionID]);
+}
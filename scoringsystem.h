@@ -1,25 +1,115 @@
+#ifndef SCORINGSYSTEM_H
+#define SCORINGSYSTEM_H
+
+#include <array>
+#include <vector>
+#include <QtGlobal>
+#include "notetable.h"
+#include "noteset.h"
+
+/*!
+ * \brief Streaming analytics of the notes a player is asked for and plays.
+ * \details Every evaluation updates fixed-size counters in constant time and without
+ *          allocating: an expected x played confusion matrix by pitch class and by MIDI
+ *          note, log-bucketed response-time histograms per question and overall, and
+ *          exponentially weighted accuracies per pitch class, per topic and overall.
+ *          Weak spots are the pitch classes whose weighted accuracy is below
+ *          WEAK_ACCURACY; they are kept up to date by every evaluation, so reading them
+ *          never rescans a history.
+ *
+ *          A played note that was not asked for is counted against the nearest expected
+ *          note that was not played (or the nearest expected note if all were played),
+ *          so playing F# for F lands in row F, column F#. An expected note that nothing
+ *          was played for is counted in the MISSED column of its row.
+ */
 class ScoringSystem {
+public:
+    static constexpr int PITCH_CLASS_COUNT = 12;                  /*!< Rows of the pitch-class matrix. */
+    static constexpr int PITCH_CLASS_MISSED = PITCH_CLASS_COUNT;  /*!< Column of pitch classes asked for but not played. */
+    static constexpr int MIDI_MISSED = NoteTable::NOTE_COUNT;     /*!< Column of MIDI notes asked for but not played. */
+    static constexpr int TOPIC_COUNT = 6;                         /*!< Topics with a weighted accuracy, from FIRST_TOPIC_ID. */
+    static constexpr int FIRST_TOPIC_ID = 101;                    /*!< Topic of the first weighted accuracy. */
+    static constexpr int RESPONSE_BUCKETS = 16;                   /*!< Buckets of a response-time histogram. */
+    static constexpr qint64 RESPONSE_BUCKET_MS = 64;              /*!< Bucket b counts answers from RESPONSE_BUCKET_MS << b ms; bucket 0 also the faster ones. */
+    static constexpr float SMOOTHING = 0.2f;                      /*!< Weight of the newest result in a weighted accuracy. */
+    static constexpr float WEAK_ACCURACY = 0.6f;                  /*!< Weighted accuracy below which a pitch class is a weak spot. */
+    static constexpr quint32 WEAK_MIN_ATTEMPTS = 3;               /*!< Attempts at a pitch class before it can be a weak spot. */
+
 private:
     float accuracy = 0.0f; /*!< The overall accuracy of the user's current session, as a percentage. Default is 0. */
     unsigned int totalKeyPresses = 0; /*!< The total number of Keyboard key presses the user has made during the current session. */
     unsigned int correctKeyPresses = 0; /*!< The total number of correct key presses the user has made during the current session. */
 
-    const unsigned int maxNoteValue = 72; /*!< The maximum key value recognized by the program. */
-    const unsigned int minNoteValue = 60; /*!< The minimum key value recognized by the program. */
+    std::array<std::array<quint32, PITCH_CLASS_COUNT + 1>, PITCH_CLASS_COUNT> pitchClassMatrix{}; /*!< Expected x played pitch classes, plus MISSED. */
+    std::array<std::array<quint32, NoteTable::NOTE_COUNT + 1>, NoteTable::NOTE_COUNT> midiMatrix{}; /*!< Expected x played MIDI notes, plus MISSED. */
+
+    std::array<quint32, RESPONSE_BUCKETS> responseBuckets{}; /*!< Response times of all questions. */
+    std::vector<std::array<quint16, RESPONSE_BUCKETS>> questionResponseBuckets; /*!< Response times per question ID; saturating. */
+
+    float weightedAccuracy = 0.0f; /*!< Exponentially weighted share of correct attempts. */
+    quint32 attempts = 0; /*!< Attempts evaluated with evaluateAttempt(). */
+    std::array<float, PITCH_CLASS_COUNT> pitchClassWeighted{}; /*!< Weighted share of each expected pitch class that was played. */
+    std::array<quint32, PITCH_CLASS_COUNT> pitchClassAttempts{}; /*!< Attempts that asked for each pitch class. */
+    std::array<float, TOPIC_COUNT> topicWeighted{}; /*!< Weighted share of correct attempts per topic. */
+    std::array<quint32, TOPIC_COUNT> topicAttempts{}; /*!< Attempts per topic. */
+    quint16 weakMask = 0; /*!< Bit n set while pitch class n is a weak spot. */
+
+    /*!
+     * \brief Counts what was played for each expected note of one attempt.
+     * \param expected The notes asked for.
+     * \param played The notes played.
+     * \return Mask of the expected pitch classes that were played.
+     */
+    quint16 countConfusions(const NoteSet& expected, const NoteSet& played);
+
+    /*!
+     * \brief Adds a response time to the histograms.
+     * \param questionID The question answered, or -1.
+     * \param responseMs Time from the question to the answer in milliseconds.
+     */
+    void countResponse(int questionID, qint64 responseMs);
+
+    /*!
+     * \brief Finds the median of a response-time histogram.
+     * \param buckets The histogram.
+     * \return The middle of the bucket holding the median in milliseconds, or -1 if the histogram is empty.
+     */
+    template <typename Counter>
+    static qint64 medianOf(const std::array<Counter, RESPONSE_BUCKETS>& buckets);
+
 public:
     /*!
      * \brief The constructor of the ScoringSystem object.
      */
     ScoringSystem();
 
+    /*!
+     * \brief Reserves a response-time histogram for every question ID.
+     * \param questionIDs One more than the largest question ID; answers to larger IDs only count overall.
+     * \details Allocates once, so evaluations never allocate.
+     */
+    void setQuestionCapacity(int questionIDs);
+
     /*!
      * \brief Checks if the values corresponding to two notes are the same; if they are, increment 'correctKeyPresses.'
      * \param inputNote The note input by the user.
      * \param expectedNote The correct note, expected by the user.
-     * \return Returns 0 if no error occurs (inputNote and expectedNote) are within the expected range (60 - 72), -1 otherwise.
+     * \return Returns 0 if no error occurs (inputNote and expectedNote) are valid MIDI notes (0 - 127), -1 otherwise.
      */
     int evaluate(unsigned int inputNote, unsigned int expectedNote);
 
+    /*!
+     * \brief Records one attempt at a question.
+     * \param questionID The question, or -1.
+     * \param topicID The question's topic.
+     * \param expected The notes the question asks for.
+     * \param played The notes played; empty if they are not known, in which case every expected note counts as played when the attempt was correct.
+     * \param correct Whether the attempt answered the question.
+     * \param responseMs Time from the question to the answer in milliseconds, -1 if not known.
+     */
+    void evaluateAttempt(int questionID, int topicID, const NoteSet& expected, const NoteSet& played,
+                         bool correct, qint64 responseMs = -1);
+
     /*!
      * \brief Sets the attributes of the ScoringSystem object back to their default values.
      */
@@ -49,8 +139,72 @@ public:
      */
     unsigned int rate();
 
+    /*!
+     * \brief Returns how often a pitch class was played for an expected one.
+     * \param expected The pitch class asked for (0-11).
+     * \param played The pitch class played (0-11), or PITCH_CLASS_MISSED.
+     * \return The count.
+     */
+    quint32 pitchClassConfusion(int expected, int played) const { return pitchClassMatrix[expected][played]; }
+
+    /*!
+     * \brief Returns how often a MIDI note was played for an expected one.
+     * \param expected The MIDI note asked for (0-127).
+     * \param played The MIDI note played (0-127), or MIDI_MISSED.
+     * \return The count.
+     */
+    quint32 midiConfusion(int expected, int played) const { return midiMatrix[expected][played]; }
+
+    /*!
+     * \brief Returns the pitch class most often played instead of an expected one.
+     * \param expected The pitch class asked for (0-11).
+     * \return The pitch class, or -1 if no other pitch class was played for it.
+     */
+    int mostConfusedWith(int expected) const;
+
+    /*!
+     * \brief Returns the exponentially weighted accuracy of all attempts.
+     * \return The accuracy from 0 to 1, 0 before the first attempt.
+     */
+    float getWeightedAccuracy() const { return weightedAccuracy; }
+
+    /*!
+     * \brief Returns the exponentially weighted accuracy of a pitch class.
+     * \param pitchClass The pitch class (0-11).
+     * \return The share of recent attempts that played it when asked, from 0 to 1.
+     */
+    float getPitchClassAccuracy(int pitchClass) const { return pitchClassWeighted[pitchClass]; }
+
+    /*!
+     * \brief Returns the exponentially weighted accuracy of a topic.
+     * \param topicID The topic.
+     * \return The accuracy from 0 to 1, 0 for unknown topics.
+     */
+    float getTopicAccuracy(int topicID) const;
+
+    /*!
+     * \brief Returns the weak spots.
+     * \return Bit n set if pitch class n is a weak spot.
+     */
+    quint16 weakPitchClasses() const { return weakMask; }
+
+    /*!
+     * \brief Returns the median response time.
+     * \param questionID The question, or -1 for all questions.
+     * \return The median in milliseconds, accurate to the histogram bucket; -1 if nothing was recorded.
+     */
+    qint64 medianResponseMs(int questionID = -1) const;
+
+    /*!
+     * \brief Returns the number of attempts evaluated with evaluateAttempt().
+     * \return The count.
+     */
+    quint32 getAttempts() const { return attempts; }
+
     /*!
      * \brief The destructor of the ScoringSystem object.
      */
     ~ScoringSystem();
 };
+
+#endif // SCORINGSYSTEM_H
@@ -0,0 +1,100 @@
+/**
+ * @file screenlayout.cpp
+ * @brief Implementation of the ScreenLayout class
+ * @author Alan Cruz
+ * @details This file implements recording the design geometry of the main window
+ *          and scaling it to the screen in one pass.
+ */
+
+#include "screenlayout.h"
+#include "mathutils.h"
+#include <QLayout>
+
+/**
+ * @brief Records the design geometry of the widgets under a root
+ * @param root The widget whose descendants are scaled
+ */
+ScreenLayout::ScreenLayout(QWidget* root)
+    : m_root(root)
+{
+    if (!m_root) {
+        return;
+    }
+
+    const QList<QWidget*> widgets = m_root->findChildren<QWidget*>();
+    m_items.reserve(widgets.size());
+    for (QWidget* widget : widgets) {
+        if (isPlaced(widget) && !widget->objectName().isEmpty()
+                && !widget->objectName().startsWith(QLatin1String("qt_"))) {
+            m_items.push_back({widget, widget->geometry()});
+            m_recorded.insert(widget);
+        }
+    }
+}
+
+/**
+ * @brief Gets the size the pages are scaled to for an available area
+ * @param available Logical size of the screen or window
+ * @return The size, shrunk to MAX_WIDTH x MAX_HEIGHT keeping its aspect ratio
+ */
+QSize ScreenLayout::targetSize(const QSize& available)
+{
+    if (available.width() > MAX_WIDTH || available.height() > MAX_HEIGHT) {
+        const double scale = qMin(double(MAX_WIDTH) / available.width(), double(MAX_HEIGHT) / available.height());
+        return QSize(available.width() * scale, available.height() * scale);
+    }
+    return available;
+}
+
+/**
+ * @brief Scales all recorded widgets to a size
+ * @param size Size of the root
+ * @return true if the widgets were moved, false if they already had this size
+ * @details Runtime children that fill their parent are found before anything
+ *          moves, and given their parent's new rectangle afterwards.
+ */
+bool ScreenLayout::apply(const QSize& size)
+{
+    if (!m_root || size.isEmpty() || size == m_size) {
+        return false;
+    }
+    m_size = size;
+
+    QList<QWidget*> fillers;
+    const QList<QWidget*> widgets = m_root->findChildren<QWidget*>();
+    for (QWidget* widget : widgets) {
+        if (!m_recorded.contains(widget) && isPlaced(widget)
+                && widget->geometry() == widget->parentWidget()->rect()) {
+            fillers.append(widget);
+        }
+    }
+
+    const QSize designSize(DESIGN_WIDTH, DESIGN_HEIGHT);
+    m_root->setUpdatesEnabled(false);
+    m_root->setGeometry(0, 0, size.width(), size.height());
+    for (const Item& item : m_items) {
+        if (!item.widget) {
+            continue;
+        }
+        const QRect scaled = MathUtils::scaleRect(item.designRect, size, designSize);
+        if (item.widget->geometry() != scaled) {
+            item.widget->setGeometry(scaled);
+        }
+    }
+    for (QWidget* widget : fillers) {
+        widget->setGeometry(widget->parentWidget()->rect());
+    }
+    m_root->setUpdatesEnabled(true);
+    return true;
+}
+
+/**
+ * @brief Checks whether a widget is placed by hand rather than by a layout or by Qt
+ * @param widget The widget
+ * @return true if its geometry can be scaled
+ */
+bool ScreenLayout::isPlaced(const QWidget* widget)
+{
+    const QWidget* parent = widget->parentWidget();
+    return !widget->isWindow() && parent && !parent->layout();
+}
@@ -0,0 +1,98 @@
+/**
+ * @file screenlayout.h
+ * @brief Header file for the ScreenLayout class
+ * @author Alan Cruz
+ * @details This file defines ScreenLayout, which scales every page of the main
+ *          window from the geometry it was designed at to the size of the screen.
+ */
+
+#ifndef SCREENLAYOUT_H
+#define SCREENLAYOUT_H
+
+#include <QPointer>
+#include <QRect>
+#include <QSet>
+#include <QSize>
+#include <QWidget>
+#include <vector>
+
+/**
+ * @brief Resolution-independent placement of the widgets of the main window
+ * @details The design rectangle of every widget under the root is recorded once,
+ *          when the layout is created right after setupUi(), so it is the geometry
+ *          from the .ui file at 1920x1080. apply() computes all scaled rectangles
+ *          from those records, never from the current geometry, so applying it
+ *          again does not compound and a widget added to the .ui is covered
+ *          without being listed anywhere.
+ *
+ *          Widgets managed by a QLayout are left to their layout. Widgets added
+ *          at runtime that fill their parent, such as the piano in its
+ *          placeholder, are resized with it.
+ *
+ *          apply() does nothing if the size did not change and otherwise moves
+ *          all widgets with updates disabled, so a new screen or pixel ratio
+ *          costs one repaint.
+ */
+class ScreenLayout
+{
+public:
+    static constexpr int DESIGN_WIDTH = 1920;   ///< Width the .ui file is designed at
+    static constexpr int DESIGN_HEIGHT = 1080;  ///< Height the .ui file is designed at
+    static constexpr int MAX_WIDTH = 3840;      ///< Widest size the pages are scaled to
+    static constexpr int MAX_HEIGHT = 2160;     ///< Tallest size the pages are scaled to
+
+    /**
+     * @brief Records the design geometry of the widgets under a root
+     * @param root The widget whose descendants are scaled; it is itself placed at the origin
+     */
+    explicit ScreenLayout(QWidget* root);
+
+    /**
+     * @brief Gets the size the pages are scaled to for an available area
+     * @param available Logical size of the screen or window
+     * @return The size, shrunk to MAX_WIDTH x MAX_HEIGHT keeping its aspect ratio
+     */
+    static QSize targetSize(const QSize& available);
+
+    /**
+     * @brief Scales all recorded widgets to a size
+     * @param size Size of the root, usually from targetSize()
+     * @return true if the widgets were moved, false if they already had this size
+     */
+    bool apply(const QSize& size);
+
+    /**
+     * @brief Gets the size last applied
+     * @return The size, empty before the first apply()
+     */
+    QSize size() const { return m_size; }
+
+    /**
+     * @brief Gets the number of recorded widgets
+     * @return The count
+     */
+    int widgetCount() const { return static_cast<int>(m_items.size()); }
+
+private:
+    /**
+     * @brief A widget and the rectangle it was designed at
+     */
+    struct Item {
+        QPointer<QWidget> widget;  ///< The widget; null once it is deleted
+        QRect designRect;          ///< Geometry in its parent at DESIGN_WIDTH x DESIGN_HEIGHT
+    };
+
+    /**
+     * @brief Checks whether a widget is placed by hand rather than by a layout or by Qt
+     * @param widget The widget
+     * @return true if its geometry can be scaled
+     */
+    static bool isPlaced(const QWidget* widget);
+
+    QWidget* m_root;                    // Widget whose descendants are scaled
+    std::vector<Item> m_items;          // Recorded widgets
+    QSet<const QWidget*> m_recorded;    // Widgets of m_items, to tell them from runtime children
+    QSize m_size;                       // Size last applied
+};
+
+#endif // SCREENLAYOUT_H
@@ -0,0 +1,174 @@
+/**
+ * @file sessionlog.cpp
+ * @brief Implementation of the SessionLog class
+ * @author Alan Cruz, Bashar Hamo
+ * @details This file implements reading, appending and compacting the
+ *          line-delimited lesson history.
+ */
+
+#include "sessionlog.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <algorithm>
+#include <map>
+
+/**
+ * @brief Converts an entry to one line of compact JSON
+ * @param entry The entry to convert
+ * @return The JSON text followed by a newline
+ */
+static QByteArray entryToLine(const SessionLog::Entry& entry)
+{
+    QJsonObject json{
+        {"topic", entry.topicId},
+        {"score", entry.score},
+        {"accuracy", entry.accuracy},
+        {"attempts", entry.attempts},
+        {"time", entry.timestamp}
+    };
+    return QJsonDocument(json).toJson(QJsonDocument::Compact) + '\n';
+}
+
+/**
+ * @brief Sets the file the log is stored in
+ * @param filePath Path of the log file
+ */
+void SessionLog::setFilePath(const QString& filePath)
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_filePath = filePath;
+    m_file.setFileName(filePath);
+}
+
+/**
+ * @brief Appends an entry to the end of the log
+ * @param entry The completed lesson
+ * @return true if the entry was written, false otherwise
+ */
+bool SessionLog::append(const Entry& entry)
+{
+    if (m_filePath.isEmpty()) {
+        qDebug() << "SessionLog: No file path set";
+        return false;
+    }
+
+    if (!m_file.isOpen() && !m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "SessionLog: Failed to open session log for appending at:" << m_filePath;
+        return false;
+    }
+
+    QByteArray line = entryToLine(entry);
+    if (m_file.write(line) != line.size() || !m_file.flush()) {
+        qDebug() << "SessionLog: Failed to append to session log at:" << m_filePath;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads every entry of the log
+ * @return The entries, oldest first; unreadable lines are skipped
+ */
+std::vector<SessionLog::Entry> SessionLog::readAll()
+{
+    std::vector<Entry> entries;
+    if (m_file.isOpen()) {
+        m_file.flush();
+    }
+
+    QFile file(m_filePath);
+    if (!file.exists()) {
+        return entries;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "SessionLog: Failed to open session log for reading at:" << m_filePath;
+        return entries;
+    }
+
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonObject json = QJsonDocument::fromJson(line).object();
+        if (!json.contains("topic")) {
+            continue;
+        }
+        Entry entry;
+        entry.topicId = json["topic"].toInt();
+        entry.score = json["score"].toInt();
+        entry.accuracy = json["accuracy"].toDouble();
+        entry.attempts = json["attempts"].toInt();
+        entry.timestamp = json["time"].toInteger();
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+/**
+ * @brief Gets the size of the log file
+ * @return The size in bytes, 0 if the file does not exist
+ */
+qint64 SessionLog::size() const
+{
+    if (m_file.isOpen()) {
+        return m_file.size();
+    }
+    return QFileInfo(m_filePath).size();
+}
+
+/**
+ * @brief Drops old entries from the log
+ * @param keepPerTopic Number of most recent entries kept for every topic
+ * @return true if the log was rewritten or nothing had to be dropped
+ */
+bool SessionLog::compact(int keepPerTopic)
+{
+    std::vector<Entry> entries = readAll();
+
+    // Count per topic how many of the oldest entries have to go
+    std::map<int, int> toDrop;
+    for (const Entry& entry : entries) {
+        ++toDrop[entry.topicId];
+    }
+    bool dropsAny = false;
+    for (auto& topic : toDrop) {
+        topic.second = std::max(0, topic.second - keepPerTopic);
+        dropsAny = dropsAny || topic.second > 0;
+    }
+    if (!dropsAny) {
+        return true;
+    }
+
+    QByteArray output;
+    for (const Entry& entry : entries) {
+        int& drop = toDrop[entry.topicId];
+        if (drop > 0) {
+            --drop;
+            continue;
+        }
+        output.append(entryToLine(entry));
+    }
+
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "SessionLog: Failed to open session log for compaction at:" << m_filePath;
+        return false;
+    }
+    if (file.write(output) != output.size() || !file.commit()) {
+        qDebug() << "SessionLog: Failed to compact session log at:" << m_filePath;
+        return false;
+    }
+
+    qDebug() << "SessionLog: Compacted session log from" << entries.size() << "entries";
+    return true;
+}
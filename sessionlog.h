@@ -0,0 +1,80 @@
+/**
+ * @file sessionlog.h
+ * @brief Header file for the SessionLog class
+ * @author Alan Cruz, Bashar Hamo
+ * @details This file defines SessionLog, the append-only history of completed
+ *          lessons. The log keeps the raw results, while the per-topic aggregates
+ *          shown on the Statistics page live in data.json.
+ */
+
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+
+#include <QFile>
+#include <QString>
+#include <vector>
+
+/**
+ * @brief Append-only log of completed lessons
+ * @details Every entry is one line of compact JSON, so appending never rewrites
+ *          earlier entries and a torn last line only loses that entry. The log is
+ *          opened lazily and kept open for appending. compact() trims old entries;
+ *          it does not change any statistic, since those are kept separately.
+ */
+class SessionLog {
+public:
+    /**
+     * @brief One completed lesson
+     */
+    struct Entry {
+        int topicId = 0;        ///< Topic of the lesson (e.g., 101)
+        int score = 0;          ///< Final score
+        double accuracy = 0.0;  ///< Accuracy percentage
+        int attempts = 0;       ///< Attempts made
+        qint64 timestamp = 0;   ///< Completion time in ms since the epoch, 0 if unknown
+    };
+
+    /**
+     * @brief Constructs a log without a file
+     * @details setFilePath() must be called before entries can be appended.
+     */
+    SessionLog() = default;
+
+    /**
+     * @brief Sets the file the log is stored in
+     * @param filePath Path of the log file
+     */
+    void setFilePath(const QString& filePath);
+
+    /**
+     * @brief Appends an entry to the end of the log
+     * @param entry The completed lesson
+     * @return true if the entry was written, false otherwise
+     */
+    bool append(const Entry& entry);
+
+    /**
+     * @brief Reads every entry of the log
+     * @return The entries, oldest first; unreadable lines are skipped
+     */
+    std::vector<Entry> readAll();
+
+    /**
+     * @brief Gets the size of the log file
+     * @return The size in bytes, 0 if the file does not exist
+     */
+    qint64 size() const;
+
+    /**
+     * @brief Drops old entries from the log
+     * @param keepPerTopic Number of most recent entries kept for every topic
+     * @return true if the log was rewritten or nothing had to be dropped
+     */
+    bool compact(int keepPerTopic);
+
+private:
+    QString m_filePath;  ///< Path of the log file
+    QFile m_file;        ///< Log file, open for appending once the first entry is written
+};
+
+#endif // SESSIONLOG_H
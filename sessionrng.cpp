@@ -0,0 +1,38 @@
+/**
+ * @file sessionrng.cpp
+ * @brief Implementation of the SessionRng class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file implements seeding of the per-session random number generator.
+ */
+
+#include "sessionrng.h"
+#include <QRandomGenerator>
+
+/**
+ * @brief Creates a generator for a seed
+ * @param seed The session seed; the same seed always yields the same sequence
+ * @details Expands the seed into the 256-bit state with splitmix64, which never
+ *          produces the all-zero state xoshiro cannot leave.
+ */
+SessionRng::SessionRng(quint64 seed)
+    : m_seed(seed)
+{
+    quint64 x = seed;
+    for (quint64& word : m_state) {
+        quint64 z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        word = z ^ (z >> 31);
+    }
+}
+
+/**
+ * @brief Draws a fresh seed for a new session
+ * @return A seed from the system's entropy source
+ * @details Only called once per session, so the shared system generator is not
+ *          on any hot path.
+ */
+quint64 SessionRng::randomSeed()
+{
+    return QRandomGenerator::system()->generate64();
+}
@@ -0,0 +1,123 @@
+/**
+ * @file sessionrng.h
+ * @brief Header file for the SessionRng class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file defines SessionRng, the small seeded random number generator
+ *          owned by every quiz and game session so that its question order and
+ *          selections can be replayed from the recorded seed.
+ */
+
+#ifndef SESSIONRNG_H
+#define SESSIONRNG_H
+
+#include <QtGlobal>
+
+/**
+ * @brief Seedable xoshiro256** generator for one session
+ * @details Each GameSession (AdaptiveQuiz, Lessonsgame, MultiplayerGame) owns its own instance,
+ *          so drawing a number is a few arithmetic operations with no locking, and
+ *          a session started with the same seed makes exactly the same choices.
+ *          The 256-bit state is expanded from the 64-bit seed with splitmix64.
+ *
+ *          The class meets the UniformRandomBitGenerator requirements and can be
+ *          passed to std::shuffle and the <random> distributions.
+ */
+class SessionRng
+{
+public:
+    using result_type = quint64;  ///< Type of the generated numbers
+
+    /**
+     * @brief Creates a generator for a seed
+     * @param seed The session seed; the same seed always yields the same sequence
+     */
+    explicit SessionRng(quint64 seed);
+
+    /**
+     * @brief Draws a fresh seed for a new session
+     * @return A seed from the system's entropy source
+     */
+    static quint64 randomSeed();
+
+    /**
+     * @brief Gets the seed the generator was created with
+     * @return The session seed
+     */
+    quint64 seed() const { return m_seed; }
+
+    /**
+     * @brief Generates the next 64-bit number
+     * @return A uniformly distributed 64-bit value
+     */
+    quint64 next()
+    {
+        const quint64 result = rotl(m_state[1] * 5, 7) * 9;
+        const quint64 t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+        return result;
+    }
+
+    /**
+     * @brief Generates a number in [0, bound)
+     * @param bound Exclusive upper limit; must be greater than 0
+     * @return A uniformly distributed value below bound
+     * @details Uses Lemire's multiply-and-reject method, which needs no division
+     *          in the common case.
+     */
+    quint32 bounded(quint32 bound)
+    {
+        quint64 product = quint64(quint32(next() >> 32)) * bound;
+        quint32 low = quint32(product);
+        if (low < bound) {
+            const quint32 threshold = quint32(-bound) % bound;
+            while (low < threshold) {
+                product = quint64(quint32(next() >> 32)) * bound;
+                low = quint32(product);
+            }
+        }
+        return quint32(product >> 32);
+    }
+
+    /**
+     * @brief Generates a floating-point number in [0, 1)
+     * @return A uniformly distributed double
+     */
+    double uniform() { return double(next() >> 11) * 0x1.0p-53; }
+
+    /**
+     * @brief Generates the next number
+     * @return A uniformly distributed 64-bit value
+     */
+    result_type operator()() { return next(); }
+
+    /**
+     * @brief Gets the smallest value operator() can return
+     * @return 0
+     */
+    static constexpr result_type min() { return 0; }
+
+    /**
+     * @brief Gets the largest value operator() can return
+     * @return The largest 64-bit value
+     */
+    static constexpr result_type max() { return ~result_type(0); }
+
+private:
+    /**
+     * @brief Rotates a 64-bit value left
+     * @param x The value to rotate
+     * @param k The number of bits
+     * @return The rotated value
+     */
+    static quint64 rotl(quint64 x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    quint64 m_seed;        ///< Seed the state was expanded from
+    quint64 m_state[4];    ///< xoshiro256** state
+};
+
+#endif // SESSIONRNG_H
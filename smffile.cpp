@@ -0,0 +1,374 @@
+/**
+ * @file smffile.cpp
+ * @brief Implementation of the SmfWriter and SmfReader classes
+ * @author Alan Cruz
+ * @details This file implements writing and reading the chunks and events of
+ *          Standard MIDI Files.
+ */
+
+#include "smffile.h"
+#include <QDebug>
+#include <algorithm>
+
+/// Offset of the length of the first track, after the header chunk and "MTrk"
+static constexpr qint64 SMF_TRACK_LENGTH_OFFSET = 18;
+
+/// Offset of the first event of the first track
+static constexpr qint64 SMF_TRACK_DATA_OFFSET = 22;
+
+/// Largest delta time a variable-length quantity holds
+static constexpr quint32 SMF_MAX_DELTA = 0x0FFFFFFF;
+
+/**
+ * @brief Appends a big-endian integer to a buffer
+ * @param buffer The buffer
+ * @param value The value
+ * @param bytes Number of bytes to write, from the most significant
+ */
+static void appendBigEndian(QByteArray& buffer, quint32 value, int bytes)
+{
+    for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+        buffer.append(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+/**
+ * @brief Reads a big-endian integer from a byte array
+ * @param data The bytes
+ * @param bytes Number of bytes to read
+ * @return The value
+ */
+static quint32 readBigEndian(const char* data, int bytes)
+{
+    quint32 value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | static_cast<quint8>(data[i]);
+    }
+    return value;
+}
+
+/**
+ * @brief Creates the file and writes its header
+ * @param filePath Path of the file; an existing file is replaced
+ * @param startTime MidiEventQueue::now() time of tick 0
+ * @return true if the file was created
+ */
+bool SmfWriter::open(const QString& filePath, qint64 startTime)
+{
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "SmfWriter: Failed to create" << filePath;
+        return false;
+    }
+
+    // Format 0, one track, ticks per quarter note; then the track with its length still 0
+    QByteArray header("MThd");
+    appendBigEndian(header, 6, 4);
+    appendBigEndian(header, 0, 2);
+    appendBigEndian(header, 1, 2);
+    appendBigEndian(header, TICKS_PER_QUARTER, 2);
+    header.append("MTrk");
+    appendBigEndian(header, 0, 4);
+    if (m_file.write(header) != header.size()) {
+        qDebug() << "SmfWriter: Failed to write the header of" << filePath;
+        m_file.close();
+        return false;
+    }
+
+    m_buffer.clear();
+    m_buffer.reserve(BUFFER_BYTES + 16);
+    m_held.reset();
+    m_startTime = startTime;
+    m_lastTick = 0;
+    m_trackBytes = 0;
+    m_notes = 0;
+
+    // Tempo meta event
+    writeVarLen(0);
+    m_buffer.append(static_cast<char>(0xFF));
+    m_buffer.append(static_cast<char>(0x51));
+    m_buffer.append(static_cast<char>(0x03));
+    appendBigEndian(m_buffer, TEMPO_US, 3);
+    return true;
+}
+
+/**
+ * @brief Adds a note-on or note-off event
+ * @param event The event; events before the start time are placed at tick 0
+ */
+void SmfWriter::write(const MidiEvent& event)
+{
+    if (!isOpen() || event.type == MidiEvent::ControlChange) {
+        return;
+    }
+
+    const quint8 key = event.key & 0x7F;
+    writeDelta(event.time);
+    if (event.type == MidiEvent::NoteOn) {
+        m_buffer.append(static_cast<char>(0x90 | (event.channel & 0x0F)));
+        m_buffer.append(static_cast<char>(key));
+        m_buffer.append(static_cast<char>(std::clamp<int>(event.velocity, 1, 127)));
+        m_held.set(key);
+        ++m_notes;
+    } else {
+        m_buffer.append(static_cast<char>(0x80 | (event.channel & 0x0F)));
+        m_buffer.append(static_cast<char>(key));
+        m_buffer.append(static_cast<char>(64));
+        m_held.reset(key);
+    }
+
+    if (m_buffer.size() >= BUFFER_BYTES) {
+        flush();
+    }
+}
+
+/**
+ * @brief Writes the buffered events and the track length
+ * @return true if everything was written
+ */
+bool SmfWriter::flush()
+{
+    if (!isOpen()) {
+        return false;
+    }
+    if (m_buffer.isEmpty()) {
+        return true;
+    }
+
+    const bool written = m_file.write(m_buffer) == m_buffer.size();
+    if (written) {
+        m_trackBytes += static_cast<quint32>(m_buffer.size());
+    }
+    m_buffer.clear();
+
+    QByteArray length;
+    appendBigEndian(length, m_trackBytes, 4);
+    const bool patched = m_file.seek(SMF_TRACK_LENGTH_OFFSET) && m_file.write(length) == length.size()
+            && m_file.seek(SMF_TRACK_DATA_OFFSET + m_trackBytes) && m_file.flush();
+    if (!written || !patched) {
+        qDebug() << "SmfWriter: Failed to write to" << m_file.fileName();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Ends the notes still held, ends the track and closes the file
+ * @param endTime MidiEventQueue::now() time the held notes end at
+ * @return true if everything was written
+ */
+bool SmfWriter::close(qint64 endTime)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    for (int key = 0; key < 128 && m_held.any(); ++key) {
+        if (m_held.test(key)) {
+            MidiEvent off;
+            off.type = MidiEvent::NoteOff;
+            off.key = static_cast<quint8>(key);
+            off.time = endTime;
+            write(off);
+        }
+    }
+
+    // End of track meta event
+    writeVarLen(0);
+    m_buffer.append(static_cast<char>(0xFF));
+    m_buffer.append(static_cast<char>(0x2F));
+    m_buffer.append(static_cast<char>(0x00));
+    const bool ok = flush();
+    m_file.close();
+    return ok;
+}
+
+/**
+ * @brief Appends the delta time of an event at a time
+ * @param time MidiEventQueue::now() time of the event
+ * @details Ticks never go backwards, so an event stamped slightly before the
+ *          previous one follows it directly.
+ */
+void SmfWriter::writeDelta(qint64 time)
+{
+    const qint64 tick = std::max(m_lastTick, (time - m_startTime) / 1000000);
+    writeVarLen(static_cast<quint32>(std::min<qint64>(tick - m_lastTick, SMF_MAX_DELTA)));
+    m_lastTick = tick;
+}
+
+/**
+ * @brief Appends a variable-length quantity
+ * @param value The value, at most 0x0FFFFFFF
+ */
+void SmfWriter::writeVarLen(quint32 value)
+{
+    char bytes[4];
+    int count = 0;
+    bytes[count++] = static_cast<char>(value & 0x7F);
+    while ((value >>= 7) != 0 && count < 4) {
+        bytes[count++] = static_cast<char>((value & 0x7F) | 0x80);
+    }
+    while (count > 0) {
+        m_buffer.append(bytes[--count]);
+    }
+}
+
+/**
+ * @brief Opens a file and finds its first track
+ * @param filePath Path of the file
+ * @return true if the file is a Standard MIDI File with ticks per quarter note
+ */
+bool SmfReader::open(const QString& filePath)
+{
+    m_file.close();
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qDebug() << "SmfReader: Failed to open" << filePath;
+        return false;
+    }
+
+    const QByteArray header = m_file.read(14);
+    if (header.size() != 14 || !header.startsWith("MThd")) {
+        qDebug() << "SmfReader: Not a MIDI file:" << filePath;
+        m_file.close();
+        return false;
+    }
+    const quint32 headerLength = readBigEndian(header.constData() + 4, 4);
+    m_division = static_cast<quint16>(readBigEndian(header.constData() + 12, 2));
+    if (headerLength < 6 || m_division == 0 || (m_division & 0x8000)) {
+        qDebug() << "SmfReader: Unsupported MIDI file:" << filePath;
+        m_file.close();
+        return false;
+    }
+    m_file.seek(8 + headerLength);
+
+    // Skip chunks of other types up to the first track
+    while (true) {
+        const QByteArray chunk = m_file.read(8);
+        if (chunk.size() != 8) {
+            qDebug() << "SmfReader: No track in" << filePath;
+            m_file.close();
+            return false;
+        }
+        const quint32 length = readBigEndian(chunk.constData() + 4, 4);
+        if (chunk.startsWith("MTrk")) {
+            // A length of 0 is a recording that was never flushed; read what is there
+            m_trackEnd = length ? m_file.pos() + length : m_file.size();
+            break;
+        }
+        m_file.seek(m_file.pos() + length);
+    }
+
+    m_nsPerTick = SmfWriter::TEMPO_US * 1000.0 / m_division;
+    m_time = 0.0;
+    m_runningStatus = 0;
+    return true;
+}
+
+/**
+ * @brief Reads the next note event
+ * @param event Receives the event; its time is in nanoseconds from the start of the file
+ * @return true if an event was read, false at the end of the track
+ */
+bool SmfReader::next(MidiEvent& event)
+{
+    quint32 delta = 0;
+    quint8 status = 0;
+    while (m_file.isOpen() && readVarLen(delta) && readByte(status)) {
+        m_time += delta * m_nsPerTick;
+
+        quint8 data1 = 0;
+        if (status < 0x80) {
+            // Running status: the byte read is the first data byte
+            if (!m_runningStatus) {
+                return false;
+            }
+            data1 = status;
+            status = m_runningStatus;
+        } else if (status == 0xFF) {
+            quint8 type = 0;
+            quint32 length = 0;
+            if (!readByte(type) || !readVarLen(length) || type == 0x2F) {
+                return false;
+            }
+            if (type == 0x51 && length == 3) {
+                quint8 tempo[3];
+                if (!readByte(tempo[0]) || !readByte(tempo[1]) || !readByte(tempo[2])) {
+                    return false;
+                }
+                const quint32 usPerQuarter = (quint32(tempo[0]) << 16) | (quint32(tempo[1]) << 8) | tempo[2];
+                m_nsPerTick = usPerQuarter * 1000.0 / m_division;
+            } else {
+                m_file.seek(std::min(m_file.pos() + length, m_trackEnd));
+            }
+            continue;
+        } else if (status == 0xF0 || status == 0xF7) {
+            quint32 length = 0;
+            if (!readVarLen(length)) {
+                return false;
+            }
+            m_file.seek(std::min(m_file.pos() + length, m_trackEnd));
+            continue;
+        } else if (status > 0xF0) {
+            return false;
+        } else if (!readByte(data1)) {
+            return false;
+        }
+        m_runningStatus = status;
+
+        // Program change and channel pressure have one data byte, the others two
+        const quint8 kind = status & 0xF0;
+        quint8 data2 = 0;
+        if (kind != 0xC0 && kind != 0xD0 && !readByte(data2)) {
+            return false;
+        }
+        if (kind != 0x80 && kind != 0x90) {
+            continue;
+        }
+
+        event = MidiEvent();
+        event.type = kind == 0x90 && data2 > 0 ? MidiEvent::NoteOn : MidiEvent::NoteOff;
+        event.channel = status & 0x0F;
+        event.key = data1 & 0x7F;
+        event.velocity = event.type == MidiEvent::NoteOn ? data2 : 0;
+        event.time = static_cast<qint64>(m_time);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Reads a byte of the track
+ * @param byte Receives the byte
+ * @return false at the end of the track
+ */
+bool SmfReader::readByte(quint8& byte)
+{
+    char c = 0;
+    if (m_file.pos() >= m_trackEnd || !m_file.getChar(&c)) {
+        return false;
+    }
+    byte = static_cast<quint8>(c);
+    return true;
+}
+
+/**
+ * @brief Reads a variable-length quantity of the track
+ * @param value Receives the value
+ * @return false at the end of the track
+ */
+bool SmfReader::readVarLen(quint32& value)
+{
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        quint8 byte = 0;
+        if (!readByte(byte)) {
+            return false;
+        }
+        value = (value << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file smffile.h
+ * @brief Header file for the SmfWriter and SmfReader classes
+ * @author Alan Cruz
+ * @details This file defines streaming access to Standard MIDI Files, used to
+ *          record free-style performances and play them back.
+ */
+
+#ifndef SMFFILE_H
+#define SMFFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <bitset>
+#include "midieventqueue.h"
+
+/**
+ * @brief Writes note events to a format 0 Standard MIDI File as they arrive
+ * @details The header, a tempo of 120 BPM and TICKS_PER_QUARTER ticks per
+ *          quarter note are written by open(), so one tick is a millisecond.
+ *          Events are collected in a buffer of BUFFER_BYTES and written by
+ *          flush(), which also updates the length of the track, so the file is
+ *          complete up to the last flush even if the application is killed.
+ *          Memory use does not depend on the length of the recording.
+ */
+class SmfWriter
+{
+public:
+    static constexpr quint16 TICKS_PER_QUARTER = 500;  ///< Division of the file
+    static constexpr quint32 TEMPO_US = 500000;        ///< Microseconds per quarter note, 120 BPM
+    static constexpr int BUFFER_BYTES = 4096;          ///< Events buffered before they are written
+
+    /**
+     * @brief Creates the file and writes its header
+     * @param filePath Path of the file; an existing file is replaced
+     * @param startTime MidiEventQueue::now() time of tick 0
+     * @return true if the file was created
+     */
+    bool open(const QString& filePath, qint64 startTime);
+
+    /**
+     * @brief Adds a note-on or note-off event
+     * @param event The event; events before the start time are placed at tick 0
+     */
+    void write(const MidiEvent& event);
+
+    /**
+     * @brief Writes the buffered events and the track length
+     * @return true if everything was written
+     */
+    bool flush();
+
+    /**
+     * @brief Ends the notes still held, ends the track and closes the file
+     * @param endTime MidiEventQueue::now() time the held notes end at
+     * @return true if everything was written
+     */
+    bool close(qint64 endTime);
+
+    /**
+     * @brief Checks whether a file is open
+     * @return true between open() and close()
+     */
+    bool isOpen() const { return m_file.isOpen(); }
+
+    /**
+     * @brief Gets the number of notes written
+     * @return The number of note-on events
+     */
+    qint64 noteCount() const { return m_notes; }
+
+private:
+    /**
+     * @brief Appends the delta time of an event at a time
+     * @param time MidiEventQueue::now() time of the event
+     */
+    void writeDelta(qint64 time);
+
+    /**
+     * @brief Appends a variable-length quantity
+     * @param value The value
+     */
+    void writeVarLen(quint32 value);
+
+    QFile m_file;                      // The file being written
+    QByteArray m_buffer;               // Events not written yet
+    std::bitset<128> m_held;           // Notes on without a note-off yet
+    qint64 m_startTime = 0;            // Time of tick 0
+    qint64 m_lastTick = 0;             // Tick of the last event
+    quint32 m_trackBytes = 0;          // Bytes of the track written so far
+    qint64 m_notes = 0;                // Note-on events written
+};
+
+/**
+ * @brief Reads the note events of a Standard MIDI File one at a time
+ * @details Reads the first track, so format 0 files and the first track of
+ *          format 1 files, honouring tempo changes. Only one event is decoded at
+ *          a time, so a file of any length can be streamed.
+ */
+class SmfReader
+{
+public:
+    /**
+     * @brief Opens a file and finds its first track
+     * @param filePath Path of the file
+     * @return true if the file is a Standard MIDI File with ticks per quarter note
+     */
+    bool open(const QString& filePath);
+
+    /**
+     * @brief Reads the next note event
+     * @param event Receives the event; its time is in nanoseconds from the start of the file
+     * @return true if an event was read, false at the end of the track
+     * @details A note-on with velocity 0 is returned as a note-off.
+     */
+    bool next(MidiEvent& event);
+
+    /**
+     * @brief Closes the file
+     */
+    void close() { m_file.close(); }
+
+private:
+    /**
+     * @brief Reads a byte of the track
+     * @param byte Receives the byte
+     * @return false at the end of the track
+     */
+    bool readByte(quint8& byte);
+
+    /**
+     * @brief Reads a variable-length quantity of the track
+     * @param value Receives the value
+     * @return false at the end of the track
+     */
+    bool readVarLen(quint32& value);
+
+    QFile m_file;                      // The file being read
+    qint64 m_trackEnd = 0;             // Offset of the end of the track
+    quint16 m_division = SmfWriter::TICKS_PER_QUARTER; // Ticks per quarter note
+    double m_nsPerTick = 0.0;          // Length of a tick at the current tempo
+    double m_time = 0.0;               // Time of the last event in nanoseconds
+    quint8 m_runningStatus = 0;        // Status byte of the last channel event
+};
+
+#endif // SMFFILE_H
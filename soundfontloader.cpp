@@ -0,0 +1,312 @@
+/**
+ * @file soundfontloader.cpp
+ * @brief Implementation of the SoundFontLoader class
+ * @author Alan Cruz
+ * @details This file implements the background SoundFont loading and the
+ *          extraction cache keyed on the SoundFont's hash.
+ */
+
+#include "soundfontloader.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstdio>
+
+#ifdef KEYQUEST_HAVE_SOUNDFONT_HASH
+// Generated from the piano SoundFont by tools/soundfont_hash.py
+extern const char soundFontResource[];
+extern const char soundFontSha256[];
+extern const long long soundFontSize;
+#endif
+
+/**
+ * @brief Opens a file for FluidSynth through QFile
+ * @param filename UTF-8 path; Qt resource paths are supported
+ * @return The QFile, or nullptr if it cannot be opened
+ */
+static void* openFile(const char* filename)
+{
+    QFile* file = new QFile(QString::fromUtf8(filename));
+    if (!file->open(QIODevice::ReadOnly)) {
+        delete file;
+        return nullptr;
+    }
+    return file;
+}
+
+/**
+ * @brief Reads exactly count bytes for FluidSynth
+ * @param buf Destination buffer
+ * @param count Number of bytes
+ * @param handle The QFile
+ * @return FLUID_OK, or FLUID_FAILED on a short read
+ */
+static int readFile(void* buf, fluid_long_long_t count, void* handle)
+{
+    QFile* file = static_cast<QFile*>(handle);
+    return file->read(static_cast<char*>(buf), count) == count ? FLUID_OK : FLUID_FAILED;
+}
+
+/**
+ * @brief Seeks for FluidSynth
+ * @param handle The QFile
+ * @param offset Offset relative to origin
+ * @param origin SEEK_SET, SEEK_CUR or SEEK_END
+ * @return FLUID_OK, or FLUID_FAILED if the position is invalid
+ */
+static int seekFile(void* handle, fluid_long_long_t offset, int origin)
+{
+    QFile* file = static_cast<QFile*>(handle);
+    qint64 base = 0;
+    if (origin == SEEK_CUR) {
+        base = file->pos();
+    } else if (origin == SEEK_END) {
+        base = file->size();
+    }
+    return file->seek(base + offset) ? FLUID_OK : FLUID_FAILED;
+}
+
+/**
+ * @brief Gets the position for FluidSynth
+ * @param handle The QFile
+ * @return The current position
+ */
+static fluid_long_long_t tellFile(void* handle)
+{
+    return static_cast<QFile*>(handle)->pos();
+}
+
+/**
+ * @brief Closes a file opened by openFile()
+ * @param handle The QFile
+ * @return FLUID_OK
+ */
+static int closeFile(void* handle)
+{
+    delete static_cast<QFile*>(handle);
+    return FLUID_OK;
+}
+
+/**
+ * @brief Constructs a loader
+ * @param settings Settings the synthesizer was created with
+ * @param synth Synthesizer to load the SoundFont into
+ * @param resourcePath Path of the SoundFont, e.g. ":/sounds/piano.sf2"
+ * @param parent The parent QObject
+ */
+SoundFontLoader::SoundFontLoader(fluid_settings_t* settings, fluid_synth_t* synth,
+                                 const QString& resourcePath, QObject* parent)
+    : QObject(parent)
+    , m_settings(settings)
+    , m_synth(synth)
+    , m_resourcePath(resourcePath)
+    , m_thread(nullptr)
+    , m_soundFontId(-1)
+{
+}
+
+/**
+ * @brief Destructor
+ * @details Waits for a load that is still running.
+ */
+SoundFontLoader::~SoundFontLoader()
+{
+    wait();
+    delete m_thread;
+}
+
+/**
+ * @brief Starts loading in the background
+ */
+void SoundFontLoader::start()
+{
+    if (m_thread) {
+        return;
+    }
+
+    m_thread = QThread::create([this]() {
+        bool ok = load();
+
+        // Report on the loader's own thread
+        QMetaObject::invokeMethod(this, [this, ok]() { emit finished(ok); }, Qt::QueuedConnection);
+    });
+    m_thread->setObjectName("SoundFontLoader");
+    m_thread->start(QThread::LowPriority);
+}
+
+/**
+ * @brief Blocks until the load has finished
+ */
+void SoundFontLoader::wait()
+{
+    if (m_thread) {
+        m_thread->wait();
+    }
+}
+
+/**
+ * @brief Loads the SoundFont; runs on the worker thread
+ * @return true on success
+ */
+bool SoundFontLoader::load()
+{
+    if (!m_settings || !m_synth) {
+        return false;
+    }
+
+    // Let FluidSynth read through QFile so resource paths can be opened directly
+    fluid_sfloader_t* loader = new_fluid_defsfloader(m_settings);
+    if (loader) {
+        fluid_sfloader_set_callbacks(loader, openFile, readFile, seekFile, tellFile, closeFile);
+        fluid_synth_add_sfloader(m_synth, loader);
+    }
+
+    QString path = sourcePath(false);
+    if (path.isEmpty()) {
+        return false;
+    }
+
+    // **Load SoundFont in FluidSynth**
+    int sfId = fluid_synth_sfload(m_synth, path.toUtf8().constData(), 1);
+    if (sfId == FLUID_FAILED && path != m_resourcePath) {
+        // The cache only had the right size; check its content and extract it again if damaged
+        qDebug() << "Cached SoundFont was rejected, verifying it:" << path;
+        path = sourcePath(true);
+        if (path.isEmpty()) {
+            return false;
+        }
+        sfId = fluid_synth_sfload(m_synth, path.toUtf8().constData(), 1);
+    }
+    if (sfId == FLUID_FAILED) {
+        qDebug() << "ERROR: Failed to load SoundFont!" << path;
+        return false;
+    }
+
+    // Set the instrument to piano (program 0) after loading the soundfont, also on
+    // the channels the keyboard's sequences play on; channel 9 stays percussion
+    for (int channel = 0; channel < 16; ++channel) {
+        if (channel != 9) {
+            fluid_synth_program_select(m_synth, channel, sfId, 0, 0);
+        }
+    }
+    m_soundFontId = sfId;
+    qDebug() << "SoundFont Loaded Successfully from" << path;
+    return true;
+}
+
+/**
+ * @brief Gets the path FluidSynth should open for the resource
+ * @param verifyCache true to check the cache file's hash, not only its size
+ * @return The resource path itself if it is stored uncompressed, otherwise the
+ *         cache file, extracting it first if needed; empty on error
+ * @details The cache file is named after the resource's hash, so a file of the
+ *          right size under that name is trusted without reading it.
+ */
+QString SoundFontLoader::sourcePath(bool verifyCache) const
+{
+    QResource resource(m_resourcePath);
+    if (!resource.isValid()) {
+        qDebug() << "ERROR: SoundFont resource not found!" << m_resourcePath;
+        return QString();
+    }
+
+    // Uncompressed resources are read in place, there is nothing to extract
+    if (resource.compressionAlgorithm() == QResource::NoCompression) {
+        return m_resourcePath;
+    }
+
+    QString hash = resourceHash(resource);
+    if (hash.isEmpty()) {
+        qDebug() << "ERROR: Failed to open resource SoundFont file!";
+        return QString();
+    }
+
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/soundfonts";
+    QString cachePath = cacheDir + "/" + hash + ".sf2";
+    QFileInfo cached(cachePath);
+    if (cached.exists()) {
+        if (cached.size() == resource.uncompressedSize() && (!verifyCache || hashFile(cachePath) == hash)) {
+            return cachePath;
+        }
+        qDebug() << "Cached SoundFont is damaged, extracting it again:" << cachePath;
+    }
+
+    if (!QDir().mkpath(cacheDir)) {
+        qDebug() << "ERROR: Failed to create SoundFont cache directory:" << cacheDir;
+        return QString();
+    }
+
+    // Copy in chunks; QSaveFile only replaces the cache once the copy is complete
+    QFile source(m_resourcePath);
+    QSaveFile target(cachePath);
+    if (!source.open(QIODevice::ReadOnly) || !target.open(QIODevice::WriteOnly)) {
+        qDebug() << "ERROR: Failed to create SoundFont cache file:" << cachePath;
+        return QString();
+    }
+    QByteArray chunk;
+    while (!(chunk = source.read(CHUNK_SIZE)).isEmpty()) {
+        if (target.write(chunk) != chunk.size()) {
+            qDebug() << "ERROR: Failed to write SoundFont to disk!";
+            return QString();
+        }
+    }
+    if (!target.commit()) {
+        qDebug() << "ERROR: Failed to write SoundFont to disk!";
+        return QString();
+    }
+    qDebug() << "Extracted SoundFont to:" << cachePath;
+
+    // Older versions of the SoundFont are no longer needed
+    QDir dir(cacheDir);
+    for (const QString& name : dir.entryList({"*.sf2"}, QDir::Files)) {
+        if (name != hash + ".sf2") {
+            dir.remove(name);
+        }
+    }
+    return cachePath;
+}
+
+/**
+ * @brief Gets the SHA-256 of the resource
+ * @param resource The resource at m_resourcePath
+ * @return The hash computed at build time if it belongs to the resource,
+ *         otherwise the hash of its content; empty if it cannot be read
+ * @details The build-time hash is only trusted while the embedded resource has
+ *          the size it was computed for, so a stale generated file falls back to
+ *          hashing instead of naming the cache after the wrong content.
+ */
+QString SoundFontLoader::resourceHash(const QResource& resource) const
+{
+#ifdef KEYQUEST_HAVE_SOUNDFONT_HASH
+    if (m_resourcePath == QLatin1String(soundFontResource) && resource.uncompressedSize() == soundFontSize) {
+        return QString::fromLatin1(soundFontSha256);
+    }
+#else
+    Q_UNUSED(resource);
+#endif
+    return hashFile(m_resourcePath);
+}
+
+/**
+ * @brief Computes the SHA-256 of a file, reading it in chunks
+ * @param path Path of the file or resource
+ * @return The hash as hex digits, or an empty string if the file cannot be read
+ */
+QString SoundFontLoader::hashFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QByteArray chunk;
+    while (!(chunk = file.read(CHUNK_SIZE)).isEmpty()) {
+        hash.addData(chunk);
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
@@ -0,0 +1,122 @@
+/**
+ * @file soundfontloader.h
+ * @brief Header file for the SoundFontLoader class
+ * @author Alan Cruz
+ * @details This file defines SoundFontLoader, which loads the piano SoundFont into
+ *          the FluidSynth synthesizer on a background thread so that startup never
+ *          waits for it.
+ */
+
+#ifndef SOUNDFONTLOADER_H
+#define SOUNDFONTLOADER_H
+
+#include <QObject>
+#include <QResource>
+#include <QString>
+#include <QThread>
+#include <fluidsynth.h>
+#include <atomic>
+
+/**
+ * @brief Loads a SoundFont into a synthesizer on a worker thread
+ * @details FluidSynth reads the SoundFont through file callbacks backed by QFile,
+ *          so a resource that rcc stored uncompressed (the usual case for sample
+ *          data, which rcc does not find worth compressing) is read straight from
+ *          the mapped resource data, embedded or in a registered .rcc file, without
+ *          being copied to disk.
+ *
+ *          A compressed resource would have to be inflated into memory as a whole.
+ *          It is instead extracted once, in fixed-size chunks, to a cache file in
+ *          AppDataLocation whose name is the SHA-256 of the content. The hash is
+ *          computed at build time by tools/soundfont_hash.py, so a start with a
+ *          valid cache reads neither the resource nor the cached file: the cache is
+ *          used if its size matches the resource. Only if FluidSynth then rejects
+ *          it is the cached file hashed, and extracted again if it was damaged.
+ *          Builds without the generated hash compute it from the resource.
+ *
+ *          finished() is always emitted on the thread the loader was created on.
+ */
+class SoundFontLoader : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a loader
+     * @param settings Settings the synthesizer was created with
+     * @param synth Synthesizer to load the SoundFont into
+     * @param resourcePath Path of the SoundFont, e.g. ":/sounds/piano.sf2"
+     * @param parent The parent QObject
+     */
+    SoundFontLoader(fluid_settings_t* settings, fluid_synth_t* synth,
+                    const QString& resourcePath, QObject* parent = nullptr);
+
+    /**
+     * @brief Destructor
+     * @details Waits for a load that is still running.
+     */
+    ~SoundFontLoader() override;
+
+    /**
+     * @brief Starts loading in the background
+     * @details Does nothing if a load was already started.
+     */
+    void start();
+
+    /**
+     * @brief Blocks until the load has finished
+     */
+    void wait();
+
+    /**
+     * @brief Gets the ID of the loaded SoundFont
+     * @return The FluidSynth SoundFont ID, or -1 if it is not loaded (yet)
+     */
+    int soundFontId() const { return m_soundFontId; }
+
+signals:
+    /**
+     * @brief Emitted when loading has finished
+     * @param ok true if the SoundFont was loaded and the piano program selected
+     */
+    void finished(bool ok);
+
+private:
+    static const qint64 CHUNK_SIZE = 1024 * 1024;  ///< Bytes copied or hashed at a time
+
+    /**
+     * @brief Loads the SoundFont; runs on the worker thread
+     * @return true on success
+     */
+    bool load();
+
+    /**
+     * @brief Gets the path FluidSynth should open for the resource
+     * @param verifyCache true to check the cache file's hash, not only its size
+     * @return The resource path itself if it is stored uncompressed, otherwise the
+     *         cache file, extracting it first if needed; empty on error
+     */
+    QString sourcePath(bool verifyCache) const;
+
+    /**
+     * @brief Gets the SHA-256 of the resource
+     * @param resource The resource at m_resourcePath
+     * @return The hash computed at build time if it belongs to the resource,
+     *         otherwise the hash of its content; empty if it cannot be read
+     */
+    QString resourceHash(const QResource& resource) const;
+
+    /**
+     * @brief Computes the SHA-256 of a file, reading it in chunks
+     * @param path Path of the file or resource
+     * @return The hash as hex digits, or an empty string if the file cannot be read
+     */
+    static QString hashFile(const QString& path);
+
+    fluid_settings_t* m_settings;    ///< Settings the synthesizer was created with
+    fluid_synth_t* m_synth;          ///< Synthesizer to load into
+    QString m_resourcePath;          ///< Path of the SoundFont resource
+    QThread* m_thread;               ///< Worker thread, nullptr until start()
+    std::atomic<int> m_soundFontId;  ///< Loaded SoundFont, -1 until loaded
+};
+
+#endif // SOUNDFONTLOADER_H
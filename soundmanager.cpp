@@ -9,6 +9,7 @@
 
 #include "soundmanager.h"
 #include <QDebug>
+#include <QFileInfo>
 
 // Initialize static member
 SoundManager* SoundManager::m_instance = nullptr;
@@ -30,42 +31,144 @@ SoundManager* SoundManager::instance()
 /**
  * @brief Constructs a new SoundManager
  * @param parent The parent QObject
- * @details Initializes the button click sound effect and background music player.
- *          Sets up the background music tracks and connects signals.
+ * @details Registers the button click sound effect and sets up the two background music
+ *          players. Sets up the background music tracks and connects signals.
  */
 SoundManager::SoundManager(QObject *parent)
     : QObject(parent)
     , m_sfx_muted(false)
     , m_bgmusic_muted(false)
     , m_currentTrack(0)
-    , m_audioOutput(new QAudioOutput(this))
+    , m_musicOutputs{new QAudioOutput(this), new QAudioOutput(this)}
+    , m_activePlayer(0)
+    , m_musicVolume(0.3f)  // 30% volume for background music
+    , m_crossfade(new QVariantAnimation(this))
+    , m_buttonClickId(-1)
+    , m_sfxVolume(0.5f)  // 50% volume
 {
     // Set up button click sound
-    m_buttonClick.setSource(QUrl("qrc:/sounds/soundFiles/buttonClick.wav"));
-    m_buttonClick.setVolume(0.5f);  // 50% volume
+    m_buttonClickId = registerEffect("buttonClick", QUrl("qrc:/sounds/soundFiles/buttonClick.wav"));
 
     // Set up background music tracks
-    m_backgroundTracks << "qrc:/sounds/soundFiles/anoen.mp3"
-                      << "qrc:/sounds/soundFiles/quend.mp3";
+    setPlaylist({"qrc:/sounds/soundFiles/anoen.mp3",
+                 "qrc:/sounds/soundFiles/quend.mp3"});
 
-    // Set up background music player
-    m_audioOutput->setVolume(0.3f);  // 30% volume for background music
-    m_backgroundMusic.setAudioOutput(m_audioOutput);
-    
-    connect(&m_backgroundMusic, &QMediaPlayer::mediaStatusChanged,
-            this, &SoundManager::handleMusicEnd);
+    // Set up background music players
+    for (int i = 0; i < 2; ++i) {
+        m_musicPlayers[i].setAudioOutput(m_musicOutputs[i]);
+        connect(&m_musicPlayers[i], &QMediaPlayer::mediaStatusChanged, this,
+                [this, i](QMediaPlayer::MediaStatus status) { handleMusicEnd(i, status); });
+        connect(&m_musicPlayers[i], &QMediaPlayer::positionChanged, this,
+                [this, i](qint64 position) { handleMusicPosition(i, position); });
+    }
+    applyMusicVolume();
+
+    m_crossfade->setStartValue(0.0);
+    m_crossfade->setEndValue(1.0);
+    m_crossfade->setDuration(CROSSFADE_MS);
+    connect(m_crossfade, &QVariantAnimation::valueChanged, this, [this]() { applyMusicVolume(); });
+    connect(m_crossfade, &QVariantAnimation::finished, this, &SoundManager::finishCrossfade);
+}
+
+/**
+ * @brief Registers a sound effect and preloads its voices
+ * @param name Name to look the effect up by with effectId()
+ * @param source URL of the sound file, e.g. "qrc:/sounds/soundFiles/buttonClick.wav"
+ * @param voices Number of times the effect can sound at once
+ * @param gain Volume of the effect relative to the sound effects volume (0-1)
+ * @return ID to pass to playEffect(); the existing ID if the name is already registered
+ * @details Setting the source starts decoding every voice in the background, so the
+ *          first trigger does not wait for it.
+ */
+int SoundManager::registerEffect(const QString& name, const QUrl& source, int voices, float gain)
+{
+    auto it = m_effectIds.constFind(name);
+    if (it != m_effectIds.constEnd()) {
+        return it.value();
+    }
+
+    Effect effect;
+    effect.gain = gain;
+    for (int i = 0; i < qMax(1, voices); ++i) {
+        QSoundEffect* voice = new QSoundEffect(this);
+        voice->setSource(source);
+        voice->setVolume(m_sfxVolume * gain);
+        effect.voices.push_back(voice);
+    }
+
+    int id = static_cast<int>(m_effects.size());
+    m_effects.push_back(std::move(effect));
+    m_effectIds.insert(name, id);
+    return id;
+}
+
+/**
+ * @brief Gets the memory the decoded sound effects hold
+ * @return Bytes of the sample data of every registered effect
+ * @details The voices of an effect share one decoded sample, whose size is about
+ *          that of its uncompressed WAV file.
+ */
+qint64 SoundManager::memoryUsage() const
+{
+    qint64 bytes = 0;
+    for (const Effect& effect : m_effects) {
+        if (effect.voices.empty()) {
+            continue;
+        }
+        const QUrl source = effect.voices.front()->source();
+        bytes += QFileInfo(source.scheme() == "qrc" ? ":" + source.path() : source.toLocalFile()).size();
+    }
+    return bytes;
+}
+
+/**
+ * @brief Gets the ID of a registered effect
+ * @param name Name the effect was registered under
+ * @return The ID, or -1 if no effect has that name
+ */
+int SoundManager::effectId(const QString& name) const
+{
+    return m_effectIds.value(name, -1);
+}
+
+/**
+ * @brief Plays a registered sound effect
+ * @param id ID returned by registerEffect()
+ * @details Uses the first idle voice, starting after the one used last. If all voices
+ *          are playing, the next voice in turn is restarted.
+ */
+void SoundManager::playEffect(int id)
+{
+    if (m_sfx_muted || id < 0 || id >= static_cast<int>(m_effects.size())) {
+        return;
+    }
+
+    Effect& effect = m_effects[id];
+    const int count = static_cast<int>(effect.voices.size());
+    int chosen = effect.nextVoice;
+    for (int i = 0; i < count; ++i) {
+        int index = (effect.nextVoice + i) % count;
+        if (!effect.voices[index]->isPlaying()) {
+            chosen = index;
+            break;
+        }
+    }
+
+    QSoundEffect* voice = effect.voices[chosen];
+    if (voice->isPlaying()) {
+        voice->stop();
+    }
+    voice->play();
+    effect.nextVoice = (chosen + 1) % count;
 }
 
 /**
  * @brief Plays the button click sound effect
  * @details Plays the sound effect if sound is not muted.
- *          The sound is played at the volume set in the constructor.
  */
 void SoundManager::playButtonClick()
 {
-    if (!m_sfx_muted) {
-        m_buttonClick.play();
-    }
+    playEffect(m_buttonClickId);
 }
 
 /**
@@ -77,7 +180,12 @@ void SoundManager::playButtonClick()
 void SoundManager::setSFXVolume(float volume)
 {
     (volume == 0) ? setSFXMuted(true) : setSFXMuted(false);
-    m_buttonClick.setVolume(volume / 100);
+    m_sfxVolume = volume / 100;
+    for (const Effect& effect : m_effects) {
+        for (QSoundEffect* voice : effect.voices) {
+            voice->setVolume(m_sfxVolume * effect.gain);
+        }
+    }
 }
 
 /**
@@ -89,7 +197,8 @@ void SoundManager::setSFXVolume(float volume)
 void SoundManager::setBGMusicVolume(float volume)
 {
     (volume == 0) ? setBGMusicMuted(true) : setBGMusicMuted(false);
-    m_audioOutput->setVolume(volume / 100);
+    m_musicVolume = volume / 100;
+    applyMusicVolume();
 }
 
 /**
@@ -110,9 +219,14 @@ void SoundManager::setBGMusicMuted(bool muted)
 {
     m_bgmusic_muted = muted;
     if (m_bgmusic_muted) {
-        m_backgroundMusic.pause();
-    } else {
-        m_backgroundMusic.play();
+        // A crossfade in progress is cut short
+        if (m_crossfade->state() == QAbstractAnimation::Running) {
+            m_crossfade->stop();
+            finishCrossfade();
+        }
+        m_musicPlayers[m_activePlayer].pause();
+    } else if (!m_musicPlayers[m_activePlayer].source().isEmpty()) {
+        m_musicPlayers[m_activePlayer].play();
     }
 }
 
@@ -134,6 +248,21 @@ bool SoundManager::isBGMusicMuted() const
     return m_bgmusic_muted;
 }
 
+/**
+ * @brief Replaces the background music playlist
+ * @param tracks Track URLs ("qrc:/..." or "file:/...") or local file paths
+ * @details Local files are streamed by the media backend rather than read into
+ *          memory. Takes effect from the next track change.
+ */
+void SoundManager::setPlaylist(const QStringList& tracks)
+{
+    m_backgroundTracks.clear();
+    for (const QString& track : tracks) {
+        m_backgroundTracks.append(track.startsWith("qrc:") ? QUrl(track) : QUrl::fromUserInput(track));
+    }
+    m_currentTrack = 0;
+}
+
 /**
  * @brief Starts playing background music
  * @details Plays the background music tracks in sequence.
@@ -141,10 +270,16 @@ bool SoundManager::isBGMusicMuted() const
  */
 void SoundManager::startBackgroundMusic()
 {
-    if (!m_bgmusic_muted && m_backgroundMusic.playbackState() != QMediaPlayer::PlayingState) {
+    QMediaPlayer& player = m_musicPlayers[m_activePlayer];
+    if (m_bgmusic_muted || m_backgroundTracks.isEmpty() || player.playbackState() == QMediaPlayer::PlayingState) {
+        return;
+    }
+
+    // After a stop, continue with the next track; after a pause, resume
+    if (player.source().isEmpty()) {
         switchToNextTrack();
-        m_backgroundMusic.play();
     }
+    m_musicPlayers[m_activePlayer].play();
 }
 
 /**
@@ -152,16 +287,36 @@ void SoundManager::startBackgroundMusic()
  */
 void SoundManager::stopBackgroundMusic()
 {
-    m_backgroundMusic.stop();
+    m_crossfade->stop();
+    for (QMediaPlayer& player : m_musicPlayers) {
+        player.stop();
+    }
+    m_musicPlayers[m_activePlayer].setSource(QUrl());
     m_currentTrack = 0;
+    applyMusicVolume();
 }
 
 /**
  * @brief Pauses background music
+ * @details A running crossfade is completed first, so only the active player
+ *          has to be resumed.
  */
 void SoundManager::pauseBackgroundMusic()
 {
-    m_backgroundMusic.pause();
+    if (m_crossfade->state() == QAbstractAnimation::Running) {
+        m_crossfade->stop();
+        finishCrossfade();
+    }
+    m_musicPlayers[m_activePlayer].pause();
+}
+
+/**
+ * @brief Checks whether background music is playing
+ * @return true if the current track is playing
+ */
+bool SoundManager::isBackgroundMusicPlaying() const
+{
+    return m_musicPlayers[m_activePlayer].playbackState() == QMediaPlayer::PlayingState;
 }
 
 /**
@@ -170,29 +325,125 @@ void SoundManager::pauseBackgroundMusic()
 void SoundManager::resumeBackgroundMusic()
 {
     if (!m_bgmusic_muted) {
-        m_backgroundMusic.play();
+        m_musicPlayers[m_activePlayer].play();
     }
 }
 
 /**
  * @brief Handles the end of a music track
- * @details Switches to the next track in the playlist
+ * @param player Index of the player whose status changed
+ * @param status The new media status
+ * @details Switches to the next track in the playlist if the track ended
+ *          before a crossfade could start, e.g. because it is very short.
  */
-void SoundManager::handleMusicEnd(QMediaPlayer::MediaStatus status)
+void SoundManager::handleMusicEnd(int player, QMediaPlayer::MediaStatus status)
 {
-    if (status == QMediaPlayer::EndOfMedia) {
+    if (status == QMediaPlayer::EndOfMedia && player == m_activePlayer) {
         switchToNextTrack();
         if (!m_bgmusic_muted) {
-            m_backgroundMusic.play();
+            m_musicPlayers[m_activePlayer].play();
         }
     }
 }
 
+/**
+ * @brief Starts the crossfade when the playing track is about to end
+ * @param player Index of the player whose position changed
+ * @param position Playback position in milliseconds
+ */
+void SoundManager::handleMusicPosition(int player, qint64 position)
+{
+    const QMediaPlayer& current = m_musicPlayers[player];
+    if (player != m_activePlayer || m_bgmusic_muted || m_backgroundTracks.size() < 2
+        || m_crossfade->state() == QAbstractAnimation::Running
+        || current.duration() <= 2 * CROSSFADE_MS
+        || position < current.duration() - CROSSFADE_MS) {
+        return;
+    }
+
+    // Only crossfade into a track that is already open; otherwise EndOfMedia switches
+    const QMediaPlayer& standby = m_musicPlayers[1 - player];
+    if (standby.source() != trackUrl(m_currentTrack + 1)
+        || (standby.mediaStatus() != QMediaPlayer::LoadedMedia
+            && standby.mediaStatus() != QMediaPlayer::BufferedMedia)) {
+        return;
+    }
+
+    m_crossfade->start();
+    switchToNextTrack();
+    applyMusicVolume();
+    m_musicPlayers[m_activePlayer].play();
+}
+
+/**
+ * @brief Stops the faded-out player and preloads the following track on it
+ */
+void SoundManager::finishCrossfade()
+{
+    m_musicPlayers[1 - m_activePlayer].stop();
+    applyMusicVolume();
+    prefetchNextTrack();
+}
+
 /**
  * @brief Switches to the next background music track
+ * @details Makes the preloaded player active, or loads the track on the active
+ *          player if it was not preloaded, and preloads the track after it.
  */
 void SoundManager::switchToNextTrack()
 {
     m_currentTrack = (m_currentTrack + 1) % m_backgroundTracks.size();
-    m_backgroundMusic.setSource(QUrl(m_backgroundTracks[m_currentTrack]));
-} 
+    const QUrl url = trackUrl(m_currentTrack);
+
+    const int standby = 1 - m_activePlayer;
+    if (m_musicPlayers[standby].source() == url) {
+        m_activePlayer = standby;
+    } else {
+        m_musicPlayers[m_activePlayer].setSource(url);
+    }
+
+    // A crossfade preloads once the outgoing player has faded out
+    if (m_crossfade->state() != QAbstractAnimation::Running && m_musicPlayers[1 - m_activePlayer].playbackState() != QMediaPlayer::PlayingState) {
+        prefetchNextTrack();
+    }
+}
+
+/**
+ * @brief Loads the track after the current one on the idle player
+ */
+void SoundManager::prefetchNextTrack()
+{
+    if (m_backgroundTracks.size() < 2) {
+        return;
+    }
+    QMediaPlayer& standby = m_musicPlayers[1 - m_activePlayer];
+    const QUrl next = trackUrl(m_currentTrack + 1);
+    if (standby.source() != next) {
+        standby.setSource(next);
+    }
+}
+
+/**
+ * @brief Gets the URL of a playlist entry
+ * @param index Index into the playlist; wraps around
+ * @return The URL
+ */
+QUrl SoundManager::trackUrl(int index) const
+{
+    return m_backgroundTracks[index % m_backgroundTracks.size()];
+}
+
+/**
+ * @brief Sets the volume of both music players
+ * @details During a crossfade the active player fades in while the other one fades
+ *          out; otherwise only the active player is audible.
+ */
+void SoundManager::applyMusicVolume()
+{
+    qreal fade = 1.0;
+    if (m_crossfade->state() == QAbstractAnimation::Running) {
+        fade = m_crossfade->currentValue().toReal();
+    }
+    m_musicOutputs[m_activePlayer]->setVolume(m_musicVolume * fade);
+    m_musicOutputs[1 - m_activePlayer]->setVolume(m_musicVolume * (1.0 - fade));
+}
@@ -16,6 +16,9 @@
 #include <QObject>
 #include <QUrl>
 #include <QStringList>
+#include <QHash>
+#include <QVariantAnimation>
+#include <vector>
 
 /**
  * @brief Manages sound effects and background music throughout the application
@@ -23,6 +26,17 @@
  * The SoundManager class is responsible for playing sound effects like button clicks
  * and managing background music. It implements a singleton pattern to ensure only
  * one instance exists and manages all audio in the application.
+ *
+ * Sound effects are registered once with registerEffect(), which creates a small pool
+ * of QSoundEffect voices for the effect and starts decoding them right away. Playing
+ * an effect picks the next idle voice of its pool, so quick repeated triggers overlap
+ * instead of cutting each other off. When every voice is busy the voices are restarted
+ * in turn. Triggering does not allocate or look anything up by name.
+ *
+ * Background music alternates between two players. While one plays, the other has
+ * already opened the next track, and the two are crossfaded over CROSSFADE_MS before
+ * the playing track ends. A track change therefore never waits for a file to be
+ * opened. Tracks can be resources or files on disk, which are streamed.
  */
 class SoundManager : public QObject
 {
@@ -34,6 +48,32 @@ public:
      */
     static SoundManager* instance();
 
+    static const int DEFAULT_VOICES = 4;  ///< Voices per effect unless registered otherwise
+
+    /**
+     * @brief Registers a sound effect and preloads its voices
+     * @param name Name to look the effect up by with effectId()
+     * @param source URL of the sound file, e.g. "qrc:/sounds/soundFiles/buttonClick.wav"
+     * @param voices Number of times the effect can sound at once
+     * @param gain Volume of the effect relative to the sound effects volume (0-1)
+     * @return ID to pass to playEffect(); the existing ID if the name is already registered
+     */
+    int registerEffect(const QString& name, const QUrl& source, int voices = DEFAULT_VOICES, float gain = 1.0f);
+
+    /**
+     * @brief Gets the ID of a registered effect
+     * @param name Name the effect was registered under
+     * @return The ID, or -1 if no effect has that name
+     */
+    int effectId(const QString& name) const;
+
+    /**
+     * @brief Plays a registered sound effect
+     * @param id ID returned by registerEffect()
+     * @details Does nothing if sound effects are muted or the ID is unknown.
+     */
+    void playEffect(int id);
+
     /**
      * @brief Plays the button click sound effect
      * @details Plays a short click sound when a button is pressed.
@@ -77,6 +117,13 @@ public:
      */
     bool isBGMusicMuted() const;
 
+    /**
+     * @brief Replaces the background music playlist
+     * @param tracks Track URLs ("qrc:/..." or "file:/...") or local file paths
+     * @details Takes effect from the next track change; the playing track continues.
+     */
+    void setPlaylist(const QStringList& tracks);
+
     /**
      * @brief Starts playing background music
      * @details Plays the background music tracks in sequence.
@@ -89,11 +136,26 @@ public:
      */
     void stopBackgroundMusic();
 
+    /**
+     * @brief Gets the memory the decoded sound effects hold
+     * @return Bytes of the sample data of every registered effect
+     * @details The music is streamed by QMediaPlayer and not counted.
+     */
+    qint64 memoryUsage() const;
+
     /**
      * @brief Pauses background music
+     * @details A running crossfade is completed first, so only the active player
+     *          has to be resumed.
      */
     void pauseBackgroundMusic();
 
+    /**
+     * @brief Checks whether background music is playing
+     * @return true if the current track is playing
+     */
+    bool isBackgroundMusicPlaying() const;
+
     /**
      * @brief Resumes background music
      */
@@ -102,9 +164,24 @@ public:
 private slots:
     /**
      * @brief Handles the end of a music track
-     * @details Switches to the next track in the playlist
+     * @details Switches to the next track in the playlist if the track ended
+     *          before a crossfade could start, e.g. because it is very short.
+     * @param player Index of the player whose status changed
+     * @param status The new media status
      */
-    void handleMusicEnd(QMediaPlayer::MediaStatus status);
+    void handleMusicEnd(int player, QMediaPlayer::MediaStatus status);
+
+    /**
+     * @brief Starts the crossfade when the playing track is about to end
+     * @param player Index of the player whose position changed
+     * @param position Playback position in milliseconds
+     */
+    void handleMusicPosition(int player, qint64 position);
+
+    /**
+     * @brief Stops the faded-out player and preloads the following track on it
+     */
+    void finishCrossfade();
 
 private:
     /**
@@ -115,17 +192,53 @@ private:
 
     /**
      * @brief Switches to the next background music track
+     * @details Makes the preloaded player active, or loads the track on the active
+     *          player if it was not preloaded, and preloads the track after it.
      */
     void switchToNextTrack();
 
+    /**
+     * @brief Loads the track after the current one on the idle player
+     */
+    void prefetchNextTrack();
+
+    /**
+     * @brief Gets the URL of a playlist entry
+     * @param index Index into the playlist; wraps around
+     * @return The URL
+     */
+    QUrl trackUrl(int index) const;
+
+    /**
+     * @brief Sets the volume of both music players
+     */
+    void applyMusicVolume();
+
+    static const int CROSSFADE_MS = 3000;  ///< Overlap between two tracks
+
+    /**
+     * @brief Voice pool of one registered effect
+     */
+    struct Effect {
+        std::vector<QSoundEffect*> voices;  ///< Preloaded voices, owned by the SoundManager
+        int nextVoice = 0;                  ///< Voice to try first on the next trigger
+        float gain = 1.0f;                  ///< Volume relative to the sound effects volume
+    };
+
     static SoundManager* m_instance;  ///< The singleton instance
-    QSoundEffect m_buttonClick;      ///< Sound effect for button clicks
-    QMediaPlayer m_backgroundMusic;  ///< Media player for background music
-    QAudioOutput* m_audioOutput;      ///< Audio output for background music
+    std::vector<Effect> m_effects;    ///< Registered effects, indexed by ID
+    QHash<QString, int> m_effectIds;  ///< Effect ID for each registered name
+    int m_buttonClickId;              ///< Effect ID of the button click
+    float m_sfxVolume;                ///< Sound effects volume (0-1)
+    QMediaPlayer m_musicPlayers[2];  ///< Playing and preloaded music players
+    QAudioOutput* m_musicOutputs[2];  ///< Audio output of each music player
+    int m_activePlayer;              ///< Index of the player of the current track
+    float m_musicVolume;             ///< Background music volume (0-1)
+    QVariantAnimation* m_crossfade;  ///< Fades from the previous to the active player
     bool m_sfx_muted;                    ///< Whether sound effects are muted
     bool m_bgmusic_muted;               ///< Whether the background music is muted
     int m_currentTrack;              ///< Index of the current track
-    QStringList m_backgroundTracks;  ///< List of background music tracks
+    QList<QUrl> m_backgroundTracks;  ///< List of background music tracks
 };
 
 #endif // SOUNDMANAGER_H 
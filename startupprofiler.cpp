@@ -0,0 +1,283 @@
+/**
+ * @file startupprofiler.cpp
+ * @brief Implementation of the StartupProfiler class
+ * @author Alan Cruz
+ * @details This file implements the phase recording, the first-frame detection and
+ *          the report of the startup profiler.
+ */
+
+#include "startupprofiler.h"
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QEvent>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QStandardPaths>
+#include <QTimer>
+
+namespace {
+
+/// One recorded phase
+struct StartupPhase {
+    const char* name;  ///< Name of the phase
+    qint64 start;      ///< Start time in nanoseconds since enable()
+    qint64 duration;   ///< Duration in nanoseconds
+};
+
+bool enabled = false;          ///< Whether enable() was called
+bool finished = false;         ///< Whether the report was written
+qint64 origin = 0;             ///< Clock value at enable()
+qint64 firstFrame = -1;        ///< Time of the first frame, -1 until it is shown
+QString reportFile;            ///< Report path given to enable()
+std::vector<StartupPhase> phases;  ///< Phases in the order they ended
+
+/**
+ * @brief Reads the monotonic clock
+ * @return Clock value in nanoseconds
+ */
+qint64 clockNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Application event filter waiting for the first paint of a widget
+ */
+class FirstFrameFilter : public QObject
+{
+public:
+    /**
+     * @brief Creates the filter and installs it on the application
+     * @param context Object the callback belongs to
+     * @param callback Function to run after the first frame
+     */
+    FirstFrameFilter(QObject* context, std::function<void()> callback)
+        : m_context(context), m_callback(std::move(callback))
+    {
+        QCoreApplication::instance()->installEventFilter(this);
+    }
+
+    /**
+     * @brief Watches for the first paint event
+     * @param watched The object receiving the event
+     * @param event The event
+     * @return Always false, the event is delivered as usual
+     */
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        if (event->type() == QEvent::Paint && watched->isWidgetType() && m_callback) {
+            QCoreApplication::instance()->removeEventFilter(this);
+
+            // Queued behind the paint, so the frame has been flushed when it runs
+            QPointer<QObject> context = m_context;
+            std::function<void()> callback = std::move(m_callback);
+            QTimer::singleShot(0, QCoreApplication::instance(), [context, callback]() {
+                if (enabled && firstFrame < 0) {
+                    firstFrame = clockNow() - origin;
+                }
+                if (context) {
+                    callback();
+                }
+            });
+            deleteLater();
+        }
+        return false;
+    }
+
+private:
+    QPointer<QObject> m_context;       ///< Object the callback belongs to
+    std::function<void()> m_callback; ///< Function to run after the first frame
+};
+
+/**
+ * @brief Converts nanoseconds to milliseconds
+ * @param nanoseconds The time in nanoseconds
+ * @return The time in milliseconds
+ */
+double toMs(qint64 nanoseconds)
+{
+    return nanoseconds / 1e6;
+}
+
+} // namespace
+
+/**
+ * @brief Starts a phase
+ * @param name Name of the phase; must be a string literal
+ */
+StartupProfiler::Phase::Phase(const char* name)
+    : m_name(name), m_start(enabled && !finished ? now() : -1)
+{
+}
+
+/**
+ * @brief Ends the phase and records it
+ */
+StartupProfiler::Phase::~Phase()
+{
+    if (m_start >= 0) {
+        record(m_name, m_start, now() - m_start);
+    }
+}
+
+/**
+ * @brief Finds the profiling flag in the command line
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return true if "--profile-startup" or "--profile-startup=<file>" was given
+ */
+bool StartupProfiler::enableFromArguments(int argc, char* argv[])
+{
+    static const char flag[] = "--profile-startup";
+    const std::size_t flagLength = sizeof(flag) - 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], flag, flagLength) != 0) {
+            continue;
+        }
+        if (argv[i][flagLength] == '\0') {
+            enable();
+            return true;
+        }
+        if (argv[i][flagLength] == '=') {
+            enable(QString::fromLocal8Bit(argv[i] + flagLength + 1));
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Starts profiling
+ * @param reportPath File to write the report to; empty for
+ *        startup-<date>.json in the application data folder
+ */
+void StartupProfiler::enable(const QString& reportPath)
+{
+    if (enabled) {
+        return;
+    }
+    enabled = true;
+    origin = clockNow();
+    reportFile = reportPath;
+    phases.reserve(32);
+}
+
+/**
+ * @brief Checks whether profiling is on
+ * @return true after enable()
+ */
+bool StartupProfiler::isEnabled()
+{
+    return enabled;
+}
+
+/**
+ * @brief Runs a function once the first frame of the application is on screen
+ * @param context The function is dropped if this object is destroyed first
+ * @param callback The function to run
+ */
+void StartupProfiler::afterFirstFrame(QObject* context, std::function<void()> callback)
+{
+    new FirstFrameFilter(context, std::move(callback));
+}
+
+/**
+ * @brief Ends profiling and writes the report
+ * @details Phases are written as complete events on one track, with the nesting
+ *          given by their times. The summary lists them in the order they ended,
+ *          so a phase appears after the phases nested in it.
+ */
+void StartupProfiler::finish()
+{
+    if (!enabled || finished) {
+        return;
+    }
+    finished = true;
+    const qint64 total = now();
+
+    QJsonArray events;
+    for (const StartupPhase& phase : phases) {
+        QJsonObject object;
+        object["name"] = QString::fromLatin1(phase.name);
+        object["ph"] = "X";
+        object["ts"] = phase.start / 1000.0;
+        object["dur"] = phase.duration / 1000.0;
+        object["pid"] = static_cast<qint64>(QCoreApplication::applicationPid());
+        object["tid"] = 1;
+        events.append(object);
+    }
+    if (firstFrame >= 0) {
+        events.append(QJsonObject{{"name", "First frame"}, {"ph", "i"}, {"s", "g"},
+                                  {"ts", firstFrame / 1000.0},
+                                  {"pid", static_cast<qint64>(QCoreApplication::applicationPid())},
+                                  {"tid", 1}});
+    }
+
+    QJsonObject trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+    trace["otherData"] = QJsonObject{
+        {"firstFrameMs", firstFrame >= 0 ? toMs(firstFrame) : -1.0},
+        {"warmedUpMs", toMs(total)},
+        {"targetFirstFrameMs", TARGET_FIRST_FRAME_MS}
+    };
+
+    qDebug() << "StartupProfiler: phases in ms";
+    for (const StartupPhase& phase : phases) {
+        qDebug().noquote() << QString("  %1 %2 (at %3)")
+            .arg(QString::fromLatin1(phase.name), -24)
+            .arg(toMs(phase.duration), 8, 'f', 2)
+            .arg(toMs(phase.start), 0, 'f', 2);
+    }
+    if (firstFrame >= 0) {
+        qDebug().noquote() << QString("StartupProfiler: first frame after %1 ms (target %2 ms)%3")
+            .arg(toMs(firstFrame), 0, 'f', 1)
+            .arg(TARGET_FIRST_FRAME_MS, 0, 'f', 0)
+            .arg(toMs(firstFrame) > TARGET_FIRST_FRAME_MS ? ", over budget" : "");
+    }
+    qDebug().noquote() << QString("StartupProfiler: warmed up after %1 ms").arg(toMs(total), 0, 'f', 1);
+
+    QString path = reportFile;
+    if (path.isEmpty()) {
+        QString folder = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(folder);
+        path = folder + "/startup-" + QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss") + ".json";
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "StartupProfiler: Could not write" << path;
+        return;
+    }
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Indented));
+    qDebug() << "StartupProfiler: Wrote report to" << path;
+}
+
+/**
+ * @brief Gets the time since enable()
+ * @return Elapsed time in nanoseconds
+ */
+qint64 StartupProfiler::now()
+{
+    return clockNow() - origin;
+}
+
+/**
+ * @brief Records a finished phase
+ * @param name Name of the phase
+ * @param start Start time in nanoseconds
+ * @param duration Duration in nanoseconds
+ */
+void StartupProfiler::record(const char* name, qint64 start, qint64 duration)
+{
+    phases.push_back({name, start, duration});
+}
@@ -0,0 +1,118 @@
+/**
+ * @file startupprofiler.h
+ * @brief Header file for the StartupProfiler class
+ * @author Alan Cruz
+ * @details This file defines the startup profiler, which measures the phases from
+ *          main() to the first frame of the main menu and the background warm-up
+ *          that follows. It is enabled at run time with "--profile-startup".
+ */
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <functional>
+#include <QString>
+#include <QtGlobal>
+
+class QObject;
+
+/**
+ * @brief Records the startup phases of the application and writes a report
+ * @details Until enable() is called every function returns immediately, so the
+ *          phases can stay in the code of release builds. Once enabled, each Phase
+ *          records its start and duration relative to enable(), which main() calls
+ *          before anything else. Phases are recorded on the GUI thread only.
+ *
+ *          The report is written by finish() once the warm-up after the first frame
+ *          is done. It uses the Chrome trace event format, so chrome://tracing and
+ *          ui.perfetto.dev show the phases on a timeline; "otherData" holds the time
+ *          to the first frame and the time until everything was warmed up. A summary
+ *          is also printed with qDebug().
+ */
+class StartupProfiler
+{
+public:
+    static constexpr double TARGET_FIRST_FRAME_MS = 300.0;  ///< Budget for an interactive main menu
+
+    /**
+     * @brief Records a phase from construction to destruction
+     */
+    class Phase
+    {
+    public:
+        /**
+         * @brief Starts a phase
+         * @param name Name of the phase; must be a string literal
+         */
+        explicit Phase(const char* name);
+
+        /**
+         * @brief Ends the phase and records it
+         */
+        ~Phase();
+
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+
+    private:
+        const char* m_name;  ///< Name of the phase
+        qint64 m_start;      ///< Start time in nanoseconds, -1 if profiling is off
+    };
+
+    /**
+     * @brief Finds the profiling flag in the command line
+     * @param argc Number of command line arguments
+     * @param argv Command line arguments
+     * @return true if "--profile-startup" or "--profile-startup=<file>" was given
+     * @details Reads argv directly, so it can run before QApplication exists. The
+     *          flag enables profiling and sets the report path if one was given.
+     */
+    static bool enableFromArguments(int argc, char* argv[]);
+
+    /**
+     * @brief Starts profiling
+     * @param reportPath File to write the report to; empty for
+     *        startup-<date>.json in the application data folder
+     */
+    static void enable(const QString& reportPath = QString());
+
+    /**
+     * @brief Checks whether profiling is on
+     * @return true after enable()
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Runs a function once the first frame of the application is on screen
+     * @param context The function is dropped if this object is destroyed first
+     * @param callback The function to run
+     * @details Waits for the first paint event of any widget and queues the callback
+     *          behind it, so it runs after that frame has been flushed. The time of
+     *          the first frame is recorded when profiling is on. Works whether or not
+     *          profiling is enabled.
+     */
+    static void afterFirstFrame(QObject* context, std::function<void()> callback);
+
+    /**
+     * @brief Ends profiling and writes the report
+     * @details Call once the startup work is done; later calls do nothing.
+     */
+    static void finish();
+
+private:
+    /**
+     * @brief Gets the time since enable()
+     * @return Elapsed time in nanoseconds
+     */
+    static qint64 now();
+
+    /**
+     * @brief Records a finished phase
+     * @param name Name of the phase
+     * @param start Start time in nanoseconds
+     * @param duration Duration in nanoseconds
+     */
+    static void record(const char* name, qint64 start, qint64 duration);
+};
+
+#endif // STARTUPPROFILER_H
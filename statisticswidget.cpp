@@ -1,6 +1,10 @@
 #include "statisticswidget.h"
+#include "notetable.h"
+#include "scoringsystem.h"
+#include "theme.h"
 #include <QFont>
 #include <QFontDatabase>
+#include <QStringList>
 
 /**
  * @file statisticswidget.cpp
@@ -20,6 +24,7 @@ StatisticsWidget::StatisticsWidget(QWidget *parent)
     : QFrame(parent)
     , mainLayout(new QVBoxLayout(this))
     , statsGrid(new QGridLayout())
+    , quizAnalytics(nullptr)
 {
     setupUI();
     updateStatistics();
@@ -55,7 +60,7 @@ QLabel* StatisticsWidget::createStyledLabel(const QString& text)
     font.setBold(true);
     
     label->setFont(font);
-    label->setStyleSheet("QLabel { color: rgb(103, 49, 0); }"); // Brown color
+    Theme::setRole(label, Theme::TEXT); // Brown color
     label->setAlignment(Qt::AlignCenter);
     
     return label;
@@ -76,7 +81,7 @@ void StatisticsWidget::setupUI()
     // Set frame style
     setFrameShape(QFrame::StyledPanel);
     setFrameShadow(QFrame::Raised);
-    setStyleSheet("QFrame { background-color: rgba(255, 255, 255, 0.9); border-radius: 10px; }");
+    Theme::setRole(this, Theme::PANEL);
     
     // Create headers
     lessonHeader = createStyledLabel("Lesson");
@@ -114,8 +119,12 @@ void StatisticsWidget::setupUI()
     // Add some spacing
     statsGrid->setSpacing(20);
     
-    // Add the grid to the main layout
+    // Add the grid to the main layout, with the quiz analytics below it
     mainLayout->addLayout(statsGrid);
+    quizLabel = createStyledLabel("");
+    quizLabel->setWordWrap(true);
+    mainLayout->addSpacing(20);
+    mainLayout->addWidget(quizLabel);
     mainLayout->addStretch();
     
     // Set margins for the main layout
@@ -131,44 +140,66 @@ void StatisticsWidget::setupUI()
  * - Average score
  * - Total number of attempts
  * 
- * If no data exists for a topic, displays zeros.
+ * If no data exists for a topic, displays zeros. The values come from the
+ * running aggregates, so this does not depend on the length of the history.
  */
 void StatisticsWidget::updateStatistics()
 {
     LoadDataManager* dataManager = LoadDataManager::instance();
-    QJsonObject data = dataManager->getData();
-    QJsonObject topics = data["lessons"].toObject()["topics"].toObject();
     
     // Update statistics for each topic
     for(int i = 0; i < 6; ++i) {
-        QString topicId = QString::number(101 + i);
-        QJsonObject topic = topics[topicId].toObject();
-        QJsonObject stats = topic["statistics"].toObject();
-        
-        QJsonArray scores = stats["scores"].toArray();
-        QJsonArray accuracies = stats["accuracy"].toArray();
-        QJsonArray attempts = stats["attempts"].toArray();
+        TopicStatistics stats = dataManager->getTopicStatistics(101 + i);
         
-        // Calculate averages
-        double avgAccuracy = 0.0;
-        double avgScore = 0.0;
-        int totalAttempts = attempts.size();
-        
-        if (totalAttempts > 0) {
-            for (const QJsonValue& acc : accuracies) {
-                avgAccuracy += acc.toDouble();
-            }
-            avgAccuracy /= totalAttempts;
-            
-            for (const QJsonValue& score : scores) {
-                avgScore += score.toDouble();
-            }
-            avgScore /= totalAttempts;
-        }
+        double avgAccuracy = stats.accuracy.mean();
+        double avgScore = stats.scores.mean();
+        qint64 totalAttempts = stats.scores.count();
         
         // Update labels
         accuracyLabels[i]->setText(QString::number(avgAccuracy, 'f', 1) + "%");
         scoreLabels[i]->setText(QString::number(avgScore, 'f', 1));
         attemptsLabels[i]->setText(QString::number(totalAttempts));
     }
+
+    if (!quizAnalytics || quizAnalytics->getAttempts() == 0) {
+        quizLabel->setText("Quiz weak spots: play a quiz to find them");
+        return;
+    }
+
+    // Name every weak pitch class, and what is most often played instead of it
+    QStringList weakSpots;
+    const quint16 weak = quizAnalytics->weakPitchClasses();
+    for (int pitchClass = 0; pitchClass < ScoringSystem::PITCH_CLASS_COUNT; ++pitchClass) {
+        if (!(weak & (1u << pitchClass))) {
+            continue;
+        }
+        QString name = NoteTable::name(NoteTable::MIDDLE_C + pitchClass);
+        name.chop(1);  // Drop the octave
+        int confusedWith = quizAnalytics->mostConfusedWith(pitchClass);
+        if (confusedWith >= 0) {
+            QString played = NoteTable::name(NoteTable::MIDDLE_C + confusedWith);
+            played.chop(1);
+            name += " (often played as " + played + ")";
+        }
+        weakSpots.append(name);
+    }
+
+    QString text = "Quiz weak spots: " + (weakSpots.isEmpty() ? QString("none yet") : weakSpots.join(", "));
+    text += QString("   Recent accuracy: %1%").arg(quizAnalytics->getWeightedAccuracy() * 100.0f, 0, 'f', 0);
+    const qint64 median = quizAnalytics->medianResponseMs();
+    if (median > 0) {
+        text += QString("   Typical answer: %1 s").arg(median / 1000.0, 0, 'f', 1);
+    }
+    quizLabel->setText(text);
+}
+
+/**
+ * @brief Sets the analytics the quiz line is read from
+ * @param scoring The quiz engine's scoring system, or nullptr if no quiz was played
+ *
+ * The values are shown by the next updateStatistics().
+ */
+void StatisticsWidget::setQuizAnalytics(const ScoringSystem* scoring)
+{
+    quizAnalytics = scoring;
 } 
\ No newline at end of file
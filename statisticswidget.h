@@ -8,6 +8,8 @@
 #include <QGridLayout>
 #include "loaddatamanager.h"
 
+class ScoringSystem;
+
 /**
  * @file statisticswidget.h
  * @author Alan Cruz
@@ -23,7 +25,9 @@
  * - Total number of attempts
  * 
  * The statistics are automatically loaded from the LoadDataManager and displayed
- * in a formatted grid with headers and styled labels.
+ * in a formatted grid with headers and styled labels. Below the grid, the weak
+ * spots, recent accuracy and typical answer time of the quiz are read from the
+ * quiz engine's ScoringSystem.
  */
 class StatisticsWidget : public QFrame
 {
@@ -41,6 +45,20 @@ public:
      */
     ~StatisticsWidget();
 
+    /**
+     * @brief Updates the statistics display with current data
+     * 
+     * Loads the latest statistics from LoadDataManager and updates
+     * all labels with the current values for each lesson topic.
+     */
+    void updateStatistics();
+
+    /**
+     * @brief Sets the analytics the quiz line is read from
+     * @param scoring The quiz engine's scoring system, or nullptr if no quiz was played
+     */
+    void setQuizAnalytics(const ScoringSystem* scoring);
+
 private:
     /**
      * @brief Sets up the user interface components
@@ -50,14 +68,6 @@ private:
      */
     void setupUI();
 
-    /**
-     * @brief Updates the statistics display with current data
-     * 
-     * Loads the latest statistics from LoadDataManager and updates
-     * all labels with the current values for each lesson topic.
-     */
-    void updateStatistics();
-
     /**
      * @brief Creates a styled QLabel with consistent formatting
      * @param text The text to display in the label
@@ -80,6 +90,9 @@ private:
     QLabel* accuracyLabels[6];  ///< Labels for average accuracy
     QLabel* scoreLabels[6];     ///< Labels for average scores
     QLabel* attemptsLabels[6];  ///< Labels for total attempts
+
+    QLabel* quizLabel;          ///< Weak spots and answer speed of the quiz
+    const ScoringSystem* quizAnalytics;  ///< Analytics of the quiz, not owned; may be null
     
     /** @brief Mapping of topic IDs to their display names */
     const QMap<QString, QString> topicNames = {
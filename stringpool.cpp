@@ -0,0 +1,67 @@
+/**
+ * @file stringpool.cpp
+ * @brief Implementation of the StringPool class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file implements the interned string table shared by all questions.
+ */
+
+#include "stringpool.h"
+
+// Initialize static member
+StringPool* StringPool::m_instance = nullptr;
+
+/**
+ * @brief Gets the application-wide string pool
+ * @return Pointer to the shared StringPool instance
+ */
+StringPool* StringPool::instance()
+{
+    if (!m_instance) {
+        m_instance = new StringPool();
+    }
+    return m_instance;
+}
+
+/**
+ * @brief Creates a pool holding only the empty string
+ */
+StringPool::StringPool()
+{
+    m_strings.emplace_back();
+    m_ids.insert(QString(), EMPTY);
+}
+
+/**
+ * @brief Interns a string
+ * @param text The string to intern
+ * @return The ID of the pooled copy; the same ID for equal strings
+ */
+StringPool::Id StringPool::intern(const QString& text)
+{
+    if (text.isEmpty()) {
+        return EMPTY;
+    }
+
+    auto it = m_ids.constFind(text);
+    if (it != m_ids.constEnd()) {
+        return it.value();
+    }
+
+    Id id = static_cast<Id>(m_strings.size());
+    m_strings.push_back(text);
+    m_ids.insert(text, id);
+    return id;
+}
+
+/**
+ * @brief Gets an interned string
+ * @param id The ID returned by intern()
+ * @return The pooled string, or the empty string if the ID is unknown
+ */
+const QString& StringPool::string(Id id) const
+{
+    if (id >= m_strings.size()) {
+        return m_strings.front();
+    }
+    return m_strings[id];
+}
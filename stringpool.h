@@ -0,0 +1,78 @@
+/**
+ * @file stringpool.h
+ * @brief Header file for the StringPool class
+ * @author Alan Cruz, Sarah Lahourpour
+ * @details This file defines StringPool, the process-wide table of interned
+ *          strings that keeps the text of questions out of the Question records.
+ */
+
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <deque>
+#include <QHash>
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @brief Process-wide pool of interned, immutable strings
+ * @details Every distinct string is stored once and referred to by a 32-bit ID, so
+ *          a topic name shared by every question of a topic costs one string, and
+ *          a record holding text only has to hold IDs. ID 0 is always the empty
+ *          string.
+ *
+ *          Strings are never removed, and references returned by string() stay
+ *          valid for the rest of the process. The pool is not thread-safe and is
+ *          only used from the GUI thread.
+ */
+class StringPool
+{
+public:
+    using Id = quint32;  ///< Handle of an interned string
+
+    static constexpr Id EMPTY = 0;  ///< ID of the empty string
+
+    /**
+     * @brief Gets the application-wide string pool
+     * @return Pointer to the shared StringPool instance
+     */
+    static StringPool* instance();
+
+    /**
+     * @brief Interns a string
+     * @param text The string to intern
+     * @return The ID of the pooled copy; the same ID for equal strings
+     * @details A string created with QString::fromRawData() is pooled without a
+     *          copy, so its data has to stay alive for the rest of the process.
+     */
+    Id intern(const QString& text);
+
+    /**
+     * @brief Gets an interned string
+     * @param id The ID returned by intern()
+     * @return The pooled string, or the empty string if the ID is unknown
+     */
+    const QString& string(Id id) const;
+
+    /**
+     * @brief Gets the number of distinct strings in the pool
+     * @return The string count, including the empty string
+     */
+    int size() const { return static_cast<int>(m_strings.size()); }
+
+private:
+    /**
+     * @brief Creates a pool holding only the empty string
+     */
+    StringPool();
+
+    static StringPool* m_instance;  ///< The application-wide instance
+
+    /// Pooled strings indexed by ID; a deque keeps references stable as it grows
+    std::deque<QString> m_strings;
+
+    /// Maps every pooled string to its ID
+    QHash<QString, Id> m_ids;
+};
+
+#endif // STRINGPOOL_H
@@ -0,0 +1,81 @@
+/**
+ * @file audiotest.cpp
+ * @brief Tests of the piano's audio output
+ * @author Alan Cruz
+ * @details This file implements the audiotest console tool, a QTest suite that
+ *          runs a Keyboard on the real audio driver. A note counts as heard once
+ *          the audio callback has applied it, which the record queue shows.
+ */
+
+#include <QLoggingCategory>
+#include <QStandardPaths>
+#include <QTest>
+#include "keyboard.h"
+
+/**
+ * @brief Test cases of the Keyboard's audio driver
+ */
+class AudioTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Keeps the output to the results and the settings out of the player's data
+     */
+    void initTestCase();
+
+    /**
+     * @brief A MIDI note that arrives while the driver is suspended is heard after resumeAudio()
+     */
+    void externalNoteWhileSuspended();
+
+private:
+    static const int SOUNDFONT_TIMEOUT_MS = 60000;  ///< Time allowed to load and extract the SoundFont
+};
+
+void AudioTest::initTestCase()
+{
+    QLoggingCategory::setFilterRules("*.debug=false");
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void AudioTest::externalNoteWhileSuspended()
+{
+    Keyboard keyboard;
+
+    // The callback drops queued events until the SoundFont has loaded, and the
+    // first run also extracts it to the test-mode cache
+    if (!QTest::qWaitFor([&keyboard]() { return keyboard.isReady(); }, SOUNDFONT_TIMEOUT_MS)) {
+        QSKIP("The SoundFont did not load");
+    }
+
+    keyboard.suspendAudio();
+    if (!keyboard.isAudioSuspended()) {
+        QSKIP("No audio driver could be opened");
+    }
+    keyboard.setRecording(true);
+
+    // What MidiInput::handleMidiEvent() queues on the MIDI thread
+    MidiEvent note;
+    note.type = MidiEvent::NoteOn;
+    note.key = 60;
+    note.velocity = 100;
+    note.time = MidiEventQueue::now();
+    QVERIFY(keyboard.queueExternalEvent(note));
+
+    // Nothing renders while the driver is closed
+    QTest::qWait(100);
+    QVERIFY(!keyboard.recordQueue().peek());
+
+    keyboard.resumeAudio();
+    QTRY_VERIFY_WITH_TIMEOUT(keyboard.recordQueue().peek() != nullptr, 1000);
+    const MidiEvent* heard = keyboard.recordQueue().peek();
+    QCOMPARE(heard->type, MidiEvent::NoteOn);
+    QCOMPARE(int(heard->key), 60);
+    QCOMPARE(int(heard->velocity), 100);
+}
+
+QTEST_GUILESS_MAIN(AudioTest)
+
+#include "audiotest.moc"
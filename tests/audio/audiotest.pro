@@ -0,0 +1,56 @@
+# Tests of the piano's audio output that need FluidSynth and an audio device.
+# Build from the repository root with "qmake tests/audio/audiotest.pro" and
+# "make", then run "./audiotest". Cases that cannot open an audio driver are
+# skipped rather than failed.
+QT       = core testlib
+CONFIG  += console c++17 testcase
+CONFIG  -= app_bundle
+TARGET   = audiotest
+
+KEYQUEST_ROOT = $$PWD/../..
+INCLUDEPATH += $$KEYQUEST_ROOT
+
+unix:!macx {
+    INCLUDEPATH += /usr/include
+    LIBS += -L/usr/lib -lfluidsynth
+}
+
+macx {
+    INCLUDEPATH += /opt/homebrew/include
+    LIBS += -L/opt/homebrew/lib -lfluidsynth
+}
+
+SOURCES += \
+    audiotest.cpp \
+    $$KEYQUEST_ROOT/datawriter.cpp \
+    $$KEYQUEST_ROOT/keyboard.cpp \
+    $$KEYQUEST_ROOT/loaddatamanager.cpp \
+    $$KEYQUEST_ROOT/midieventqueue.cpp \
+    $$KEYQUEST_ROOT/notesampler.cpp \
+    $$KEYQUEST_ROOT/qtable.cpp \
+    $$KEYQUEST_ROOT/quizhistory.cpp \
+    $$KEYQUEST_ROOT/reviewschedule.cpp \
+    $$KEYQUEST_ROOT/runningstats.cpp \
+    $$KEYQUEST_ROOT/sessionlog.cpp \
+    $$KEYQUEST_ROOT/soundfontloader.cpp \
+    $$KEYQUEST_ROOT/trace.cpp
+
+HEADERS += \
+    $$KEYQUEST_ROOT/datawriter.h \
+    $$KEYQUEST_ROOT/keyboard.h \
+    $$KEYQUEST_ROOT/loaddatamanager.h \
+    $$KEYQUEST_ROOT/midieventqueue.h \
+    $$KEYQUEST_ROOT/notesampler.h \
+    $$KEYQUEST_ROOT/qtable.h \
+    $$KEYQUEST_ROOT/quizhistory.h \
+    $$KEYQUEST_ROOT/quizreport.h \
+    $$KEYQUEST_ROOT/reviewschedule.h \
+    $$KEYQUEST_ROOT/runningstats.h \
+    $$KEYQUEST_ROOT/sessionlog.h \
+    $$KEYQUEST_ROOT/soundfontloader.h \
+    $$KEYQUEST_ROOT/state.h \
+    $$KEYQUEST_ROOT/trace.h
+
+# The piano SoundFont
+RESOURCES += \
+    $$KEYQUEST_ROOT/soundFiles.qrc
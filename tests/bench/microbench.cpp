@@ -0,0 +1,654 @@
+/**
+ * @file microbench.cpp
+ * @brief Micro-benchmarks of the KeyQuest hot paths
+ * @author Alan Cruz
+ * @details This file implements the microbench console tool, a QTest benchmark of
+ *          the code that runs on every key press, question, save and repaint. Each
+ *          case reports the wall time of one run and the number of heap allocations
+ *          it makes. The results can be saved as a baseline and later runs compared
+ *          with it, so an optimization can be shown to help and a regression is
+ *          caught before it ships.
+ *
+ *          Example:
+ *              microbench --save-baseline tests/bench/baselines/<machine>.csv
+ *              microbench --compare tests/bench/baselines/<machine>.csv --tolerance 5
+ *              microbench --compare tests/bench/baselines/<machine>.csv paintBackground
+ */
+
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <vector>
+#include <QApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QPixmap>
+#include <QRegularExpression>
+#include <QResizeEvent>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTextStream>
+#include "adaptivequiz.h"
+#include "backgroundpage.h"
+#include "datawriter.h"
+#include "loaddatamanager.h"
+#include "noteset.h"
+#include "qtable.h"
+#include "questionbank.h"
+#include "questionloader.h"
+
+/// Heap allocations made by the calling thread so far
+static thread_local quint64 allocationCount = 0;
+
+#if defined(__GLIBC__)
+// glibc lets a program replace malloc() and friends. Counting there also sees the
+// allocations of Qt's containers, which bypass operator new.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* memory, size_t size);
+void __libc_free(void* memory);
+
+/**
+ * @brief Counting replacement of malloc()
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory
+ */
+void* malloc(size_t size) __THROW
+{
+    ++allocationCount;
+    return __libc_malloc(size);
+}
+
+/**
+ * @brief Counting replacement of calloc()
+ * @param count Number of elements
+ * @param size Size of an element
+ * @return Pointer to the zeroed memory
+ */
+void* calloc(size_t count, size_t size) __THROW
+{
+    ++allocationCount;
+    return __libc_calloc(count, size);
+}
+
+/**
+ * @brief Counting replacement of realloc()
+ * @param memory Memory to resize, or nullptr
+ * @param size New size in bytes
+ * @return Pointer to the resized memory
+ */
+void* realloc(void* memory, size_t size) __THROW
+{
+    ++allocationCount;
+    return __libc_realloc(memory, size);
+}
+
+/**
+ * @brief Replacement of free() matching the ones above
+ * @param memory Memory to release
+ */
+void free(void* memory) __THROW
+{
+    __libc_free(memory);
+}
+}
+#else
+/**
+ * @brief Counting replacement of the global allocation function
+ * @param size Number of bytes to allocate
+ * @return Pointer to the allocated memory
+ * @details Without glibc only operator new is counted, so Qt containers, which
+ *          allocate with malloc() directly, are missing from the figure.
+ */
+void* operator new(std::size_t size)
+{
+    ++allocationCount;
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+/**
+ * @brief Replacement of the global deallocation function matching operator new
+ * @param memory Pointer returned by operator new
+ */
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+/**
+ * @brief Sized replacement of the global deallocation function
+ * @param memory Pointer returned by operator new
+ */
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+#endif
+
+/// Metric name of the allocation counts in the result files
+static const QString ALLOCATIONS_METRIC = "Allocations";
+
+/// Allocations of one run of each case, by case name
+static std::map<QString, quint64> caseAllocations;
+
+/// Keeps results alive so the compiler cannot drop the work that produced them
+static volatile qint64 sink = 0;
+
+/**
+ * @brief Gets the name of the running case
+ * @return "function" or "function/data tag"
+ */
+static QString currentCaseName()
+{
+    const QString tag = QTest::currentDataTag() ? QString(QTest::currentDataTag()) : QString();
+    const QString function = QTest::currentTestFunction();
+    return tag.isEmpty() ? function : function + "/" + tag;
+}
+
+/**
+ * @brief Counts the allocations of one run of a case and then times it
+ * @param body One run of the case
+ * @details The first run warms up caches and lazy initialization, the second is
+ *          counted, and QBENCHMARK repeats the body until the time is stable.
+ */
+template <typename Body>
+static void measure(Body body)
+{
+    body();
+    const quint64 before = allocationCount;
+    body();
+    caseAllocations[currentCaseName()] = allocationCount - before;
+
+    QBENCHMARK {
+        body();
+    }
+}
+
+/**
+ * @brief The benchmark cases
+ */
+class MicroBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Loads the question bank and trains a Q-table shared by the cases
+     */
+    void initTestCase();
+
+    /**
+     * @brief Note names of the noteNameToMidi() case
+     */
+    void noteNameToMidi_data();
+
+    /**
+     * @brief Parses a note name, as the answer keys and MIDI input do
+     */
+    void noteNameToMidi();
+
+    /**
+     * @brief Expected inputs of the parseAnswer() case
+     */
+    void parseAnswer_data();
+
+    /**
+     * @brief Turns an expected input into the note set answers are compared with
+     */
+    void parseAnswer();
+
+    /**
+     * @brief Played notes and answers of the isAnsweredBy() case
+     */
+    void isAnsweredBy_data();
+
+    /**
+     * @brief Collects played notes and judges them, as submitting a chord does
+     */
+    void isAnsweredBy();
+
+    /**
+     * @brief Reads and parses the bundled question bank
+     */
+    void loadQuestionsFromFile();
+
+    /**
+     * @brief Reads the bundled question bank and builds its indexes
+     */
+    void loadQuestionBank();
+
+    /**
+     * @brief Selects the next quiz question
+     */
+    void getNextAction();
+
+    /**
+     * @brief Scores an answer and updates the Q-table
+     */
+    void evaluateResponse();
+
+    /**
+     * @brief Gets the active player's Q-table
+     */
+    void getQTable();
+
+    /**
+     * @brief Stores the Q-table for the next write
+     */
+    void saveQTable();
+
+    /**
+     * @brief Hands all data to the writer thread
+     */
+    void saveData();
+
+    /**
+     * @brief Serializes and replaces a data file, as the writer thread does
+     */
+    void writeData();
+
+    /**
+     * @brief Window sizes of the paintBackground() case
+     */
+    void paintBackground_data();
+
+    /**
+     * @brief Repaints a background page whose scaled image is cached
+     */
+    void paintBackground();
+
+    /**
+     * @brief Window sizes of the resizeBackground() case
+     */
+    void resizeBackground_data();
+
+    /**
+     * @brief Repaints a background page after a resize, which scales the image
+     */
+    void resizeBackground();
+
+private:
+    /**
+     * @brief Adds the common window sizes as data rows
+     */
+    static void addWindowSizes();
+
+    QuestionBank bank;        // Bundled question bank
+    QTable table;             // Q-table trained on a few hundred answers
+    QTemporaryDir writeDir;   // Files written by writeData()
+};
+
+void MicroBench::initTestCase()
+{
+    QVERIFY(bank.loadFromFile(":/resources/questionBank.json"));
+    QVERIFY(writeDir.isValid());
+
+    AdaptiveQuiz quiz(bank, table, State(), 1);
+    for (int i = 0; i < 500; ++i) {
+        quiz.evaluateResponse(quiz.getNextAction(), i % 3 != 0);
+    }
+}
+
+void MicroBench::noteNameToMidi_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::newRow("natural") << "C";
+    QTest::newRow("octave") << "C4";
+    QTest::newRow("sharp") << "F#3";
+    QTest::newRow("double flat") << "Ebb";
+}
+
+void MicroBench::noteNameToMidi()
+{
+    QFETCH(QString, name);
+    measure([&]() { sink = sink + NoteSet::noteNameToMidi(name); });
+}
+
+void MicroBench::parseAnswer_data()
+{
+    QTest::addColumn<QString>("expected");
+    QTest::newRow("note") << "Ebb";
+    QTest::newRow("triad") << "C-E-G";
+    QTest::newRow("octave triad") << "C4-E4-G4";
+    QTest::newRow("scale") << "C4-D4-E4-F4-G4-A4-B4-C5";
+}
+
+void MicroBench::parseAnswer()
+{
+    QFETCH(QString, expected);
+    measure([&]() { sink = sink + NoteSet::fromString(expected).pitchClassMask(); });
+}
+
+void MicroBench::isAnsweredBy_data()
+{
+    QTest::addColumn<QString>("expected");
+    QTest::addColumn<QList<int>>("played");
+    QTest::newRow("note") << "Ebb" << QList<int>{62};
+    QTest::newRow("triad") << "C-E-G" << QList<int>{64, 67, 72};
+    QTest::newRow("octave triad") << "C4-E4-G4" << QList<int>{60, 64, 67};
+    QTest::newRow("wrong seventh") << "G-B-D-F" << QList<int>{55, 59, 62, 66};
+}
+
+void MicroBench::isAnsweredBy()
+{
+    QFETCH(QString, expected);
+    QFETCH(QList<int>, played);
+    const NoteSet answer = NoteSet::fromString(expected);
+    measure([&]() {
+        NoteSet chord;
+        for (int note : played) {
+            chord.addMidiNote(note);
+        }
+        sink = sink + answer.isAnsweredBy(chord);
+    });
+}
+
+void MicroBench::loadQuestionsFromFile()
+{
+    measure([]() { sink = sink + qint64(::loadQuestionsFromFile(":/resources/questionBank.json").size()); });
+}
+
+void MicroBench::loadQuestionBank()
+{
+    QuestionBank loaded;
+    measure([&]() { sink = sink + loaded.loadFromFile(":/resources/questionBank.json"); });
+}
+
+void MicroBench::getNextAction()
+{
+    QTable quizTable = table;
+    AdaptiveQuiz quiz(bank, quizTable, State(), 2);
+    measure([&]() { sink = sink + quiz.getNextAction(); });
+}
+
+void MicroBench::evaluateResponse()
+{
+    QTable quizTable = table;
+    AdaptiveQuiz quiz(bank, quizTable, State(), 3);
+    const int questionID = quiz.getNextAction();
+    bool correct = false;
+    measure([&]() {
+        correct = !correct;
+        quiz.evaluateResponse(questionID, correct);
+    });
+}
+
+void MicroBench::getQTable()
+{
+    LoadDataManager* data = LoadDataManager::instance();
+    measure([&]() { sink = sink + data->getQTable().actionCount(); });
+}
+
+void MicroBench::saveQTable()
+{
+    LoadDataManager* data = LoadDataManager::instance();
+    measure([&]() { data->saveQTable(table); });
+}
+
+void MicroBench::saveData()
+{
+    LoadDataManager* data = LoadDataManager::instance();
+    measure([&]() { sink = sink + data->saveData(); });
+}
+
+void MicroBench::writeData()
+{
+    DataWriter writer;
+    const QString path = writeDir.filePath("profile.json");
+    QJsonObject lessons;
+    for (int topic = 101; topic <= 106; ++topic) {
+        lessons.insert(QString::number(topic), QJsonObject{{"attempts", 12}, {"bestScore", 900}, {"accuracy", 87.5}});
+    }
+    const QJsonObject data{{"lessons", lessons}, {"qtable", QJsonObject()}};
+    const QStringList sections{"lessons", "qtable"};
+    const auto snapshot = std::make_shared<const QTable>(table);
+    measure([&]() { writer.write(path, data, sections, snapshot); });
+}
+
+void MicroBench::addWindowSizes()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::newRow("1280x720") << QSize(1280, 720);
+    QTest::newRow("1920x1080") << QSize(1920, 1080);
+    QTest::newRow("2560x1440") << QSize(2560, 1440);
+    QTest::newRow("3840x2160") << QSize(3840, 2160);
+}
+
+void MicroBench::paintBackground_data()
+{
+    addWindowSizes();
+}
+
+void MicroBench::paintBackground()
+{
+    QFETCH(QSize, size);
+    BackgroundPage page;
+    page.resize(size);
+    QPixmap target(size);
+    measure([&]() { page.render(&target); });
+}
+
+void MicroBench::resizeBackground_data()
+{
+    addWindowSizes();
+}
+
+void MicroBench::resizeBackground()
+{
+    QFETCH(QSize, size);
+    BackgroundPage page;
+    page.resize(size);
+    QPixmap target(size);
+    measure([&]() {
+        QResizeEvent event(size, size);
+        QCoreApplication::sendEvent(&page, &event);
+        page.render(&target);
+    });
+}
+
+/**
+ * @brief One measurement of one case
+ */
+struct BenchResult {
+    QString name;        ///< "function" or "function/data tag"
+    QString metric;      ///< QTest metric name, or ALLOCATIONS_METRIC
+    double value = 0.0;  ///< Value of one run
+};
+
+/**
+ * @brief Reads results in QTest's CSV format
+ * @param path The file, written by QTest or by writeResults()
+ * @param results Receives the results
+ * @return true if the file could be read
+ * @details Only the first four columns are used: function, data tag, metric and
+ *          the value per run.
+ */
+static bool readResults(const QString& path, std::vector<BenchResult>& results)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    static const QRegularExpression line("^\"([^\"]*)\",\"([^\"]*)\",\"([^\"]*)\",([^,\\s]+)");
+    while (!file.atEnd()) {
+        const QRegularExpressionMatch match = line.match(QString::fromUtf8(file.readLine()));
+        if (!match.hasMatch()) {
+            continue;
+        }
+        const QString tag = match.captured(2);
+        results.push_back({tag.isEmpty() ? match.captured(1) : match.captured(1) + "/" + tag,
+                           match.captured(3), match.captured(4).toDouble()});
+    }
+    return true;
+}
+
+/**
+ * @brief Writes results in the format readResults() reads
+ * @param path The file; its folder is created if needed
+ * @param results The results
+ * @return true if the file was written
+ */
+static bool writeResults(const QString& path, const std::vector<BenchResult>& results)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream out(&file);
+    for (const BenchResult& result : results) {
+        const int slash = result.name.indexOf('/');
+        const QString function = slash < 0 ? result.name : result.name.left(slash);
+        const QString tag = slash < 0 ? QString() : result.name.mid(slash + 1);
+        out << '"' << function << "\",\"" << tag << "\",\"" << result.metric << "\","
+            << QString::number(result.value, 'g', 13) << "\n";
+    }
+    return true;
+}
+
+/**
+ * @brief Compares results with a baseline and prints the differences
+ * @param baseline The baseline results
+ * @param results The results of this run
+ * @param tolerance Fraction a value may grow by before it counts as a regression
+ * @param out Receives the comparison table
+ * @param compared Receives the number of results found in the baseline
+ * @return Number of regressions
+ * @details Cases missing from the baseline are listed as new and are not counted.
+ */
+static int compareResults(const std::vector<BenchResult>& baseline, const std::vector<BenchResult>& results,
+                          double tolerance, QTextStream& out, int& compared)
+{
+    std::map<QString, double> baselineValues;
+    for (const BenchResult& result : baseline) {
+        baselineValues[result.name + " " + result.metric] = result.value;
+    }
+
+    int regressions = 0;
+    compared = 0;
+    out << "\ncase                                metric                baseline       current  change\n";
+    for (const BenchResult& result : results) {
+        out << result.name.leftJustified(35) << ' ' << result.metric.leftJustified(20);
+        auto it = baselineValues.find(result.name + " " + result.metric);
+        if (it == baselineValues.end()) {
+            out << qSetFieldWidth(10) << "-" << qSetFieldWidth(14) << result.value << qSetFieldWidth(0) << "  new\n";
+            continue;
+        }
+
+        const double base = it->second;
+        ++compared;
+        const bool regressed = result.value > base * (1.0 + tolerance);
+        const bool improved = result.value < base * (1.0 - tolerance);
+        regressions += regressed ? 1 : 0;
+        out << qSetFieldWidth(10) << base << qSetFieldWidth(14) << result.value << qSetFieldWidth(0) << "  "
+            << (base > 0 ? QString::asprintf("%+.1f%%", 100.0 * (result.value - base) / base) : QString("-"))
+            << (regressed ? "  REGRESSION" : improved ? "  improved" : "") << "\n";
+    }
+    out << "\n" << regressions << " regression(s) beyond " << 100.0 * tolerance << "%\n";
+    return regressions;
+}
+
+/**
+ * @brief Entry point of the benchmark
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return 0 on success, 1 if a case failed, a regression was found or a file could not be read or written
+ * @details "--save-baseline <file>" writes the results of the run, "--compare <file>"
+ *          compares them with a saved run and "--tolerance <percent>" sets how much
+ *          slower a case may get (10% by default). Every other argument is passed to
+ *          QTest, e.g. case names or "-iterations 1000". Without a display the
+ *          offscreen platform is used. A baseline that is missing, empty or shares
+ *          no case with the run is an error, reported before any case runs when
+ *          possible.
+ */
+int main(int argc, char* argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    // The code under test logs every load and save; keep the output to the results
+    QLoggingCategory::setFilterRules("*.debug=false");
+    // LoadDataManager reads and writes a scratch data folder instead of the player's
+    QStandardPaths::setTestModeEnabled(true);
+
+    QString baselinePath;
+    QString savePath;
+    double tolerance = 0.10;
+    const QStringList arguments = app.arguments();
+    QStringList testArguments{arguments.first()};
+    for (int i = 1; i < arguments.size(); ++i) {
+        const QString& argument = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.size();
+        if (argument == "--compare" && hasValue) {
+            baselinePath = arguments.at(++i);
+        } else if (argument == "--save-baseline" && hasValue) {
+            savePath = arguments.at(++i);
+        } else if (argument == "--tolerance" && hasValue) {
+            tolerance = arguments.at(++i).toDouble() / 100.0;
+        } else {
+            testArguments << argument;
+        }
+    }
+
+    // A comparison without a baseline would pass without checking anything
+    std::vector<BenchResult> baseline;
+    if (!baselinePath.isEmpty()) {
+        if (!readResults(baselinePath, baseline)) {
+            out << "microbench: could not read the baseline " << baselinePath
+                << "; record one on this machine with --save-baseline first\n";
+            return 1;
+        }
+        if (baseline.empty()) {
+            out << "microbench: the baseline " << baselinePath << " holds no results\n";
+            return 1;
+        }
+    }
+
+    QTemporaryDir resultsDir;
+    const QString resultsPath = resultsDir.filePath("results.csv");
+    testArguments << "-o" << resultsPath + ",csv" << "-o" << "-,txt";
+
+    MicroBench bench;
+    const int failures = QTest::qExec(&bench, testArguments);
+
+    std::vector<BenchResult> results;
+    if (!readResults(resultsPath, results)) {
+        out << "microbench: no results written by QTest\n";
+        return 1;
+    }
+    for (const auto& [name, count] : caseAllocations) {
+        results.push_back({name, ALLOCATIONS_METRIC, double(count)});
+    }
+
+    if (!savePath.isEmpty()) {
+        if (!writeResults(savePath, results)) {
+            out << "microbench: could not write " << savePath << "\n";
+            return 1;
+        }
+        out << "Baseline written to " << savePath << "\n";
+    }
+
+    int regressions = 0;
+    if (!baselinePath.isEmpty()) {
+        int compared = 0;
+        regressions = compareResults(baseline, results, tolerance, out, compared);
+        if (compared == 0) {
+            out << "microbench: no case of this run is in the baseline " << baselinePath << "\n";
+            return 1;
+        }
+    }
+    return failures > 0 || regressions > 0 ? 1 : 0;
+}
+
+#include "microbench.moc"
@@ -0,0 +1,68 @@
+# Micro-benchmarks of the note parsing, answer checking, question loading, quiz,
+# save and background painting hot paths.
+# Build from the repository root with "qmake tests/bench/microbench.pro" and "make",
+# then run "./microbench --save-baseline <file>" once and "./microbench --compare
+# <file>" after a change. It uses the offscreen platform when there is no display
+# and needs no FluidSynth.
+QT       = core gui widgets testlib
+CONFIG  += console c++17 release
+CONFIG  -= app_bundle
+TARGET   = microbench
+
+KEYQUEST_ROOT = $$PWD/../..
+INCLUDEPATH += $$KEYQUEST_ROOT
+
+# Same optimization profiles as the application (CONFIG+=performance, pgo_*)
+include($$KEYQUEST_ROOT/buildprofile.pri)
+
+SOURCES += \
+    microbench.cpp \
+    $$KEYQUEST_ROOT/adaptivequiz.cpp \
+    $$KEYQUEST_ROOT/backgroundpage.cpp \
+    $$KEYQUEST_ROOT/backgroundrenderer.cpp \
+    $$KEYQUEST_ROOT/datawriter.cpp \
+    $$KEYQUEST_ROOT/gamesession.cpp \
+    $$KEYQUEST_ROOT/loaddatamanager.cpp \
+    $$KEYQUEST_ROOT/memorymonitor.cpp \
+    $$KEYQUEST_ROOT/noteset.cpp \
+    $$KEYQUEST_ROOT/notetable.cpp \
+    $$KEYQUEST_ROOT/qtable.cpp \
+    $$KEYQUEST_ROOT/question.cpp \
+    $$KEYQUEST_ROOT/questionbank.cpp \
+    $$KEYQUEST_ROOT/questionloader.cpp \
+    $$KEYQUEST_ROOT/quizhistory.cpp \
+    $$KEYQUEST_ROOT/reviewschedule.cpp \
+    $$KEYQUEST_ROOT/runningstats.cpp \
+    $$KEYQUEST_ROOT/scoringsystem.cpp \
+    $$KEYQUEST_ROOT/sessionlog.cpp \
+    $$KEYQUEST_ROOT/sessionrng.cpp \
+    $$KEYQUEST_ROOT/stringpool.cpp
+
+HEADERS += \
+    $$KEYQUEST_ROOT/adaptivequiz.h \
+    $$KEYQUEST_ROOT/backgroundpage.h \
+    $$KEYQUEST_ROOT/backgroundrenderer.h \
+    $$KEYQUEST_ROOT/datawriter.h \
+    $$KEYQUEST_ROOT/gamesession.h \
+    $$KEYQUEST_ROOT/loaddatamanager.h \
+    $$KEYQUEST_ROOT/memorymonitor.h \
+    $$KEYQUEST_ROOT/noteset.h \
+    $$KEYQUEST_ROOT/notetable.h \
+    $$KEYQUEST_ROOT/qtable.h \
+    $$KEYQUEST_ROOT/question.h \
+    $$KEYQUEST_ROOT/questionbank.h \
+    $$KEYQUEST_ROOT/questionloader.h \
+    $$KEYQUEST_ROOT/quizhistory.h \
+    $$KEYQUEST_ROOT/quizreport.h \
+    $$KEYQUEST_ROOT/reviewschedule.h \
+    $$KEYQUEST_ROOT/runningstats.h \
+    $$KEYQUEST_ROOT/scoringsystem.h \
+    $$KEYQUEST_ROOT/sessionlog.h \
+    $$KEYQUEST_ROOT/sessionrng.h \
+    $$KEYQUEST_ROOT/state.h \
+    $$KEYQUEST_ROOT/stringpool.h
+
+# The question bank and the background image of the main menu
+RESOURCES += \
+    $$KEYQUEST_ROOT/data.qrc \
+    $$KEYQUEST_ROOT/resources.qrc
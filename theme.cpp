@@ -0,0 +1,77 @@
+/**
+ * @file theme.cpp
+ * @brief Implementation of the Theme class
+ * @author Alan Cruz
+ * @details This file implements the application stylesheet and switching the
+ *          role of a widget.
+ */
+
+#include "theme.h"
+#include <QApplication>
+#include <QStyle>
+#include <QWidget>
+
+/**
+ * @brief Sets the application stylesheet
+ * @param app The application
+ */
+void Theme::install(QApplication& app)
+{
+    app.setStyleSheet(styleSheet());
+}
+
+/**
+ * @brief Gets the application stylesheet
+ * @return The stylesheet with the rules of every role
+ */
+QString Theme::styleSheet()
+{
+    return QStringLiteral(
+        "QLabel[themeRole=\"text\"] {"
+        "    color: rgb(103, 49, 0);"
+        "}"
+        "QFrame[themeRole=\"panel\"], QFrame[themeRole=\"panel\"] QFrame {"
+        "    background-color: rgba(255, 255, 255, 0.9);"
+        "    border-radius: 10px;"
+        "}"
+        "QPushButton[themeRole=\"keyToggle\"] {"
+        "    background-color: #333;"
+        "    color: white;"
+        "    border: 1px solid #666;"
+        "    border-radius: 4px;"
+        "    padding: 4px 8px;"
+        "}"
+        "QPushButton[themeRole=\"keyToggle\"]:checked {"
+        "    background-color: #666;"
+        "    border: 1px solid #999;"
+        "}"
+        "QLabel[themeRole=\"traceOverlay\"] {"
+        "    background-color: rgba(0, 0, 0, 160);"
+        "    color: white;"
+        "    font-family: monospace;"
+        "    padding: 6px;"
+        "}");
+}
+
+/**
+ * @brief Gives a widget a role of the stylesheet
+ * @param widget The widget
+ * @param role One of the role names, or nullptr for none
+ * @details Setting the role a widget already has does nothing.
+ */
+void Theme::setRole(QWidget* widget, const char* role)
+{
+    if (!widget) {
+        return;
+    }
+    const QVariant value = role ? QVariant(QString::fromLatin1(role)) : QVariant();
+    if (widget->property(ROLE_PROPERTY) == value) {
+        return;
+    }
+
+    widget->setProperty(ROLE_PROPERTY, value);
+    if (widget->testAttribute(Qt::WA_WState_Polished)) {
+        widget->style()->unpolish(widget);
+        widget->style()->polish(widget);
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * @file theme.h
+ * @brief Header file for the Theme class
+ * @author Alan Cruz
+ * @details This file defines Theme, the one application stylesheet every styled
+ *          widget of KeyQuest takes its look from.
+ */
+
+#ifndef THEME_H
+#define THEME_H
+
+#include <QString>
+
+class QApplication;
+class QWidget;
+
+/**
+ * @brief The application-wide stylesheet and the roles widgets pick from it
+ * @details The stylesheet is set on the application once, before the main window
+ *          is created, and Qt parses it once. A widget selects its rules by the
+ *          ROLE_PROPERTY dynamic property instead of carrying its own stylesheet,
+ *          so creating a styled label costs no CSS parsing, and changing a role
+ *          only re-polishes that widget.
+ *
+ *          Styles that only apply to one widget in the .ui file stay in the .ui.
+ */
+class Theme
+{
+public:
+    /// Dynamic property the stylesheet selects on
+    static constexpr const char* ROLE_PROPERTY = "themeRole";
+
+    static constexpr const char* TEXT = "text";                ///< Brown text of the game and statistics labels
+    static constexpr const char* PANEL = "panel";              ///< Translucent white panel with rounded corners, and the frames in it
+    static constexpr const char* KEY_TOGGLE = "keyToggle";     ///< Dark checkable button over the piano
+    static constexpr const char* TRACE_OVERLAY = "traceOverlay"; ///< Monospace overlay of the latency trace
+
+    /**
+     * @brief Sets the application stylesheet
+     * @param app The application
+     */
+    static void install(QApplication& app);
+
+    /**
+     * @brief Gets the application stylesheet
+     * @return The stylesheet with the rules of every role
+     */
+    static QString styleSheet();
+
+    /**
+     * @brief Gives a widget a role of the stylesheet
+     * @param widget The widget
+     * @param role One of the role names above, or nullptr for none
+     * @details A widget that is already shown is re-polished, so the new rules
+     *          apply at once.
+     */
+    static void setRole(QWidget* widget, const char* role);
+};
+
+#endif // THEME_H
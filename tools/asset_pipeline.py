@@ -0,0 +1,199 @@
+#!/usr/bin/env python3
+"""Build the external image resource file used by KeyQuest.
+
+Usage: asset_pipeline.py [--rcc RCC] [--manifest assets.json] [--scan FILE]...
+                         <work dir> <output.rcc> <images.qrc>...
+
+Every image listed in the given .qrc files is written to <work dir> under its
+resource path, resized and recompressed as described below. An assets.qrc that
+lists all of them is generated there and compiled with "rcc -binary" into
+<output.rcc>, which main.cpp registers at startup. Qt memory-maps registered
+resource files, so the images no longer take space in the executable and only
+the pages that are actually touched are read from disk.
+
+Sizes come from the manifest. Each image has a logical size, which is the
+largest edge it is ever drawn at in device-independent pixels:
+  - <name>.png     longest edge at most the logical size (@1x screens)
+  - <name>@2x.png  longest edge at most twice the logical size (@2x screens),
+                   written only if it differs from the @1x variant
+Images are never scaled up. Images used as stylesheet border-images with
+non-zero slice offsets keep their size, since the offsets are given in image
+pixels; they are only recompressed. The offsets are found by scanning the files
+passed with --scan (normally mainwindow.ui and the .cpp files).
+
+PNG output is recompressed losslessly and kept only when it is smaller. Other
+formats are copied when they need no resize. Outputs newer than their source
+and the manifest are reused, so rebuilding only processes changed images.
+
+Requires Pillow (python3 -m pip install Pillow).
+"""
+
+import argparse
+import fnmatch
+import io
+import json
+import os
+import re
+import subprocess
+import sys
+import xml.etree.ElementTree as ET
+
+try:
+    from PIL import Image
+except ImportError:
+    sys.exit("asset_pipeline.py: Pillow is required (python3 -m pip install Pillow)")
+
+IMAGE_SUFFIXES = (".png", ".jpg", ".jpeg", ".webp")
+SLICE_RE = re.compile(r"border-image:\s*url\(\s*:?(/[^)\s]+)\s*\)\s*(\d+)\s+(\d+)\s+(\d+)\s+(\d+)")
+
+
+def read_qrc(path):
+    """Yield (resource path, source file) for every file listed in a .qrc."""
+    base = os.path.dirname(os.path.abspath(path))
+    root = ET.parse(path).getroot()
+    for resource in root.iter("qresource"):
+        prefix = resource.get("prefix", "/").strip("/")
+        for entry in resource.iter("file"):
+            name = entry.get("alias") or entry.text.strip()
+            resource_path = "/".join(part for part in (prefix, name) if part)
+            yield resource_path, os.path.join(base, entry.text.strip())
+
+
+def sliced_images(scan_files):
+    """Return the resource paths used as border-images with non-zero slices."""
+    sliced = set()
+    for path in scan_files:
+        with open(path, encoding="utf-8", errors="replace") as f:
+            for match in SLICE_RE.finditer(f.read()):
+                if any(int(offset) for offset in match.groups()[1:]):
+                    sliced.add(match.group(1).lstrip("/"))
+    return sliced
+
+
+def logical_size(manifest, resource_path):
+    for rule in manifest.get("rules", []):
+        if fnmatch.fnmatch(resource_path, rule["pattern"]):
+            return rule["logicalSize"]
+    return manifest["defaultLogicalSize"]
+
+
+def fit(size, longest_edge):
+    """Scale size down so that its longest edge is at most longest_edge."""
+    width, height = size
+    scale = min(1.0, longest_edge / max(width, height))
+    return max(1, round(width * scale)), max(1, round(height * scale))
+
+
+def encode(image, size, source_bytes, source_format):
+    """Return the bytes of image at size, in the format of the source."""
+    resized = size != image.size
+    if not resized and source_format != "PNG":
+        return source_bytes
+    if resized:
+        image = image.resize(size, Image.LANCZOS)
+    out = io.BytesIO()
+    if source_format == "PNG":
+        image.save(out, "PNG", optimize=True)
+    else:
+        image.save(out, source_format, quality=90)
+    data = out.getvalue()
+    if not resized and len(data) >= len(source_bytes):
+        return source_bytes
+    return data
+
+
+def write_if_changed(path, data):
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    if os.path.exists(path):
+        with open(path, "rb") as f:
+            if f.read() == data:
+                return
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def up_to_date(outputs, inputs):
+    if not all(os.path.exists(path) for path in outputs):
+        return False
+    newest_input = max(os.path.getmtime(path) for path in inputs)
+    return all(os.path.getmtime(path) >= newest_input for path in outputs)
+
+
+def process(resource_path, source, work_dir, logical, keep_size, manifest_path):
+    """Write the variants of one image; return their resource paths."""
+    stem, suffix = os.path.splitext(resource_path)
+    path_1x = resource_path
+    path_2x = stem + "@2x" + suffix
+    out_1x = os.path.join(work_dir, path_1x)
+    out_2x = os.path.join(work_dir, path_2x)
+
+    with open(source, "rb") as f:
+        source_bytes = f.read()
+    image = Image.open(io.BytesIO(source_bytes))
+    source_format = image.format
+    image.load()
+
+    if keep_size:
+        size_1x = size_2x = image.size
+    else:
+        size_1x = fit(image.size, logical)
+        size_2x = fit(image.size, logical * 2)
+
+    variants = [path_1x] + ([path_2x] if size_2x != size_1x else [])
+    outputs = [os.path.join(work_dir, path) for path in variants]
+    if up_to_date(outputs, [source, manifest_path]):
+        return variants
+
+    write_if_changed(out_1x, encode(image, size_1x, source_bytes, source_format))
+    if size_2x != size_1x:
+        write_if_changed(out_2x, encode(image, size_2x, source_bytes, source_format))
+    elif os.path.exists(out_2x):
+        os.remove(out_2x)
+
+    print("asset_pipeline.py: %s %dx%d -> %s" % (
+        resource_path, image.size[0], image.size[1],
+        ", ".join("%dx%d" % size for size in ([size_1x, size_2x] if len(variants) > 1 else [size_1x]))))
+    return variants
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build the external KeyQuest image resources.")
+    parser.add_argument("--rcc", default="rcc", help="rcc executable")
+    parser.add_argument("--manifest", default=os.path.join(os.path.dirname(__file__), "assets.json"))
+    parser.add_argument("--scan", action="append", default=[], help="file to scan for border-image slices")
+    parser.add_argument("work_dir")
+    parser.add_argument("output")
+    parser.add_argument("qrc", nargs="+")
+    args = parser.parse_args()
+
+    with open(args.manifest, encoding="utf-8") as f:
+        manifest = json.load(f)
+    sliced = sliced_images(args.scan)
+
+    resources = []
+    for qrc in args.qrc:
+        for resource_path, source in read_qrc(qrc):
+            if not resource_path.lower().endswith(IMAGE_SUFFIXES):
+                print("asset_pipeline.py: skipping non-image resource %s" % resource_path, file=sys.stderr)
+                continue
+            resources += process(resource_path, source, args.work_dir,
+                                 logical_size(manifest, resource_path),
+                                 resource_path in sliced, args.manifest)
+
+    lines = ["<RCC>", '    <qresource prefix="/">']
+    lines += ["        <file>%s</file>" % path for path in sorted(resources)]
+    lines += ["    </qresource>", "</RCC>", ""]
+    qrc_path = os.path.join(args.work_dir, "assets.qrc")
+    write_if_changed(qrc_path, "\n".join(lines).encode("utf-8"))
+
+    # Images are already compressed, so rcc's own compression would only cost decode time
+    result = subprocess.run([args.rcc, "-binary", "-no-compress", qrc_path, "-o", args.output])
+    if result.returncode != 0:
+        sys.exit("asset_pipeline.py: rcc failed")
+
+    total = sum(os.path.getsize(os.path.join(args.work_dir, path)) for path in resources)
+    print("asset_pipeline.py: wrote %s (%d images, %.1f MB)" % (args.output, len(resources), total / 1e6))
+
+
+if __name__ == "__main__":
+    main()
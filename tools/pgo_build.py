@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Build a profile-guided optimized KeyQuest.
+
+Usage: pgo_build.py [--qmake QMAKE] [--spec SPEC] [--profdata LLVM_PROFDATA]
+                    [--march TIER] [<build dir>]
+
+Runs the two stages of the profile-guided build described in buildprofile.pri:
+  1. builds bench/quizbench with CONFIG+=performance CONFIG+=pgo_generate in
+     <build dir>/train and runs it with the training workloads below, then
+     merges the raw profiles into <build dir>/keyquest.profdata
+  2. builds KeyQuest with CONFIG+=performance CONFIG+=pgo_use in <build dir>/app
+
+The training runs exercise question selection and answer evaluation with both
+answer models, with and without a carried-over Q-table, so the profile covers
+the branches a classroom session takes. Needs clang and llvm-profdata.
+"""
+
+import argparse
+import glob
+import os
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+TRAINING_RUNS = [
+    ["--learners", "20000", "--questions", "30", "--model", "skill"],
+    ["--learners", "20000", "--questions", "30", "--model", "fixed", "--accuracy", "0.6"],
+    ["--learners", "5000", "--questions", "50", "--model", "skill", "--fresh-table"],
+]
+
+
+def run(command, cwd, env=None):
+    print("pgo_build.py: %s" % " ".join(command))
+    if subprocess.run(command, cwd=cwd, env=env).returncode != 0:
+        sys.exit("pgo_build.py: %s failed" % command[0])
+
+
+def qmake(args, project, build_dir, extra):
+    command = [args.qmake, "-spec", args.spec, os.path.join(ROOT, project),
+               "CONFIG+=release", "CONFIG+=performance"] + extra
+    if args.march:
+        command.append("KEYQUEST_MARCH=" + args.march)
+    run(command, build_dir)
+    run(["make", "-j%d" % (os.cpu_count() or 4)], build_dir)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build a profile-guided optimized KeyQuest.")
+    parser.add_argument("--qmake", default="qmake6", help="qmake executable")
+    parser.add_argument("--spec", default="linux-clang", help="clang mkspec")
+    parser.add_argument("--profdata", default="llvm-profdata", help="llvm-profdata executable")
+    parser.add_argument("--march", help="CPU tier passed as KEYQUEST_MARCH")
+    parser.add_argument("build_dir", nargs="?", default=os.path.join(ROOT, "build-pgo"))
+    args = parser.parse_args()
+
+    build_dir = os.path.abspath(args.build_dir)
+    train_dir = os.path.join(build_dir, "train")
+    app_dir = os.path.join(build_dir, "app")
+    profile = os.path.join(build_dir, "keyquest.profdata")
+    os.makedirs(train_dir, exist_ok=True)
+    os.makedirs(app_dir, exist_ok=True)
+
+    # Stage 1: instrumented benchmark and training runs
+    qmake(args, "bench/quizbench.pro", train_dir, ["CONFIG+=pgo_generate"])
+    for raw in glob.glob(os.path.join(train_dir, "*.profraw")):
+        os.remove(raw)
+    env = dict(os.environ, LLVM_PROFILE_FILE=os.path.join(train_dir, "quizbench-%p.profraw"))
+    for training in TRAINING_RUNS:
+        run([os.path.join(train_dir, "quizbench")] + training, train_dir, env)
+    run([args.profdata, "merge", "-o", profile] + glob.glob(os.path.join(train_dir, "*.profraw")), train_dir)
+
+    # Stage 2: the application, optimized with the profile
+    qmake(args, "KeyQuest.pro", app_dir, ["CONFIG+=pgo_use", "KEYQUEST_PGO_PROFILE=" + profile])
+    print("pgo_build.py: built %s" % os.path.join(app_dir, "KeyQuest"))
+
+
+if __name__ == "__main__":
+    main()
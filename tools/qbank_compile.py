@@ -0,0 +1,218 @@
+#!/usr/bin/env python3
+"""Compile resources/questionBank.json into the binary question bank blob.
+
+Usage: qbank_compile.py <questionBank.json> <output.cpp>
+
+The output is a C++ source file defining questionBankBlob/questionBankBlobSize,
+which KeyQuest.pro links into the executable. The layout is documented in
+questionbankformat.h and must be kept in sync with it.
+
+Expected answers are normalized the same way the lessons and multiplayer games
+used to normalize them at runtime: every note without an octave number gets
+octave 4. The answer is also stored as a pitch-class mask and a MIDI note mask
+(see NoteSet) so the runtime never has to parse note names for the bank.
+
+Every question also gets a prompt, the answer as notes to play back: the notes
+of a chord or interval sound together, those of a scale or melody one per beat
+(see QuestionBank::isSequentialTopic()).
+"""
+
+import json
+import struct
+import sys
+
+MAGIC = b"KQQB"
+VERSION = 3
+ANSWER_VALID = 0x01
+ANSWER_EXACT_OCTAVE = 0x02
+
+HEADER = struct.Struct("<4sHHIIIIIIII")
+RECORD = struct.Struct("<iiBBBBHHIIIIQQ")
+TOPIC = struct.Struct("<iIII")
+PROMPT_NOTE = struct.Struct("<BB")
+
+# Topics whose answers are played one note per beat: scales and melodies
+SEQUENTIAL_TOPICS = {104, 106}
+
+BASE_VALUES = {"C": 0, "D": 2, "E": 4, "F": 5, "G": 7, "A": 9, "B": 11}
+
+
+def align(size, alignment):
+    return (size + alignment - 1) // alignment * alignment
+
+
+def normalize_note(note):
+    """Append octave 4 to a note that has no octave number."""
+    return note if has_octave(note) else note + "4"
+
+
+def normalize_input(expected):
+    return "-".join(normalize_note(note) for note in expected.split("-"))
+
+
+def has_octave(note):
+    return len(note) > 1 and note[-1].isdigit()
+
+
+def note_value(note):
+    """Return (pitch class, MIDI note) for a note name, or None.
+
+    Mirrors NoteSet::noteNameToMidi().
+    """
+    octave = 4
+    name = note
+    if has_octave(note):
+        octave = int(note[-1])
+        name = note[:-1]
+    if not name or name[0] not in BASE_VALUES:
+        return None
+    value = BASE_VALUES[name[0]]
+    if "##" in name:
+        value += 2
+    elif "bb" in name:
+        value -= 2
+    else:
+        value += name[1:].count("#") - name[1:].count("b")
+    pitch_class = (value + 12) % 12
+    midi_note = (octave + 1) * 12 + pitch_class
+    if midi_note > 127:
+        return None
+    return pitch_class, midi_note
+
+
+class StringTable:
+    """Interned UTF-16LE strings addressed by byte offset."""
+
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, text):
+        if text in self.offsets:
+            return self.offsets[text]
+        offset = len(self.data)
+        units = text.encode("utf-16-le")
+        self.data += struct.pack("<I", len(units) // 2) + units
+        self.data += b"\0" * (align(len(self.data), 4) - len(self.data))
+        self.offsets[text] = offset
+        return offset
+
+
+def compile_bank(bank):
+    strings = StringTable()
+    questions = []
+    topic_names = {}
+
+    for topic in bank.get("topics", []):
+        topic_id = int(topic.get("topicID", 0))
+        topic_names.setdefault(topic_id, topic.get("topicName", ""))
+        for q in topic.get("questions", []):
+            questions.append((topic_id, q))
+
+    # Later duplicates of a question ID win, matching loadQuestionsFromFile()
+    by_id = {}
+    for topic_id, q in questions:
+        by_id[int(q.get("questionID", 0))] = (topic_id, q)
+    ordered = sorted(by_id.items(), key=lambda item: (item[1][0], item[0]))
+
+    records = bytearray()
+    topics = []
+    prompts = bytearray()
+    prompt_notes = 0
+    for index, (qid, (topic_id, q)) in enumerate(ordered):
+        expected = q.get("ExpectedInput", "")
+        normalized = normalize_input(expected)
+        notes = expected.split("-")
+
+        flags = ANSWER_VALID
+        all_have_octave = True
+        pitch_mask = 0
+        midi_mask = 0
+        prompt_first = prompt_notes
+        for step, note in enumerate(notes):
+            value = note_value(note)
+            if value is None:
+                flags &= ~ANSWER_VALID
+                continue
+            all_have_octave = all_have_octave and has_octave(note)
+            pitch_mask |= 1 << value[0]
+            midi_mask |= 1 << value[1]
+            if step < 256:
+                prompts += PROMPT_NOTE.pack(value[1], step if topic_id in SEQUENTIAL_TOPICS else 0)
+                prompt_notes += 1
+        prompt_count = min(prompt_notes - prompt_first, 255)
+        if prompt_first > 0xFFFF:
+            raise ValueError("question bank has too many prompt notes")
+        if all_have_octave and pitch_mask:
+            flags |= ANSWER_EXACT_OCTAVE
+
+        records += RECORD.pack(
+            qid, topic_id, int(q.get("difficulty", 0)), flags, min(len(notes), 255), prompt_count,
+            pitch_mask, prompt_first,
+            strings.add(q.get("Title", "")),
+            strings.add(q.get("Description", "")),
+            strings.add(expected),
+            strings.add(normalized),
+            midi_mask & 0xFFFFFFFFFFFFFFFF, midi_mask >> 64)
+
+        if topics and topics[-1][0] == topic_id:
+            topics[-1][3] += 1
+        else:
+            topics.append([topic_id, strings.add(topic_names[topic_id]), index, 1])
+
+    records_offset = align(HEADER.size, 8)
+    topics_offset = align(records_offset + len(records), 8)
+    prompts_offset = align(topics_offset + TOPIC.size * len(topics), 8)
+    strings_offset = align(prompts_offset + len(prompts), 8)
+
+    blob = bytearray(HEADER.pack(
+        MAGIC, VERSION, HEADER.size, len(ordered), len(topics),
+        records_offset, topics_offset, strings_offset, len(strings.data),
+        prompts_offset, prompt_notes))
+    blob += b"\0" * (records_offset - len(blob))
+    blob += records
+    blob += b"\0" * (topics_offset - len(blob))
+    for topic in topics:
+        blob += TOPIC.pack(*topic)
+    blob += b"\0" * (prompts_offset - len(blob))
+    blob += prompts
+    blob += b"\0" * (strings_offset - len(blob))
+    blob += strings.data
+    return bytes(blob)
+
+
+def write_source(blob, path):
+    lines = [
+        "// Generated by tools/qbank_compile.py from questionBank.json. Do not edit.",
+        "#include <cstddef>",
+        "",
+        "extern const unsigned char questionBankBlob[];",
+        "extern const std::size_t questionBankBlobSize;",
+        "",
+        "alignas(8) const unsigned char questionBankBlob[] = {",
+    ]
+    for start in range(0, len(blob), 16):
+        chunk = blob[start:start + 16]
+        lines.append("    " + ", ".join("0x%02x" % b for b in chunk) + ",")
+    lines += [
+        "};",
+        "",
+        "const std::size_t questionBankBlobSize = sizeof(questionBankBlob);",
+        "",
+    ]
+    with open(path, "w", newline="\n") as out:
+        out.write("\n".join(lines))
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write("usage: qbank_compile.py <questionBank.json> <output.cpp>\n")
+        return 2
+    with open(argv[1], encoding="utf-8") as source:
+        bank = json.load(source)
+    write_source(compile_bank(bank), argv[2])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""Record the SHA-256 and size of the piano SoundFont at build time.
+
+Usage: soundfont_hash.py <soundfont.sf2> <resource path> <output.cpp>
+
+The output is a C++ source file defining soundFontResource, soundFontSha256 and
+soundFontSize, which KeyQuest.pro links into the executable. SoundFontLoader
+names its extraction cache after the hash and checks the cached file against the
+size, so startup never has to hash the SoundFont itself. The values are only
+used for the resource path they were generated for and only while the embedded
+resource still has that size.
+"""
+
+import hashlib
+import os
+import sys
+
+CHUNK_SIZE = 1024 * 1024
+
+
+def hash_file(path):
+    digest = hashlib.sha256()
+    with open(path, "rb") as source:
+        for chunk in iter(lambda: source.read(CHUNK_SIZE), b""):
+            digest.update(chunk)
+    return digest.hexdigest()
+
+
+def write_source(resource, sha256, size, path):
+    lines = [
+        "// Generated by tools/soundfont_hash.py from the piano SoundFont. Do not edit.",
+        "",
+        "extern const char soundFontResource[];",
+        "extern const char soundFontSha256[];",
+        "extern const long long soundFontSize;",
+        "",
+        'const char soundFontResource[] = "%s";' % resource,
+        'const char soundFontSha256[] = "%s";' % sha256,
+        "const long long soundFontSize = %dLL;" % size,
+        "",
+    ]
+    with open(path, "w", newline="\n") as out:
+        out.write("\n".join(lines))
+
+
+def main(argv):
+    if len(argv) != 4:
+        sys.stderr.write("usage: soundfont_hash.py <soundfont.sf2> <resource path> <output.cpp>\n")
+        return 2
+    write_source(argv[2], hash_file(argv[1]), os.path.getsize(argv[1]), argv[3])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,223 @@
+/**
+ * @file trace.cpp
+ * @brief Implementation of the Trace class
+ * @author Alan Cruz
+ * @details This file implements the per-thread span buffers, the input latency and
+ *          frame-time sample windows, and the Chrome trace export.
+ */
+
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace {
+
+/// One recorded span
+struct TraceEvent {
+    const char* name;  ///< Name of the stage
+    qint64 start;      ///< Start time in nanoseconds
+    qint64 duration;   ///< Duration in nanoseconds
+};
+
+/// Ring buffer written by exactly one thread
+struct ThreadBuffer {
+    int threadIndex = 0;                  ///< Thread number used as "tid" in the export
+    std::atomic<quint32> written{0};      ///< Number of events written so far
+    TraceEvent events[Trace::BUFFER_CAPACITY];  ///< Event slots, reused once full
+};
+
+/// Fixed window of the most recent samples, used from the GUI thread only
+struct SampleWindow {
+    qint64 samples[Trace::SAMPLE_WINDOW] = {};  ///< Samples in nanoseconds
+    int count = 0;                              ///< Samples added so far, capped at the window
+    int next = 0;                               ///< Slot of the next sample
+
+    /**
+     * @brief Adds a sample, replacing the oldest one once the window is full
+     * @param value The sample in nanoseconds
+     */
+    void add(qint64 value)
+    {
+        samples[next] = value;
+        next = (next + 1) % Trace::SAMPLE_WINDOW;
+        count = std::min(count + 1, int(Trace::SAMPLE_WINDOW));
+    }
+
+    /**
+     * @brief Gets a percentile of the window
+     * @param percentile The percentile, 0-100
+     * @return The percentile in milliseconds, or -1 without samples
+     */
+    double percentileMs(double percentile) const
+    {
+        if (count == 0) {
+            return -1.0;
+        }
+        std::vector<qint64> sorted(samples, samples + count);
+        auto rank = static_cast<std::size_t>(qBound(0.0, percentile / 100.0, 1.0) * (count - 1) + 0.5);
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank] / 1e6;
+    }
+};
+
+QMutex registryMutex;                                  ///< Guards threadBuffers
+std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;  ///< Buffers of all threads that traced
+thread_local ThreadBuffer* currentBuffer = nullptr;    ///< Buffer of the calling thread
+
+SampleWindow inputLatencies;   ///< Input-to-feedback latencies
+SampleWindow frameTimes;       ///< Piano paint durations
+qint64 pendingInput = -1;      ///< Time of the first press of the current attempt, -1 if none
+
+/**
+ * @brief Gets the buffer of the calling thread, registering it on first use
+ * @return The calling thread's buffer
+ */
+ThreadBuffer* threadBuffer()
+{
+    if (!currentBuffer) {
+        QMutexLocker locker(&registryMutex);
+        threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+        currentBuffer = threadBuffers.back().get();
+        currentBuffer->threadIndex = static_cast<int>(threadBuffers.size());
+    }
+    return currentBuffer;
+}
+
+} // namespace
+
+/**
+ * @brief Gets the trace clock
+ * @return Monotonic time in nanoseconds
+ */
+qint64 Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Records a finished span in the calling thread's buffer
+ * @param name Name of the stage; must be a string literal
+ * @param start Start time in nanoseconds
+ * @param duration Duration in nanoseconds
+ */
+void Trace::record(const char* name, qint64 start, qint64 duration)
+{
+    ThreadBuffer* buffer = threadBuffer();
+    quint32 index = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[index % BUFFER_CAPACITY] = {name, start, duration};
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Records a finished scope
+ * @param name Name of the stage
+ * @param start Start time in nanoseconds
+ * @param frame Whether the span also feeds the frame-time samples
+ */
+void Trace::finish(const char* name, qint64 start, bool frame)
+{
+    qint64 duration = now() - start;
+    record(name, start, duration);
+    if (frame) {
+        frameTimes.add(duration);
+    }
+}
+
+/**
+ * @brief Marks a key press as the start of an attempt
+ */
+void Trace::markInput()
+{
+    if (pendingInput < 0) {
+        pendingInput = now();
+    }
+}
+
+/**
+ * @brief Marks the feedback of an attempt
+ */
+void Trace::markFeedback()
+{
+    if (pendingInput < 0) {
+        return;
+    }
+    qint64 latency = now() - pendingInput;
+    record("Input to feedback", pendingInput, latency);
+    inputLatencies.add(latency);
+    pendingInput = -1;
+}
+
+/**
+ * @brief Gets a percentile of the recent input latencies
+ * @param percentile The percentile, 0-100
+ * @return The latency in milliseconds, or -1 without samples
+ */
+double Trace::inputLatencyMs(double percentile)
+{
+    return inputLatencies.percentileMs(percentile);
+}
+
+/**
+ * @brief Gets a percentile of the recent frame times
+ * @param percentile The percentile, 0-100
+ * @return The frame time in milliseconds, or -1 without samples
+ */
+double Trace::frameTimeMs(double percentile)
+{
+    return frameTimes.percentileMs(percentile);
+}
+
+/**
+ * @brief Writes all buffered spans as a Chrome trace
+ * @param path Path of the JSON file to write
+ * @return true if the file was written
+ * @details Events that a thread overwrites while the export runs may come out
+ *          mixed; the export is meant for a paused or idle application.
+ */
+bool Trace::writeChromeTrace(const QString& path)
+{
+    QJsonArray events;
+    {
+        QMutexLocker locker(&registryMutex);
+        for (const auto& buffer : threadBuffers) {
+            quint32 written = buffer->written.load(std::memory_order_acquire);
+            quint32 first = written > quint32(BUFFER_CAPACITY) ? written - BUFFER_CAPACITY : 0;
+            for (quint32 i = first; i < written; ++i) {
+                const TraceEvent& event = buffer->events[i % BUFFER_CAPACITY];
+                QJsonObject object;
+                object["name"] = QString::fromLatin1(event.name);
+                object["ph"] = "X";
+                object["ts"] = event.start / 1000.0;
+                object["dur"] = event.duration / 1000.0;
+                object["pid"] = static_cast<qint64>(QCoreApplication::applicationPid());
+                object["tid"] = buffer->threadIndex;
+                events.append(object);
+            }
+        }
+    }
+
+    QJsonObject trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Trace: Could not write" << path;
+        return false;
+    }
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    qDebug() << "Trace: Wrote" << events.size() << "events to" << path;
+    return true;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file trace.h
+ * @brief Header file for the Trace class and the tracing macros
+ * @author Alan Cruz
+ * @details This file defines the lightweight tracing layer used to follow a key
+ *          press through the input, chord, quiz and feedback stages. Tracing is
+ *          compiled in with "qmake CONFIG+=trace", which defines KEYQUEST_TRACE;
+ *          without it every macro expands to nothing.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @brief Per-thread span recorder with Chrome trace export
+ * @details Every thread that records a span gets its own ring buffer of
+ *          BUFFER_CAPACITY events. Recording writes one slot and publishes it with
+ *          a single atomic store, so it never locks; only the first span of a
+ *          thread takes a lock to register its buffer. Old events are overwritten
+ *          once a buffer is full.
+ *
+ *          On top of the spans the GUI thread keeps two rolling sample windows:
+ *          - input latency, from the first key press of an attempt to the
+ *            feedback highlight on the piano
+ *          - frame time, the time spent painting the piano
+ *
+ *          writeChromeTrace() exports the buffers in the Chrome trace event format,
+ *          which chrome://tracing and ui.perfetto.dev open directly.
+ */
+class Trace
+{
+public:
+    static constexpr int BUFFER_CAPACITY = 16384;  ///< Events kept per thread
+    static constexpr int SAMPLE_WINDOW = 256;      ///< Latency and frame samples kept
+
+    /**
+     * @brief Records a span from construction to destruction
+     */
+    class Scope
+    {
+    public:
+        /**
+         * @brief Starts a span
+         * @param name Name of the stage; must be a string literal
+         * @param frame Whether the span is a frame and also feeds the frame-time samples
+         */
+        explicit Scope(const char* name, bool frame = false)
+            : m_name(name), m_frame(frame), m_start(now()) {}
+
+        /**
+         * @brief Ends the span and records it
+         */
+        ~Scope() { finish(m_name, m_start, m_frame); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* m_name;  ///< Name of the stage
+        bool m_frame;        ///< Whether the span is a frame
+        qint64 m_start;      ///< Start time in nanoseconds
+    };
+
+    /**
+     * @brief Gets the trace clock
+     * @return Monotonic time in nanoseconds
+     */
+    static qint64 now();
+
+    /**
+     * @brief Records a finished span in the calling thread's buffer
+     * @param name Name of the stage; must be a string literal
+     * @param start Start time in nanoseconds
+     * @param duration Duration in nanoseconds
+     */
+    static void record(const char* name, qint64 start, qint64 duration);
+
+    /**
+     * @brief Marks a key press as the start of an attempt
+     * @details Only the first press before the next feedback counts, so the
+     *          latency of a chord is measured from its first note.
+     */
+    static void markInput();
+
+    /**
+     * @brief Marks the feedback of an attempt
+     * @details Adds the time since markInput() to the input latency samples and
+     *          records it as a span.
+     */
+    static void markFeedback();
+
+    /**
+     * @brief Gets a percentile of the recent input latencies
+     * @param percentile The percentile, 0-100
+     * @return The latency in milliseconds, or -1 without samples
+     */
+    static double inputLatencyMs(double percentile);
+
+    /**
+     * @brief Gets a percentile of the recent frame times
+     * @param percentile The percentile, 0-100
+     * @return The frame time in milliseconds, or -1 without samples
+     */
+    static double frameTimeMs(double percentile);
+
+    /**
+     * @brief Writes all buffered spans as a Chrome trace
+     * @param path Path of the JSON file to write
+     * @return true if the file was written
+     */
+    static bool writeChromeTrace(const QString& path);
+
+private:
+    /**
+     * @brief Records a finished scope
+     * @param name Name of the stage
+     * @param start Start time in nanoseconds
+     * @param frame Whether the span also feeds the frame-time samples
+     */
+    static void finish(const char* name, qint64 start, bool frame);
+};
+
+#ifdef KEYQUEST_TRACE
+#define KEYQUEST_TRACE_CONCAT_(a, b) a##b
+#define KEYQUEST_TRACE_CONCAT(a, b) KEYQUEST_TRACE_CONCAT_(a, b)
+/// Records the rest of the enclosing block as a span
+#define KEYQUEST_TRACE_SCOPE(name) Trace::Scope KEYQUEST_TRACE_CONCAT(traceScope, __LINE__)(name)
+/// Records the rest of the enclosing block as a span and a frame-time sample
+#define KEYQUEST_TRACE_FRAME(name) Trace::Scope KEYQUEST_TRACE_CONCAT(traceFrame, __LINE__)(name, true)
+/// Marks the start of an attempt for the input latency
+#define KEYQUEST_TRACE_INPUT() Trace::markInput()
+/// Marks the feedback of an attempt for the input latency
+#define KEYQUEST_TRACE_FEEDBACK() Trace::markFeedback()
+#else
+#define KEYQUEST_TRACE_SCOPE(name) do {} while (0)
+#define KEYQUEST_TRACE_FRAME(name) do {} while (0)
+#define KEYQUEST_TRACE_INPUT() do {} while (0)
+#define KEYQUEST_TRACE_FEEDBACK() do {} while (0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,84 @@
+/**
+ * @file traceoverlay.cpp
+ * @brief Implementation of the TraceOverlay class
+ * @author Alan Cruz
+ * @details This file implements the on-screen latency, frame time and memory readout.
+ */
+
+#include "traceoverlay.h"
+#include "memorymonitor.h"
+#include "theme.h"
+#include "trace.h"
+
+/**
+ * @brief Formats a percentile for display
+ * @param valueMs The value in milliseconds, negative without samples
+ * @return The value with one decimal, or "-"
+ */
+static QString formatMs(double valueMs)
+{
+    return valueMs < 0 ? QStringLiteral("-") : QString::number(valueMs, 'f', 1);
+}
+
+/**
+ * @brief Creates the overlay, hidden
+ * @param parent The widget the overlay is drawn over
+ */
+TraceOverlay::TraceOverlay(QWidget* parent)
+    : QLabel(parent)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    Theme::setRole(this, Theme::TRACE_OVERLAY);
+    refreshTimer.setInterval(REFRESH_INTERVAL_MS);
+    connect(&refreshTimer, &QTimer::timeout, this, &TraceOverlay::refresh);
+    hide();
+}
+
+/**
+ * @brief Shows or hides the overlay
+ */
+void TraceOverlay::toggle()
+{
+    setVisible(!isVisible());
+}
+
+/**
+ * @brief Starts refreshing when the overlay is shown
+ * @param event The show event
+ */
+void TraceOverlay::showEvent(QShowEvent* event)
+{
+    QLabel::showEvent(event);
+    refresh();
+    raise();
+    refreshTimer.start();
+}
+
+/**
+ * @brief Stops refreshing when the overlay is hidden
+ * @param event The hide event
+ */
+void TraceOverlay::hideEvent(QHideEvent* event)
+{
+    refreshTimer.stop();
+    QLabel::hideEvent(event);
+}
+
+/**
+ * @brief Updates the text from the current samples
+ */
+void TraceOverlay::refresh()
+{
+    QString text = QString("input  p50 %1 ms  p99 %2 ms\nframe  p50 %3 ms  p99 %4 ms")
+                       .arg(formatMs(Trace::inputLatencyMs(50)), formatMs(Trace::inputLatencyMs(99)),
+                            formatMs(Trace::frameTimeMs(50)), formatMs(Trace::frameTimeMs(99)));
+    qint64 total = 0;
+    for (const MemoryMonitor::Entry& entry : MemoryMonitor::instance()->snapshot()) {
+        total += entry.bytes;
+        text += QString("\n%1 %2 MiB").arg(entry.name, -9).arg(entry.bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    text += QString("\n%1 %2 MiB").arg(QString(MemoryMonitor::TOTAL), -9).arg(total / (1024.0 * 1024.0), 0, 'f', 1);
+    setText(text);
+    adjustSize();
+    move(8, 8);
+}
@@ -0,0 +1,62 @@
+/**
+ * @file traceoverlay.h
+ * @brief Header file for the TraceOverlay class
+ * @author Alan Cruz
+ * @details This file defines the on-screen readout of the input latency and frame
+ *          time percentiles collected by Trace, and of the memory breakdown kept by
+ *          MemoryMonitor.
+ */
+
+#ifndef TRACEOVERLAY_H
+#define TRACEOVERLAY_H
+
+#include <QLabel>
+#include <QTimer>
+
+/**
+ * @brief Small overlay showing p50/p99 input latency, frame time and memory per subsystem
+ * @details The overlay ignores the mouse, so it can sit on top of the piano
+ *          without blocking it. It only refreshes while visible.
+ */
+class TraceOverlay : public QLabel
+{
+    Q_OBJECT
+
+public:
+    static constexpr int REFRESH_INTERVAL_MS = 250;  ///< Time between two refreshes
+
+    /**
+     * @brief Creates the overlay, hidden
+     * @param parent The widget the overlay is drawn over
+     */
+    explicit TraceOverlay(QWidget* parent);
+
+    /**
+     * @brief Shows or hides the overlay
+     */
+    void toggle();
+
+protected:
+    /**
+     * @brief Starts refreshing when the overlay is shown
+     * @param event The show event
+     */
+    void showEvent(QShowEvent* event) override;
+
+    /**
+     * @brief Stops refreshing when the overlay is hidden
+     * @param event The hide event
+     */
+    void hideEvent(QHideEvent* event) override;
+
+private Q_SLOTS:
+    /**
+     * @brief Updates the text from the current samples
+     */
+    void refresh();
+
+private:
+    QTimer refreshTimer;  ///< Drives refresh() while visible
+};
+
+#endif // TRACEOVERLAY_H